@@ -174,18 +174,18 @@ $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"qla2xxx\" -DLINUX_MODULE_AUX_HEAP_NAME=qla2xxx -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=35*1024*1024 -DLINUX_MODULE_HEAP_NAME=qla2xxx -DLINUX_MODULE_VERSION=\"821.k1.35vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/qla2xxx -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-qla2xxx.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/qla2xxx/qla_sup.o vmkdrivers/src26/drivers/scsi/qla2xxx/qla_sup.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"qla2xxx\" -DLINUX_MODULE_AUX_HEAP_NAME=qla2xxx -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=35*1024*1024 -DLINUX_MODULE_HEAP_NAME=qla2xxx -DLINUX_MODULE_VERSION=\"821.k1.35vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/qla2xxx -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-qla2xxx.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/qla2xxx/qla_xioct.o vmkdrivers/src26/drivers/scsi/qla2xxx/qla_xioct.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"qla2xxx\" -DLINUX_MODULE_AUX_HEAP_NAME=qla2xxx -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=35*1024*1024 -DLINUX_MODULE_HEAP_NAME=qla2xxx -DLINUX_MODULE_VERSION=\"821.k1.35vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/qla2xxx -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-qla2xxx.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o vmkdrivers/src26/common/vmklinux_module.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/aachba.o vmkdrivers/src26/drivers/scsi/aacraid2/aachba.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/commctrl.o vmkdrivers/src26/drivers/scsi/aacraid2/commctrl.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/comminit.o vmkdrivers/src26/drivers/scsi/aacraid2/comminit.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/commsup.o vmkdrivers/src26/drivers/scsi/aacraid2/commsup.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/csmi.o vmkdrivers/src26/drivers/scsi/aacraid2/csmi.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/dpcsup.o vmkdrivers/src26/drivers/scsi/aacraid2/dpcsup.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/rkt.o vmkdrivers/src26/drivers/scsi/aacraid2/rkt.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/rx.o vmkdrivers/src26/drivers/scsi/aacraid2/rx.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/linit.o vmkdrivers/src26/drivers/scsi/aacraid2/linit.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/sa.o vmkdrivers/src26/drivers/scsi/aacraid2/sa.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/nark.o vmkdrivers/src26/drivers/scsi/aacraid2/nark.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o vmkdrivers/src26/common/vmklinux_module.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/aachba.o vmkdrivers/src26/drivers/scsi/aacraid2/aachba.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/commctrl.o vmkdrivers/src26/drivers/scsi/aacraid2/commctrl.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/comminit.o vmkdrivers/src26/drivers/scsi/aacraid2/comminit.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/commsup.o vmkdrivers/src26/drivers/scsi/aacraid2/commsup.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/csmi.o vmkdrivers/src26/drivers/scsi/aacraid2/csmi.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/dpcsup.o vmkdrivers/src26/drivers/scsi/aacraid2/dpcsup.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/rkt.o vmkdrivers/src26/drivers/scsi/aacraid2/rkt.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/rx.o vmkdrivers/src26/drivers/scsi/aacraid2/rx.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/linit.o vmkdrivers/src26/drivers/scsi/aacraid2/linit.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/sa.o vmkdrivers/src26/drivers/scsi/aacraid2/sa.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/aacraid2/nark.o vmkdrivers/src26/drivers/scsi/aacraid2/nark.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"aacraid\" -DLINUX_MODULE_AUX_HEAP_NAME=aacraid -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=aacraid -DLINUX_MODULE_VERSION=\"3.5.10.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/aacraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-aacraid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o vmkdrivers/src26/common/vmklinux_module.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"megaraid_sas\" -DLINUX_MODULE_AUX_HEAP_NAME=megaraid_sas -DLINUX_MODULE_HEAP_INITIAL=8*1024*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=megaraid_sas -DLINUX_MODULE_VERSION=\"3.0.21.11vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/megaraid_sas -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-megaraid_sas.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/megaraid_sas/megaraid_sas.o vmkdrivers/src26/drivers/scsi/megaraid_sas/megaraid_sas.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"megaraid_sas\" -DLINUX_MODULE_AUX_HEAP_NAME=megaraid_sas -DLINUX_MODULE_HEAP_INITIAL=8*1024*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=megaraid_sas -DLINUX_MODULE_VERSION=\"3.0.21.11vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/megaraid_sas -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-megaraid_sas.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o vmkdrivers/src26/common/vmklinux_module.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"megaraid2\" -DLINUX_MODULE_AUX_HEAP_NAME=megaraid2 -DLINUX_MODULE_HEAP_INITIAL=8*1024*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=megaraid2 -DLINUX_MODULE_VERSION=\"2.00.4\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/megaraid2 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-megaraid2.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/megaraid2/megaraid.o vmkdrivers/src26/drivers/scsi/megaraid2/megaraid.c
@@ -258,8 +258,6 @@ $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Werror -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_ASSERTS -DDEBUG_STUB -DEXPORT_SYMTAB -DFCOE_T11_AUG07 -DGPLED_CODE -DKBUILD_MODNAME=\"fnic\" -DLINUX_MODULE_AUX_HEAP_NAME=fnic -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=32*1024*1024 -DLINUX_MODULE_HEAP_NAME=fnic -DLINUX_MODULE_VERSION=\"1.0.0.24206\" -DMODULE -DOPENFC_LIB -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/fnic -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_log.o vmkdrivers/src26/drivers/scsi/fnic/sa_log.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Werror -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_ASSERTS -DDEBUG_STUB -DEXPORT_SYMTAB -DFCOE_T11_AUG07 -DGPLED_CODE -DKBUILD_MODNAME=\"fnic\" -DLINUX_MODULE_AUX_HEAP_NAME=fnic -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=32*1024*1024 -DLINUX_MODULE_HEAP_NAME=fnic -DLINUX_MODULE_VERSION=\"1.0.0.24206\" -DMODULE -DOPENFC_LIB -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/fnic -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_state.o vmkdrivers/src26/drivers/scsi/fnic/sa_state.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Werror -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_ASSERTS -DDEBUG_STUB -DEXPORT_SYMTAB -DFCOE_T11_AUG07 -DGPLED_CODE -DKBUILD_MODNAME=\"fnic\" -DLINUX_MODULE_AUX_HEAP_NAME=fnic -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=32*1024*1024 -DLINUX_MODULE_HEAP_NAME=fnic -DLINUX_MODULE_VERSION=\"1.0.0.24206\" -DMODULE -DOPENFC_LIB -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/fnic -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_timer.o vmkdrivers/src26/drivers/scsi/fnic/sa_timer.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Werror -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_ASSERTS -DDEBUG_STUB -DEXPORT_SYMTAB -DFCOE_T11_AUG07 -DGPLED_CODE -DKBUILD_MODNAME=\"fnic\" -DLINUX_MODULE_AUX_HEAP_NAME=fnic -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=32*1024*1024 -DLINUX_MODULE_HEAP_NAME=fnic -DLINUX_MODULE_VERSION=\"1.0.0.24206\" -DMODULE -DOPENFC_LIB -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/fnic -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/crc32_le.o vmkdrivers/src26/drivers/scsi/fnic/crc32_le.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Werror -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_ASSERTS -DDEBUG_STUB -DEXPORT_SYMTAB -DFCOE_T11_AUG07 -DGPLED_CODE -DKBUILD_MODNAME=\"fnic\" -DLINUX_MODULE_AUX_HEAP_NAME=fnic -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=32*1024*1024 -DLINUX_MODULE_HEAP_NAME=fnic -DLINUX_MODULE_VERSION=\"1.0.0.24206\" -DMODULE -DOPENFC_LIB -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/fnic -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/crc32_le_tab.o vmkdrivers/src26/drivers/scsi/fnic/crc32_le_tab.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Werror -Wall -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_ASSERTS -DDEBUG_STUB -DEXPORT_SYMTAB -DFCOE_T11_AUG07 -DGPLED_CODE -DKBUILD_MODNAME=\"fnic\" -DLINUX_MODULE_AUX_HEAP_NAME=fnic -DLINUX_MODULE_HEAP_INITIAL=4*1024*1024 -DLINUX_MODULE_HEAP_MAX=32*1024*1024 -DLINUX_MODULE_HEAP_NAME=fnic -DLINUX_MODULE_VERSION=\"1.0.0.24206\" -DMODULE -DOPENFC_LIB -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/fnic -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o vmkdrivers/src26/common/vmklinux_module.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -w -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCONFIG_DCA -DCONFIG_DCA_MODULE -DCONFIG_IXGBE_MQ -DCONFIG_IXGBE_NAPI -DCONFIG_IXGBE_VMDQ -DCONFIG_NETDEVICES_MULTIQUEUE -DCONFIG_PCI_MSI -DCONFIG_PROC_FS -DCPU=x86-64 -DDEBUG_STUB -DDISABLE_PACKET_SPLIT -DDRIVER_IXGBE -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DIXGBE_NO_LRO -DKBUILD_MODNAME=\"ixgbe\" -DLINUX_MODULE_AUX_HEAP_NAME=ixgbe -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=ixgbe -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=22*1024*1024 -DLINUX_MODULE_VERSION=\"1.3.36\" -DMODULE -DNET_DRIVER -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/net/ixgbe -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/drivers/net -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-ixgbe.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/ixgbe/ixgbe_82598.o vmkdrivers/src26/drivers/net/ixgbe/ixgbe_82598.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -w -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCONFIG_DCA -DCONFIG_DCA_MODULE -DCONFIG_IXGBE_MQ -DCONFIG_IXGBE_NAPI -DCONFIG_IXGBE_VMDQ -DCONFIG_NETDEVICES_MULTIQUEUE -DCONFIG_PCI_MSI -DCONFIG_PROC_FS -DCPU=x86-64 -DDEBUG_STUB -DDISABLE_PACKET_SPLIT -DDRIVER_IXGBE -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DIXGBE_NO_LRO -DKBUILD_MODNAME=\"ixgbe\" -DLINUX_MODULE_AUX_HEAP_NAME=ixgbe -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=ixgbe -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=22*1024*1024 -DLINUX_MODULE_VERSION=\"1.3.36\" -DMODULE -DNET_DRIVER -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__USE_COMPAT_LAYER_2_6_18_PLUS__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/net/ixgbe -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/drivers/net -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-ixgbe.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/ixgbe/ixgbe_common.o vmkdrivers/src26/drivers/net/ixgbe/ixgbe_common.c
@@ -293,6 +291,7 @@ $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/linux/lib/string.o vmkdrivers/src26/vmklinux26/linux/lib/string.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/linux/lib/idr.o vmkdrivers/src26/vmklinux26/linux/lib/idr.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/linux/lib/hweight.o vmkdrivers/src26/vmklinux26/linux/lib/hweight.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/linux/lib/crc32.o vmkdrivers/src26/vmklinux26/linux/lib/crc32.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/linux/lib/semaphore-sleepers.o vmkdrivers/src26/vmklinux26/linux/lib/semaphore-sleepers.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/linux/lib/zlib_inflate/inflate.o vmkdrivers/src26/vmklinux26/linux/lib/zlib_inflate/inflate.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/linux/lib/zlib_inflate/inftrees.o vmkdrivers/src26/vmklinux26/linux/lib/zlib_inflate/inftrees.c
@@ -360,8 +359,8 @@ $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/vmware/linux_kthread.o vmkdrivers/src26/vmklinux26/vmware/linux_kthread.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/vmklinux26/vmware/linux_input.o vmkdrivers/src26/vmklinux26/vmware/linux_input.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DESX3_NETWORKING_NOT_DONE_YET -DGPLED_CODE -DKBUILD_MODNAME=\"vmklinux\" -DLINUX_MODULE_AUX_HEAP_NAME=vmklinux -DLINUX_MODULE_HEAP_INITIAL=256*1024 -DLINUX_MODULE_HEAP_MAX=20*1024*1024 -DLINUX_MODULE_HEAP_NAME=vmklinux -DLINUX_MODULE_SKB_HEAP -DLINUX_MODULE_SKB_HEAP_INITIAL=512*1024 -DLINUX_MODULE_SKB_HEAP_MAX=7*1024*1024 -DLINUX_MODULE_VERSION=\"None\" -DMODULE -DSCONS_NO_GVMOMI -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLINUX -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/vmklinux26/vmware -Ivmkdrivers/src26/vmklinux26/linux/arch/x86_64/kernel -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/linux -Ivmkdrivers/src26/include/vmklinux26 -Ivmkdrivers/src26/vmklinux26/linux/drivers/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-vmklinux.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o vmkdrivers/src26/common/vmklinux_module.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DGPLED_CODE -DKBUILD_MODNAME=\"hpsa\" -DLINUX_MODULE_AUX_HEAP_NAME=hpsa -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=hpsa -DLINUX_MODULE_VERSION=\"3.6.14.9.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/hpsa -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-hpsa.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/hpsa/hpsa.o vmkdrivers/src26/drivers/scsi/hpsa/hpsa.c
-$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DGPLED_CODE -DKBUILD_MODNAME=\"hpsa\" -DLINUX_MODULE_AUX_HEAP_NAME=hpsa -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=hpsa -DLINUX_MODULE_VERSION=\"3.6.14.9.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/hpsa -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-hpsa.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o vmkdrivers/src26/common/vmklinux_module.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DGPLED_CODE -DKBUILD_MODNAME=\"hpsa\" -DLINUX_MODULE_AUX_HEAP_NAME=hpsa -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=hpsa -DLINUX_MODULE_VERSION=\"3.6.14.9.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/hpsa -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-hpsa.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/hpsa/hpsa.o vmkdrivers/src26/drivers/scsi/hpsa/hpsa.c
+$CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-error -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DGPLED_CODE -DKBUILD_MODNAME=\"hpsa\" -DLINUX_MODULE_AUX_HEAP_NAME=hpsa -DLINUX_MODULE_HEAP_INITIAL=1024*100 -DLINUX_MODULE_HEAP_MAX=1024*4096 -DLINUX_MODULE_HEAP_NAME=hpsa -DLINUX_MODULE_VERSION=\"3.6.14.9.5vmw\" -DMODULE -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/hpsa -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-hpsa.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o vmkdrivers/src26/common/vmklinux_module.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"lpfc820\" -DLINUX_MODULE_AUX_HEAP_NAME=lpfc820 -DLINUX_MODULE_HEAP_INITIAL=8*1024*1024 -DLINUX_MODULE_HEAP_MAX=45*1024*1024 -DLINUX_MODULE_HEAP_NAME=lpfc820 -DLINUX_MODULE_VERSION=\"8.2.0.30.48vmw\" -DMODULE -DNETLINK_FCTRANSPORT=19 -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/lpfc820 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-lpfc820.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/lpfc820/lpfc_attr.o vmkdrivers/src26/drivers/scsi/lpfc820/lpfc_attr.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"lpfc820\" -DLINUX_MODULE_AUX_HEAP_NAME=lpfc820 -DLINUX_MODULE_HEAP_INITIAL=8*1024*1024 -DLINUX_MODULE_HEAP_MAX=45*1024*1024 -DLINUX_MODULE_HEAP_NAME=lpfc820 -DLINUX_MODULE_VERSION=\"8.2.0.30.48vmw\" -DMODULE -DNETLINK_FCTRANSPORT=19 -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/lpfc820 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-lpfc820.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/lpfc820/lpfc_auth_access.o vmkdrivers/src26/drivers/scsi/lpfc820/lpfc_auth_access.c
 $CC -fno-strict-aliasing -fno-working-directory -gdwarf-2 -g3 -O2 -Wall -Werror -Wstrict-prototypes -fPIE -falign-functions=4 -falign-jumps=4 -falign-loops=4 -ffreestanding -fno-common -fno-omit-frame-pointer -fno-strength-reduce -march=x86-64 -mcmodel=small -minline-all-stringops -mno-red-zone -nostartfiles -nostdlib -Wno-unused-value -Wno-pointer-sign -Wno-strict-prototypes -DCONFIG_COMPAT -DCPU=x86-64 -DDEBUG_STUB -DEXPORT_SYMTAB -DGPLED_CODE -DKBUILD_MODNAME=\"lpfc820\" -DLINUX_MODULE_AUX_HEAP_NAME=lpfc820 -DLINUX_MODULE_HEAP_INITIAL=8*1024*1024 -DLINUX_MODULE_HEAP_MAX=45*1024*1024 -DLINUX_MODULE_HEAP_NAME=lpfc820 -DLINUX_MODULE_VERSION=\"8.2.0.30.48vmw\" -DMODULE -DNETLINK_FCTRANSPORT=19 -DSCONS_NO_GVMOMI -DSCSI_DRIVER -DSMP_CAPABLE_VMK_DRIVER -DVMKERNEL_MODULE -DVMKLNX_VMKSGARRAY_SUPPORTED -DVMK_DEVKIT_HAS_API_VMKAPI_BASE -DVMK_DEVKIT_HAS_API_VMKAPI_DEVICE -DVMK_DEVKIT_HAS_API_VMKAPI_NET -DVMK_DEVKIT_HAS_API_VMKAPI_NPIV -DVMK_DEVKIT_HAS_API_VMKAPI_SCSI -DVMNIX -DVMX86_RELEASE -DVMX86_SERVER -DVMX86_VPROBES -D_LINUX -D__COMPAT_LAYER_2_6_18_PLUS__ -D__KERNEL__ -D__VMKERNEL_MODULE__ -D__VMKERNEL__ -D__VMKLNX__ -D__VMK_GCC_BUG_ALIGNMENT_PADDING__ -D__VMWARE__ -Ivmkdrivers/src26/drivers/scsi/lpfc820 -Ibora/build/scons/build/version -Ibora/vmkernel/include/vmkapi -Ivmkdrivers/src26/include -Ivmkdrivers/src26/include/vmklinux26 -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release -Ibora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/mac-default -Ibora/build/scons/build/HEADERS/vmkdrivers-vmkernel/vmkernel64/release -Ivmkdrivers/src26/include/scsi/drivers -Ivmkdrivers/src26/include/scsi -include bora/vmkernel/distribute/push-hidden.h -include vmkdrivers/src26/include/linux/autoconf.h -c -o bora/build/scons/build/vmkdriver-lpfc820.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/lpfc820/lpfc_auth.o vmkdrivers/src26/drivers/scsi/lpfc820/lpfc_auth.c
@@ -417,7 +416,7 @@ $LD -r -o bora/build/scons/build/vmkdriver-e1000e.o/release/vmkernel64/e1000e.o
 $LD -r -o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/e1000.o --whole-archive bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_82540.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_82541.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_82542.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_82543.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_api.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_ethtool.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_mac.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_main.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_manage.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_nvm.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_param.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/e1000_phy.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/kcompat.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/e1000/kcompat_ethtool.o bora/build/scons/build/vmkdriver-e1000.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o
 $LD -r -o bora/build/scons/build/vmkdriver-ehci-hcd.o/release/vmkernel64/ehci-hcd.o --whole-archive bora/build/scons/build/vmkdriver-ehci-hcd.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/usb/host/ehci/ehci-hcd.o bora/build/scons/build/vmkdriver-ehci-hcd.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o
 $LD -r -o bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/enic.o --whole-archive bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/enic/enic_main.o bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/enic/enic_res.o bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/enic/vnic_dev.o bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/enic/vnic_wq.o bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/enic/vnic_rq.o bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/enic/vnic_cq.o bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/enic/vnic_intr.o bora/build/scons/build/vmkdriver-enic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o
-$LD -r -o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/fnic.o --whole-archive bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_main.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_res.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_dev.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_wq.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_rq.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_cq.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_fcs.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_scsi.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_isr.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_intr.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_wq_copy.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_scsi.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_pkt.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_if.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_attr.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_ioctl.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fcs_attr.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fcs_cmd.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fcs_event.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fcs_state.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_exch.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_disc_targ.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_frame.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_local_port.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_print.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_remote_port.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_sess.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_virt_fab.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_port.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_assert.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_cons_linux.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_event.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_hash_kern.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_log.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_state.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_timer.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/crc32_le.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/crc32_le_tab.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o
+$LD -r -o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/fnic.o --whole-archive bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_main.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_res.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_dev.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_wq.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_rq.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_cq.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_fcs.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_scsi.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fnic_isr.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_intr.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/vnic_wq_copy.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_scsi.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_pkt.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_if.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_attr.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/openfc_ioctl.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fcs_attr.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fcs_cmd.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fcs_event.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fcs_state.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_exch.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_disc_targ.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_frame.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_local_port.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_print.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_remote_port.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_sess.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_virt_fab.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/fc_port.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_assert.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_cons_linux.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_event.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_hash_kern.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_log.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_state.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/fnic/sa_timer.o bora/build/scons/build/vmkdriver-fnic.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o
 $LD -r -o bora/build/scons/build/vmkdriver-forcedeth.o/release/vmkernel64/forcedeth.o --whole-archive bora/build/scons/build/vmkdriver-forcedeth.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/net/forcedeth/forcedeth.o bora/build/scons/build/vmkdriver-forcedeth.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o
 $LD -r -o bora/build/scons/build/vmkdriver-hid.o/release/vmkernel64/hid.o --whole-archive bora/build/scons/build/vmkdriver-hid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/usb/input/hid-core.o bora/build/scons/build/vmkdriver-hid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/usb/input/hid-ff.o bora/build/scons/build/vmkdriver-hid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/usb/input/hid-quirks.o bora/build/scons/build/vmkdriver-hid.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o
 $LD -r -o bora/build/scons/build/vmkdriver-hpsa.o/release/vmkernel64/hpsa.o --whole-archive bora/build/scons/build/vmkdriver-hpsa.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/drivers/scsi/hpsa/hpsa.o bora/build/scons/build/vmkdriver-hpsa.o/release/vmkernel64/SUBDIRS/vmkdrivers/src26/common/vmklinux_module.o
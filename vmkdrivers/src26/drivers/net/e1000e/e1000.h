@@ -166,6 +166,9 @@ struct e1000_ring {
 	struct sk_buff *rx_skb_top;
 
 	struct e1000_queue_stats stats;
+#if defined(__VMKLNX__)
+	struct vmklnx_page_pool *page_pool; /* premapped packet split pages */
+#endif
 };
 
 #ifdef SIOCGMIIPHY
@@ -505,6 +505,16 @@ static void e1000_alloc_rx_buffers_ps(struct e1000_adapter *adapter,
 				rx_desc->read.buffer_addr[j+1] = ~0;
 				continue;
 			}
+#if defined(__VMKLNX__)
+			if (!ps_page->page) {
+				unsigned int offset;
+
+				ps_page->page =
+					vmklnx_page_pool_alloc(rx_ring->page_pool,
+							       &offset,
+							       &ps_page->dma);
+			}
+#endif
 			if (!ps_page->page) {
 				ps_page->page = alloc_page(GFP_ATOMIC);
 				if (!ps_page->page) {
@@ -1144,6 +1154,11 @@ static bool e1000_clean_rx_irq_ps(struct e1000_adapter *adapter)
 				break;
 
 			ps_page = &buffer_info->ps_pages[j];
+#if defined(__VMKLNX__)
+			/* pool pages stay mapped until they are recycled */
+			if (!vmklnx_page_pool_owns(rx_ring->page_pool,
+						   ps_page->page))
+#endif
 			pci_unmap_page(pdev, ps_page->dma, PAGE_SIZE,
 				       PCI_DMA_FROMDEVICE);
 			ps_page->dma = 0;
@@ -1432,6 +1447,16 @@ static void e1000_clean_rx_ring(struct e1000_adapter *adapter)
 			ps_page = &buffer_info->ps_pages[j];
 			if (!ps_page->page)
 				break;
+#if defined(__VMKLNX__)
+			if (vmklnx_page_pool_owns(rx_ring->page_pool,
+						  ps_page->page)) {
+				vmklnx_page_pool_free(rx_ring->page_pool,
+						      ps_page->page, 0);
+				ps_page->dma = 0;
+				ps_page->page = NULL;
+				continue;
+			}
+#endif
 			pci_unmap_page(pdev, ps_page->dma, PAGE_SIZE,
 				       PCI_DMA_FROMDEVICE);
 			ps_page->dma = 0;
@@ -1473,6 +1498,11 @@ void e1000_free_rx_resources(struct e1000_adapter *adapter)
 
 	e1000_clean_rx_ring(adapter);
 
+#if defined(__VMKLNX__)
+	vmklnx_page_pool_destroy(rx_ring->page_pool);
+	rx_ring->page_pool = NULL;
+#endif
+
 	for (i = 0; i < rx_ring->count; i++) {
 		kfree(rx_ring->buffer_info[i].ps_pages);
 	}
@@ -2919,6 +2949,20 @@ static void e1000_configure_rx(struct e1000_adapter *adapter)
 		adapter->alloc_rx_buf = e1000_alloc_rx_buffers;
 	}
 
+#if defined(__VMKLNX__)
+	/* packet split pages come premapped out of a ring pool */
+	if (adapter->rx_ps_pages && !rx_ring->page_pool) {
+		rx_ring->page_pool =
+			vmklnx_page_pool_create(adapter->pdev,
+						rx_ring->count *
+						adapter->rx_ps_pages,
+						PAGE_SIZE);
+	} else if (!adapter->rx_ps_pages && rx_ring->page_pool) {
+		vmklnx_page_pool_destroy(rx_ring->page_pool);
+		rx_ring->page_pool = NULL;
+	}
+#endif
+
 	/* disable receives while setting up the descriptors */
 	rctl = er32(RCTL);
 	ew32(RCTL, rctl & ~E1000_RCTL_EN);
@@ -42,6 +42,7 @@
 #include "cq_enet_desc.h"
 #include "vnic_dev.h"
 #include "vnic_intr.h"
+#include "vnic_nic.h"
 #include "vnic_stats.h"
 #include "enic_res.h"
 #include "enic.h"
@@ -417,8 +418,8 @@ static irqreturn_t enic_isr_legacy(int irq, void *data)
 	}
 
 	if (ENIC_TEST_INTR(pba, ENIC_INTX_WQ_RQ)) {
-		if (netif_rx_schedule_prep(netdev, &enic->napi))
-			__netif_rx_schedule(netdev, &enic->napi);
+		if (netif_rx_schedule_prep(netdev, &enic->napi[0]))
+			__netif_rx_schedule(netdev, &enic->napi[0]);
 	} else {
 		vnic_intr_unmask(&enic->intr[ENIC_INTX_WQ_RQ]);
 	}
@@ -446,17 +447,17 @@ static irqreturn_t enic_isr_msi(int irq, void *data)
 	 * writes).
 	 */
 
-	netif_rx_schedule(enic->netdev, &enic->napi);
+	netif_rx_schedule(enic->netdev, &enic->napi[0]);
 
 	return IRQ_HANDLED;
 }
 
 static irqreturn_t enic_isr_msix_rq(int irq, void *data)
 {
-	struct enic *enic = data;
+	struct napi_struct *napi = data;
 
 	/* schedule NAPI polling for RQ cleanup */
-	netif_rx_schedule(enic->netdev, &enic->napi);
+	netif_rx_schedule(napi->dev, napi);
 
 	return IRQ_HANDLED;
 }
@@ -467,10 +468,10 @@ static irqreturn_t enic_isr_msix_wq(int irq, void *data)
 	unsigned int wq_work_to_do = -1; /* no limit */
 	unsigned int wq_work_done;
 
-	wq_work_done = vnic_cq_service(&enic->cq[ENIC_CQ_WQ],
+	wq_work_done = vnic_cq_service(&enic->cq[enic_cq_wq(enic, 0)],
 		wq_work_to_do, enic_wq_service, NULL);
 
-	vnic_intr_return_credits(&enic->intr[ENIC_MSIX_WQ],
+	vnic_intr_return_credits(&enic->intr[enic_msix_wq_intr(enic, 0)],
 		wq_work_done,
 		1 /* unmask intr */,
 		1 /* reset intr timer */);
@@ -482,7 +483,7 @@ static irqreturn_t enic_isr_msix_err(int irq, void *data)
 {
 	struct enic *enic = data;
 
-	vnic_intr_return_all_credits(&enic->intr[ENIC_MSIX_ERR]);
+	vnic_intr_return_all_credits(&enic->intr[enic_msix_err_intr(enic)]);
 
 	enic_log_q_error(enic);
 
@@ -496,7 +497,7 @@ static irqreturn_t enic_isr_msix_notify(int irq, void *data)
 {
 	struct enic *enic = data;
 
-	vnic_intr_return_all_credits(&enic->intr[ENIC_MSIX_NOTIFY]);
+	vnic_intr_return_all_credits(&enic->intr[enic_msix_notify_intr(enic)]);
 	enic_notify_check(enic);
 
 	return IRQ_HANDLED;
@@ -1080,7 +1081,8 @@ static void enic_rq_indicate_buf(struct vnic_rq *rq,
 		if (enic->vlan_group && vlan_stripped) {
 
 			if ((netdev->features & NETIF_F_LRO) && ipv4)
-				lro_vlan_hwaccel_receive_skb(&enic->lro_mgr,
+				lro_vlan_hwaccel_receive_skb(
+					&enic->lro_mgr[rq->index],
 					skb, enic->vlan_group,
 					vlan, cq_desc);
 			else
@@ -1090,7 +1092,8 @@ static void enic_rq_indicate_buf(struct vnic_rq *rq,
 		} else {
 
 			if ((netdev->features & NETIF_F_LRO) && ipv4)
-				lro_receive_skb(&enic->lro_mgr, skb, cq_desc);
+				lro_receive_skb(&enic->lro_mgr[rq->index],
+					skb, cq_desc);
 			else
 				netif_receive_skb(skb);
 
@@ -1147,8 +1150,8 @@ static int enic_rq_service_drop(struct vnic_dev *vdev, struct cq_desc *cq_desc,
 
 static int enic_poll(struct napi_struct *napi, int budget)
 {
-	struct enic *enic = container_of(napi, struct enic, napi);
-	struct net_device *netdev = enic->netdev;
+	struct net_device *netdev = napi->dev;
+	struct enic *enic = netdev_priv(netdev);
 	unsigned int rq_work_to_do = budget;
 	unsigned int wq_work_to_do = -1; /* no limit */
 	unsigned int  work_done, rq_work_done, wq_work_done;
@@ -1156,10 +1159,10 @@ static int enic_poll(struct napi_struct *napi, int budget)
 	/* Service RQ (first) and WQ
 	 */
 
-	rq_work_done = vnic_cq_service(&enic->cq[ENIC_CQ_RQ],
+	rq_work_done = vnic_cq_service(&enic->cq[enic_cq_rq(enic, 0)],
 		rq_work_to_do, enic_rq_service, NULL);
 
-	wq_work_done = vnic_cq_service(&enic->cq[ENIC_CQ_WQ],
+	wq_work_done = vnic_cq_service(&enic->cq[enic_cq_wq(enic, 0)],
 		wq_work_to_do, enic_wq_service, NULL);
 
 	/* Accumulate intr event credits for this polling
@@ -1188,7 +1191,7 @@ static int enic_poll(struct napi_struct *napi, int budget)
 		 */
 
 		if (netdev->features & NETIF_F_LRO)
-			lro_flush_all(&enic->lro_mgr);
+			lro_flush_all(&enic->lro_mgr[0]);
 
 		netif_rx_complete(netdev, napi);
 		vnic_intr_unmask(&enic->intr[ENIC_INTX_WQ_RQ]);
@@ -1199,15 +1202,17 @@ static int enic_poll(struct napi_struct *napi, int budget)
 
 static int enic_poll_msix(struct napi_struct *napi, int budget)
 {
-	struct enic *enic = container_of(napi, struct enic, napi);
-	struct net_device *netdev = enic->netdev;
+	struct net_device *netdev = napi->dev;
+	struct enic *enic = netdev_priv(netdev);
+	unsigned int rq = napi - &enic->napi[0];
+	unsigned int intr = enic_msix_rq_intr(enic, rq);
 	unsigned int work_to_do = budget;
 	unsigned int work_done;
 
 	/* Service RQ
 	 */
 
-	work_done = vnic_cq_service(&enic->cq[ENIC_CQ_RQ],
+	work_done = vnic_cq_service(&enic->cq[enic_cq_rq(enic, rq)],
 		work_to_do, enic_rq_service, NULL);
 
 	if (work_done > 0) {
@@ -1215,14 +1220,14 @@ static int enic_poll_msix(struct napi_struct *napi, int budget)
 		/* Replenish RQ
 		 */
 
-		vnic_rq_fill(&enic->rq[0], enic_rq_alloc_buf);
+		vnic_rq_fill(&enic->rq[rq], enic_rq_alloc_buf);
 
 		/* Return intr event credits for this polling
 		 * cycle.  An intr event is the completion of a
 		 * RQ packet.
 		 */
 
-		vnic_intr_return_credits(&enic->intr[ENIC_MSIX_RQ],
+		vnic_intr_return_credits(&enic->intr[intr],
 			work_done,
 			0 /* don't unmask intr */,
 			0 /* don't reset intr timer */);
@@ -1232,10 +1237,10 @@ static int enic_poll_msix(struct napi_struct *napi, int budget)
 		 */
 
 		if (netdev->features & NETIF_F_LRO)
-			lro_flush_all(&enic->lro_mgr);
+			lro_flush_all(&enic->lro_mgr[rq]);
 
 		netif_rx_complete(netdev, napi);
-		vnic_intr_unmask(&enic->intr[ENIC_MSIX_RQ]);
+		vnic_intr_unmask(&enic->intr[intr]);
 	}
 
 	return work_done;
@@ -1246,7 +1251,7 @@ static int enic_poll_msix(struct napi_struct *napi, int budget)
 static int __enic_poll(struct net_device *netdev, int *budget)
 {
 	struct enic *enic = netdev_priv(netdev);
-	struct napi_struct *napi = &enic->napi;
+	struct napi_struct *napi = &enic->napi[0];
 	unsigned int work_done;
 	unsigned int work_to_do = min(*budget, netdev->quota);
 
@@ -1283,7 +1288,7 @@ static void enic_free_intr(struct enic *enic)
 		free_irq(enic->pdev->irq, enic);
 		break;
 	case VNIC_DEV_INTR_MODE_MSIX:
-		for (i = 0; i < ARRAY_SIZE(enic->msix); i++)
+		for (i = 0; i < enic->intr_count; i++)
 			if (enic->msix[i].requested)
 				free_irq(enic->msix_entry[i].vector,
 					enic->msix[i].devid);
@@ -1296,7 +1301,7 @@ static void enic_free_intr(struct enic *enic)
 static int enic_request_intr(struct enic *enic)
 {
 	struct net_device *netdev = enic->netdev;
-	unsigned int i;
+	unsigned int i, intr;
 	int err = 0;
 
 	switch (vnic_dev_get_intr_mode(enic->vdev)) {
@@ -1315,27 +1320,33 @@ static int enic_request_intr(struct enic *enic)
 
 	case VNIC_DEV_INTR_MODE_MSIX:
 
-		sprintf(enic->msix[ENIC_MSIX_RQ].devname,
-			"%.11s-rx-0", netdev->name);
-		enic->msix[ENIC_MSIX_RQ].isr = enic_isr_msix_rq;
-		enic->msix[ENIC_MSIX_RQ].devid = enic;
+		for (i = 0; i < enic->rq_count; i++) {
+			intr = enic_msix_rq_intr(enic, i);
+			sprintf(enic->msix[intr].devname,
+				"%.11s-rx-%d", netdev->name, i);
+			enic->msix[intr].isr = enic_isr_msix_rq;
+			enic->msix[intr].devid = &enic->napi[i];
+		}
 
-		sprintf(enic->msix[ENIC_MSIX_WQ].devname,
+		intr = enic_msix_wq_intr(enic, 0);
+		sprintf(enic->msix[intr].devname,
 			"%.11s-tx-0", netdev->name);
-		enic->msix[ENIC_MSIX_WQ].isr = enic_isr_msix_wq;
-		enic->msix[ENIC_MSIX_WQ].devid = enic;
+		enic->msix[intr].isr = enic_isr_msix_wq;
+		enic->msix[intr].devid = enic;
 
-		sprintf(enic->msix[ENIC_MSIX_ERR].devname,
+		intr = enic_msix_err_intr(enic);
+		sprintf(enic->msix[intr].devname,
 			"%.11s-err", netdev->name);
-		enic->msix[ENIC_MSIX_ERR].isr = enic_isr_msix_err;
-		enic->msix[ENIC_MSIX_ERR].devid = enic;
+		enic->msix[intr].isr = enic_isr_msix_err;
+		enic->msix[intr].devid = enic;
 
-		sprintf(enic->msix[ENIC_MSIX_NOTIFY].devname,
+		intr = enic_msix_notify_intr(enic);
+		sprintf(enic->msix[intr].devname,
 			"%.11s-notify", netdev->name);
-		enic->msix[ENIC_MSIX_NOTIFY].isr = enic_isr_msix_notify;
-		enic->msix[ENIC_MSIX_NOTIFY].devid = enic;
+		enic->msix[intr].isr = enic_isr_msix_notify;
+		enic->msix[intr].devid = enic;
 
-		for (i = 0; i < ARRAY_SIZE(enic->msix); i++) {
+		for (i = 0; i < enic->intr_count; i++) {
 			err = request_irq(enic->msix_entry[i].vector,
 				enic->msix[i].isr, 0,
 				enic->msix[i].devname,
@@ -1365,7 +1376,8 @@ static int enic_notify_set(struct enic *enic)
 		err = vnic_dev_notify_set(enic->vdev, ENIC_INTX_NOTIFY);
 		break;
 	case VNIC_DEV_INTR_MODE_MSIX:
-		err = vnic_dev_notify_set(enic->vdev, ENIC_MSIX_NOTIFY);
+		err = vnic_dev_notify_set(enic->vdev,
+			enic_msix_notify_intr(enic));
 		break;
 	default:
 		err = vnic_dev_notify_set(enic->vdev, -1 /* no intr */);
@@ -1440,7 +1452,8 @@ static int enic_open(struct net_device *netdev)
 	enic_set_multicast_list(netdev);
 
 	netif_wake_queue(netdev);
-	napi_enable(&enic->napi);
+	for (i = 0; i < enic->rq_count; i++)
+		napi_enable(&enic->napi[i]);
 	vnic_dev_enable(enic->vdev);
 
 	for (i = 0; i < enic->intr_count; i++)
@@ -1468,7 +1481,8 @@ static int enic_stop(struct net_device *netdev)
 	del_timer_sync(&enic->notify_timer);
 
 	vnic_dev_disable(enic->vdev);
-	napi_disable(&enic->napi);
+	for (i = 0; i < enic->rq_count; i++)
+		napi_disable(&enic->napi[i]);
 	netif_stop_queue(netdev);
 
 	for (i = 0; i < enic->intr_count; i++)
@@ -1488,10 +1502,12 @@ static int enic_stop(struct net_device *netdev)
 	vnic_dev_notify_unset(enic->vdev);
 	enic_free_intr(enic);
 
-	(void)vnic_cq_service(&enic->cq[ENIC_CQ_RQ],
-		-1, enic_rq_service_drop, NULL);
-	(void)vnic_cq_service(&enic->cq[ENIC_CQ_WQ],
-		-1, enic_wq_service, NULL);
+	for (i = 0; i < enic->rq_count; i++)
+		(void)vnic_cq_service(&enic->cq[enic_cq_rq(enic, i)],
+			-1, enic_rq_service_drop, NULL);
+	for (i = 0; i < enic->wq_count; i++)
+		(void)vnic_cq_service(&enic->cq[enic_cq_wq(enic, i)],
+			-1, enic_wq_service, NULL);
 
 	for (i = 0; i < enic->wq_count; i++)
 		vnic_wq_clean(&enic->wq[i], enic_free_wq_buf);
@@ -1535,10 +1551,12 @@ static void enic_poll_controller(struct net_device *netdev)
 {
 	struct enic *enic = netdev_priv(netdev);
 	struct vnic_dev *vdev = enic->vdev;
+	unsigned int i;
 
 	switch (vnic_dev_get_intr_mode(vdev)) {
 	case VNIC_DEV_INTR_MODE_MSIX:
-		enic_isr_msix_rq(enic->pdev->irq, enic);
+		for (i = 0; i < enic->rq_count; i++)
+			enic_isr_msix_rq(enic->pdev->irq, &enic->napi[i]);
 		enic_isr_msix_wq(enic->pdev->irq, enic);
 		break;
 	case VNIC_DEV_INTR_MODE_MSI:
@@ -1614,19 +1632,126 @@ static int enic_dev_soft_reset(struct enic *enic)
 	return err;
 }
 
+static int enic_set_rsskey(struct enic *enic)
+{
+	union vnic_rss_key *rss_key_buf_va;
+	dma_addr_t rss_key_buf_pa;
+	static const u8 rss_key[ENIC_RSS_KEY_LEN] = {
+		85, 67, 83, 97, 119, 101, 115, 111, 109, 101,
+		80, 65, 76, 79, 117, 110, 105, 113, 117, 101,
+		76, 73, 78, 85, 88, 114, 111, 99, 107, 115,
+		69, 78, 73, 67, 105, 115, 99, 111, 111, 108,
+	};
+	unsigned int i;
+	int err;
+
+	rss_key_buf_va = pci_alloc_consistent(enic->pdev,
+		sizeof(union vnic_rss_key), &rss_key_buf_pa);
+	if (!rss_key_buf_va)
+		return -ENOMEM;
+
+	/* The key is handed over in 10 byte subkeys, each padded
+	 * out to 16 bytes
+	 */
+
+	memset(rss_key_buf_va, 0, sizeof(union vnic_rss_key));
+	for (i = 0; i < ENIC_RSS_KEY_LEN; i++)
+		rss_key_buf_va->key[i / 10].b[i % 10] = rss_key[i];
+
+	err = enic_set_rss_key(enic, rss_key_buf_pa,
+		sizeof(union vnic_rss_key));
+
+	pci_free_consistent(enic->pdev, sizeof(union vnic_rss_key),
+		rss_key_buf_va, rss_key_buf_pa);
+
+	return err;
+}
+
+static int enic_set_rsscpu(struct enic *enic, u8 rss_hash_bits)
+{
+	union vnic_rss_cpu *rss_cpu_buf_va;
+	dma_addr_t rss_cpu_buf_pa;
+	unsigned int i;
+	int err;
+
+	rss_cpu_buf_va = pci_alloc_consistent(enic->pdev,
+		sizeof(union vnic_rss_cpu), &rss_cpu_buf_pa);
+	if (!rss_cpu_buf_va)
+		return -ENOMEM;
+
+	/* Spread the indirection table round-robin across the RQs
+	 */
+
+	for (i = 0; i < (1 << rss_hash_bits); i++)
+		rss_cpu_buf_va->cpu[i / 4].b[i % 4] = i % enic->rq_count;
+
+	err = enic_set_rss_cpu(enic, rss_cpu_buf_pa,
+		sizeof(union vnic_rss_cpu));
+
+	pci_free_consistent(enic->pdev, sizeof(union vnic_rss_cpu),
+		rss_cpu_buf_va, rss_cpu_buf_pa);
+
+	return err;
+}
+
+static u8 enic_rss_hash_type(struct enic *enic)
+{
+	u8 rss_hash_type = 0;
+
+	if (ENIC_SETTING(enic, RSSHASH_IPV4))
+		rss_hash_type |= NIC_CFG_RSS_HASH_TYPE_IPV4;
+	if (ENIC_SETTING(enic, RSSHASH_TCPIPV4))
+		rss_hash_type |= NIC_CFG_RSS_HASH_TYPE_TCP_IPV4;
+	if (ENIC_SETTING(enic, RSSHASH_IPV6))
+		rss_hash_type |= NIC_CFG_RSS_HASH_TYPE_IPV6;
+	if (ENIC_SETTING(enic, RSSHASH_TCPIPV6))
+		rss_hash_type |= NIC_CFG_RSS_HASH_TYPE_TCP_IPV6;
+	if (ENIC_SETTING(enic, RSSHASH_IPV6_EX))
+		rss_hash_type |= NIC_CFG_RSS_HASH_TYPE_IPV6_EX;
+	if (ENIC_SETTING(enic, RSSHASH_TCPIPV6_EX))
+		rss_hash_type |= NIC_CFG_RSS_HASH_TYPE_TCP_IPV6_EX;
+
+	/* No hash types provisioned for the vNIC; hash on the
+	 * IP and TCP 4-tuple for both address families
+	 */
+
+	if (!rss_hash_type)
+		rss_hash_type = NIC_CFG_RSS_HASH_TYPE_IPV4 |
+			NIC_CFG_RSS_HASH_TYPE_TCP_IPV4 |
+			NIC_CFG_RSS_HASH_TYPE_IPV6 |
+			NIC_CFG_RSS_HASH_TYPE_TCP_IPV6;
+
+	return rss_hash_type;
+}
+
 static int enic_set_niccfg(struct enic *enic)
 {
 	const u8 rss_default_cpu = 0;
-	const u8 rss_hash_type = 0;
-	const u8 rss_hash_bits = 0;
 	const u8 rss_base_cpu = 0;
-	const u8 rss_enable = 0;
 	const u8 tso_ipid_split_en = 0;
 	const u8 ig_vlan_strip_en = 1;
+	u8 rss_hash_type = 0;
+	u8 rss_hash_bits = 0;
+	u8 rss_enable = 0;
 
-	/* Enable VLAN tag stripping.  RSS not enabled (yet).
+	/* Enable VLAN tag stripping.  Enable RSS when the vNIC is
+	 * provisioned for it and we got more than one RQ (MSI-X only).
 	 */
 
+	if (ENIC_SETTING(enic, RSS) && enic->rq_count > 1) {
+		rss_hash_bits = ENIC_RSS_HASH_BITS;
+		if (!enic_set_rsskey(enic) &&
+		    !enic_set_rsscpu(enic, rss_hash_bits)) {
+			rss_hash_type = enic_rss_hash_type(enic);
+			rss_enable = 1;
+		} else {
+			printk(KERN_WARNING PFX
+				"Failed to program RSS, "
+				"using a single receive queue.\n");
+			rss_hash_bits = 0;
+		}
+	}
+
 	return enic_set_nic_cfg(enic,
 		 rss_default_cpu, rss_hash_type,
 		 rss_hash_bits, rss_base_cpu,
@@ -1660,8 +1785,8 @@ static void enic_reset(struct work_struct *work)
 
 static int enic_set_intr_mode(struct enic *enic)
 {
-	unsigned int n = ARRAY_SIZE(enic->rq);
-	unsigned int m = ARRAY_SIZE(enic->wq);
+	unsigned int n = min_t(unsigned int, enic->rq_count, ENIC_RQ_MAX);
+	unsigned int m = min_t(unsigned int, enic->wq_count, ENIC_WQ_MAX);
 	unsigned int i;
 
 	/* Set interrupt mode (INTx, MSI, MSI-X) depending
@@ -1672,15 +1797,20 @@ static int enic_set_intr_mode(struct enic *enic)
 	 * We need n RQs, m WQs, n+m CQs, and n+m+2 INTRs
 	 * (the second to last INTR is used for WQ/RQ errors)
 	 * (the last INTR is used for notifications)
+	 *
+	 * More than one RQ is only useful with RSS, and then
+	 * there is no point in more RQs than CPUs to poll them.
 	 */
 
-	BUG_ON(ARRAY_SIZE(enic->msix_entry) < n + m + 2);
-	for (i = 0; i < n + m + 2; i++)
+	if (!ENIC_SETTING(enic, RSS))
+		n = 1;
+	n = min_t(unsigned int, n, num_online_cpus());
+
+	for (i = 0; i < ARRAY_SIZE(enic->msix_entry); i++)
 		enic->msix_entry[i].entry = i;
 
 	if (enic->config.intr_mode < 1 &&
-	    enic->rq_count >= n &&
-	    enic->wq_count >= m &&
+	    n > 1 && m >= 1 &&
 	    enic->cq_count >= n + m &&
 	    enic->intr_count >= n + m + 2 &&
 	    !pci_enable_msix(enic->pdev, enic->msix_entry, n + m + 2)) {
@@ -1695,6 +1825,29 @@ static int enic_set_intr_mode(struct enic *enic)
 		return 0;
 	}
 
+	/* Next try MSI-X with a single RQ, e.g. when there are
+	 * not enough CQs/INTRs for RSS
+	 *
+	 * We need 1 RQ, 1 WQ, 2 CQs, and 4 INTRs
+	 */
+
+	if (enic->config.intr_mode < 1 &&
+	    enic->rq_count >= 1 &&
+	    enic->wq_count >= 1 &&
+	    enic->cq_count >= 2 &&
+	    enic->intr_count >= 4 &&
+	    !pci_enable_msix(enic->pdev, enic->msix_entry, 4)) {
+
+		enic->rq_count = 1;
+		enic->wq_count = 1;
+		enic->cq_count = 2;
+		enic->intr_count = 4;
+
+		vnic_dev_set_intr_mode(enic->vdev, VNIC_DEV_INTR_MODE_MSIX);
+
+		return 0;
+	}
+
 	/* Next try MSI
 	 *
 	 * We need 1 RQ, 1 WQ, 2 CQs, and 1 INTR
@@ -2026,10 +2179,12 @@ static int __devinit enic_probe(struct pci_dev *pdev,
 
 	switch (vnic_dev_get_intr_mode(enic->vdev)) {
 	default:
-		netif_napi_add(netdev, &enic->napi, enic_poll, 64);
+		netif_napi_add(netdev, &enic->napi[0], enic_poll, 64);
 		break;
 	case VNIC_DEV_INTR_MODE_MSIX:
-		netif_napi_add(netdev, &enic->napi, enic_poll_msix, 64);
+		for (i = 0; i < enic->rq_count; i++)
+			netif_napi_add(netdev, &enic->napi[i],
+				enic_poll_msix, 64);
 		break;
 	}
 
@@ -2051,14 +2206,18 @@ static int __devinit enic_probe(struct pci_dev *pdev,
 #endif
 	enic->csum_rx_enabled = ENIC_SETTING(enic, RXCSUM);
 
-	enic->lro_mgr.max_aggr = ENIC_LRO_MAX_AGGR;
-	enic->lro_mgr.max_desc = ENIC_LRO_MAX_DESC;
-	enic->lro_mgr.lro_arr = enic->lro_desc;
-	enic->lro_mgr.get_skb_header = enic_get_skb_header;
-	enic->lro_mgr.features	= LRO_F_NAPI | LRO_F_EXTRACT_VLAN_ID;
-	enic->lro_mgr.dev = netdev;
-	enic->lro_mgr.ip_summed = CHECKSUM_COMPLETE;
-	enic->lro_mgr.ip_summed_aggr = CHECKSUM_UNNECESSARY;
+	for (i = 0; i < enic->rq_count; i++) {
+		struct net_lro_mgr *lro_mgr = &enic->lro_mgr[i];
+
+		lro_mgr->max_aggr = ENIC_LRO_MAX_AGGR;
+		lro_mgr->max_desc = ENIC_LRO_MAX_DESC;
+		lro_mgr->lro_arr = enic->lro_desc[i];
+		lro_mgr->get_skb_header = enic_get_skb_header;
+		lro_mgr->features = LRO_F_NAPI | LRO_F_EXTRACT_VLAN_ID;
+		lro_mgr->dev = netdev;
+		lro_mgr->ip_summed = CHECKSUM_COMPLETE;
+		lro_mgr->ip_summed_aggr = CHECKSUM_UNNECESSARY;
+	}
 
 #if defined(__VMKLNX__)
 
@@ -128,6 +128,7 @@ struct e1000_adv_context_desc {
 #define E1000_TX_SEQNUM_WB_ENABLE 0x2
 
 #define E1000_MRQC_ENABLE_RSS_4Q            0x00000002
+#define E1000_MRQC_ENABLE_VMDQ              0x00000003
 #define E1000_MRQC_RSS_FIELD_IPV4_UDP       0x00400000
 #define E1000_MRQC_RSS_FIELD_IPV6_UDP       0x00800000
 #define E1000_MRQC_RSS_FIELD_IPV6_UDP_EX    0x01000000
@@ -375,6 +376,19 @@ struct e1000_adv_tx_context_desc {
 #define E1000_VMOLR_BAM        0x08000000 /* Accept Broadcast packets */
 #define E1000_VMOLR_MPME       0x10000000 /* Multicast promiscuous mode */
 #define E1000_VMOLR_STRVLAN    0x40000000 /* Vlan stripping enable */
+#define E1000_VMOLR_ROMPE      0x02000000 /* Accept packets matched in MTA */
+#define E1000_VMOLR_RLPML_MASK 0x00003FFF /* Long packet maximum length */
+
+/* RAH pool/queue select; 82575 takes a queue index, 82576 a pool bitmap */
+#define E1000_RAH_POOL_MASK    0x03FC0000
+#define E1000_RAH_POOL_1       0x00040000
+
+/* VLAN pool membership (82576) */
+#define E1000_VLVF_ARRAY_SIZE     32
+#define E1000_VLVF_VLANID_MASK    0x00000FFF
+#define E1000_VLVF_POOLSEL_SHIFT  12
+#define E1000_VLVF_POOLSEL_MASK   (0xFF << E1000_VLVF_POOLSEL_SHIFT)
+#define E1000_VLVF_VLANID_ENABLE  0x80000000
 
 #define E1000_V2PMAILBOX_REQ   0x00000001 /* Request for PF Ready bit */
 #define E1000_V2PMAILBOX_ACK   0x00000002 /* Ack PF message received */
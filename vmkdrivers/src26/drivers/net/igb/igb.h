@@ -131,6 +131,13 @@ struct igb_adapter;
 #define IGB_RXBUFFER_8192  8192
 #define IGB_RXBUFFER_16384 16384
 
+#if defined(__VMKLNX__)
+/* packet split buffers are half pages out of the vmklinux rx page pool */
+#define IGB_RX_PS_BUFSZ    (PAGE_SIZE / 2)
+#else
+#define IGB_RX_PS_BUFSZ    PAGE_SIZE
+#endif
+
 /* Packet Buffer allocations */
 #define IGB_PBA_BYTES_SHIFT 0xA
 #define IGB_TX_HEAD_ADDR_SHIFT 7
@@ -168,6 +175,7 @@ struct igb_buffer {
 		struct {
 			struct page *page;
 			u64 page_dma;
+			unsigned int page_offset;
 		};
 	};
 };
@@ -199,6 +207,11 @@ struct igb_ring {
 	unsigned int total_packets;
 
 	char name[IFNAMSIZ + 5];
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	bool allocated;              /* handed out as a netqueue */
+	bool active;                 /* rx: mac filter programmed */
+	u8 mac_addr[ETH_ALEN];       /* rx: netqueue filter address */
+#endif
 	union {
 		/* TX */
 		struct {
@@ -214,6 +227,9 @@ struct igb_ring {
 			int set_itr;
 			int interrupt_count;
 			struct igb_ring *buddy;
+#if defined(__VMKLNX__)
+			struct vmklnx_page_pool *page_pool;
+#endif
 #ifdef IGB_LRO
 			struct net_lro_mgr lro_mgr;
 			bool lro_used;
@@ -336,6 +352,10 @@ struct igb_adapter {
 	unsigned int tx_ring_count;
 	unsigned int rx_ring_count;
 	u32 stats_freq_us;
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	u32 n_rx_queues_allocated;
+	u32 rss_mrqc;
+#endif
 };
 
 
@@ -347,6 +367,7 @@ struct igb_adapter {
 #define IGB_FLAG_IN_NETPOLL        (1 << 5)
 #define IGB_FLAG_QUAD_PORT_A       (1 << 6)
 #define IGB_FLAG_NEED_CTX_IDX      (1 << 7)
+#define IGB_FLAG_VMDQ_ENABLED      (1 << 8)
 
 enum e1000_state_t {
 	__IGB_TESTING,
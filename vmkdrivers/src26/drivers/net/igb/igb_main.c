@@ -164,6 +164,14 @@ static struct notifier_block dca_notifier = {
 static void igb_netpoll (struct net_device *);
 #endif
 
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+static void igb_rar_set_qsel(struct igb_adapter *, u8 *, u32, u32);
+static void igb_configure_vmdq(struct igb_adapter *);
+static void igb_vmdq_set_vmolr(struct igb_adapter *);
+static void igb_vmdq_set_vlvf(struct igb_adapter *, u16, bool);
+static int igb_netqueue_ops(vmknetddi_queueops_op_t op, void *args);
+#endif
+
 #ifdef HAVE_PCI_ERS
 static pci_ers_result_t igb_io_error_detected(struct pci_dev *,
                      pci_channel_state_t);
@@ -648,6 +656,15 @@ static void igb_set_interrupt_capability(struct igb_adapter *adapter)
 		break;
 	}
 
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	/* NetQueue needs a vector per rx queue to steer interrupts, so
+	 * only offer it when MSI-X came up with more than one queue. */
+	if (adapter->msix_entries && adapter->num_rx_queues > 1)
+		adapter->flags |= IGB_FLAG_VMDQ_ENABLED;
+	else
+		adapter->flags &= ~IGB_FLAG_VMDQ_ENABLED;
+#endif
+
 #ifdef CONFIG_NETDEVICES_MULTIQUEUE
 	/* Notify the stack of the (possibly) reduced Tx Queue count. */
 	adapter->netdev->egress_subqueue_count = adapter->num_tx_queues;
@@ -679,6 +696,9 @@ static int igb_request_irq(struct igb_adapter *adapter)
 		igb_free_all_tx_resources(adapter);
 		igb_free_all_rx_resources(adapter);
 		adapter->num_rx_queues = 1;
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+		adapter->flags &= ~IGB_FLAG_VMDQ_ENABLED;
+#endif
 		igb_alloc_queues(adapter);
 	} else {
 		switch (hw->mac.type) {
@@ -1355,6 +1375,12 @@ static int __devinit igb_probe(struct pci_dev *pdev,
 #else /* defined(__VMKLNX__) */
         strcpy(netdev->name, "");
 #endif /* !defined(__VMKLNX__) */
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	if (adapter->flags & IGB_FLAG_VMDQ_ENABLED) {
+		DPRINTK(PROBE, INFO, "Registering for VMware NetQueue Ops\n");
+		VMKNETDDI_REGISTER_QUEUEOPS(netdev, igb_netqueue_ops);
+	}
+#endif
 	err = register_netdev(netdev);
 	if (err)
 		goto err_register;
@@ -1957,8 +1983,8 @@ static void igb_setup_rctl(struct igb_adapter *adapter)
 		adapter->rx_ps_hdr_size = IGB_RXBUFFER_128;
 		srrctl = adapter->rx_ps_hdr_size <<
 		         E1000_SRRCTL_BSIZEHDRSIZE_SHIFT;
-		/* buffer size is ALWAYS one page */
-		srrctl |= PAGE_SIZE >> E1000_SRRCTL_BSIZEPKT_SHIFT;
+		/* buffer size is ALWAYS one page (half a page on ESX) */
+		srrctl |= IGB_RX_PS_BUFSZ >> E1000_SRRCTL_BSIZEPKT_SHIFT;
 		srrctl |= E1000_SRRCTL_DESCTYPE_HDR_SPLIT_ALWAYS;
 	} else {
 #endif /* CONFIG_IGB_DISABLE_PACKET_SPLIT */
@@ -1972,6 +1998,23 @@ static void igb_setup_rctl(struct igb_adapter *adapter)
 		E1000_WRITE_REG(hw, E1000_SRRCTL(i), srrctl);
 	}
 
+#if defined(__VMKLNX__)
+	/* packet split pages come premapped out of a per ring pool */
+	for (i = 0; i < adapter->num_rx_queues; i++) {
+		struct igb_ring *rx_ring = &adapter->rx_ring[i];
+
+		if (adapter->rx_ps_hdr_size && !rx_ring->page_pool) {
+			rx_ring->page_pool =
+				vmklnx_page_pool_create(adapter->pdev,
+				                        2 * rx_ring->count,
+				                        IGB_RX_PS_BUFSZ);
+		} else if (!adapter->rx_ps_hdr_size && rx_ring->page_pool) {
+			vmklnx_page_pool_destroy(rx_ring->page_pool);
+			rx_ring->page_pool = NULL;
+		}
+	}
+#endif
+
 	E1000_WRITE_REG(hw, E1000_RCTL, rctl);
 }
 
@@ -1988,6 +2031,7 @@ static void igb_configure_rx(struct igb_adapter *adapter)
 	struct e1000_hw *hw = &adapter->hw;
 	u32 rctl, rxcsum;
 	u32 rxdctl;
+	bool rss = (adapter->num_rx_queues > 1);
 	int i;
 
 	/* disable receives while setting up the descriptors */
@@ -2036,7 +2080,7 @@ static void igb_configure_rx(struct igb_adapter *adapter)
 
 	}
 
-	if (adapter->num_rx_queues > 1) {
+	if (rss) {
 		u32 random[10];
 		u32 mrqc;
 		u32 j, shift;
@@ -2076,6 +2120,10 @@ static void igb_configure_rx(struct igb_adapter *adapter)
 		mrqc |=( E1000_MRQC_RSS_FIELD_IPV6_UDP_EX |
 			E1000_MRQC_RSS_FIELD_IPV6_TCP_EX);
 
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+		/* restored once the last netqueue is freed */
+		adapter->rss_mrqc = mrqc;
+#endif
 
 		E1000_WRITE_REG(hw, E1000_MRQC, mrqc);
 
@@ -2102,6 +2150,11 @@ static void igb_configure_rx(struct igb_adapter *adapter)
 		E1000_WRITE_REG(hw, E1000_RXCSUM, rxcsum);
 	}
 
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	if (adapter->flags & IGB_FLAG_VMDQ_ENABLED)
+		igb_configure_vmdq(adapter);
+#endif
+
 	if (adapter->vlgrp)
 		E1000_WRITE_REG(hw, E1000_RLPML,
 		                adapter->max_frame_size + VLAN_TAG_SIZE);
@@ -2230,6 +2283,11 @@ void igb_free_rx_resources(struct igb_ring *rx_ring)
 
 	igb_clean_rx_ring(rx_ring);
 
+#if defined(__VMKLNX__)
+	vmklnx_page_pool_destroy(rx_ring->page_pool);
+	rx_ring->page_pool = NULL;
+#endif
+
 	vfree(rx_ring->buffer_info);
 	rx_ring->buffer_info = NULL;
 
@@ -2295,9 +2353,20 @@ static void igb_clean_rx_ring(struct igb_ring *rx_ring)
 			buffer_info->skb = NULL;
 		}
 		if (buffer_info->page) {
-			pci_unmap_page(pdev, buffer_info->page_dma,
-			               PAGE_SIZE, PCI_DMA_FROMDEVICE);
-			put_page(buffer_info->page);
+#if defined(__VMKLNX__)
+			if (vmklnx_page_pool_owns(rx_ring->page_pool,
+			                          buffer_info->page))
+				vmklnx_page_pool_free(rx_ring->page_pool,
+				                      buffer_info->page,
+				                      buffer_info->page_offset);
+			else
+#endif
+			{
+				pci_unmap_page(pdev, buffer_info->page_dma,
+				               IGB_RX_PS_BUFSZ,
+				               PCI_DMA_FROMDEVICE);
+				put_page(buffer_info->page);
+			}
 			buffer_info->page = NULL;
 			buffer_info->page_dma = 0;
 		}
@@ -2356,6 +2425,11 @@ static int igb_set_mac(struct net_device *netdev, void *p)
 	memcpy(hw->mac.addr, addr->sa_data, netdev->addr_len);
 
 	e1000_rar_set(hw, hw->mac.addr, 0);
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	/* 82576 only accepts the address for the pools named in RAH */
+	if (adapter->flags & IGB_FLAG_VMDQ_ENABLED)
+		igb_rar_set_qsel(adapter, hw->mac.addr, 0, 0);
+#endif
 
 	return 0;
 }
@@ -2378,8 +2452,17 @@ static void igb_set_multi(struct net_device *netdev)
 	struct dev_mc_list *mc_ptr;
 	u8  *mta_list;
 	u32 rctl;
+	u32 rar_used_count = 1;
 	int i;
 
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	/* RAR[1..num_rx_queues-1] hold the netqueue filters */
+	if (adapter->flags & IGB_FLAG_VMDQ_ENABLED) {
+		rar_used_count = adapter->num_rx_queues;
+		igb_vmdq_set_vmolr(adapter);
+	}
+#endif
+
 	/* Check for Promiscuous and All Multicast modes */
 
 	rctl = E1000_READ_REG(hw, E1000_RCTL);
@@ -2396,7 +2479,7 @@ static void igb_set_multi(struct net_device *netdev)
 
 	if (!netdev->mc_count) {
 		/* nothing to program, so clear mc list */
-		e1000_update_mc_addr_list(hw, NULL, 0, 1,
+		e1000_update_mc_addr_list(hw, NULL, 0, rar_used_count,
 		                          mac->rar_entry_count);
 		return;
 	}
@@ -2414,7 +2497,8 @@ static void igb_set_multi(struct net_device *netdev)
 		memcpy(mta_list + (i*ETH_ALEN), mc_ptr->dmi_addr, ETH_ALEN);
 		mc_ptr = mc_ptr->next;
 	}
-	e1000_update_mc_addr_list(hw, mta_list, i, 1, mac->rar_entry_count);
+	e1000_update_mc_addr_list(hw, mta_list, i, rar_used_count,
+	                          mac->rar_entry_count);
 	kfree(mta_list);
 }
 
@@ -4036,6 +4120,12 @@ static void igb_receive_skb(struct igb_ring *ring, u8 status,
 	struct igb_adapter * adapter = ring->adapter;
 	bool vlan_extracted = (adapter->vlgrp && (status & E1000_RXD_STAT_VP));
 
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	/* until a netqueue is handed out, RSS spreads the default queue */
+	vmknetddi_queueops_set_skb_queueid(skb,
+	                VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID(ring->allocated ?
+	                                                 ring->queue_index : 0));
+#endif
 #ifdef IGB_LRO
 	if (adapter->netdev->features & NETIF_F_LRO &&
 	    skb->ip_summed == CHECKSUM_UNNECESSARY) {
@@ -4153,11 +4243,16 @@ static bool igb_clean_rx_irq_adv(struct igb_ring *rx_ring,
 		}
 
 		while (length) {
+#if defined(__VMKLNX__)
+			/* pool pages stay mapped until they are recycled */
+			if (!vmklnx_page_pool_owns(rx_ring->page_pool,
+			                           buffer_info->page))
+#endif
 			pci_unmap_page(pdev, buffer_info->page_dma,
-				PAGE_SIZE, PCI_DMA_FROMDEVICE);
+				IGB_RX_PS_BUFSZ, PCI_DMA_FROMDEVICE);
 			buffer_info->page_dma = 0;
 			skb_fill_page_desc(skb, j, buffer_info->page,
-						0, length);
+						buffer_info->page_offset, length);
 			buffer_info->page = NULL;
 
 			skb->len += length;
@@ -4271,16 +4366,29 @@ static void igb_alloc_rx_buffers_adv(struct igb_ring *rx_ring,
 		rx_desc = E1000_RX_DESC_ADV(*rx_ring, i);
 
 		if (adapter->rx_ps_hdr_size && !buffer_info->page) {
+#if defined(__VMKLNX__)
+			dma_addr_t page_dma;
+
+			buffer_info->page =
+				vmklnx_page_pool_alloc(rx_ring->page_pool,
+				                       &buffer_info->page_offset,
+				                       &page_dma);
+			buffer_info->page_dma = page_dma;
+			if (!buffer_info->page)
+#endif
+			{
 			buffer_info->page = alloc_page(GFP_ATOMIC);
 			if (!buffer_info->page) {
 				adapter->alloc_rx_buff_failed++;
 				goto no_buffers;
 			}
+			buffer_info->page_offset = 0;
 			buffer_info->page_dma =
 				pci_map_page(pdev,
 				             buffer_info->page,
-				             0, PAGE_SIZE,
+				             0, IGB_RX_PS_BUFSZ,
 				             PCI_DMA_FROMDEVICE);
+			}
 		}
 
 		if (!buffer_info->skb) {
@@ -4468,6 +4576,12 @@ static void igb_vlan_rx_register(struct net_device *netdev,
 		                adapter->max_frame_size);
 	}
 
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	/* 82576 pools strip tags per VMOLR rather than per CTRL.VME */
+	if (adapter->flags & IGB_FLAG_VMDQ_ENABLED)
+		igb_vmdq_set_vmolr(adapter);
+#endif
+
 	if (!test_bit(__IGB_DOWN, &adapter->state))
 		igb_irq_enable(adapter);
 }
@@ -4493,6 +4607,10 @@ static void igb_vlan_rx_add_vid(struct net_device *netdev, u16 vid)
 	vfta = E1000_READ_REG_ARRAY(hw, E1000_VFTA, index);
 	vfta |= (1 << (vid & 0x1F));
 	e1000_write_vfta(hw, index, vfta);
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	if (adapter->flags & IGB_FLAG_VMDQ_ENABLED)
+		igb_vmdq_set_vlvf(adapter, vid, TRUE);
+#endif
 	/* Copy feature flags from netdev to the vlan netdev for this vid.
 	 * This allows things like TSO to bubble down to our vlan device.
 	 */
@@ -4531,6 +4649,10 @@ static void igb_vlan_rx_kill_vid(struct net_device *netdev, u16 vid)
 	vfta = E1000_READ_REG_ARRAY(hw, E1000_VFTA, index);
 	vfta &= ~(1 << (vid & 0x1F));
 	e1000_write_vfta(hw, index, vfta);
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+	if (adapter->flags & IGB_FLAG_VMDQ_ENABLED)
+		igb_vmdq_set_vlvf(adapter, vid, FALSE);
+#endif
 }
 
 static void igb_restore_vlan(struct igb_adapter *adapter)
@@ -4853,6 +4975,432 @@ static void igb_io_resume(struct pci_dev *pdev)
 }
 #endif /* HAVE_PCI_ERS */
 
+#if defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__)
+/**
+ * igb_rar_set_qsel - program a receive address steered to one rx queue
+ * @adapter: board private structure
+ * @addr: unicast address, or NULL to clear the entry
+ * @index: receive address register to use
+ * @queue: rx queue that should receive frames for @addr
+ *
+ * 82575 takes the queue number in the RAH pool field, 82576 takes a
+ * pool bitmap where pool n feeds queue n.
+ **/
+static void igb_rar_set_qsel(struct igb_adapter *adapter, u8 *addr,
+                             u32 index, u32 queue)
+{
+	struct e1000_hw *hw = &adapter->hw;
+	u32 rar_low = 0, rar_high = 0;
+
+	if (addr) {
+		rar_low = ((u32) addr[0] | ((u32) addr[1] << 8) |
+		           ((u32) addr[2] << 16) | ((u32) addr[3] << 24));
+		rar_high = ((u32) addr[4] | ((u32) addr[5] << 8));
+		rar_high |= E1000_RAH_AV;
+		if (hw->mac.type == e1000_82575)
+			rar_high |= E1000_RAH_POOL_1 * queue;
+		else
+			rar_high |= E1000_RAH_POOL_1 << queue;
+	}
+
+	E1000_WRITE_REG(hw, E1000_RAL(index), rar_low);
+	E1000_WRITE_FLUSH(hw);
+	E1000_WRITE_REG(hw, E1000_RAH(index), rar_high);
+	E1000_WRITE_FLUSH(hw);
+}
+
+/**
+ * igb_vmdq_set_vmolr - per pool receive options for 82576 VMDq
+ * @adapter: board private structure
+ *
+ * Only the default pool takes broadcast and multicast; the netqueue
+ * pools see nothing but unicast for their filter address.
+ **/
+static void igb_vmdq_set_vmolr(struct igb_adapter *adapter)
+{
+	struct e1000_hw *hw = &adapter->hw;
+	u32 vmolr;
+	int i;
+
+	/* 82575 has no per pool offload registers */
+	if (hw->mac.type != e1000_82576)
+		return;
+
+	for (i = 0; i < adapter->num_rx_queues; i++) {
+		vmolr = E1000_VMOLR_AUPE | E1000_VMOLR_LPE;
+		vmolr |= (adapter->max_frame_size + VLAN_TAG_SIZE) &
+		         E1000_VMOLR_RLPML_MASK;
+		if (adapter->vlgrp)
+			vmolr |= E1000_VMOLR_STRVLAN;
+		if (i == 0) {
+			vmolr |= E1000_VMOLR_BAM | E1000_VMOLR_ROMPE;
+			if (adapter->netdev->flags & (IFF_PROMISC | IFF_ALLMULTI))
+				vmolr |= E1000_VMOLR_MPME;
+		}
+		E1000_WRITE_REG(hw, E1000_VMOLR(i), vmolr);
+	}
+}
+
+/**
+ * igb_vmdq_set_vlvf - add or remove a vlan from every 82576 pool
+ * @adapter: board private structure
+ * @vid: vlan id
+ * @add: TRUE to add membership, FALSE to drop it
+ *
+ * In VMDq mode the 82576 only hands a tagged frame to a pool that is
+ * a member of its vlan, so the netqueue pools join every vlan the
+ * stack registers.  If the VLVF table is full, tagged frames for that
+ * vlan keep arriving on the default queue.
+ **/
+static void igb_vmdq_set_vlvf(struct igb_adapter *adapter, u16 vid, bool add)
+{
+	struct e1000_hw *hw = &adapter->hw;
+	u32 vlvf;
+	int i, free = -1;
+
+	if (hw->mac.type != e1000_82576)
+		return;
+
+	for (i = 0; i < E1000_VLVF_ARRAY_SIZE; i++) {
+		vlvf = E1000_READ_REG_ARRAY(hw, E1000_VLVF, i);
+		if (!(vlvf & E1000_VLVF_VLANID_ENABLE)) {
+			if (free < 0)
+				free = i;
+			continue;
+		}
+		if ((vlvf & E1000_VLVF_VLANID_MASK) == vid)
+			break;
+	}
+
+	if (!add) {
+		if (i < E1000_VLVF_ARRAY_SIZE)
+			E1000_WRITE_REG_ARRAY(hw, E1000_VLVF, i, 0);
+		return;
+	}
+
+	if (i == E1000_VLVF_ARRAY_SIZE) {
+		if (free < 0) {
+			DPRINTK(DRV, WARNING, "VLVF full, vlan %d stays on "
+			        "the default queue\n", vid);
+			return;
+		}
+		i = free;
+	}
+
+	vlvf = E1000_VLVF_VLANID_ENABLE | (vid & E1000_VLVF_VLANID_MASK);
+	vlvf |= (((1 << adapter->num_rx_queues) - 1) <<
+	         E1000_VLVF_POOLSEL_SHIFT) & E1000_VLVF_POOLSEL_MASK;
+	E1000_WRITE_REG_ARRAY(hw, E1000_VLVF, i, vlvf);
+}
+
+/**
+ * igb_vmdq_set_mrqc - pick RSS or VMDq queue selection
+ * @adapter: board private structure
+ *
+ * While no netqueue is allocated every rx queue belongs to the default
+ * queue and RSS spreads flows over them.  MRQC switches to VMDq when
+ * the first netqueue is handed out and back to RSS when the last one
+ * is freed, so the default queue only loses RSS while NetQueue uses
+ * the other rings.
+ **/
+static void igb_vmdq_set_mrqc(struct igb_adapter *adapter)
+{
+	struct e1000_hw *hw = &adapter->hw;
+
+	if (adapter->n_rx_queues_allocated)
+		E1000_WRITE_REG(hw, E1000_MRQC, E1000_MRQC_ENABLE_VMDQ);
+	else
+		E1000_WRITE_REG(hw, E1000_MRQC, adapter->rss_mrqc);
+	E1000_WRITE_FLUSH(hw);
+}
+
+/**
+ * igb_configure_vmdq - steer rx queues by destination MAC
+ * @adapter: board private structure
+ *
+ * Queue 0 is the default pool.  RAR[n] carries the filter for netqueue
+ * n, so any filter still applied is written back here since the reset
+ * that precedes every igb_configure clears the receive addresses.
+ * RAR[0] is rewritten with the default pool selected, which the reset
+ * leaves clear.
+ **/
+static void igb_configure_vmdq(struct igb_adapter *adapter)
+{
+	struct e1000_hw *hw = &adapter->hw;
+	int i;
+
+	E1000_WRITE_REG(hw, E1000_VMD_CTL, E1000_VMD_CTL_DEFAULT_POOL_0);
+	igb_vmdq_set_vmolr(adapter);
+	igb_rar_set_qsel(adapter, hw->mac.addr, 0, 0);
+	igb_vmdq_set_mrqc(adapter);
+
+	for (i = 1; i < adapter->num_rx_queues; i++) {
+		struct igb_ring *ring = &adapter->rx_ring[i];
+
+		igb_rar_set_qsel(adapter, ring->active ? ring->mac_addr : NULL,
+		                 i, i);
+	}
+}
+
+static int igb_get_netqueue_features(vmknetddi_queueop_get_features_args_t *args)
+{
+	args->features = VMKNETDDI_QUEUEOPS_FEATURE_NONE;
+	args->features |= VMKNETDDI_QUEUEOPS_FEATURE_RXQUEUES;
+	return VMKNETDDI_QUEUEOPS_OK;
+}
+
+static int igb_get_queue_count(vmknetddi_queueop_get_queue_count_args_t *args)
+{
+	struct igb_adapter *adapter = netdev_priv(args->netdev);
+
+	if (args->type == VMKNETDDI_QUEUEOPS_QUEUE_TYPE_RX) {
+		args->count = max(adapter->num_rx_queues - 1, 0);
+		return VMKNETDDI_QUEUEOPS_OK;
+	}
+	else if (args->type == VMKNETDDI_QUEUEOPS_QUEUE_TYPE_TX) {
+		/* a single tx ring; only the default queue */
+		args->count = 0;
+		return VMKNETDDI_QUEUEOPS_OK;
+	}
+	else {
+		printk("igb_get_queue_count: invalid queue type\n");
+		return VMKNETDDI_QUEUEOPS_ERR;
+	}
+}
+
+static int igb_get_filter_count(vmknetddi_queueop_get_filter_count_args_t *args)
+{
+	/* one RAR per queue */
+	args->count = 1;
+	return VMKNETDDI_QUEUEOPS_OK;
+}
+
+static int igb_alloc_rx_queue(struct net_device *netdev,
+                              vmknetddi_queueops_queueid_t *p_qid,
+                              struct napi_struct **napi_p)
+{
+	struct igb_adapter *adapter = netdev_priv(netdev);
+	int i;
+
+	if (adapter->n_rx_queues_allocated >= adapter->num_rx_queues - 1)
+		return VMKNETDDI_QUEUEOPS_ERR;
+
+	for (i = 1; i < adapter->num_rx_queues; i++) {
+		struct igb_ring *ring = &adapter->rx_ring[i];
+
+		if (!ring->allocated) {
+			ring->allocated = TRUE;
+			*p_qid = VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID(i);
+			*napi_p = &ring->napi;
+			if (adapter->n_rx_queues_allocated++ == 0)
+				igb_vmdq_set_mrqc(adapter);
+			return VMKNETDDI_QUEUEOPS_OK;
+		}
+	}
+	return VMKNETDDI_QUEUEOPS_ERR;
+}
+
+static int igb_alloc_queue(vmknetddi_queueop_alloc_queue_args_t *args)
+{
+	if (args->type == VMKNETDDI_QUEUEOPS_QUEUE_TYPE_RX) {
+		return igb_alloc_rx_queue(args->netdev, &args->queueid,
+		                          &args->napi);
+	}
+	else {
+		printk("igb_alloc_queue: only rx queues supported\n");
+		return VMKNETDDI_QUEUEOPS_ERR;
+	}
+}
+
+static int igb_free_queue(vmknetddi_queueop_free_queue_args_t *args)
+{
+	struct igb_adapter *adapter = netdev_priv(args->netdev);
+	u16 queue = VMKNETDDI_QUEUEOPS_QUEUEID_VAL(args->queueid);
+	struct igb_ring *ring;
+
+	if (!VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID(args->queueid) ||
+	    queue == 0 || queue >= adapter->num_rx_queues) {
+		printk("igb_free_queue: invalid queue 0x%x\n", args->queueid);
+		return VMKNETDDI_QUEUEOPS_ERR;
+	}
+
+	ring = &adapter->rx_ring[queue];
+	if (!ring->allocated) {
+		printk("igb_free_queue: rx queue not allocated\n");
+		return VMKNETDDI_QUEUEOPS_ERR;
+	}
+
+	if (ring->active) {
+		/* the filter should already be gone; don't leak the RAR */
+		igb_rar_set_qsel(adapter, NULL, queue, queue);
+		ring->active = FALSE;
+	}
+	ring->allocated = FALSE;
+	if (--adapter->n_rx_queues_allocated == 0)
+		igb_vmdq_set_mrqc(adapter);
+	return VMKNETDDI_QUEUEOPS_OK;
+}
+
+static int igb_get_queue_vector(vmknetddi_queueop_get_queue_vector_args_t *args)
+{
+	struct igb_adapter *adapter = netdev_priv(args->netdev);
+	u16 queue = VMKNETDDI_QUEUEOPS_QUEUEID_VAL(args->queueid);
+	int vector = queue;
+
+	if (!VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID(args->queueid) ||
+	    queue >= adapter->num_rx_queues || !adapter->msix_entries)
+		return VMKNETDDI_QUEUEOPS_ERR;
+
+#ifdef CONFIG_IGB_SEPARATE_TX_HANDLER
+	/* tx vectors come first */
+	vector += adapter->num_tx_queues;
+#endif
+	args->vector = adapter->msix_entries[vector].vector;
+	return VMKNETDDI_QUEUEOPS_OK;
+}
+
+static int igb_get_default_queue(vmknetddi_queueop_get_default_queue_args_t *args)
+{
+	struct igb_adapter *adapter = netdev_priv(args->netdev);
+
+	if (args->type == VMKNETDDI_QUEUEOPS_QUEUE_TYPE_RX) {
+		args->napi = &adapter->rx_ring[0].napi;
+		args->queueid = VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID(0);
+		return VMKNETDDI_QUEUEOPS_OK;
+	}
+	else if (args->type == VMKNETDDI_QUEUEOPS_QUEUE_TYPE_TX) {
+		args->queueid = VMKNETDDI_QUEUEOPS_MK_TX_QUEUEID(0);
+		args->queue_mapping = 0;
+		return VMKNETDDI_QUEUEOPS_OK;
+	}
+	else {
+		return VMKNETDDI_QUEUEOPS_ERR;
+	}
+}
+
+static int igb_apply_rx_filter(vmknetddi_queueop_apply_rx_filter_args_t *args)
+{
+	struct igb_adapter *adapter = netdev_priv(args->netdev);
+	u16 queue = VMKNETDDI_QUEUEOPS_QUEUEID_VAL(args->queueid);
+	struct igb_ring *ring;
+	u8 *macaddr;
+
+	if (!VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID(args->queueid) ||
+	    queue == 0 || queue >= adapter->num_rx_queues) {
+		printk("igb_apply_rx_filter: invalid rx queue 0x%x\n",
+		       args->queueid);
+		return VMKNETDDI_QUEUEOPS_ERR;
+	}
+
+	if (vmknetddi_queueops_get_filter_class(&args->filter)
+					!= VMKNETDDI_QUEUEOPS_FILTER_MACADDR) {
+		printk("igb_apply_rx_filter: only mac filters supported\n");
+		return VMKNETDDI_QUEUEOPS_ERR;
+	}
+
+	ring = &adapter->rx_ring[queue];
+	if (!ring->allocated || ring->active)
+		return VMKNETDDI_QUEUEOPS_ERR;
+
+	macaddr = vmknetddi_queueops_get_filter_macaddr(&args->filter);
+	if (!is_valid_ether_addr(macaddr))
+		return VMKNETDDI_QUEUEOPS_ERR;
+
+	memcpy(ring->mac_addr, macaddr, ETH_ALEN);
+	igb_rar_set_qsel(adapter, ring->mac_addr, queue, queue);
+	ring->active = TRUE;
+
+	/* We only support one filter per queue - hard code
+	 * filter id to zero index
+	 */
+	args->filterid = VMKNETDDI_QUEUEOPS_MK_FILTERID(0);
+	return VMKNETDDI_QUEUEOPS_OK;
+}
+
+static int igb_remove_rx_filter(vmknetddi_queueop_remove_rx_filter_args_t *args)
+{
+	struct igb_adapter *adapter = netdev_priv(args->netdev);
+	u16 queue = VMKNETDDI_QUEUEOPS_QUEUEID_VAL(args->queueid);
+	u16 fidx = VMKNETDDI_QUEUEOPS_FILTERID_VAL(args->filterid);
+	struct igb_ring *ring;
+
+	if (!VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID(args->queueid) ||
+	    queue == 0 || queue >= adapter->num_rx_queues || fidx != 0)
+		return VMKNETDDI_QUEUEOPS_ERR;
+
+	ring = &adapter->rx_ring[queue];
+	if (!ring->active)
+		return VMKNETDDI_QUEUEOPS_ERR;
+
+	igb_rar_set_qsel(adapter, NULL, queue, queue);
+	ring->active = FALSE;
+	return VMKNETDDI_QUEUEOPS_OK;
+}
+
+static int igb_get_queue_stats(vmknetddi_queueop_get_stats_args_t *args)
+{
+	return VMKNETDDI_QUEUEOPS_ERR;
+}
+
+static int igb_get_netqueue_version(vmknetddi_queueop_get_version_args_t *args)
+{
+	return vmknetddi_queueops_version(args);
+}
+
+static int igb_netqueue_ops(vmknetddi_queueops_op_t op, void *args)
+{
+	switch (op) {
+	case VMKNETDDI_QUEUEOPS_OP_GET_VERSION:
+		return igb_get_netqueue_version(
+			(vmknetddi_queueop_get_version_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_GET_FEATURES:
+		return igb_get_netqueue_features(
+			(vmknetddi_queueop_get_features_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_GET_QUEUE_COUNT:
+		return igb_get_queue_count(
+			(vmknetddi_queueop_get_queue_count_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_GET_FILTER_COUNT:
+		return igb_get_filter_count(
+			(vmknetddi_queueop_get_filter_count_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_ALLOC_QUEUE:
+		return igb_alloc_queue(
+			(vmknetddi_queueop_alloc_queue_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_FREE_QUEUE:
+		return igb_free_queue(
+			(vmknetddi_queueop_free_queue_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_GET_QUEUE_VECTOR:
+		return igb_get_queue_vector(
+			(vmknetddi_queueop_get_queue_vector_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_GET_DEFAULT_QUEUE:
+		return igb_get_default_queue(
+			(vmknetddi_queueop_get_default_queue_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_APPLY_RX_FILTER:
+		return igb_apply_rx_filter(
+			(vmknetddi_queueop_apply_rx_filter_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_REMOVE_RX_FILTER:
+		return igb_remove_rx_filter(
+			(vmknetddi_queueop_remove_rx_filter_args_t *)args);
+
+	case VMKNETDDI_QUEUEOPS_OP_GET_STATS:
+		return igb_get_queue_stats(
+			(vmknetddi_queueop_get_stats_args_t *)args);
+
+	default:
+		printk("Unhandled NETQUEUE OP %d\n", op);
+		return VMKNETDDI_QUEUEOPS_ERR;
+	}
+}
+#endif /* defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__) */
+
 
 s32 e1000_alloc_zeroed_dev_spec_struct(struct e1000_hw *hw, u32 size)
 {
@@ -231,6 +231,9 @@ struct ixgbe_ring {
 	u8 active;
 	u8 allocated;
 #endif /* defined(__VMKLNX__) && defined(__VMKNETDDI_QUEUEOPS__) */
+#if defined(__VMKLNX__)
+	struct vmklnx_page_pool *page_pool; /* premapped packet split pages */
+#endif
 };
 
 #define RING_F_VMDQ 1
@@ -271,6 +274,9 @@ struct ixgbe_q_vector {
 	u8 tx_itr;
 	u8 rx_itr;
 	u32 eitr;
+#if defined(__VMKLNX__)
+	struct vmklnx_itr itr;
+#endif
 };
 
 /* Helper macros to switch between ints/sec and what the register uses.
@@ -330,6 +336,9 @@ struct ixgbe_adapter {
 	u32 itr_setting;
 	u16 eitr_low;
 	u16 eitr_high;
+#if defined(__VMKLNX__)
+	struct vmklnx_itr_profile itr_profile;
+#endif
 	
 	/* TX */
 	struct ixgbe_ring *tx_ring;	/* One per active queue */
@@ -467,6 +476,9 @@ extern int ixgbe_setup_rx_resources(struct ixgbe_adapter *adapter,
 extern int ixgbe_setup_tx_resources(struct ixgbe_adapter *adapter,
                                     struct ixgbe_ring *txdr);
 extern void ixgbe_update_stats(struct ixgbe_adapter *adapter);
+#if defined(__VMKLNX__)
+extern void ixgbe_set_itr_profile(struct ixgbe_adapter *adapter);
+#endif
 
 #ifdef ETHTOOL_OPS_COMPAT
 extern int ethtool_ioctl(struct ifreq *ifr);
@@ -1826,6 +1826,10 @@ static int ixgbe_set_coalesce(struct net_device *netdev,
 		IXGBE_WRITE_REG(hw, IXGBE_EITR(0),
 		            EITR_INTS_PER_SEC_TO_REG(adapter->eitr_param));
 	}
+#if defined(__VMKLNX__)
+	/* pick up new eitr_low/eitr_high thresholds for dynamic mode */
+	ixgbe_set_itr_profile(adapter);
+#endif
 
 	/* if some error return -EINVAL */
 	return 0;
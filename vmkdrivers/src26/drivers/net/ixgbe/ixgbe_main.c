@@ -538,6 +538,14 @@ static void ixgbe_alloc_rx_buffers(struct ixgbe_adapter *adapter,
 		rx_desc = IXGBE_RX_DESC_ADV(*rx_ring, i);
 
 		if (!bi->page && (adapter->flags & IXGBE_FLAG_RX_PS_ENABLED)) {
+#if defined(__VMKLNX__)
+			unsigned int offset;
+
+			bi->page = vmklnx_page_pool_alloc(rx_ring->page_pool,
+			                                  &offset, &bi->page_dma);
+			if (!bi->page)
+#endif
+			{
 			bi->page = alloc_page(GFP_ATOMIC);
 			if (!bi->page) {
 				adapter->alloc_rx_page_failed++;
@@ -546,6 +554,7 @@ static void ixgbe_alloc_rx_buffers(struct ixgbe_adapter *adapter,
 			bi->page_dma = pci_map_page(pdev, bi->page, 0,
 			                            PAGE_SIZE,
 			                            PCI_DMA_FROMDEVICE);
+			}
 		}
 
 		if (!bi->skb) {
@@ -1074,6 +1083,11 @@ static bool ixgbe_clean_rx_irq(struct ixgbe_adapter *adapter,
 		}
 
 		if (upper_len) {
+#if defined(__VMKLNX__)
+			/* pool pages stay mapped until they are recycled */
+			if (!vmklnx_page_pool_owns(rx_ring->page_pool,
+			                           rx_buffer_info->page))
+#endif
 			pci_unmap_page(pdev, rx_buffer_info->page_dma,
 			               PAGE_SIZE, PCI_DMA_FROMDEVICE);
 			rx_buffer_info->page_dma = 0;
@@ -1177,6 +1191,9 @@ next_desc:
 #ifdef CONFIG_IXGBE_NAPI
 static int ixgbe_clean_rxonly(struct napi_struct *, int);
 #endif
+#if defined(__VMKLNX__)
+static void ixgbe_write_eitr(void *data, u32 usecs);
+#endif
 /**
  * ixgbe_configure_msix - Configure MSI-X hardware
  * @adapter: board private structure
@@ -1228,6 +1245,10 @@ static void ixgbe_configure_msix(struct ixgbe_adapter *adapter)
 
 		IXGBE_WRITE_REG(&adapter->hw, IXGBE_EITR(v_idx),
 		                EITR_INTS_PER_SEC_TO_REG(q_vector->eitr));
+#if defined(__VMKLNX__)
+		vmklnx_itr_init(&q_vector->itr, &adapter->itr_profile,
+		                q_vector->eitr, ixgbe_write_eitr, q_vector);
+#endif
 	}
 
 	ixgbe_set_ivar(adapter, IXGBE_IVAR_OTHER_CAUSES_INDEX, v_idx);
@@ -1242,6 +1263,7 @@ static void ixgbe_configure_msix(struct ixgbe_adapter *adapter)
 	IXGBE_WRITE_REG(&adapter->hw, IXGBE_EIAC, mask);
 }
 
+#if !defined(__VMKLNX__)
 enum latency_range {
 	lowest_latency = 0,
 	low_latency = 1,
@@ -1312,7 +1334,57 @@ static u8 ixgbe_update_itr(struct ixgbe_adapter *adapter,
 update_itr_done:
 	return retval;
 }
+#endif /* !defined(__VMKLNX__) */
+
+#if defined(__VMKLNX__)
+/**
+ * ixgbe_write_eitr - program the rate picked by the moderation engine
+ * @data: the q_vector whose EITR is written
+ * @usecs: new interrupt interval
+ **/
+static void ixgbe_write_eitr(void *data, u32 usecs)
+{
+	struct ixgbe_q_vector *q_vector = data;
+	struct ixgbe_adapter *adapter = q_vector->adapter;
+	int v_idx = q_vector - adapter->q_vector;
+	u32 itr_reg;
+
+	q_vector->eitr = q_vector->itr.rate;
+	itr_reg = EITR_INTS_PER_SEC_TO_REG(q_vector->eitr);
+	/* must write high and low 16 bits to reset counter */
+	DPRINTK(TX_ERR, DEBUG, "writing eitr(%d): %08X (%u usecs)\n",
+	        v_idx, itr_reg, usecs);
+	IXGBE_WRITE_REG(&adapter->hw, IXGBE_EITR(v_idx),
+	                itr_reg | (itr_reg)<<16);
+}
 
+static void ixgbe_set_itr_msix(struct ixgbe_q_vector *q_vector)
+{
+	struct ixgbe_adapter *adapter = q_vector->adapter;
+	int i, r_idx;
+	struct ixgbe_ring *rx_ring, *tx_ring;
+
+	r_idx = find_first_bit(q_vector->txr_idx, adapter->num_tx_queues);
+	for (i = 0; i < q_vector->txr_count; i++) {
+		tx_ring = &(adapter->tx_ring[r_idx]);
+		vmklnx_itr_add(&q_vector->itr, VMKLNX_ITR_TX,
+		               tx_ring->total_packets, tx_ring->total_bytes);
+		r_idx = find_next_bit(q_vector->txr_idx, adapter->num_tx_queues,
+		                      r_idx + 1);
+	}
+
+	r_idx = find_first_bit(q_vector->rxr_idx, adapter->num_rx_queues);
+	for (i = 0; i < q_vector->rxr_count; i++) {
+		rx_ring = &(adapter->rx_ring[r_idx]);
+		vmklnx_itr_add(&q_vector->itr, VMKLNX_ITR_RX,
+		               rx_ring->total_packets, rx_ring->total_bytes);
+		r_idx = find_next_bit(q_vector->rxr_idx, adapter->num_rx_queues,
+		                      r_idx + 1);
+	}
+
+	vmklnx_itr_update(&q_vector->itr);
+}
+#else /* !defined(__VMKLNX__) */
 static void ixgbe_set_itr_msix(struct ixgbe_q_vector *q_vector)
 {
 	struct ixgbe_adapter *adapter = q_vector->adapter;
@@ -1382,6 +1454,7 @@ static void ixgbe_set_itr_msix(struct ixgbe_q_vector *q_vector)
 
 	return;
 }
+#endif /* defined(__VMKLNX__) */
 
 static void ixgbe_check_fan_failure(struct ixgbe_adapter *adapter, u32 eicr)
 {
@@ -1796,6 +1869,20 @@ out:
 	return err;
 }
 
+#if defined(__VMKLNX__)
+static void ixgbe_set_itr(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_q_vector *q_vector = adapter->q_vector;
+	struct ixgbe_ring *rx_ring = &adapter->rx_ring[0];
+	struct ixgbe_ring *tx_ring = &adapter->tx_ring[0];
+
+	vmklnx_itr_add(&q_vector->itr, VMKLNX_ITR_TX, tx_ring->total_packets,
+	               tx_ring->total_bytes);
+	vmklnx_itr_add(&q_vector->itr, VMKLNX_ITR_RX, rx_ring->total_packets,
+	               rx_ring->total_bytes);
+	vmklnx_itr_update(&q_vector->itr);
+}
+#else /* !defined(__VMKLNX__) */
 static void ixgbe_set_itr(struct ixgbe_adapter *adapter)
 {
 	struct ixgbe_hw *hw = &adapter->hw;
@@ -1843,6 +1930,7 @@ static void ixgbe_set_itr(struct ixgbe_adapter *adapter)
 
 	return;
 }
+#endif /* defined(__VMKLNX__) */
 
 static inline void ixgbe_irq_enable(struct ixgbe_adapter *adapter);
 
@@ -2017,6 +2105,12 @@ static void ixgbe_configure_msi_and_legacy(struct ixgbe_adapter *adapter)
 
 	IXGBE_WRITE_REG(hw, IXGBE_EITR(0),
 	                EITR_INTS_PER_SEC_TO_REG(adapter->eitr_param));
+#if defined(__VMKLNX__)
+	adapter->q_vector[0].eitr = adapter->eitr_param;
+	vmklnx_itr_init(&adapter->q_vector[0].itr, &adapter->itr_profile,
+	                adapter->eitr_param, ixgbe_write_eitr,
+	                &adapter->q_vector[0]);
+#endif
 
 	ixgbe_set_ivar(adapter, IXGBE_IVAR_RX_QUEUE(0), 0);
 	ixgbe_set_ivar(adapter, IXGBE_IVAR_TX_QUEUE(0), 0);
@@ -2188,6 +2282,20 @@ static void ixgbe_configure_rx(struct ixgbe_adapter *adapter)
 #if defined(__VMKLNX__)
 		IXGBE_WRITE_REG(&adapter->hw, IXGBE_SRRCTL(i), srrctl);
 #endif /* defined(__VMKLNX__) */
+#endif
+#if defined(__VMKLNX__)
+		/* packet split pages come premapped out of a per ring pool */
+		if ((adapter->flags & IXGBE_FLAG_RX_PS_ENABLED) &&
+		    !adapter->rx_ring[i].page_pool) {
+			adapter->rx_ring[i].page_pool =
+				vmklnx_page_pool_create(adapter->pdev,
+				                        adapter->rx_ring[i].count,
+				                        PAGE_SIZE);
+		} else if (!(adapter->flags & IXGBE_FLAG_RX_PS_ENABLED) &&
+		           adapter->rx_ring[i].page_pool) {
+			vmklnx_page_pool_destroy(adapter->rx_ring[i].page_pool);
+			adapter->rx_ring[i].page_pool = NULL;
+		}
 #endif
 	}
 #ifdef CONFIG_IXGBE_VMDQ
@@ -2747,6 +2855,16 @@ static void ixgbe_clean_rx_ring(struct ixgbe_adapter *adapter,
 		}
 		if (!rx_buffer_info->page)
 			continue;
+#if defined(__VMKLNX__)
+		if (vmklnx_page_pool_owns(rx_ring->page_pool,
+		                          rx_buffer_info->page)) {
+			vmklnx_page_pool_free(rx_ring->page_pool,
+			                      rx_buffer_info->page, 0);
+			rx_buffer_info->page_dma = 0;
+			rx_buffer_info->page = NULL;
+			continue;
+		}
+#endif
 		pci_unmap_page(pdev, rx_buffer_info->page_dma, PAGE_SIZE,
 		               PCI_DMA_FROMDEVICE);
 		rx_buffer_info->page_dma = 0;
@@ -3646,6 +3764,26 @@ err_alloc_queues:
 	return err;
 }
 
+#if defined(__VMKLNX__)
+/**
+ * ixgbe_set_itr_profile - load the adaptive moderation profile
+ * @adapter: board private structure
+ *
+ * The vectors share adapter->itr_profile, so new eitr_low/eitr_high
+ * thresholds apply from the next interrupt on.
+ **/
+void ixgbe_set_itr_profile(struct ixgbe_adapter *adapter)
+{
+	adapter->itr_profile.rate[VMKLNX_ITR_LOWEST_LATENCY] = 100000;
+	adapter->itr_profile.rate[VMKLNX_ITR_LOW_LATENCY] = 20000;
+	adapter->itr_profile.rate[VMKLNX_ITR_BULK] = 8000;
+	adapter->itr_profile.low_bpus = adapter->eitr_low;
+	adapter->itr_profile.high_bpus = adapter->eitr_high;
+	/* do an exponential smoothing */
+	adapter->itr_profile.smooth_pct = 10;
+}
+
+#endif
 /**
  * ixgbe_sw_init - Initialize general software structures (struct ixgbe_adapter)
  * @adapter: board private structure to initialize
@@ -3718,6 +3856,9 @@ static int __devinit ixgbe_sw_init(struct ixgbe_adapter *adapter)
 	/* set defaults for eitr in MegaBytes */
 	adapter->eitr_low = 10;
 	adapter->eitr_high = 20;
+#if defined(__VMKLNX__)
+	ixgbe_set_itr_profile(adapter);
+#endif
 
 	/* enable rx csum by default */
 	adapter->flags |= IXGBE_FLAG_RX_CSUM_ENABLED;
@@ -3924,6 +4065,11 @@ static void ixgbe_free_rx_resources(struct ixgbe_adapter *adapter,
 #endif
 	ixgbe_clean_rx_ring(adapter, rx_ring);
 
+#if defined(__VMKLNX__)
+	vmklnx_page_pool_destroy(rx_ring->page_pool);
+	rx_ring->page_pool = NULL;
+#endif
+
 	vfree(rx_ring->rx_buffer_info);
 	rx_ring->rx_buffer_info = NULL;
 
@@ -4575,8 +4721,34 @@ static void ixgbe_tx_queue(struct ixgbe_adapter *adapter,
 	wmb();
 
 	tx_ring->next_to_use = i;
+#if !defined(__VMKLNX__)
 	writel(i, adapter->hw.hw_addr + tx_ring->tail);
+#endif
+}
+
+#if defined(__VMKLNX__)
+/*
+ * The tail write is deferred while vmklinux tells us more packets of
+ * the same burst are following.  It must be issued for the last packet,
+ * whenever the queue gets stopped and before any error return, or
+ * descriptors could sit unnoticed by the hardware.
+ */
+static inline void ixgbe_tx_kick(struct ixgbe_adapter *adapter,
+                                 struct ixgbe_ring *tx_ring)
+{
+	writel(tx_ring->next_to_use, adapter->hw.hw_addr + tx_ring->tail);
+}
+
+static inline int ixgbe_tx_stopped(struct net_device *netdev,
+                                   struct ixgbe_ring *tx_ring)
+{
+#ifdef CONFIG_NETDEVICES_MULTIQUEUE
+	return __netif_subqueue_stopped(netdev, tx_ring->queue_index);
+#else
+	return netif_queue_stopped(netdev);
+#endif
 }
+#endif /* defined(__VMKLNX__) */
 
 static int __ixgbe_maybe_stop_tx(struct net_device *netdev,
                                  struct ixgbe_ring *tx_ring, int size)
@@ -4626,12 +4798,18 @@ static inline int ixgbe_xmit_frame_common(struct sk_buff *skb, struct net_device
 	u8 hdr_len = 0;
 	int tso;
 	int count = 0;
+#if defined(__VMKLNX__)
+	int xmit_more;
+#endif
 
 #ifdef MAX_SKB_FRAGS
 	unsigned int f;
 #endif
 	tx_ring = &adapter->tx_ring[r_idx];
 
+#if defined(__VMKLNX__)
+	xmit_more = skb_xmit_more(skb);
+#endif
 
 #ifdef NETIF_F_HW_VLAN_TX
 	if (adapter->vlgrp && vlan_tx_tag_present(skb)) {
@@ -4654,6 +4832,9 @@ static inline int ixgbe_xmit_frame_common(struct sk_buff *skb, struct net_device
 
 	if (ixgbe_maybe_stop_tx(netdev, tx_ring, count)) {
 		adapter->tx_busy++;
+#if defined(__VMKLNX__)
+		ixgbe_tx_kick(adapter, tx_ring);
+#endif
 		return NETDEV_TX_BUSY;
 	}
 
@@ -4663,6 +4844,9 @@ static inline int ixgbe_xmit_frame_common(struct sk_buff *skb, struct net_device
 	tso = ixgbe_tso(adapter, tx_ring, skb, tx_flags, &hdr_len);
 	if (tso < 0) {
 		dev_kfree_skb_any(skb);
+#if defined(__VMKLNX__)
+		ixgbe_tx_kick(adapter, tx_ring);
+#endif
 		return NETDEV_TX_OK;
 	}
 
@@ -4680,6 +4864,11 @@ static inline int ixgbe_xmit_frame_common(struct sk_buff *skb, struct net_device
 
 	ixgbe_maybe_stop_tx(netdev, tx_ring, DESC_NEEDED);
 
+#if defined(__VMKLNX__)
+	if (!xmit_more || ixgbe_tx_stopped(netdev, tx_ring))
+		ixgbe_tx_kick(adapter, tx_ring);
+#endif
+
 	return NETDEV_TX_OK;
 }
 
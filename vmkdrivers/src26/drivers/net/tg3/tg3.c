@@ -3455,6 +3455,7 @@ static int tg3_rx(struct tg3 *tp, int budget)
 	u32 sw_idx = tp->rx_rcb_ptr;
 	u16 hw_idx;
 	int received;
+	u32 rx_bytes = 0;
 
 	hw_idx = tp->hw_status->idx[0].rx_producer;
 	/*
@@ -3561,6 +3562,7 @@ static int tg3_rx(struct tg3 *tp, int budget)
 
 		tp->dev->last_rx = jiffies;
 		received++;
+		rx_bytes += len;
 		budget--;
 
 next_pkt:
@@ -3602,6 +3604,9 @@ next_pkt_nopost:
 	}
 	mmiowb();
 
+#if defined(__VMKLNX__)
+	vmklnx_itr_add(&tp->rx_itr, VMKLNX_ITR_RX, received, rx_bytes);
+#endif
 	return received;
 }
 
@@ -3666,6 +3671,10 @@ static int tg3_poll(struct napi_struct *napi, int budget)
 
 		if (likely(!tg3_has_work(tp))) {
 			netif_rx_complete(tp->dev, napi);
+#if defined(__VMKLNX__)
+			if (tp->coal.use_adaptive_rx_coalesce)
+				vmklnx_itr_update(&tp->rx_itr);
+#endif
 			tg3_restart_ints(tp);
 			break;
 		}
@@ -6357,6 +6366,35 @@ static void tg3_set_bdinfo(struct tg3 *tp, u32 bdinfo_addr,
 }
 
 static void __tg3_set_rx_mode(struct net_device *);
+
+#if defined(__VMKLNX__)
+/* Adaptive rx coalescing; rates for the lowest latency, low latency
+ * and bulk classes, and the bytes/usec that separate them.
+ */
+static const struct vmklnx_itr_profile tg3_itr_profile = {
+	.rate		= { 50000, 20000, 8000 },
+	.low_bpus	= 5,
+	.high_bpus	= 20,
+	.smooth_pct	= 25,
+};
+
+static void tg3_set_rx_itr(void *data, u32 usecs)
+{
+	struct tg3 *tp = data;
+	u32 frames = tp->coal.rx_max_coalesced_frames;
+
+	/* Stretch the frame limit along with the timer, or it alone would
+	 * keep the interrupt rate up under bulk traffic.
+	 */
+	if (tp->coal.rx_coalesce_usecs && usecs > tp->coal.rx_coalesce_usecs)
+		frames = min_t(u32, frames * usecs / tp->coal.rx_coalesce_usecs,
+			       MAX_RXMAX_FRAMES);
+
+	tw32(HOSTCC_RXCOL_TICKS, min_t(u32, usecs, MAX_RXCOL_TICKS));
+	tw32(HOSTCC_RXMAX_FRAMES, frames);
+}
+#endif
+
 static void __tg3_set_coalesce(struct tg3 *tp, struct ethtool_coalesce *ec)
 {
 	tw32(HOSTCC_RXCOL_TICKS, ec->rx_coalesce_usecs);
@@ -6377,6 +6415,12 @@ static void __tg3_set_coalesce(struct tg3 *tp, struct ethtool_coalesce *ec)
 
 		tw32(HOSTCC_STAT_COAL_TICKS, val);
 	}
+#if defined(__VMKLNX__)
+	vmklnx_itr_init(&tp->rx_itr, &tg3_itr_profile,
+			ec->rx_coalesce_usecs ?
+			1000000 / ec->rx_coalesce_usecs : 0,
+			tg3_set_rx_itr, tp);
+#endif
 }
 
 /* tp->lock is held. */
@@ -9696,6 +9740,9 @@ static int tg3_set_coalesce(struct net_device *dev, struct ethtool_coalesce *ec)
 	tp->coal.rx_max_coalesced_frames_irq = ec->rx_max_coalesced_frames_irq;
 	tp->coal.tx_max_coalesced_frames_irq = ec->tx_max_coalesced_frames_irq;
 	tp->coal.stats_block_coalesce_usecs = ec->stats_block_coalesce_usecs;
+#if defined(__VMKLNX__)
+	tp->coal.use_adaptive_rx_coalesce = ec->use_adaptive_rx_coalesce;
+#endif
 
 	if (netif_running(dev)) {
 		tg3_full_lock(tp, 0);
@@ -2518,6 +2518,9 @@ struct tg3 {
 #define SST_25VF0X0_PAGE_SIZE		4098
 
 	struct ethtool_coalesce		coal;
+#if defined(__VMKLNX__)
+	struct vmklnx_itr		rx_itr;
+#endif
 };
 
 #endif /* !(_T3_H) */
@@ -2834,7 +2834,11 @@ static int busy_disk(struct aac_dev * dev, int cid)
 			if ((device->channel == CONTAINER_TO_CHANNEL(cid))
 			 && (device->id == CONTAINER_TO_ID(cid))
 			 && (device->lun == CONTAINER_TO_LUN(cid))
+#if defined(__VMKLNX__)
+			&& (atomic_read(&device->device_busy)
+#else
 			&& (device->device_busy
+#endif
 			  || (SHOST_RECOVERY == dev->scsi_host_ptr->shost_state))) {
 				scsi_device_put(device);
 				return 1;
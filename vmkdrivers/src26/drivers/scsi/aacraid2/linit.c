@@ -1213,6 +1213,8 @@ static struct scsi_host_template aac_driver_template = {
 #if defined(__VMKLNX__)
 	.eh_device_reset_handler        = aac_eh_device_reset,
 	.eh_bus_reset_handler           = aac_eh_bus_reset,
+	/* the abort and reset handlers walk sdev->cmd_list */
+	.sdev_cmd_list			= 1,
 #endif /* defined(__VMKLNX__) */
 	.can_queue			= AAC_NUM_IO_FIB,
 	.this_id			= MAXIMUM_NUM_CONTAINERS,
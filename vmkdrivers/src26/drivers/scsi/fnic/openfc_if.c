@@ -136,6 +136,10 @@ static struct scsi_host_template openfc_driver_template = {
 	.sg_tablesize = OPENFC_DFLT_SG_TABLESIZE,
 	.max_sectors = 0xffff,
 	.shost_attrs = openfc_host_attrs,
+#if defined(__VMKLNX__)
+	/* openfc_queuecommand drops the host_lock anyway */
+	.lockless = 1,
+#endif /* __VMKLNX__ */
 };
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2,6,16)
 static struct attribute_group *openfc_groups[] = {
@@ -271,7 +275,8 @@ void openfc_io_compl(struct fc_scsi_pkt *sp)
  * @done:	Callback function to be called when cmd is completed
  *
  * this is the i/o strategy routine, called by the scsi layer
- * this routine is called with holding the host_lock.
+ * this routine is called with holding the host_lock (without it on
+ * ESX, see .lockless).
  */
 static int openfc_queuecommand(struct scsi_cmnd *sc_cmd,
 			       void (*done) (struct scsi_cmnd * sc_cmd))
@@ -347,8 +352,10 @@ static int openfc_queuecommand(struct scsi_cmnd *sc_cmd,
 		goto out;
 	}
 
+#if !defined(__VMKLNX__) /* called without the host_lock, see .lockless */
 	/* after finding target we wil release the lock */
 	spin_unlock_irq(openfcp->host->host_lock);
+#endif /* __VMKLNX__ */
 
 	sp = openfc_alloc_scsi_pkt(openfcp);
 	if (sp == NULL) {
@@ -408,7 +415,9 @@ static int openfc_queuecommand(struct scsi_cmnd *sc_cmd,
 		rc = SCSI_MLQUEUE_HOST_BUSY;
 	}
 busy_lock:
+#if !defined(__VMKLNX__)
 	spin_lock_irq(openfcp->host->host_lock);
+#endif /* __VMKLNX__ */
 out:
 	return rc;
 }
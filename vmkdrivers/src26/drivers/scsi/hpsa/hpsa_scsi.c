@@ -1425,9 +1425,22 @@ hpsa_scatter_gather(struct pci_dev *pdev,
 		use_sg = pci_map_sg(pdev, cmd->request_buffer, cmd->use_sg,
 			cmd->sc_data_direction);
 
+#if defined(__VMKLNX__)
+		/*
+		 * The list is the vmk_SgArray of the IO itself, walk it
+		 * with sg_next() rather than indexing.
+		 */
+		sg_reset(scatter);
+#endif /* defined(__VMKLNX__) */
 		for (nsegs=0; nsegs < use_sg; nsegs++) {
+#if defined(__VMKLNX__)
+			addr64 = (__u64) sg_dma_address(scatter);
+			len  = sg_dma_len(scatter);
+			scatter = sg_next(scatter);
+#else /* !defined(__VMKLNX__) */
 			addr64 = (__u64) sg_dma_address(&scatter[nsegs]);
 			len  = sg_dma_len(&scatter[nsegs]);
+#endif /* defined(__VMKLNX__) */
 			cp->SG[nsegs].Addr.lower =
 			  (__u32) (addr64 & (__u64) 0x00000000FFFFFFFF);
 			cp->SG[nsegs].Addr.upper =
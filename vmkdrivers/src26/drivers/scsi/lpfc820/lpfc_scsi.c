@@ -1956,6 +1956,10 @@ struct scsi_host_template lpfc_template = {
 	.use_clustering		= ENABLE_CLUSTERING,
 	.shost_attrs		= lpfc_hba_attrs,
 	.max_sectors		= 0xFFFF,
+#if defined(__VMKLNX__)
+	/* lpfc_queuecommand only relies on the hba locks */
+	.lockless		= 1,
+#endif /* defined(__VMKLNX__) */
 };
 
 struct scsi_host_template lpfc_vport_template = {
@@ -1976,4 +1980,8 @@ struct scsi_host_template lpfc_vport_template = {
 	.use_clustering		= ENABLE_CLUSTERING,
 	.shost_attrs		= lpfc_vport_attrs,
 	.max_sectors		= 0xFFFF,
+#if defined(__VMKLNX__)
+	/* lpfc_queuecommand only relies on the hba locks */
+	.lockless		= 1,
+#endif /* defined(__VMKLNX__) */
 };
@@ -764,7 +764,7 @@ mptscsih_io_done(MPT_ADAPTER *ioc, MPT_FRAME_HDR *mf, MPT_FRAME_HDR *mr)
                                         ioc->name, sc->serial_number,
                                         sc->device->channel, sc->device->id,
                                         sc->device->lun,
-                                        sc->device->device_busy, sc->cmnd[0]));
+                                        atomic_read(&sc->device->device_busy), sc->cmnd[0]));
 #endif
 
 			if (hd->sel_timeout[pScsiReq->TargetID] < 0xFFFF)
@@ -796,7 +796,7 @@ mptscsih_io_done(MPT_ADAPTER *ioc, MPT_FRAME_HDR *mf, MPT_FRAME_HDR *mr)
                 			ioc->name, sc->serial_number,
 					sc->device->channel, sc->device->id,
 					sc->device->lun,
-					sc->device->device_busy, sc->cmnd[0]));
+					atomic_read(&sc->device->device_busy), sc->cmnd[0]));
 #else
 						sc->result = (DID_BUS_BUSY << 16);
 #endif
@@ -829,7 +829,7 @@ mptscsih_io_done(MPT_ADAPTER *ioc, MPT_FRAME_HDR *mf, MPT_FRAME_HDR *mr)
 				ioc->name, status, sc->result, log_info,
 				sc->serial_number, sc->device->channel,
 				sc->device->id, sc->device->lun,
-				sc->device->device_busy, sc->cmnd[0],
+				atomic_read(&sc->device->device_busy), sc->cmnd[0],
 				vdevice ? vdevice->nexus_loss : 0xFF));
 #endif
 			break;
@@ -1174,7 +1174,7 @@ mptscsih_search_running_cmds(MPT_SCSI_HOST *hd, VirtDevice *vdevice)
                 			ioc->name, sc->serial_number,
 					sc->device->channel, sc->device->id,
 					sc->device->lun,
-					sc->device->device_busy, sc->cmnd[0]));
+					atomic_read(&sc->device->device_busy), sc->cmnd[0]));
 #endif
 			sc->scsi_done(sc);
 			spin_lock_irqsave(&ioc->scsi_lookup_lock, flags);
@@ -237,6 +237,10 @@ struct scsi_host_template qla2x00_driver_template = {
 	 */
 	.max_sectors		= 0xFFFF,
 	.shost_attrs		= qla2x00_host_attrs,
+#if defined(__VMKLNX__)
+	/* the queuecommand routines drop the host_lock anyway */
+	.lockless		= 1,
+#endif /* defined(__VMKLNX__) */
 };
 
 struct scsi_host_template qla24xx_driver_template = {
@@ -266,6 +270,10 @@ struct scsi_host_template qla24xx_driver_template = {
 
 	.max_sectors		= 0xFFFF,
 	.shost_attrs		= qla2x00_host_attrs,
+#if defined(__VMKLNX__)
+	/* the queuecommand routines drop the host_lock anyway */
+	.lockless		= 1,
+#endif /* defined(__VMKLNX__) */
 };
 
 static struct scsi_transport_template *qla2xxx_transport_template = NULL;
@@ -559,7 +567,9 @@ qla2x00_queuecommand(struct scsi_cmnd *cmd, void (*done)(struct scsi_cmnd *))
 		goto qc_host_busy;
 	}
 
+#if !defined(__VMKLNX__) /* called without the host_lock, see .lockless */
 	spin_unlock_irq(ha->host->host_lock);
+#endif
 
 	sp = qla2x00_get_new_sp(ha, fcport, cmd, done);
 	if (!sp)
@@ -569,7 +579,9 @@ qla2x00_queuecommand(struct scsi_cmnd *cmd, void (*done)(struct scsi_cmnd *))
 	if (rval != QLA_SUCCESS)
 		goto qc_host_busy_free_sp;
 
+#if !defined(__VMKLNX__)
 	spin_lock_irq(ha->host->host_lock);
+#endif
 
 	return 0;
 
@@ -578,7 +590,9 @@ qc_host_busy_free_sp:
 	mempool_free(sp, ha->srb_mempool);
 
 qc_host_busy_lock:
+#if !defined(__VMKLNX__)
 	spin_lock_irq(ha->host->host_lock);
+#endif
 
 qc_host_busy:
 	return SCSI_MLQUEUE_HOST_BUSY;
@@ -636,7 +650,9 @@ qla24xx_queuecommand(struct scsi_cmnd *cmd, void (*done)(struct scsi_cmnd *))
 		goto qc24_host_busy;
 	}
 
+#if !defined(__VMKLNX__) /* called without the host_lock, see .lockless */
 	spin_unlock_irq(ha->host->host_lock);
+#endif
 
 	sp = qla2x00_get_new_sp(pha, fcport, cmd, done);
 	if (!sp)
@@ -646,7 +662,9 @@ qla24xx_queuecommand(struct scsi_cmnd *cmd, void (*done)(struct scsi_cmnd *))
 	if (rval != QLA_SUCCESS)
 		goto qc24_host_busy_free_sp;
 
+#if !defined(__VMKLNX__)
 	spin_lock_irq(ha->host->host_lock);
+#endif
 
 	return 0;
 
@@ -655,7 +673,9 @@ qc24_host_busy_free_sp:
 	mempool_free(sp, pha->srb_mempool);
 
 qc24_host_busy_lock:
+#if !defined(__VMKLNX__)
 	spin_lock_irq(ha->host->host_lock);
+#endif
 
 qc24_host_busy:
 	return SCSI_MLQUEUE_HOST_BUSY;
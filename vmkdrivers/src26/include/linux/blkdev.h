@@ -418,6 +418,20 @@ struct request_queue
 	unsigned int		sg_reserved_size;
 	int			node;
 
+#if defined(__VMKLNX__)
+	/*
+	 * vmklinux merge/plug accounting, protected by queue_lock.
+	 * nr_sorted counts the requests still on queue_head.
+	 */
+	unsigned int		nr_pending;	/* queued or owned by the driver */
+	unsigned long		nr_bios;	/* bios handed to the queue */
+	unsigned long		nr_back_merges;
+	unsigned long		nr_front_merges;
+	unsigned long		nr_unplug_idle;
+	unsigned long		nr_unplug_thresh;
+	unsigned long		nr_unplug_done;
+#endif /* defined(__VMKLNX__) */
+
 	struct blk_trace	*blk_trace;
 
 	/*
@@ -11,6 +11,12 @@ extern u32  crc32_le(u32 crc, unsigned char const *p, size_t len);
 extern u32  crc32_be(u32 crc, unsigned char const *p, size_t len);
 extern u32  bitreverse(u32 in);
 
+#if defined(__VMKLNX__)
+extern u32  crc32_le_copy(u32 crc, unsigned char *dst,
+                          unsigned char const *src, size_t len);
+extern void crc32_init(void);
+#endif /* defined(__VMKLNX__) */
+
 #define crc32(seed, data, length)  crc32_le(seed, (unsigned char const *)data, length)
 
 /*
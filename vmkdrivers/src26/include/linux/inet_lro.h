@@ -33,6 +33,7 @@
 #include <net/tcp.h>
 
 #if defined(__VMKLNX__)
+#include <linux/ipv6.h>
 #include "vmkapi.h"
 
 extern unsigned int vmklnxLROEnabled;
@@ -42,10 +43,24 @@ extern unsigned int vmklnxLROEnabled;
  * LRO statistics
  */
 
+#if defined(__VMKLNX__)
+/* log2 buckets of packets per flushed session: 1, 2-3, ..., 128+ */
+#define LRO_AGGR_HIST_BUCKETS 8
+#endif /* defined(__VMKLNX__) */
+
 struct net_lro_stats {
 	unsigned long aggregated;
 	unsigned long flushed;
 	unsigned long no_desc;
+#if defined(__VMKLNX__)
+	unsigned long aggregated_ipv4;	/* per-family split of aggregated */
+	unsigned long aggregated_ipv6;
+	unsigned long aggregated_vlan;	/* aggregated packets with a vlan tag */
+	unsigned long flushed_psh;	/* sessions ended by a PSH segment */
+	unsigned long flushed_budget;	/* ... by max_aggr or max_sess_bytes */
+	unsigned long flushed_idle;	/* ... by the idle deadline */
+	unsigned long aggr_hist[LRO_AGGR_HIST_BUCKETS];
+#endif /* defined(__VMKLNX__) */
 };
 
 /*
@@ -72,6 +87,12 @@ struct net_lro_desc {
 	int vlan_packet;
 	int mss;
 	int active;
+#if defined(__VMKLNX__)
+	struct ipv6hdr *ip6h;		/* set instead of iph for IPv6 sessions */
+	u32 hash;			/* 4-tuple hash of the session */
+	u16 hash_next;			/* index + 1 of next desc in bucket */
+	vmk_TimerCycles last_tc;	/* last segment, LRO_F_DEFERRED_FLUSH */
+#endif /* defined(__VMKLNX__) */
 };
 
 /*
@@ -90,13 +111,18 @@ struct net_lro_mgr {
 #define LRO_F_EXTRACT_VLAN_ID 2  /* Set flag if VLAN IDs are extracted
 				    from received packets and eth protocol
 				    is still ETH_P_8021Q */
+#if defined(__VMKLNX__)
+#define LRO_F_DEFERRED_FLUSH  4  /* Sessions stay open across polls until
+				    flushed by vmklnx_lro_flush_idle() */
+#endif /* defined(__VMKLNX__) */
 
 	u32 ip_summed;      /* Set in non generated SKBs in page mode */
 	u32 ip_summed_aggr; /* Set in aggregated SKBs: CHECKSUM_UNNECESSARY
 			     * or CHECKSUM_NONE */
 
 #if defined(__VMKLNX__)
-#define LRO_DEFAULT_MAX_DESC 8
+#define LRO_DEFAULT_MAX_DESC 32
+#define LRO_HASH_BUCKETS     64 /* Must be a power of 2 */
 #define LRO_DEFAULT_MAX_AGGR VMK_PKT_FRAGS_MAX_LENGTH /* We cannot aggregate more 
                                                        * packets than the number of
                                                        * sg entries */
@@ -109,6 +135,21 @@ struct net_lro_mgr {
 
 	struct net_lro_desc *lro_arr; /* Array of LRO descriptors */
 
+#if defined(__VMKLNX__)
+	/*
+	 * Active descriptors are chained off lro_hash by their 4-tuple
+	 * hash, so lookups don't have to scan lro_arr. Bucket heads and
+	 * chain links hold the descriptor index + 1, 0 being the end.
+	 */
+	u16 lro_hash[LRO_HASH_BUCKETS];
+	int active_cnt;  /* Number of active descriptors */
+	int free_hint;   /* Where to start looking for a free descriptor */
+
+	u32 max_sess_bytes;               /* Flush a session at this size, 0
+					   * for as much as fits an IP packet */
+	vmk_TimerRelCycles flush_idle_tc; /* LRO_F_DEFERRED_FLUSH deadline */
+#endif /* defined(__VMKLNX__) */
+
 	/*
 	 * Optimized driver functions
 	 *
@@ -120,6 +161,9 @@ struct net_lro_mgr {
 	/* hdr_flags: */
 #define LRO_IPV4 1 /* ip_hdr is IPv4 header */
 #define LRO_TCP  2 /* tcpudp_hdr is TCP header */
+#if defined(__VMKLNX__)
+#define LRO_IPV6 4 /* ip_hdr is IPv6 header */
+#endif /* defined(__VMKLNX__) */
 
 	/*
 	 * get_frag_header: returns mac, tcp and ip header for packet in SKB
@@ -207,6 +251,19 @@ void lro_flush_pkt(struct net_lro_mgr *lro_mgr,
 int
 vmklnx_net_lro_get_skb_header(struct sk_buff *skb, void **ip_hdr,
                               void **tcpudp_hdr, u64 *hdr_flags, void *priv);
+
+/*
+ * Drop all descriptor state of lro_mgr without flushing it
+ */
+
+void vmklnx_lro_reset(struct net_lro_mgr *lro_mgr);
+
+/*
+ * Forward the sessions idle for flush_idle_tc to network stack
+ */
+
+vmk_TimerRelCycles vmklnx_lro_flush_idle(struct net_lro_mgr *lro_mgr,
+                                         vmk_TimerCycles now);
 #endif /* defined(__VMKLNX__) */
 
 #endif
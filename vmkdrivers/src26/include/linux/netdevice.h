@@ -280,6 +280,11 @@ struct napi_wdt_priv {
         struct napi_struct     *napi; /* napi context being polled */
 };
 
+struct napi_pool_wdt;
+
+/* log2 buckets of the napi stack push batch size histogram: 1, 2-3, ..., 128+ */
+#define NAPI_PUSH_HIST_BUCKETS  8
+
 struct napi_struct {
         unsigned long           state;
         int                     weight;
@@ -292,6 +297,19 @@ struct napi_struct {
         vmk_PktList             pktList;
         struct napi_wdt_priv    napi_wdt_priv;
         vmk_uint32              vector;
+        vmk_uint32              push_min;      /* pkts needed to push right away */
+        vmk_uint32              push_skip_max; /* polls a short list may be held */
+        vmk_uint32              rx_rate;       /* avg pkts per poll, fixed point */
+        vmk_TimerRelCycles      poll_cycles;   /* avg cost of a poll */
+        vmk_TimerRelCycles      push_cycles;   /* avg cost of a stack push */
+        unsigned long           push_hist[NAPI_PUSH_HIST_BUCKETS];
+        vmk_uint64              polls;         /* driver polls */
+        vmk_uint64              polls_full;    /* polls that used up the weight */
+        vmk_uint64              poll_cycles_total; /* time spent in driver polls */
+        struct napi_pool_wdt    *pool_wdt;     /* device pool worldlet, or NULL */
+        vmknetddi_queueops_queueid_t rx_qid;   /* netqueue of the pkts in pktList */
+        vmk_uint64              rx_bytes;      /* bytes of the pkts in pktList */
+        vmk_Timer               lro_timer;     /* deferred lro flush deadline */
         struct net_lro_mgr      lro_mgr;
         struct net_lro_desc     lro_desc[LRO_DEFAULT_MAX_DESC];
 };
@@ -511,13 +529,111 @@ enum netdev_queue_state_t
         __QUEUE_STATE_SCHED,
 };
 
+/*
+ * Slots of the lock-free tx staging ring of a soft queue, must be a
+ * power of 2.
+ */
+#define NETDEV_TX_STAGE_SLOTS   32
+
+struct netdev_tx_stage_slot {
+        atomic_t                seq;               /* slot sequence number */
+        vmk_PktList             pktList;           /* staged packets */
+};
+
+/*
+ * Lock-free multi-producer staging of tx packets in front of outputList.
+ * Producers claim slots at head without taking queue_lock; the slots are
+ * moved to outputList in order by whoever holds queue_lock, at tail.
+ */
+struct netdev_tx_stage {
+        atomic_t                head;
+        atomic_t                pkts;              /* packets in the ring */
+        unsigned long           owner;             /* drain ownership bit */
+        unsigned int            tail ____cacheline_aligned_in_smp;
+        struct netdev_tx_stage_slot ring[NETDEV_TX_STAGE_SLOTS];
+};
+
 struct netdev_soft_queue {
         spinlock_t		queue_lock;        /* queue lock */
         unsigned int            state;             /* queue state */
         unsigned int            hardState;         /* hard queue state */
         vmk_PktList             outputList;        /* output packet list */
         uint32_t                outputListMaxSize; /* max allowed queue length */
+        struct netdev_tx_stage  *stage;            /* tx staging, or NULL */
+};
+
+#if defined(__VMKLNX__)
+/* why vmklinux dropped a packet on its way to or from a driver */
+enum netdev_drop_reason {
+        NETDEV_DROP_BLOCKED = 0,   /* device or queue blocked */
+        NETDEV_DROP_INVALID,       /* zero length, bad vlan tag, no napi */
+        NETDEV_DROP_NORESOURCE,    /* queue full or stopped, could not map,
+                                    * append or segment it */
+        NETDEV_DROP_REASONS
+};
+
+/*
+ * vmklinux counters of one rx or tx queue as seen by one PCPU. A PCPU
+ * only ever writes its own copy; readers add the copies up.
+ */
+struct netdev_queue_stats {
+        u64 packets;
+        u64 bytes;
+        u64 dropped[NETDEV_DROP_REASONS];
+        u64 batches;            /* rx: stack pushes, tx: driver bursts */
+        u64 batchPkts;          /* packets carried by those batches */
+        u64 requeued;           /* tx: put back after the driver refused */
+};
+
+/*
+ * Rx counters are kept per netqueue id; ids at or beyond this share the
+ * last slot. Tx counters follow, one per struct netdev_queue.
+ */
+#define NETDEV_STATS_RX_QUEUES  16
+
+/*
+ * Per-queue vmklinux counters through the NIC char device. ifr_data
+ * points to a struct netdev_qstats_req; on input nQueues is the room
+ * in queues[], on output the number of entries filled in. Rx queues
+ * come first, in netqueue id order, then the tx queues.
+ */
+#define SIOCGVMKLNXQSTATS       (SIOCPROTOPRIVATE + 0xF)
+
+struct netdev_qstats_entry {
+        u32 type;               /* VMKNETDDI_QUEUEOPS_QUEUE_TYPE_RX/TX */
+        u32 index;              /* netqueue id value or tx queue index */
+        struct netdev_queue_stats stats;
+};
+
+struct netdev_qstats_req {
+        u32 nQueues;
+        u32 pad;
+        struct netdev_qstats_entry queues[0];
+};
+
+/*
+ * Binary export of the driver's ethtool statistics. ifr_data points to a
+ * struct netdev_estats_req; on input nStats is the room in data[], on
+ * output the number of entries filled in. SIOCGVMKLNXESTRINGS fills data[]
+ * with ETH_GSTRING_LEN names, SIOCGVMKLNXESTATS with struct netdev_estat.
+ * generation changes whenever the driver's name table does, so the names
+ * only need to be fetched again when it moves.
+ */
+#define SIOCGVMKLNXESTRINGS     (SIOCPROTOPRIVATE + 0xE)
+#define SIOCGVMKLNXESTATS       (SIOCPROTOPRIVATE + 0xD)
+
+struct netdev_estat {
+        u32 index;              /* into the SIOCGVMKLNXESTRINGS table */
+        u32 pad;
+        u64 value;
+};
+
+struct netdev_estats_req {
+        u32 nStats;
+        u32 generation;
+        u8  data[0];
 };
+#endif /* defined(__VMKLNX__) */
 
 struct netdev_queue {
 	struct net_device	 *dev;
@@ -533,6 +649,7 @@ struct netdev_queue {
 	spinlock_t		 _xmit_lock ____cacheline_aligned_in_smp;
 	int			 xmit_lock_owner;
         unsigned char            processing_tx;
+        struct netdev_bounce_ring *bounce_ring; /* high dma workaround copies, under _xmit_lock */
 
         struct netdev_queue	 *next_sched;
 } ____cacheline_aligned_in_smp;
@@ -703,10 +820,7 @@ struct net_device
 	unsigned long		last_rx;	   /* Time of last Rx	*/
         atomic_t                rxInFlight;        /* keeps track of the rx packet in flight. */
 
-        unsigned long           linnet_rx_packets; /* vmklinux rx packets */
-        unsigned long           linnet_tx_packets; /* vmklinux tx packets */
-        unsigned long           linnet_rx_dropped; /* vmklinux rx dropped */
-        unsigned long           linnet_tx_dropped; /* vmklinux tx dropped */
+        struct netdev_queue_stats **linnet_stats; /* per-PCPU vmklinux queue counters */
         int                     linnet_pkt_completed; /* vmklinux pkt completed */
 #endif /* defined(__VMKLNX__) */
 
@@ -854,6 +968,7 @@ struct net_device
 	unsigned long           watchdog_timeohit_period_start;
 	vmknetddi_queueops_f	netqueue_ops;
         kmem_cache_t           *skb_pool;
+        struct netdev_stats_cache *stats_cache; /* driver stats snapshot for the uplink */
 	int			useDriverNamingDevice;
         spinlock_t              napi_lock;
         struct list_head        napi_list;
@@ -891,6 +1006,65 @@ static inline vmk_Bool vmknetddi_queueops_getset_state(struct net_device *dev, v
 }
 #endif /* defined(__VMKLNX__) */
 
+/*
+ * Adaptive interrupt moderation
+ *
+ * A driver keeps one vmklnx_itr per interrupt vector, feeds it the rx
+ * and tx packets and bytes handled since the last interrupt and calls
+ * vmklnx_itr_update() when its NAPI poll completes.  Rx and tx traffic
+ * are each sorted into one of three classes by their byte rate, and the
+ * vector runs at the rate of the higher class; when that differs from
+ * the current rate the engine moves towards it and hands the new
+ * interval to the driver's callback, which programs the hardware.
+ */
+#if defined(__VMKLNX__)
+enum vmklnx_itr_class {
+        VMKLNX_ITR_LOWEST_LATENCY = 0,
+        VMKLNX_ITR_LOW_LATENCY,
+        VMKLNX_ITR_BULK,
+        VMKLNX_ITR_NUM_CLASSES
+};
+
+enum vmklnx_itr_dir {
+        VMKLNX_ITR_RX = 0,
+        VMKLNX_ITR_TX,
+        VMKLNX_ITR_NUM_DIRS
+};
+
+struct vmklnx_itr_profile {
+        u32     rate[VMKLNX_ITR_NUM_CLASSES];   /* target interrupts/sec */
+        u32     low_bpus;       /* bytes/usec that leave lowest latency */
+        u32     high_bpus;      /* bytes/usec that make traffic bulk */
+        u32     smooth_pct;     /* weight of the target per step, 1-100 */
+};
+
+typedef void (*vmklnx_itr_set_fn)(void *data, u32 usecs);
+
+struct vmklnx_itr {
+        const struct vmklnx_itr_profile *profile;
+        vmklnx_itr_set_fn       set_interval;
+        void                    *data;
+        u32                     packets[VMKLNX_ITR_NUM_DIRS];
+        u32                     bytes[VMKLNX_ITR_NUM_DIRS];
+        u32                     rate;   /* current interrupts/sec */
+        u8                      cls[VMKLNX_ITR_NUM_DIRS]; /* vmklnx_itr_class */
+};
+
+extern void vmklnx_itr_init(struct vmklnx_itr *itr,
+                            const struct vmklnx_itr_profile *profile,
+                            u32 rate, vmklnx_itr_set_fn set_interval,
+                            void *data);
+extern u32 vmklnx_itr_update(struct vmklnx_itr *itr);
+
+static inline void vmklnx_itr_add(struct vmklnx_itr *itr,
+                                  enum vmklnx_itr_dir dir,
+                                  u32 packets, u32 bytes)
+{
+        itr->packets[dir] += packets;
+        itr->bytes[dir] += bytes;
+}
+#endif /* defined(__VMKLNX__) */
+
 #define	NETDEV_ALIGN		32
 #define	NETDEV_ALIGN_CONST	(NETDEV_ALIGN - 1)
 
@@ -2017,32 +2191,7 @@ extern int		netdev_max_backlog;
 extern int		weight_p;
 extern int		netdev_set_master(struct net_device *dev, struct net_device *master);
 extern int skb_checksum_help(struct sk_buff *skb, int inward);
-#if defined(__VMKLNX__)
-/**
- *  skb_gso_segment - non-operational function
- *  @skb: Ignored
- *  @features: Ignored
- *
- *  A non-operational function provided to help reduce
- *  kernel ifdefs. It is not supported in this release of ESX.
- *
- *  ESX Deviation Notes:
- *  A non-operational function provided to help reduce
- *  kernel ifdefs. It is not supported in this release of ESX.
- *
- *  RETURN VALUE:
- *  Returns NULL always.
- *
- */
-/* _VMKLNX_CODECHECK_: skb_gso_segment */
-static inline struct sk_buff *skb_gso_segment(struct sk_buff *skb, int features)
-{
-        /* PR 260085 : Should we expose TSO segmentation functions of vmkernel to vmkapi ? */
-        return NULL;
-}
-#else /* !defined(__VMKLNX__) */
 extern struct sk_buff *skb_gso_segment(struct sk_buff *skb, int features);
-#endif /* defined(__VMKLNX__) */
 #ifdef CONFIG_BUG
 extern void netdev_rx_csum_fault(struct net_device *dev);
 #else
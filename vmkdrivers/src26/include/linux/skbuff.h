@@ -230,6 +230,7 @@ enum {
  *	@ip_summed: Driver fed us an IP checksum
  *      @mhead : Packet flat buffer has been reallocated
  *      @lro_ready : Has the skb already been through lro ?
+ *      @xmit_more : More packets of the same tx burst follow this one
  *	@protocol: Packet protocol from driver
  *	@truesize: Buffer size 
  *	@users: User count - see {datagram,tcp}.c
@@ -291,6 +292,7 @@ struct sk_buff {
 	__u8                         ip_summed;
         __u8                         mhead;
         __u8                         lro_ready;
+        __u8                         xmit_more;
         __be16                       protocol;
 
 	/* These elements must be at the end, see alloc_skb() for details.  */
@@ -520,6 +522,19 @@ extern void kfree_skb(struct sk_buff *skb);
 
 #if defined(__VMKLNX__)
 struct sk_buff *vmklnx_net_alloc_skb(kmem_cache_t *cache, unsigned int size);
+
+/* premapped, recycled rx page buffers; see linux_net.c */
+struct vmklnx_page_pool;
+struct vmklnx_page_pool *vmklnx_page_pool_create(struct pci_dev *pdev,
+                                                 unsigned int nBufs,
+                                                 unsigned int bufSize);
+void vmklnx_page_pool_destroy(struct vmklnx_page_pool *pool);
+struct page *vmklnx_page_pool_alloc(struct vmklnx_page_pool *pool,
+                                    unsigned int *offset, dma_addr_t *dma);
+int vmklnx_page_pool_owns(struct vmklnx_page_pool *pool, struct page *page);
+void vmklnx_page_pool_free(struct vmklnx_page_pool *pool, struct page *page,
+                           unsigned int offset);
+void vmklnx_page_pool_put_frags(struct sk_buff *skb);
 static inline struct sk_buff *__alloc_skb(unsigned int size,
                                           gfp_t priority, int fclone)
 {
@@ -1815,18 +1830,18 @@ extern int	       skb_copy_and_csum_datagram_iovec(struct sk_buff *skb,
 extern void	       skb_free_datagram(struct sock *sk, struct sk_buff *skb);
 extern void	       skb_kill_datagram(struct sock *sk, struct sk_buff *skb,
 					 unsigned int flags);
+#endif /* !defined(__VMKLNX__) */
 extern unsigned int    skb_checksum(const struct sk_buff *skb, int offset,
 				    int len, unsigned int csum);
-#endif /* !defined(__VMKLNX__) */
 extern int	       skb_copy_bits(const struct sk_buff *skb, int offset,
 				     void *to, int len);
-#if !defined(__VMKLNX__)
-extern int	       skb_store_bits(const struct sk_buff *skb, int offset,
-				      void *from, int len);
 extern unsigned int    skb_copy_and_csum_bits(const struct sk_buff *skb,
 					      int offset, u8 *to, int len,
 					      unsigned int csum);
 extern void	       skb_copy_and_csum_dev(const struct sk_buff *skb, u8 *to);
+#if !defined(__VMKLNX__)
+extern int	       skb_store_bits(const struct sk_buff *skb, int offset,
+				      void *from, int len);
 extern void	       skb_split(struct sk_buff *skb,
 				 struct sk_buff *skb1, const u32 len);
 
@@ -2109,5 +2124,27 @@ static inline int skb_is_gso(const struct sk_buff *skb)
 	return skb_shinfo(skb)->gso_size;
 }
 
+#if defined(__VMKLNX__)
+/**
+ *  skb_xmit_more - Are more packets of the same burst about to be sent ?
+ *  @skb: Pointer to socket buffer
+ *
+ *  vmklinux hands packets to hard_start_xmit in bursts while holding the
+ *  device tx lock once. This hint is set on every skb of a burst but the
+ *  last, so a driver may defer its tail/doorbell register write. A driver
+ *  that defers the write must still issue it when the hint is clear, when
+ *  its queue is stopped, and before returning any error status.
+ *
+ *  RETURN VALUE:
+ *    non-zero - more packets follow in this burst
+ *    zero - this is the last packet of the burst
+ */
+/* _VMKLNX_CODECHECK_: skb_xmit_more */
+static inline int skb_xmit_more(const struct sk_buff *skb)
+{
+	return skb->xmit_more;
+}
+#endif /* defined(__VMKLNX__) */
+
 #endif	/* __KERNEL__ */
 #endif	/* _LINUX_SKBUFF_H */
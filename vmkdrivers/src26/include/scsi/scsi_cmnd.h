@@ -118,6 +118,10 @@ struct scsi_cmnd {
 	unsigned long pid;	/* Process ID, starts at 0. Unique per host. */
 #if defined(__VMKLNX__)
 	struct list_head bhlist;  /* scsi_cmnd for vmklnx bh processing */
+	struct scsi_cmnd *bhnext; /* next in the bh inbox of another PCPU */
+	int submit_pcpu;          /* PCPU the command was issued from */
+	struct list_head active_entry; /* entry on the host's per-PCPU active list */
+	int alloc_pcpu;           /* PCPU whose active list holds the command */
         spinlock_t vmklock;
    	int vmkflags;                  /* vmware flags protected by vmk_lock */
    	struct vmk_ScsiCommand	*vmkCmdPtr;
@@ -230,6 +234,54 @@ static inline void scsi_set_resid(struct scsi_cmnd *cmd, int resid)
 #if defined(__VMKLNX__)
 #include <linux/scatterlist.h>
 
+/**
+ *  scsi_sglist_first - returns the first element of a command's SG list
+ *  @cmd: a pointer to struct scsi_cmnd
+ *
+ *  Returns the SG list of @cmd positioned on its first element.
+ *
+ *  ESX Deviation Notes:
+ *  For an SG_VMK list the returned scatterlist is a cursor over the
+ *  vmk_SgElem array of the IO, which is rewound here.
+ *
+ *  RETURN VALUE:
+ *  Returns a pointer to the first struct scatterlist of @cmd, or NULL if
+ *  @cmd has no SG list.
+ *
+ */
+/* _VMKLNX_CODECHECK_: scsi_sglist_first */
+static inline struct scatterlist *scsi_sglist_first(struct scsi_cmnd *cmd)
+{
+	struct scatterlist *sg = scsi_sglist(cmd);
+
+	if (sg != NULL && cmd->use_sg) {
+		sg_reset(sg);
+	}
+	return sg;
+}
+
+/**
+ *  scsi_for_each_sg - iterate over the SG list of a command
+ *  @cmd: a pointer to struct scsi_cmnd
+ *  @sg: struct scatterlist pointer used as the loop cursor
+ *  @nseg: number of SG elements to walk
+ *  @__i: int used as the loop counter
+ *
+ *  Walks the first @nseg elements of the SG list of @cmd, typically the
+ *  count returned by pci_map_sg() or dma_map_sg().
+ *
+ *  ESX Deviation Notes:
+ *  Handles both SG_LINUX and SG_VMK types of SG list. For SG_VMK, @sg
+ *  stays on the scatterlist embedded in @cmd and only its cursor moves,
+ *  so use sg_dma_address() and sg_dma_len() on @sg inside the loop and
+ *  do not keep @sg across iterations.
+ *
+ */
+/* _VMKLNX_CODECHECK_: scsi_for_each_sg */
+#define scsi_for_each_sg(cmd, sg, nseg, __i)				\
+	for (__i = 0, sg = scsi_sglist_first(cmd); __i < (nseg);	\
+	     __i++, sg = sg_next(sg))
+
 /**
  *  scsi_sg_copy_from_buffer - Copy data from a buffer to scsi_cmnd's buffer/SG list
  *  @cmd: pointer to the struct scsi_cmnd
@@ -155,6 +155,21 @@ struct scsi_host_template {
 	 * If SCSI error handling is required, set this variable to 1
 	 */
 	int enable_eh;
+
+	/*
+	 * If set, queuecommand is called without the host_lock held and
+	 * with interrupts enabled, so that commands to the host can be
+	 * issued from several PCPUs at once. Only for drivers that do
+	 * not rely on the host_lock in queuecommand.
+	 */
+	unsigned lockless:1;
+
+	/*
+	 * vmklinux tracks outstanding commands per PCPU and leaves
+	 * sdev->cmd_list empty. Set this if the driver walks
+	 * sdev->cmd_list itself, so that commands are linked there too.
+	 */
+	unsigned sdev_cmd_list:1;
 #endif /* defined(__VMKLNX__) */
 	/*
 	 * Before the mid layer attempts to scan for a new device where none
@@ -470,6 +485,10 @@ struct Scsi_Host {
 	struct scsi_host_cmd_pool *cmd_pool;
 	spinlock_t		free_list_lock;
 	struct list_head	free_list; /* backup store of cmd structs */
+#if defined(__VMKLNX__)
+	/* per-PCPU scmd magazines and outstanding command lists */
+	struct scsi_host_pcpu	**pcpu_cmds;
+#endif /* defined(__VMKLNX__) */
 	struct list_head	starved_list;
 
 	spinlock_t		default_lock;
@@ -491,12 +510,25 @@ struct Scsi_Host {
 	 */
 	struct blk_queue_tag	*bqt;
 
+#if defined(__VMKLNX__)
+	/*
+	 * host_busy is admitted against can_queue and released without
+	 * the host_lock, read it with atomic_read().
+	 */
+	atomic_t host_busy;		   /* commands actually active on low-level */
+	/*
+	 * The following field is protected with host_lock;
+	 * however, eh routines can safely access during eh processing
+	 * without acquiring the lock.
+	 */
+#else /* !defined(__VMKLNX__) */
 	/*
 	 * The following two fields are protected with host_lock;
 	 * however, eh routines can safely access during eh processing
 	 * without acquiring the lock.
 	 */
 	unsigned int host_busy;		   /* commands actually active on low-level */
+#endif /* defined(__VMKLNX__) */
 	unsigned int host_failed;	   /* commands that failed. */
 	unsigned int host_eh_scheduled;    /* EH scheduled without command */
     
@@ -153,3 +153,101 @@ unsigned short ip_compute_csum(unsigned char * buff, int len)
 }
 EXPORT_SYMBOL(ip_compute_csum);
 
+/*
+ * Copy len bytes from src to dst and return their 32-bit checksum.
+ *
+ * x86 doesn't mind unaligned loads and stores, so unlike do_csum() the
+ * words are simply summed in the order they appear from src, leaving the
+ * odd byte, if any, in the low half of the last 16-bit word.
+ *
+ * Only general purpose registers are used: vmklinux has no
+ * kernel_fpu_begin(), so SSE/AVX state can't be touched from the
+ * contexts checksums are computed in.
+ */
+static unsigned do_csum_copy(const unsigned char *src, unsigned char *dst,
+			     unsigned len)
+{
+	unsigned long result = 0, zero = 0;
+	unsigned long a, b, c, d;
+
+	while (len >= 32) {
+		asm("movq 0*8(%[src]),%[a]\n\t"
+		    "movq 1*8(%[src]),%[b]\n\t"
+		    "movq 2*8(%[src]),%[c]\n\t"
+		    "movq 3*8(%[src]),%[d]\n\t"
+		    "addq %[a],%[res]\n\t"
+		    "adcq %[b],%[res]\n\t"
+		    "adcq %[c],%[res]\n\t"
+		    "adcq %[d],%[res]\n\t"
+		    "adcq %[zero],%[res]\n\t"
+		    "movq %[a],0*8(%[dst])\n\t"
+		    "movq %[b],1*8(%[dst])\n\t"
+		    "movq %[c],2*8(%[dst])\n\t"
+		    "movq %[d],3*8(%[dst])"
+		    : [res] "+r" (result),
+		      [a] "=&r" (a), [b] "=&r" (b), [c] "=&r" (c), [d] "=&r" (d)
+		    : [src] "r" (src), [dst] "r" (dst), [zero] "r" (zero)
+		    : "memory");
+		src += 32;
+		dst += 32;
+		len -= 32;
+	}
+
+	while (len >= 8) {
+		a = *(const unsigned long *)src;
+		*(unsigned long *)dst = a;
+		asm("addq %[a],%[res]\n\t"
+		    "adcq %[zero],%[res]"
+		    : [res] "+r" (result)
+		    : [a] "r" (a), [zero] "r" (zero));
+		src += 8;
+		dst += 8;
+		len -= 8;
+	}
+
+	result = add32_with_carry(result >> 32, result & 0xffffffff);
+	if (len & 4) {
+		a = *(const unsigned int *)src;
+		*(unsigned int *)dst = a;
+		result += a;
+		src += 4;
+		dst += 4;
+	}
+	if (len & 2) {
+		a = *(const unsigned short *)src;
+		*(unsigned short *)dst = a;
+		result += a;
+		src += 2;
+		dst += 2;
+	}
+	if (len & 1) {
+		*dst = *src;
+		result += *src;
+	}
+	return add32_with_carry(result >> 32, result & 0xffffffff);
+}
+
+/**
+ * csum_partial_copy_generic - Copy a buffer and compute its checksum.
+ * @src: source buffer
+ * @dst: destination buffer
+ * @len: number of bytes to copy
+ * @sum: initial sum to be added in (32bit unfolded)
+ * @src_err_ptr: unused, there are no faulting user copies in vmklinux
+ * @dst_err_ptr: unused, there are no faulting user copies in vmklinux
+ *
+ * Copies len bytes from src to dst, checksumming them on the way, so
+ * that the data is only brought into the cache once.
+ *
+ * RETURN VALUE:
+ * Returns the 32-bit unfolded checksum of the copied bytes plus sum.
+ */
+unsigned long csum_partial_copy_generic(const unsigned char *src,
+					const unsigned char *dst,
+					unsigned len, unsigned sum,
+					int *src_err_ptr, int *dst_err_ptr)
+{
+	return add32_with_carry(do_csum_copy(src, (unsigned char *)dst, len),
+				sum);
+}
+EXPORT_SYMBOL(csum_partial_copy_generic);
@@ -7,6 +7,25 @@
 #include <asm/checksum.h>
 #include <linux/module.h>
 
+/**
+ * csum_partial_copy_nocheck - Copy a kernel buffer and compute its checksum.
+ * @src: source buffer
+ * @dst: destination buffer
+ * @len: number of bytes to copy
+ * @sum: initial sum to be added in (32bit unfolded)
+ *
+ * RETURN VALUE:
+ * Returns the 32bit unfolded checksum of the copied bytes plus sum.
+ */
+/* _VMKLNX_CODECHECK_: csum_partial_copy_nocheck */
+unsigned int
+csum_partial_copy_nocheck(const unsigned char *src, unsigned char *dst,
+                          int len, unsigned int sum)
+{
+        return csum_partial_copy_generic(src, dst, len, sum, NULL, NULL);
+}
+EXPORT_SYMBOL(csum_partial_copy_nocheck);
+
 unsigned short csum_ipv6_magic(struct in6_addr *saddr, struct in6_addr *daddr,
                                __u32 len, unsigned short proto, unsigned int sum) 
 {
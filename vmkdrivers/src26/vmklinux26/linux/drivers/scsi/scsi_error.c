@@ -54,7 +54,11 @@
 /* called with shost->host_lock held */
 void scsi_eh_wakeup(struct Scsi_Host *shost)
 {
+#if defined(__VMKLNX__)
+	if (atomic_read(&shost->host_busy) == shost->host_failed) {
+#else /* !defined(__VMKLNX__) */
 	if (shost->host_busy == shost->host_failed) {
+#endif /* defined(__VMKLNX__) */
 		wake_up_process(shost->ehandler);
 		SCSI_LOG_ERROR_RECOVERY(5,
 				printk("Waking error handler thread\n"));
@@ -1613,7 +1617,11 @@ int scsi_error_handler(void *data)
 	set_current_state(TASK_INTERRUPTIBLE);
 	while (!kthread_should_stop()) {
 		if ((shost->host_failed == 0 && shost->host_eh_scheduled == 0) ||
+#if defined(__VMKLNX__)
+		    shost->host_failed != atomic_read(&shost->host_busy)) {
+#else /* !defined(__VMKLNX__) */
 		    shost->host_failed != shost->host_busy) {
+#endif /* defined(__VMKLNX__) */
 			SCSI_LOG_ERROR_RECOVERY(1,
 				printk("Error handler scsi_eh_%d sleeping\n",
 					shost->host_no));
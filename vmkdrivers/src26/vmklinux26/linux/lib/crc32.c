@@ -0,0 +1,148 @@
+/*
+ * crc32.c - little-endian CRC32 (IEEE 802.3 polynomial) for vmklinux
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This is the one CRC32 implementation of vmklinux: crc32_le() is what
+ * drivers use for multicast hash filters and firmware checks, and the
+ * FCoE frame CRC of fnic goes through it as well. Buffers are processed
+ * 8 bytes at a time with slice-by-8 tables built by crc32_init().
+ *
+ * There is no SIMD (PCLMULQDQ) path: vmklinux has no kernel_fpu_begin(),
+ * and the callers run in worldlet, interrupt and driver contexts whose
+ * XMM state must not be clobbered.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/types.h>
+#include <linux/string.h>
+#include <linux/crc32.h>
+
+#define CRC32_POLY_LE		0xedb88320
+
+/*
+ * crc32_table[0] is the classic byte at a time table, crc32_table[k][b]
+ * is the crc of byte b followed by k zero bytes.
+ */
+static u32 crc32_table[8][256] __cacheline_aligned;
+
+static u32 crc32_le_sb8(u32 crc, unsigned char const *p, size_t len)
+{
+	const u32 (*t)[256] = crc32_table;
+	u32 q, q2;
+
+	for (; len && ((unsigned long)p & 7); len--)
+		crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	for (; len >= 8; len -= 8) {
+		q = crc ^ *(const u32 *)p;
+		q2 = *(const u32 *)(p + 4);
+		p += 8;
+		crc = t[7][q & 0xff] ^ t[6][(q >> 8) & 0xff] ^
+		      t[5][(q >> 16) & 0xff] ^ t[4][q >> 24] ^
+		      t[3][q2 & 0xff] ^ t[2][(q2 >> 8) & 0xff] ^
+		      t[1][(q2 >> 16) & 0xff] ^ t[0][q2 >> 24];
+	}
+
+	while (len--)
+		crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+/**
+ *  crc32_le - Calculate bitwise little-endian Ethernet CRC
+ *  @crc: seed value for computation
+ *  @p: pointer to buffer over which CRC is run
+ *  @len: length of buffer p
+ *
+ *  Calculates bitwise little-endian Ethernet CRC from an
+ *  initial seed value that could be 0 or a previous value if
+ *  computing incrementally.
+ *
+ *  RETURN VALUE:
+ *  32-bit CRC value.
+ *
+ */
+/* _VMKLNX_CODECHECK_: crc32_le */
+u32 crc32_le(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_le_sb8(crc, p, len);
+}
+EXPORT_SYMBOL(crc32_le);
+
+/**
+ *  crc32_le_copy - Copy a buffer and calculate its little-endian CRC
+ *  @crc: seed value for computation
+ *  @dst: destination buffer
+ *  @src: pointer to buffer over which CRC is run
+ *  @len: length of buffer src
+ *
+ *  Copies @len bytes from @src to @dst, which must not overlap, and
+ *  returns crc32_le(@crc, @src, @len). The copy is done in the same
+ *  pass as the CRC.
+ *
+ *  RETURN VALUE:
+ *  32-bit CRC value.
+ *
+ */
+u32 crc32_le_copy(u32 crc, unsigned char *dst, unsigned char const *src,
+		  size_t len)
+{
+	const u32 (*t)[256] = crc32_table;
+	u32 q, q2;
+
+	for (; len && ((unsigned long)src & 7); len--) {
+		*dst++ = *src;
+		crc = t[0][(crc ^ *src++) & 0xff] ^ (crc >> 8);
+	}
+
+	for (; len >= 8; len -= 8) {
+		q = *(const u32 *)src;
+		q2 = *(const u32 *)(src + 4);
+		*(u32 *)dst = q;
+		*(u32 *)(dst + 4) = q2;
+		src += 8;
+		dst += 8;
+		q ^= crc;
+		crc = t[7][q & 0xff] ^ t[6][(q >> 8) & 0xff] ^
+		      t[5][(q >> 16) & 0xff] ^ t[4][q >> 24] ^
+		      t[3][q2 & 0xff] ^ t[2][(q2 >> 8) & 0xff] ^
+		      t[1][(q2 >> 16) & 0xff] ^ t[0][q2 >> 24];
+	}
+
+	while (len--) {
+		*dst++ = *src;
+		crc = t[0][(crc ^ *src++) & 0xff] ^ (crc >> 8);
+	}
+
+	return crc;
+}
+EXPORT_SYMBOL(crc32_le_copy);
+
+/*
+ * Build the slice-by-8 tables. Must run before any CRC is computed.
+ */
+void crc32_init(void)
+{
+	u32 crc;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ ((crc & 1) ? CRC32_POLY_LE : 0);
+		crc32_table[0][i] = crc;
+	}
+	for (i = 0; i < 256; i++) {
+		crc = crc32_table[0][i];
+		for (j = 1; j < 8; j++) {
+			crc = crc32_table[0][crc & 0xff] ^ (crc >> 8);
+			crc32_table[j][i] = crc;
+		}
+	}
+}
@@ -48,12 +48,74 @@ MODULE_DESCRIPTION("Large Receive Offload (ipv4 / tcp)");
 #define LRO_INC_STATS(lro_mgr, attr) { lro_mgr->stats.attr++; }
 
 #if defined(__VMKLNX__)
+#define IP6_HDR_LEN sizeof(struct ipv6hdr)
+/* length of the IPv6 fixed header plus extension headers */
+#define IP6_EXT_HDR_LEN(ip6h, tcph) ((u8 *)(tcph) - (u8 *)(ip6h))
+#define TCP6_PAYLOAD_LENGTH(ip6h, tcph) \
+	(IP6_HDR_LEN + ntohs(ip6h->payload_len) - IP6_EXT_HDR_LEN(ip6h, tcph) \
+	 - TCP_HDR_LEN(tcph))
+
+/* vmklnx_lro_ipv6_exthdrs bits */
+#define LRO_IPV6_EXTHDR_HOPOPTS 0x1
+#define LRO_IPV6_EXTHDR_DSTOPTS 0x2
+#define LRO_IPV6_EXTHDR_ROUTING 0x4
+
+static unsigned int vmklnx_lro_ipv6_exthdrs = 0;
+module_param(vmklnx_lro_ipv6_exthdrs, uint, 0444);
+MODULE_PARM_DESC(vmklnx_lro_ipv6_exthdrs, "IPv6 extension headers LRO may aggregate across: 0x1 hop-by-hop, 0x2 destination options, 0x4 routing (default 0, none).");
+
+/*
+ * Walk the IPv6 extension headers allowed by vmklnx_lro_ipv6_exthdrs
+ * and return the tcp header, or NULL if the packet isn't tcp, carries
+ * any other extension header or isn't linear up to the tcp header.
+ */
+
+static struct tcphdr *lro_ipv6_get_tcphdr(struct ipv6hdr *ip6h, int len)
+{
+	struct ipv6_opt_hdr *opth;
+	unsigned int exthdr;
+	u8 nexthdr = ip6h->nexthdr;
+	int off = IP6_HDR_LEN;
+
+	while (nexthdr != IPPROTO_TCP) {
+		switch (nexthdr) {
+		case IPPROTO_HOPOPTS:
+			/* only allowed right after the fixed header */
+			if (off != IP6_HDR_LEN)
+				return NULL;
+			exthdr = LRO_IPV6_EXTHDR_HOPOPTS;
+			break;
+		case IPPROTO_DSTOPTS:
+			exthdr = LRO_IPV6_EXTHDR_DSTOPTS;
+			break;
+		case IPPROTO_ROUTING:
+			exthdr = LRO_IPV6_EXTHDR_ROUTING;
+			break;
+		default:
+			return NULL;
+		}
+
+		if (!(vmklnx_lro_ipv6_exthdrs & exthdr)
+		    || off + sizeof(*opth) > len)
+			return NULL;
+
+		opth = (struct ipv6_opt_hdr *)((u8 *)ip6h + off);
+		nexthdr = opth->nexthdr;
+		off += (opth->hdrlen + 1) << 3;
+	}
+
+	if (off + sizeof(struct tcphdr) > len)
+		return NULL;
+
+	return (struct tcphdr *)((u8 *)ip6h + off);
+}
+
 int
 vmklnx_net_lro_get_skb_header(struct sk_buff *skb, void **ip_hdr,
                               void **tcpudp_hdr, u64 *hdr_flags, void *priv)
 {
         struct ethhdr *eh = NULL;
-        struct iphdr *iph = NULL;
+        void *l3h = NULL;
         struct tcphdr *th = NULL;
         u32 ethhdr_sz;
         
@@ -62,53 +124,69 @@ vmklnx_net_lro_get_skb_header(struct sk_buff *skb, void **ip_hdr,
         
         /* check to see if it is IPv4 */
         if (eth_header_is_ipv4(eh)) {
+                struct iphdr *iph;
+
                 ethhdr_sz = eth_header_len(eh);
                 
                 *hdr_flags |= LRO_IPV4;
                 iph = (struct iphdr *)((char *)eh + ethhdr_sz);
+                l3h = iph;
                 
                 /* check to see if it is TCP */
                 if (iph->protocol == IPPROTO_TCP) {
                         *hdr_flags |= LRO_TCP;
                         th = (struct tcphdr *)((char *)eh + sizeof(*iph) + ethhdr_sz);
                 }
-        }    
+        } else if (eth_header_frame_type(eh) == htons(ETH_P_IPV6)) {
+                struct ipv6hdr *ip6h;
+
+                ethhdr_sz = eth_header_len(eh);
+
+                *hdr_flags |= LRO_IPV6;
+                ip6h = (struct ipv6hdr *)((char *)eh + ethhdr_sz);
+                l3h = ip6h;
+
+                th = lro_ipv6_get_tcphdr(ip6h, skb_headlen(skb) - ethhdr_sz);
+                if (th) {
+                        *hdr_flags |= LRO_TCP;
+                }
+        }
         
-        *ip_hdr = iph;
+        *ip_hdr = l3h;
         *tcpudp_hdr = th;
         
         return 0;
 }
+
+/*
+ * Drop all descriptor state of lro_mgr without flushing it. Only to be
+ * used while nothing is being aggregated, e.g. when enabling napi.
+ */
+
+void vmklnx_lro_reset(struct net_lro_mgr *lro_mgr)
+{
+	memset(lro_mgr->lro_arr, 0,
+	       lro_mgr->max_desc * sizeof(struct net_lro_desc));
+	memset(lro_mgr->lro_hash, 0, sizeof(lro_mgr->lro_hash));
+	lro_mgr->active_cnt = 0;
+	lro_mgr->free_hint = 0;
+}
 #endif /* defined(__VMKLNX__) */
 
 /*
  * Basic tcp checks whether packet is suitable for LRO
  */
 
-static int lro_tcp_ip_check(struct iphdr *iph, struct tcphdr *tcph,
-			    int len, struct net_lro_desc *lro_desc)
+static int lro_tcp_check(struct tcphdr *tcph, int tcp_data_len,
+			 struct net_lro_desc *lro_desc)
 {
-        /* check ip header: don't aggregate padded frames */
-        if (ntohs(iph->tot_len) != len)
-		return -1;
-        
-        if ((iph->frag_off & htons(IP_OFFSET|IP_MF)) != 0) {
-                return -1;
-        }
-
-        if (TCP_PAYLOAD_LENGTH(iph, tcph) == 0)
-		return -1;
-        
-        if (iph->ihl != IPH_LEN_WO_OPTIONS)
+        if (tcp_data_len == 0)
 		return -1;
         
 	if (tcph->cwr || tcph->ece || tcph->urg || !tcph->ack
 	    || tcph->rst || tcph->syn || tcph->fin)
 		return -1;
         
-	if (INET_ECN_is_ce(ipv4_get_dsfield(iph)))
-		return -1;
-        
 	if (tcph->doff != TCPH_LEN_WO_OPTIONS
 	    && tcph->doff != TCPH_LEN_W_TIMESTAMP)
 		return -1;
@@ -137,6 +215,73 @@ static int lro_tcp_ip_check(struct iphdr *iph, struct tcphdr *tcph,
 	return 0;
 }
 
+static int lro_tcp_ip_check(struct iphdr *iph, struct tcphdr *tcph,
+			    int len, struct net_lro_desc *lro_desc)
+{
+        /* check ip header: don't aggregate padded frames */
+        if (ntohs(iph->tot_len) != len)
+		return -1;
+        
+        if ((iph->frag_off & htons(IP_OFFSET|IP_MF)) != 0) {
+                return -1;
+        }
+
+        if (iph->ihl != IPH_LEN_WO_OPTIONS)
+		return -1;
+        
+	if (INET_ECN_is_ce(ipv4_get_dsfield(iph)))
+		return -1;
+        
+	return lro_tcp_check(tcph, TCP_PAYLOAD_LENGTH(iph, tcph), lro_desc);
+}
+
+#if defined(__VMKLNX__)
+static int lro_tcp_ip6_check(struct ipv6hdr *ip6h, struct tcphdr *tcph,
+			     int len, struct net_lro_desc *lro_desc)
+{
+	int ext_len = IP6_EXT_HDR_LEN(ip6h, tcph);
+
+	/* don't aggregate padded frames */
+	if (IP6_HDR_LEN + ntohs(ip6h->payload_len) != len)
+		return -1;
+
+	if (INET_ECN_is_ce(ipv6_get_dsfield(ip6h)))
+		return -1;
+
+	/* extension headers must be the ones of the session */
+	if (lro_desc
+	    && (ext_len != IP6_EXT_HDR_LEN(lro_desc->ip6h, lro_desc->tcph)
+		|| memcmp(ip6h + 1, lro_desc->ip6h + 1, ext_len - IP6_HDR_LEN)))
+		return -1;
+
+	return lro_tcp_check(tcph, TCP6_PAYLOAD_LENGTH(ip6h, tcph), lro_desc);
+}
+
+static inline int lro_l3_check(struct iphdr *iph, struct ipv6hdr *ip6h,
+			       struct tcphdr *tcph, int len,
+			       struct net_lro_desc *lro_desc)
+{
+	if (iph)
+		return lro_tcp_ip_check(iph, tcph, len, lro_desc);
+	return lro_tcp_ip6_check(ip6h, tcph, len, lro_desc);
+}
+
+static inline u16 lro_ip_tot_len(struct iphdr *iph, struct ipv6hdr *ip6h)
+{
+	if (iph)
+		return ntohs(iph->tot_len);
+	return IP6_HDR_LEN + ntohs(ip6h->payload_len);
+}
+
+static inline int lro_tcp_data_len(struct iphdr *iph, struct ipv6hdr *ip6h,
+				   struct tcphdr *tcph)
+{
+	if (iph)
+		return TCP_PAYLOAD_LENGTH(iph, tcph);
+	return TCP6_PAYLOAD_LENGTH(ip6h, tcph);
+}
+#endif /* defined(__VMKLNX__) */
+
 static void lro_update_tcp_ip_header(struct net_lro_desc *lro_desc)
 {
 	struct iphdr *iph = lro_desc->iph;
@@ -154,6 +299,14 @@ static void lro_update_tcp_ip_header(struct net_lro_desc *lro_desc)
 		*(p+2) = lro_desc->tcp_rcv_tsecr;
 	}
 
+#if defined(__VMKLNX__)
+	if (lro_desc->ip6h) {
+		lro_desc->ip6h->payload_len =
+			htons(lro_desc->ip_tot_len - IP6_HDR_LEN);
+		return;
+	}
+#endif /* defined(__VMKLNX__) */
+
 	iph->tot_len = htons(lro_desc->ip_tot_len);
 
 	iph->check = 0;
@@ -189,13 +342,24 @@ static __wsum lro_tcp_data_csum(struct iphdr *iph, struct tcphdr *tcph, int len)
 }
 #endif /* !defined(__VMKLNX__) */
 
+#if defined(__VMKLNX__)
+static void lro_init_desc(struct net_lro_desc *lro_desc, struct sk_buff *skb,
+			  struct iphdr *iph, struct ipv6hdr *ip6h,
+			  struct tcphdr *tcph,
+			  u16 vlan_tag, struct vlan_group *vgrp)
+#else /* !defined(__VMKLNX__) */
 static void lro_init_desc(struct net_lro_desc *lro_desc, struct sk_buff *skb,
 			  struct iphdr *iph, struct tcphdr *tcph,
 			  u16 vlan_tag, struct vlan_group *vgrp)
+#endif /* defined(__VMKLNX__) */
 {
 	int nr_frags;
 	__be32 *ptr;
+#if defined(__VMKLNX__)
+	u32 tcp_data_len = lro_tcp_data_len(iph, ip6h, tcph);
+#else /* !defined(__VMKLNX__) */
 	u32 tcp_data_len = TCP_PAYLOAD_LENGTH(iph, tcph);
+#endif /* defined(__VMKLNX__) */
 
 	nr_frags = skb_shinfo(skb)->nr_frags;
 	lro_desc->parent = skb;
@@ -207,7 +371,12 @@ static void lro_init_desc(struct net_lro_desc *lro_desc, struct sk_buff *skb,
 	lro_desc->tcp_window = tcph->window;
 
 	lro_desc->pkt_aggr_cnt = 1;
+#if defined(__VMKLNX__)
+	lro_desc->ip6h = ip6h;
+	lro_desc->ip_tot_len = lro_ip_tot_len(iph, ip6h);
+#else /* !defined(__VMKLNX__) */
 	lro_desc->ip_tot_len = ntohs(iph->tot_len);
+#endif /* defined(__VMKLNX__) */
 
 	if (tcph->doff == 8) {
 		ptr = (__be32 *)(tcph+1);
@@ -263,11 +432,19 @@ static void lro_add_common(struct net_lro_desc *lro_desc, struct iphdr *iph,
 		lro_desc->mss = tcp_data_len;
 }
 
+#if defined(__VMKLNX__)
+static void lro_add_packet(struct net_lro_desc *lro_desc, struct sk_buff *skb,
+			   struct iphdr *iph, struct tcphdr *tcph,
+			   int tcp_data_len)
+{
+	struct sk_buff *parent = lro_desc->parent;
+#else /* !defined(__VMKLNX__) */
 static void lro_add_packet(struct net_lro_desc *lro_desc, struct sk_buff *skb,
 			   struct iphdr *iph, struct tcphdr *tcph)
 {
 	struct sk_buff *parent = lro_desc->parent;
 	int tcp_data_len = TCP_PAYLOAD_LENGTH(iph, tcph);
+#endif /* defined(__VMKLNX__) */
 
 	lro_add_common(lro_desc, iph, tcph, tcp_data_len);
 
@@ -308,30 +485,154 @@ static void lro_add_frags(struct net_lro_desc *lro_desc,
 }
 #endif /* !defined(__VMKLNX__) */
 
+#if defined(__VMKLNX__)
 static int lro_check_tcp_conn(struct net_lro_desc *lro_desc,
 			      struct iphdr *iph,
+			      struct ipv6hdr *ip6h,
 			      struct tcphdr *tcph)
 {
-	if ((lro_desc->iph->saddr != iph->saddr)
-	    || (lro_desc->iph->daddr != iph->daddr)
-	    || (lro_desc->tcph->source != tcph->source)
+	if ((lro_desc->tcph->source != tcph->source)
 	    || (lro_desc->tcph->dest != tcph->dest))
 		return -1;
-	return 0;
+
+	if (iph)
+		return (lro_desc->iph == NULL
+			|| lro_desc->iph->saddr != iph->saddr
+			|| lro_desc->iph->daddr != iph->daddr) ? -1 : 0;
+
+	return (lro_desc->ip6h == NULL
+		|| memcmp(&lro_desc->ip6h->saddr, &ip6h->saddr,
+			  sizeof(struct in6_addr))
+		|| memcmp(&lro_desc->ip6h->daddr, &ip6h->daddr,
+			  sizeof(struct in6_addr))) ? -1 : 0;
 }
 
-#if defined(__VMKLNX__)
+static u32 lro_hash_tuple(struct iphdr *iph, struct ipv6hdr *ip6h,
+			  struct tcphdr *tcph, u16 vlan_tag)
+{
+	u32 hash;
+
+	if (iph) {
+		hash = (u32)iph->saddr ^ (u32)iph->daddr;
+	} else {
+		hash = ip6h->saddr.s6_addr32[0] ^ ip6h->saddr.s6_addr32[1]
+		       ^ ip6h->saddr.s6_addr32[2] ^ ip6h->saddr.s6_addr32[3]
+		       ^ ip6h->daddr.s6_addr32[0] ^ ip6h->daddr.s6_addr32[1]
+		       ^ ip6h->daddr.s6_addr32[2] ^ ip6h->daddr.s6_addr32[3];
+	}
+	hash ^= ((u32)tcph->source << 16) | tcph->dest;
+	hash ^= vlan_tag;
+
+	/* mix so that the low bits used for the bucket depend on all bits */
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3b;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+static inline u16 *lro_hash_bucket(struct net_lro_mgr *lro_mgr, u32 hash)
+{
+	return &lro_mgr->lro_hash[hash & (LRO_HASH_BUCKETS - 1)];
+}
+
+static void lro_hash_insert(struct net_lro_mgr *lro_mgr,
+			    struct net_lro_desc *lro_desc)
+{
+	u16 *head = lro_hash_bucket(lro_mgr, lro_desc->hash);
+
+	lro_desc->hash_next = *head;
+	*head = (lro_desc - lro_mgr->lro_arr) + 1;
+	lro_mgr->active_cnt++;
+}
+
+static void lro_hash_remove(struct net_lro_mgr *lro_mgr,
+			    struct net_lro_desc *lro_desc)
+{
+	u16 *link = lro_hash_bucket(lro_mgr, lro_desc->hash);
+	u16 idx = (lro_desc - lro_mgr->lro_arr) + 1;
+
+	while (*link && *link != idx)
+		link = &lro_mgr->lro_arr[*link - 1].hash_next;
+
+	if (*link) {
+		*link = lro_desc->hash_next;
+		lro_mgr->active_cnt--;
+	}
+}
+
+/*
+ * Look the session up in its hash bucket. If there is none, hand out
+ * a free descriptor with the hash already set, lro_hash_insert() links
+ * it once the session is started.
+ */
+
 static struct net_lro_desc *lro_get_desc(struct net_lro_mgr *lro_mgr,
 					 struct net_lro_desc *lro_arr,
                                          u16 vlan_tag,
 					 struct iphdr *iph,
+					 struct ipv6hdr *ip6h,
 					 struct tcphdr *tcph)
+{
+	struct net_lro_desc *tmp;
+	int max_desc = lro_mgr->max_desc;
+	u32 hash = lro_hash_tuple(iph, ip6h, tcph, vlan_tag);
+	u16 idx;
+	int i, j;
+
+	for (idx = *lro_hash_bucket(lro_mgr, hash); idx; idx = tmp->hash_next) {
+		tmp = &lro_arr[idx - 1];
+		if ((tmp->hash == hash) && (tmp->vlan_tag == vlan_tag) &&
+		    !lro_check_tcp_conn(tmp, iph, ip6h, tcph))
+			return tmp;
+	}
+
+	if (lro_mgr->active_cnt < max_desc) {
+		j = lro_mgr->free_hint < max_desc ? lro_mgr->free_hint : 0;
+		for (i = 0; i < max_desc; i++) {
+			tmp = &lro_arr[j];
+			if (++j == max_desc)
+				j = 0;
+			if (!tmp->active) {
+				tmp->hash = hash;
+				lro_mgr->free_hint = j;
+				return tmp;
+			}
+		}
+	}
+
+	LRO_INC_STATS(lro_mgr, no_desc);
+	return NULL;
+}
+
+static inline void lro_inc_aggr_stats(struct net_lro_mgr *lro_mgr,
+				      struct net_lro_desc *lro_desc)
+{
+	LRO_INC_STATS(lro_mgr, aggregated);
+	if (lro_desc->ip6h)
+		lro_mgr->stats.aggregated_ipv6++;
+	else
+		lro_mgr->stats.aggregated_ipv4++;
+	if (lro_desc->vlan_tag)
+		lro_mgr->stats.aggregated_vlan++;
+}
 #else /* !defined(__VMKLNX__) */
+static int lro_check_tcp_conn(struct net_lro_desc *lro_desc,
+			      struct iphdr *iph,
+			      struct tcphdr *tcph)
+{
+	if ((lro_desc->iph->saddr != iph->saddr)
+	    || (lro_desc->iph->daddr != iph->daddr)
+	    || (lro_desc->tcph->source != tcph->source)
+	    || (lro_desc->tcph->dest != tcph->dest))
+		return -1;
+	return 0;
+}
+
 static struct net_lro_desc *lro_get_desc(struct net_lro_mgr *lro_mgr,
 					 struct net_lro_desc *lro_arr,
 					 struct iphdr *iph,
 					 struct tcphdr *tcph)
-#endif /* defined(__VMKLNX__) */
 {
 	struct net_lro_desc *lro_desc = NULL;
 	struct net_lro_desc *tmp;
@@ -341,12 +642,7 @@ static struct net_lro_desc *lro_get_desc(struct net_lro_mgr *lro_mgr,
 	for (i = 0; i < max_desc; i++) {
 		tmp = &lro_arr[i];
 		if (tmp->active)
-#if defined(__VMKLNX__)
-                        if ((tmp->vlan_tag == vlan_tag) &&
-                            !lro_check_tcp_conn(tmp, iph, tcph)) {
-#else /* !defined(__VMKLNX__) */
 			if (!lro_check_tcp_conn(tmp, iph, tcph)) {
-#endif /* defined(__VMKLNX__) */
 				lro_desc = tmp;
 				goto out;
 			}
@@ -363,6 +659,7 @@ static struct net_lro_desc *lro_get_desc(struct net_lro_mgr *lro_mgr,
 out:
 	return lro_desc;
 }
+#endif /* defined(__VMKLNX__) */
 
 static void lro_flush(struct net_lro_mgr *lro_mgr,
 		      struct net_lro_desc *lro_desc)
@@ -401,6 +698,11 @@ static void lro_flush(struct net_lro_mgr *lro_mgr,
 	}
 
 	LRO_INC_STATS(lro_mgr, flushed);
+#if defined(__VMKLNX__)
+	lro_mgr->stats.aggr_hist[min(fls(lro_desc->pkt_aggr_cnt) - 1,
+				     LRO_AGGR_HIST_BUCKETS - 1)]++;
+	lro_hash_remove(lro_mgr, lro_desc);
+#endif /* defined(__VMKLNX__) */
 	lro_clear_desc(lro_desc);
 }
 
@@ -412,7 +714,9 @@ static int __lro_proc_skb(struct net_lro_mgr *lro_mgr, struct sk_buff *skb,
 	struct tcphdr *tcph;
 	u64 flags;
 #if defined(__VMKLNX__)
+	struct ipv6hdr *ip6h = NULL;
 	int eth_hdr_len = 0;
+	int tcp_data_len;
 #else /* !defined(__VMKLNX__) */
 	int vlan_hdr_len = 0;
 #endif /* defined(__VMKLNX__) */
@@ -432,12 +736,23 @@ static int __lro_proc_skb(struct net_lro_mgr *lro_mgr, struct sk_buff *skb,
 				       &flags, priv))
 		goto out;
 
-	if (!(flags & LRO_IPV4) || !(flags & LRO_TCP))
+#if defined(__VMKLNX__)
+	if (!(flags & LRO_TCP))
 		goto out;
 
-#if defined(__VMKLNX__)
-	lro_desc = lro_get_desc(lro_mgr, lro_mgr->lro_arr, vlan_tag, iph, tcph);
+	if (flags & LRO_IPV6) {
+		ip6h = (struct ipv6hdr *)iph;
+		iph = NULL;
+	} else if (!(flags & LRO_IPV4)) {
+		goto out;
+	}
+
+	lro_desc = lro_get_desc(lro_mgr, lro_mgr->lro_arr, vlan_tag,
+				iph, ip6h, tcph);
 #else /* !defined(__VMKLNX__) */
+	if (!(flags & LRO_IPV4) || !(flags & LRO_TCP))
+		goto out;
+
 	lro_desc = lro_get_desc(lro_mgr, lro_mgr->lro_arr, iph, tcph);
 #endif /* defined(__VMKLNX__) */
 	if (!lro_desc)
@@ -453,15 +768,25 @@ static int __lro_proc_skb(struct net_lro_mgr *lro_mgr, struct sk_buff *skb,
 
 	if (!lro_desc->active) { /* start new lro session */
 #if defined(__VMKLNX__)
-                if (lro_tcp_ip_check(iph, tcph, skb->len - eth_hdr_len, NULL))
+		/* a PSH segment would end the session right away */
+                if (tcph->psh ||
+                    lro_l3_check(iph, ip6h, tcph, skb->len - eth_hdr_len, NULL))
+			goto out;
+
+		skb->ip_summed = lro_mgr->ip_summed_aggr;
+		lro_init_desc(lro_desc, skb, iph, ip6h, tcph, vlan_tag, vgrp);
+		lro_hash_insert(lro_mgr, lro_desc);
+		lro_inc_aggr_stats(lro_mgr, lro_desc);
+		if (lro_mgr->features & LRO_F_DEFERRED_FLUSH)
+			lro_desc->last_tc = vmk_GetTimerCycles();
 #else /* !defined(__VMKLNX__) */
                 if (lro_tcp_ip_check(iph, tcph, skb->len - vlan_hdr_len, NULL))
-#endif /* defined(__VMKLNX__) */
 			goto out;
 
 		skb->ip_summed = lro_mgr->ip_summed_aggr;
 		lro_init_desc(lro_desc, skb, iph, tcph, vlan_tag, vgrp);
 		LRO_INC_STATS(lro_mgr, aggregated);
+#endif /* defined(__VMKLNX__) */
 		return 0;
 	}
 
@@ -469,10 +794,28 @@ static int __lro_proc_skb(struct net_lro_mgr *lro_mgr, struct sk_buff *skb,
 		goto out2;
 
 #if defined(__VMKLNX__)
-	if (lro_tcp_ip_check(iph, tcph, skb->len - eth_hdr_len, lro_desc))
+	if (lro_l3_check(iph, ip6h, tcph, skb->len - eth_hdr_len, lro_desc))
+		goto out2;
+
+	tcp_data_len = lro_tcp_data_len(iph, ip6h, tcph);
+	lro_add_packet(lro_desc, skb, iph, tcph, tcp_data_len);
+	lro_inc_aggr_stats(lro_mgr, lro_desc);
+
+	if ((lro_desc->pkt_aggr_cnt >= lro_mgr->max_aggr) ||
+	    lro_desc->parent->len > (0xFFFF - lro_mgr->dev->mtu) ||
+	    (lro_mgr->max_sess_bytes &&
+	     lro_desc->parent->len >= lro_mgr->max_sess_bytes)) {
+		lro_mgr->stats.flushed_budget++;
+                lro_flush(lro_mgr, lro_desc);
+	} else if (tcph->psh) {
+		/* the sender has no more data queued, don't hold it back */
+		lro_mgr->stats.flushed_psh++;
+                lro_flush(lro_mgr, lro_desc);
+	} else if (lro_mgr->features & LRO_F_DEFERRED_FLUSH) {
+		lro_desc->last_tc = vmk_GetTimerCycles();
+	}
 #else /* !defined(__VMKLNX__) */
 	if (lro_tcp_ip_check(iph, tcph, skb->len, lro_desc))
-#endif /* defined(__VMKLNX__) */
 		goto out2;
 
 	lro_add_packet(lro_desc, skb, iph, tcph);
@@ -481,6 +824,7 @@ static int __lro_proc_skb(struct net_lro_mgr *lro_mgr, struct sk_buff *skb,
 	if ((lro_desc->pkt_aggr_cnt >= lro_mgr->max_aggr) ||
 	    lro_desc->parent->len > (0xFFFF - lro_mgr->dev->mtu))
                 lro_flush(lro_mgr, lro_desc);
+#endif /* defined(__VMKLNX__) */
 
 	return 0;
 
@@ -623,8 +967,13 @@ int lro_receive_skb(struct net_lro_mgr *lro_mgr,
 {
         u16 vlan_tag = 0;
         
-        /* The skb might comes from vlan_hwaccel_receive_skb() */
-        if (unlikely(__vlan_hwaccel_get_tag(skb, &vlan_tag))) {
+        /*
+         * The skb might come from vlan_hwaccel_receive_skb(), which
+         * stores the tag in skb->cb with the rx cookie magic.
+         */
+        if (vlan_rx_tag_present(skb)) {
+                vlan_tag = vlan_rx_tag_get(skb);
+        } else {
                 __vlan_get_tag(skb, &vlan_tag);
         }
         if (__lro_proc_skb(lro_mgr, skb, NULL, vlan_tag, priv)) {
@@ -714,6 +1063,11 @@ void lro_flush_all(struct net_lro_mgr *lro_mgr)
 	int i;
 	struct net_lro_desc *lro_desc = lro_mgr->lro_arr;
 
+#if defined(__VMKLNX__)
+	if (lro_mgr->active_cnt == 0)
+		return;
+#endif /* defined(__VMKLNX__) */
+
 	for (i = 0; i < lro_mgr->max_desc; i++) {
                 if (lro_desc[i].active)
 			lro_flush(lro_mgr, &lro_desc[i]);
@@ -721,6 +1075,40 @@ void lro_flush_all(struct net_lro_mgr *lro_mgr)
 }
 EXPORT_SYMBOL(lro_flush_all);
 
+#if defined(__VMKLNX__)
+/*
+ * Flush the sessions of a LRO_F_DEFERRED_FLUSH manager which haven't
+ * aggregated anything for flush_idle_tc. Returns how long until the
+ * next remaining session goes idle, 0 if none is left open.
+ */
+
+vmk_TimerRelCycles vmklnx_lro_flush_idle(struct net_lro_mgr *lro_mgr,
+                                         vmk_TimerCycles now)
+{
+	struct net_lro_desc *lro_desc = lro_mgr->lro_arr;
+	vmk_TimerRelCycles idle, next = 0;
+	int i;
+
+	if (lro_mgr->active_cnt == 0)
+		return 0;
+
+	for (i = 0; i < lro_mgr->max_desc; i++) {
+		if (!lro_desc[i].active)
+			continue;
+
+		idle = (vmk_TimerRelCycles)(now - lro_desc[i].last_tc);
+		if (idle >= lro_mgr->flush_idle_tc) {
+			lro_mgr->stats.flushed_idle++;
+			lro_flush(lro_mgr, &lro_desc[i]);
+		} else if (next == 0 || lro_mgr->flush_idle_tc - idle < next) {
+			next = lro_mgr->flush_idle_tc - idle;
+		}
+	}
+
+	return next;
+}
+#endif /* defined(__VMKLNX__) */
+
 #if !defined(__VMKLNX__)
 void lro_flush_pkt(struct net_lro_mgr *lro_mgr,
 		  struct iphdr *iph, struct tcphdr *tcph)
@@ -345,6 +345,13 @@ skb_release_data(struct sk_buff *skb)
          } else {
             vmk_PktRelease(skb->pkt);
          }
+         /*
+          * page frags from an rx page pool go back to it with the packet
+          * handle; pskb_expand_head() keeps both across a data release
+          */
+         if (skb_shinfo(skb)->nr_frags) {
+            vmklnx_page_pool_put_frags(skb);
+         }
       }
 
       if (skb_shinfo(skb)->frag_list)
@@ -1370,9 +1377,21 @@ fault:
 }
 
 EXPORT_SYMBOL(skb_store_bits);
+#endif /* !defined(__VMKLNX__) */
 
-/* Checksum skb data. */
+/**
+ *	skb_checksum	-	checksum skb data
+ *	@skb: buffer to checksum
+ *	@offset: offset of the first byte to checksum
+ *	@len: number of bytes to checksum
+ *	@csum: initial sum to be added in (32bit unfolded)
+ *
+ *	Computes the 32bit unfolded internet checksum of @len bytes of
+ *	@skb starting at @offset, walking the paged fragments and the
+ *	fragment list as needed. Returns the checksum plus @csum.
+ */
 
+/* _VMKLNX_CODECHECK_: skb_checksum */
 unsigned int skb_checksum(const struct sk_buff *skb, int offset,
 			  int len, unsigned int csum)
 {
@@ -1446,8 +1465,20 @@ unsigned int skb_checksum(const struct sk_buff *skb, int offset,
 	return csum;
 }
 
-/* Both of above in one bottle. */
+/**
+ *	skb_copy_and_csum_bits	-	copy skb data and checksum it
+ *	@skb: source buffer
+ *	@offset: offset in source
+ *	@to: destination buffer
+ *	@len: number of bytes to copy
+ *	@csum: initial sum to be added in (32bit unfolded)
+ *
+ *	Both skb_copy_bits() and skb_checksum() in one pass over the data,
+ *	with the copy and the checksum fused by csum_partial_copy_nocheck().
+ *	Returns the 32bit unfolded checksum of the copied bytes plus @csum.
+ */
 
+/* _VMKLNX_CODECHECK_: skb_copy_and_csum_bits */
 unsigned int skb_copy_and_csum_bits(const struct sk_buff *skb, int offset,
 				    u8 *to, int len, unsigned int csum)
 {
@@ -1527,6 +1558,18 @@ unsigned int skb_copy_and_csum_bits(const struct sk_buff *skb, int offset,
 	return csum;
 }
 
+/**
+ *	skb_copy_and_csum_dev	-	copy skb to a device buffer
+ *	@skb: source buffer
+ *	@to: destination buffer, at least skb->len bytes
+ *
+ *	Copies the whole of @skb into @to for devices that transmit from
+ *	a bounce buffer. For a CHECKSUM_HW skb the transport checksum is
+ *	computed while copying and stored at its offset in @to, so such
+ *	devices need not offload it.
+ */
+
+/* _VMKLNX_CODECHECK_: skb_copy_and_csum_dev */
 void skb_copy_and_csum_dev(const struct sk_buff *skb, u8 *to)
 {
 	unsigned int csum;
@@ -1552,7 +1595,6 @@ void skb_copy_and_csum_dev(const struct sk_buff *skb, u8 *to)
 		*((unsigned short *)(to + csstuff)) = csum_fold(csum);
 	}
 }
-#endif /* !defined(__VMKLNX__) */
 
 /**
  *	skb_dequeue - remove from the head of the queue
@@ -2234,16 +2276,14 @@ EXPORT_SYMBOL(__netdev_alloc_skb);
 EXPORT_SYMBOL(pskb_copy);
 #endif /* !defined(__VMKLNX__) */
 EXPORT_SYMBOL(pskb_expand_head);
-#if !defined(__VMKLNX__)
 EXPORT_SYMBOL(skb_checksum);
+#if !defined(__VMKLNX__)
 EXPORT_SYMBOL(skb_clone);
 #endif /* !defined(__VMKLNX__) */
 EXPORT_SYMBOL(skb_clone_fraglist);
 EXPORT_SYMBOL(skb_copy);
-#if !defined(__VMKLNX__)
 EXPORT_SYMBOL(skb_copy_and_csum_bits);
 EXPORT_SYMBOL(skb_copy_and_csum_dev);
-#endif /* !defined(__VMKLNX__) */
 EXPORT_SYMBOL(skb_copy_bits);
 #if !defined(__VMKLNX__)
 EXPORT_SYMBOL(skb_copy_expand);
@@ -0,0 +1,616 @@
+/*
+ * blk_merge_sim.c --
+ *
+ *    Trace-driven simulation of the request merging and plugging of the
+ *    vmklinux block request queue as it ships: LinuxBlockIssueCmd with
+ *    LinuxBlockMergeBio and add_request, the completion of LinuxBlockBH,
+ *    blk_complete_request, elv_next_request, elv_dequeue_request,
+ *    blk_plug_device, blk_remove_plug, blk_start_queue, blk_stop_queue,
+ *    blk_rq_map_sg and __generic_unplug_device in vmware/linux_block.c,
+ *    in front of the cciss driver (do_cciss_request, complete_command
+ *    and cciss_softirq_done in drivers/block/cciss/cciss.c).
+ *
+ *    Each workload is a trace of block commands with arrival times:
+ *    sequential, reverse sequential, random, sequential streams mixed
+ *    with random IO, and a sequential stream slow enough to find the
+ *    device idle each time. The controller completes a command after a
+ *    fixed cost plus a cost per sector, give or take some jitter, and
+ *    the BH runs right after each completion. The merge and unplug
+ *    statistics of each run are printed, with the mean sectors per
+ *    request and the mean wait of a command for the driver.
+ *
+ *    The test fails if
+ *    - a command is not completed exactly once, not with the bytes it
+ *      asked for, or the memory of its request is not freed;
+ *    - a request handed to the controller is not one contiguous run of
+ *      its bios in sector order, mixes directions, exceeds max_sectors,
+ *      max_phys_segments or max_hw_segments, does not have the SG list
+ *      and CDB of its bios, or changes after the driver has seen it;
+ *    - requests reach the controller out of the order they were queued
+ *      in;
+ *    - a command that finds the device idle is not handed to it at once,
+ *      or requests are held on the queue while the driver owns none;
+ *    - a busy, plugged queue holds more than vmklnx_block_unplug_thresh
+ *      requests;
+ *    - sequential and reverse sequential streams are not mostly merged,
+ *      random IO is, or anything is merged with merging turned off.
+ *
+ * extract ../../include/linux/poison.h: LIST_POISON1 LIST_POISON2
+ * extract ../../include/linux/list.h: LIST_HEAD_INIT LIST_HEAD __list_add list_add list_add_tail __list_del list_del list_del_init list_empty list_for_each list_for_each_prev
+ * extract ../../include/linux/types.h: sector_t
+ * extract ../../include/linux/kdev_t.h: MINORBITS MKDEV
+ * extract ../../include/linux/major.h: MAX_BLKDEV COMPAQ_CISS_MAJOR
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/linux/pci.h: PCI_DMA_TODEVICE PCI_DMA_FROMDEVICE
+ * extract ../../include/linux/timer.h: struct timer_list
+ * extract ../../include/linux/backing-dev.h: congested_fn struct backing_dev_info
+ * extract ../../include/linux/fs.h: READ WRITE struct block_device
+ * extract ../../include/linux/genhd.h: struct gendisk
+ * extract ../../include/linux/bio.h: struct bio_vec bio_end_io_t bio_destructor_t struct bio BIO_UPTODATE BIO_POOL_BITS BIO_POOL_OFFSET BIO_RW bio_iovec_idx bio_iovec bio_sectors bio_cur_sectors bvec_to_phys BIOVEC_PHYS_MERGEABLE __BIO_SEG_BOUNDARY BIOVEC_SEG_BOUNDARY __bio_for_each_segment bio_for_each_segment bio_get
+ * extract ../../include/linux/blkdev.h: request_queue_t elevator_t rq_end_io_fn BLK_MAX_CDB struct request enum rq_flag_bits REQ_SOFTBARRIER REQ_HARDBARRIER REQ_CMD REQ_NOMERGE REQ_STARTED struct request_list merge_request_fn merge_requests_fn request_fn_proc make_request_fn prep_rq_fn unplug_fn merge_bvec_fn activity_fn issue_flush_fn prepare_flush_fn softirq_done_fn struct request_queue RQ_INACTIVE RQ_ACTIVE QUEUE_FLAG_CLUSTER QUEUE_FLAG_STOPPED QUEUE_FLAG_PLUGGED blk_queue_plugged blk_queue_stopped blk_fs_request blk_rq_started blk_account_rq list_entry_rq rq_data_dir RQ_NOMERGE_FLAGS rq_for_each_bio bdev_get_queue blkdev_dequeue_request blk_finished_io
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_lock.h: vmk_SpinlockIRQ
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_ext.h: vmk_ScsiCommandDirection vmk_ScsiPluginStatus vmk_ScsiHostStatus vmk_ScsiDeviceStatus vmk_ScsiCmdStatus
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_types.h: vmk_ScsiSenseData vmk_ScsiCommandId vmk_ScsiCommandDoneCbk VMK_SCSI_MAX_CDB_LEN vmk_ScsiCommand
+ * extract ../vmware/linux_block.c: SECTOR_SIZE BLOCK_GET_ID BLOCK_MAX_BH_COMMANDS BLOCK_MAX_MERGE_SCAN vmklnx_block_unplug_thresh vmklnx_block_merge linuxBlockBHNum blockBHListLock linuxBHCompletionList bdev_cachep all_bdevs LinuxBlockDisk LinuxBlockAdapter blockDevices LinuxBlockBuffer LINBLOCK_NORMAL_IO LINBLOCK_SPECIAL_IO add_request blkdev_release_request end_that_request_last bdget LinuxBlockScheduleCompletion LinuxBlockCompleteCommand LinuxBlockIODone LinuxBlockBH bio_phys_segments bio_hw_segments LinuxBlockMergeBio LinuxBlockIssueCmd __generic_unplug_device elv_next_request elv_dequeue_request blk_start_queue blk_add_trace_generic blk_plug_device blk_remove_plug blk_stop_queue blk_rq_map_sg blk_complete_request bio_endio bio_init vmklnx_bio_vec_alloc vmklnx_bio_alloc vmklnx_bio_free vmklnx_bio_fs_destructor bio_alloc
+ * extract ../../drivers/block/cciss/cciss_cmd.h: SENSEINFOBYTES MAXSGENTRIES CMD_TARGET_STATUS CMD_DATA_UNDERRUN CMD_DATA_OVERRUN CMD_INVALID CMD_PROTOCOL_ERR CMD_HARDWARE_ERR CMD_CONNECTION_LOST CMD_ABORTED CMD_ABORT_FAILED CMD_UNSOLICITED_ABORT CMD_TIMEOUT XFER_WRITE XFER_READ ATTR_SIMPLE TYPE_CMD vals32 u64bit BYTE WORD HWORD DWORD QWORD CISS_MAX_LUN CCISS_READ CCISS_WRITE SCSI3Addr_struct PhysDevAddr_struct LogDevAddr_struct LUNAddr_struct CommandListHeader_struct RequestBlock_struct ErrDescriptor_struct SGDescriptor_struct MoreErrInfo_struct ErrorInfo_struct CMD_RWREQ PADSIZE CommandList_struct HostWrite_struct CfgTable_struct
+ * extract ../../drivers/block/cciss/cciss.h: NWD NWD_SHIFT ctlr_info_t struct access_method drive_info_struct struct sendcmd_reject_list struct ctlr_info
+ * extract ../../drivers/block/cciss/cciss.c: MAX_CMD_RETRIES MAX_CTLR hba addQ removeQ cmd_alloc cmd_free complete_buffers cciss_check_queues cciss_softirq_done start_io resend_cciss_cmd complete_command do_cciss_request
+ */
+
+#include <errno.h>
+
+#include "stubs.h"
+
+#define NR_CMDS                 8       /* cciss command slots */
+#define MAX_SECTORS             128
+#define MAX_IOS                 20000
+#define REQ_COST_US             40
+#define SECTOR_COST_US          1
+#define PAGE_SIZE               4096UL
+
+typedef unsigned int gfp_t;
+#define GFP_KERNEL                      0
+#define VMK_DEVICE_NAME_MAX_LENGTH      32
+#define module_param(name, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+#define vmk_Panic(fmt, args...)                 VMK_ASSERT(0)
+#define vmk_GetPCPUNum()                        ((unsigned) stub_pcpu)
+#define vmk_SPLockIRQ(lock)                     ((void) (lock), (uint64_t) 0)
+#define vmk_SPUnlockIRQ(lock, irql)             ((void) (lock), (void) (irql))
+#define vmk_ScsiAdapterIsPAECapable(adapter)    ((void) (adapter), VMK_TRUE)
+#define vmk_IsLowMachAddr(addr)                 ((addr) < (1ULL << 32))
+#define blk_add_trace_rq(q, rq, what)           do { } while (0)
+#define add_disk_randomness(disk)               ((void) (disk))
+
+/* __generic_unplug_device() only uses its adapter for the module id */
+#undef VMKAPI_MODULE_CALL_VOID
+#define VMKAPI_MODULE_CALL_VOID(moduleID, fn, args...)                     \
+   ((void) (moduleID), (fn)(args))
+
+/* the machine and virtual addresses of the test are the same */
+#define phys_to_page(x)         ((struct page *) (uintptr_t) ((x) & ~(PAGE_SIZE - 1)))
+#define page_to_phys(page)      ((dma_addr_t) (uintptr_t) (page))
+#define offset_in_page(x)       ((unsigned int) ((x) & (PAGE_SIZE - 1)))
+
+struct pci_dev;
+#define pci_map_page(pdev, page, offset, size, dir)                        \
+   ((void) (pdev), (void) (size), (void) (dir), page_to_phys(page) + (offset))
+#define pci_unmap_page(pdev, addr, size, dir)                              \
+   ((void) (pdev), (void) (addr), (void) (size), (void) (dir))
+#define pci_alloc_consistent(pdev, size, handle)                           \
+   ((void) (pdev), *(handle) = 0, calloc(1, (size)))
+#define pci_free_consistent(pdev, size, ptr, handle)                       \
+   ((void) (pdev), (void) (size), (void) (handle), free(ptr))
+
+/* all bdevs are made by bdget() */
+#define kmem_cache_alloc(cache, flags)                                     \
+   ((void) (cache), (void) (flags), calloc(1, sizeof(struct block_device)))
+
+/* the requests are stamped with the simulated time */
+static unsigned long now;
+#define jiffies                 now
+
+/* what the block queue embeds without touching it */
+struct mutex {
+   int unused;
+};
+struct semaphore {
+   int unused;
+};
+struct kobject {
+   int unused;
+};
+struct work_struct {
+   int unused;
+};
+struct disk_stats {
+   int unused;
+};
+typedef struct {
+   int unused;
+} wait_queue_head_t;
+typedef struct mempool_s mempool_t;
+
+typedef struct vmk_ScsiAdapter {
+   vmk_ModuleID moduleID;
+} vmk_ScsiAdapter;
+
+/* the module heap, counted */
+static struct {
+   unsigned long allocs;
+   unsigned long frees;
+} heap;
+
+static void *
+VMKLinux26_Alloc(size_t size)
+{
+   heap.allocs++;
+   return calloc(1, size);
+}
+
+static void
+VMKLinux26_Free(void *ptr)
+{
+   if (ptr != NULL) {
+      heap.frees++;
+      free(ptr);
+   }
+}
+
+#define kmalloc(size, flags)    ((void) (flags), VMKLinux26_Alloc(size))
+
+/* what the extracted code calls, defined below or in it further down */
+struct request_queue;
+struct request;
+struct bio;
+struct completion;
+struct vmk_ScsiCommand;
+static int find_first_zero_bit(const unsigned long *addr, int size);
+static void complete(struct completion *waiting);
+static VMK_ReturnStatus vmk_BottomHalfSchedulePCPU(vmk_BottomHalf bh,
+                                                   unsigned pcpu);
+static struct bio *vmklnx_bio_alloc(int nr_iovecs);
+static void vmklnx_bio_free(struct bio *bio);
+struct bio *bio_alloc(gfp_t gfp_mask, int nr_iovecs);
+/* as in the kernel, which is built with gnu89 inline */
+int bio_phys_segments(struct request_queue *q, struct bio *bio);
+int bio_hw_segments(struct request_queue *q, struct bio *bio);
+void __generic_unplug_device(struct request_queue *q, void *data);
+void elv_dequeue_request(struct request_queue *q, struct request *rq);
+void blk_plug_device(struct request_queue *q);
+int blk_remove_plug(struct request_queue *q);
+
+#include "blk_merge_sim.inc"
+
+/* a command of the test, as the vmkernel sees it */
+struct sim_cmd {
+   vmk_ScsiCommand vmkCmd;
+   unsigned long arrival;
+   unsigned long dispatched;
+   int completed;
+   int foundIdle;
+};
+
+static const char *curWorkload;
+static int bhScheduled;
+
+#define fail_run(fmt, args...)  fail("%s: " fmt, curWorkload, ## args)
+
+/* the cciss controller, with one logical drive */
+static ctlr_info_t ctlr;
+static CommandList_struct cmdPool[NR_CMDS];
+static ErrorInfo_struct errinfoPool[NR_CMDS];
+static unsigned long cmdPoolBits[1];
+static struct gendisk disk;
+static request_queue_t queue;
+
+static vmk_ScsiAdapter vmkAdapter;
+static LinuxBlockDisk blkDisk = { .exists = VMK_TRUE, .gd = &disk };
+static LinuxBlockAdapter blkAdapter = {
+   .adapter = &vmkAdapter,
+   .major = COMPAQ_CISS_MAJOR,
+   .minor_shift = NWD_SHIFT,
+};
+
+/* what the controller tracks of the commands it was handed */
+static struct {
+   unsigned long doneAt[NR_CMDS];
+   unsigned long startedSectors[NR_CMDS];
+   unsigned long lastStart;
+   unsigned long requests;
+   unsigned long sectors;
+   unsigned int seed;
+} sim;
+
+static int
+find_first_zero_bit(const unsigned long *addr, int size)
+{
+   int i;
+
+   for (i = 0; i < size && test_bit(i, addr); i++) {
+   }
+   return i;
+}
+
+static void
+complete(struct completion *waiting)
+{
+   (void) waiting;
+   fail_run("completed a request with a waiter");
+}
+
+static VMK_ReturnStatus
+vmk_BottomHalfSchedulePCPU(vmk_BottomHalf bh, unsigned pcpu)
+{
+   VMK_ASSERT(bh == linuxBlockBHNum);
+   (void) pcpu;
+   bhScheduled = 1;
+   return VMK_OK;
+}
+
+static void
+sim_done(vmk_ScsiCommand *cmd)
+{
+   struct sim_cmd *sc = container_of(cmd, struct sim_cmd, vmkCmd);
+
+   sc->completed++;
+   if (cmd->status.host != VMK_SCSI_HOST_OK ||
+       cmd->status.device != VMK_SCSI_DEVICE_GOOD) {
+      fail_run("command completed with host status %d", cmd->status.host);
+   }
+}
+
+/* what the controller checks of a command it is handed */
+static void
+check_request(CommandList_struct *c)
+{
+   struct request *rq = c->rq;
+   struct bio *bio;
+   struct bio_vec *bvec;
+   LinuxBlockBuffer *llb;
+   unsigned int sector = rq->sector, segs = 0, startBlk, nrSectors;
+   int sg = 0, i;
+
+   if (rq->nr_sectors > queue.max_sectors ||
+       rq->nr_phys_segments > queue.max_phys_segments ||
+       rq->nr_hw_segments > queue.max_hw_segments) {
+      fail_run("request exceeds the queue limits");
+   }
+   if (sim.requests > 0 && rq->start_time <= sim.lastStart) {
+      fail_run("request reached the controller out of queue order");
+   }
+   sim.lastStart = rq->start_time;
+
+   startBlk = c->Request.CDB[2] << 24 | c->Request.CDB[3] << 16 |
+              c->Request.CDB[4] << 8 | c->Request.CDB[5];
+   nrSectors = c->Request.CDB[7] << 8 | c->Request.CDB[8];
+   if (startBlk != rq->sector || nrSectors != rq->nr_sectors ||
+       c->Request.CDB[0] !=
+          (rq_data_dir(rq) == READ ? CCISS_READ : CCISS_WRITE)) {
+      fail_run("CDB does not match the request");
+   }
+
+   llb = rq->bio->bi_private;
+   for (bio = rq->bio; bio != NULL; bio = bio->bi_next) {
+      if (bio->bi_sector != sector || bio->bi_private != llb ||
+          llb->creq != rq || bio->bi_rw != rq_data_dir(rq)) {
+         fail_run("request is not one contiguous run of its bios");
+         return;
+      }
+      /* the buffers of the commands do not touch, each is a segment */
+      bio_for_each_segment(bvec, bio, i) {
+         if (sg == c->Header.SGList ||
+             (c->SG[sg].Addr.lower | (u64) c->SG[sg].Addr.upper << 32) !=
+                bvec->addr ||
+             c->SG[sg].Len != bvec->bv_len) {
+            fail_run("SG list does not match the bios");
+            return;
+         }
+         sg++;
+      }
+      sector += llb->numSectors;
+      segs += bio->bi_phys_segments;
+      llb = llb->next;
+   }
+   if (llb != NULL || sector != rq->sector + rq->nr_sectors ||
+       segs != rq->nr_phys_segments || sg != c->Header.SGList) {
+      fail_run("request sectors do not match its bios");
+   }
+}
+
+/* access.submit_command() */
+static void
+sim_submit_command(ctlr_info_t *h, CommandList_struct *c)
+{
+   struct request *rq = c->rq;
+   LinuxBlockBuffer *llb;
+
+   VMK_ASSERT(h == &ctlr && c->cmdindex >= 0 && c->cmdindex < NR_CMDS);
+   check_request(c);
+
+   for (llb = rq->bio->bi_private; llb != NULL; llb = llb->next) {
+      container_of(llb->cmd, struct sim_cmd, vmkCmd)->dispatched = now;
+   }
+   sim.doneAt[c->cmdindex] = now + REQ_COST_US +
+                             rq->nr_sectors * SECTOR_COST_US +
+                             rand_r(&sim.seed) % REQ_COST_US;
+   sim.startedSectors[c->cmdindex] = rq->nr_sectors;
+   sim.requests++;
+   sim.sectors += rq->nr_sectors;
+}
+
+static unsigned long
+sim_fifo_full(ctlr_info_t *h)
+{
+   (void) h;
+   return 0;
+}
+
+/* the command the controller completes next */
+static CommandList_struct *
+next_completion(void)
+{
+   CommandList_struct *c = ctlr.cmpQ, *first = NULL;
+
+   if (c == NULL) {
+      return NULL;
+   }
+   do {
+      if (first == NULL ||
+          sim.doneAt[c->cmdindex] < sim.doneAt[first->cmdindex]) {
+         first = c;
+      }
+      c = c->next;
+   } while (c != ctlr.cmpQ);
+   return first;
+}
+
+/* the interrupt of do_cciss_intr() for c, and the BH it schedules */
+static void
+complete_next(CommandList_struct *c)
+{
+   unsigned long flags;
+
+   now = sim.doneAt[c->cmdindex];
+   if (c->rq->nr_sectors != sim.startedSectors[c->cmdindex]) {
+      fail_run("request changed after the driver took it");
+   }
+
+   spin_lock_irqsave(&ctlr.lock, flags);
+   removeQ(&ctlr.cmpQ, c);
+   complete_command(&ctlr, c, 0);
+   spin_unlock_irqrestore(&ctlr.lock, flags);
+
+   while (bhScheduled) {
+      bhScheduled = 0;
+      LinuxBlockBH(NULL);
+   }
+}
+
+static void
+setup(void)
+{
+   static const struct access_method access = {
+      .submit_command = sim_submit_command,
+      .fifo_full = sim_fifo_full,
+   };
+
+   memset(&ctlr, 0, sizeof(ctlr));
+   memset(cmdPoolBits, 0, sizeof(cmdPoolBits));
+   ctlr.nr_cmds = NR_CMDS;
+   ctlr.cmd_pool = cmdPool;
+   ctlr.errinfo_pool = errinfoPool;
+   ctlr.cmd_pool_bits = cmdPoolBits;
+   ctlr.access = access;
+   ctlr.drv[0].queue = &queue;
+   ctlr.drv[0].heads = 255;
+   ctlr.gendisk[0] = &disk;
+   spin_lock_init(&ctlr.lock);
+   hba[0] = &ctlr;
+
+   /* what cciss_init_one() and blk_init_queue() set up */
+   memset(&queue, 0, sizeof(queue));
+   INIT_LIST_HEAD(&queue.queue_head);
+   queue.request_fn = do_cciss_request;
+   queue.softirq_done_fn = cciss_softirq_done;
+   queue.queuedata = &ctlr;
+   queue.queue_lock = &ctlr.lock;
+   queue.queue_flags = 1 << QUEUE_FLAG_CLUSTER;
+   queue.max_sectors = MAX_SECTORS;
+   queue.max_phys_segments = MAXSGENTRIES;
+   queue.max_hw_segments = MAXSGENTRIES;
+   queue.max_segment_size = 65536;
+   queue.seg_boundary_mask = 0xffffffff;
+   queue.unplug_thresh = vmklnx_block_unplug_thresh;
+
+   disk.major = COMPAQ_CISS_MAJOR;
+   disk.queue = &queue;
+   disk.private_data = &ctlr.drv[0];
+   blockDevices[COMPAQ_CISS_MAJOR] = &blkAdapter;
+   INIT_LIST_HEAD(&linuxBHCompletionList);
+
+   memset(&sim, 0, sizeof(sim));
+   sim.seed = 1;
+   memset(&heap, 0, sizeof(heap));
+   now = 0;
+}
+
+enum { SEQ, REVERSE, RANDOM, MIXED };
+
+struct workload {
+   const char *name;
+   int pattern;
+   unsigned int ios;
+   unsigned int ioSectors;
+   unsigned int gapUs;          /* between arrivals */
+   int merge;
+   int expectMerged;            /* percent of bios at least, or -1 */
+   int expectMergedMax;         /* percent of bios at most */
+};
+
+static const struct workload workloads[] = {
+   { "sequential",         SEQ,     MAX_IOS,  8,  5, 1, 50, 100 },
+   { "sequential 32K",     SEQ,     MAX_IOS,  64, 20, 1, 20, 100 },
+   { "sequential 64K",     SEQ,     MAX_IOS, 128, 30, 1, -1, 0 },
+   { "reverse sequential", REVERSE, MAX_IOS,  8,  5, 1, 50, 100 },
+   { "random",             RANDOM,  MAX_IOS,  8, 10, 1, -1, 1 },
+   { "mixed",              MIXED,   MAX_IOS,  8,  5, 1, 20, 100 },
+   { "sequential idle",    SEQ,     2000,     8, 500, 1, -1, 0 },
+   /* more than the controller can take unmerged */
+   { "sequential nomerge", SEQ,     MAX_IOS,  8,  5, 0, -1, 0 },
+};
+
+static struct sim_cmd cmds[MAX_IOS];
+
+/* the SG array of command i, one 4K page apart from the next */
+static vmk_SgArray *
+make_sg_array(unsigned int i, unsigned int sectors)
+{
+   unsigned int n = sectors * SECTOR_SIZE / PAGE_SIZE, k;
+   vmk_SgArray *sga = malloc(sizeof(*sga) + n * sizeof(sga->elem[0]));
+
+   sga->maxElems = sga->nbElems = n;
+   for (k = 0; k < n; k++) {
+      sga->elem[k].addr = ((vmk_MachAddr) (i + 1) << 20) + 2 * k * PAGE_SIZE;
+      sga->elem[k].length = PAGE_SIZE;
+   }
+   return sga;
+}
+
+static void
+run(const struct workload *w)
+{
+   unsigned int seqSector = 1 << 20, revSector = 1 << 22;
+   unsigned int seed = 1;
+   unsigned long nextArrival = 0, waitSum = 0, merged;
+   unsigned int issued = 0, i;
+
+   curWorkload = w->name;
+   setup();
+   vmklnx_block_merge = w->merge;
+   memset(cmds, 0, sizeof(cmds));
+
+   while (issued < w->ios || queue.nr_pending > 0) {
+      CommandList_struct *done = next_completion();
+
+      if (done != NULL &&
+          (issued == w->ios || sim.doneAt[done->cmdindex] <= nextArrival)) {
+         complete_next(done);
+      } else if (issued < w->ios) {
+         struct sim_cmd *sc = &cmds[issued];
+         unsigned int sector;
+         int pattern = w->pattern;
+
+         if (pattern == MIXED) {
+            pattern = (rand_r(&seed) % 3 == 0) ? RANDOM : SEQ;
+         }
+         switch (pattern) {
+         case SEQ:
+            sector = seqSector;
+            seqSector += w->ioSectors;
+            break;
+         case REVERSE:
+            revSector -= w->ioSectors;
+            sector = revSector;
+            break;
+         default:
+            sector = (rand_r(&seed) % (1 << 24)) & ~(w->ioSectors - 1);
+            break;
+         }
+
+         now = nextArrival;
+         sc->arrival = now;
+         sc->foundIdle = queue.nr_pending <= queue.nr_sorted;
+         sc->vmkCmd.done = sim_done;
+         sc->vmkCmd.sgArray = make_sg_array(issued, w->ioSectors);
+         sc->vmkCmd.requiredDataLen = w->ioSectors * SECTOR_SIZE;
+         if (LinuxBlockIssueCmd(&blkAdapter, &sc->vmkCmd, &blkDisk, sector,
+                                w->ioSectors,
+                                w->pattern == MIXED ? 1 : (issued & 16) != 0)
+             != VMK_OK) {
+            fail_run("command not issued");
+         }
+         issued++;
+         nextArrival = now + w->gapUs;
+      } else {
+         fail_run("commands pending with nothing in the driver");
+         break;
+      }
+
+      if (queue.nr_sorted > 0 && queue.nr_pending == queue.nr_sorted) {
+         fail_run("requests held on the queue of an idle device");
+      }
+      if (blk_queue_plugged(&queue) && !blk_queue_stopped(&queue) &&
+          queue.nr_pending > queue.nr_sorted &&
+          queue.nr_sorted > (unsigned int) queue.unplug_thresh) {
+         fail_run("busy queue holds more than unplug_thresh requests");
+      }
+   }
+
+   for (i = 0; i < w->ios; i++) {
+      if (cmds[i].completed != 1) {
+         fail_run("command not completed exactly once");
+         break;
+      }
+      if (cmds[i].vmkCmd.bytesXferred != w->ioSectors * SECTOR_SIZE) {
+         fail_run("command completed with the wrong byte count");
+         break;
+      }
+      if (cmds[i].foundIdle && cmds[i].dispatched != cmds[i].arrival) {
+         fail_run("command found the device idle and had to wait");
+         break;
+      }
+      waitSum += cmds[i].dispatched - cmds[i].arrival;
+   }
+   for (i = 0; i < w->ios; i++) {
+      free(cmds[i].vmkCmd.sgArray);
+   }
+   if (queue.nr_sorted != 0 || queue.nr_pending != 0) {
+      fail_run("requests left on the queue");
+   }
+   if (heap.allocs != heap.frees) {
+      fail_run("%lu allocations not freed", heap.allocs - heap.frees);
+   }
+
+   merged = queue.nr_back_merges + queue.nr_front_merges;
+   printf("%-19s %6lu bios %6lu reqs %5.1f sect/req  merged %5.1f%% "
+          "(back %lu front %lu)  unplugs idle %lu thresh %lu done %lu  "
+          "wait %.1fus\n",
+          w->name, queue.nr_bios, sim.requests,
+          (double) sim.sectors / sim.requests,
+          100.0 * merged / queue.nr_bios,
+          queue.nr_back_merges, queue.nr_front_merges, queue.nr_unplug_idle,
+          queue.nr_unplug_thresh, queue.nr_unplug_done,
+          (double) waitSum / w->ios);
+
+   if (w->expectMerged >= 0 &&
+       merged * 100 < (unsigned long) w->expectMerged * queue.nr_bios) {
+      fail_run("too few bios merged");
+   }
+   if (merged * 100 > (unsigned long) w->expectMergedMax * queue.nr_bios) {
+      fail_run("too many bios merged");
+   }
+   if (w->pattern == REVERSE && queue.nr_front_merges == 0) {
+      fail_run("no front merges of a reverse stream");
+   }
+   if (sim.requests + merged != queue.nr_bios) {
+      fail_run("requests and merges do not add up to the bios");
+   }
+}
+
+int
+main(void)
+{
+   unsigned int i;
+
+   for (i = 0; i < ARRAY_SIZE(workloads); i++) {
+      run(&workloads[i]);
+   }
+
+   if (failures) {
+      fprintf(stderr, "blk_merge: %d failures\n", failures);
+      return 1;
+   }
+   printf("blk_merge: ok\n");
+   return 0;
+}
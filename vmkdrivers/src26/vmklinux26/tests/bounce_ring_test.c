@@ -0,0 +1,412 @@
+/*
+ * bounce_ring_test.c --
+ *
+ *    Test of the high dma tx bounce ring of vmware/linux_net.c as it
+ *    ships: netdev_bounce_ring_create, netdev_bounce_ring_destroy,
+ *    netdev_bounce_get and vmklnx_netdev_high_dma_workaround.
+ *
+ *    A driver with a tx ring of TX_RING descriptors sends random frames,
+ *    linear or with page frags, through the workaround and completes them
+ *    in order, a random number at a time; a second run completes out of
+ *    order. Some of the buffers the allocator hands out lie above the
+ *    device's dma mask.
+ *
+ *    The test fails if
+ *    - a ring keeps a slot above the dma mask, or a ring that can't be
+ *      filled below it is not given up without leaking its skbs;
+ *    - a slot still held by the driver is handed out again;
+ *    - the frame the driver sees differs from the original, or its
+ *      mac/network/transport header offsets moved;
+ *    - a frame that fits is copied with skb_copy while the slot at the
+ *      ring's next position is free, or one that doesn't fit is put in a
+ *      slot;
+ *    - the original packet is not released, or the counters don't add up
+ *      to the frames sent;
+ *    - the ring's reference on a slot is dropped before the ring is
+ *      destroyed, or not dropped when it is.
+ *
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/linux/skbuff.h: MAX_SKB_FRAGS skb_frag_t struct skb_frag_struct struct skb_shared_info struct sk_buff skb_shinfo skb_get skb_is_nonlinear SKB_LINEAR_ASSERT skb_put NET_SKB_PAD
+ * extract ../vmware/linux_net.c: struct netdev_bounce_ring netdev_bounce_ring_create netdev_bounce_ring_destroy netdev_bounce_get vmklnx_netdev_high_dma_workaround
+ */
+
+#include "stubs.h"
+
+#define NSLOTS          64
+#define SLOT_SIZE       1518
+#define TX_RING         256
+#define FRAMES          200000
+#define MAX_FRAGS       4
+#define FRAG_MAX        4096
+#define DMA_MASK        0xffffffffULL
+
+typedef unsigned int gfp_t;
+
+#define GFP_KERNEL      0
+#define GFP_ATOMIC      1
+
+struct page;
+struct kmem_cache_s;
+struct netdev_bounce_ring;
+
+struct netdev_queue {
+   struct netdev_bounce_ring *bounce_ring;
+};
+
+struct net_device {
+   unsigned int num_tx_queues;
+   struct netdev_queue *_tx;
+};
+
+/* what the extracted code calls, defined below */
+static void *kzalloc(size_t size, gfp_t flags);
+static void kfree(const void *p);
+static struct sk_buff *vmklnx_net_alloc_skb(struct kmem_cache_s *cache,
+                                            unsigned int size);
+static VMK_ReturnStatus vmk_PktFragGet(vmk_PktHandle *pkt, vmk_PktFrag *frag,
+                                       vmk_uint16 entry);
+static void vmk_PktRelease(vmk_PktHandle *pkt);
+static void kfree_skb(struct sk_buff *skb);
+static struct sk_buff *skb_copy(const struct sk_buff *skb, gfp_t gfp);
+static int skb_copy_bits(const struct sk_buff *skb, int offset, void *to,
+                         int len);
+static void skb_over_panic(struct sk_buff *skb, int len, void *here);
+
+#define current_text_addr()     NULL
+#define page_address(page)      ((void *) (page))
+
+#include "bounce_ring_test.inc"
+
+/*
+ * What the skbs of the test carry besides the sk_buff: its packet, with
+ * the machine address vmk_PktFragGet() reports, and whether the skb is a
+ * ring slot.
+ */
+struct test_skb {
+   struct sk_buff skb;
+   struct skb_shared_info shinfo;      /* skb_shinfo() */
+   vmk_PktHandle pkt;
+   vmk_MachAddr addr;
+   int isSlot;
+};
+
+#define TS(s)           container_of(s, struct test_skb, skb)
+
+static unsigned int seed = 1;
+static int highPercent;         /* of the buffers above DMA_MASK */
+static int ringsDestroyed;
+static u64 allocated, freed, copies, released;
+
+static void *
+kzalloc(size_t size, gfp_t flags)
+{
+   (void) flags;
+   return calloc(1, size);
+}
+
+static void
+kfree(const void *p)
+{
+   free((void *) p);
+}
+
+static struct sk_buff *
+test_skb_alloc(unsigned int size)
+{
+   struct test_skb *ts = calloc(1, sizeof(*ts));
+   struct sk_buff *skb = &ts->skb;
+
+   skb->head = malloc(size);
+   skb->data = skb->tail = skb->head;
+   skb->end = skb->head + size;
+   skb->pkt = &ts->pkt;
+   atomic_set(&skb->users, 1);
+   ts->addr = (rand_r(&seed) % 100 < highPercent ? DMA_MASK + 1 : 0) +
+              (rand_r(&seed) % 0x10000) * 0x1000;
+   allocated++;
+   return skb;
+}
+
+/* the vmk_PktAlloc() buffer of the skb, from the heap the test chooses */
+static struct sk_buff *
+vmklnx_net_alloc_skb(kmem_cache_t *cache, unsigned int size)
+{
+   struct sk_buff *skb = test_skb_alloc(size);
+
+   (void) cache;
+   TS(skb)->isSlot = 1;
+   return skb;
+}
+
+static VMK_ReturnStatus
+vmk_PktFragGet(vmk_PktHandle *pkt, vmk_PktFrag *frag, vmk_uint16 entry)
+{
+   struct test_skb *ts = container_of(pkt, struct test_skb, pkt);
+
+   VMK_ASSERT(entry == 0);
+   frag->addr = ts->addr;
+   frag->length = ts->skb.end - ts->skb.head;
+   return VMK_OK;
+}
+
+static void
+vmk_PktRelease(vmk_PktHandle *pkt)
+{
+   (void) pkt;
+   released++;
+}
+
+static void
+kfree_skb(struct sk_buff *skb)
+{
+   struct test_skb *ts = TS(skb);
+
+   if (!atomic_dec_and_test(&skb->users)) {
+      return;
+   }
+   if (ts->isSlot && !ringsDestroyed && ts->addr + SLOT_SIZE <= DMA_MASK) {
+      fail("ring reference on a slot dropped");
+   }
+   free(skb->head);
+   freed++;
+   free(ts);
+}
+
+/* skb_copy_bits() over the linear part and the frags */
+static int
+skb_copy_bits(const struct sk_buff *skb, int offset, void *to, int len)
+{
+   unsigned int headLen = skb->len - skb->data_len, i;
+   unsigned char *p = to;
+
+   VMK_ASSERT(offset == 0 && len == (int) skb->len);
+   memcpy(p, skb->data, headLen);
+   p += headLen;
+   for (i = 0; i < skb_shinfo(skb)->nr_frags; i++) {
+      const skb_frag_t *f = &skb_shinfo(skb)->frags[i];
+
+      memcpy(p, (unsigned char *) page_address(f->page) + f->page_offset,
+             f->size);
+      p += f->size;
+   }
+   return 0;
+}
+
+/* skb_copy(): a linear copy with the header offsets kept */
+static struct sk_buff *
+skb_copy(const struct sk_buff *base, gfp_t gfp)
+{
+   struct sk_buff *skb = test_skb_alloc(base->len);
+   long offset = skb->head - base->data;
+
+   (void) gfp;
+   skb_put(skb, base->len);
+   skb_copy_bits(base, 0, skb->data, base->len);
+   skb->h.raw = base->h.raw + offset;
+   skb->nh.raw = base->nh.raw + offset;
+   skb->mac.raw = base->mac.raw + offset;
+   copies++;
+   return skb;
+}
+
+static void
+skb_over_panic(struct sk_buff *skb, int len, void *here)
+{
+   (void) skb;
+   (void) here;
+   fail("skb_put() of %d bytes overruns the buffer", len);
+}
+
+static unsigned char fragPages[MAX_FRAGS][FRAG_MAX];
+
+/* a random frame: a linear header part, maybe followed by page frags */
+static struct sk_buff *
+make_frame(struct net_device *dev, unsigned char *flat)
+{
+   struct sk_buff *base = test_skb_alloc(64 + 214);
+   unsigned int i, j, len, n;
+
+   base->dev = dev;
+   base->data = base->tail = base->head + rand_r(&seed) % 64;
+   skb_put(base, 14 + rand_r(&seed) % 200);
+   for (i = 0; i < base->len; i++) {
+      base->data[i] = rand_r(&seed);
+   }
+   n = rand_r(&seed) % 3 == 0 ? 1 + rand_r(&seed) % MAX_FRAGS : 0;
+   for (i = 0; i < n; i++) {
+      skb_frag_t *f = &skb_shinfo(base)->frags[i];
+
+      len = 1 + rand_r(&seed) % (rand_r(&seed) % 8 ? 400 : FRAG_MAX - 16);
+      f->page = (struct page *) fragPages[i];
+      f->page_offset = rand_r(&seed) % (FRAG_MAX - len);
+      f->size = len;
+      for (j = 0; j < len; j++) {
+         fragPages[i][f->page_offset + j] = rand_r(&seed);
+      }
+      base->len += len;
+      base->data_len += len;
+   }
+   skb_shinfo(base)->nr_frags = n;
+   base->mac.raw = base->data;
+   base->nh.raw = base->data + 14;
+   base->h.raw = base->data + 14 + 20;
+   skb_copy_bits(base, 0, flat, base->len);
+   return base;
+}
+
+static void
+run(int outOfOrder)
+{
+   struct netdev_queue txq;
+   struct net_device dev = { 1, &txq };
+   struct netdev_bounce_ring *ring;
+   struct sk_buff *txRing[TX_RING], *base, *skb, *slot;
+   unsigned char flat[SLOT_SIZE + FRAG_MAX * MAX_FRAGS];
+   unsigned int head = 0, tail = 0, i, n, len;
+   unsigned int nextBefore;
+   int slotFree;
+   u64 oversizedWant = 0, fallbackWant = 0, copiesBefore;
+
+   /* a third of the buffers above the mask: those are passed over */
+   highPercent = 33;
+   ring = netdev_bounce_ring_create(NSLOTS, SLOT_SIZE, DMA_MASK);
+   highPercent = 0;
+   if (ring == NULL || ring->nSlots != NSLOTS) {
+      fail("no ring of %u slots", NSLOTS);
+      return;
+   }
+   for (i = 0; i < NSLOTS; i++) {
+      if (TS(ring->slots[i])->addr + NET_SKB_PAD + SLOT_SIZE - 1 > DMA_MASK) {
+         fail("slot %u above the dma mask", i);
+      }
+   }
+   txq.bounce_ring = ring;
+   ringsDestroyed = 0;
+   copies = released = 0;
+
+   for (i = 0; i < FRAMES; i++) {
+      if (head - tail == TX_RING) {
+         /* the driver's ring is full: complete one */
+         kfree_skb(txRing[tail++ % TX_RING]);
+      }
+
+      base = make_frame(&dev, flat);
+      len = base->len;
+      nextBefore = ring->next;
+      slot = ring->slots[nextBefore];
+      slotFree = atomic_read(&slot->users) == 1;
+      copiesBefore = copies;
+
+      skb = vmklnx_netdev_high_dma_workaround(base);
+
+      if (TS(skb)->isSlot) {
+         if (atomic_read(&skb->users) != 2) {
+            fail("slot handed out with %d users",
+                 atomic_read(&skb->users));
+         }
+         if (len > SLOT_SIZE || skb != slot) {
+            fail("frame of %u bytes in the wrong slot", len);
+         }
+      } else if (len > SLOT_SIZE) {
+         oversizedWant++;
+      } else {
+         fallbackWant++;
+         if (slotFree) {
+            fail("copied although slot %u was free", nextBefore);
+         }
+      }
+      if (copies != copiesBefore + !TS(skb)->isSlot) {
+         fail("frame %u copied %llu times", i,
+              (unsigned long long) (copies - copiesBefore));
+      }
+      if (skb->len != len || skb_is_nonlinear(skb) ||
+          memcmp(skb->data, flat, len) ||
+          skb->mac.raw != skb->data || skb->nh.raw != skb->data + 14 ||
+          skb->h.raw != skb->data + 14 + 20) {
+         fail("frame %u differs from the original", i);
+      }
+      /* the workaround released the packet; the skb is the caller's */
+      kfree_skb(base);
+      if (failures > 16) {
+         break;
+      }
+
+      txRing[head++ % TX_RING] = skb;
+
+      /* tx completion */
+      n = rand_r(&seed) % 3;
+      while (n-- && head != tail) {
+         if (outOfOrder && head - tail > 1 && rand_r(&seed) % 2) {
+            /* complete the second oldest first */
+            unsigned int k = (tail + 1) % TX_RING;
+            struct sk_buff *t = txRing[k];
+
+            txRing[k] = txRing[tail % TX_RING];
+            kfree_skb(t);
+            tail++;
+         } else {
+            kfree_skb(txRing[tail++ % TX_RING]);
+         }
+      }
+   }
+
+   if (ring->bounced + copies != i || released != i ||
+       ring->oversized != oversizedWant ||
+       copies != oversizedWant + fallbackWant ||
+       ring->exhausted != fallbackWant) {
+      fail("counters: bounced %llu copies %llu oversized %llu exhausted "
+           "%llu released %llu of %u frames",
+           (unsigned long long) ring->bounced, (unsigned long long) copies,
+           (unsigned long long) ring->oversized,
+           (unsigned long long) ring->exhausted,
+           (unsigned long long) released, i);
+   }
+   printf("%s completion: %llu bounced, %llu exhausted, %llu oversized\n",
+          outOfOrder ? "out of order" : "in order",
+          (unsigned long long) ring->bounced,
+          (unsigned long long) ring->exhausted,
+          (unsigned long long) ring->oversized);
+
+   /* the device goes away with frames still in flight */
+   for (i = 0; i < NSLOTS; i++) {
+      slot = ring->slots[i];
+      if (atomic_read(&slot->users) < 1 || atomic_read(&slot->users) > 2) {
+         fail("slot %u with %d users", i, atomic_read(&slot->users));
+      }
+   }
+   ringsDestroyed = 1;
+   netdev_bounce_ring_destroy(ring);
+   while (head != tail) {
+      skb = txRing[tail++ % TX_RING];
+      if (atomic_read(&skb->users) != 1) {
+         fail("frame in flight with %d users once the ring is gone",
+              atomic_read(&skb->users));
+         break;
+      }
+      kfree_skb(skb);
+   }
+}
+
+int
+main(void)
+{
+   run(0);
+   run(1);
+
+   /* no ring if the buffers can't be had below the mask, and no leak */
+   highPercent = 100;
+   if (netdev_bounce_ring_create(NSLOTS, SLOT_SIZE, DMA_MASK) != NULL) {
+      fail("ring with slots above the dma mask");
+   }
+   if (allocated != freed) {
+      fail("%llu skbs allocated, %llu freed", (unsigned long long) allocated,
+           (unsigned long long) freed);
+   }
+
+   if (failures) {
+      fprintf(stderr, "bounce_ring_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("bounce_ring_test: ok\n");
+   return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * crc32_test.c --
+ *
+ *    Correctness test of crc32_le() and crc32_le_copy() of
+ *    linux/lib/crc32.c, with the slice-by-8 tables crc32_init() builds.
+ *
+ *    They are checked against a bit at a time reference over every length
+ *    up to 4K at every source and destination alignment modulo 16, random
+ *    lengths up to 64K, incremental computation over split buffers, and
+ *    the check value of the IEEE 802.3 CRC. crc32_le_copy() also has to
+ *    copy exactly, without writing outside the destination.
+ *
+ * extract ../linux/lib/crc32.c: CRC32_POLY_LE crc32_table crc32_le_sb8 crc32_le crc32_le_copy crc32_init
+ */
+
+#include "stubs.h"
+#include "crc32_test.inc"
+
+#define BUF_LEN         (64 * 1024)
+#define PAD             64
+
+static unsigned char src[BUF_LEN + PAD] __attribute__((aligned(64)));
+static unsigned char dst[BUF_LEN + PAD] __attribute__((aligned(64)));
+
+/* the definition: one bit at a time */
+static u32
+crc32_le_ref(u32 crc, unsigned char const *p, size_t len)
+{
+   int i;
+
+   while (len--) {
+      crc ^= *p++;
+      for (i = 0; i < 8; i++) {
+         crc = (crc >> 1) ^ ((crc & 1) ? CRC32_POLY_LE : 0);
+      }
+   }
+   return crc;
+}
+
+static void
+check(size_t off, size_t doff, size_t len, u32 seed)
+{
+   u32 want = crc32_le_ref(seed, src + off, len);
+   u32 got = crc32_le(seed, src + off, len);
+
+   if (got != want) {
+      fail("crc32_le(off %zu, len %zu): %08x, want %08x", off, len, got,
+           want);
+   }
+
+   memset(dst, 0xa5, sizeof(dst));
+   got = crc32_le_copy(seed, dst + doff, src + off, len);
+   if (got != want || memcmp(dst + doff, src + off, len) != 0 ||
+       dst[doff + len] != 0xa5 || (doff && dst[doff - 1] != 0xa5)) {
+      fail("crc32_le_copy(off %zu, doff %zu, len %zu): %08x, want %08x, "
+           "or bad copy", off, doff, len, got, want);
+   }
+}
+
+int
+main(void)
+{
+   unsigned int seed = 1;
+   size_t i, off, len;
+
+   crc32_init();
+   for (i = 0; i < sizeof(src); i++) {
+      src[i] = rand_r(&seed);
+   }
+
+   /* standard check value: CRC-32 of "123456789" */
+   if ((crc32_le(~0U, (unsigned char const *) "123456789", 9) ^ ~0U) !=
+       0xcbf43926) {
+      fail("check value mismatch");
+   }
+
+   for (len = 0; len <= 4096 && failures < 16; len++) {
+      for (off = 0; off < 16; off++) {
+         check(off, (off * 7 + len) & 15, len, ~0U);
+      }
+   }
+
+   for (i = 0; i < 2000 && failures < 16; i++) {
+      off = rand_r(&seed) % PAD;
+      len = rand_r(&seed) % (BUF_LEN + 1);
+      check(off, rand_r(&seed) % PAD, len, rand_r(&seed));
+   }
+
+   /* incremental: crc of a buffer split anywhere is the crc of the whole */
+   for (i = 0; i < 2000 && failures < 16; i++) {
+      size_t split;
+      u32 whole, part;
+
+      len = rand_r(&seed) % BUF_LEN;
+      split = len ? rand_r(&seed) % len : 0;
+      whole = crc32_le(~0U, src, len);
+      part = crc32_le(crc32_le(~0U, src, split), src + split, len - split);
+      if (whole != part) {
+         fail("split crc (len %zu at %zu): %08x, want %08x", len, split,
+              part, whole);
+      }
+   }
+
+   if (failures) {
+      fprintf(stderr, "crc32_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("crc32_test: ok\n");
+   return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ * csum_bench.c --
+ *
+ *    Benchmark of the checksum routines of
+ *    linux/arch/x86_64/lib/csum-partial.c.
+ *
+ *    For each size it reports csum_partial() alone, a memcpy() followed by
+ *    csum_partial() (what skb_copy_and_csum_dev() would otherwise do) and
+ *    the fused csum_partial_copy_generic(), at an aligned and an odd
+ *    source offset.
+ *
+ *    usage: csum_bench [megabytes per size]
+ *
+ * extract ../../../../bora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/asm/checksum.h: add32_with_carry
+ * extract ../linux/arch/x86_64/lib/csum-partial.c: __force_inline from32to16 do_csum csum_partial do_csum_copy csum_partial_copy_generic
+ */
+
+#include <time.h>
+
+#include "stubs.h"
+#include "csum_bench.inc"
+
+static unsigned char src[64 * 1024 + 64] __attribute__((aligned(64)));
+static unsigned char dst[64 * 1024 + 64] __attribute__((aligned(64)));
+static volatile unsigned sink;
+
+/* called through these, as drivers call them, not inlined into the loop */
+static unsigned (*volatile csum)(const unsigned char *, unsigned, unsigned) =
+   csum_partial;
+static unsigned long (*volatile csum_copy)(const unsigned char *,
+                                           const unsigned char *, unsigned,
+                                           unsigned, int *, int *) =
+   csum_partial_copy_generic;
+
+static double
+now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+enum { CSUM, COPY_THEN_CSUM, FUSED };
+
+static double
+run(int what, size_t len, size_t off, size_t total)
+{
+   size_t iters = total / len, i;
+   unsigned sum = 0;
+   double t;
+
+   t = now();
+   for (i = 0; i < iters; i++) {
+      switch (what) {
+      case CSUM:
+         sum = csum(src + off, len, sum);
+         break;
+      case COPY_THEN_CSUM:
+         memcpy(dst, src + off, len);
+         asm volatile("" : : : "memory");
+         sum = csum(dst, len, sum);
+         break;
+      default:
+         sum = csum_copy(src + off, dst, len, sum, NULL, NULL);
+         break;
+      }
+   }
+   t = now() - t;
+   sink = sum;
+   return (double) iters * len / t / 1e6;
+}
+
+int
+main(int argc, char **argv)
+{
+   static const size_t sizes[] = { 20, 64, 576, 1500, 4096, 9000, 65536 };
+   size_t total = (argc > 1 ? strtoul(argv[1], NULL, 0) : 512) << 20;
+   unsigned int seed = 1;
+   size_t i, off;
+
+   for (i = 0; i < sizeof(src); i++) {
+      src[i] = rand_r(&seed);
+   }
+
+   printf("%8s %5s %14s %14s %14s\n", "size", "align", "csum",
+          "memcpy+csum", "fused copy");
+   for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+      for (off = 0; off <= 1; off++) {
+         printf("%8zu %5zu %10.0fMB/s %10.0fMB/s %10.0fMB/s\n", sizes[i],
+                off, run(CSUM, sizes[i], off, total),
+                run(COPY_THEN_CSUM, sizes[i], off, total),
+                run(FUSED, sizes[i], off, total));
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * csum_test.c --
+ *
+ *    Fuzz test of csum_partial() and csum_partial_copy_generic() of
+ *    linux/arch/x86_64/lib/csum-partial.c.
+ *
+ *    Their folded results are compared against a scalar reference for
+ *    every length from 0 to 64K at every source alignment modulo 8, with
+ *    several initial sums, and the copy is checked for exactness and for
+ *    not writing outside the destination. The reference is computed in
+ *    O(1) per buffer from prefix sums of the even and odd bytes, which
+ *    keeps the exhaustive sweep fast.
+ *
+ * extract ../../../../bora/build/scons/build/HEADERS/vmkdrivers-asm-x64/vmkernel64/release/asm/checksum.h: csum_fold add32_with_carry
+ * extract ../linux/arch/x86_64/lib/csum-partial.c: __force_inline from32to16 do_csum csum_partial do_csum_copy csum_partial_copy_generic
+ */
+
+#include "stubs.h"
+#include "csum_test.inc"
+
+#define BUF_LEN         (64 * 1024)
+#define ALIGNS          8
+#define GUARD           64
+
+static unsigned char src[BUF_LEN + 2 * GUARD] __attribute__((aligned(64)));
+static unsigned char dst[BUF_LEN + 2 * GUARD] __attribute__((aligned(64)));
+
+/* pre[p][i]: sum of src[j], j < i, j % 2 == p */
+static u64 pre[2][BUF_LEN + 2 * GUARD + 1];
+
+/* fold a 32 or 64 bit ones' complement sum to 16 bits, not inverted */
+static unsigned
+fold16(u64 sum)
+{
+   while (sum >> 16) {
+      sum = (sum & 0xffff) + (sum >> 16);
+   }
+   return sum;
+}
+
+/*
+ * The 16-bit little endian words starting at off: bytes at an even
+ * distance from off are low bytes, the others high bytes.
+ */
+static unsigned
+ref_csum(size_t off, size_t len)
+{
+   int p = off & 1;
+   u64 lo = pre[p][off + len] - pre[p][off];
+   u64 hi = pre[!p][off + len] - pre[!p][off];
+
+   return fold16(lo + (hi << 8));
+}
+
+int
+main(void)
+{
+   static const unsigned sums[] = { 0, 0xffff, 0x12345678, 0xffffffff };
+   unsigned int seed = 1;
+   size_t i, off, len;
+
+   for (i = 0; i < sizeof(src); i++) {
+      src[i] = rand_r(&seed);
+   }
+   /* runs of 0xff make the carries interesting */
+   memset(src + 4096, 0xff, 8192);
+   for (i = 0; i < sizeof(src); i++) {
+      pre[0][i + 1] = pre[0][i] + (i % 2 == 0 ? src[i] : 0);
+      pre[1][i + 1] = pre[1][i] + (i % 2 == 1 ? src[i] : 0);
+   }
+
+   /* the check value of RFC 1071, section 3 */
+   {
+      static const unsigned char rfc[] = {
+         0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7
+      };
+
+      if (csum_fold(csum_partial(rfc, sizeof(rfc), 0)) != (u16) ~0xf2ddU) {
+         fail("csum_partial() of the RFC 1071 example is wrong");
+      }
+   }
+
+   for (len = 0; len <= BUF_LEN && failures < 16; len++) {
+      for (off = GUARD; off < GUARD + ALIGNS; off++) {
+         unsigned want = ref_csum(off, len);
+         unsigned sum = sums[len % 4];
+         unsigned char *to = dst + GUARD + (len & 7);
+         unsigned got;
+
+         got = csum_partial(src + off, len, 0);
+         if (fold16(got) != want) {
+            fail("csum_partial(off %zu, len %zu): %04x, want %04x",
+                 off % ALIGNS, len, fold16(got), want);
+         }
+         got = csum_partial(src + off, len, sum);
+         if (fold16(got) != fold16((u64) want + sum)) {
+            fail("csum_partial(off %zu, len %zu, sum %08x): bad sum",
+                 off % ALIGNS, len, sum);
+         }
+
+         /* a sparse subset of the copies, all of them is slow */
+         if (len > 4096 && (len + off) % 61) {
+            continue;
+         }
+         memset(dst, 0x5a, len + 2 * GUARD);
+         got = csum_partial_copy_generic(src + off, to, len, sum, NULL, NULL);
+         if (fold16(got) != fold16((u64) want + sum) ||
+             memcmp(to, src + off, len) != 0 ||
+             to[-1] != 0x5a || to[len] != 0x5a) {
+            fail("csum_partial_copy_generic(off %zu, len %zu): bad sum or "
+                 "copy", off % ALIGNS, len);
+         }
+      }
+   }
+
+   if (failures) {
+      fprintf(stderr, "csum_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("csum_test: ok\n");
+   return 0;
+}
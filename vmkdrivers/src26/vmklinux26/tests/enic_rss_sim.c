@@ -0,0 +1,1054 @@
+/*
+ * enic_rss_sim.c --
+ *
+ *    Simulation of RSS and per-RQ NAPI in drivers/net/enic as it ships:
+ *    enic_set_intr_mode, enic_set_niccfg with enic_set_rsskey,
+ *    enic_set_rsscpu and enic_rss_hash_type, the resource layout helpers
+ *    of enic.h, the RQ/CQ/INTR wiring of enic_init_vnic_resources and
+ *    enic_request_intr, and enic_isr_msix_rq with enic_poll_msix on the
+ *    vmklinux NAPI scheduling of netdevice.h, against a stand-in for the
+ *    vNIC.
+ *
+ *    The stand-in takes CMD_RSS_KEY, CMD_RSS_CPU and CMD_NIC_CFG the way
+ *    the firmware does, reading the key and the indirection table from
+ *    the "DMA" buffer the driver passes, and steers received flows with
+ *    a Toeplitz hash over the fields the programmed hash types select.
+ *    A received packet completes on the CQ vnic_rq_init named for its
+ *    RQ and raises the INTR vnic_cq_init named for that CQ; the handler
+ *    enic_request_intr registered for the vector runs, and the NAPI
+ *    contexts it schedules are polled until they complete.  Buffers from
+ *    pci_alloc_consistent start out poisoned and must be freed once the
+ *    command is done.
+ *
+ *    The test fails if
+ *    - the Toeplitz stand-in disagrees with the published RSS test
+ *      vectors;
+ *    - an interrupt mode is chosen that needs more RQs, CQs or INTRs
+ *      than the vNIC has, more RQs than CPUs, more than one RQ without
+ *      RSS, or a single RQ where RSS could run on several;
+ *    - an MSI-X vector is requested other than once, a CQ raises a
+ *      vector whose NAPI context polls another CQ, or queue errors are
+ *      not raised on the error vector;
+ *    - the key or the table the firmware reads differ from the driver's,
+ *      a table entry names an RQ that does not exist, or the hash types
+ *      differ from the vNIC configuration;
+ *    - a flow is received on more than one RQ, an RQ gets no flows or
+ *      far more than its share, a packet is left on its CQ, or the
+ *      completions are credited to another vector;
+ *    - RSS stays enabled after the key or the table could not be
+ *      programmed.
+ *
+ * extract ../../include/linux/inet_lro.h: LRO_AGGR_HIST_BUCKETS struct net_lro_stats struct net_lro_desc struct net_lro_mgr LRO_DEFAULT_MAX_DESC
+ * extract ../../include/linux/netdevice.h: enum netdev_state_t struct net_device_stats NAPI_PUSH_HIST_BUCKETS struct napi_struct enum NAPI_STATE_SCHED napi_disable_pending napi_schedule_prep __napi_complete NETDEV_ALIGN NETDEV_ALIGN_CONST netdev_priv netif_carrier_ok netif_rx_schedule_prep __netif_rx_schedule netif_rx_schedule __netif_rx_complete netif_rx_complete
+ * extract ../../include/linux/timer.h: struct timer_list
+ * extract ../../include/linux/pci.h: struct msix_entry
+ * extract ../../include/linux/irqreturn.h: irqreturn_t IRQ_NONE IRQ_HANDLED
+ * extract ../../include/linux/interrupt.h: IRQF_SHARED
+ * extract ../../drivers/net/enic/kcompat.h: NETIF_F_LRO DIV_ROUND_UP
+ * extract ../../drivers/net/enic/vnic_resource.h: enum vnic_res_type
+ * extract ../../drivers/net/enic/vnic_devcmd.h: _CMD_NBITS _CMD_VTYPEBITS _CMD_FLAGSBITS _CMD_DIRBITS _CMD_NMASK _CMD_VTYPEMASK _CMD_FLAGSMASK _CMD_DIRMASK _CMD_NSHIFT _CMD_VTYPESHIFT _CMD_FLAGSSHIFT _CMD_DIRSHIFT _CMD_DIR_NONE _CMD_DIR_WRITE _CMD_DIR_READ _CMD_DIR_RW _CMD_FLAGS_NONE _CMD_FLAGS_NOWAIT _CMD_VTYPE_NONE _CMD_VTYPE_ENET _CMD_VTYPE_FC _CMD_VTYPE_SCSI _CMD_VTYPE_ALL _CMDCF _CMDC _CMDCNW enum vnic_devcmd_cmd
+ * extract ../../drivers/net/enic/vnic_dev.h: enum vnic_dev_intr_mode struct vnic_dev_bar struct vnic_dev_ring
+ * extract ../../drivers/net/enic/vnic_cq.h: struct vnic_cq_ctrl struct vnic_cq
+ * extract ../../drivers/net/enic/vnic_rq.h: struct vnic_rq_ctrl VNIC_RQ_BUF_BLK_ENTRIES VNIC_RQ_BUF_BLKS_NEEDED VNIC_RQ_BUF_BLKS_MAX struct vnic_rq_buf struct vnic_rq
+ * extract ../../drivers/net/enic/vnic_wq.h: struct vnic_wq_ctrl struct vnic_wq_buf VNIC_WQ_BUF_BLK_ENTRIES VNIC_WQ_BUF_BLKS_NEEDED VNIC_WQ_BUF_BLKS_MAX struct vnic_wq
+ * extract ../../drivers/net/enic/vnic_intr.h: struct vnic_intr_ctrl struct vnic_intr
+ * extract ../../drivers/net/enic/vnic_enet.h: struct vnic_enet_config VENETF_RSS VENETF_RSSHASH_IPV4 VENETF_RSSHASH_TCPIPV4 VENETF_RSSHASH_IPV6 VENETF_RSSHASH_TCPIPV6 VENETF_RSSHASH_IPV6_EX VENETF_RSSHASH_TCPIPV6_EX
+ * extract ../../drivers/net/enic/vnic_nic.h: NIC_CFG_RSS_DEFAULT_CPU_MASK_FIELD NIC_CFG_RSS_DEFAULT_CPU_SHIFT NIC_CFG_RSS_HASH_TYPE_MASK_FIELD NIC_CFG_RSS_HASH_TYPE_SHIFT NIC_CFG_RSS_HASH_BITS_MASK_FIELD NIC_CFG_RSS_HASH_BITS_SHIFT NIC_CFG_RSS_BASE_CPU_MASK_FIELD NIC_CFG_RSS_BASE_CPU_SHIFT NIC_CFG_RSS_ENABLE_MASK_FIELD NIC_CFG_RSS_ENABLE_SHIFT NIC_CFG_TSO_IPID_SPLIT_EN_MASK_FIELD NIC_CFG_TSO_IPID_SPLIT_EN_SHIFT NIC_CFG_IG_VLAN_STRIP_EN_MASK_FIELD NIC_CFG_IG_VLAN_STRIP_EN_SHIFT NIC_CFG_RSS_HASH_TYPE_IPV4 NIC_CFG_RSS_HASH_TYPE_TCP_IPV4 NIC_CFG_RSS_HASH_TYPE_IPV6 NIC_CFG_RSS_HASH_TYPE_TCP_IPV6 NIC_CFG_RSS_HASH_TYPE_IPV6_EX NIC_CFG_RSS_HASH_TYPE_TCP_IPV6_EX vnic_set_nic_cfg
+ * extract ../../drivers/net/enic/vnic_rss.h: union vnic_rss_key union vnic_rss_cpu
+ * extract ../../drivers/net/enic/enic_res.h: ENIC_MULTICAST_PERFECT_FILTERS ENIC_SETTING
+ * extract ../../drivers/net/enic/enic.h: ENIC_WQ_MAX ENIC_RQ_MAX ENIC_CQ_MAX ENIC_INTR_MAX ENIC_RSS_HASH_BITS ENIC_RSS_KEY_LEN ENIC_LRO_MAX_DESC enum enic_intx_intr_index struct enic_msix_entry struct enic enic_cq_rq enic_cq_wq enic_msix_rq_intr enic_msix_wq_intr enic_msix_err_intr enic_msix_notify_intr
+ * extract ../../drivers/net/enic/enic_res.c: enic_set_nic_cfg enic_set_rss_key enic_set_rss_cpu enic_get_res_counts enic_init_vnic_resources
+ * extract ../../drivers/net/enic/enic_main.c: enic_log_q_error enic_link_check enic_mtu_check enic_msglvl_check enic_notify_check ENIC_TEST_INTR enic_isr_legacy enic_isr_msi enic_isr_msix_rq enic_isr_msix_wq enic_isr_msix_err enic_isr_msix_notify enic_poll_msix enic_free_intr enic_request_intr enic_set_rsskey enic_set_rsscpu enic_rss_hash_type enic_set_niccfg enic_set_intr_mode
+ */
+
+#include <errno.h>
+
+#include "stubs.h"
+
+#define IFNAMSIZ                16
+#define ETH_ALEN                6
+#define IRQ_BASE                64
+
+struct vlan_group;
+struct vnic_dev;
+
+struct work_struct {
+   int unused;
+};
+
+struct pci_dev {
+   unsigned int irq;
+};
+
+/* cacheline aligned, so that netdev_priv() is aligned for struct enic */
+struct net_device {
+   char name[IFNAMSIZ];
+   unsigned long state;
+   unsigned long features;
+   unsigned int mtu;
+} ____cacheline_aligned;
+
+/* the vNIC, defined below */
+struct vnic_cq;
+struct vnic_rq;
+struct vnic_wq;
+struct vnic_intr;
+enum vnic_devcmd_cmd;
+enum vnic_dev_intr_mode;
+enum vnic_res_type;
+
+static int vnic_dev_cmd(struct vnic_dev *vdev, enum vnic_devcmd_cmd cmd,
+                        u64 *a0, u64 *a1, int wait);
+static unsigned int vnic_dev_get_res_count(struct vnic_dev *vdev,
+                                           enum vnic_res_type type);
+static void vnic_dev_set_intr_mode(struct vnic_dev *vdev,
+                                   enum vnic_dev_intr_mode intr_mode);
+static enum vnic_dev_intr_mode vnic_dev_get_intr_mode(struct vnic_dev *vdev);
+static void vnic_dev_stats_clear(struct vnic_dev *vdev);
+static int vnic_dev_link_status(struct vnic_dev *vdev);
+static u32 vnic_dev_mtu(struct vnic_dev *vdev);
+static u32 vnic_dev_msg_lvl(struct vnic_dev *vdev);
+static void vnic_rq_init(struct vnic_rq *rq, unsigned int cq_index,
+                         unsigned int error_interrupt_enable,
+                         unsigned int error_interrupt_offset);
+static void vnic_wq_init(struct vnic_wq *wq, unsigned int cq_index,
+                         unsigned int error_interrupt_enable,
+                         unsigned int error_interrupt_offset);
+static void vnic_cq_init(struct vnic_cq *cq, unsigned int flow_control_enable,
+                         unsigned int color_enable, unsigned int cq_head,
+                         unsigned int cq_tail, unsigned int cq_tail_color,
+                         unsigned int interrupt_enable,
+                         unsigned int cq_entry_enable,
+                         unsigned int message_enable,
+                         unsigned int interrupt_offset, u64 message_addr);
+static void vnic_intr_init(struct vnic_intr *intr,
+                           unsigned int coalescing_timer,
+                           unsigned int coalescing_type,
+                           unsigned int mask_on_assertion);
+static unsigned int vnic_rq_error_status(struct vnic_rq *rq);
+static unsigned int vnic_wq_error_status(struct vnic_wq *wq);
+static unsigned int vnic_cq_serve(struct vnic_cq *cq, unsigned int work_to_do);
+static void vnic_intr_return_credits(struct vnic_intr *intr,
+                                     unsigned int credits, int unmask,
+                                     int reset_timer);
+static void vnic_intr_return_all_credits(struct vnic_intr *intr);
+static void vnic_intr_mask(struct vnic_intr *intr);
+static void vnic_intr_unmask(struct vnic_intr *intr);
+static u32 vnic_intr_legacy_pba(u32 __iomem *legacy_pba);
+
+/* the completions stand in for the descriptor rings */
+#define vnic_cq_service(cq, work_to_do, q_service, opaque)                 \
+   vnic_cq_serve((cq), (work_to_do))
+#define vnic_rq_fill(rq, buf_fill)      ((void) (rq))
+#define lro_flush_all(lro_mgr)          ((void) (lro_mgr))
+
+/* the kernel, defined below */
+struct msix_entry;
+
+static unsigned int num_online_cpus(void);
+static int pci_enable_msix(struct pci_dev *pdev, struct msix_entry *entries,
+                           int nvec);
+static int pci_enable_msi(struct pci_dev *pdev);
+static void *pci_alloc_consistent(struct pci_dev *pdev, size_t size,
+                                  dma_addr_t *dma_handle);
+static void pci_free_consistent(struct pci_dev *pdev, size_t size,
+                                void *vaddr, dma_addr_t dma_handle);
+static int request_irq(unsigned int irq, int (*handler)(int, void *),
+                       unsigned long flags, const char *name, void *dev_id);
+static void free_irq(unsigned int irq, void *dev_id);
+static int schedule_work(struct work_struct *work);
+static void netif_carrier_on(struct net_device *dev);
+static void netif_carrier_off(struct net_device *dev);
+
+/* declared in netdevice.h */
+static void __napi_schedule(struct napi_struct *n);
+
+#include "enic_rss_sim.inc"
+
+/*
+ * The vNIC stand-in
+ */
+
+struct vnic_dev {
+   /* resources provisioned for the vNIC */
+   unsigned int res_rq, res_wq, res_cq, res_intr;
+   int msix_ok, msi_ok;
+   enum vnic_dev_intr_mode intr_mode;
+
+   /* devcmd state */
+   int fail_cmd;                /* devcmd to fail, or 0 */
+   int fail_alloc;              /* fail pci_alloc_consistent */
+   u8 key[ENIC_RSS_KEY_LEN];
+   u8 cpu[1 << ENIC_RSS_HASH_BITS];
+   int key_set, cpu_set;
+   u32 nic_cfg;
+   int nic_cfg_set;
+
+   /* what enic_init_vnic_resources programmed */
+   unsigned int rq_count;
+   unsigned int rq_cq[ENIC_RQ_MAX], rq_err_intr[ENIC_RQ_MAX];
+   unsigned int cq_intr[ENIC_CQ_MAX];
+
+   /* completions not yet serviced, and serviced */
+   unsigned int cq_pending[ENIC_CQ_MAX], cq_served[ENIC_CQ_MAX];
+   unsigned int intr_credits[ENIC_INTR_MAX];
+};
+
+/* the adapter, as alloc_etherdev lays it out */
+static struct {
+   struct net_device netdev;
+   struct enic enic;
+} dev = { .netdev = { .name = "vmnic0", .mtu = 1500 } };
+
+static struct vnic_dev vdev;
+static unsigned int online_cpus;
+
+/* what enic_request_intr registered for each MSI-X vector */
+static struct {
+   int requested;
+   int (*handler)(int, void *);
+   void *dev_id;
+} irqs[ENIC_INTR_MAX];
+
+/* the NAPI contexts scheduled and not yet polled */
+static struct napi_struct *sched[ENIC_RQ_MAX];
+static unsigned int n_sched;
+
+static int
+vnic_dev_cmd(struct vnic_dev *vd, enum vnic_devcmd_cmd cmd, u64 *a0, u64 *a1,
+             int wait)
+{
+   unsigned int i;
+
+   (void) wait;
+   if (cmd == (enum vnic_devcmd_cmd) vd->fail_cmd) {
+      return -ETIMEDOUT;
+   }
+
+   switch (cmd) {
+   case CMD_RSS_KEY: {
+      const union vnic_rss_key *k = (const void *) (unsigned long) *a0;
+
+      if (*a1 != sizeof(union vnic_rss_key)) {
+         return -EINVAL;
+      }
+      for (i = 0; i < ENIC_RSS_KEY_LEN; i++) {
+         vd->key[i] = k->key[i / 10].b[i % 10];
+      }
+      vd->key_set = 1;
+      return 0;
+   }
+   case CMD_RSS_CPU: {
+      const union vnic_rss_cpu *c = (const void *) (unsigned long) *a0;
+
+      if (*a1 != sizeof(union vnic_rss_cpu)) {
+         return -EINVAL;
+      }
+      for (i = 0; i < (1 << ENIC_RSS_HASH_BITS); i++) {
+         vd->cpu[i] = c->cpu[i / 4].b[i % 4];
+         if (vd->cpu[i] >= vd->rq_count) {
+            return -EINVAL;
+         }
+      }
+      vd->cpu_set = 1;
+      return 0;
+   }
+   case CMD_NIC_CFG:
+      vd->nic_cfg = (u32) *a0;
+      vd->nic_cfg_set = 1;
+      return 0;
+   default:
+      return -EINVAL;
+   }
+}
+
+static unsigned int
+vnic_dev_get_res_count(struct vnic_dev *vd, enum vnic_res_type type)
+{
+   switch (type) {
+   case RES_TYPE_WQ:
+      return vd->res_wq;
+   case RES_TYPE_RQ:
+      return vd->res_rq;
+   case RES_TYPE_CQ:
+      return vd->res_cq;
+   case RES_TYPE_INTR_CTRL:
+      return vd->res_intr;
+   default:
+      return 0;
+   }
+}
+
+static void
+vnic_dev_set_intr_mode(struct vnic_dev *vd, enum vnic_dev_intr_mode intr_mode)
+{
+   vd->intr_mode = intr_mode;
+}
+
+static enum vnic_dev_intr_mode
+vnic_dev_get_intr_mode(struct vnic_dev *vd)
+{
+   return vd->intr_mode;
+}
+
+static void
+vnic_dev_stats_clear(struct vnic_dev *vd)
+{
+   (void) vd;
+}
+
+static int
+vnic_dev_link_status(struct vnic_dev *vd)
+{
+   (void) vd;
+   return 1;
+}
+
+static u32
+vnic_dev_mtu(struct vnic_dev *vd)
+{
+   (void) vd;
+   return 1500;
+}
+
+static u32
+vnic_dev_msg_lvl(struct vnic_dev *vd)
+{
+   (void) vd;
+   return 0;
+}
+
+static void
+vnic_rq_init(struct vnic_rq *rq, unsigned int cq_index,
+             unsigned int error_interrupt_enable,
+             unsigned int error_interrupt_offset)
+{
+   unsigned int i = rq - dev.enic.rq;
+
+   (void) error_interrupt_enable;
+   vdev.rq_cq[i] = cq_index;
+   vdev.rq_err_intr[i] = error_interrupt_offset;
+   vdev.rq_count = max(vdev.rq_count, i + 1);
+}
+
+static void
+vnic_wq_init(struct vnic_wq *wq, unsigned int cq_index,
+             unsigned int error_interrupt_enable,
+             unsigned int error_interrupt_offset)
+{
+   (void) wq;
+   (void) cq_index;
+   (void) error_interrupt_enable;
+   (void) error_interrupt_offset;
+}
+
+static void
+vnic_cq_init(struct vnic_cq *cq, unsigned int flow_control_enable,
+             unsigned int color_enable, unsigned int cq_head,
+             unsigned int cq_tail, unsigned int cq_tail_color,
+             unsigned int interrupt_enable, unsigned int cq_entry_enable,
+             unsigned int message_enable, unsigned int interrupt_offset,
+             u64 message_addr)
+{
+   (void) flow_control_enable;
+   (void) color_enable;
+   (void) cq_head;
+   (void) cq_tail;
+   (void) cq_tail_color;
+   (void) interrupt_enable;
+   (void) cq_entry_enable;
+   (void) message_enable;
+   (void) message_addr;
+   vdev.cq_intr[cq - dev.enic.cq] = interrupt_offset;
+}
+
+static void
+vnic_intr_init(struct vnic_intr *intr, unsigned int coalescing_timer,
+               unsigned int coalescing_type, unsigned int mask_on_assertion)
+{
+   (void) intr;
+   (void) coalescing_timer;
+   (void) coalescing_type;
+   (void) mask_on_assertion;
+}
+
+static unsigned int
+vnic_rq_error_status(struct vnic_rq *rq)
+{
+   (void) rq;
+   return 0;
+}
+
+static unsigned int
+vnic_wq_error_status(struct vnic_wq *wq)
+{
+   (void) wq;
+   return 0;
+}
+
+static unsigned int
+vnic_cq_serve(struct vnic_cq *cq, unsigned int work_to_do)
+{
+   unsigned int i = cq - dev.enic.cq;
+   unsigned int work_done = min(vdev.cq_pending[i], work_to_do);
+
+   vdev.cq_pending[i] -= work_done;
+   vdev.cq_served[i] += work_done;
+   return work_done;
+}
+
+static void
+vnic_intr_return_credits(struct vnic_intr *intr, unsigned int credits,
+                         int unmask, int reset_timer)
+{
+   (void) unmask;
+   (void) reset_timer;
+   vdev.intr_credits[intr - dev.enic.intr] += credits;
+}
+
+static void
+vnic_intr_return_all_credits(struct vnic_intr *intr)
+{
+   (void) intr;
+}
+
+static void
+vnic_intr_mask(struct vnic_intr *intr)
+{
+   (void) intr;
+}
+
+static void
+vnic_intr_unmask(struct vnic_intr *intr)
+{
+   (void) intr;
+}
+
+static u32
+vnic_intr_legacy_pba(u32 __iomem *legacy_pba)
+{
+   (void) legacy_pba;
+   return 0;
+}
+
+/*
+ * The kernel
+ */
+
+#define POISON  0xa5
+
+struct dma_buf {
+   size_t size;
+   int freed;
+   u8 data[];
+};
+
+static struct dma_buf *dma_bufs[64];
+static unsigned int n_dma_bufs;
+
+static unsigned int
+num_online_cpus(void)
+{
+   return online_cpus;
+}
+
+static int
+pci_enable_msix(struct pci_dev *pdev, struct msix_entry *entries, int nvec)
+{
+   int i;
+
+   (void) pdev;
+   if (!vdev.msix_ok || nvec > (int) vdev.res_intr) {
+      return -ENOSPC;
+   }
+   for (i = 0; i < nvec; i++) {
+      entries[i].vector = IRQ_BASE + entries[i].entry;
+   }
+   return 0;
+}
+
+static int
+pci_enable_msi(struct pci_dev *pdev)
+{
+   (void) pdev;
+   return vdev.msi_ok ? 0 : -EINVAL;
+}
+
+static void *
+pci_alloc_consistent(struct pci_dev *pdev, size_t size, dma_addr_t *pa)
+{
+   struct dma_buf *buf;
+
+   (void) pdev;
+   if (vdev.fail_alloc) {
+      return NULL;
+   }
+   buf = malloc(sizeof(*buf) + size);
+   buf->size = size;
+   buf->freed = 0;
+   memset(buf->data, POISON, size);
+   if (n_dma_bufs < 64) {
+      dma_bufs[n_dma_bufs++] = buf;
+   }
+   *pa = (dma_addr_t) (unsigned long) buf->data;
+   return buf->data;
+}
+
+static void
+pci_free_consistent(struct pci_dev *pdev, size_t size, void *va,
+                    dma_addr_t pa)
+{
+   struct dma_buf *buf = (struct dma_buf *)
+                         ((u8 *) va - offsetof(struct dma_buf, data));
+
+   (void) pdev;
+   if ((dma_addr_t) (unsigned long) va != pa || size != buf->size) {
+      fail("dma buffer freed with the wrong address or size");
+   }
+   memset(va, POISON, size);
+   buf->freed = 1;
+}
+
+static void
+dma_bufs_release(void)
+{
+   while (n_dma_bufs) {
+      free(dma_bufs[--n_dma_bufs]);
+   }
+}
+
+static int
+request_irq(unsigned int irq, int (*handler)(int, void *),
+            unsigned long flags, const char *name, void *dev_id)
+{
+   (void) flags;
+   (void) name;
+   if (irq < IRQ_BASE || irq >= IRQ_BASE + ENIC_INTR_MAX) {
+      fail("request of vector %u, not one pci_enable_msix gave", irq);
+      return -EINVAL;
+   }
+   irqs[irq - IRQ_BASE].requested++;
+   irqs[irq - IRQ_BASE].handler = handler;
+   irqs[irq - IRQ_BASE].dev_id = dev_id;
+   return 0;
+}
+
+static void
+free_irq(unsigned int irq, void *dev_id)
+{
+   (void) dev_id;
+   irqs[irq - IRQ_BASE].requested--;
+}
+
+static int
+schedule_work(struct work_struct *work)
+{
+   (void) work;
+   fail("reset scheduled");
+   return 1;
+}
+
+static void
+netif_carrier_on(struct net_device *d)
+{
+   clear_bit(__LINK_STATE_NOCARRIER, &d->state);
+}
+
+static void
+netif_carrier_off(struct net_device *d)
+{
+   set_bit(__LINK_STATE_NOCARRIER, &d->state);
+}
+
+static void
+__napi_schedule(struct napi_struct *n)
+{
+   VMK_ASSERT(n_sched < ENIC_RQ_MAX);
+   sched[n_sched++] = n;
+}
+
+/* the poll worldlet: poll what is scheduled until it completes */
+static void
+napi_run(void)
+{
+   struct napi_struct *n;
+   int polls;
+
+   while (n_sched) {
+      n = sched[--n_sched];
+      for (polls = 0; test_bit(NAPI_STATE_SCHED, &n->state); polls++) {
+         if (polls == 16) {
+            fail("NAPI context never completes");
+            clear_bit(NAPI_STATE_SCHED, &n->state);
+            break;
+         }
+         n->poll(n, n->weight);
+      }
+   }
+}
+
+/*
+ * Toeplitz hash over the fields the programmed hash types select
+ */
+
+static u32
+toeplitz(const u8 *key, const u8 *data, unsigned int len)
+{
+   u32 hash = 0, v;
+   unsigned int i;
+   int b;
+
+   v = (u32) key[0] << 24 | key[1] << 16 | key[2] << 8 | key[3];
+   for (i = 0; i < len; i++) {
+      for (b = 7; b >= 0; b--) {
+         if ((data[i] >> b) & 1) {
+            hash ^= v;
+         }
+         v = v << 1 | ((key[i + 4] >> b) & 1);
+      }
+   }
+   return hash;
+}
+
+struct flow {
+   int v6, tcp;
+   u8 src[16], dst[16];
+   u16 sport, dport;
+};
+
+/* the hash input for a flow, or 0 when the hash types skip it */
+static unsigned int
+hash_input(const struct flow *f, u8 hash_type, u8 *in)
+{
+   unsigned int alen = f->v6 ? 16 : 4, len;
+   u8 l3 = f->v6 ? NIC_CFG_RSS_HASH_TYPE_IPV6 : NIC_CFG_RSS_HASH_TYPE_IPV4;
+   u8 l4 = f->v6 ? NIC_CFG_RSS_HASH_TYPE_TCP_IPV6 :
+                   NIC_CFG_RSS_HASH_TYPE_TCP_IPV4;
+
+   memcpy(in, f->src, alen);
+   memcpy(in + alen, f->dst, alen);
+   len = 2 * alen;
+   if (f->tcp && (hash_type & l4)) {
+      in[len++] = f->sport >> 8;
+      in[len++] = f->sport & 0xff;
+      in[len++] = f->dport >> 8;
+      in[len++] = f->dport & 0xff;
+      return len;
+   }
+   return (hash_type & l3) ? len : 0;
+}
+
+/* the stand-in's receive steering: the RQ a packet of the flow lands on */
+static unsigned int
+vnic_rx_steer(const struct flow *f)
+{
+   u32 cfg = vdev.nic_cfg;
+   u8 hash_type = (cfg >> NIC_CFG_RSS_HASH_TYPE_SHIFT) &
+                  NIC_CFG_RSS_HASH_TYPE_MASK_FIELD;
+   u8 bits = (cfg >> NIC_CFG_RSS_HASH_BITS_SHIFT) &
+             NIC_CFG_RSS_HASH_BITS_MASK_FIELD;
+   u8 base = (cfg >> NIC_CFG_RSS_BASE_CPU_SHIFT) &
+             NIC_CFG_RSS_BASE_CPU_MASK_FIELD;
+   u8 in[36];
+   unsigned int len;
+
+   if (!((cfg >> NIC_CFG_RSS_ENABLE_SHIFT) & 1)) {
+      return cfg & NIC_CFG_RSS_DEFAULT_CPU_MASK_FIELD;
+   }
+   len = hash_input(f, hash_type, in);
+   if (len == 0) {
+      return cfg & NIC_CFG_RSS_DEFAULT_CPU_MASK_FIELD;
+   }
+   return base + vdev.cpu[toeplitz(vdev.key, in, len) & ((1u << bits) - 1)];
+}
+
+/*
+ * Receive a packet: complete it on the CQ of its RQ, raise the vector of
+ * that CQ and poll what the handler scheduled.
+ */
+static void
+vnic_rx(struct enic *enic, const struct flow *f, unsigned int *rq_out)
+{
+   unsigned int rq = vnic_rx_steer(f), cq, intr;
+
+   *rq_out = rq;
+   if (rq >= enic->rq_count) {
+      fail("packet steered to an RQ that does not exist");
+      return;
+   }
+   cq = vdev.rq_cq[rq];
+   intr = vdev.cq_intr[cq];
+   vdev.cq_pending[cq]++;
+   irqs[intr].handler(enic->msix_entry[intr].vector, irqs[intr].dev_id);
+   napi_run();
+   if (vdev.cq_pending[cq]) {
+      fail("packet left on CQ %u, polled by the NAPI context of another RQ",
+           cq);
+      vdev.cq_pending[cq] = 0;
+   }
+}
+
+/* the published Toeplitz verification vectors */
+static void
+test_toeplitz(void)
+{
+   static const u8 key[40] = {
+      0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+      0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+      0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+      0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+      0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa,
+   };
+   struct flow v4 = {
+      .tcp = 1, .src = { 66, 9, 149, 187 }, .dst = { 161, 142, 100, 80 },
+      .sport = 2794, .dport = 1766,
+   };
+   struct flow v6 = {
+      .v6 = 1, .tcp = 1,
+      .src = { 0x3f, 0xfe, 0x25, 0x01, 0x02, 0x00, 0x1f, 0xff,
+               0, 0, 0, 0, 0, 0, 0, 7 },
+      .dst = { 0x3f, 0xfe, 0x25, 0x01, 0x02, 0x00, 0x00, 0x03,
+               0, 0, 0, 0, 0, 0, 0, 1 },
+      .sport = 2794, .dport = 1766,
+   };
+   u8 in[36];
+   unsigned int len;
+
+   len = hash_input(&v4, NIC_CFG_RSS_HASH_TYPE_TCP_IPV4, in);
+   if (toeplitz(key, in, len) != 0x51ccc178) {
+      fail("toeplitz: IPv4 TCP vector");
+   }
+   len = hash_input(&v4, NIC_CFG_RSS_HASH_TYPE_IPV4, in);
+   if (toeplitz(key, in, len) != 0x323e8fc2) {
+      fail("toeplitz: IPv4 vector");
+   }
+   len = hash_input(&v6, NIC_CFG_RSS_HASH_TYPE_TCP_IPV6, in);
+   if (toeplitz(key, in, len) != 0x40207d3d) {
+      fail("toeplitz: IPv6 TCP vector");
+   }
+   len = hash_input(&v6, NIC_CFG_RSS_HASH_TYPE_IPV6, in);
+   if (toeplitz(key, in, len) != 0x2cc18cd5) {
+      fail("toeplitz: IPv6 vector");
+   }
+}
+
+/*
+ * What enic_probe does up to enic_set_niccfg, on a vNIC with @res_*
+ * resources and @cpus CPUs.  Returns the enic_set_intr_mode result.
+ */
+static int
+probe(unsigned int res_rq, unsigned int res_cq, unsigned int res_intr,
+      int msix_ok, u32 flags, unsigned int cpus)
+{
+   struct enic *enic = &dev.enic;
+   unsigned int i;
+   int err;
+
+   memset(&vdev, 0, sizeof(vdev));
+   memset(enic, 0, sizeof(*enic));
+   memset(irqs, 0, sizeof(irqs));
+   vdev.res_rq = res_rq;
+   vdev.res_wq = 1;
+   vdev.res_cq = res_cq;
+   vdev.res_intr = res_intr;
+   vdev.msix_ok = msix_ok;
+   vdev.msi_ok = 1;
+   enic->netdev = &dev.netdev;
+   enic->vdev = &vdev;
+   enic->config.flags = flags;
+   online_cpus = cpus;
+
+   enic_get_res_counts(enic);
+   err = enic_set_intr_mode(enic);
+   if (err) {
+      return err;
+   }
+   enic_init_vnic_resources(enic);
+   for (i = 0; i < ENIC_RQ_MAX; i++) {
+      enic->napi[i].dev = &dev.netdev;
+      enic->napi[i].poll = enic_poll_msix;
+      enic->napi[i].weight = 64;
+   }
+   return 0;
+}
+
+/*
+ * Interrupt mode selection over all small resource provisionings
+ */
+
+static void
+check_layout(struct enic *enic, unsigned int cpus)
+{
+   unsigned int i, intr, want_n;
+
+   if (enic->rq_count > vdev.res_rq || enic->wq_count > vdev.res_wq ||
+       enic->cq_count > vdev.res_cq || enic->intr_count > vdev.res_intr) {
+      fail("interrupt mode needs more resources than provisioned");
+   }
+   if (enic->cq_count < enic->rq_count + enic->wq_count) {
+      fail("fewer CQs than RQs and WQs");
+   }
+
+   if (vdev.intr_mode != VNIC_DEV_INTR_MODE_MSIX) {
+      if (enic->rq_count != 1) {
+         fail("several RQs without MSI-X");
+      }
+      return;
+   }
+
+   if (enic->rq_count > cpus || enic->rq_count > ENIC_RQ_MAX) {
+      fail("more RQs than CPUs");
+   }
+   if (enic->rq_count > 1 && !ENIC_SETTING(enic, RSS)) {
+      fail("several RQs without RSS");
+   }
+
+   /* several RQs whenever RSS could run on them */
+   want_n = min_t(unsigned int, vdev.res_rq, ENIC_RQ_MAX);
+   want_n = min_t(unsigned int, want_n, cpus);
+   if (!ENIC_SETTING(enic, RSS)) {
+      want_n = 1;
+   }
+   if (want_n > 1 && vdev.res_wq >= 1 &&
+       vdev.res_cq >= want_n + 1 && vdev.res_intr >= want_n + 3 &&
+       enic->rq_count != want_n) {
+      fail("RSS possible but not all RQs used");
+   }
+
+   if (enic->intr_count != enic->rq_count + enic->wq_count + 2) {
+      fail("MSI-X vector count does not match the queues");
+   }
+
+   if (enic_request_intr(enic)) {
+      fail("MSI-X vectors not requested");
+      return;
+   }
+   for (i = 0; i < enic->intr_count; i++) {
+      if (irqs[enic->msix_entry[i].vector - IRQ_BASE].requested != 1) {
+         fail("MSI-X vector not requested exactly once");
+      }
+   }
+   for (i = 0; i < enic->rq_count; i++) {
+      intr = vdev.cq_intr[vdev.rq_cq[i]];
+      if (intr >= enic->intr_count ||
+          irqs[enic->msix_entry[intr].vector - IRQ_BASE].dev_id !=
+          &enic->napi[i]) {
+         fail("CQ raises a vector of another NAPI context");
+      }
+      if (vdev.rq_err_intr[i] != enic_msix_err_intr(enic)) {
+         fail("RQ errors raised on vector %u", vdev.rq_err_intr[i]);
+      }
+   }
+   intr = vdev.cq_intr[enic_cq_wq(enic, 0)];
+   if (intr >= enic->intr_count ||
+       irqs[enic->msix_entry[intr].vector - IRQ_BASE].handler !=
+       enic_isr_msix_wq) {
+      fail("WQ CQ raises a vector without the WQ handler");
+   }
+   intr = enic_msix_err_intr(enic);
+   if (irqs[enic->msix_entry[intr].vector - IRQ_BASE].handler !=
+       enic_isr_msix_err) {
+      fail("error vector without the error handler");
+   }
+}
+
+static void
+test_intr_modes(void)
+{
+   unsigned int rq, cq, intr, cpus, flags, msix;
+
+   for (rq = 1; rq <= 10; rq++)
+   for (cq = 1; cq <= 12; cq++)
+   for (intr = 1; intr <= 14; intr++)
+   for (cpus = 1; cpus <= 8; cpus *= 2)
+   for (flags = 0; flags <= VENETF_RSS; flags += VENETF_RSS)
+   for (msix = 0; msix <= 1; msix++) {
+      if (probe(rq, cq, intr, msix, flags, cpus)) {
+         if (cq >= 2) {
+            fail("no interrupt mode although MSI works");
+         }
+         continue;
+      }
+      check_layout(&dev.enic, cpus);
+   }
+}
+
+/*
+ * RSS programming and steering
+ */
+
+static void
+bring_up(struct enic *enic, u32 flags, unsigned int cpus, int fail_cmd,
+         int fail_alloc)
+{
+   if (probe(8, 9, 11, 1, flags, cpus) ||
+       vdev.intr_mode != VNIC_DEV_INTR_MODE_MSIX) {
+      fail("no MSI-X on a fully provisioned vNIC");
+   }
+   if (enic_request_intr(enic)) {
+      fail("MSI-X vectors not requested");
+   }
+   vdev.fail_cmd = fail_cmd;
+   vdev.fail_alloc = fail_alloc;
+   if (enic_set_niccfg(enic) || !vdev.nic_cfg_set) {
+      fail("NIC_CFG not accepted");
+   }
+}
+
+#define FLOWS           4096
+#define PKTS_PER_FLOW   8
+
+static void
+make_flow(struct flow *f, unsigned int i, unsigned int *seed)
+{
+   unsigned int j;
+
+   memset(f, 0, sizeof(*f));
+   f->v6 = i % 4 == 3;
+   f->tcp = i % 8 != 5;
+   for (j = 0; j < 16; j++) {
+      f->src[j] = rand_r(seed);
+      f->dst[j] = rand_r(seed);
+   }
+   f->sport = rand_r(seed);
+   f->dport = rand_r(seed) % 4 ? 80 : rand_r(seed);
+}
+
+/* receive FLOWS flows; returns the flows each RQ got */
+static void
+run_traffic(struct enic *enic, unsigned int *per_rq, const char *name)
+{
+   struct flow f;
+   unsigned int i, p, rq, cq, first, seed = 11;
+   unsigned int total = 0;
+
+   memset(per_rq, 0, ENIC_RQ_MAX * sizeof(*per_rq));
+   memset(vdev.cq_served, 0, sizeof(vdev.cq_served));
+   memset(vdev.intr_credits, 0, sizeof(vdev.intr_credits));
+
+   for (i = 0; i < FLOWS; i++) {
+      make_flow(&f, i, &seed);
+      vnic_rx(enic, &f, &first);
+      for (p = 1; p < PKTS_PER_FLOW; p++) {
+         vnic_rx(enic, &f, &rq);
+         if (rq != first) {
+            fail("flow received on more than one RQ");
+         }
+      }
+      if (first < ENIC_RQ_MAX) {
+         per_rq[first]++;
+      }
+   }
+
+   printf("%-28s", name);
+   for (i = 0; i < enic->rq_count; i++) {
+      cq = vdev.rq_cq[i];
+      printf(" %5u", per_rq[i]);
+      total += vdev.cq_served[cq];
+      if (vdev.intr_credits[vdev.cq_intr[cq]] != vdev.cq_served[cq]) {
+         fail("RQ %u completions credited to another vector", i);
+      }
+   }
+   printf("\n");
+   if (total != FLOWS * PKTS_PER_FLOW) {
+      fail("%u of %u packets serviced", total, FLOWS * PKTS_PER_FLOW);
+   }
+}
+
+static void
+test_rss(void)
+{
+   static const char *names[] = {
+      "rss key devcmd fails:", "rss cpu devcmd fails:",
+      "dma buffer alloc fails:",
+   };
+   struct enic *enic = &dev.enic;
+   unsigned int per_rq[ENIC_RQ_MAX], i, share;
+   u8 hash_type;
+   int rss_enable;
+
+   /* RSS with the default hash types */
+   bring_up(enic, VENETF_RSS, 6, 0, 0);
+   for (i = 0; i < n_dma_bufs; i++) {
+      if (!dma_bufs[i]->freed) {
+         fail("devcmd buffer leaked");
+      }
+   }
+   dma_bufs_release();
+   rss_enable = (vdev.nic_cfg >> NIC_CFG_RSS_ENABLE_SHIFT) & 1;
+   hash_type = vdev.nic_cfg >> NIC_CFG_RSS_HASH_TYPE_SHIFT;
+   if (!rss_enable || !vdev.key_set || !vdev.cpu_set ||
+       ((vdev.nic_cfg >> NIC_CFG_RSS_HASH_BITS_SHIFT) & 7) !=
+       ENIC_RSS_HASH_BITS) {
+      fail("RSS not enabled on a vNIC provisioned for it");
+   }
+   if (hash_type != (NIC_CFG_RSS_HASH_TYPE_IPV4 |
+                     NIC_CFG_RSS_HASH_TYPE_TCP_IPV4 |
+                     NIC_CFG_RSS_HASH_TYPE_IPV6 |
+                     NIC_CFG_RSS_HASH_TYPE_TCP_IPV6)) {
+      fail("default hash types");
+   }
+   if (!((vdev.nic_cfg >> NIC_CFG_IG_VLAN_STRIP_EN_SHIFT) & 1)) {
+      fail("VLAN stripping turned off");
+   }
+
+   run_traffic(enic, per_rq, "rss, default hash types:");
+   share = FLOWS / enic->rq_count;
+   for (i = 0; i < enic->rq_count; i++) {
+      if (per_rq[i] == 0 || per_rq[i] > share * 13 / 10) {
+         fail("RQs unevenly loaded");
+      }
+   }
+
+   /* the configured hash types are programmed as they are */
+   bring_up(enic, VENETF_RSS | VENETF_RSSHASH_IPV4 |
+            VENETF_RSSHASH_TCPIPV6_EX, 8, 0, 0);
+   dma_bufs_release();
+   hash_type = vdev.nic_cfg >> NIC_CFG_RSS_HASH_TYPE_SHIFT;
+   if (hash_type != (NIC_CFG_RSS_HASH_TYPE_IPV4 |
+                     NIC_CFG_RSS_HASH_TYPE_TCP_IPV6_EX)) {
+      fail("configured hash types");
+   }
+   run_traffic(enic, per_rq, "rss, ipv4 and tcp/ipv6ex:");
+
+   /* no RSS: one RQ */
+   bring_up(enic, 0, 8, 0, 0);
+   dma_bufs_release();
+   if (enic->rq_count != 1 || vdev.key_set || vdev.cpu_set ||
+       ((vdev.nic_cfg >> NIC_CFG_RSS_ENABLE_SHIFT) & 1)) {
+      fail("RSS programmed on a vNIC without it");
+   }
+   run_traffic(enic, per_rq, "no rss:");
+
+   /* programming fails: RSS stays off and RQ 0 takes everything */
+   for (i = 0; i < 3; i++) {
+      bring_up(enic, VENETF_RSS, 8,
+               i == 0 ? CMD_RSS_KEY : i == 1 ? CMD_RSS_CPU : 0, i == 2);
+      dma_bufs_release();
+      if ((vdev.nic_cfg >> NIC_CFG_RSS_ENABLE_SHIFT) & 1 ||
+          (vdev.nic_cfg >> NIC_CFG_RSS_HASH_BITS_SHIFT) & 7) {
+         fail("RSS enabled although programming failed");
+      }
+      run_traffic(enic, per_rq, names[i]);
+      if (per_rq[0] != FLOWS) {
+         fail("traffic not on RQ 0 after RSS failed");
+      }
+   }
+}
+
+int
+main(void)
+{
+   VMK_ASSERT(netdev_priv(&dev.netdev) == &dev.enic);
+
+   test_toeplitz();
+   test_intr_modes();
+   test_rss();
+
+   if (failures) {
+      fprintf(stderr, "enic_rss_sim: %d failures\n", failures);
+      return 1;
+   }
+   printf("enic_rss_sim: ok\n");
+   return 0;
+}
@@ -0,0 +1,336 @@
+#
+# extract.awk --
+#
+#    Pull the code under test out of the vmklinux and driver sources, so
+#    that the programs here compile the shipped functions instead of
+#    copies of them.
+#
+#    A program names what it needs in a comment, one source per line:
+#
+#     * extract ../vmware/linux_net.c: netdev_stats_put process_tx_queue
+#
+#    Functions, #defines, variables (also those a macro defines, as in
+#    "static LIST_HEAD(name);"), and struct, union and enum types
+#    ("struct netdev_queue_stats", or "enum LIN_NET_QUEUE_UNBLOCKED" for
+#    an anonymous enum by its first constant) are written out in the
+#    order they appear in the source, each behind a #line marker that points back at
+#    it. Every name has to be found exactly once, so a renamed or removed
+#    function breaks the build of its test instead of going unnoticed.
+#    The rest of the source is left out; the program provides what the
+#    extracted code calls, as stubs or as further extracts.
+#
+#    Only one branch of an #if/#else is used, the first one unless it is
+#    for Linux without __VMKLNX__ or "#if 0". The others are not searched,
+#    and within a function body they are copied but not used to match
+#    braces, as in the sources a body is balanced in each branch.
+#
+#    usage: awk -f extract.awk [-v deps=prog.d] prog.c > prog.inc
+#
+
+BEGIN {
+   # conditionals whose first branch is not taken
+   FALSEIF = "^[ \t]*#[ \t]*(if[ \t]+0|ifndef[ \t]+__VMKLNX__|if[ \t]+!" \
+             "[ \t]*defined[ \t]*\\(?[ \t]*__VMKLNX__)"
+   # attributes after the name of a variable
+   TRAILATTR = "[ \t]+(__attribute__[ \t]*\\(\\(.*\\)\\)|" \
+               "_*cacheline_aligned[a-z_]*|VMK_ATTRIBUTE_[A-Z0-9_]*)[ \t]*$"
+}
+
+function fail(msg)
+{
+   print FILENAME ": " msg > "/dev/stderr"
+   failed = 1
+   exit 1
+}
+
+# the line with comments, string and character literals blanked out
+function strip(line,    out, n, i, c, q)
+{
+   out = ""
+   n = length(line)
+   i = 1
+   while (i <= n) {
+      c = substr(line, i, 1)
+      if (incomment) {
+         if (c == "*" && substr(line, i + 1, 1) == "/") {
+            incomment = 0
+            i++
+         }
+         out = out " "
+      } else if (c == "/" && substr(line, i + 1, 1) == "*") {
+         incomment = 1
+         out = out " "
+         i++
+      } else if (c == "/" && substr(line, i + 1, 1) == "/") {
+         break
+      } else if (c == "\"" || c == "'") {
+         q = c
+         for (i++; i <= n && substr(line, i, 1) != q; i++) {
+            if (substr(line, i, 1) == "\\") {
+               i++
+            }
+         }
+         out = out " "
+      } else {
+         out = out c
+      }
+      i++
+   }
+   return out
+}
+
+function lastident(s)
+{
+   sub(/[^A-Za-z0-9_]+$/, "", s)
+   if (!match(s, /[A-Za-z_][A-Za-z0-9_]*$/)) {
+      return ""
+   }
+   return substr(s, RSTART, RLENGTH)
+}
+
+# the name a top level statement defines, "" if none of interest
+function defname(hdr, tail, inner, opened,    s)
+{
+   gsub(/\[[^]]*\]/, "", hdr)
+   gsub(/__attribute__[ \t]*\(\(.*\)\)/, "", tail)
+   sub(TRAILATTR, "", hdr)
+   if (opened && hdr ~ /^[ \t]*enum[ \t]*$/ &&
+       match(inner, /[A-Za-z_][A-Za-z0-9_]*/)) {
+      return "enum " substr(inner, RSTART, RLENGTH)
+   }
+   if (hdr ~ /^[ \t]*typedef[ \t]/) {
+      # a function or function pointer type
+      if (!opened && match(hdr, /\([ \t]*\*?[ \t]*[A-Za-z_][A-Za-z0-9_]*[ \t]*\)/)) {
+         return lastident(substr(hdr, RSTART, RLENGTH))
+      }
+      return lastident(opened ? tail : hdr)
+   }
+   if (opened && hdr !~ /[(=]/ &&
+       match(hdr, /(struct|union|enum)[ \t]+[A-Za-z_][A-Za-z0-9_]*/)) {
+      s = substr(hdr, RSTART, RLENGTH)
+      sub(/[ \t]+/, " ", s)
+      return s
+   }
+   if (!opened &&
+       hdr ~ /^[ \t]*(struct|union|enum)[ \t]+[A-Za-z_][A-Za-z0-9_]*[ \t]*$/) {
+      # a declaration of a type defined elsewhere
+      return ""
+   }
+   if (index(hdr, "=")) {
+      return lastident(substr(hdr, 1, index(hdr, "=") - 1))
+   }
+   if (!opened && hdr !~ /^[ \t]*EXPORT_/ &&
+       hdr ~ /^[ \t]*(static[ \t]+)?[A-Z_][A-Z0-9_]*[ \t]*\([ \t]*[A-Za-z_][A-Za-z0-9_]*[ \t]*\)[ \t]*$/) {
+      # a variable defined by a macro, as in "static LIST_HEAD(name);"
+      return lastident(hdr)
+   }
+   if (index(hdr, "(")) {
+      # a function, or without a body a prototype
+      return opened ? lastident(substr(hdr, 1, index(hdr, "(") - 1)) : ""
+   }
+   return lastident(hdr)
+}
+
+function emit(key, file, start, text,    norm)
+{
+   if (!(key in want)) {
+      return
+   }
+   # a macro may be defined again the same way, as C allows
+   norm = text
+   gsub(/[ \t]+/, " ", norm)
+   if (key in found) {
+      if (found[key] == norm && norm ~ /^ ?# ?define /) {
+         return
+      }
+      fail(file ": " key " defined more than once")
+   }
+   found[key] = norm
+   printf "#line %d \"%s\"\n%s", start, file, text
+}
+
+function scan(file,    line, code, lnum, depth, instmt, opened, buf, hdr,
+              tail, inner, start, inmacro, cap, name, cpp, skip, outer, lvl,
+              i, c, n, done)
+{
+   lnum = 0
+   depth = 0
+   instmt = 0
+   inmacro = 0
+   cpp = 0
+   skip = 0
+   incomment = 0
+   while ((getline line < file) > 0) {
+      lnum++
+      if (inmacro) {
+         if (instmt && !(skip && skip <= outer)) {
+            buf = buf line "\n"
+         }
+         if (cap) {
+            print line
+         }
+         strip(line)
+         inmacro = line ~ /\\$/ || incomment
+         continue
+      }
+
+      if (!incomment && line ~ /^[ \t]*#/) {
+         # only one branch of a conditional is used
+         lvl = cpp + 1
+         if (line ~ /^[ \t]*#[ \t]*if/) {
+            cpp++
+            notfirst[cpp] = line ~ FALSEIF
+            if (!skip && notfirst[cpp]) {
+               skip = cpp
+            }
+         } else if (line ~ /^[ \t]*#[ \t]*(else|elif)/) {
+            lvl = cpp
+            if (skip == cpp && notfirst[cpp]) {
+               skip = 0
+            } else if (!skip) {
+               skip = cpp
+            }
+            notfirst[cpp] = 0
+         } else if (line ~ /^[ \t]*#[ \t]*endif/) {
+            lvl = cpp
+            if (skip == cpp) {
+               skip = 0
+            }
+            cpp--
+         }
+         cap = 0
+         # of a conditional around the start of a statement, like one
+         # between two versions of a function header, only the branch
+         # used is kept
+         if (instmt && lvl > outer && !(skip && skip <= outer)) {
+            buf = buf line "\n"
+         }
+         if (cpp < outer) {
+            outer = cpp
+         }
+         # a #define inside a type, like the NETIF_F_ flags in struct
+         # net_device, is taken out on its own as well
+         if (!skip && line ~ /^[ \t]*#[ \t]*define[ \t]/) {
+            name = line
+            sub(/^[ \t]*#[ \t]*define[ \t]+/, "", name)
+            match(name, /^[A-Za-z_][A-Za-z0-9_]*/)
+            name = substr(name, 1, RLENGTH)
+            cap = name in want
+            if (cap) {
+               emit(name, file, lnum, line "\n")
+            }
+         }
+         strip(line)
+         inmacro = line ~ /\\$/ || incomment
+         continue
+      }
+
+      code = strip(line)
+      if (!instmt) {
+         if (skip || code ~ /^[ \t]*$/) {
+            continue
+         }
+         instmt = 1
+         outer = cpp
+         opened = 0
+         buf = ""
+         hdr = ""
+         tail = ""
+         inner = ""
+         start = lnum
+      }
+      if (!skip || skip > outer) {
+         buf = buf line "\n"
+      }
+
+      done = 0
+      n = length(code)
+      for (i = 1; i <= n && !done; i++) {
+         c = substr(code, i, 1)
+         if (skip) {
+            continue
+         }
+         if (c == "{") {
+            opened = 1
+            depth++
+         } else if (c == "}") {
+            depth--
+         } else if (depth == 0 && c == ";") {
+            done = 1
+         } else if (depth == 1 && length(inner) < 256) {
+            inner = inner c
+         } else if (depth == 0) {
+            if (opened) {
+               tail = tail c
+            } else {
+               hdr = hdr c
+            }
+         }
+      }
+      if (depth == 0 && (done || (opened && code ~ /}[ \t]*$/))) {
+         emit(defname(hdr, tail, inner, opened), file, start, buf)
+         instmt = 0
+      } else if (depth == 0 && !opened) {
+         hdr = hdr " "
+      }
+   }
+   close(file)
+   if (instmt || depth != 0) {
+      fail(file ": unbalanced braces at the end")
+   }
+}
+
+/^[ \t]*\*[ \t]+extract[ \t]+[^ \t]+:/ {
+   sub(/^[ \t]*\*[ \t]+extract[ \t]+/, "")
+   file = substr($0, 1, index($0, ":") - 1)
+   $0 = substr($0, index($0, ":") + 1)
+   if (!header) {
+      print "/* Generated by extract.awk from " FILENAME ", do not edit. */"
+      print "#pragma GCC diagnostic push"
+      print "#pragma GCC diagnostic ignored \"-Wunused-parameter\""
+      print "#pragma GCC diagnostic ignored \"-Wsign-compare\""
+      print "#pragma GCC diagnostic ignored \"-Wmissing-field-initializers\""
+      print "#pragma GCC diagnostic ignored \"-Wtype-limits\""
+      print "#pragma GCC diagnostic ignored \"-Wpointer-sign\""
+      header = 1
+   }
+   for (k in want) {
+      delete want[k]
+   }
+   for (k in found) {
+      delete found[k]
+   }
+   for (k = 1; k <= NF; k++) {
+      if ($k == "struct" || $k == "union" || $k == "enum") {
+         want[$k " " $(k + 1)] = 1
+         k++
+      } else {
+         want[$k] = 1
+      }
+   }
+   scan(file)
+   for (k in want) {
+      if (!(k in found)) {
+         fail(file ": " k " not found")
+      }
+   }
+   if (!(file in read)) {
+      read[file] = 1
+      deplist = deplist " " file
+   }
+}
+
+END {
+   if (failed) {
+      exit 1
+   }
+   if (header) {
+      print "#pragma GCC diagnostic pop"
+   }
+   if (deps != "") {
+      out = FILENAME
+      sub(/\.[ch]$/, ".inc", out)
+      print out ":" deplist > deps
+      close(deps)
+   }
+}
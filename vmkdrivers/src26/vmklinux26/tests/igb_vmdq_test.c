@@ -0,0 +1,372 @@
+/*
+ * igb_vmdq_test.c --
+ *
+ *    Programming model test of the igb NetQueue receive steering of
+ *    drivers/net/igb as it ships: the NetQueue ops behind
+ *    igb_netqueue_ops (igb_alloc_queue, igb_free_queue,
+ *    igb_apply_rx_filter, igb_remove_rx_filter with igb_rar_set_qsel and
+ *    igb_vmdq_set_mrqc), igb_configure_rx with igb_configure_vmdq,
+ *    igb_set_mac, and e1000_init_rx_addrs_generic and
+ *    e1000_rar_set_generic of the reset path.
+ *
+ *    The driver runs on a register file, and a model of the 82575/82576
+ *    receive queue selection classifies frames by destination MAC and
+ *    flow hash:
+ *    - MRQC RSS: the RETA entry of the hash;
+ *    - MRQC VMDq: the first RAR that matches, its RAH pool field read as
+ *      a queue index on 82575 and as a pool bitmap on 82576, where a
+ *      match that selects no pool is dropped.
+ *    A reset clears the register file and runs e1000_init_rx_addrs_generic
+ *    and igb_configure_rx, as igb_reset and igb_configure do.
+ *
+ *    The test fails if the default address is not spread over every
+ *    queue while no netqueue is allocated, if a filter address does not
+ *    land on its netqueue, if the default address is dropped or leaves
+ *    queue 0 in VMDq mode, if any of this breaks across a reset or a MAC
+ *    address change, or if the ops accept a filter on a queue that is
+ *    not allocated or already filtered.
+ *
+ * extract ../../include/vmklinux26/vmknetddinetq.h: VMKNETDDI_QUEUEOPS_MAJOR_VER VMKNETDDI_QUEUEOPS_MINOR_VER VMKNETDDI_QUEUEOPS_OK VMKNETDDI_QUEUEOPS_ERR VMKNETDDI_QUEUEOPS_FEATURE_NONE VMKNETDDI_QUEUEOPS_FEATURE_RXQUEUES VMKNETDDI_QUEUEOPS_FEATURE_TXQUEUES vmknetddi_queueops_filter_class_t vmknetddi_queueops_queue_t vmknetddi_queueops_filterid_t VMKNETDDI_QUEUEOPS_MK_TX_QUEUEID VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID VMKNETDDI_QUEUEOPS_QUEUEID_VAL VMKNETDDI_QUEUEOPS_MK_FILTERID VMKNETDDI_QUEUEOPS_FILTERID_VAL VMKNETDDI_QUEUEOPS_IS_TX_QUEUEID VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID vmknetddi_queueops_filter_t vmknetddi_queueops_features_t vmknetddi_queueops_op_t vmknetddi_queueop_get_version_args_t vmknetddi_queueop_get_features_args_t vmknetddi_queueop_get_queue_count_args_t vmknetddi_queueop_get_filter_count_args_t vmknetddi_queueop_alloc_queue_args_t vmknetddi_queueop_free_queue_args_t vmknetddi_queueop_get_queue_vector_args_t vmknetddi_queueop_get_default_queue_args_t vmknetddi_queueop_apply_rx_filter_args_t vmknetddi_queueop_remove_rx_filter_args_t vmknetddi_queueop_get_stats_args_t vmknetddi_queueops_version vmknetddi_queueops_get_filter_class vmknetddi_queueops_set_filter_macaddr vmknetddi_queueops_get_filter_macaddr
+ * extract ../../include/linux/etherdevice.h: is_zero_ether_addr is_multicast_ether_addr is_valid_ether_addr
+ * extract ../../include/linux/socket.h: sa_family_t struct sockaddr
+ * extract ../../include/linux/timer.h: struct timer_list
+ * extract ../../include/linux/inet_lro.h: LRO_AGGR_HIST_BUCKETS struct net_lro_stats struct net_lro_desc struct net_lro_mgr LRO_DEFAULT_MAX_DESC
+ * extract ../../include/linux/netdevice.h: struct net_device_stats NAPI_PUSH_HIST_BUCKETS struct napi_struct
+ * extract ../../include/linux/pci.h: struct msix_entry
+ * extract ../../drivers/net/igb/e1000_regs.h: E1000_STATUS E1000_ITR E1000_RCTL E1000_RDBAL E1000_RDBAH E1000_RDLEN E1000_SRRCTL E1000_RDH E1000_RDT E1000_RXDCTL E1000_TDBAL E1000_TDBAH E1000_TDLEN E1000_TDH E1000_TDT E1000_TXDCTL E1000_RAL E1000_RAH E1000_RXCSUM E1000_RLPML E1000_RA E1000_VMD_CTL E1000_MRQC E1000_RETA E1000_RSSRK E1000_VLVF E1000_VMOLR
+ * extract ../../drivers/net/igb/e1000_defines.h: E1000_MRQC_ENABLE_MASK E1000_MRQC_RSS_FIELD_IPV4_TCP E1000_MRQC_RSS_FIELD_IPV4 E1000_MRQC_RSS_FIELD_IPV6_TCP_EX E1000_MRQC_RSS_FIELD_IPV6 E1000_MRQC_RSS_FIELD_IPV6_TCP E1000_RCTL_EN E1000_RXCSUM_TUOFL E1000_RXCSUM_IPPCSE E1000_RXCSUM_PCSD VLAN_TAG_SIZE E1000_RAH_AV E1000_SUCCESS
+ * extract ../../drivers/net/igb/e1000_hw.h: e1000_mac_type e1000_media_type e1000_nvm_type e1000_nvm_override e1000_phy_type e1000_bus_type e1000_bus_speed e1000_bus_width e1000_1000t_rx_status e1000_rev_polarity e1000_fc_type struct e1000_hw_stats struct e1000_phy_stats struct e1000_host_mng_dhcp_cookie struct e1000_host_mng_command_header
+ * extract ../../drivers/net/igb/e1000_phy.h: e1000_ms_type e1000_smart_speed
+ * extract ../../drivers/net/igb/e1000_hw.h: struct e1000_mac_operations struct e1000_phy_operations struct e1000_nvm_operations struct e1000_mac_info struct e1000_phy_info struct e1000_nvm_info struct e1000_bus_info struct e1000_fc_info struct e1000_hw
+ * extract ../../drivers/net/igb/e1000_82575.h: E1000_MRQC_ENABLE_RSS_4Q E1000_MRQC_ENABLE_VMDQ E1000_MRQC_RSS_FIELD_IPV4_UDP E1000_MRQC_RSS_FIELD_IPV6_UDP E1000_MRQC_RSS_FIELD_IPV6_UDP_EX union e1000_adv_rx_desc E1000_RXDCTL_QUEUE_ENABLE E1000_VMD_CTL_DEFAULT_POOL_0 E1000_VMOLR_LPE E1000_VMOLR_AUPE E1000_VMOLR_BAM E1000_VMOLR_MPME E1000_VMOLR_STRVLAN E1000_VMOLR_ROMPE E1000_VMOLR_RLPML_MASK E1000_RAH_POOL_MASK E1000_RAH_POOL_1 E1000_VLVF_ARRAY_SIZE E1000_VLVF_VLANID_MASK E1000_VLVF_POOLSEL_SHIFT E1000_VLVF_POOLSEL_MASK E1000_VLVF_VLANID_ENABLE
+ * extract ../../drivers/net/igb/e1000_osdep.h: DEBUGOUT DEBUGOUT1 DEBUGFUNC E1000_REGISTER E1000_WRITE_REG E1000_READ_REG E1000_WRITE_REG_ARRAY E1000_READ_REG_ARRAY E1000_WRITE_FLUSH
+ * extract ../../drivers/net/igb/igb.h: IGB_RX_PTHRESH IGB_RX_HTHRESH IGB_RX_WTHRESH struct igb_buffer struct igb_queue_stats struct igb_ring struct igb_adapter IGB_FLAG_VMDQ_ENABLED
+ * extract ../../drivers/net/igb/e1000_82575.c: e1000_translate_register_82576
+ * extract ../../drivers/net/igb/e1000_mac.c: e1000_init_rx_addrs_generic e1000_rar_set_generic
+ * extract ../../drivers/net/igb/e1000_api.c: e1000_rar_set
+ * extract ../../drivers/net/igb/igb_main.c: igb_configure_rx igb_set_mac igb_rar_set_qsel igb_vmdq_set_vmolr igb_vmdq_set_mrqc igb_configure_vmdq igb_get_netqueue_features igb_get_queue_count igb_get_filter_count igb_alloc_rx_queue igb_alloc_queue igb_free_queue igb_get_queue_vector igb_get_default_queue igb_apply_rx_filter igb_remove_rx_filter igb_get_queue_stats igb_get_netqueue_version igb_netqueue_ops
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+
+#include "stubs.h"
+
+#define NUM_QUEUES              4
+#define NUM_RAR                 16
+#define REGS_SIZE               0x10000
+
+#define __VMKNETDDI_QUEUEOPS__
+#define ETH_ALEN                6
+#define IFNAMSIZ                16
+#define TRUE                    true
+#define FALSE                   false
+#define IFF_PROMISC             0x100
+#define IFF_ALLMULTI            0x200
+#define mdelay(ms)              ((void) (ms))
+#define DPRINTK(nlevel, klevel, fmt, args...)   do { } while (0)
+
+/* the register file */
+#define readl(addr)             (*(volatile u32 *) (addr))
+#define writel(val, addr)       (*(volatile u32 *) (addr) = (val))
+#define readb(addr)             (*(volatile u8 *) (addr))
+
+struct work_struct {
+   int unused;
+};
+
+struct net_device {
+   char name[IFNAMSIZ];
+   unsigned int flags;
+   unsigned char addr_len;
+   u8 dev_addr[ETH_ALEN];
+   void *priv;
+};
+
+#define netdev_priv(dev)        ((dev)->priv)
+
+/* what the extracted code calls, defined below */
+struct vlan_group;
+struct vmklnx_page_pool;
+static void get_random_bytes(void *buf, int nbytes);
+
+/* forward declarations of e1000_hw.h and the top of igb_main.c */
+struct e1000_hw;
+struct igb_adapter;
+static void igb_rar_set_qsel(struct igb_adapter *adapter, u8 *addr,
+                             u32 index, u32 queue);
+static void igb_configure_vmdq(struct igb_adapter *adapter);
+
+#include "igb_vmdq_test.inc"
+
+static const u8 def_mac[ETH_ALEN] = { 0x00, 0x1b, 0x21, 0x00, 0x00, 0x01 };
+static const u8 new_mac[ETH_ALEN] = { 0x00, 0x1b, 0x21, 0x00, 0x00, 0x02 };
+static const u8 vm_mac[NUM_QUEUES][ETH_ALEN] = {
+   { 0 },
+   { 0x00, 0x50, 0x56, 0x00, 0x00, 0x11 },
+   { 0x00, 0x50, 0x56, 0x00, 0x00, 0x12 },
+   { 0x00, 0x50, 0x56, 0x00, 0x00, 0x13 },
+};
+
+static u32 regs[REGS_SIZE / sizeof(u32)];
+static struct igb_adapter adapter;
+static struct igb_ring rings[NUM_QUEUES];
+static struct net_device netdev = { .name = "vmnic0", .addr_len = ETH_ALEN };
+static const char *name;
+
+static void
+get_random_bytes(void *buf, int nbytes)
+{
+   u8 *p = buf;
+
+   while (nbytes-- > 0) {
+      *p++ = rand();
+   }
+}
+
+/*
+ * The device: the queue a frame for @dst with flow hash @hash is put
+ * on, or -1 if it is dropped.
+ */
+static int
+hw_rx_queue(const u8 *dst, u32 hash)
+{
+   struct e1000_hw *hw = &adapter.hw;
+   u32 lo = dst[0] | dst[1] << 8 | dst[2] << 16 | (u32) dst[3] << 24;
+   u32 hi = dst[4] | dst[5] << 8;
+   u32 i, pool, rah = 0;
+   u8 reta;
+   int q;
+
+   for (i = 0; i < NUM_RAR; i++) {
+      rah = E1000_READ_REG(hw, E1000_RAH(i));
+      if ((rah & E1000_RAH_AV) && E1000_READ_REG(hw, E1000_RAL(i)) == lo &&
+          (rah & 0xffff) == hi) {
+         break;
+      }
+   }
+   if (i == NUM_RAR) {
+      return -1;
+   }
+
+   switch (E1000_READ_REG(hw, E1000_MRQC) & E1000_MRQC_ENABLE_MASK) {
+   case E1000_MRQC_ENABLE_RSS_4Q:
+      reta = readb(hw->hw_addr + E1000_RETA(0) + (hash & 127));
+      return hw->mac.type == e1000_82575 ? reta >> 6 : reta & 7;
+   case E1000_MRQC_ENABLE_VMDQ:
+      pool = (rah & E1000_RAH_POOL_MASK) / E1000_RAH_POOL_1;
+      if (hw->mac.type == e1000_82575) {
+         return pool;
+      }
+      for (q = 0; q < 8; q++) {
+         if (pool & (1 << q)) {
+            return q;
+         }
+      }
+      return -1;
+   default:
+      return 0;
+   }
+}
+
+/* igb_reset() and igb_configure(), as far as receive steering goes */
+static void
+reset_configure(void)
+{
+   memset(regs, 0, sizeof(regs));
+   e1000_init_rx_addrs_generic(&adapter.hw, adapter.hw.mac.rar_entry_count);
+   igb_configure_rx(&adapter);
+}
+
+static int
+alloc_queue(void)
+{
+   vmknetddi_queueop_alloc_queue_args_t args = {
+      .netdev = &netdev,
+      .type = VMKNETDDI_QUEUEOPS_QUEUE_TYPE_RX,
+   };
+
+   if (igb_netqueue_ops(VMKNETDDI_QUEUEOPS_OP_ALLOC_QUEUE, &args) !=
+       VMKNETDDI_QUEUEOPS_OK) {
+      fail("%s: no netqueue allocated", name);
+      return 0;
+   }
+   if (args.napi != &adapter.rx_ring[
+          VMKNETDDI_QUEUEOPS_QUEUEID_VAL(args.queueid)].napi) {
+      fail("%s: netqueue handed out with the napi of another ring", name);
+   }
+   return VMKNETDDI_QUEUEOPS_QUEUEID_VAL(args.queueid);
+}
+
+static void
+free_queue(int q)
+{
+   vmknetddi_queueop_free_queue_args_t args = {
+      .netdev = &netdev,
+      .queueid = VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID(q),
+   };
+
+   if (igb_netqueue_ops(VMKNETDDI_QUEUEOPS_OP_FREE_QUEUE, &args) !=
+       VMKNETDDI_QUEUEOPS_OK) {
+      fail("%s: netqueue %d not freed", name, q);
+   }
+}
+
+static int
+apply_filter(int q, const u8 *mac)
+{
+   vmknetddi_queueop_apply_rx_filter_args_t args = {
+      .netdev = &netdev,
+      .queueid = VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID(q),
+   };
+
+   vmknetddi_queueops_set_filter_macaddr(&args.filter, (u8 *) mac);
+   return igb_netqueue_ops(VMKNETDDI_QUEUEOPS_OP_APPLY_RX_FILTER, &args);
+}
+
+static void
+remove_filter(int q)
+{
+   vmknetddi_queueop_remove_rx_filter_args_t args = {
+      .netdev = &netdev,
+      .queueid = VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID(q),
+      .filterid = VMKNETDDI_QUEUEOPS_MK_FILTERID(0),
+   };
+
+   if (igb_netqueue_ops(VMKNETDDI_QUEUEOPS_OP_REMOVE_RX_FILTER, &args) !=
+       VMKNETDDI_QUEUEOPS_OK) {
+      fail("%s: filter of netqueue %d not removed", name, q);
+   }
+}
+
+static void
+set_mac(const u8 *mac)
+{
+   struct sockaddr addr;
+
+   memcpy(addr.sa_data, mac, ETH_ALEN);
+   if (igb_set_mac(&netdev, &addr) != 0) {
+      fail("%s: address change refused", name);
+   }
+}
+
+/* default address traffic is spread over every queue */
+static void
+check_rss(const u8 *mac, const char *what)
+{
+   unsigned int seen = 0;
+   u32 hash;
+   int q;
+
+   for (hash = 0; hash < 1024; hash++) {
+      q = hw_rx_queue(mac, hash * 2654435761u);
+      if (q < 0) {
+         fail("%s %s: default address dropped", name, what);
+         return;
+      }
+      seen |= 1 << q;
+   }
+   if (seen != (1u << adapter.num_rx_queues) - 1) {
+      fail("%s %s: RSS reached queues 0x%x", name, what, seen);
+   }
+}
+
+static void
+check_queue(const u8 *mac, int want, const char *what)
+{
+   int q = hw_rx_queue(mac, 0x12345678);
+
+   if (q != want) {
+      fail("%s %s: frame on queue %d, want %d", name, what, q, want);
+   }
+}
+
+static void
+run(e1000_mac_type type)
+{
+   char what[64];
+   int i, q[NUM_QUEUES];
+
+   name = type == e1000_82575 ? "82575" : "82576";
+   memset(&adapter, 0, sizeof(adapter));
+   memset(rings, 0, sizeof(rings));
+   netdev.priv = &adapter;
+   memcpy(netdev.dev_addr, def_mac, ETH_ALEN);
+
+   /* what igb_probe, igb_sw_init and e1000_init_mac_params_82575 set */
+   adapter.netdev = &netdev;
+   adapter.hw.hw_addr = (u8 *) regs;
+   adapter.hw.mac.type = type;
+   adapter.hw.mac.rar_entry_count = NUM_RAR;
+   adapter.hw.mac.ops.rar_set = e1000_rar_set_generic;
+   memcpy(adapter.hw.mac.addr, def_mac, ETH_ALEN);
+   adapter.flags = IGB_FLAG_VMDQ_ENABLED;
+   adapter.max_frame_size = 1518;
+   adapter.num_rx_queues = NUM_QUEUES;
+   adapter.rx_ring = rings;
+   for (i = 0; i < NUM_QUEUES; i++) {
+      rings[i].adapter = &adapter;
+      rings[i].queue_index = i;
+      rings[i].count = 256;
+   }
+   reset_configure();
+
+   check_rss(def_mac, "idle");
+
+   for (i = 1; i < NUM_QUEUES; i++) {
+      q[i] = alloc_queue();
+      if (apply_filter(q[i], vm_mac[i]) != VMKNETDDI_QUEUEOPS_OK) {
+         fail("%s: filter on netqueue %d refused", name, q[i]);
+      }
+   }
+   if (apply_filter(q[1], vm_mac[2]) == VMKNETDDI_QUEUEOPS_OK) {
+      fail("%s: second filter on netqueue %d taken", name, q[1]);
+   }
+   for (i = 1; i < NUM_QUEUES; i++) {
+      snprintf(what, sizeof(what), "filter %d", i);
+      check_queue(vm_mac[i], q[i], what);
+   }
+   check_queue(def_mac, 0, "vmdq default");
+
+   /* reset with filters applied */
+   reset_configure();
+   for (i = 1; i < NUM_QUEUES; i++) {
+      snprintf(what, sizeof(what), "filter %d after reset", i);
+      check_queue(vm_mac[i], q[i], what);
+   }
+   check_queue(def_mac, 0, "vmdq default after reset");
+
+   set_mac(new_mac);
+   check_queue(new_mac, 0, "vmdq new address");
+
+   /* a removed filter is dropped, the others stay */
+   remove_filter(q[2]);
+   check_queue(vm_mac[2], -1, "removed filter");
+   check_queue(vm_mac[3], q[3], "removed filter");
+
+   for (i = 1; i < NUM_QUEUES; i++) {
+      free_queue(q[i]);
+   }
+   if (apply_filter(q[1], vm_mac[1]) == VMKNETDDI_QUEUEOPS_OK) {
+      fail("%s: filter on a freed netqueue taken", name);
+   }
+   check_rss(new_mac, "all freed");
+   check_queue(vm_mac[1], -1, "all freed");
+
+   reset_configure();
+   check_rss(new_mac, "all freed after reset");
+}
+
+int
+main(void)
+{
+   run(e1000_82575);
+   run(e1000_82576);
+
+   if (failures) {
+      fprintf(stderr, "igb_vmdq_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("igb_vmdq_test: ok\n");
+   return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * itr_replay_sim.c --
+ *
+ *    Trace replay of the adaptive interrupt moderation engine of
+ *    vmware/linux_net.c (vmklnx_itr_init, vmklnx_itr_classify and
+ *    vmklnx_itr_update) with the profiles of ixgbe and tg3.
+ *
+ *    Each trace is a list of rx and tx completions with their arrival
+ *    time and size. The vector's timer fires no sooner than one interval
+ *    after the last interrupt and no sooner than the oldest pending
+ *    completion; the interrupt hands everything pending to the engine,
+ *    the way ixgbe_set_itr_msix does from the NAPI poll. For every trace
+ *    the interrupt rate is reported against the mean time an rx
+ *    completion waited for its interrupt.
+ *
+ *    The test fails if
+ *    - request/response traffic leaves the lowest latency class or waits
+ *      longer than one lowest latency interval;
+ *    - a bulk stream, received or sent, does not settle at the bulk rate;
+ *    - moderate traffic in both directions is moderated as bulk, i.e. rx
+ *      and tx bytes are summed into one class;
+ *    - new thresholds in the driver's profile are not used from the next
+ *      interrupt on;
+ *    - set_interval is called without a rate change, with an interval
+ *      that is not the rate's, or the rate leaves the profile's range.
+ *
+ * extract ../vmware/linux_net.c: vmklnx_itr_init vmklnx_itr_classify vmklnx_itr_update
+ * extract ../../drivers/net/ixgbe/ixgbe_main.c: ixgbe_set_itr_profile
+ * extract ../../drivers/net/tg3/tg3.c: tg3_itr_profile
+ */
+
+#include "stubs.h"
+
+/* what ixgbe_set_itr_profile() uses of the adapter */
+struct ixgbe_adapter {
+   struct vmklnx_itr_profile itr_profile;
+   u16 eitr_low;
+   u16 eitr_high;
+};
+
+void ixgbe_set_itr_profile(struct ixgbe_adapter *adapter);
+
+#include "itr_replay_sim.inc"
+
+/* one completion of a trace, times in usecs */
+struct event {
+   u64 t;
+   u8 dir;
+   u32 bytes;
+};
+
+#define TRACE_USECS     200000
+#define TRACE_MAX       (TRACE_USECS * 2)
+
+static struct event trace[TRACE_MAX];
+static unsigned int traceLen;
+
+static void
+trace_add(u64 t, u8 dir, u32 bytes)
+{
+   if (t < TRACE_USECS && traceLen < TRACE_MAX) {
+      trace[traceLen++] = (struct event){ t, dir, bytes };
+   }
+}
+
+static int
+event_cmp(const void *a, const void *b)
+{
+   const struct event *x = a, *y = b;
+
+   return x->t < y->t ? -1 : x->t > y->t;
+}
+
+/* request/response: a 64 byte request and its reply every 50 usecs */
+static void
+trace_pingpong(void)
+{
+   u64 t;
+
+   for (t = 0; t < TRACE_USECS; t += 50) {
+      trace_add(t, VMKLNX_ITR_RX, 64);
+      trace_add(t + 5, VMKLNX_ITR_TX, 64);
+   }
+}
+
+/* a 10G stream of full frames in dir, acked every fourth frame */
+static void
+trace_bulk(u8 dir)
+{
+   u64 i;
+
+   for (i = 0; i * 12 / 10 < TRACE_USECS; i++) {
+      trace_add(i * 12 / 10, dir, 1514);
+      if ((i & 3) == 3) {
+         trace_add(i * 12 / 10, !dir, 66);
+      }
+   }
+}
+
+/* 150 bytes each way every 10 usecs: 15 bytes/usec per direction */
+static void
+trace_mixed(void)
+{
+   u64 t;
+
+   for (t = 0; t < TRACE_USECS; t += 10) {
+      trace_add(t, VMKLNX_ITR_RX, 150);
+      trace_add(t + 3, VMKLNX_ITR_TX, 150);
+   }
+}
+
+/* the driver's set_interval callback */
+struct vector {
+   struct vmklnx_itr itr;
+   u32 interval;        /* what the hardware is programmed with */
+   u32 lastRate;
+   unsigned long calls;
+   const char *name;
+};
+
+static void
+set_interval(void *data, u32 usecs)
+{
+   struct vector *v = data;
+   const struct vmklnx_itr_profile *p = v->itr.profile;
+
+   v->calls++;
+   if (v->itr.rate == v->lastRate) {
+      fail("%s: set_interval without a rate change", v->name);
+   }
+   if (usecs != max_t(u32, 1000000 / v->itr.rate, 1)) {
+      fail("%s: interval does not match the rate", v->name);
+   }
+   if (v->itr.rate > p->rate[VMKLNX_ITR_LOWEST_LATENCY] ||
+       v->itr.rate < p->rate[VMKLNX_ITR_BULK]) {
+      fail("%s: rate outside the profile", v->name);
+   }
+   v->lastRate = v->itr.rate;
+   v->interval = usecs;
+}
+
+struct result {
+   double intrPerSec;
+   double rxWaitUs;
+   u32 rate;
+   u8 cls[VMKLNX_ITR_NUM_DIRS];
+   double bulkPct;      /* share of interrupts that left it bulk */
+};
+
+/*
+ * Replay the trace through one vector. rxOnly feeds only the rx
+ * completions, as tg3 does. With an ixgbe adapter to retune, its high
+ * threshold is raised half way through, as ixgbe_set_coalesce() does.
+ */
+static struct result
+replay(const char *name, const struct vmklnx_itr_profile *profile,
+       int rxOnly, struct ixgbe_adapter *retune)
+{
+   struct vector v;
+   struct result r;
+   u64 lastIrq = 0, irqs = 0, rxWait = 0, rxCount = 0, bulkIrqs = 0, fire;
+   unsigned int i, first = 0;
+   u16 savedHigh = retune ? retune->eitr_high : 0;
+
+   memset(&v, 0, sizeof(v));
+   v.name = name;
+   vmklnx_itr_init(&v.itr, profile, 0, set_interval, &v);
+   v.lastRate = v.itr.rate;
+   v.interval = 1000000 / v.itr.rate;
+
+   qsort(trace, traceLen, sizeof(trace[0]), event_cmp);
+   for (i = 0; i <= traceLen; i++) {
+      /* fire the interrupts due before the next completion arrives */
+      while (first < i) {
+         fire = max(lastIrq + v.interval, trace[first].t);
+         if (i < traceLen && fire > trace[i].t) {
+            break;
+         }
+         for (; first < i; first++) {
+            if (trace[first].dir == VMKLNX_ITR_RX) {
+               rxWait += fire - trace[first].t;
+               rxCount++;
+            } else if (rxOnly) {
+               continue;
+            }
+            vmklnx_itr_add(&v.itr, trace[first].dir, 1, trace[first].bytes);
+         }
+         lastIrq = fire;
+         irqs++;
+         if (retune && fire >= TRACE_USECS / 2 &&
+             retune->eitr_high == savedHigh) {
+            retune->eitr_high = 60000;
+            ixgbe_set_itr_profile(retune);
+         }
+         vmklnx_itr_update(&v.itr);
+         if (v.itr.cls[VMKLNX_ITR_RX] == VMKLNX_ITR_BULK ||
+             v.itr.cls[VMKLNX_ITR_TX] == VMKLNX_ITR_BULK) {
+            bulkIrqs++;
+         }
+      }
+   }
+   if (retune) {
+      retune->eitr_high = savedHigh;
+      ixgbe_set_itr_profile(retune);
+   }
+
+   r.intrPerSec = irqs * 1000000.0 / TRACE_USECS;
+   r.rxWaitUs = rxCount ? (double)rxWait / rxCount : 0;
+   r.rate = v.itr.rate;
+   r.bulkPct = irqs ? bulkIrqs * 100.0 / irqs : 0;
+   memcpy(r.cls, v.itr.cls, sizeof(r.cls));
+   printf("%-22s %7.0f intr/s %6.1f us rx wait %5.1f%% bulk  rate %6u  "
+          "class rx %u tx %u\n", name, r.intrPerSec, r.rxWaitUs, r.bulkPct,
+          r.rate, r.cls[VMKLNX_ITR_RX], r.cls[VMKLNX_ITR_TX]);
+   return r;
+}
+
+static struct ixgbe_adapter adapter;
+
+static int
+near(u32 rate, u32 want)
+{
+   return rate * 100 >= want * 95 && rate * 100 <= want * 105;
+}
+
+int
+main(void)
+{
+   const struct vmklnx_itr_profile *ixgbe = &adapter.itr_profile;
+   const struct vmklnx_itr_profile *tg3 = &tg3_itr_profile;
+   struct result r;
+
+   /* the thresholds ixgbe_sw_init() starts with */
+   adapter.eitr_low = 10;
+   adapter.eitr_high = 20;
+   ixgbe_set_itr_profile(&adapter);
+
+   traceLen = 0;
+   trace_pingpong();
+   r = replay("ixgbe ping-pong", ixgbe, 0, NULL);
+   if (r.cls[VMKLNX_ITR_RX] != VMKLNX_ITR_LOWEST_LATENCY ||
+       r.cls[VMKLNX_ITR_TX] != VMKLNX_ITR_LOWEST_LATENCY ||
+       r.rate != ixgbe->rate[VMKLNX_ITR_LOWEST_LATENCY]) {
+      fail("ixgbe ping-pong: left the lowest latency class");
+   }
+   if (r.rxWaitUs > 1000000.0 / ixgbe->rate[VMKLNX_ITR_LOWEST_LATENCY]) {
+      fail("ixgbe ping-pong: rx waits longer than one interval");
+   }
+   replay("tg3 ping-pong", tg3, 1, NULL);
+
+   traceLen = 0;
+   trace_bulk(VMKLNX_ITR_RX);
+   r = replay("ixgbe bulk", ixgbe, 0, NULL);
+   if (r.cls[VMKLNX_ITR_RX] != VMKLNX_ITR_BULK ||
+       r.rate != ixgbe->rate[VMKLNX_ITR_BULK] ||
+       r.intrPerSec > ixgbe->rate[VMKLNX_ITR_BULK] * 1.25) {
+      fail("ixgbe bulk: did not settle at the bulk rate");
+   }
+   r = replay("tg3 bulk", tg3, 1, NULL);
+   if (r.cls[VMKLNX_ITR_RX] != VMKLNX_ITR_BULK ||
+       r.cls[VMKLNX_ITR_TX] != VMKLNX_ITR_LOWEST_LATENCY ||
+       r.rate != tg3->rate[VMKLNX_ITR_BULK]) {
+      fail("tg3 bulk: did not settle at the bulk rate");
+   }
+   r = replay("ixgbe bulk, retuned", ixgbe, 0, &adapter);
+   if (r.cls[VMKLNX_ITR_RX] != VMKLNX_ITR_LOW_LATENCY ||
+       !near(r.rate, ixgbe->rate[VMKLNX_ITR_LOW_LATENCY])) {
+      fail("ixgbe bulk, retuned: new thresholds were not used");
+   }
+
+   traceLen = 0;
+   trace_bulk(VMKLNX_ITR_TX);
+   r = replay("ixgbe bulk tx", ixgbe, 0, NULL);
+   if (r.cls[VMKLNX_ITR_TX] != VMKLNX_ITR_BULK ||
+       r.rate != ixgbe->rate[VMKLNX_ITR_BULK]) {
+      fail("ixgbe bulk tx: did not settle at the bulk rate");
+   }
+
+   traceLen = 0;
+   trace_mixed();
+   r = replay("ixgbe mixed rx+tx", ixgbe, 0, NULL);
+   if (r.bulkPct > 10 ||
+       r.intrPerSec < 2 * ixgbe->rate[VMKLNX_ITR_BULK]) {
+      fail("ixgbe mixed rx+tx: moderated as bulk");
+   }
+   replay("tg3 mixed rx+tx", tg3, 1, NULL);
+
+   if (failures) {
+      fprintf(stderr, "itr_replay_sim: %d failures\n", failures);
+      return 1;
+   }
+   printf("itr_replay_sim: ok\n");
+   return 0;
+}
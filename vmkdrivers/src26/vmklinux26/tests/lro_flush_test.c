@@ -0,0 +1,616 @@
+/*
+ * lro_flush_test.c --
+ *
+ *    Test of deferred LRO flushing: the vmklinux LRO engine of
+ *    linux/net/inet_lro.c (lro_receive_skb, lro_flush_all,
+ *    vmklnx_lro_flush_idle) and the napi side of it in
+ *    vmware/linux_net.c (napi_lro_flush, napi_lro_timer_cb), as they
+ *    ship, on a virtual clock.
+ *
+ *    TCP flows over IPv4 and IPv6, some with a VLAN tag, send a few
+ *    segments per napi poll. The test fails if
+ *    - with LRO_F_DEFERRED_FLUSH, sessions do not keep aggregating across
+ *      polls until max_aggr or max_sess_bytes ends them, or without it,
+ *      are not flushed after every poll;
+ *    - a session that stops getting segments is not flushed once it has
+ *      been idle for flush_idle_tc, or is flushed before: after the last
+ *      poll the lro timer has to be armed for the oldest session's
+ *      deadline, and its callback has to wake the worldlet, unless the
+ *      napi context is being disabled;
+ *    - a PSH segment, or one after a lost segment, does not end its
+ *      session, or a PSH segment starts one;
+ *    - a disabled napi context, or one whose timer can not be armed, does
+ *      not flush everything;
+ *    - any flow's bytes reach the stack out of order, twice, or not at
+ *      all, or an aggregated skb's IP length disagrees with its length;
+ *    - the flush reason counters and the session size histogram do not
+ *      add up.
+ *
+ * extract ../../include/linux/if_ether.h: ETH_ALEN ETH_HEADER_TYPE_DIX ETH_HEADER_TYPE_802_1PQ ETH_HEADER_TYPE_802_3 ETH_HEADER_TYPE_802_1PQ_802_3 ETH_P_IP ETH_P_8021Q ETH_P_IPV6 struct ethhdr_llc struct ethhdr
+ * extract ../../include/linux/in.h: enum IPPROTO_IP
+ * extract ../../include/linux/in6.h: struct in6_addr s6_addr32 IPPROTO_HOPOPTS IPPROTO_ROUTING IPPROTO_DSTOPTS
+ * extract ../../include/linux/ip.h: struct iphdr
+ * extract ../../include/net/ip.h: IP_MF IP_OFFSET
+ * extract ../../include/linux/ipv6.h: struct ipv6_opt_hdr struct ipv6hdr
+ * extract ../../include/linux/tcp.h: struct tcphdr
+ * extract ../../include/net/tcp.h: TCPOPT_NOP TCPOPT_TIMESTAMP TCPOLEN_TIMESTAMP after
+ * extract ../../include/net/inet_ecn.h: enum INET_ECN_NOT_ECT INET_ECN_is_ce
+ * extract ../../include/net/dsfield.h: ipv4_get_dsfield ipv6_get_dsfield
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/linux/skbuff.h: CHECKSUM_UNNECESSARY MAX_SKB_FRAGS skb_frag_t struct skb_frag_struct struct skb_shared_info struct sk_buff skb_shinfo skb_headlen __skb_pull skb_pull
+ * extract ../../include/linux/if_vlan.h: struct vlan_ethhdr_llc struct vlan_ethhdr struct vlan_skb_tx_cookie VLAN_RX_COOKIE_MAGIC VLAN_RX_SKB_CB vlan_rx_tag_get vlan_rx_tag_present VLAN_TX_SKB_CB vlan_tx_tag_get __vlan_get_tag
+ * extract ../../include/linux/etherdevice.h: eth_header_type eth_header_len eth_header_frame_type eth_header_is_ipv4
+ * extract ../../include/linux/inet_lro.h: LRO_AGGR_HIST_BUCKETS struct net_lro_stats struct net_lro_desc struct net_lro_mgr
+ * extract ../../include/linux/netdevice.h: NET_RX_SUCCESS NAPI_PUSH_HIST_BUCKETS struct napi_struct enum NAPI_STATE_SCHED
+ * extract ../linux/net/inet_lro.c: TCP_HDR_LEN IP_HDR_LEN TCP_PAYLOAD_LENGTH IPH_LEN_WO_OPTIONS TCPH_LEN_WO_OPTIONS TCPH_LEN_W_TIMESTAMP LRO_INC_STATS IP6_HDR_LEN IP6_EXT_HDR_LEN TCP6_PAYLOAD_LENGTH LRO_IPV6_EXTHDR_HOPOPTS LRO_IPV6_EXTHDR_DSTOPTS LRO_IPV6_EXTHDR_ROUTING vmklnx_lro_ipv6_exthdrs lro_ipv6_get_tcphdr vmklnx_net_lro_get_skb_header lro_tcp_check lro_tcp_ip_check lro_tcp_ip6_check lro_l3_check lro_ip_tot_len lro_tcp_data_len lro_update_tcp_ip_header lro_init_desc lro_clear_desc lro_add_common lro_add_packet lro_check_tcp_conn lro_hash_tuple lro_hash_bucket lro_hash_insert lro_hash_remove lro_get_desc lro_inc_aggr_stats lro_flush __lro_proc_skb lro_receive_skb lro_flush_all vmklnx_lro_flush_idle
+ * extract ../vmware/linux_net.c: napi_lro_timer_cb napi_lro_flush
+ */
+
+#include <errno.h>
+
+#include "stubs.h"
+
+#define TC_PER_US       1000
+#define IDLE_US         50
+#define POLL_US         20
+#define MAX_AGGR        16
+#define MSS             1448
+#define FLOWS           4
+#define SEGS            (1 << 14)
+#define FRAME_LEN       (18 + 40 + 32 + MSS)
+
+typedef int vmk_SpinlockRank;
+#define VMK_SP_RANK_UNRANKED    0
+
+struct sk_buff;
+struct vlan_group;
+
+struct net_device {
+   char name[16];
+   unsigned int mtu;
+};
+
+unsigned int vmklnxLROEnabled = 1;
+
+/* what the extracted code calls, defined below */
+static vmk_TimerCycles vmk_GetTimerCycles(void);
+static vmk_int64 vmk_TimerTCToUS(vmk_TimerRelCycles cycles);
+static VMK_ReturnStatus vmk_TimerModifyOrAdd(vmk_TimerCallback callback,
+                                             vmk_TimerCookie data,
+                                             vmk_int32 timeoutUs,
+                                             vmk_Bool periodic,
+                                             vmk_SpinlockRank rank,
+                                             vmk_Timer *timer,
+                                             vmk_Bool *pending);
+static VMK_ReturnStatus vmk_WorldletActivate(vmk_Worldlet worldlet);
+static void vmk_PktSetLargeTcpPacket(vmk_PktHandle *pkt, vmk_uint32 mss);
+static __sum16 ip_fast_csum(const void *iph, unsigned int ihl);
+static int netif_receive_skb(struct sk_buff *skb);
+static int netif_rx(struct sk_buff *skb);
+static int vlan_hwaccel_receive_skb(struct sk_buff *skb,
+                                    struct vlan_group *grp,
+                                    unsigned short vlan_tag);
+static int vlan_hwaccel_rx(struct sk_buff *skb, struct vlan_group *grp,
+                           unsigned short vlan_tag);
+
+#include "lro_flush_test.inc"
+
+/*
+ * An skb with its frame. lro_add_packet() pulls the headers of the
+ * segments it chains to a session, the frame keeps them for the checks.
+ */
+struct test_skb {
+   struct sk_buff skb;
+   struct skb_shared_info shinfo;
+   vmk_PktHandle pkt;
+   unsigned int mss;            /* vmk_PktSetLargeTcpPacket() */
+   unsigned int flow;
+   u32 seq;
+   unsigned int payload;
+   unsigned char frame[FRAME_LEN];
+};
+
+#define TS(s)           container_of(s, struct test_skb, skb)
+
+static struct test_skb *skbs;
+static unsigned int nSkbs;
+
+static struct {
+   vmk_TimerCycles now;
+   unsigned int activations;    /* vmk_WorldletActivate() */
+   int armFails;                /* vmk_TimerModifyOrAdd() fails */
+   unsigned int armed;          /* timer armed, with timeout ... */
+   vmk_int32 armedUs;           /* ... in us */
+   unsigned long delivered;     /* skbs handed to the stack */
+   unsigned long sessions;      /* ... of them aggregated */
+   u32 sent[FLOWS];             /* bytes of each flow received */
+   u32 nextSeq[FLOWS];          /* ... and handed up */
+   u32 lost[FLOWS];             /* bytes the next skb handed up skips */
+} sim;
+
+static vmk_TimerCycles
+vmk_GetTimerCycles(void)
+{
+   return sim.now;
+}
+
+static vmk_int64
+vmk_TimerTCToUS(vmk_TimerRelCycles cycles)
+{
+   return cycles / TC_PER_US;
+}
+
+static VMK_ReturnStatus
+vmk_TimerModifyOrAdd(vmk_TimerCallback callback, vmk_TimerCookie data,
+                     vmk_int32 timeoutUs, vmk_Bool periodic,
+                     vmk_SpinlockRank rank, vmk_Timer *timer,
+                     vmk_Bool *pending)
+{
+   (void) callback;
+   (void) data;
+   (void) periodic;
+   (void) rank;
+   (void) timer;
+   *pending = VMK_FALSE;
+   if (sim.armFails) {
+      return VMK_NO_RESOURCES;
+   }
+   sim.armed++;
+   sim.armedUs = timeoutUs;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletActivate(vmk_Worldlet worldlet)
+{
+   (void) worldlet;
+   sim.activations++;
+   return VMK_OK;
+}
+
+static void
+vmk_PktSetLargeTcpPacket(vmk_PktHandle *pkt, vmk_uint32 mss)
+{
+   container_of(pkt, struct test_skb, pkt)->mss = mss;
+}
+
+static __sum16
+ip_fast_csum(const void *iph, unsigned int ihl)
+{
+   const u16 *p = iph;
+   u32 sum = 0;
+   unsigned int i;
+
+   for (i = 0; i < ihl * 2; i++) {
+      sum += p[i];
+   }
+   while (sum >> 16) {
+      sum = (sum & 0xffff) + (sum >> 16);
+   }
+   return (__sum16) ~sum;
+}
+
+static int
+netif_rx(struct sk_buff *skb)
+{
+   (void) skb;
+   fail("netif_rx() from a napi lro manager");
+   return 0;
+}
+
+static int
+vlan_hwaccel_receive_skb(struct sk_buff *skb, struct vlan_group *grp,
+                         unsigned short vlan_tag)
+{
+   (void) grp;
+   (void) vlan_tag;
+   return netif_receive_skb(skb);
+}
+
+static int
+vlan_hwaccel_rx(struct sk_buff *skb, struct vlan_group *grp,
+                unsigned short vlan_tag)
+{
+   (void) grp;
+   (void) vlan_tag;
+   return netif_rx(skb);
+}
+
+/* the stack: check and account what lro hands up */
+static int
+netif_receive_skb(struct sk_buff *skb)
+{
+   struct test_skb *ts = TS(skb);
+   struct ethhdr *eh = (struct ethhdr *) ts->frame;
+   unsigned int ipLen = skb->len - eth_header_len(eh);
+   unsigned int n = 1, payload = ts->payload;
+   struct sk_buff *seg;
+   struct iphdr *iph;
+
+   if (!skb->lro_ready) {
+      fail("skb handed up without lro_ready");
+   }
+   for (seg = skb_shinfo(skb)->frag_list; seg != NULL; seg = seg->next) {
+      if (TS(seg)->flow != ts->flow ||
+          TS(seg)->seq != ts->seq + payload) {
+         fail("flow %u: segment at %u chained to a session at %u",
+              ts->flow, TS(seg)->seq, ts->seq);
+      }
+      payload += TS(seg)->payload;
+      n++;
+   }
+   if (sim.lost[ts->flow] != 0 &&
+       ts->seq == sim.nextSeq[ts->flow] + sim.lost[ts->flow]) {
+      sim.nextSeq[ts->flow] = ts->seq;
+      sim.lost[ts->flow] = 0;
+   }
+   if (ts->seq != sim.nextSeq[ts->flow]) {
+      fail("flow %u: %u bytes at %u, expected %u", ts->flow, payload,
+           ts->seq, sim.nextSeq[ts->flow]);
+   }
+   sim.nextSeq[ts->flow] = ts->seq + payload;
+
+   iph = (struct iphdr *) (ts->frame + eth_header_len(eh));
+   if (iph->version == 4 ? ntohs(iph->tot_len) != ipLen :
+       IP6_HDR_LEN + ntohs(((struct ipv6hdr *) iph)->payload_len) != ipLen) {
+      fail("flow %u: ip length of a %u packet session is not %u",
+           ts->flow, n, ipLen);
+   }
+   if (n > 1) {
+      if (ts->mss != MSS || skb_shinfo(skb)->gso_size != MSS) {
+         fail("flow %u: aggregated skb without mss", ts->flow);
+      }
+      sim.sessions++;
+   }
+   sim.delivered++;
+   return NET_RX_SUCCESS;
+}
+
+/* the next segment of a flow, as a driver would hand it to lro */
+static struct sk_buff *
+make_segment(unsigned int flow, u32 seq, int psh)
+{
+   struct test_skb *ts;
+   struct ethhdr *eh;
+   struct tcphdr *th;
+   __be32 *topt;
+   unsigned char *p;
+   unsigned int len;
+
+   VMK_ASSERT(nSkbs < SEGS);
+   ts = &skbs[nSkbs++];
+   memset(ts, 0, offsetof(struct test_skb, frame));
+   ts->flow = flow;
+   ts->seq = seq;
+   ts->payload = MSS;
+
+   p = ts->frame;
+   eh = (struct ethhdr *) p;
+   memset(eh->h_dest, 0x02, ETH_ALEN);
+   memset(eh->h_source, 0x04, ETH_ALEN);
+   if (flow & 2) {
+      /* a tagged frame, lro keys the session by the tag as well */
+      struct vlan_ethhdr *veh = (struct vlan_ethhdr *) p;
+
+      veh->h_vlan_proto = htons(ETH_P_8021Q);
+      veh->h_vlan_TCI = htons(100 + flow);
+      veh->h_vlan_encapsulated_proto = htons(flow & 1 ? ETH_P_IPV6 : ETH_P_IP);
+      p += sizeof(*veh);
+   } else {
+      eh->h_proto = htons(flow & 1 ? ETH_P_IPV6 : ETH_P_IP);
+      p += sizeof(*eh);
+   }
+
+   len = 32 + MSS;
+   if (flow & 1) {
+      struct ipv6hdr *ip6h = (struct ipv6hdr *) p;
+
+      memset(ip6h, 0, sizeof(*ip6h));
+      ip6h->version = 6;
+      ip6h->payload_len = htons(len);
+      ip6h->nexthdr = IPPROTO_TCP;
+      ip6h->hop_limit = 64;
+      ip6h->saddr.s6_addr32[0] = htonl(0xfe800000);
+      ip6h->saddr.s6_addr32[3] = htonl(flow);
+      ip6h->daddr.s6_addr32[0] = htonl(0xfe800000);
+      ip6h->daddr.s6_addr32[3] = htonl(0x100);
+      p += sizeof(*ip6h);
+   } else {
+      struct iphdr *iph = (struct iphdr *) p;
+
+      memset(iph, 0, sizeof(*iph));
+      iph->version = 4;
+      iph->ihl = 5;
+      len += sizeof(*iph);
+      iph->tot_len = htons(len);
+      iph->ttl = 64;
+      iph->protocol = IPPROTO_TCP;
+      iph->saddr = htonl(0x0a000000 + flow);
+      iph->daddr = htonl(0x0a000100);
+      p += sizeof(*iph);
+   }
+
+   th = (struct tcphdr *) p;
+   memset(th, 0, sizeof(*th));
+   th->source = htons(40000 + flow);
+   th->dest = htons(2049);
+   th->seq = htonl(seq);
+   th->ack_seq = htonl(1);
+   th->doff = TCPH_LEN_W_TIMESTAMP;
+   th->ack = 1;
+   th->psh = psh;
+   th->window = htons(512);
+   topt = (__be32 *) (th + 1);
+   topt[0] = htonl((TCPOPT_NOP << 24) | (TCPOPT_NOP << 16) |
+                   (TCPOPT_TIMESTAMP << 8) | TCPOLEN_TIMESTAMP);
+   topt[1] = htonl(1000 + sim.now / TC_PER_US);
+   topt[2] = htonl(7);
+   p += 32;
+   memset(p, flow, MSS);
+   p += MSS;
+
+   ts->skb.data = ts->skb.head = ts->frame;
+   ts->skb.tail = ts->skb.end = p;
+   ts->skb.len = p - ts->frame;
+   ts->skb.truesize = sizeof(ts->frame);
+   ts->skb.ip_summed = CHECKSUM_UNNECESSARY;
+   ts->skb.pkt = &ts->pkt;
+   atomic_set(&ts->skb.users, 1);
+   atomic_set(&ts->shinfo.dataref, 1);
+   return &ts->skb;
+}
+
+static void
+setup(struct napi_struct *napi, struct net_device *dev, int deferred,
+      u32 sessBytes)
+{
+   struct net_lro_mgr *lro_mgr = &napi->lro_mgr;
+
+   /* as netif_napi_add() does */
+   memset(napi, 0, sizeof(*napi));
+   napi->dev = dev;
+   napi->lro_timer = VMK_INVALID_TIMER;
+   lro_mgr->dev = dev;
+   lro_mgr->features = LRO_F_NAPI;
+   lro_mgr->ip_summed = CHECKSUM_UNNECESSARY;
+   lro_mgr->ip_summed_aggr = CHECKSUM_UNNECESSARY;
+   lro_mgr->max_desc = LRO_DEFAULT_MAX_DESC;
+   lro_mgr->lro_arr = napi->lro_desc;
+   lro_mgr->get_skb_header = vmklnx_net_lro_get_skb_header;
+   lro_mgr->max_aggr = MAX_AGGR;
+   lro_mgr->max_sess_bytes = sessBytes;
+   lro_mgr->flush_idle_tc = IDLE_US * TC_PER_US;
+   if (deferred) {
+      lro_mgr->features |= LRO_F_DEFERRED_FLUSH;
+   }
+
+   memset(&sim, 0, sizeof(sim));
+   sim.now = 1000000;
+   nSkbs = 0;
+}
+
+/* a napi poll: segsPerFlow segments of each flow, then the lro flush */
+static void
+poll(struct napi_struct *napi, unsigned int segsPerFlow, int suspend)
+{
+   unsigned int i, f;
+
+   for (i = 0; i < segsPerFlow; i++) {
+      for (f = 0; f < FLOWS; f++) {
+         lro_receive_skb(&napi->lro_mgr, make_segment(f, sim.sent[f], 0),
+                         NULL);
+         sim.sent[f] += MSS;
+      }
+   }
+   napi_lro_flush(napi, suspend);
+}
+
+/* every byte sent was handed up, and the counters add up */
+static void
+check_done(struct napi_struct *napi, const char *what)
+{
+   struct net_lro_stats *st = &napi->lro_mgr.stats;
+   unsigned long hist = 0;
+   unsigned int f, i;
+
+   if (napi->lro_mgr.active_cnt != 0) {
+      fail("%s: %d sessions left open", what, napi->lro_mgr.active_cnt);
+   }
+   for (f = 0; f < FLOWS; f++) {
+      if (sim.nextSeq[f] != sim.sent[f]) {
+         fail("%s: flow %u handed up %u of %u bytes", what, f,
+              sim.nextSeq[f], sim.sent[f]);
+      }
+   }
+   for (i = 0; i < LRO_AGGR_HIST_BUCKETS; i++) {
+      hist += st->aggr_hist[i];
+   }
+   if (hist != st->flushed) {
+      fail("%s: %lu sessions in the histogram, %lu flushed", what, hist,
+           st->flushed);
+   }
+   if (st->aggregated_ipv4 + st->aggregated_ipv6 != st->aggregated) {
+      fail("%s: per family aggregated counts don't add up", what);
+   }
+}
+
+/* polls a few segments apart keep aggregating into sessions of max_aggr */
+static void
+check_deferred(struct napi_struct *napi, struct net_device *dev)
+{
+   struct net_lro_stats *st = &napi->lro_mgr.stats;
+   vmk_TimerCycles suspended;
+   unsigned int i;
+
+   setup(napi, dev, 1, 0);
+   for (i = 0; i < 40; i++) {
+      poll(napi, 3, 0);
+      sim.now += POLL_US * TC_PER_US;
+   }
+   /* 120 segments per flow: 7 sessions of 16, 8 left open */
+   if (st->flushed_budget != 7 * FLOWS || st->flushed != 7 * FLOWS ||
+       st->aggr_hist[4] != 7 * FLOWS) {
+      fail("deferred: %lu sessions ended by max_aggr, expected %u",
+           st->flushed_budget, 7 * FLOWS);
+   }
+   if (napi->lro_mgr.active_cnt != FLOWS) {
+      fail("deferred: %d sessions open, expected %u",
+           napi->lro_mgr.active_cnt, FLOWS);
+   }
+
+   /* the last poll before the worldlet suspends arms the timer */
+   poll(napi, 0, 1);
+   if (sim.armed != 1 || sim.armedUs > IDLE_US + 1) {
+      fail("deferred: timer armed %u times for %dus", sim.armed,
+           sim.armedUs);
+   }
+   napi_lro_timer_cb(napi);
+   if (sim.activations != 1) {
+      fail("deferred: lro timer did not wake the worldlet");
+   }
+
+   /* a poll just before the deadline flushes nothing, one at it all */
+   suspended = sim.now;
+   sim.now = suspended + (sim.armedUs - 2) * TC_PER_US;
+   poll(napi, 0, 0);
+   if (st->flushed_idle != 0) {
+      fail("deferred: %lu sessions flushed before going idle",
+           st->flushed_idle);
+   }
+   sim.now = suspended + sim.armedUs * TC_PER_US;
+   poll(napi, 0, 1);
+   if (st->flushed_idle != FLOWS || st->aggr_hist[3] != FLOWS) {
+      fail("deferred: %lu of %u idle sessions flushed at the deadline",
+           st->flushed_idle, FLOWS);
+   }
+   if (sim.armed != 1) {
+      fail("deferred: timer armed with no session open");
+   }
+   check_done(napi, "deferred");
+   printf("deferred: %lu skbs handed up for %u segments, %.1f per session\n",
+          sim.delivered, nSkbs, (double) nSkbs / sim.delivered);
+}
+
+/* without LRO_F_DEFERRED_FLUSH, every poll flushes */
+static void
+check_per_poll(struct napi_struct *napi, struct net_device *dev)
+{
+   struct net_lro_stats *st = &napi->lro_mgr.stats;
+   unsigned int i;
+
+   setup(napi, dev, 0, 0);
+   for (i = 0; i < 40; i++) {
+      poll(napi, 3, i == 39);
+      sim.now += POLL_US * TC_PER_US;
+   }
+   if (st->flushed != 40 * FLOWS || st->aggr_hist[1] != 40 * FLOWS ||
+       sim.armed != 0) {
+      fail("per poll: %lu sessions flushed, expected %u of 3 packets",
+           st->flushed, 40 * FLOWS);
+   }
+   check_done(napi, "per poll");
+   printf("per poll: %lu skbs handed up for %u segments, %.1f per session\n",
+          sim.delivered, nSkbs, (double) nSkbs / sim.delivered);
+}
+
+/* sessions end at max_sess_bytes, and on a PSH segment */
+static void
+check_psh_and_bytes(struct napi_struct *napi, struct net_device *dev)
+{
+   struct net_lro_stats *st = &napi->lro_mgr.stats;
+   u32 seq = 0;
+   unsigned int i;
+
+   setup(napi, dev, 1, 6 * MSS);
+   for (i = 0; i < 5; i++) {
+      lro_receive_skb(&napi->lro_mgr, make_segment(0, seq, 0), NULL);
+      seq += MSS;
+   }
+   if (st->flushed != 0) {
+      fail("bytes: session of %u bytes ended", 5 * MSS);
+   }
+   lro_receive_skb(&napi->lro_mgr, make_segment(0, seq, 0), NULL);
+   seq += MSS;
+   if (st->flushed_budget != 1 || sim.delivered != 1) {
+      fail("bytes: session not ended at max_sess_bytes");
+   }
+
+   /* a PSH segment neither starts a session ... */
+   lro_receive_skb(&napi->lro_mgr, make_segment(0, seq, 1), NULL);
+   seq += MSS;
+   if (napi->lro_mgr.active_cnt != 0 || sim.delivered != 2 ||
+       st->aggregated != 6) {
+      fail("psh: segment started a session");
+   }
+   /* ... nor lets one go on */
+   lro_receive_skb(&napi->lro_mgr, make_segment(0, seq, 0), NULL);
+   seq += MSS;
+   lro_receive_skb(&napi->lro_mgr, make_segment(0, seq, 1), NULL);
+   seq += MSS;
+   if (st->flushed_psh != 1 || sim.delivered != 3 || sim.sessions != 2) {
+      fail("psh: session not ended by a PSH segment");
+   }
+
+   /* a segment after a lost one ends the session, and goes up alone */
+   lro_receive_skb(&napi->lro_mgr, make_segment(0, seq, 0), NULL);
+   seq += MSS;
+   sim.lost[0] = MSS;
+   lro_receive_skb(&napi->lro_mgr, make_segment(0, seq + MSS, 0), NULL);
+   if (napi->lro_mgr.active_cnt != 0 || st->flushed != 3 ||
+       sim.delivered != 5 || sim.lost[0] != 0) {
+      fail("out of sequence segment did not end the session");
+   }
+   printf("psh and bytes: ok\n");
+}
+
+/* a napi context being disabled, or without a timer, flushes everything */
+static void
+check_flush_all(struct napi_struct *napi, struct net_device *dev)
+{
+   setup(napi, dev, 1, 0);
+   poll(napi, 3, 0);
+   sim.armFails = 1;
+   poll(napi, 3, 1);
+   if (napi->lro_mgr.active_cnt != 0 || napi->lro_mgr.stats.flushed_idle) {
+      fail("sessions kept open without the lro timer");
+   }
+   check_done(napi, "no timer");
+
+   setup(napi, dev, 1, 0);
+   poll(napi, 3, 0);
+   set_bit(NAPI_STATE_DISABLE, &napi->state);
+   poll(napi, 3, 1);
+   if (napi->lro_mgr.active_cnt != 0 || sim.armed != 0) {
+      fail("sessions kept open while disabling napi");
+   }
+   napi_lro_timer_cb(napi);
+   if (sim.activations != 0) {
+      fail("lro timer woke the worldlet of a napi context being disabled");
+   }
+   check_done(napi, "disable");
+   printf("flush all: ok\n");
+}
+
+int
+main(void)
+{
+   static struct napi_struct napi;
+   struct net_device dev;
+
+   memset(&dev, 0, sizeof(dev));
+   strcpy(dev.name, "vmnic0");
+   dev.mtu = 1500;
+   skbs = calloc(SEGS, sizeof(*skbs));
+
+   check_deferred(&napi, &dev);
+   check_per_poll(&napi, &dev);
+   check_psh_and_bytes(&napi, &dev);
+   check_flush_all(&napi, &dev);
+
+   if (failures) {
+      fprintf(stderr, "lro_flush_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("lro_flush_test: ok\n");
+   return 0;
+}
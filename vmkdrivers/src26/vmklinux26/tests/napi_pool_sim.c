@@ -0,0 +1,674 @@
+/*
+ * napi_pool_sim.c --
+ *
+ *    Simulation of the napi worldlet pool of vmklinux as it ships: the
+ *    worldlet handlers napi_poll and netdev_poll, napi_poll_handoff, the
+ *    pool (napi_pool_take, napi_pool_add, napi_pool_return,
+ *    napi_poll_promote), napi_poll_init, netdev_poll_init,
+ *    napi_poll_cleanup, netdev_poll_cleanup, __napi_schedule,
+ *    netif_napi_add, netif_napi_del, napi_disable and napi_enable of
+ *    vmware/linux_net.c.
+ *
+ *    A device adds and deletes napi contexts as a driver does across ring
+ *    reconfigurations and resets, with worldlet creation failing part of
+ *    the time. Interrupts schedule the contexts from vectors that move
+ *    now and then. Worldlets run one at a time in random order, and a
+ *    driver poll may run another worldlet in its middle, as a worldlet
+ *    on another PCPU would. napi_disable() runs the worldlets while it
+ *    waits for them.
+ *
+ *    The test fails if
+ *    - a napi context is polled from two worldlets at once, or after it
+ *      was deleted;
+ *    - the device creates more worldlets than it ever had napi contexts,
+ *      or any while a pool worldlet was free;
+ *    - a napi context goes to the backup worldlet while creation works,
+ *      or stays there once a pool worldlet was free at napi_enable() or
+ *      set aside for it;
+ *    - the backup worldlet is tied to a vector, or a pool worldlet does
+ *      not follow the vector its context is scheduled from;
+ *    - work scheduled on a napi context, packets it gathered, or its
+ *      handoff to a pool worldlet are left without an active worldlet, or
+ *      are never polled, pushed or handed over.
+ *
+ * extract ../../include/linux/poison.h: LIST_POISON1 LIST_POISON2
+ * extract ../../include/linux/list.h: __list_add list_add list_add_tail __list_del list_del list_move_tail list_for_each_safe
+ * extract ../../include/linux/skbuff.h: CHECKSUM_UNNECESSARY
+ * extract ../../include/linux/inet_lro.h: LRO_AGGR_HIST_BUCKETS struct net_lro_stats struct net_lro_desc struct net_lro_mgr LRO_F_NAPI LRO_F_DEFERRED_FLUSH LRO_DEFAULT_MAX_DESC LRO_HASH_BUCKETS
+ * extract ../../include/linux/netdevice.h: NAPI_PUSH_HIST_BUCKETS struct napi_struct enum NAPI_STATE_SCHED napi_disable_pending napi_schedule_prep napi_schedule __napi_complete napi_complete NETIF_F_SW_LRO NETDEV_ALIGN
+ * extract ../vmware/linux_net.c: NAPI_STACK_PUSH_WORK_MIN NAPI_STACK_SKIP_PUSH_MAX NAPI_RX_RATE_SHIFT NAPI_EWMA_SHIFT NapiPollState struct napi_pool_wdt struct LinNetDev LinNetDev get_LinNetDev vmklnxLROEnabled vmklnxLROMaxAggr lroFlushIdleTC vmklnx_lro_session_bytes napi_poll_work_pending napi_poll_account napi_poll napi_poll_handoff netdev_poll napi_pool_take napi_pool_add napi_pool_return napi_poll_promote napi_poll_init netdev_poll_init napi_poll_cleanup netdev_poll_cleanup __napi_schedule napi_disable netif_napi_add netif_napi_del napi_enable
+ */
+
+#include "stubs.h"
+
+#define CONTEXTS_MAX    12
+#define WORLDLETS_MAX   (CONTEXTS_MAX + 1)
+#define PKTS_PER_NAPI   8
+#define STEPS           200000
+#define SEEDS           4
+
+#define module_param(name, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+#define VMK_DEBUG_ONLY(x)
+#define FASTCALL(x)     x
+#define GFP_KERNEL      0
+
+struct sk_buff;
+struct napi_struct;
+struct net_lro_mgr;
+
+enum {
+   NETREG_UNINITIALIZED = 0,
+   NETREG_REGISTERED,
+   NETREG_EARLY_NAPI_ADD_FAILED,
+};
+
+struct net_device {
+   char name[16];
+   unsigned long features;
+   vmk_ModuleID module_id;
+   int reg_state;
+   spinlock_t napi_lock;
+   struct list_head napi_list;
+   vmk_Worldlet napi_worldlet;
+   struct napi_wdt_priv napi_wdt_priv;
+   vmk_Worldlet default_worldlet;
+};
+
+/* what the extracted code calls, defined below */
+static VMK_ReturnStatus vmk_WorldletCreate(vmk_Worldlet *worldlet,
+                                           const char *name,
+                                           vmk_ServiceAcctId serviceID,
+                                           vmk_ModuleID moduleID,
+                                           vmk_WorldletFn worldletFn,
+                                           void *private);
+static VMK_ReturnStatus vmk_WorldletActivate(vmk_Worldlet worldlet);
+static VMK_ReturnStatus vmk_WorldletCheckState(vmk_Worldlet worldlet,
+                                               vmk_WorldletState *state);
+static VMK_ReturnStatus vmk_WorldletShouldYield(vmk_Worldlet worldlet,
+                                                vmk_Bool *yield);
+static VMK_ReturnStatus vmk_WorldletVectorSet(vmk_Worldlet worldlet,
+                                              vmk_uint32 vector);
+static VMK_ReturnStatus vmk_WorldletVectorUnSet(vmk_Worldlet worldlet);
+static VMK_ReturnStatus vmk_WorldletNameSet(vmk_Worldlet worldlet,
+                                            const char *name);
+static VMK_ReturnStatus vmk_WorldletUnref(vmk_Worldlet worldlet);
+static vmk_Bool vmk_ContextIsInterruptHandler(vmk_uint32 *vector);
+static void schedule_timeout_interruptible(long timeout);
+static void napi_stack_push(struct napi_struct *napi);
+static void napi_push_adapt(struct napi_struct *napi);
+static void napi_lro_flush(struct napi_struct *napi, vmk_Bool suspend);
+static void vmklnx_lro_reset(struct net_lro_mgr *lro_mgr);
+static int vmklnx_net_lro_get_skb_header(struct sk_buff *skb, void **iphdr,
+                                         void **tcph, u64 *hdr_flags,
+                                         void *priv);
+
+/* declared in netdevice.h */
+static void __napi_schedule(struct napi_struct *napi);
+
+static vmk_ModuleID vmklinuxModID;
+
+static VMK_ReturnStatus
+vmk_ServiceGetID(const char *name, vmk_ServiceAcctId *serviceID)
+{
+   (void) name;
+   *serviceID = 1;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_TimerRemoveSync(vmk_Timer timer)
+{
+   (void) timer;
+   return VMK_OK;
+}
+
+static vmk_TimerCycles
+vmk_GetTimerCycles(void)
+{
+   static vmk_TimerCycles now;
+
+   return now += 100;
+}
+
+static void *
+kzalloc(size_t size, int flags)
+{
+   (void) flags;
+   return calloc(1, size);
+}
+
+static void
+kfree(const void *p)
+{
+   free((void *) p);
+}
+
+#include "napi_pool_sim.inc"
+
+/* a vmk_Worldlet */
+struct vmk_WorldletInt {
+   vmk_WorldletFn fn;
+   void *priv;
+   int ready;                   /* activated, waiting to run */
+   int running;                 /* its handler is on the stack */
+   vmk_uint32 vector;           /* vmk_WorldletVectorSet(), 0 if none */
+   int backup;
+   int released;
+};
+
+/* a napi context of the driver, with its ring */
+struct sim_napi {
+   struct napi_struct napi;
+   int live;                    /* between netif_napi_add and _del */
+   int enabled;                 /* between napi_enable and napi_disable */
+   unsigned int irq;            /* vector the device raises for it */
+   int pollers;
+   vmk_PktHandle pkts[PKTS_PER_NAPI];
+   vmk_PktList free;            /* packets not in napi->pktList */
+};
+
+#define SN(n)           container_of(n, struct sim_napi, napi)
+
+static struct LinNetDev linDev;
+static struct net_device *dev = &linDev.linNetDev;
+static struct sim_napi napis[CONTEXTS_MAX];
+static struct vmk_WorldletInt worldlets[WORLDLETS_MAX];
+static int nWorldlets;
+static vmk_uint32 curVector;    /* of the interrupt being handled, 0 if none */
+static int createFails;         /* percent of vmk_WorldletCreate() calls */
+static int worldletsMax;        /* vmk_WorldletCreate() fails beyond this */
+static int liveContexts, peakContexts;
+static long polls, pushed;
+
+static int worldlet_step(void);
+
+static int
+pool_has_free(void)
+{
+   struct napi_pool_wdt *wdt;
+
+   list_for_each_entry(wdt, &linDev.napiPool, list) {
+      if (wdt->priv.napi == NULL) {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletCreate(vmk_Worldlet *worldlet, const char *name,
+                   vmk_ServiceAcctId serviceID, vmk_ModuleID moduleID,
+                   vmk_WorldletFn worldletFn, void *private)
+{
+   struct vmk_WorldletInt *w;
+
+   (void) name;
+   (void) serviceID;
+   (void) moduleID;
+   /* the backup worldlet comes first and always works */
+   if (nWorldlets > 0) {
+      if (rand() % 100 < createFails || nWorldlets > worldletsMax) {
+         return VMK_NO_MEMORY;
+      }
+      if (pool_has_free()) {
+         fail("worldlet created while a pool worldlet was free");
+      }
+   }
+   VMK_ASSERT(nWorldlets < WORLDLETS_MAX);
+   w = &worldlets[nWorldlets++];
+   memset(w, 0, sizeof(*w));
+   w->fn = worldletFn;
+   w->priv = private;
+   w->backup = worldletFn == netdev_poll;
+   *worldlet = w;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletActivate(vmk_Worldlet worldlet)
+{
+   VMK_ASSERT(!worldlet->released);
+   worldlet->ready = 1;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletCheckState(vmk_Worldlet worldlet, vmk_WorldletState *state)
+{
+   *state = worldlet->ready || worldlet->running ? VMK_WDT_READY :
+                                                   VMK_WDT_SUSPEND;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletShouldYield(vmk_Worldlet worldlet, vmk_Bool *yield)
+{
+   (void) worldlet;
+   *yield = rand() % 2;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletVectorSet(vmk_Worldlet worldlet, vmk_uint32 vector)
+{
+   if (worldlet->backup) {
+      fail("backup worldlet tied to vector %u", vector);
+   }
+   worldlet->vector = vector;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletVectorUnSet(vmk_Worldlet worldlet)
+{
+   worldlet->vector = 0;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletNameSet(vmk_Worldlet worldlet, const char *name)
+{
+   (void) worldlet;
+   (void) name;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletUnref(vmk_Worldlet worldlet)
+{
+   VMK_ASSERT(!worldlet->running);
+   worldlet->released = 1;
+   return VMK_OK;
+}
+
+static vmk_Bool
+vmk_ContextIsInterruptHandler(vmk_uint32 *vector)
+{
+   *vector = curVector;
+   return curVector != 0;
+}
+
+/* napi_disable() waits for the worldlets, let them run */
+static void
+schedule_timeout_interruptible(long timeout)
+{
+   (void) timeout;
+   if (!worldlet_step()) {
+      fail("napi_disable waits for a context no worldlet will run");
+      exit(1);
+   }
+}
+
+/* the stack takes the packets, the ring gets them back */
+static void
+napi_stack_push(struct napi_struct *napi)
+{
+   struct sim_napi *s = SN(napi);
+
+   pushed += vmk_PktListCount(&napi->pktList);
+   vmk_PktListJoin(&s->free, &napi->pktList);
+}
+
+static void
+napi_push_adapt(struct napi_struct *napi)
+{
+   (void) napi;
+}
+
+static void
+napi_lro_flush(struct napi_struct *napi, vmk_Bool suspend)
+{
+   (void) napi;
+   (void) suspend;
+}
+
+static void
+vmklnx_lro_reset(struct net_lro_mgr *lro_mgr)
+{
+   (void) lro_mgr;
+}
+
+static int
+vmklnx_net_lro_get_skb_header(struct sk_buff *skb, void **iphdr, void **tcph,
+                              u64 *hdr_flags, void *priv)
+{
+   (void) skb;
+   (void) iphdr;
+   (void) tcph;
+   (void) hdr_flags;
+   (void) priv;
+   return -1;
+}
+
+/*
+ * The driver poll routine: it may let another worldlet run in its middle,
+ * gathers a few packets, and completes three times out of four.
+ */
+static int
+sim_poll(struct napi_struct *napi, int budget)
+{
+   struct sim_napi *s = SN(napi);
+   int i, n;
+
+   if (!s->live) {
+      fail("context %d polled after it was deleted", (int) (s - napis));
+   }
+   if (s->pollers++) {
+      fail("context %d polled from two worldlets at once", (int) (s - napis));
+   }
+   if (rand() % 3 == 0) {
+      worldlet_step();
+   }
+   n = rand() % 3;
+   for (i = 0; i < n && !vmk_PktListIsEmpty(&s->free); i++) {
+      vmk_PktListAddToTail(&napi->pktList, vmk_PktListPopHead(&s->free));
+   }
+   s->pollers--;
+   polls++;
+   if (rand() % 4) {
+      napi_complete(napi);
+      return budget / 2;
+   }
+   return budget;
+}
+
+/* run one ready worldlet that is not already running, 0 if there is none */
+static int
+worldlet_step(void)
+{
+   struct vmk_WorldletInt *ready[WORLDLETS_MAX];
+   struct vmk_WorldletInt *w;
+   vmk_WorldletState state;
+   int n = 0, i;
+
+   for (i = 0; i < nWorldlets; i++) {
+      if (worldlets[i].ready && !worldlets[i].running) {
+         ready[n++] = &worldlets[i];
+      }
+   }
+   if (n == 0) {
+      return 0;
+   }
+   w = ready[rand() % n];
+   w->ready = 0;
+   w->running = 1;
+   w->fn(w, w->priv, &state);
+   w->running = 0;
+   if (state == VMK_WDT_READY) {
+      w->ready = 1;
+   }
+   return 1;
+}
+
+static int
+busy_worldlets(void)
+{
+   int i, n = 0;
+
+   for (i = 0; i < nWorldlets; i++) {
+      n += worldlets[i].ready;
+   }
+   return n;
+}
+
+/* napi_enable(), checking it moved the context off the backup if it could */
+static void
+sim_enable(struct sim_napi *s)
+{
+   int hadFree = pool_has_free();
+
+   napi_enable(&s->napi);
+   s->enabled = 1;
+   if (s->napi.dev_poll && s->napi.pool_wdt == NULL && hadFree) {
+      fail("napi_enable left context %d on the backup with a free worldlet",
+           (int) (s - napis));
+   }
+}
+
+static void
+sim_disable(struct sim_napi *s)
+{
+   napi_disable(&s->napi);
+   s->enabled = 0;
+}
+
+static void
+sim_add(struct sim_napi *s)
+{
+   int i;
+
+   memset(s, 0, sizeof(*s));
+   vmk_PktListInit(&s->free);
+   for (i = 0; i < PKTS_PER_NAPI; i++) {
+      vmk_PktListAddToTail(&s->free, &s->pkts[i]);
+   }
+   s->irq = 1 + rand() % 4;
+   netif_napi_add(dev, &s->napi, sim_poll, 64);
+   if (s->napi.dev_poll && createFails == 0 &&
+       (int) linDev.napiPoolSize < worldletsMax) {
+      fail("context %d on the backup worldlet while creation works",
+           (int) (s - napis));
+   }
+   s->live = 1;
+   if (++liveContexts > peakContexts) {
+      peakContexts = liveContexts;
+   }
+   sim_enable(s);
+}
+
+static void
+sim_del(struct sim_napi *s)
+{
+   sim_disable(s);
+   netif_napi_del(&s->napi);
+   s->live = 0;
+   liveContexts--;
+}
+
+/* the device raises the interrupt of a context */
+static void
+sim_interrupt(struct sim_napi *s)
+{
+   int scheduled = !test_bit(NAPI_STATE_SCHED, &s->napi.state) &&
+                   !test_bit(NAPI_STATE_DISABLE, &s->napi.state);
+
+   curVector = s->irq;
+   napi_schedule(&s->napi);
+   curVector = 0;
+   if (scheduled && !s->napi.dev_poll && s->napi.worldlet->vector != s->irq) {
+      fail("pool worldlet on vector %u, its context scheduled from %u",
+           s->napi.worldlet->vector, s->irq);
+   }
+}
+
+/*
+ * Work or packets on a context, or its handoff to a pool worldlet, must
+ * have a worldlet on its way to them.
+ */
+static void
+check_wakeups(void)
+{
+   int i;
+
+   for (i = 0; i < CONTEXTS_MAX; i++) {
+      struct sim_napi *s = &napis[i];
+      int work;
+
+      if (!s->live) {
+         continue;
+      }
+      work = (s->enabled && test_bit(NAPI_STATE_SCHED, &s->napi.state)) ||
+             !vmk_PktListIsEmpty(&s->napi.pktList);
+      if (work && !s->napi.worldlet->ready && !s->napi.worldlet->running) {
+         fail("work on context %d without an active worldlet", i);
+      }
+      if (s->napi.dev_poll && s->napi.pool_wdt != NULL &&
+          !dev->napi_worldlet->ready && !dev->napi_worldlet->running) {
+         fail("context %d waits for its pool worldlet, the backup is idle", i);
+      }
+   }
+}
+
+static void
+check_vectors(void)
+{
+   int i;
+
+   for (i = 0; i < CONTEXTS_MAX; i++) {
+      struct sim_napi *s = &napis[i];
+
+      if (s->live && !s->napi.dev_poll && s->napi.vector &&
+          s->napi.worldlet->vector != s->napi.vector) {
+         fail("pool worldlet on vector %u, its context on %u",
+              s->napi.worldlet->vector, s->napi.vector);
+      }
+   }
+}
+
+static void
+sim(unsigned int seed, int fails, int limit)
+{
+   long step;
+   int i, onBackup = 0, freeWdts = 0, poolSize;
+   struct napi_pool_wdt *wdt;
+
+   srand(seed);
+   memset(&linDev, 0, sizeof(linDev));
+   memset(napis, 0, sizeof(napis));
+   snprintf(dev->name, sizeof(dev->name), "vmnic%u", seed);
+   dev->reg_state = NETREG_REGISTERED;
+   spin_lock_init(&dev->napi_lock);
+   INIT_LIST_HEAD(&dev->napi_list);
+   INIT_LIST_HEAD(&linDev.napiPool);
+   nWorldlets = 0;
+   liveContexts = peakContexts = 0;
+   polls = pushed = 0;
+   createFails = 0;
+   worldletsMax = limit;
+   if (netdev_poll_init(dev) != VMK_OK) {
+      fail("no backup worldlet");
+      return;
+   }
+   createFails = fails;
+
+   for (step = 0; step < STEPS; step++) {
+      struct sim_napi *s = &napis[rand() % CONTEXTS_MAX];
+      int r = rand() % 100;
+
+      if (r < 2) {
+         if (!s->live) {
+            sim_add(s);
+         } else {
+            /*
+             * A reset dropping a ring: napi_disable() and netif_napi_del()
+             * for it, then a restart of the rings left.
+             */
+            sim_del(s);
+            for (i = 0; i < CONTEXTS_MAX; i++) {
+               if (napis[i].live) {
+                  sim_disable(&napis[i]);
+                  sim_enable(&napis[i]);
+               }
+            }
+         }
+      } else if (r < 4) {
+         if (s->live) {
+            sim_disable(s);
+            sim_enable(s);
+         }
+      } else if (r < 5) {
+         /* the vector moves to another PCPU */
+         s->irq = 1 + rand() % 4;
+      } else if (r < 30) {
+         if (s->live) {
+            sim_interrupt(s);
+         }
+      } else {
+         worldlet_step();
+      }
+      check_wakeups();
+      if ((step % 1000) == 0) {
+         check_vectors();
+      }
+   }
+
+   /* let everything settle */
+   for (i = 0; i < CONTEXTS_MAX; i++) {
+      if (napis[i].live) {
+         sim_disable(&napis[i]);
+         sim_enable(&napis[i]);
+      }
+   }
+   for (step = 0; step < STEPS && busy_worldlets(); step++) {
+      worldlet_step();
+   }
+
+   for (i = 0; i < CONTEXTS_MAX; i++) {
+      struct sim_napi *s = &napis[i];
+
+      if (!s->live) {
+         continue;
+      }
+      if (test_bit(NAPI_STATE_SCHED, &s->napi.state) ||
+          !vmk_PktListIsEmpty(&s->napi.pktList)) {
+         fail("work on context %d never polled or pushed", i);
+      }
+      if (s->napi.dev_poll && s->napi.pool_wdt != NULL) {
+         fail("context %d never handed over to its pool worldlet", i);
+      }
+      onBackup += s->napi.dev_poll;
+   }
+   list_for_each_entry(wdt, &linDev.napiPool, list) {
+      freeWdts += wdt->priv.napi == NULL;
+   }
+   if (onBackup && freeWdts) {
+      fail("%d contexts left on the backup worldlet with %d pool worldlets "
+           "free", onBackup, freeWdts);
+   }
+   poolSize = linDev.napiPoolSize;
+   if (poolSize > peakContexts) {
+      fail("%d worldlets for at most %d napi contexts", poolSize,
+           peakContexts);
+   }
+   check_vectors();
+
+   printf("napi_pool: seed %u, create fails %2d%%, at most %2d: %2d worldlets "
+          "for %2d contexts at peak, %6ld polls, %6ld packets pushed, "
+          "%d on backup at the end\n",
+          seed, fails, limit, poolSize, peakContexts, polls, pushed,
+          onBackup);
+
+   /* the device goes away */
+   for (i = 0; i < CONTEXTS_MAX; i++) {
+      if (napis[i].live) {
+         sim_disable(&napis[i]);
+      }
+   }
+   netdev_poll_cleanup(dev);
+   for (i = 0; i < nWorldlets; i++) {
+      if (!worldlets[i].released) {
+         fail("worldlet %d left behind", i);
+      }
+   }
+}
+
+int
+main(void)
+{
+   unsigned int seed;
+
+   for (seed = 1; seed <= SEEDS; seed++) {
+      sim(seed, 0, CONTEXTS_MAX);
+      sim(seed, 30, CONTEXTS_MAX);
+      /* fewer worldlets than contexts, the backup takes the overflow */
+      sim(seed, 10, CONTEXTS_MAX / 2);
+   }
+
+   if (failures) {
+      fprintf(stderr, "napi_pool: %d failures\n", failures);
+      return 1;
+   }
+   printf("napi_pool: ok\n");
+   return 0;
+}
@@ -0,0 +1,372 @@
+/*
+ * napi_push_sim.c --
+ *
+ *    Simulation of the adaptive napi stack push batching of
+ *    vmware/linux_net.c as it ships: the napi_poll worldlet handler with
+ *    napi_poll_work_pending, napi_poll_account, napi_push_adapt and
+ *    napi_stack_push.
+ *
+ *    A napi context is driven by a synthetic arrival process in simulated
+ *    time, one timer cycle being one ns. The driver poll routine moves up
+ *    to the weight of packets from the device ring to the napi list and
+ *    completes when it drains the ring; an arrival after that raises the
+ *    interrupt that schedules the context again. Polls and stack pushes
+ *    cost a fixed plus a per packet amount. For a bulk flow, a sparse RPC
+ *    flow and a mix of both, the simulation runs with the default module
+ *    parameters and with batching turned off by them
+ *    (vmklnx_napi_push_latency_us and vmklnx_napi_push_batch_max 0, i.e.
+ *    a push of every list of more than NAPI_STACK_PUSH_WORK_MIN packets
+ *    and no poll skipped), and reports the pushes, mean pushed batch and
+ *    the hold time of packets between poll and push.
+ *
+ *    It fails if:
+ *    - the adaptive thresholds leave their bounds;
+ *    - a packet is held past the latency budget plus one poll;
+ *    - for the bulk flow the adaptive policy does not push bigger batches
+ *      than with batching turned off;
+ *    - for the sparse flow it holds packets noticeably (10%) longer on
+ *      average than with batching turned off;
+ *    - the push histogram or the rx counters miss a push or a packet.
+ *
+ * extract ../../include/vmklinux26/vmknetddinetq.h: vmknetddi_queueops_queue_t VMKNETDDI_QUEUEOPS_QUEUEID_VAL VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID
+ * extract ../../include/linux/inet_lro.h: LRO_AGGR_HIST_BUCKETS struct net_lro_stats struct net_lro_desc struct net_lro_mgr LRO_DEFAULT_MAX_DESC
+ * extract ../../include/linux/netdevice.h: enum netdev_drop_reason struct netdev_queue_stats NETDEV_STATS_RX_QUEUES NAPI_PUSH_HIST_BUCKETS struct napi_struct enum NAPI_STATE_SCHED napi_disable_pending napi_schedule_prep napi_schedule __napi_complete napi_complete NETIF_F_SW_LRO
+ * extract ../vmware/linux_net.c: NAPI_STACK_PUSH_WORK_MIN NAPI_STACK_SKIP_PUSH_MAX NAPI_STACK_SKIP_PUSH_LIMIT NAPI_RX_RATE_SHIFT NAPI_EWMA_SHIFT NapiPollState vmklnx_napi_push_latency_us vmklnx_napi_push_batch_max napiPushLatencyTC netdev_rx_stats_get netdev_stats_put napi_poll_work_pending napi_push_adapt napi_poll_account napi_stack_push napi_poll
+ */
+
+#include <math.h>
+
+#include "stubs.h"
+
+/* simulated costs, in ns */
+#define POLL_COST_BASE   2000
+#define POLL_COST_PKT    60
+#define PUSH_COST_BASE   1500
+#define PUSH_COST_PKT    120
+#define NAPI_WEIGHT      64
+#define RING_SIZE        4096
+
+#define SIM_TIME_NS      (200 * 1000 * 1000LL)
+
+#define module_param(name, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+#define FASTCALL(x)     x
+
+typedef struct vmk_UplinkInt vmk_Uplink;
+
+struct sk_buff;
+struct net_lro_mgr;
+
+struct net_device {
+   char name[16];
+   unsigned long features;
+   vmk_ModuleID module_id;
+   vmk_Uplink *uplinkDev;
+   struct netdev_queue_stats **linnet_stats;
+};
+
+/* what the extracted code calls, defined below */
+static vmk_TimerCycles vmk_GetTimerCycles(void);
+static VMK_ReturnStatus vmk_WorldletShouldYield(vmk_Worldlet worldlet,
+                                                vmk_Bool *yield);
+static void vmk_PktListRxProcess(vmk_PktList *pktList, vmk_Uplink *uplink);
+static void napi_lro_flush(struct napi_struct *napi, vmk_Bool suspend);
+
+/* declared in netdevice.h */
+static void __napi_schedule(struct napi_struct *napi);
+
+#include "napi_push_sim.inc"
+
+enum flow { FLOW_BULK, FLOW_SPARSE, FLOW_MIXED };
+
+static const char *flowName[] = { "bulk", "sparse", "mixed" };
+
+struct result {
+   unsigned long pushes;
+   unsigned long pushed;
+   int64_t       maxHold;
+   double        meanHold;
+   unsigned int  maxPushMin;
+   unsigned int  maxSkip;
+   unsigned int  minPushMin;
+};
+
+static struct net_device dev = { .name = "vmnic0", .features = NETIF_F_SW_LRO };
+static struct netdev_queue_stats rxStats[NETDEV_STATS_RX_QUEUES];
+static struct netdev_queue_stats *pcpuStats[1] = { rxStats };
+static struct napi_struct napi;
+
+/* the packets, in the device ring, the napi list or free */
+static vmk_PktHandle pkts[RING_SIZE];
+static int64_t polledAt[RING_SIZE];
+static vmk_PktList freePkts, ring;
+
+static struct {
+   enum flow flow;
+   int64_t now;
+   int64_t arrival;             /* of the next packet */
+   int active;                  /* the worldlet is activated */
+   double holdSum;
+   struct result *res;
+} sim;
+
+static double
+uniform(void)
+{
+   return (random() + 1.0) / ((double)RAND_MAX + 2.0);
+}
+
+/* next arrival time after now */
+static int64_t
+next_arrival(enum flow flow, int64_t now)
+{
+   switch (flow) {
+   case FLOW_BULK:
+      /* ~1.5 Mpps, in bursts of back to back frames */
+      return now + (random() % 8 ? 300 : 3000);
+   case FLOW_SPARSE:
+      /* ~20 kpps of single requests, exponential gaps */
+      return now + (int64_t)(-50000.0 * log(uniform()));
+   case FLOW_MIXED:
+   default:
+      /* alternating 5 ms phases of the two */
+      return ((now / 5000000) & 1) ? next_arrival(FLOW_SPARSE, now)
+                                   : next_arrival(FLOW_BULK, now);
+   }
+}
+
+/*
+ * Let time pass: packets land in the ring, dropped if it is full, and
+ * raise the interrupt unless the context is scheduled already.
+ */
+static void
+sim_advance(int64_t cycles)
+{
+   sim.now += cycles;
+   while (sim.arrival <= sim.now) {
+      if (!vmk_PktListIsEmpty(&freePkts)) {
+         vmk_PktListAddToTail(&ring, vmk_PktListPopHead(&freePkts));
+      }
+      sim.arrival = next_arrival(sim.flow, sim.arrival);
+   }
+   if (!vmk_PktListIsEmpty(&ring)) {
+      napi_schedule(&napi);
+   }
+}
+
+static vmk_TimerCycles
+vmk_GetTimerCycles(void)
+{
+   return sim.now;
+}
+
+static VMK_ReturnStatus
+vmk_WorldletShouldYield(vmk_Worldlet worldlet, vmk_Bool *yield)
+{
+   (void) worldlet;
+   *yield = sim.now >= SIM_TIME_NS;
+   return VMK_OK;
+}
+
+static void
+__napi_schedule(struct napi_struct *n)
+{
+   VMK_ASSERT(n == &napi);
+   sim.active = 1;
+}
+
+static void
+napi_lro_flush(struct napi_struct *n, vmk_Bool suspend)
+{
+   (void) n;
+   (void) suspend;
+   fail("lro flush of a device with software lro");
+}
+
+/* the stack takes the packets, the ring gets them back */
+static void
+vmk_PktListRxProcess(vmk_PktList *pktList, vmk_Uplink *uplink)
+{
+   vmk_uint32 count = vmk_PktListCount(pktList);
+   vmk_PktHandle *pkt;
+
+   (void) uplink;
+   sim_advance(PUSH_COST_BASE + PUSH_COST_PKT * (int64_t) count);
+   for (pkt = vmk_PktListGetHead(pktList); pkt != NULL;
+        pkt = vmk_PktListGetNext(pktList, pkt)) {
+      int64_t hold = sim.now - polledAt[pkt - pkts];
+
+      sim.holdSum += hold;
+      sim.res->maxHold = max(sim.res->maxHold, hold);
+   }
+   sim.res->pushes++;
+   sim.res->pushed += count;
+   vmk_PktListJoin(&freePkts, pktList);
+}
+
+/* the driver poll routine */
+static int
+sim_poll(struct napi_struct *n, int budget)
+{
+   vmk_PktList polled;
+   int got = 0;
+
+   sim.res->maxPushMin = max(sim.res->maxPushMin, n->push_min);
+   sim.res->minPushMin = min(sim.res->minPushMin, n->push_min);
+   sim.res->maxSkip = max(sim.res->maxSkip, n->push_skip_max);
+
+   vmk_PktListInit(&polled);
+   while (got < budget && !vmk_PktListIsEmpty(&ring)) {
+      vmk_PktListAddToTail(&polled, vmk_PktListPopHead(&ring));
+      got++;
+   }
+   sim_advance(POLL_COST_BASE + POLL_COST_PKT * got);
+   while (!vmk_PktListIsEmpty(&polled)) {
+      vmk_PktHandle *pkt = vmk_PktListPopHead(&polled);
+
+      polledAt[pkt - pkts] = sim.now;
+      vmk_PktListAddToTail(&n->pktList, pkt);
+   }
+
+   /* the ring was drained: napi_complete and enable the interrupt */
+   if (got < budget) {
+      napi_complete(n);
+      sim_advance(0);
+   }
+   return got;
+}
+
+/*
+ * Run the napi_poll worldlet against the arrival process. The hold time
+ * of a packet is the time from its poll to its push, the part the push
+ * policy controls.
+ */
+static void
+simulate(enum flow flow, int batching, struct result *res)
+{
+   vmk_WorldletState state;
+   int i;
+
+   memset(res, 0, sizeof(*res));
+   memset(&sim, 0, sizeof(sim));
+   memset(rxStats, 0, sizeof(rxStats));
+   res->minPushMin = ~0U;
+   sim.flow = flow;
+   sim.res = res;
+
+   if (batching) {
+      vmklnx_napi_push_latency_us = 100;
+      vmklnx_napi_push_batch_max = 64;
+   } else {
+      vmklnx_napi_push_latency_us = 0;
+      vmklnx_napi_push_batch_max = 0;
+   }
+   /* as the module init does */
+   napiPushLatencyTC = max(vmklnx_napi_push_latency_us, 0) * 1000LL;
+
+   /* as netif_napi_add does */
+   memset(&napi, 0, sizeof(napi));
+   napi.weight = NAPI_WEIGHT;
+   napi.poll = sim_poll;
+   napi.dev = &dev;
+   napi.napi_wdt_priv.dev = &dev;
+   napi.napi_wdt_priv.napi = &napi;
+   vmk_PktListInit(&napi.pktList);
+   napi.push_min = NAPI_STACK_PUSH_WORK_MIN;
+   napi.push_skip_max = NAPI_STACK_SKIP_PUSH_MAX;
+
+   vmk_PktListInit(&freePkts);
+   vmk_PktListInit(&ring);
+   for (i = 0; i < RING_SIZE; i++) {
+      vmk_PktListAddToTail(&freePkts, &pkts[i]);
+   }
+
+   srandom(7);
+   sim.arrival = next_arrival(flow, 0);
+   while (sim.now < SIM_TIME_NS) {
+      /* worldlet asleep: the next interrupt schedules the napi context */
+      if (!sim.active) {
+         sim_advance(sim.arrival - sim.now);
+      }
+      sim.active = 0;
+      napi_poll(NULL, &napi.napi_wdt_priv, &state);
+      if (state == VMK_WDT_READY) {
+         sim.active = 1;
+      }
+   }
+   res->meanHold = res->pushed ? sim.holdSum / res->pushed : 0;
+
+   for (i = 0; i < NAPI_PUSH_HIST_BUCKETS; i++) {
+      res->pushes -= napi.push_hist[i];
+   }
+   if (res->pushes != 0) {
+      fail("%s: push histogram misses %ld pushes", flowName[flow],
+           (long) res->pushes);
+   }
+   for (i = 0; i < NAPI_PUSH_HIST_BUCKETS; i++) {
+      res->pushes += napi.push_hist[i];
+   }
+   if (rxStats[0].packets != res->pushed ||
+       rxStats[0].batches != res->pushes) {
+      fail("%s: rx counters do not match the pushes", flowName[flow]);
+   }
+}
+
+int
+main(void)
+{
+   int64_t bound;
+   int f;
+
+   printf("%-7s %-9s %9s %10s %8s %10s %10s\n", "flow", "policy", "pushes",
+          "mean batch", "max min", "mean hold", "max hold");
+
+   dev.linnet_stats = pcpuStats;
+   for (f = FLOW_BULK; f <= FLOW_MIXED; f++) {
+      struct result fixed, adapt;
+
+      simulate(f, 0, &fixed);
+      simulate(f, 1, &adapt);
+
+      printf("%-7s %-9s %9lu %10.2f %8u %8.1fus %8.1fus\n", flowName[f],
+             "unbatched", fixed.pushes, (double)fixed.pushed / fixed.pushes,
+             fixed.maxPushMin, fixed.meanHold / 1000,
+             fixed.maxHold / 1000.0);
+      printf("%-7s %-9s %9lu %10.2f %8u %8.1fus %8.1fus\n", flowName[f],
+             "adaptive", adapt.pushes, (double)adapt.pushed / adapt.pushes,
+             adapt.maxPushMin, adapt.meanHold / 1000,
+             adapt.maxHold / 1000.0);
+
+      if (adapt.minPushMin < NAPI_STACK_PUSH_WORK_MIN ||
+          adapt.maxPushMin > (unsigned int)vmklnx_napi_push_batch_max ||
+          adapt.maxSkip > NAPI_STACK_SKIP_PUSH_LIMIT) {
+         fail("%s: thresholds out of bounds (min %u..%u skip %u)",
+              flowName[f], adapt.minPushMin, adapt.maxPushMin, adapt.maxSkip);
+      }
+
+      /* a held list is pushed at most one poll after the budget ran out */
+      bound = vmklnx_napi_push_latency_us * 1000LL +
+              POLL_COST_BASE + POLL_COST_PKT * NAPI_WEIGHT +
+              PUSH_COST_BASE + PUSH_COST_PKT * vmklnx_napi_push_batch_max;
+      if (adapt.maxHold > bound) {
+         fail("%s: packet held %.1fus, budget %dus", flowName[f],
+              adapt.maxHold / 1000.0, vmklnx_napi_push_latency_us);
+      }
+
+      if (f == FLOW_BULK &&
+          (double)adapt.pushed / adapt.pushes <=
+          (double)fixed.pushed / fixed.pushes) {
+         fail("bulk: adaptive batches are not larger");
+      }
+      if (f == FLOW_SPARSE && adapt.meanHold > fixed.meanHold * 1.1) {
+         fail("sparse: adaptive holds packets longer");
+      }
+   }
+
+   if (failures) {
+      fprintf(stderr, "napi_push_sim: %d failures\n", failures);
+      return 1;
+   }
+   printf("napi_push_sim: ok\n");
+   return 0;
+}
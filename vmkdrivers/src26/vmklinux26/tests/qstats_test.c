@@ -0,0 +1,640 @@
+/*
+ * qstats_test.c --
+ *
+ *    Test of the per-queue, per-PCPU uplink counters of
+ *    vmware/linux_net.c as they ship: the rx accounting of netif_rx,
+ *    netif_receive_skb and napi_stack_push, the drop accounting of
+ *    netif_rx_common, netdev_tx_queue, block_tx_soft_queue and
+ *    stop_tx_soft_queue, netdev_stats_fold and netdev_ifr_data.
+ *
+ *    The test fails if
+ *    - the folded rx counters of napi contexts on several PCPUs miss or
+ *      double count a packet, a byte, a drop or a stack push;
+ *    - the napi receive path disables interrupts more than once per stack
+ *      push, i.e. counts packets one by one;
+ *    - a blocked device, a blocked, stopped or full queue, or a queue torn
+ *      down by block/stop, charges its drops to the wrong reason, or
+ *      block/stop leave packets in the tx staging ring;
+ *    - ifr_data of a 32-bit caller is not found through struct ifreq32.
+ *
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_types.h: vmk_IoctlCallerSize
+ * extract ../../include/linux/socket.h: sa_family_t struct sockaddr
+ * extract ../../include/linux/if.h: IFNAMSIZ
+ * extract ../../include/linux/hdlc/ioctl.h: sync_serial_settings te1_settings raw_hdlc_proto fr_proto fr_proto_pvc fr_proto_pvc_info cisco_proto
+ * extract ../../include/linux/if.h: struct if_settings struct ifreq ifr_data
+ * extract ../../include/linux/compat.h: struct ifmap32 struct ifreq32
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/vmklinux26/vmknetddinetq.h: vmknetddi_queueops_queue_t VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID VMKNETDDI_QUEUEOPS_QUEUEID_VAL VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID
+ * extract ../../include/linux/skbuff.h: CHECKSUM_NONE MAX_SKB_FRAGS skb_frag_t struct skb_frag_struct struct skb_shared_info struct sk_buff skb_shinfo skb_headroom skb_headlen
+ * extract ../../include/linux/if_vlan.h: struct vlan_skb_tx_cookie VLAN_RX_COOKIE_MAGIC VLAN_RX_SKB_CB vlan_rx_tag_get vlan_rx_tag_present VLAN_TX_SKB_CB vlan_tx_tag_get VLAN_VID_MASK VLAN_MAX_VALID_VID VLAN_1PTAG_MASK VLAN_1PTAG_SHIFT
+ * extract ../../include/linux/inet_lro.h: LRO_AGGR_HIST_BUCKETS struct net_lro_stats struct net_lro_desc struct net_lro_mgr
+ * extract ../../include/linux/netdevice.h: NET_RX_SUCCESS NET_RX_DROP enum netdev_state_t NETDEV_TX_STAGE_SLOTS struct netdev_tx_stage_slot struct netdev_tx_stage struct netdev_soft_queue enum netdev_drop_reason struct netdev_queue_stats NETDEV_STATS_RX_QUEUES struct netdev_queue NAPI_PUSH_HIST_BUCKETS struct napi_struct NETIF_F_SW_LRO
+ * extract ../vmware/linux_net.c: NAPI_EWMA_SHIFT enum LIN_NET_QUEUE_UNBLOCKED vmklnx_tx_stage netdev_rx_stats_get netdev_tx_stats_get netdev_stats_put netdev_rx_stats_drop netdev_tx_stats_drop netdev_stats_fold netif_rx_common netif_rx netif_receive_skb napi_stack_push netdev_tx_stages_create netdev_tx_stage_drain netdev_tx_stage_put netdev_queue_tx_pkts_locked netdev_tx_queue block_tx_soft_queue stop_tx_soft_queue netdev_ifr_data
+ */
+
+#include "stubs.h"
+
+#define NR_PCPUS        4
+#define NR_POLLS        20000
+#define POLL_MAX        64
+#define OUTPUT_MAX      100
+
+typedef uint32_t compat_caddr_t;
+typedef int32_t compat_int_t;
+typedef uint32_t compat_ulong_t;
+typedef struct vmk_UplinkInt vmk_Uplink;
+
+#define GFP_KERNEL      0
+#define NETIF_F_TSO     (1 << 16)
+#define NETIF_F_TSO6    (1 << 20)
+
+struct sk_buff;
+struct net_lro_mgr;
+
+struct net_device {
+   char name[16];
+   unsigned long state;
+   unsigned long features;
+   vmk_PktCompletionData genCount;
+   atomic_t rxInFlight;
+   struct list_head napi_list;
+   vmk_Uplink *uplinkDev;
+   struct netdev_queue *_tx;
+   unsigned int num_tx_queues;
+   struct netdev_queue_stats **linnet_stats;
+};
+
+unsigned int vmklnxLROEnabled;
+
+/* what the extracted code calls, defined below */
+static vmk_uint32 vmk_NumPCPUs(void);
+static vmk_TimerCycles vmk_GetTimerCycles(void);
+static void *kzalloc(size_t size, int flags);
+static VMK_ReturnStatus vmk_PktAdjust(vmk_PktHandle *pkt, vmk_uint32 offset,
+                                      vmk_uint32 len);
+static VMK_ReturnStatus vmk_PktAppend(vmk_PktHandle *pkt,
+                                      vmk_PktHandle *fragPkt,
+                                      vmk_uint32 offset, vmk_uint32 len);
+static void vmk_PktSetCompletionData(vmk_PktHandle *pkt, void *data,
+                                     vmk_PktCompletionData genCount,
+                                     vmk_Bool nonCompl);
+static void vmk_PktClearCompletionData(vmk_PktHandle *pkt);
+static VMK_ReturnStatus vmk_PktFrameLenSet(vmk_PktHandle *pkt,
+                                           vmk_uint32 len);
+static vmk_uint16 vmk_PktVlanIDGet(vmk_PktHandle *pkt);
+static VMK_ReturnStatus vmk_PktVlanIDSet(vmk_PktHandle *pkt,
+                                         vmk_uint16 vlanID);
+static VMK_ReturnStatus vmk_PktPrioritySet(vmk_PktHandle *pkt,
+                                           vmk_uint8 priority);
+static void vmk_PktSetCsumVfd(vmk_PktHandle *pkt);
+static void vmk_PktQueueForRxProcess(vmk_PktHandle *pkt,
+                                     vmk_Uplink *uplink);
+static void vmk_PktListRxProcess(vmk_PktList *pktList, vmk_Uplink *uplink);
+static void vmk_PktListReleasePkts(vmk_PktList *pktList);
+static VMK_ReturnStatus vmk_WorldletGetCurrent(vmk_Worldlet *worldlet,
+                                               void **private);
+static int vmklnx_is_panic(void);
+static void LinStress_CorruptSkbData(struct sk_buff *skb, unsigned int n,
+                                     unsigned int off);
+static void LinStress_CorruptRxData(vmk_PktHandle *pkt,
+                                    struct sk_buff *skb);
+static void LinStress_CorruptEthHdr(struct sk_buff *skb);
+static void do_free_skb(struct sk_buff *skb);
+static void dev_kfree_skb_any(struct sk_buff *skb);
+static int lro_receive_skb(struct net_lro_mgr *lro_mgr, struct sk_buff *skb,
+                           void *priv);
+static void netdev_tx_sw_gso(struct net_device *dev, vmk_PktList *pktList,
+                             vmk_PktList *freeList);
+static VMK_ReturnStatus netdev_tx_stage(struct netdev_queue *queue,
+                                        vmk_PktList *pktList,
+                                        vmk_PktList *freeList);
+static void process_tx_queue(struct netdev_queue *queue,
+                             vmk_PktList *freePktsList);
+static void *compat_ptr(compat_caddr_t uptr);
+
+#include "qstats_test.inc"
+
+/* what a PCPU saw go by; each is only written by its own thread */
+struct pcpu_sim {
+   unsigned long delivered, bytes, dropped, pushes, pushedPkts;
+   unsigned long freedSkbs, irqSaves;
+};
+
+static struct net_device dev;
+static struct netdev_queue txq[2];
+static struct pcpu_sim sim[NR_PCPUS];
+static unsigned long released;  /* vmk_PktListReleasePkts() */
+
+static vmk_uint32
+vmk_NumPCPUs(void)
+{
+   return NR_PCPUS;
+}
+
+static vmk_TimerCycles
+vmk_GetTimerCycles(void)
+{
+   return 0;
+}
+
+static void *
+kzalloc(size_t size, int flags)
+{
+   (void) flags;
+   return calloc(1, size);
+}
+
+static VMK_ReturnStatus
+vmk_PktAdjust(vmk_PktHandle *pkt, vmk_uint32 offset, vmk_uint32 len)
+{
+   (void) pkt;
+   (void) offset;
+   (void) len;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_PktAppend(vmk_PktHandle *pkt, vmk_PktHandle *fragPkt, vmk_uint32 offset,
+              vmk_uint32 len)
+{
+   (void) pkt;
+   (void) fragPkt;
+   (void) offset;
+   (void) len;
+   fail("an skb with a frag_list");
+   return VMK_FAILURE;
+}
+
+static void
+vmk_PktSetCompletionData(vmk_PktHandle *pkt, void *data,
+                         vmk_PktCompletionData genCount, vmk_Bool nonCompl)
+{
+   (void) pkt;
+   (void) data;
+   (void) genCount;
+   (void) nonCompl;
+}
+
+static void
+vmk_PktClearCompletionData(vmk_PktHandle *pkt)
+{
+   (void) pkt;
+}
+
+static VMK_ReturnStatus
+vmk_PktFrameLenSet(vmk_PktHandle *pkt, vmk_uint32 len)
+{
+   (void) pkt;
+   (void) len;
+   return VMK_OK;
+}
+
+static vmk_uint16
+vmk_PktVlanIDGet(vmk_PktHandle *pkt)
+{
+   (void) pkt;
+   return 0;
+}
+
+static VMK_ReturnStatus
+vmk_PktVlanIDSet(vmk_PktHandle *pkt, vmk_uint16 vlanID)
+{
+   (void) pkt;
+   (void) vlanID;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_PktPrioritySet(vmk_PktHandle *pkt, vmk_uint8 priority)
+{
+   (void) pkt;
+   (void) priority;
+   return VMK_OK;
+}
+
+static void
+vmk_PktSetCsumVfd(vmk_PktHandle *pkt)
+{
+   (void) pkt;
+}
+
+static void
+vmk_PktQueueForRxProcess(vmk_PktHandle *pkt, vmk_Uplink *uplink)
+{
+   (void) pkt;
+   (void) uplink;
+   sim[stub_pcpu].delivered++;
+}
+
+static void
+vmk_PktListRxProcess(vmk_PktList *pktList, vmk_Uplink *uplink)
+{
+   (void) uplink;
+   sim[stub_pcpu].pushes++;
+   sim[stub_pcpu].pushedPkts += vmk_PktListCount(pktList);
+   vmk_PktListInit(pktList);
+}
+
+static void
+vmk_PktListReleasePkts(vmk_PktList *pktList)
+{
+   released += vmk_PktListCount(pktList);
+   vmk_PktListInit(pktList);
+}
+
+static VMK_ReturnStatus
+vmk_WorldletGetCurrent(vmk_Worldlet *worldlet, void **private)
+{
+   (void) worldlet;
+   (void) private;
+   fail("netif_receive_skb() of an skb without a napi context");
+   return VMK_FAILURE;
+}
+
+static int
+vmklnx_is_panic(void)
+{
+   return 0;
+}
+
+static void
+LinStress_CorruptSkbData(struct sk_buff *skb, unsigned int n,
+                         unsigned int off)
+{
+   (void) skb;
+   (void) n;
+   (void) off;
+}
+
+static void
+LinStress_CorruptRxData(vmk_PktHandle *pkt, struct sk_buff *skb)
+{
+   (void) pkt;
+   (void) skb;
+}
+
+static void
+LinStress_CorruptEthHdr(struct sk_buff *skb)
+{
+   (void) skb;
+}
+
+static void
+do_free_skb(struct sk_buff *skb)
+{
+   (void) skb;
+   sim[stub_pcpu].freedSkbs++;
+}
+
+static void
+dev_kfree_skb_any(struct sk_buff *skb)
+{
+   (void) skb;
+   sim[stub_pcpu].freedSkbs++;
+}
+
+static int
+lro_receive_skb(struct net_lro_mgr *lro_mgr, struct sk_buff *skb, void *priv)
+{
+   (void) lro_mgr;
+   (void) skb;
+   (void) priv;
+   fail("lro_receive_skb() with lro disabled");
+   return NET_RX_DROP;
+}
+
+static void
+netdev_tx_sw_gso(struct net_device *d, vmk_PktList *pktList,
+                 vmk_PktList *freeList)
+{
+   (void) d;
+   (void) pktList;
+   (void) freeList;
+   fail("netdev_tx_sw_gso() for a device that does TSO");
+}
+
+static VMK_ReturnStatus
+netdev_tx_stage(struct netdev_queue *queue, vmk_PktList *pktList,
+                vmk_PktList *freeList)
+{
+   (void) queue;
+   (void) pktList;
+   (void) freeList;
+   fail("netdev_tx_stage() for a queue without a staging ring");
+   return VMK_FAILURE;
+}
+
+/* a driver that is never called: what is queued stays on outputList */
+static void
+process_tx_queue(struct netdev_queue *queue, vmk_PktList *freePktsList)
+{
+   (void) queue;
+   (void) freePktsList;
+}
+
+static void *
+compat_ptr(compat_caddr_t uptr)
+{
+   return (void *) (unsigned long) uptr;
+}
+
+/* rx */
+
+struct test_skb {
+   struct sk_buff skb;
+   struct skb_shared_info shinfo;
+   vmk_PktHandle pkt;
+};
+
+static void
+skb_prepare(struct test_skb *ts, struct napi_struct *napi,
+            vmknetddi_queueops_queueid_t qid, unsigned int len)
+{
+   memset(ts, 0, sizeof(*ts));
+   ts->skb.dev = &dev;
+   ts->skb.napi = napi;
+   ts->skb.qid = qid;
+   ts->skb.len = len;
+   ts->skb.head = ts->skb.data = (unsigned char *) &ts->pkt;
+   ts->skb.end = (unsigned char *) &ts->shinfo;
+   ts->skb.pkt = &ts->pkt;
+   ts->skb.ip_summed = CHECKSUM_NONE;
+}
+
+/* a napi context on its own PCPU, polled NR_POLLS times */
+static void *
+world_main(void *arg)
+{
+   int cpu = (long) arg;
+   struct pcpu_sim *s = &sim[cpu];
+   struct test_skb *skbs = calloc(POLL_MAX, sizeof(*skbs));
+   struct napi_struct *napi = calloc(1, sizeof(*napi));
+   vmknetddi_queueops_queueid_t qid = VMKNETDDI_QUEUEOPS_MK_RX_QUEUEID(cpu);
+   unsigned int seed = cpu + 1, poll, i, n, len, drops;
+   unsigned long saves;
+
+   stub_pcpu = cpu;
+   napi->dev = &dev;
+   vmk_PktListInit(&napi->pktList);
+   for (poll = 0; poll < NR_POLLS; poll++) {
+      saves = stub_irq_saves;
+      n = 1 + rand_r(&seed) % POLL_MAX;
+      drops = 0;
+      for (i = 0; i < n; i++) {
+         /* now and then a runt, which is dropped */
+         len = rand_r(&seed) % 32 == 0 ? 0 : 60 + rand_r(&seed) % 1455;
+         skb_prepare(&skbs[i], napi, qid, len);
+         if (netif_receive_skb(&skbs[i].skb) == NET_RX_SUCCESS) {
+            s->bytes += len;
+         } else {
+            s->dropped++;
+            drops++;
+         }
+      }
+      if (!vmk_PktListIsEmpty(&napi->pktList)) {
+         napi_stack_push(napi);
+      }
+      if (stub_irq_saves - saves > 1 + drops) {
+         fail("pcpu %d: %lu interrupt toggles for %u packets, %u dropped",
+              cpu, stub_irq_saves - saves, n, drops);
+         break;
+      }
+   }
+
+   /* and a few through netif_rx(), which counts them one by one */
+   for (i = 0; i < POLL_MAX; i++) {
+      skb_prepare(&skbs[i], NULL, qid, 60 + i);
+      if (netif_rx(&skbs[i].skb) != NET_RX_SUCCESS) {
+         fail("pcpu %d: netif_rx() dropped a packet", cpu);
+      }
+      s->bytes += 60 + i;
+   }
+
+   s->irqSaves = stub_irq_saves;
+   free(napi);
+   free(skbs);
+   return NULL;
+}
+
+static void
+test_rx(void)
+{
+   pthread_t t[NR_PCPUS];
+   struct netdev_queue_stats sum, slot;
+   unsigned long i, delivered = 0, bytes = 0, dropped = 0, pushes = 0;
+
+   for (i = 0; i < NR_PCPUS; i++) {
+      pthread_create(&t[i], NULL, world_main, (void *) i);
+   }
+   for (i = 0; i < NR_PCPUS; i++) {
+      pthread_join(t[i], NULL);
+   }
+
+   for (i = 0; i < NR_PCPUS; i++) {
+      if (sim[i].freedSkbs != sim[i].pushedPkts + sim[i].delivered +
+                              sim[i].dropped) {
+         fail("pcpu %lu: %lu skbs freed for %lu packets", i,
+              sim[i].freedSkbs,
+              sim[i].pushedPkts + sim[i].delivered + sim[i].dropped);
+      }
+
+      /* each napi context received on its own netqueue */
+      netdev_stats_fold(&dev, i, 1, &slot);
+      if (slot.packets != sim[i].pushedPkts + sim[i].delivered ||
+          slot.batches != sim[i].pushes) {
+         fail("rx queue %lu: %llu packets in %llu pushes, want %lu in %lu",
+              i, (unsigned long long) slot.packets,
+              (unsigned long long) slot.batches,
+              sim[i].pushedPkts + sim[i].delivered, sim[i].pushes);
+      }
+      delivered += sim[i].pushedPkts + sim[i].delivered;
+      bytes += sim[i].bytes;
+      dropped += sim[i].dropped;
+      pushes += sim[i].pushes;
+   }
+
+   netdev_stats_fold(&dev, 0, NETDEV_STATS_RX_QUEUES, &sum);
+   if (sum.packets != delivered || sum.bytes != bytes ||
+       sum.dropped[NETDEV_DROP_INVALID] != dropped ||
+       sum.batches != pushes || sum.batchPkts != delivered - NR_PCPUS * POLL_MAX) {
+      fail("folded %llu packets, %llu bytes, %llu drops, %llu pushes, "
+           "want %lu, %lu, %lu, %lu",
+           (unsigned long long) sum.packets, (unsigned long long) sum.bytes,
+           (unsigned long long) sum.dropped[NETDEV_DROP_INVALID],
+           (unsigned long long) sum.batches, delivered, bytes, dropped,
+           pushes);
+   }
+   printf("rx: %lu packets, %lu bytes, %lu drops in %lu pushes, "
+          "%lu interrupt toggles on pcpu 0\n", delivered, bytes, dropped,
+          pushes, sim[0].irqSaves);
+}
+
+/* tx drops */
+
+static vmk_PktHandle txPkts[OUTPUT_MAX * 8];
+static unsigned int txPktsUsed;
+
+static void
+pkts_get(vmk_PktList *pktList, unsigned int n)
+{
+   VMK_ASSERT(txPktsUsed + n <= ARRAY_SIZE(txPkts));
+   vmk_PktListInit(pktList);
+   while (n-- > 0) {
+      vmk_PktListAddToTail(pktList, &txPkts[txPktsUsed++]);
+   }
+}
+
+static void
+check_drops(const char *what, struct netdev_queue *queue,
+            const u64 want[NETDEV_DROP_REASONS], unsigned int queued)
+{
+   struct netdev_queue_stats sum;
+   int r;
+
+   netdev_stats_fold(&dev, NETDEV_STATS_RX_QUEUES + (queue - dev._tx), 1,
+                     &sum);
+   for (r = 0; r < NETDEV_DROP_REASONS; r++) {
+      if (sum.dropped[r] != want[r]) {
+         fail("%s: %llu drops as reason %d, want %llu", what,
+              (unsigned long long) sum.dropped[r], r,
+              (unsigned long long) want[r]);
+      }
+   }
+   if (vmk_PktListCount(&queue->softq.outputList) != queued) {
+      fail("%s: %u packets queued, want %u", what,
+           vmk_PktListCount(&queue->softq.outputList), queued);
+   }
+}
+
+static void
+test_tx_drops(void)
+{
+   struct netdev_queue *q = &dev._tx[0], *sq = &dev._tx[1];
+   u64 want[NETDEV_DROP_REASONS] = { 0 };
+   vmk_PktList pktList;
+
+   stub_pcpu = 0;
+
+   set_bit(__LINK_STATE_BLOCKED, &dev.state);
+   pkts_get(&pktList, 10);
+   netdev_tx_queue(&dev, q, &pktList);
+   want[NETDEV_DROP_BLOCKED] += 10;
+   check_drops("device blocked", q, want, 0);
+   clear_bit(__LINK_STATE_BLOCKED, &dev.state);
+
+   q->softq.state = LIN_NET_QUEUE_STARTED;
+   pkts_get(&pktList, 10);
+   netdev_tx_queue(&dev, q, &pktList);
+   want[NETDEV_DROP_BLOCKED] += 10;
+   check_drops("queue blocked", q, want, 0);
+
+   q->softq.state = LIN_NET_QUEUE_UNBLOCKED;
+   pkts_get(&pktList, 10);
+   netdev_tx_queue(&dev, q, &pktList);
+   want[NETDEV_DROP_NORESOURCE] += 10;
+   check_drops("queue stopped", q, want, 0);
+
+   q->softq.state = LIN_NET_QUEUE_UNBLOCKED|LIN_NET_QUEUE_STARTED;
+   pkts_get(&pktList, OUTPUT_MAX - 6);
+   netdev_tx_queue(&dev, q, &pktList);
+   pkts_get(&pktList, 10);
+   netdev_tx_queue(&dev, q, &pktList);
+   want[NETDEV_DROP_NORESOURCE] += 4;
+   check_drops("queue full", q, want, OUTPUT_MAX);
+
+   block_tx_soft_queue(q);
+   want[NETDEV_DROP_BLOCKED] += OUTPUT_MAX;
+   check_drops("queue torn down by block", q, want, 0);
+
+   /*
+    * With a staging ring, block and stop drop what is staged as well, even
+    * what doesn't fit on outputList since a refused burst went back there.
+    */
+   vmklnx_tx_stage = 1;
+   netdev_tx_stages_create(&dev);
+   memset(want, 0, sizeof(want));
+   pkts_get(&pktList, 50);
+   if (netdev_tx_stage_put(&sq->softq, &pktList) != VMK_OK) {
+      fail("packets not staged");
+   }
+   pkts_get(&pktList, 60);
+   vmk_PktListJoin(&sq->softq.outputList, &pktList);
+   stop_tx_soft_queue(sq);
+   want[NETDEV_DROP_NORESOURCE] += 110;
+   check_drops("staged queue torn down by stop", sq, want, 0);
+
+   sq->softq.state = LIN_NET_QUEUE_UNBLOCKED|LIN_NET_QUEUE_STARTED;
+   pkts_get(&pktList, OUTPUT_MAX - 1);
+   if (netdev_tx_stage_put(&sq->softq, &pktList) != VMK_OK) {
+      fail("packets not staged");
+   }
+   pkts_get(&pktList, 8);
+   vmk_PktListJoin(&sq->softq.outputList, &pktList);
+   block_tx_soft_queue(sq);
+   want[NETDEV_DROP_BLOCKED] += OUTPUT_MAX + 7;
+   check_drops("staged queue torn down by block", sq, want, 0);
+   if (atomic_read(&sq->softq.stage->pkts) != 0) {
+      fail("%d packets left in the staging ring",
+           atomic_read(&sq->softq.stage->pkts));
+   }
+
+   if (released != txPktsUsed) {
+      fail("%lu packets released", released);
+   }
+}
+
+/* ifr_data */
+
+static void
+test_ifr_data(void)
+{
+   struct ifreq ifr;
+   struct ifreq32 *ifr32 = (struct ifreq32 *) &ifr;
+
+   memset(&ifr, 0xa5, sizeof(ifr));
+   ifr32->ifr_ifru.ifru_data = 0x12345678;
+   if (netdev_ifr_data(&ifr, VMK_IOCTL_CALLER_32) !=
+       (void *) 0x12345678UL) {
+      fail("32-bit ifr_data: %p", netdev_ifr_data(&ifr, VMK_IOCTL_CALLER_32));
+   }
+   ifr.ifr_data = &ifr;
+   if (netdev_ifr_data(&ifr, VMK_IOCTL_CALLER_64) != &ifr) {
+      fail("64-bit ifr_data: %p", netdev_ifr_data(&ifr, VMK_IOCTL_CALLER_64));
+   }
+}
+
+int
+main(void)
+{
+   int i;
+
+   /* as vmklnx_alloc_etherdev_mq() and register_netdev() set it up */
+   strcpy(dev.name, "vmnic0");
+   dev.features = NETIF_F_TSO | NETIF_F_TSO6;
+   dev._tx = txq;
+   dev.num_tx_queues = 2;
+   dev.linnet_stats = calloc(NR_PCPUS, sizeof(*dev.linnet_stats));
+   for (i = 0; i < NR_PCPUS; i++) {
+      dev.linnet_stats[i] = calloc(NETDEV_STATS_RX_QUEUES + dev.num_tx_queues,
+                                   sizeof(struct netdev_queue_stats));
+   }
+   for (i = 0; i < 2; i++) {
+      txq[i].dev = &dev;
+      spin_lock_init(&txq[i].softq.queue_lock);
+      txq[i].softq.state = LIN_NET_QUEUE_UNBLOCKED|LIN_NET_QUEUE_STARTED;
+      txq[i].softq.outputListMaxSize = OUTPUT_MAX;
+      vmk_PktListInit(&txq[i].softq.outputList);
+   }
+
+   test_rx();
+   test_tx_drops();
+
+   test_ifr_data();
+
+   if (failures) {
+      fprintf(stderr, "qstats_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("qstats_test: ok\n");
+   return 0;
+}
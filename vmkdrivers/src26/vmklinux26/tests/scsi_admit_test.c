@@ -0,0 +1,390 @@
+/*
+ * scsi_admit_test.c --
+ *
+ *    Multi-threaded test of the host_lock free admission of scsi commands
+ *    in vmklinux as it ships: SCSILinuxAdmitCommand, and the busy count
+ *    release of SCSILinuxBH with SCSILinuxBusyRunEnds, reached through
+ *    SCSILinuxCmdDone, in vmware/linux_scsi.c.
+ *
+ *    Issuing threads admit runs of commands to the devices of one host
+ *    against the queue depth of each device and the can_queue of the
+ *    host, which is less than the sum of the queue depths. The HBA
+ *    completes them in bursts on the PCPUs of the BH threads, whose BH
+ *    hands them back in passes of a bounded length, releasing the busy
+ *    counts once per run of completions for the same device. The timer
+ *    cycles tick at every read, so that a pass yields after a few dozen
+ *    completions.
+ *
+ *    The test fails if
+ *    - more commands are admitted to a device than its queue depth, or to
+ *      the host than its can_queue;
+ *    - the busy counts of a device are released after its last command
+ *      was handed back, when the device may already be gone;
+ *    - device_busy or host_busy is not back to zero once all commands
+ *      have completed;
+ *    - the counts are released once per command instead of once per run,
+ *      or a BH pass runs past its yield time to finish a run;
+ *    - a BH pass that used up its time leaves completions behind without
+ *      scheduling the BH again;
+ *    - commands are never admitted because a limit was reached, i.e. the
+ *      test did not exercise the limits.
+ *
+ * extract ../../include/linux/poison.h: LIST_POISON1 LIST_POISON2
+ * extract ../../include/linux/list.h: __list_add list_add_tail __list_del list_del list_empty __list_splice list_splice_init
+ * extract ../../include/linux/dma-mapping.h: enum dma_data_direction
+ * extract ../../include/linux/timer.h: struct timer_list
+ * extract ../../include/scsi/scsi.h: DID_OK DID_ERROR DRIVER_OK DRIVER_BUSY DRIVER_SOFT DRIVER_MEDIA DRIVER_ERROR DRIVER_INVALID DRIVER_TIMEOUT DRIVER_HARD DRIVER_SENSE driver_byte
+ * extract ../../include/scsi/scsi_cmnd.h: struct scsi_pointer struct scsi_cmnd MAX_COMMAND_SIZE SCSI_SENSE_BUFFERSIZE
+ * extract ../../include/vmklinux26/vmklinux26_scsi.h: enum VMKLinux_Flags
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_const.h: VMK_SCSI_CMD_INQUIRY
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_ext.h: vmk_ScsiCommandDirection vmk_ScsiPluginStatus vmk_ScsiHostStatus vmk_ScsiDeviceStatus vmk_ScsiCmdStatus
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_types.h: vmk_ScsiSenseData vmk_ScsiCommandId vmk_ScsiCommandDoneCbk VMK_SCSI_MAX_CDB_LEN vmk_ScsiCommand
+ * extract ../vmware/linux_scsi.h: VMKLNX_SCSI_HOST_STATUS VMKLNX_SCSI_DEVICE_STATUS VMKLNX_SCSI_STATUS_NO_SUGGEST SCSILinuxCompleteCommand SCSILinuxCompleteCommandInt
+ * extract ../vmware/linux_scsi.c: scsiLinuxBH scsiLinuxTLS_t scsiLinuxTLS enum SCSI_COMPL_ON_INTR_PCPU vmklnx_scsi_compl_steering vmklnx_scsi_compl_domain_pcpus SCSILinuxTakeInbox SCSILinuxBusyRunEnds SCSILinuxBH SCSILinuxAdmitCommand SCSILinuxSignalBH SCSILinuxScheduleCompletion SCSILinuxComplPCPU SCSILinuxSteerCompletion SCSILinuxCmdDone
+ */
+
+#include "stubs.h"
+
+#define DEVICES         6
+#define QUEUE_DEPTH     8
+#define CAN_QUEUE       32
+#define ISSUERS         3
+#define BHS             2
+#define CMDS_PER_ISSUER 100000
+#define HBA_BURST       24
+#define PASS_CYCLES     20      /* timer cycles of the 5 ms a BH pass gets */
+
+#define NR_CPUS         BHS
+
+#define module_param(name, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+#define VMK_FMT64                       "l"
+#define VMK_NOT_REACHED()               VMK_ASSERT(0)
+#define vmk_LogDebug(log, level, fmt, args...)  do { } while (0)
+#define vmk_WarningMessage(fmt, args...)        do { } while (0)
+#define vmk_AlertMessage(fmt, args...)          do { } while (0)
+
+/* the interrupts of a PCPU are those of its thread */
+#define vmk_GetPCPUNum()                ((unsigned) stub_pcpu)
+#define vmk_CPUDisableInterrupts()      local_irq_disable()
+#define vmk_CPUEnableInterrupts()       local_irq_enable()
+#define vmk_CPUHasIntsEnabled()         (!irqs_disabled())
+#define VMK_ASSERT_CPU_HAS_INTS_ENABLED()       VMK_ASSERT(!irqs_disabled())
+#define VMK_ASSERT_CPU_HAS_INTS_DISABLED()      VMK_ASSERT(irqs_disabled())
+
+/* a clock that ticks at every read */
+#define vmk_TimerUSToTC(us)             ((vmk_TimerCycles) (us) * PASS_CYCLES / 5000)
+
+static __thread vmk_TimerCycles pcpuCycles;
+
+static vmk_TimerCycles
+vmk_GetTimerCycles(void)
+{
+   return ++pcpuCycles;
+}
+
+struct scsi_host_template {
+   const char *name;
+};
+
+struct Scsi_Host {
+   atomic_t host_busy;
+   int can_queue;
+   struct scsi_host_template *hostt;
+};
+
+struct scsi_device {
+   struct Scsi_Host *host;
+   atomic_t device_busy;
+   int queue_depth;
+   /*
+    * What the test tracks. Admissions and hand backs of the commands of
+    * a device take its lock, so that device_busy holds still while it is
+    * looked at.
+    */
+   pthread_mutex_t lock;
+   int outstanding;             /* admitted, not yet handed back */
+};
+
+/* what the extracted code calls, defined below */
+struct scsi_cmnd;
+static VMK_ReturnStatus vmk_BottomHalfSchedulePCPU(vmk_BottomHalf bh,
+                                                   unsigned pcpu);
+static void SCSILinuxProcessStandardInquiryResponse(struct scsi_cmnd *scmd);
+static void scsi_put_command(struct scsi_cmnd *scmd);
+static int scsi_delete_timer(struct scsi_cmnd *scmd);
+static void add_disk_randomness(void *disk);
+
+#include "scsi_admit_test.inc"
+
+/* a command of the test, as the HBA and the vmkernel see it */
+struct sim_cmd {
+   struct scsi_cmnd scmd;
+   vmk_ScsiCommand vmkCmd;
+   struct sim_cmd *hbanext;
+};
+
+static struct scsi_host_template sht = { .name = "sim" };
+static struct Scsi_Host shost = { .can_queue = CAN_QUEUE, .hostt = &sht };
+static struct scsi_device sdevs[DEVICES];
+static atomic_t hostOutstanding;
+static atomic_t rejected;
+static atomic_t handedBack;
+static atomic_t heldOver;       /* hand backs with busy counts still held */
+static int bhPending[BHS];
+
+/* the HBA completes commands in the order they were issued */
+static struct {
+   pthread_mutex_t lock;
+   struct sim_cmd *head, *tail;
+} hba = { PTHREAD_MUTEX_INITIALIZER, NULL, NULL };
+
+static VMK_ReturnStatus
+vmk_BottomHalfSchedulePCPU(vmk_BottomHalf bh, unsigned pcpu)
+{
+   VMK_ASSERT(bh == scsiLinuxBH);
+   VMK_ASSERT(pcpu < BHS);
+   __atomic_store_n(&bhPending[pcpu], 1, __ATOMIC_SEQ_CST);
+   return VMK_OK;
+}
+
+static void
+SCSILinuxProcessStandardInquiryResponse(struct scsi_cmnd *scmd)
+{
+   (void) scmd;
+   fail("inquiry response on a read");
+}
+
+static void
+scsi_put_command(struct scsi_cmnd *scmd)
+{
+   (void) scmd;
+}
+
+static int
+scsi_delete_timer(struct scsi_cmnd *scmd)
+{
+   (void) scmd;
+   return 0;
+}
+
+static void
+add_disk_randomness(void *disk)
+{
+   (void) disk;
+}
+
+/* the vmkernel takes the command back from the BH */
+static void
+complete_cmd(struct vmk_ScsiCommand *vmkCmd)
+{
+   struct sim_cmd *cmd = container_of(vmkCmd, struct sim_cmd, vmkCmd);
+   struct scsi_device *sdev = cmd->scmd.device;
+   int busy;
+
+   pthread_mutex_lock(&sdev->lock);
+   sdev->outstanding--;
+   busy = atomic_read(&sdev->device_busy);
+   if (sdev->outstanding == 0 && busy != 0) {
+      fail("busy counts of device %d released after its last command "
+           "was handed back", (int) (sdev - sdevs));
+   }
+   if (busy > sdev->outstanding) {
+      atomic_inc(&heldOver);
+   }
+   pthread_mutex_unlock(&sdev->lock);
+   atomic_dec(&hostOutstanding);
+   atomic_inc(&handedBack);
+   free(cmd);
+}
+
+static void
+hba_issue(struct sim_cmd *cmd)
+{
+   pthread_mutex_lock(&hba.lock);
+   cmd->hbanext = NULL;
+   if (hba.tail) {
+      hba.tail->hbanext = cmd;
+   } else {
+      hba.head = cmd;
+   }
+   hba.tail = cmd;
+   pthread_mutex_unlock(&hba.lock);
+}
+
+/* admit a command to sdev and hand it to the HBA, 0 if a limit held it */
+static int
+issue(struct scsi_device *sdev)
+{
+   struct sim_cmd *cmd;
+   struct scsi_cmnd *scmd;
+   int admitted;
+
+   pthread_mutex_lock(&sdev->lock);
+   admitted = SCSILinuxAdmitCommand(&shost, sdev);
+   if (admitted && ++sdev->outstanding > sdev->queue_depth) {
+      fail("device %d admitted more commands than its queue depth",
+           (int) (sdev - sdevs));
+   }
+   if (!admitted && sdev->outstanding == 0 &&
+       atomic_read(&sdev->device_busy) != 0) {
+      fail("device %d holds busy counts with no command outstanding",
+           (int) (sdev - sdevs));
+      exit(1);
+   }
+   pthread_mutex_unlock(&sdev->lock);
+   if (!admitted) {
+      /* VMK_WOULD_BLOCK, the upper layer retries later */
+      atomic_inc(&rejected);
+      return 0;
+   }
+   if (atomic_inc_return(&hostOutstanding) > shost.can_queue) {
+      fail("host admitted more commands than can_queue");
+   }
+
+   cmd = calloc(1, sizeof(*cmd));
+   scmd = &cmd->scmd;
+   spin_lock_init(&scmd->vmklock);
+   scmd->device = sdev;
+   scmd->cmnd[0] = 0x28;        /* READ(10) */
+   scmd->result = DID_OK;
+   scmd->vmkflags = VMK_FLAGS_NEED_CMDDONE;
+   scmd->vmkCmdPtr = &cmd->vmkCmd;
+   scmd->scsi_done = SCSILinuxCmdDone;
+   cmd->vmkCmd.done = complete_cmd;
+   hba_issue(cmd);
+   return 1;
+}
+
+static void *
+issuer(void *arg)
+{
+   unsigned int seed = (unsigned int) (long) arg;
+   int issued = 0;
+
+   while (issued < CMDS_PER_ISSUER) {
+      /* a run of IOs to one device */
+      struct scsi_device *sdev = &sdevs[rand_r(&seed) % DEVICES];
+      int n = 1 + rand_r(&seed) % QUEUE_DEPTH;
+
+      while (n-- > 0 && issued < CMDS_PER_ISSUER) {
+         if (!issue(sdev)) {
+            sched_yield();
+            break;
+         }
+         issued++;
+      }
+   }
+   return NULL;
+}
+
+static void *
+bh(void *arg)
+{
+   const int total = ISSUERS * CMDS_PER_ISSUER;
+   int me = (int) (long) arg;
+   struct sim_cmd *burst[HBA_BURST];
+   int n, i;
+
+   stub_pcpu = me;
+   while (atomic_read(&handedBack) < total) {
+      /* an interrupt: the HBA completes a burst */
+      pthread_mutex_lock(&hba.lock);
+      for (n = 0; n < HBA_BURST && hba.head != NULL; n++) {
+         burst[n] = hba.head;
+         hba.head = hba.head->hbanext;
+         if (hba.head == NULL) {
+            hba.tail = NULL;
+         }
+      }
+      pthread_mutex_unlock(&hba.lock);
+      local_irq_disable();
+      for (i = 0; i < n; i++) {
+         burst[i]->scmd.scsi_done(&burst[i]->scmd);
+      }
+      local_irq_enable();
+
+      if (xchg(&bhPending[me], 0)) {
+         vmk_TimerCycles start = pcpuCycles;
+
+         SCSILinuxBH(NULL);
+         /* a pass may finish the command it is on when its time is up */
+         if (pcpuCycles - start > PASS_CYCLES + 4) {
+            fail("BH pass overran its yield time by %lu cycles",
+                 pcpuCycles - start - PASS_CYCLES);
+         }
+         if (!list_empty(&scsiLinuxTLS[me]->bhDoneCmds) &&
+             !__atomic_load_n(&bhPending[me], __ATOMIC_SEQ_CST)) {
+            fail("BH pass left completions behind without rescheduling");
+            exit(1);
+         }
+      }
+      sched_yield();
+   }
+   return NULL;
+}
+
+int
+main(void)
+{
+   pthread_t threads[ISSUERS + BHS];
+   long i;
+
+   for (i = 0; i < BHS; i++) {
+      /* SCSILinux_Init() */
+      if (posix_memalign((void **) &scsiLinuxTLS[i], VMK_L1_CACHELINE_SIZE,
+                         sizeof(scsiLinuxTLS_t))) {
+         return 1;
+      }
+      memset(scsiLinuxTLS[i], 0, sizeof(scsiLinuxTLS_t));
+      INIT_LIST_HEAD(&scsiLinuxTLS[i]->isrDoneCmds);
+      INIT_LIST_HEAD(&scsiLinuxTLS[i]->bhDoneCmds);
+   }
+   /* the BH of the interrupt PCPU completes the commands */
+   vmklnx_scsi_compl_steering = SCSI_COMPL_ON_INTR_PCPU;
+   for (i = 0; i < DEVICES; i++) {
+      sdevs[i].queue_depth = QUEUE_DEPTH;
+      sdevs[i].host = &shost;
+      pthread_mutex_init(&sdevs[i].lock, NULL);
+   }
+
+   for (i = 0; i < ISSUERS; i++) {
+      pthread_create(&threads[i], NULL, issuer, (void *) (i + 1));
+   }
+   for (i = 0; i < BHS; i++) {
+      pthread_create(&threads[ISSUERS + i], NULL, bh, (void *) i);
+   }
+   for (i = 0; i < ISSUERS + BHS; i++) {
+      pthread_join(threads[i], NULL);
+   }
+
+   for (i = 0; i < DEVICES; i++) {
+      if (atomic_read(&sdevs[i].device_busy) != 0) {
+         fail("device_busy of device %ld left at %d", i,
+              atomic_read(&sdevs[i].device_busy));
+      }
+   }
+   if (atomic_read(&shost.host_busy) != 0) {
+      fail("host_busy left at %d", atomic_read(&shost.host_busy));
+   }
+   if (atomic_read(&heldOver) == 0) {
+      fail("busy counts released once per command, not per run");
+   }
+   if (atomic_read(&rejected) == 0) {
+      fail("no command was ever held back by a limit");
+   }
+
+   printf("scsi_admit: %d commands, %d handed back before the busy counts "
+          "of their run, %d held back by a limit\n",
+          ISSUERS * CMDS_PER_ISSUER, atomic_read(&heldOver),
+          atomic_read(&rejected));
+   for (i = 0; i < BHS; i++) {
+      free(scsiLinuxTLS[i]);
+   }
+   if (failures) {
+      fprintf(stderr, "scsi_admit: %d failures\n", failures);
+      return 1;
+   }
+   printf("scsi_admit: ok\n");
+   return 0;
+}
@@ -0,0 +1,518 @@
+/*
+ * scsi_cmd_locks_sim.c --
+ *
+ *    Lock count harness for the allocation and tracking of scsi_cmnds in
+ *    vmklinux as it ships: scsi_get_command, scsi_put_command and the
+ *    per-PCPU magazines in vmware/linux_scsi_lld_if.c, and the walk of
+ *    the outstanding commands by SCSILinuxCollectAborts in
+ *    vmware/linux_scsi.c.
+ *
+ *    One thread per PCPU issues IOs to the LUNs of one host through a
+ *    null LLD that completes every command at once, either on the
+ *    issuing PCPU or, for a share of them, on the next PCPU as when
+ *    steering is not possible. One run has the driver ask for
+ *    sdev_cmd_list. Every spinlock counts its acquisitions, and the ones
+ *    last taken on another PCPU, i.e. that had to move the lock's cache
+ *    line. The counts per IO of each run are printed. A last run has the
+ *    slab fail now and then, so that the backup command on sh->free_list
+ *    is used.
+ *
+ *    The per-device cmd_list and the host's free_list_lock the commands
+ *    went through before the magazines cost five locks per IO, and with
+ *    a quarter of the completions remote half a moved lock per IO.
+ *
+ *    The test fails if
+ *    - with local completions the magazines take more than one lock on
+ *      get and one on put, or any lock last taken on another PCPU, or
+ *      with sdev_cmd_list more than the device's list_lock on top;
+ *    - with remote completions they take as many locks or move as many
+ *      lock cache lines per IO as before the magazines;
+ *    - the walk of the outstanding commands, at a quiescent point, does
+ *      not find every outstanding command exactly once on the list of
+ *      the PCPU that allocated it, or does not mark it for the abort;
+ *    - a command is handed out twice, or a command is lost: at the end
+ *      every command taken from the slab must be back in the slab or in
+ *      a magazine, the backup command must be back on sh->free_list, and
+ *      no magazine may hold more than its size.
+ *
+ * extract ../../include/linux/poison.h: LIST_POISON1 LIST_POISON2
+ * extract ../../include/linux/list.h: __list_add list_add list_add_tail __list_del list_del list_del_init list_move_tail list_empty list_for_each_entry_safe
+ * extract ../../include/linux/dma-mapping.h: enum dma_data_direction
+ * extract ../../include/linux/timer.h: struct timer_list
+ * extract ../../include/scsi/scsi_cmnd.h: struct scsi_pointer struct scsi_cmnd MAX_COMMAND_SIZE SCSI_SENSE_BUFFERSIZE
+ * extract ../../include/vmklinux26/vmklinux26_scsi.h: enum VMKLinux_Flags
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_ext.h: vmk_ScsiCommandDirection vmk_ScsiPluginStatus vmk_ScsiHostStatus vmk_ScsiDeviceStatus vmk_ScsiCmdStatus
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_types.h: vmk_ScsiSenseData vmk_ScsiCommandId vmk_ScsiCommandDoneCbk VMK_SCSI_MAX_CDB_LEN vmk_ScsiCommand vmk_ScsiTaskMgmtAction
+ * extract ../vmware/linux_scsi.h: struct scsi_host_cmd_pool SCSI_CMD_MAG_SIZE SCSI_CMD_MAG_BATCH struct scsi_host_pcpu
+ * extract ../vmware/linux_scsi_lld_if.c: __scsi_get_command vmklnx_clear_scmd SCSILinuxCmdMagazineGet SCSILinuxCmdMagazinePut scsi_get_command scsi_put_command
+ * extract ../vmware/linux_scsi.c: SCSILinuxCollectAborts
+ */
+
+#include "stubs.h"
+
+#define NPCPUS          4
+#define NDEVS           2
+#define IOS_PER_PCPU    200000
+#define WARMUP_IOS      1000
+#define QUEUE_DEPTH     16      /* outstanding IOs per PCPU */
+#define REMOTE_PCT      25
+#define SLAB_DRY_PERMILLE 10    /* slab allocations failing, last run */
+
+/* locks and moved locks per IO before the magazines, 25% remote */
+#define CMD_LIST_LOCKS  5.0
+#define CMD_LIST_MOVED  0.5
+
+#define vmk_GetPCPUNum()                ((unsigned) stub_pcpu)
+#define vmk_LogDebug(log, level, fmt, args...)  do { } while (0)
+#define init_timer(timer)               ((void) (timer))
+
+typedef unsigned int gfp_t;
+#define GFP_ATOMIC      1
+#define GFP_KERNEL      2
+
+/* the walk is of an abort that wants every command */
+typedef struct vmk_ScsiTaskMgmt vmk_ScsiTaskMgmt;
+#define vmk_ScsiQueryTaskMgmt(vmkTaskMgmt, vmkCmd)                         \
+   ((void) (vmkTaskMgmt), (void) (vmkCmd), VMK_SCSI_TASKMGMT_ACTION_ABORT)
+
+/* the command slab: vmk_SlabAlloc and vmk_SlabFree take its lock */
+struct kmem_cache_s {
+   spinlock_t lock;
+   long out;                    /* allocated and not freed */
+};
+
+struct scsi_host_template {
+   const char *name;
+   unsigned sdev_cmd_list:1;
+};
+
+struct Scsi_Host {
+   struct scsi_host_template *hostt;
+   struct scsi_host_cmd_pool *cmd_pool;
+   spinlock_t free_list_lock;
+   struct list_head free_list;
+   struct scsi_host_pcpu **pcpu_cmds;
+};
+
+struct scsi_device {
+   struct Scsi_Host *host;
+   spinlock_t list_lock;
+   struct list_head cmd_list;
+};
+
+/* what the extracted code calls, defined below */
+struct scsi_cmnd;
+static void *kmem_cache_alloc(struct kmem_cache_s *slab, gfp_t flags);
+static void kmem_cache_free(struct kmem_cache_s *slab, void *obj);
+static void scsi_free_sgtable(struct scatterlist *sgl, unsigned int nbElems);
+
+#include "scsi_cmd_locks_sim.inc"
+
+/* a command as the slab hands it out, with what the test tracks */
+struct sim_cmd {
+   struct scsi_cmnd scmd;
+   int inUse;
+   unsigned int seen;           /* walk generation that found it */
+   struct sim_cmd *inboxNext;
+};
+
+static struct kmem_cache_s slab;
+static struct scsi_host_cmd_pool pool = { .slab = &slab, .name = "sim" };
+static struct scsi_host_template sht = { .name = "sim" };
+static struct Scsi_Host shost = { .hostt = &sht, .cmd_pool = &pool };
+static struct scsi_host_pcpu *pcpuCmds[NPCPUS];
+static struct scsi_device sdevs[NDEVS];
+static int remotePct;
+static int slabDryPermille;
+static __thread unsigned int slabSeed;
+static __thread int slabFailed;
+static long backupUses;
+
+struct lock_stats {
+   unsigned long locks;
+   unsigned long moved;
+};
+
+static void *
+kmem_cache_alloc(struct kmem_cache_s *s, gfp_t flags)
+{
+   struct sim_cmd *cmd = NULL;
+
+   (void) flags;
+   spin_lock(&s->lock);
+   if (slabDryPermille == 0 ||
+       (int) (rand_r(&slabSeed) % 1000) >= slabDryPermille) {
+      cmd = calloc(1, sizeof(*cmd));
+      s->out++;
+   } else {
+      slabFailed = 1;
+   }
+   spin_unlock(&s->lock);
+   return cmd;
+}
+
+static void
+kmem_cache_free(struct kmem_cache_s *s, void *obj)
+{
+   spin_lock(&s->lock);
+   free(obj);
+   s->out--;
+   spin_unlock(&s->lock);
+}
+
+static void
+scsi_free_sgtable(struct scatterlist *sgl, unsigned int nbElems)
+{
+   (void) sgl;
+   (void) nbElems;
+   fail("scatterlist freed for a command without data");
+}
+
+static void
+lock_stats_add(struct lock_stats *s, spinlock_t *l)
+{
+   s->locks += l->acquired;
+   s->moved += l->moved;
+}
+
+/* the locks of the IO path taken since the last call */
+static void
+lock_stats_take(struct lock_stats *s)
+{
+   int i;
+
+   memset(s, 0, sizeof(*s));
+   lock_stats_add(s, &slab.lock);
+   lock_stats_add(s, &shost.free_list_lock);
+   for (i = 0; i < NPCPUS; i++) {
+      lock_stats_add(s, &pcpuCmds[i]->lock);
+      pcpuCmds[i]->lock.acquired = pcpuCmds[i]->lock.moved = 0;
+   }
+   for (i = 0; i < NDEVS; i++) {
+      lock_stats_add(s, &sdevs[i].list_lock);
+      sdevs[i].list_lock.acquired = sdevs[i].list_lock.moved = 0;
+   }
+   slab.lock.acquired = slab.lock.moved = 0;
+   shost.free_list_lock.acquired = shost.free_list_lock.moved = 0;
+}
+
+/*
+ * The walk of SCSILinuxAbortCommands over the outstanding commands:
+ * counts the commands found, marks them with the generation gen and
+ * puts them back.
+ */
+static long
+walk_outstanding(unsigned int gen)
+{
+   struct scsi_cmnd *scmd, *safecmd;
+   struct list_head abort_list;
+   long found = 0;
+   int i, d;
+
+   for (i = 0; i < NPCPUS; i++) {
+      struct scsi_host_pcpu *hp = shost.pcpu_cmds[i];
+
+      for (d = 0; d < NDEVS; d++) {
+         INIT_LIST_HEAD(&abort_list);
+         SCSILinuxCollectAborts(hp, &sdevs[d], NULL, &abort_list);
+         list_for_each_entry_safe(scmd, safecmd, &abort_list, active_entry) {
+            struct sim_cmd *cmd = container_of(scmd, struct sim_cmd, scmd);
+
+            if (scmd->alloc_pcpu != i) {
+               fail("command on the active list of another PCPU");
+            }
+            if (scmd->device != &sdevs[d]) {
+               fail("command of another device collected for the abort");
+            }
+            if (!(scmd->vmkflags & VMK_FLAGS_DELAY_CMDDONE)) {
+               fail("command collected without deferring its completion");
+            }
+            if (cmd->seen == gen) {
+               fail("command found twice by the walk");
+            }
+            cmd->seen = gen;
+            found++;
+            scmd->vmkflags &= ~VMK_FLAGS_DELAY_CMDDONE;
+            list_move_tail(&scmd->active_entry, &hp->active);
+         }
+      }
+   }
+   return found;
+}
+
+/* completions handed to another PCPU, as by SCSILinuxSteerCompletion */
+static struct {
+   pthread_mutex_t lock;
+   struct sim_cmd *head;
+} inbox[NPCPUS];
+
+static long outstanding;        /* got and not yet put */
+static long put;
+static pthread_barrier_t barrier;
+
+static void
+put_command(struct sim_cmd *cmd)
+{
+   __atomic_store_n(&cmd->inUse, 0, __ATOMIC_SEQ_CST);
+   scsi_put_command(&cmd->scmd);
+   __atomic_sub_fetch(&outstanding, 1, __ATOMIC_SEQ_CST);
+   __atomic_add_fetch(&put, 1, __ATOMIC_SEQ_CST);
+}
+
+static void
+drain_inbox(void)
+{
+   struct sim_cmd *cmd;
+
+   pthread_mutex_lock(&inbox[stub_pcpu].lock);
+   cmd = inbox[stub_pcpu].head;
+   inbox[stub_pcpu].head = NULL;
+   pthread_mutex_unlock(&inbox[stub_pcpu].lock);
+
+   while (cmd != NULL) {
+      struct sim_cmd *next = cmd->inboxNext;
+
+      put_command(cmd);
+      cmd = next;
+   }
+}
+
+/* the null LLD completed cmd, hand it back here or on the next PCPU */
+static void
+complete(struct sim_cmd *cmd, unsigned int *seed)
+{
+   if (remotePct != 0 && (int) (rand_r(seed) % 100) < remotePct) {
+      int to = (stub_pcpu + 1) % NPCPUS;
+
+      pthread_mutex_lock(&inbox[to].lock);
+      cmd->inboxNext = inbox[to].head;
+      inbox[to].head = cmd;
+      pthread_mutex_unlock(&inbox[to].lock);
+      return;
+   }
+   put_command(cmd);
+}
+
+static struct sim_cmd *
+get_command(struct scsi_device *dev)
+{
+   struct scsi_cmnd *scmd;
+   struct sim_cmd *cmd;
+
+   slabFailed = 0;
+   scmd = scsi_get_command(dev, GFP_ATOMIC);
+   if (scmd == NULL) {
+      return NULL;
+   }
+   if (slabFailed) {
+      __atomic_add_fetch(&backupUses, 1, __ATOMIC_SEQ_CST);
+   }
+   cmd = container_of(scmd, struct sim_cmd, scmd);
+   if (__atomic_exchange_n(&cmd->inUse, 1, __ATOMIC_SEQ_CST)) {
+      fail("command handed out twice");
+   }
+   /* SCSILinuxQueueCommand() */
+   scmd->vmkflags = VMK_FLAGS_NEED_CMDDONE;
+   return cmd;
+}
+
+static void *
+pcpu_thread(void *arg)
+{
+   struct sim_cmd *window[QUEUE_DEPTH];
+   struct sim_cmd *cmd;
+   unsigned int seed;
+   long issued, head = 0, n = 0;
+   int i;
+
+   stub_pcpu = (int) (long) arg;
+   seed = stub_pcpu + 1;
+   slabSeed = seed;
+
+   for (issued = 0; issued < WARMUP_IOS + IOS_PER_PCPU; issued++) {
+      if (issued == WARMUP_IOS) {
+         /* count from here on, with the magazines filled */
+         pthread_barrier_wait(&barrier);
+         pthread_barrier_wait(&barrier);
+      }
+      if (n == QUEUE_DEPTH) {
+         complete(window[head], &seed);
+         head = (head + 1) % QUEUE_DEPTH;
+         n--;
+      }
+      drain_inbox();
+      while ((cmd = get_command(&sdevs[rand_r(&seed) % NDEVS])) == NULL) {
+         /* out of commands, the IO is retried */
+         drain_inbox();
+         sched_yield();
+      }
+      __atomic_add_fetch(&outstanding, 1, __ATOMIC_SEQ_CST);
+      window[(head + n) % QUEUE_DEPTH] = cmd;
+      n++;
+      if ((issued % 8) == 0) {
+         sched_yield();
+      }
+   }
+
+   /* quiescent: the main thread walks the outstanding commands */
+   pthread_barrier_wait(&barrier);
+   pthread_barrier_wait(&barrier);
+
+   for (i = 0; i < n; i++) {
+      complete(window[(head + i) % QUEUE_DEPTH], &seed);
+   }
+   while (__atomic_load_n(&put, __ATOMIC_SEQ_CST) <
+          (long) NPCPUS * (WARMUP_IOS + IOS_PER_PCPU)) {
+      drain_inbox();
+      sched_yield();
+   }
+   return NULL;
+}
+
+static void
+run(int cmdList, int remote, int slabDry, struct lock_stats *total)
+{
+   static unsigned int gen;
+   pthread_t threads[NPCPUS];
+   long i, found, magCmds = 0;
+   struct scsi_cmnd *backup;
+
+   sht.sdev_cmd_list = cmdList;
+   remotePct = remote;
+   slabDryPermille = 0;
+   backupUses = 0;
+   outstanding = 0;
+   put = 0;
+   stub_pcpu = NPCPUS;
+
+   /* scsi_setup_command_freelist() */
+   spin_lock_init(&slab.lock);
+   slab.out = 0;
+   spin_lock_init(&shost.free_list_lock);
+   INIT_LIST_HEAD(&shost.free_list);
+   backup = kmem_cache_alloc(&slab, GFP_KERNEL);
+   list_add(&backup->list, &shost.free_list);
+   shost.pcpu_cmds = pcpuCmds;
+   for (i = 0; i < NPCPUS; i++) {
+      struct scsi_host_pcpu *hp;
+
+      if (posix_memalign((void **) &hp, VMK_L1_CACHELINE_SIZE,
+                         sizeof(*hp)) != 0) {
+         abort();
+      }
+      memset(hp, 0, sizeof(*hp));
+      spin_lock_init(&hp->lock);
+      INIT_LIST_HEAD(&hp->active);
+      shost.pcpu_cmds[i] = hp;
+      pthread_mutex_init(&inbox[i].lock, NULL);
+      inbox[i].head = NULL;
+   }
+   for (i = 0; i < NDEVS; i++) {
+      sdevs[i].host = &shost;
+      spin_lock_init(&sdevs[i].list_lock);
+      INIT_LIST_HEAD(&sdevs[i].cmd_list);
+   }
+   slabDryPermille = slabDry;
+
+   for (i = 0; i < NPCPUS; i++) {
+      pthread_create(&threads[i], NULL, pcpu_thread, (void *) i);
+   }
+   pthread_barrier_wait(&barrier);
+   lock_stats_take(total);
+   pthread_barrier_wait(&barrier);
+
+   pthread_barrier_wait(&barrier);
+   lock_stats_take(total);
+   found = walk_outstanding(++gen);
+   if (found != outstanding) {
+      fail("walk found %ld of %ld outstanding commands", found, outstanding);
+   }
+   pthread_barrier_wait(&barrier);
+
+   for (i = 0; i < NPCPUS; i++) {
+      pthread_join(threads[i], NULL);
+   }
+
+   /* scsi_destroy_command_freelist() */
+   for (i = 0; i < NPCPUS; i++) {
+      struct scsi_host_pcpu *hp = shost.pcpu_cmds[i];
+
+      if (hp->count > SCSI_CMD_MAG_SIZE) {
+         fail("magazine holds more than its size");
+      }
+      if (!list_empty(&hp->active)) {
+         fail("command still on an active list after its put");
+      }
+      magCmds += hp->count;
+      while (hp->count > 0) {
+         kmem_cache_free(&slab, hp->cmds[--hp->count]);
+      }
+      free(hp);
+   }
+   for (i = 0; i < NDEVS; i++) {
+      if (!list_empty(&sdevs[i].cmd_list)) {
+         fail("command still on the cmd_list of a device after its put");
+      }
+   }
+   if (list_empty(&shost.free_list)) {
+      fail("backup command lost");
+   } else {
+      backup = list_entry(shost.free_list.next, struct scsi_cmnd, list);
+      list_del_init(&backup->list);
+      kmem_cache_free(&slab, backup);
+   }
+   if (slab.out != 0) {
+      fail("commands lost or freed twice");
+   }
+
+   printf("%-9s %3d%% remote: %5.2f locks/IO, %5.2f moved/IO, "
+          "%ld outstanding at the walk, %ld in magazines\n",
+          cmdList ? "cmd_list" : "magazines", remote,
+          (double) total->locks / (NPCPUS * IOS_PER_PCPU),
+          (double) total->moved / (NPCPUS * IOS_PER_PCPU), found, magCmds);
+   if (slabDry != 0) {
+      printf("%-9s %3d%% remote, slab dry %d/1000: backup command used "
+             "%ld times\n", cmdList ? "cmd_list" : "magazines", remote,
+             slabDry, backupUses);
+   }
+}
+
+int
+main(void)
+{
+   struct lock_stats local, cmdList, remote, dry;
+   const unsigned long ios = (unsigned long) NPCPUS * IOS_PER_PCPU;
+
+   pthread_barrier_init(&barrier, NULL, NPCPUS + 1);
+
+   run(0, 0, 0, &local);
+   run(1, 0, 0, &cmdList);
+   run(0, REMOTE_PCT, 0, &remote);
+   run(0, REMOTE_PCT, SLAB_DRY_PERMILLE, &dry);
+   if (backupUses == 0) {
+      fail("backup command never used with the slab running dry");
+   }
+
+   if (local.locks != 2 * ios) {
+      fail("magazines take %.2f locks per IO, not two",
+           (double) local.locks / ios);
+   }
+   if (local.moved != 0) {
+      fail("magazines take locks last taken on another PCPU");
+   }
+   if (cmdList.locks != 4 * ios) {
+      fail("sdev_cmd_list takes %.2f locks per IO, not four",
+           (double) cmdList.locks / ios);
+   }
+   if ((double) remote.locks / ios >= CMD_LIST_LOCKS ||
+       (double) remote.moved / ios >= CMD_LIST_MOVED) {
+      fail("magazines no cheaper than the cmd_list with remote completions");
+   }
+
+   if (failures) {
+      fprintf(stderr, "scsi_cmd_locks: %d failures\n", failures);
+      return 1;
+   }
+   printf("scsi_cmd_locks: ok\n");
+   return 0;
+}
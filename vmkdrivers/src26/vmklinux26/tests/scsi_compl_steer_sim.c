@@ -0,0 +1,455 @@
+/*
+ * scsi_compl_steer_sim.c --
+ *
+ *    Simulation of the steering of scsi completions to the issuing PCPU
+ *    in vmklinux as it ships: SCSILinuxCmdDone, SCSILinuxComplPCPU,
+ *    SCSILinuxSteerCompletion, SCSILinuxScheduleCompletion,
+ *    SCSILinuxSignalBH, SCSILinuxTakeInbox and SCSILinuxBH of
+ *    vmware/linux_scsi.c.
+ *
+ *    One thread per PCPU issues commands to an HBA and runs the
+ *    interrupts and the bottom half of its PCPU. The HBA completes the
+ *    commands of each interrupt vector in order, either all on PCPU 0
+ *    (a single vector HBA) or each on the PCPU next to the one that
+ *    issued it. Every steering policy runs with both, and once with
+ *    remote BH kicks failing now and then. The timer cycles tick at
+ *    every read, so that a BH pass yields after a few dozen completions
+ *    as its 5 ms would with a busy HBA. The per-PCPU completion counters
+ *    of each run are printed.
+ *
+ *    The test fails if
+ *    - a command is completed twice or never;
+ *    - a command completes on another PCPU than the policy asks for,
+ *      unless the kick of the BH there failed;
+ *    - the completions one PCPU steers to another are completed out of
+ *      the order the interrupts delivered them in;
+ *    - the counters do not add up: completions steered out must be
+ *      steered in or taken back, and there must be no more kicks than
+ *      completions steered out;
+ *    - bursts from a single vector HBA take a kick for more than half
+ *      of their completions.
+ *
+ * extract ../../include/linux/poison.h: LIST_POISON1 LIST_POISON2
+ * extract ../../include/linux/list.h: __list_add list_add_tail __list_del list_del list_empty __list_splice list_splice_init
+ * extract ../../include/linux/dma-mapping.h: enum dma_data_direction
+ * extract ../../include/linux/timer.h: struct timer_list
+ * extract ../../include/scsi/scsi.h: DID_OK DID_ERROR DRIVER_OK DRIVER_BUSY DRIVER_SOFT DRIVER_MEDIA DRIVER_ERROR DRIVER_INVALID DRIVER_TIMEOUT DRIVER_HARD DRIVER_SENSE driver_byte
+ * extract ../../include/scsi/scsi_cmnd.h: struct scsi_pointer struct scsi_cmnd MAX_COMMAND_SIZE SCSI_SENSE_BUFFERSIZE
+ * extract ../../include/vmklinux26/vmklinux26_scsi.h: enum VMKLinux_Flags
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_const.h: VMK_SCSI_CMD_INQUIRY
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_ext.h: vmk_ScsiCommandDirection vmk_ScsiPluginStatus vmk_ScsiHostStatus vmk_ScsiDeviceStatus vmk_ScsiCmdStatus
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_types.h: vmk_ScsiSenseData vmk_ScsiCommandId vmk_ScsiCommandDoneCbk VMK_SCSI_MAX_CDB_LEN vmk_ScsiCommand
+ * extract ../vmware/linux_scsi.h: VMKLNX_SCSI_HOST_STATUS VMKLNX_SCSI_DEVICE_STATUS VMKLNX_SCSI_STATUS_NO_SUGGEST SCSILinuxCompleteCommand SCSILinuxCompleteCommandInt
+ * extract ../vmware/linux_scsi.c: scsiLinuxBH scsiLinuxTLS_t scsiLinuxTLS enum SCSI_COMPL_ON_INTR_PCPU vmklnx_scsi_compl_steering vmklnx_scsi_compl_domain_pcpus SCSILinuxTakeInbox SCSILinuxBusyRunEnds SCSILinuxBH SCSILinuxSignalBH SCSILinuxScheduleCompletion SCSILinuxComplPCPU SCSILinuxSteerCompletion SCSILinuxCmdDone
+ */
+
+#include "stubs.h"
+
+#define NPCPUS          4
+#define DOMAIN_PCPUS    2
+#define CMDS_PER_PCPU   40000
+#define QUEUE_DEPTH     32
+#define IRQ_BATCH       16
+#define KICK_FAIL_PCT   5
+#define STALL_LOOPS     2000000 /* loops without a completion: work was lost */
+
+#define NR_CPUS         NPCPUS
+
+#define module_param(name, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+#define VMK_FMT64                       "l"
+#define VMK_NOT_REACHED()               VMK_ASSERT(0)
+#define vmk_LogDebug(log, level, fmt, args...)  do { } while (0)
+#define vmk_WarningMessage(fmt, args...)        do { } while (0)
+#define vmk_AlertMessage(fmt, args...)          do { } while (0)
+
+/* the interrupts of a PCPU are those of its thread */
+#define vmk_GetPCPUNum()                ((unsigned) stub_pcpu)
+#define vmk_CPUDisableInterrupts()      local_irq_disable()
+#define vmk_CPUEnableInterrupts()       local_irq_enable()
+#define vmk_CPUHasIntsEnabled()         (!irqs_disabled())
+#define VMK_ASSERT_CPU_HAS_INTS_ENABLED()       VMK_ASSERT(!irqs_disabled())
+#define VMK_ASSERT_CPU_HAS_INTS_DISABLED()      VMK_ASSERT(irqs_disabled())
+
+/* a clock that ticks at every read, a BH pass yields after 100 reads */
+#define vmk_TimerUSToTC(us)             ((vmk_TimerCycles) (us) / 50)
+
+static __thread vmk_TimerCycles pcpuCycles;
+
+static vmk_TimerCycles
+vmk_GetTimerCycles(void)
+{
+   return ++pcpuCycles;
+}
+
+struct scsi_host_template {
+   const char *name;
+};
+
+struct Scsi_Host {
+   atomic_t host_busy;
+   struct scsi_host_template *hostt;
+};
+
+struct scsi_device {
+   struct Scsi_Host *host;
+   atomic_t device_busy;
+};
+
+/* what the extracted code calls, defined below */
+struct scsi_cmnd;
+static VMK_ReturnStatus vmk_BottomHalfSchedulePCPU(vmk_BottomHalf bh,
+                                                   unsigned pcpu);
+static void SCSILinuxProcessStandardInquiryResponse(struct scsi_cmnd *scmd);
+static void scsi_put_command(struct scsi_cmnd *scmd);
+static int scsi_delete_timer(struct scsi_cmnd *scmd);
+static void add_disk_randomness(void *disk);
+
+#include "scsi_compl_steer_sim.inc"
+
+/* a command of the simulation, as the HBA and the vmkernel see it */
+struct sim_cmd {
+   struct scsi_cmnd scmd;
+   vmk_ScsiCommand vmkCmd;
+   struct sim_cmd *hbanext;
+   int intr_pcpu;
+   unsigned int hbaSeq;         /* order the interrupts delivered it in */
+   int inflight;
+};
+
+static int bhPending[NPCPUS];
+static int singleVector;
+static int kickFailPct;
+
+/* the HBA: one in-order completion queue per interrupt PCPU */
+static struct {
+   pthread_mutex_t lock;
+   struct sim_cmd *head, *tail;
+   unsigned int seq;
+} hba[NPCPUS];
+
+static struct scsi_host_template sht = { .name = "sim" };
+static struct Scsi_Host shost = { .hostt = &sht };
+static struct scsi_device sdev = { .host = &shost };
+static struct sim_cmd cmds[NPCPUS][QUEUE_DEPTH];
+static int issued[NPCPUS];
+static int doneBy[NPCPUS];      /* completions of the commands of a PCPU */
+static int completed;
+static int stalled;
+static unsigned long takenBack;
+static unsigned long local;
+static unsigned int lastSeq[NPCPUS][NPCPUS];   /* [completer][intr PCPU] */
+
+/* kicks of the BH of another PCPU may fail */
+static VMK_ReturnStatus
+vmk_BottomHalfSchedulePCPU(vmk_BottomHalf bh, unsigned pcpu)
+{
+   VMK_ASSERT(bh == scsiLinuxBH);
+   VMK_ASSERT(pcpu < NPCPUS);
+   if (pcpu != vmk_GetPCPUNum() && rand() % 100 < kickFailPct) {
+      return VMK_FAILURE;
+   }
+   __atomic_store_n(&bhPending[pcpu], 1, __ATOMIC_SEQ_CST);
+   return VMK_OK;
+}
+
+static void
+SCSILinuxProcessStandardInquiryResponse(struct scsi_cmnd *scmd)
+{
+   (void) scmd;
+   fail("inquiry response on a read");
+}
+
+static void
+scsi_put_command(struct scsi_cmnd *scmd)
+{
+   (void) scmd;
+}
+
+static int
+scsi_delete_timer(struct scsi_cmnd *scmd)
+{
+   (void) scmd;
+   return 0;
+}
+
+static void
+add_disk_randomness(void *disk)
+{
+   (void) disk;
+}
+
+static int
+expected_pcpu(struct scsi_cmnd *scmd, int intrPCPU)
+{
+   int domain = vmklnx_scsi_compl_domain_pcpus;
+
+   switch (vmklnx_scsi_compl_steering) {
+   case SCSI_COMPL_ON_SUBMIT_PCPU:
+      return scmd->submit_pcpu;
+   case SCSI_COMPL_ON_SUBMIT_DOMAIN:
+      return scmd->submit_pcpu / domain == intrPCPU / domain ?
+             intrPCPU : scmd->submit_pcpu;
+   default:
+      return intrPCPU;
+   }
+}
+
+/* the vmkernel takes the command back from the BH */
+static void
+complete_cmd(struct vmk_ScsiCommand *vmkCmd)
+{
+   struct sim_cmd *cmd = container_of(vmkCmd, struct sim_cmd, vmkCmd);
+   int myPCPU = vmk_GetPCPUNum();
+   int submitter = cmd->scmd.submit_pcpu;
+
+   if (!__atomic_load_n(&cmd->inflight, __ATOMIC_SEQ_CST)) {
+      fail("command completed twice");
+      return;
+   }
+   if (vmkCmd->status.host != VMK_SCSI_HOST_OK ||
+       vmkCmd->status.device != VMK_SCSI_DEVICE_GOOD) {
+      fail("command completed with status %x/%x", vmkCmd->status.host,
+           vmkCmd->status.device);
+   }
+   if (myPCPU != expected_pcpu(&cmd->scmd, cmd->intr_pcpu)) {
+      if (!kickFailPct || myPCPU != cmd->intr_pcpu) {
+         fail("command of PCPU %d completed on PCPU %d", submitter, myPCPU);
+      }
+      __atomic_fetch_add(&takenBack, 1, __ATOMIC_SEQ_CST);
+   }
+   if (!kickFailPct) {
+      unsigned int *last = &lastSeq[myPCPU][cmd->intr_pcpu];
+
+      if (cmd->hbaSeq <= *last) {
+         fail("completions reordered");
+      }
+      *last = cmd->hbaSeq;
+   }
+   if (myPCPU / DOMAIN_PCPUS == submitter / DOMAIN_PCPUS) {
+      __atomic_fetch_add(&local, 1, __ATOMIC_SEQ_CST);
+   }
+   __atomic_fetch_add(&doneBy[submitter], 1, __ATOMIC_SEQ_CST);
+   __atomic_fetch_add(&completed, 1, __ATOMIC_SEQ_CST);
+   __atomic_store_n(&cmd->inflight, 0, __ATOMIC_SEQ_CST);
+}
+
+static void
+hba_issue(struct sim_cmd *cmd)
+{
+   int irq = cmd->intr_pcpu;
+
+   pthread_mutex_lock(&hba[irq].lock);
+   cmd->hbanext = NULL;
+   cmd->hbaSeq = ++hba[irq].seq;
+   if (hba[irq].tail) {
+      hba[irq].tail->hbanext = cmd;
+   } else {
+      hba[irq].head = cmd;
+   }
+   hba[irq].tail = cmd;
+   pthread_mutex_unlock(&hba[irq].lock);
+}
+
+/* the interrupt handler of a PCPU: the driver calls scsi_done */
+static void
+hba_interrupt(int myPCPU)
+{
+   struct sim_cmd *batch[IRQ_BATCH];
+   int n = 0, i;
+
+   pthread_mutex_lock(&hba[myPCPU].lock);
+   while (n < IRQ_BATCH && hba[myPCPU].head != NULL) {
+      batch[n] = hba[myPCPU].head;
+      hba[myPCPU].head = batch[n]->hbanext;
+      if (hba[myPCPU].head == NULL) {
+         hba[myPCPU].tail = NULL;
+      }
+      n++;
+   }
+   pthread_mutex_unlock(&hba[myPCPU].lock);
+
+   local_irq_disable();
+   for (i = 0; i < n; i++) {
+      batch[i]->scmd.scsi_done(&batch[i]->scmd);
+   }
+   local_irq_enable();
+}
+
+/* SCSILinuxQueueCommand() and the queuecommand of the LLD */
+static void
+issue(int me)
+{
+   int i;
+
+   for (i = 0; i < QUEUE_DEPTH && issued[me] < CMDS_PER_PCPU; i++) {
+      struct sim_cmd *cmd = &cmds[me][i];
+      struct scsi_cmnd *scmd = &cmd->scmd;
+
+      if (__atomic_load_n(&cmd->inflight, __ATOMIC_SEQ_CST)) {
+         continue;
+      }
+      issued[me]++;
+      memset(cmd, 0, sizeof(*cmd));
+      spin_lock_init(&scmd->vmklock);
+      scmd->device = &sdev;
+      scmd->cmnd[0] = 0x28;     /* READ(10) */
+      scmd->result = DID_OK;
+      scmd->vmkflags = VMK_FLAGS_NEED_CMDDONE;
+      scmd->vmkCmdPtr = &cmd->vmkCmd;
+      scmd->scsi_done = SCSILinuxCmdDone;
+      scmd->submit_pcpu = me;
+      cmd->vmkCmd.done = complete_cmd;
+      cmd->intr_pcpu = singleVector ? 0 : (me + 1) % NPCPUS;
+      cmd->inflight = 1;
+      atomic_inc(&sdev.device_busy);
+      atomic_inc(&shost.host_busy);
+      hba_issue(cmd);
+   }
+}
+
+static void *
+pcpu_thread(void *arg)
+{
+   int me = (int) (long) arg;
+   const int total = NPCPUS * CMDS_PER_PCPU;
+   int last = -1, idle = 0, now;
+
+   stub_pcpu = me;
+   while ((now = __atomic_load_n(&completed, __ATOMIC_SEQ_CST)) < total &&
+          !__atomic_load_n(&stalled, __ATOMIC_SEQ_CST)) {
+      if (now != last) {
+         last = now;
+         idle = 0;
+      } else if (++idle > STALL_LOOPS) {
+         __atomic_store_n(&stalled, 1, __ATOMIC_SEQ_CST);
+         fail("completions lost, no BH runs for them");
+         break;
+      }
+      if (xchg(&bhPending[me], 0)) {
+         SCSILinuxBH(NULL);
+      }
+      hba_interrupt(me);
+      issue(me);
+      sched_yield();
+   }
+   return NULL;
+}
+
+static void
+sim(int policy, int single, int failPct)
+{
+   static const char *policies[] = { "intr", "submit", "domain" };
+   pthread_t threads[NPCPUS];
+   unsigned long out = 0, in = 0, kicks = 0, done = 0;
+   int i;
+
+   for (i = 0; i < NPCPUS; i++) {
+      scsiLinuxTLS_t *tls = scsiLinuxTLS[i];
+
+      memset(tls, 0, sizeof(*tls));
+      INIT_LIST_HEAD(&tls->isrDoneCmds);
+      INIT_LIST_HEAD(&tls->bhDoneCmds);
+      hba[i].head = hba[i].tail = NULL;
+      hba[i].seq = 0;
+   }
+   memset(bhPending, 0, sizeof(bhPending));
+   memset(cmds, 0, sizeof(cmds));
+   memset(issued, 0, sizeof(issued));
+   memset(doneBy, 0, sizeof(doneBy));
+   memset(lastSeq, 0, sizeof(lastSeq));
+   completed = 0;
+   stalled = 0;
+   takenBack = 0;
+   local = 0;
+   vmklnx_scsi_compl_steering = policy;
+   singleVector = single;
+   kickFailPct = failPct;
+
+   for (i = 0; i < NPCPUS; i++) {
+      pthread_create(&threads[i], NULL, pcpu_thread, (void *) (long) i);
+   }
+   for (i = 0; i < NPCPUS; i++) {
+      pthread_join(threads[i], NULL);
+   }
+
+   for (i = 0; i < NPCPUS; i++) {
+      if (doneBy[i] != CMDS_PER_PCPU) {
+         fail("%d commands of PCPU %d never completed",
+              CMDS_PER_PCPU - doneBy[i], i);
+      }
+   }
+   if (atomic_read(&sdev.device_busy) || atomic_read(&shost.host_busy)) {
+      fail("busy counts left at %d/%d", atomic_read(&sdev.device_busy),
+           atomic_read(&shost.host_busy));
+   }
+
+   printf("%-6s %-6s kick fails %d%%:", policies[policy],
+          single ? "1 vec" : "n vec", failPct);
+   for (i = 0; i < NPCPUS; i++) {
+      scsiLinuxTLS_t *tls = scsiLinuxTLS[i];
+
+      printf("  %lu/%lu/%lu/%lu", tls->cmdsDone, tls->steeredOut,
+             tls->steeredIn, tls->kicks);
+      out += tls->steeredOut;
+      in += tls->steeredIn;
+      kicks += tls->kicks;
+      done += tls->cmdsDone;
+   }
+   /* completions that ran in the cache domain of the issuing PCPU */
+   printf("  in domain %3lu%%  kicks/steered %.2f\n",
+          local * 100 / (NPCPUS * CMDS_PER_PCPU),
+          out ? (double) kicks / out : 0.0);
+
+   if (done != NPCPUS * CMDS_PER_PCPU) {
+      fail("BH completion counters do not add up");
+   }
+   if (out != in + takenBack) {
+      fail("steered completions not steered in or taken back");
+   }
+   if (kicks > out) {
+      fail("more kicks than steered completions");
+   }
+   /* the interrupts complete bursts, most of a burst needs no kick */
+   if (single && kicks * 2 > out) {
+      fail("a burst of steered completions costs more than one kick");
+   }
+   if (!failPct && policy != SCSI_COMPL_ON_INTR_PCPU &&
+       local != NPCPUS * CMDS_PER_PCPU) {
+      fail("completions outside the cache domain of the issuing PCPU");
+   }
+}
+
+int
+main(void)
+{
+   int policy, i;
+
+   for (i = 0; i < NPCPUS; i++) {
+      pthread_mutex_init(&hba[i].lock, NULL);
+      /* SCSILinux_Init() */
+      if (posix_memalign((void **) &scsiLinuxTLS[i], VMK_L1_CACHELINE_SIZE,
+                         sizeof(scsiLinuxTLS_t))) {
+         return 1;
+      }
+   }
+   vmklnx_scsi_compl_domain_pcpus = DOMAIN_PCPUS;
+
+   printf("per PCPU: completed/steered out/steered in/kicks\n");
+   for (policy = SCSI_COMPL_ON_INTR_PCPU;
+        policy <= SCSI_COMPL_ON_SUBMIT_DOMAIN; policy++) {
+      sim(policy, 1, 0);
+      sim(policy, 0, 0);
+   }
+   sim(SCSI_COMPL_ON_SUBMIT_PCPU, 1, KICK_FAIL_PCT);
+
+   for (i = 0; i < NPCPUS; i++) {
+      free(scsiLinuxTLS[i]);
+   }
+   if (failures) {
+      fprintf(stderr, "scsi_compl_steer: %d failures\n", failures);
+      return 1;
+   }
+   printf("scsi_compl_steer: ok\n");
+   return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * sg_passthru_test.c --
+ *
+ *    Test of the pass-through of the vmk_SgArray of an IO to the LLDs
+ *    as it ships: SCSILinuxComputeSGArray in vmware/linux_scsi.c,
+ *    scsi_sglist_first and scsi_for_each_sg in include/scsi/scsi_cmnd.h,
+ *    sg_copy_buffer in include/linux/scatterlist.h and
+ *    hpsa_scatter_gather in drivers/scsi/hpsa/hpsa_scsi.c. sg_next,
+ *    sg_reset, sg_dma_address and sg_dma_len are those of stubs.h, as the
+ *    asm scatterlist header is not part of this tree.
+ *
+ *    Random SG arrays of 1 to MAX_SG elements are computed into a
+ *    scsi_cmnd both for an adapter added with vmkSgArray (an SG_VMK
+ *    cursor over the vmk_SgElem array) and for one without (a converted
+ *    SG_LINUX table), then walked the ways the LLDs walk them.
+ *
+ *    The test fails if
+ *    - a walk with scsi_for_each_sg or the hpsa SG list does not have
+ *      the elements of the vmk_SgArray, in order, for either list type;
+ *    - a second walk of the same command, or a walk after
+ *      sg_copy_buffer or after a partial walk, starts anywhere but at
+ *      the first element;
+ *    - sg_copy_buffer does not copy the bytes the elements point at;
+ *    - request_bufflen is not the sum of the element lengths, or a
+ *      single element command is not handed over as a plain buffer;
+ *    - the vmkSgArray path allocates a scatterlist table.
+ *
+ * extract ../../include/linux/dma-mapping.h: enum dma_data_direction
+ * extract ../../include/linux/timer.h: struct timer_list
+ * extract ../../include/linux/scatterlist.h: sg_copy_buffer sg_copy_to_buffer
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_ext.h: vmk_ScsiCommandDirection vmk_ScsiPluginStatus vmk_ScsiHostStatus vmk_ScsiDeviceStatus vmk_ScsiCmdStatus
+ * extract ../../../../bora/vmkernel/include/vmkapi/scsi/vmkapi_scsi_types.h: vmk_ScsiSenseData vmk_ScsiCommandId vmk_ScsiCommandDoneCbk VMK_SCSI_MAX_CDB_LEN vmk_ScsiCommand
+ * extract ../../include/scsi/scsi_cmnd.h: struct scsi_pointer struct scsi_cmnd MAX_COMMAND_SIZE SCSI_SENSE_BUFFERSIZE scsi_sglist scsi_sglist_first scsi_for_each_sg
+ * extract ../vmware/linux_scsi.c: SCSILinuxComputeSGArray
+ * extract ../../include/linux/cciss_ioctl.h: BYTE WORD HWORD DWORD SENSEINFOBYTES SCSI3Addr_struct PhysDevAddr_struct LogDevAddr_struct LUNAddr_struct RequestBlock_struct MoreErrInfo_struct ErrorInfo_struct
+ * extract ../../drivers/scsi/hpsa/hpsa_cmd.h: QWORD vals32 MAXSGENTRIES CommandListHeader_struct ErrDescriptor_struct SGDescriptor_struct PADSIZE CommandList_struct
+ * extract ../../drivers/scsi/hpsa/hpsa_scsi.c: hpsa_scatter_gather
+ */
+
+#include "stubs.h"
+
+#define MAX_SG          128
+#define ROUNDS          20000
+#define PAGE_SIZE       4096UL
+
+#define vmk_LogDebug(log, level, fmt, args...)  do { } while (0)
+#define vmk_AssertMemorySupportsIO(ma, len)     ((void) (ma), (void) (len))
+
+/* the machine and virtual addresses of the test are the same */
+#define __va(x)                 ((void *) (uintptr_t) (x))
+#define phys_to_virt(x)         __va(x)
+#define phys_to_page(x)         ((struct page *) (uintptr_t) ((x) & ~(PAGE_SIZE - 1)))
+#define offset_in_page(x)       ((unsigned int) ((x) & (PAGE_SIZE - 1)))
+
+struct pci_dev;
+#define pci_map_single(pdev, ptr, size, dir)                               \
+   ((void) (pdev), (void) (size), (void) (dir), (dma_addr_t) (uintptr_t) (ptr))
+#define pci_map_sg(pdev, sg, nents, dir)                                   \
+   ((void) (pdev), (void) (sg), (void) (dir), (nents))
+
+struct vmklnx_ScsiAdapter {
+   unsigned vmkSgArray;
+};
+
+struct Scsi_Host {
+   void *adapter;
+};
+
+struct scsi_device {
+   struct Scsi_Host *host;
+};
+
+/* what the extracted code calls, defined below */
+struct vmk_ScsiCommand;
+static struct scatterlist *scsi_alloc_sgtable(unsigned int nbElems);
+
+#include "sg_passthru_test.inc"
+
+static struct vmklnx_ScsiAdapter adapter;
+static struct Scsi_Host shost = { .adapter = &adapter };
+static struct scsi_device sdev = { .host = &shost };
+static unsigned long sgtableAllocs;
+static int round;
+
+#define fail_round(fmt, args...)  fail("round %d: " fmt, round, ## args)
+
+static struct scatterlist *
+scsi_alloc_sgtable(unsigned int nbElems)
+{
+   sgtableAllocs++;
+   return calloc(nbElems, sizeof(struct scatterlist));
+}
+
+static int
+check_walk(struct scsi_cmnd *cmd, vmk_SgArray *sga, int nseg)
+{
+   struct scatterlist *sg;
+   int i;
+
+   scsi_for_each_sg(cmd, sg, nseg, i) {
+      if (sg_dma_address(sg) != sga->elem[i].addr ||
+          sg_dma_len(sg) != sga->elem[i].length) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/* the SG list hpsa hands the controller for cmd */
+static void
+check_hpsa(struct scsi_cmnd *cmd, vmk_SgArray *sga)
+{
+   static CommandList_struct cp;
+   int n = sga->nbElems;
+   int i;
+
+   memset(&cp, 0, sizeof(cp));
+   hpsa_scatter_gather(NULL, &cp, cmd);
+   if (cp.Header.SGList != n || cp.Header.SGTotal != n) {
+      fail_round("hpsa walked %d elements of %d", cp.Header.SGList, n);
+      return;
+   }
+   for (i = 0; i < n; i++) {
+      u64 addr = ((u64) cp.SG[i].Addr.upper << 32) | cp.SG[i].Addr.lower;
+
+      if (addr != sga->elem[i].addr || cp.SG[i].Len != sga->elem[i].length) {
+         fail_round("hpsa SG list differs from the vmk_SgArray at %d", i);
+         return;
+      }
+   }
+}
+
+int
+main(void)
+{
+   static unsigned char backing[MAX_SG * 2 * 512];
+   static unsigned char copy[sizeof(backing)];
+   unsigned long vmkAllocs = 0;
+   unsigned int seed = 1;
+   vmk_SgArray *sga;
+   int i;
+
+   sga = malloc(sizeof(*sga) + MAX_SG * sizeof(sga->elem[0]));
+   for (i = 0; i < (int) sizeof(backing); i++) {
+      backing[i] = (unsigned char) (i * 7 + (i >> 8));
+   }
+
+   for (round = 0; round < ROUNDS; round++) {
+      static struct scsi_cmnd cmd;
+      vmk_ScsiCommand vmkCmd;
+      unsigned int total = 0, pos = 0;
+      unsigned long allocsBefore = sgtableAllocs;
+      int n;
+
+      adapter.vmkSgArray = round & 1;
+      n = 1 + rand_r(&seed) % MAX_SG;
+      sga->nbElems = n;
+      sga->maxElems = MAX_SG;
+      for (i = 0; i < n; i++) {
+         unsigned int len = 1 + rand_r(&seed) % 512;
+
+         sga->elem[i].addr = (uintptr_t) &backing[pos];
+         sga->elem[i].length = len;
+         pos += len + rand_r(&seed) % 512;
+         total += len;
+      }
+
+      memset(&cmd, 0, sizeof(cmd));
+      memset(&vmkCmd, 0, sizeof(vmkCmd));
+      vmkCmd.sgArray = sga;
+      cmd.device = &sdev;
+      cmd.vmkCmdPtr = &vmkCmd;
+      cmd.sc_data_direction = DMA_FROM_DEVICE;
+      if (SCSILinuxComputeSGArray(&cmd, &vmkCmd) != VMK_OK) {
+         fail_round("scatterlist table allocation failed");
+         continue;
+      }
+      if (adapter.vmkSgArray) {
+         vmkAllocs += sgtableAllocs - allocsBefore;
+      }
+      if (cmd.request_bufflen != total) {
+         fail_round("request_bufflen is not the sum of the elements");
+      }
+
+      if (n == 1) {
+         if (cmd.use_sg != 0 || cmd.request_bufferMA != sga->elem[0].addr ||
+             cmd.request_buffer != __va(sga->elem[0].addr)) {
+            fail_round("single element command not handed over as a buffer");
+         }
+         check_hpsa(&cmd, sga);
+         goto done;
+      }
+      if (cmd.use_sg != n) {
+         fail_round("use_sg is not the number of elements");
+      }
+
+      if (!check_walk(&cmd, sga, cmd.use_sg)) {
+         fail_round("scsi_for_each_sg walk differs from the vmk_SgArray");
+      }
+      if (!check_walk(&cmd, sga, cmd.use_sg)) {
+         fail_round("second scsi_for_each_sg walk does not start over");
+      }
+      if (!check_walk(&cmd, sga, 1 + rand_r(&seed) % n) ||
+          !check_walk(&cmd, sga, cmd.use_sg)) {
+         fail_round("walk after a partial walk does not start over");
+      }
+
+      if (sg_copy_to_buffer(scsi_sglist(&cmd), cmd.use_sg, copy,
+                            sizeof(copy)) != total) {
+         fail_round("sg_copy_buffer copied a wrong byte count");
+      } else {
+         pos = 0;
+         for (i = 0; i < n; i++) {
+            if (memcmp(&copy[pos], __va(sga->elem[i].addr),
+                       sga->elem[i].length) != 0) {
+               fail_round("sg_copy_buffer copied the wrong bytes");
+               break;
+            }
+            pos += sga->elem[i].length;
+         }
+      }
+      if (sg_dma_address(scsi_sglist(&cmd)) != sga->elem[0].addr ||
+          !check_walk(&cmd, sga, cmd.use_sg)) {
+         fail_round("walk after sg_copy_buffer does not start over");
+      }
+
+      /* the partial walk leaves the cursor mid-list for hpsa */
+      check_walk(&cmd, sga, 1 + rand_r(&seed) % n);
+      if (n <= MAXSGENTRIES) {
+         check_hpsa(&cmd, sga);
+      }
+
+done:
+      if (cmd.sgArray != cmd.vmksg) {
+         free(cmd.sgArray);
+      }
+   }
+   free(sga);
+
+   if (vmkAllocs != 0) {
+      fail("vmkSgArray path allocated a scatterlist table");
+   }
+   if (sgtableAllocs != ROUNDS / 2) {
+      fail("converted path did not allocate a table per IO");
+   }
+
+   if (failures) {
+      fprintf(stderr, "sg_passthru: %d failures\n", failures);
+      return 1;
+   }
+   printf("sg_passthru: %d IOs, %lu scatterlist tables for the converted "
+          "path, none for vmkSgArray\n", ROUNDS, sgtableAllocs);
+   printf("sg_passthru: ok\n");
+   return 0;
+}
@@ -0,0 +1,264 @@
+/*
+ * skb_complete_bench.c --
+ *
+ *    Benchmark of the rx completion path of vmware/linux_net.c as it
+ *    ships: vmklnx_net_skb_complete, do_free_skb_bulk, do_free_skb and
+ *    do_recycle_skb_bits.
+ *
+ *    Synthetic frames of 9000 bytes, a head skb with a frag_list of 3
+ *    fragment skbs, and plain 1500 byte frames for reference, complete
+ *    in pktLists of 1 to 64 packets. "single" hands the vmkernel's list
+ *    to vmklnx_net_skb_complete one packet at a time, so every skb is
+ *    freed and rxInFlight dropped per packet; "batched" hands it the
+ *    whole list. vmk_Slab is a LIFO free list, as its per-PCPU cache is,
+ *    and vmk_PktReleaseAfterComplete puts the handle on a free list, so
+ *    the numbers carry the costs the two differ in. Each frame's skbs are
+ *    taken back out of the slab between rounds, outside the timed section.
+ *
+ *    usage: skb_complete_bench [thousands of frames per run]
+ *
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/vmklinux26/vmknetddinetq.h: VMKNETDDI_QUEUEOPS_INVALID_QUEUEID
+ * extract ../../include/linux/skbuff.h: CHECKSUM_NONE MAX_SKB_FRAGS skb_frag_t struct skb_frag_struct struct skb_shared_info struct sk_buff skb_shinfo
+ * extract ../../include/linux/if_vlan.h: struct vlan_skb_tx_cookie VLAN_TX_SKB_CB
+ * extract ../../../../bora/vmkernel/include/vmkapi/net/vmkapi_net_uplink.h: vmk_UplinkCompletionData
+ * extract ../vmware/linux_net.c: NETDEV_SKB_FREE_BATCH do_recycle_skb_bits vmklnx_net_skb_complete do_free_skb do_free_skb_bulk
+ */
+
+#include <time.h>
+
+#include "stubs.h"
+
+#define FRAGS_MAX       3
+#define LIST_MAX        64
+#define SKBS            (LIST_MAX * (1 + FRAGS_MAX))
+
+struct sk_buff;
+
+/* vmk_Slab behind the skb pool: its per-PCPU cache of free objects */
+struct kmem_cache_s {
+   unsigned int count;
+   void *objs[SKBS];
+};
+
+static void
+vmklnx_kmem_cache_free(struct kmem_cache_s *cache, void *obj)
+{
+   cache->objs[cache->count++] = obj;
+}
+
+static void *
+vmklnx_kmem_cache_alloc(struct kmem_cache_s *cache)
+{
+   return cache->objs[--cache->count];
+}
+
+struct net_device {
+   vmk_PktCompletionData genCount;
+   unsigned long linnet_pkt_completed;
+   atomic_t rxInFlight;
+};
+
+/* a packet handle and its completion data */
+struct bench_pkt {
+   vmk_PktHandle handle;
+   vmk_PktCompletionData ioData;
+   vmk_PktCompletionData auxData;
+   struct bench_pkt *next;
+};
+
+#define BP(p)           container_of(p, struct bench_pkt, handle)
+
+static struct bench_pkt *pktFree;
+
+static void __attribute__((noinline))
+vmk_PktReleaseAfterComplete(vmk_PktHandle *handle)
+{
+   struct bench_pkt *pkt = BP(handle);
+
+   pkt->next = pktFree;
+   pktFree = pkt;
+}
+
+static void
+vmk_PktGetCompletionData(vmk_PktHandle *handle, vmk_PktCompletionData *ioData,
+                         vmk_PktCompletionData *auxData)
+{
+   *ioData = BP(handle)->ioData;
+   *auxData = BP(handle)->auxData;
+}
+
+static void
+vmk_PktClearCompletionData(vmk_PktHandle *handle)
+{
+   BP(handle)->ioData = NULL;
+   BP(handle)->auxData = NULL;
+}
+
+/* no page frags here */
+static void
+vmklnx_page_pool_put_frags(struct sk_buff *skb)
+{
+   (void) skb;
+   fail("page frags on a benchmark frame");
+}
+
+/* declared ahead in linux_net.c */
+static void do_free_skb_bulk(struct sk_buff **skbs, int count);
+
+#include "skb_complete_bench.inc"
+
+static struct kmem_cache_s cache;
+static struct net_device dev = { .genCount = (vmk_PktCompletionData) 0x1234 };
+
+static struct bench_pkt *
+alloc_pkt(void)
+{
+   struct bench_pkt *pkt = pktFree;
+
+   pktFree = pkt->next;
+   return pkt;
+}
+
+/* netif_rx_common(): a frame of nFrags fragments and its packet */
+static struct bench_pkt *
+build_frame(unsigned int bytes, int nFrags)
+{
+   struct sk_buff *skb = vmklnx_kmem_cache_alloc(&cache);
+   struct sk_buff **tail = &skb_shinfo(skb)->frag_list;
+   struct bench_pkt *pkt = alloc_pkt();
+   int i;
+
+   skb->pkt = &pkt->handle;
+   skb->len = bytes;
+   skb->data_len = nFrags ? bytes - 128 : 0;
+   skb->protocol = 8;
+   skb->ip_summed = 1;
+   skb->csum = bytes;
+   for (i = 0; i < nFrags; i++) {
+      struct sk_buff *frag = vmklnx_kmem_cache_alloc(&cache);
+
+      frag->pkt = &alloc_pkt()->handle;
+      frag->len = (bytes - 128) / nFrags;
+      frag->csum = i + 1;
+      *tail = frag;
+      tail = &frag->next;
+   }
+   *tail = NULL;
+   pkt->ioData = skb;
+   pkt->auxData = dev.genCount;
+   atomic_inc(&dev.rxInFlight);
+   return pkt;
+}
+
+static void __attribute__((noinline))
+complete_single(vmk_PktList *list)
+{
+   vmk_PktList one;
+
+   vmk_PktListInit(&one);
+   while (!vmk_PktListIsEmpty(list)) {
+      vmk_PktListAddToTail(&one, vmk_PktListPopHead(list));
+      vmklnx_net_skb_complete(NULL, &dev, &one);
+   }
+}
+
+static void __attribute__((noinline))
+complete_batched(vmk_PktList *list)
+{
+   vmklnx_net_skb_complete(NULL, &dev, list);
+}
+
+static u64
+now_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static double
+run(void (*complete)(vmk_PktList *), unsigned int bytes, int nFrags,
+    int listLen, unsigned long frames)
+{
+   vmk_PktList list;
+   unsigned long done = 0;
+   u64 ns = 0, t;
+   int i;
+
+   while (done < frames) {
+      vmk_PktListInit(&list);
+      for (i = 0; i < listLen; i++) {
+         vmk_PktListAddToTail(&list, &build_frame(bytes, nFrags)->handle);
+      }
+      t = now_ns();
+      complete(&list);
+      ns += now_ns() - t;
+      done += listLen;
+   }
+   if (atomic_read(&dev.rxInFlight) != 0 || cache.count != SKBS) {
+      fprintf(stderr, "rxInFlight left at %d, %u of %d skbs freed\n",
+              atomic_read(&dev.rxInFlight), cache.count, SKBS);
+      exit(1);
+   }
+   return (double) ns / done;
+}
+
+int
+main(int argc, char **argv)
+{
+   static const int lists[] = { 1, 8, 32, 64 };
+   static const struct {
+      unsigned int bytes;
+      int frags;
+   } kinds[] = { { 9000, FRAGS_MAX }, { 1500, 0 } };
+   unsigned long frames = (argc > 1 ? strtoul(argv[1], NULL, 0) : 2000) *
+                          1000;
+   size_t skbStride = (sizeof(struct sk_buff) +
+                       sizeof(struct skb_shared_info) + 63) & ~63UL;
+   unsigned char *skbs;
+   struct bench_pkt *pkts;
+   unsigned int i, k, l;
+
+   /* constructed as skb_pool_ctor() leaves them */
+   if (posix_memalign((void **) &skbs, 64, SKBS * skbStride)) {
+      return 1;
+   }
+   memset(skbs, 0, SKBS * skbStride);
+   pkts = calloc(SKBS, sizeof(*pkts));
+   for (i = 0; i < SKBS; i++) {
+      struct sk_buff *skb = (struct sk_buff *) (skbs + i * skbStride);
+
+      skb->cache = &cache;
+      do_recycle_skb_bits(skb);
+      skb->qid = VMKNETDDI_QUEUEOPS_INVALID_QUEUEID;
+      vmklnx_kmem_cache_free(&cache, skb);
+      vmk_PktReleaseAfterComplete(&pkts[i].handle);
+   }
+
+   printf("%-6s %-6s %5s %12s %12s %12s %12s\n", "frame", "frags", "list",
+          "single ns", "batched ns", "single ps/B", "batched ps/B");
+   for (k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+      for (l = 0; l < sizeof(lists) / sizeof(lists[0]); l++) {
+         double single, batched;
+
+         /* warm up, then alternate so that neither gets a cold start */
+         run(complete_batched, kinds[k].bytes, kinds[k].frags, lists[l],
+             frames / 10);
+         single = run(complete_single, kinds[k].bytes, kinds[k].frags,
+                      lists[l], frames);
+         batched = run(complete_batched, kinds[k].bytes, kinds[k].frags,
+                       lists[l], frames);
+         printf("%-6u %-6d %5d %12.1f %12.1f %12.2f %12.2f\n",
+                kinds[k].bytes, kinds[k].frags, lists[l], single, batched,
+                single * 1000 / kinds[k].bytes,
+                batched * 1000 / kinds[k].bytes);
+      }
+   }
+   printf("%lu frames completed\n", dev.linnet_pkt_completed);
+
+   free(pkts);
+   free(skbs);
+   return failures != 0;
+}
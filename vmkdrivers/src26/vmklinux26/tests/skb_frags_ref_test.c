@@ -0,0 +1,517 @@
+/*
+ * skb_frags_ref_test.c --
+ *
+ *    Test of how long the page frags of a received skb live in vmklinux,
+ *    and of the rx page pools they may come from, as the code ships:
+ *    skb_release_data and pskb_expand_head of linux/net/skbuff.c,
+ *    __kfree_skb, vmklnx_net_skb_complete and vmklnx_page_pool_* of
+ *    vmware/linux_net.c.
+ *
+ *    vmklinux has no per-page reference count: the frags belong to the
+ *    packet handle and are freed with it, when the last skb holding the
+ *    handle drops its fragsref. Frags out of an rx page pool go back to
+ *    the pool at that point. A driver fills skbs, some with a frag_list,
+ *    with half-page buffers from its pool, or from alloc_page when the
+ *    pool runs dry; the skbs go through skb_get/kfree_skb pairs and head
+ *    reallocations in random order and are then dropped with kfree_skb or
+ *    completed by the vmkernel. Part way through, the driver replaces its
+ *    pool while buffers of the old one are still out.
+ *
+ *    The test fails if
+ *    - a packet handle is released while an skb still points at it, or is
+ *      released more or less than once;
+ *    - a reallocated head is not freed exactly once;
+ *    - an skb, on a frag_list or not, is leaked or freed twice;
+ *    - a pool buffer is handed out while an skb still holds it, or does
+ *      not come back once no skb does;
+ *    - the pool runs dry although fewer buffers are out than it has;
+ *    - a destroyed pool is freed before its last buffer is back, or not
+ *      freed then.
+ *
+ * extract ../../include/linux/poison.h: LIST_POISON1 LIST_POISON2
+ * extract ../../include/linux/list.h: LIST_HEAD_INIT LIST_HEAD __list_add list_add __list_del list_del
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/linux/skbuff.h: SKB_DATA_ALIGN SKB_DATAREF_SHIFT SKB_DATAREF_MASK MAX_SKB_FRAGS skb_frag_t struct skb_frag_struct struct skb_shared_info struct sk_buff skb_shinfo kfree_skb skb_get skb_shared skb_fill_page_desc
+ * extract ../../../../bora/vmkernel/include/vmkapi/net/vmkapi_net_uplink.h: vmk_UplinkCompletionData
+ * extract ../vmware/linux_net.c: NETDEV_SKB_FREE_BATCH vmklnx_rx_page_pool_kb struct vmklnx_page_pool pagePoolList pagePoolLock pagePoolCount page_pool_release vmklnx_page_pool_create vmklnx_page_pool_destroy vmklnx_page_pool_alloc vmklnx_page_pool_owns page_pool_put vmklnx_page_pool_free vmklnx_page_pool_put_frags do_free_skb_bulk __kfree_skb vmklnx_net_skb_complete
+ * extract ../linux/net/skbuff.c: skb_drop_list skb_drop_fraglist skb_clone_fraglist skb_release_data pskb_expand_head
+ */
+
+#include <errno.h>
+
+#include "stubs.h"
+
+#define SKBS            100000
+#define OPS_MAX         8
+#define FRAG_SKBS_MAX   3
+#define BUFS_MAX        4               /* pool buffers per skb */
+#define RING            256             /* descriptors of the driver */
+#define IN_FLIGHT       32              /* skbs up the stack at a time */
+#define POOL_BUFS       (2 * RING)
+
+#define PAGE_SHIFT      12
+#define PAGE_SIZE       (1UL << PAGE_SHIFT)
+#define PAGE_MASK       (~(PAGE_SIZE - 1))
+#define ALIGN(x, a)     (((x) + (a) - 1) & ~((a) - 1))
+#define SMP_CACHE_BYTES 64
+
+typedef unsigned int gfp_t;
+
+#define GFP_KERNEL      0
+#define GFP_ATOMIC      1
+
+/* addresses are their own physical and bus addresses, a page its pfn */
+#define virt_to_phys(v)         ((u64) (uintptr_t) (v))
+#define virt_to_page(v)         ((struct page *) (virt_to_phys(v) >> PAGE_SHIFT))
+#define page_to_phys(p)         ((u64) (uintptr_t) (p) << PAGE_SHIFT)
+#define page_address(p)         ((void *) (uintptr_t) page_to_phys(p))
+
+#define VMK_MODULE_HEAP_ID      0
+#define PCI_DMA_FROMDEVICE      2
+
+typedef pthread_rwlock_t rwlock_t;
+
+#define DEFINE_RWLOCK(x)        rwlock_t x = PTHREAD_RWLOCK_INITIALIZER
+#define read_lock_irqsave(l, flags)                                        \
+   (local_irq_save(flags), pthread_rwlock_rdlock(l))
+#define read_unlock_irqrestore(l, flags)                                   \
+   (pthread_rwlock_unlock(l), local_irq_restore(flags))
+#define write_lock_irqsave(l, flags)                                       \
+   (local_irq_save(flags), pthread_rwlock_wrlock(l))
+#define write_unlock_irqrestore(l, flags)                                  \
+   (pthread_rwlock_unlock(l), local_irq_restore(flags))
+
+struct page;
+struct pci_dev;
+struct sk_buff;
+struct kmem_cache_s;
+
+struct net_device {
+   vmk_PktCompletionData genCount;
+   unsigned long linnet_pkt_completed;
+   atomic_t rxInFlight;
+};
+
+/* what the extracted code calls, defined below */
+static void *kmalloc(size_t size, gfp_t flags);
+static void *kzalloc(size_t size, gfp_t flags);
+static void kfree(const void *p);
+static void *vmklnx_kmalloc_align(vmk_HeapID heap, size_t size, size_t align);
+static void vmklnx_kfree(vmk_HeapID heap, const void *p);
+static dma_addr_t pci_map_single(struct pci_dev *pdev, void *ptr,
+                                 size_t size, int dir);
+static void pci_unmap_single(struct pci_dev *pdev, dma_addr_t dma,
+                             size_t size, int dir);
+static int vmklnx_is_panic(void);
+static void vmk_PktRelease(vmk_PktHandle *pkt);
+static void vmk_PktReleaseIRQ(vmk_PktHandle *pkt);
+static void vmk_PktReleaseAfterComplete(vmk_PktHandle *pkt);
+static void vmk_PktGetCompletionData(vmk_PktHandle *pkt,
+                                     vmk_PktCompletionData *ioData,
+                                     vmk_PktCompletionData *auxData);
+static void vmk_PktClearCompletionData(vmk_PktHandle *pkt);
+static void do_free_skb(struct sk_buff *skb);
+
+/* declared ahead in linux_net.c */
+static void do_free_skb_bulk(struct sk_buff **skbs, int count);
+
+/* between the files the code comes from */
+void vmklnx_page_pool_put_frags(struct sk_buff *skb);
+void skb_release_data(struct sk_buff *skb);
+
+#include "skb_frags_ref_test.inc"
+
+/*
+ * A packet handle, with the skb it completes to, and an skb with what
+ * map_pkt_to_skb() or the driver would have set up.
+ */
+struct test_pkt {
+   vmk_PktHandle handle;
+   struct sk_buff *skb;
+   vmk_PktCompletionData genCount;
+   int released;
+   int skbs;            /* skbs that point at this handle */
+};
+
+struct test_skb {
+   struct sk_buff skb;
+   struct skb_shared_info shinfo;      /* skb_shinfo() */
+   unsigned char head[256];
+   int dying;
+   int freed;
+};
+
+#define TP(p)           container_of(p, struct test_pkt, handle)
+#define TS(s)           container_of(s, struct test_skb, skb)
+
+static long heads, headsFreed, poolsFreed, unmaps;
+static u64 allocPageBufs;
+static struct vmklnx_page_pool *freedPool;
+
+/*
+ * Who holds each buffer of the current and the previous pool: 0 if the
+ * pool does, else the test_pkt whose skb has it as a frag.
+ */
+static struct test_pkt *bufOwner[2][POOL_BUFS];
+static struct vmklnx_page_pool *bufPool[2];
+
+static void *
+kmalloc(size_t size, gfp_t flags)
+{
+   (void) flags;
+   heads++;
+   return malloc(size);
+}
+
+static void *
+kzalloc(size_t size, gfp_t flags)
+{
+   (void) flags;
+   return calloc(1, size);
+}
+
+/* frees the heads pskb_expand_head() allocates, and pool structs */
+static void
+kfree(const void *p)
+{
+   if (p == freedPool) {
+      poolsFreed++;
+   } else {
+      headsFreed++;
+   }
+   free((void *) p);
+}
+
+static void *
+vmklnx_kmalloc_align(vmk_HeapID heap, size_t size, size_t align)
+{
+   void *p;
+
+   (void) heap;
+   return posix_memalign(&p, align, size) == 0 ? p : NULL;
+}
+
+static void
+vmklnx_kfree(vmk_HeapID heap, const void *p)
+{
+   (void) heap;
+   free((void *) p);
+}
+
+static dma_addr_t
+pci_map_single(struct pci_dev *pdev, void *ptr, size_t size, int dir)
+{
+   (void) pdev;
+   (void) size;
+   VMK_ASSERT(dir == PCI_DMA_FROMDEVICE);
+   return virt_to_phys(ptr);
+}
+
+static void
+pci_unmap_single(struct pci_dev *pdev, dma_addr_t dma, size_t size, int dir)
+{
+   (void) pdev;
+   (void) dma;
+   (void) size;
+   (void) dir;
+   unmaps++;
+}
+
+static int
+vmklnx_is_panic(void)
+{
+   return 0;
+}
+
+/* the pool buffer at frag f of an skb, or -1 if it isn't one */
+static int
+frag_buf(struct sk_buff *skb, int f, int *gen)
+{
+   skb_frag_t *frag = &skb_shinfo(skb)->frags[f];
+   u64 pa = page_to_phys(frag->page) + frag->page_offset;
+   int g;
+
+   for (g = 0; g < 2; g++) {
+      struct vmklnx_page_pool *pool = bufPool[g];
+
+      if (pool != NULL && pa - pool->basePhys < pool->size) {
+         *gen = g;
+         return (pa - pool->basePhys) / pool->bufSize;
+      }
+   }
+   return -1;
+}
+
+/*
+ * vmk_PktRelease() from the last skb over the handle: from here on its
+ * pool buffers may be handed out again.
+ */
+static void
+vmk_PktRelease(vmk_PktHandle *handle)
+{
+   struct test_pkt *pkt = TP(handle);
+   struct sk_buff *skb = pkt->skb;
+   int f, b, g;
+
+   if (pkt->released++) {
+      fail("packet handle released twice");
+   }
+   if (pkt->skbs != 1 || !TS(skb)->dying) {
+      fail("packet handle released under a live skb");
+   }
+   for (f = 0; f < skb_shinfo(skb)->nr_frags; f++) {
+      if ((b = frag_buf(skb, f, &g)) >= 0) {
+         bufOwner[g][b] = NULL;
+      }
+   }
+}
+
+static void
+vmk_PktReleaseIRQ(vmk_PktHandle *handle)
+{
+   vmk_PktRelease(handle);
+}
+
+static void
+vmk_PktReleaseAfterComplete(vmk_PktHandle *handle)
+{
+   TS(TP(handle)->skb)->dying = 1;
+   vmk_PktRelease(handle);
+}
+
+static void
+vmk_PktGetCompletionData(vmk_PktHandle *handle, vmk_PktCompletionData *ioData,
+                         vmk_PktCompletionData *auxData)
+{
+   *ioData = TP(handle)->skb;
+   *auxData = TP(handle)->genCount;
+}
+
+static void
+vmk_PktClearCompletionData(vmk_PktHandle *handle)
+{
+   TP(handle)->genCount = NULL;
+}
+
+static void
+do_free_skb(struct sk_buff *skb)
+{
+   struct test_skb *ts = TS(skb);
+
+   if (ts->freed++) {
+      fail("skb freed twice");
+      return;
+   }
+   TP(skb->pkt)->skbs--;
+}
+
+static struct net_device dev = { .genCount = (vmk_PktCompletionData) 1 };
+static struct vmklnx_page_pool *pool;
+static unsigned int seed = 1;
+
+/* map_pkt_to_skb(): a fresh skb over a packet handle */
+static struct sk_buff *
+map_pkt_to_skb(struct test_pkt *pkt)
+{
+   struct test_skb *ts = calloc(1, sizeof(*ts));
+   struct sk_buff *skb = &ts->skb;
+
+   skb->head = skb->data = skb->tail = ts->head;
+   skb->end = ts->head + sizeof(ts->head);
+   skb->pkt = &pkt->handle;
+   atomic_set(&skb->users, 1);
+   atomic_set(&skb_shinfo(skb)->dataref, 1);
+   atomic_set(&skb_shinfo(skb)->fragsref, 1);
+   pkt->skb = skb;
+   pkt->skbs++;
+   return skb;
+}
+
+/* the driver: packet split buffers from the pool, else from alloc_page */
+static void
+fill_frags(struct sk_buff *skb)
+{
+   struct test_pkt *pkt = TP(skb->pkt);
+   int i, n = rand_r(&seed) % (BUFS_MAX + 1), b, g;
+   unsigned int offset;
+   dma_addr_t dma;
+   struct page *page;
+
+   for (i = 0; i < n; i++) {
+      page = vmklnx_page_pool_alloc(pool, &offset, &dma);
+      if (page == NULL) {
+         /* not from the pool: a page the test does not track */
+         page = virt_to_page(PAGE_SIZE);
+         offset = 0;
+         allocPageBufs++;
+      } else if (dma != page_to_phys(page) + offset) {
+         fail("pool buffer at the wrong bus address");
+      }
+      skb_fill_page_desc(skb, i, page, offset, 1 + rand_r(&seed) % 2048);
+      if ((b = frag_buf(skb, i, &g)) >= 0) {
+         if (bufOwner[g][b] != NULL) {
+            fail("pool buffer %d handed out while an skb holds it", b);
+         }
+         bufOwner[g][b] = pkt;
+      }
+   }
+}
+
+static struct sk_buff *
+rx_skb(struct test_pkt *pkts, unsigned int *nPkts, struct sk_buff ***all,
+       unsigned int *nAll)
+{
+   struct sk_buff *skb, **tail;
+   int j, nFragSkbs = rand_r(&seed) % 4 == 0 ?
+                      1 + rand_r(&seed) % FRAG_SKBS_MAX : 0;
+
+   skb = (*all)[(*nAll)++] = map_pkt_to_skb(&pkts[(*nPkts)++]);
+   fill_frags(skb);
+   tail = &skb_shinfo(skb)->frag_list;
+   for (j = 0; j < nFragSkbs; j++) {
+      *tail = (*all)[(*nAll)++] = map_pkt_to_skb(&pkts[(*nPkts)++]);
+      fill_frags(*tail);
+      tail = &(*tail)->next;
+   }
+   return skb;
+}
+
+/* up the stack: a few ops on it, then dropped or completed */
+static void
+rx_done(struct sk_buff *skb)
+{
+   struct sk_buff *frag;
+   vmk_PktList list;
+   int ops, drop = rand_r(&seed) % 2;
+
+   for (ops = rand_r(&seed) % OPS_MAX; ops > 0; ops--) {
+      if (rand_r(&seed) % 2) {
+         kfree_skb(skb_get(skb));
+      } else if (drop && skb_shinfo(skb)->frag_list == NULL) {
+         /*
+          * Only before a drop, as netif_rx_common() passes the frame up
+          * in the buffer of the packet handle, not a reallocated head;
+          * and only without a frag_list: skb_shared_info is not copied
+          * with the head in vmklinux, so skb_release_data drops the
+          * list the new head should have kept.
+          */
+         if (pskb_expand_head(skb, 16, 0, GFP_ATOMIC) != 0) {
+            fail("pskb_expand_head failed");
+         }
+      }
+   }
+
+   if (drop) {
+      TS(skb)->dying = 1;
+      for (frag = skb_shinfo(skb)->frag_list; frag; frag = frag->next) {
+         TS(frag)->dying = 1;
+      }
+      kfree_skb(skb);
+   } else {
+      /* passed up with netif_rx and completed */
+      for (frag = skb_shinfo(skb)->frag_list; frag; frag = frag->next) {
+         TS(frag)->dying = 1;
+      }
+      TP(skb->pkt)->genCount = dev.genCount;
+      atomic_inc(&dev.rxInFlight);
+      vmk_PktListInit(&list);
+      vmk_PktListAddToTail(&list, skb->pkt);
+      vmklnx_net_skb_complete(NULL, &dev, &list);
+   }
+}
+
+int
+main(void)
+{
+   static struct sk_buff *allSkbs[SKBS * (1 + FRAG_SKBS_MAX)];
+   struct sk_buff **all = allSkbs, *inFlight[IN_FLIGHT];
+   struct test_pkt *pkts = calloc(SKBS * (1 + FRAG_SKBS_MAX), sizeof(*pkts));
+   unsigned int i, nPkts = 0, nAll = 0, k;
+   struct vmklnx_page_pool *old;
+   u64 empty = 0;
+
+   /* the ring's pool, as igb creates it for packet split */
+   pool = vmklnx_page_pool_create(NULL, POOL_BUFS, PAGE_SIZE / 2);
+   if (pool == NULL || pool->nBufs != POOL_BUFS) {
+      fail("no pool of %d buffers", POOL_BUFS);
+      return 1;
+   }
+   bufPool[0] = pool;
+
+   for (i = 0; i < IN_FLIGHT; i++) {
+      inFlight[i] = rx_skb(pkts, &nPkts, &all, &nAll);
+   }
+   for (i = 0; i < SKBS - IN_FLIGHT; i++) {
+      k = rand_r(&seed) % IN_FLIGHT;
+      rx_done(inFlight[k]);
+
+      if (i == SKBS / 2) {
+         /* the ring is reconfigured with skbs still up the stack */
+         empty += pool->empty;
+         old = pool;
+         freedPool = old;
+         vmklnx_page_pool_destroy(old);
+         if (poolsFreed) {
+            fail("pool freed with its buffers out");
+         }
+         pool = vmklnx_page_pool_create(NULL, POOL_BUFS, PAGE_SIZE / 2);
+         bufPool[1] = bufPool[0];
+         memcpy(bufOwner[1], bufOwner[0], sizeof(bufOwner[0]));
+         memset(bufOwner[0], 0, sizeof(bufOwner[0]));
+         bufPool[0] = pool;
+      }
+      inFlight[k] = rx_skb(pkts, &nPkts, &all, &nAll);
+   }
+   if (bufPool[1] != NULL && poolsFreed != 1) {
+      fail("destroyed pool not freed once its buffers are back");
+   }
+   for (i = 0; i < IN_FLIGHT; i++) {
+      rx_done(inFlight[i]);
+   }
+
+   /* every buffer is back, and the pool never ran dry */
+   empty += pool->empty;
+   if (pool->nFree != pool->nBufs) {
+      fail("%u of %u pool buffers back", pool->nFree, pool->nBufs);
+   }
+   if (empty != 0 || allocPageBufs != 0) {
+      fail("pool ran dry %llu times with at most %d of %d buffers out",
+           (unsigned long long) empty, IN_FLIGHT * (1 + FRAG_SKBS_MAX) *
+           BUFS_MAX, POOL_BUFS);
+   }
+   freedPool = pool;
+   vmklnx_page_pool_destroy(pool);
+   if (poolsFreed != 2 || unmaps != 2 || atomic_read(&pagePoolCount) != 0) {
+      fail("%ld of 2 pools freed and %ld unmapped, %d left", poolsFreed,
+           unmaps, atomic_read(&pagePoolCount));
+   }
+
+   for (i = 0; i < nPkts; i++) {
+      if (pkts[i].released != 1) {
+         fail("packet handle leaked");
+         break;
+      }
+   }
+   for (i = 0; i < nAll; i++) {
+      if (!TS(all[i])->freed) {
+         fail("skb leaked");
+         break;
+      }
+   }
+   if (heads != headsFreed) {
+      fail("%ld heads allocated, %ld freed", heads, headsFreed);
+   }
+   for (i = 0; i < nAll; i++) {
+      free(TS(all[i]));
+   }
+   free(pkts);
+
+   printf("skb_frags_ref: %u skbs, %ld head reallocations, %u + %u pool "
+          "buffers\n", nAll, heads, POOL_BUFS, POOL_BUFS);
+   if (failures) {
+      fprintf(stderr, "skb_frags_ref_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("skb_frags_ref_test: ok\n");
+   return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * skb_pool_test.c --
+ *
+ *    Test of the skb pools of vmware/linux_net.c (skb_pool_create,
+ *    skb_pool_ctor, do_alloc_skb, do_free_skb, do_free_skb_bulk and
+ *    do_recycle_skb_bits) over a model of vmk_Slab: per-PCPU free lists
+ *    that keep the contents of free objects, and a constructor that runs
+ *    only when an object is first carved out of the heap.
+ *
+ *    skbs are scribbled over with random bytes, as use by drivers and
+ *    vmklinux would leave them, freed on one PCPU and allocated again on
+ *    another.
+ *
+ *    The test fails if
+ *    - an skb comes out of the pool in a state other than the one
+ *      do_init_skb_bits() would have put the scribbled skb in, i.e.
+ *      do_recycle_skb_bits() misses or gets wrong a field do_init_skb_bits()
+ *      sets;
+ *    - a new skb does not come out constructed;
+ *    - the pool constructs objects beyond the peak number in use, i.e.
+ *      freed skbs are not reused.
+ *
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/vmklinux26/vmknetddinetq.h: VMKNETDDI_QUEUEOPS_INVALID_QUEUEID
+ * extract ../../include/linux/skbuff.h: CHECKSUM_NONE MAX_SKB_FRAGS skb_frag_t struct skb_frag_struct struct skb_shared_info struct sk_buff skb_shinfo
+ * extract ../../include/linux/if_vlan.h: struct vlan_skb_tx_cookie VLAN_TX_SKB_CB
+ * extract ../vmware/linux_net.c: vmklnx_skb_cache do_init_skb_bits do_recycle_skb_bits skb_pool_ctor skb_pool_create do_alloc_skb do_free_skb do_free_skb_bulk
+ */
+
+#include "stubs.h"
+
+#define PCPUS           4
+#define SKBS            64
+#define ROUNDS          20000
+
+/*
+ * The model of vmk_Slab behind vmklnx_kmem_cache_create(): a bounded free
+ * list per PCPU that spills to and refills from a shared one, in LIFO order.
+ */
+#define SLAB_OBJS       (SKBS * PCPUS * 2)
+
+struct kmem_cache_s {
+   size_t size;
+   void (*ctor)(void *, struct kmem_cache_s *, unsigned long);
+   unsigned int nFree[PCPUS];
+   void *free[PCPUS][SKBS];
+   unsigned int nShared;
+   void *shared[SLAB_OBJS];
+   unsigned int constructed;
+};
+
+static struct kmem_cache_s *
+vmklnx_kmem_cache_create(vmk_HeapID heapID, const char *name, size_t size,
+                         size_t offset,
+                         void (*ctor)(void *, struct kmem_cache_s *, unsigned long),
+                         void (*dtor)(void *, struct kmem_cache_s *, unsigned long),
+                         int trimFlag, int slabPercent)
+{
+   struct kmem_cache_s *cache = calloc(1, sizeof(*cache));
+
+   (void) heapID;
+   (void) name;
+   (void) offset;
+   (void) trimFlag;
+   (void) slabPercent;
+   VMK_ASSERT(dtor == NULL);
+   cache->size = size;
+   cache->ctor = ctor;
+   return cache;
+}
+
+static void *
+vmklnx_kmem_cache_alloc(struct kmem_cache_s *cache)
+{
+   int pcpu = smp_processor_id();
+   void *obj;
+
+   if (cache->nFree[pcpu] == 0) {
+      unsigned int n = min(cache->nShared, (unsigned int) SKBS);
+
+      cache->nShared -= n;
+      memcpy(cache->free[pcpu], &cache->shared[cache->nShared],
+             n * sizeof(void *));
+      cache->nFree[pcpu] = n;
+   }
+   if (cache->nFree[pcpu] > 0) {
+      return cache->free[pcpu][--cache->nFree[pcpu]];
+   }
+   if (cache->constructed == SLAB_OBJS) {
+      return NULL;
+   }
+   /* a new object from the heap, garbage until constructed */
+   obj = malloc(cache->size);
+   memset(obj, 0x5a, cache->size);
+   if (cache->ctor != NULL) {
+      cache->ctor(obj, cache, 0);
+   }
+   cache->constructed++;
+   return obj;
+}
+
+static void
+vmklnx_kmem_cache_free(struct kmem_cache_s *cache, void *obj)
+{
+   int pcpu = smp_processor_id();
+
+   if (cache->nFree[pcpu] == SKBS) {
+      memcpy(&cache->shared[cache->nShared], cache->free[pcpu],
+             SKBS * sizeof(void *));
+      cache->nShared += SKBS;
+      cache->nFree[pcpu] = 0;
+   }
+   cache->free[pcpu][cache->nFree[pcpu]++] = obj;
+}
+
+#include "skb_pool_test.inc"
+
+#define SKB_SIZE        (sizeof(struct sk_buff) + sizeof(struct skb_shared_info))
+
+static unsigned int seed = 1;
+
+/* what use may leave in an skb: anything, but it stays in its pool */
+static void
+scribble(struct sk_buff *skb)
+{
+   kmem_cache_t *cache = skb->cache;
+   unsigned char *p = (unsigned char *) skb;
+   size_t i;
+
+   for (i = 0; i < SKB_SIZE; i++) {
+      /* mostly zero, as most fields are in most skbs */
+      p[i] = (rand_r(&seed) % 4) == 0 ? rand_r(&seed) : 0;
+   }
+   skb->cache = cache;
+}
+
+int
+main(void)
+{
+   struct sk_buff *skbs[SKBS];
+   unsigned char *expected[SKBS];
+   unsigned char fresh[2][SKB_SIZE];
+   kmem_cache_t *pool;
+   unsigned int round, i, n;
+
+   /* as vmklinux module init and vmklnx_alloc_etherdev_mq() do */
+   vmklnx_skb_cache = skb_pool_create(0, "vmklnx_skb_cache");
+   pool = skb_pool_create(0, "skb_cache");
+
+   memset(fresh, 0x5a, sizeof(fresh));
+   do_init_skb_bits((struct sk_buff *) fresh[0], vmklnx_skb_cache);
+   do_init_skb_bits((struct sk_buff *) fresh[1], pool);
+   for (i = 0; i < SKBS; i++) {
+      expected[i] = malloc(SKB_SIZE);
+   }
+
+   for (round = 0; round < ROUNDS; round++) {
+      n = 1 + rand_r(&seed) % SKBS;
+      stub_pcpu = rand_r(&seed) % PCPUS;
+      for (i = 0; i < n; i++) {
+         skbs[i] = do_alloc_skb(round & 1 ? pool : NULL);
+         if (skbs[i] == NULL) {
+            fail("round %u: allocation failed", round);
+            return 1;
+         }
+         if (round < 2 && memcmp(skbs[i], fresh[round], SKB_SIZE) != 0) {
+            fail("a new skb is not initialized");
+         }
+      }
+
+      /* use them, and work out what they have to come back as */
+      for (i = 0; i < n; i++) {
+         scribble(skbs[i]);
+         memcpy(expected[i], skbs[i], SKB_SIZE);
+         do_init_skb_bits((struct sk_buff *) expected[i], skbs[i]->cache);
+      }
+
+      stub_pcpu = rand_r(&seed) % PCPUS;
+      if (n > 1 && (round & 2)) {
+         do_free_skb_bulk(skbs, n);
+      } else {
+         for (i = 0; i < n; i++) {
+            do_free_skb(skbs[i]);
+         }
+      }
+
+      /* the free list hands the last freed skb out first */
+      for (i = n; i-- > 0; ) {
+         struct sk_buff *skb = do_alloc_skb(skbs[i]->cache);
+
+         if (skb != skbs[i]) {
+            fail("round %u: freed skb not reused", round);
+            return 1;
+         }
+         if (memcmp(skb, expected[i], SKB_SIZE) != 0) {
+            fail("round %u: recycled skb differs from an initialized one",
+                 round);
+            return 1;
+         }
+      }
+      for (i = 0; i < n; i++) {
+         do_free_skb(skbs[i]);
+      }
+   }
+
+   if (pool->constructed > SKBS * PCPUS ||
+       vmklnx_skb_cache->constructed > SKBS * PCPUS) {
+      fail("%u and %u skbs constructed for at most %u in use",
+           pool->constructed, vmklnx_skb_cache->constructed, SKBS);
+   }
+
+   printf("skb_pool: %u rounds, %u + %u skbs constructed\n", ROUNDS,
+          pool->constructed, vmklnx_skb_cache->constructed);
+   if (failures) {
+      fprintf(stderr, "skb_pool: %d failures\n", failures);
+      return 1;
+   }
+   printf("skb_pool: ok\n");
+   return 0;
+}
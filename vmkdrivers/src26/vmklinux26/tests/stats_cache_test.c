@@ -0,0 +1,451 @@
+/*
+ * stats_cache_test.c --
+ *
+ *    Multi-threaded test of the driver statistics snapshot of
+ *    vmware/linux_net.c as it ships: netdev_stats_cache_refresh, and
+ *    GetDeviceStats and netdev_get_estats reading it.
+ *
+ *    Uplink threads query the snapshot continuously, the way
+ *    GetDeviceStats and the SIOCGVMKLNXESTATS/ESTRINGS ioctls do, while
+ *    the driver changes how many counters it exports and what they are
+ *    called. Every counter value encodes the configuration it came from,
+ *    and buffers are poisoned before they are freed.
+ *
+ *    The test fails if
+ *    - the driver is called by two refreshers at once;
+ *    - a reader sees names and values from different configurations, a
+ *      count that does not match the table, or a freed buffer;
+ *    - within the caching window the driver is asked more than once.
+ *
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_types.h: vmk_String vmk_IoctlCallerSize
+ * extract ../../../../bora/vmkernel/include/vmkapi/net/vmkapi_net_uplink.h: vmk_UplinkStats
+ * extract ../../include/linux/socket.h: sa_family_t struct sockaddr
+ * extract ../../include/linux/if.h: IFNAMSIZ
+ * extract ../../include/linux/hdlc/ioctl.h: sync_serial_settings te1_settings raw_hdlc_proto fr_proto fr_proto_pvc fr_proto_pvc_info cisco_proto
+ * extract ../../include/linux/if.h: struct if_settings struct ifreq ifr_data
+ * extract ../../include/linux/compat.h: struct ifmap32 struct ifreq32
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/linux/skbuff.h: MAX_SKB_FRAGS skb_frag_t struct skb_frag_struct struct skb_shared_info struct sk_buff
+ * extract ../../include/linux/inet_lro.h: LRO_AGGR_HIST_BUCKETS struct net_lro_stats struct net_lro_desc struct net_lro_mgr
+ * extract ../../include/linux/sockios.h: SIOCPROTOPRIVATE
+ * extract ../../include/linux/ethtool.h: struct ethtool_stats ETH_GSTRING_LEN enum ethtool_stringset struct ethtool_ops
+ * extract ../../include/linux/netdevice.h: struct net_device_stats enum netdev_state_t enum netdev_drop_reason struct netdev_queue_stats NETDEV_STATS_RX_QUEUES NAPI_PUSH_HIST_BUCKETS struct napi_struct SIOCGVMKLNXESTRINGS SIOCGVMKLNXESTATS struct netdev_estat struct netdev_estats_req NETIF_F_SW_LRO
+ * extract ../vmware/linux_net.c: vmklnx_stats_cache_ms netdev_stats_fold netdev_stats_dropped struct netdev_stats_cache NETDEV_STATS_LINE_MAX netdev_stats_cache_create netdev_stats_cache_destroy netdev_stats_count netdev_stats_strings netdev_stats_cache_strings netdev_stats_cache_refresh netdev_ifr_data netdev_get_estats append_private_stat GetDeviceStats
+ */
+
+#include <time.h>
+
+#include "stubs.h"
+
+#define READERS         4
+#define QUERIES         20000
+#define POISON          0x6b
+#define CACHE_MS        2
+
+typedef uint32_t compat_caddr_t;
+typedef int32_t compat_int_t;
+typedef uint32_t compat_ulong_t;
+typedef unsigned int gfp_t;
+
+#define GFP_KERNEL      0
+#define GFP_ATOMIC      1
+
+/* vmklinux is built for 2.6.18+ drivers */
+#define __COMPAT_LAYER_2_6_18_PLUS__
+
+struct ethtool_cmd;
+struct ethtool_drvinfo;
+struct ethtool_regs;
+struct ethtool_wolinfo;
+struct ethtool_eeprom;
+struct ethtool_coalesce;
+struct ethtool_ringparam;
+struct ethtool_pauseparam;
+struct ethtool_test;
+struct ethtool_perm_addr;
+struct net_device;
+
+struct net_device {
+   char name[16];
+   vmk_ModuleID module_id;
+   unsigned long features;
+   int num_tx_queues;
+   int real_num_tx_queues;
+   unsigned long linnet_pkt_completed;
+   struct netdev_queue_stats **linnet_stats;
+   struct net_device_stats *(*get_stats)(struct net_device *dev);
+   struct ethtool_ops *ethtool_ops;
+   struct netdev_stats_cache *stats_cache;
+   spinlock_t napi_lock;
+   struct list_head napi_list;
+};
+
+unsigned int vmklnxLROEnabled;
+
+/* what the extracted code calls, defined below */
+static vmk_uint32 vmk_NumPCPUs(void);
+static unsigned long now_ms(void);
+static void *kmalloc(size_t size, gfp_t flags);
+static void *kzalloc(size_t size, gfp_t flags);
+static void kfree(const void *p);
+static unsigned long copy_from_user(void *to, const void __user *from,
+                                    unsigned long n);
+static unsigned long copy_to_user(void __user *to, const void *from,
+                                  unsigned long n);
+static void *compat_ptr(compat_caddr_t uptr);
+static int netdev_bounce_ring_stats(struct net_device *dev, u64 *bounced,
+                                    u64 *exhausted, u64 *oversized);
+
+/* HZ is 1000 */
+#define jiffies                 now_ms()
+#define msecs_to_jiffies(ms)    ((unsigned long) (ms))
+#define time_before(a, b)       ((long) ((a) - (b)) < 0)
+
+#include "stats_cache_test.inc"
+
+static unsigned long
+now_ms(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+static vmk_uint32
+vmk_NumPCPUs(void)
+{
+   return 1;
+}
+
+/* allocations carry their size, so they can be poisoned when freed */
+static void *
+kmalloc(size_t size, gfp_t flags)
+{
+   size_t *p = malloc(sizeof(size_t) * 2 + size);
+
+   if (flags == GFP_KERNEL) {
+      sched_yield();    /* may block */
+   }
+   p[0] = size;
+   return p + 2;
+}
+
+static void *
+kzalloc(size_t size, gfp_t flags)
+{
+   return memset(kmalloc(size, flags), 0, size);
+}
+
+static void
+kfree(const void *p)
+{
+   size_t *h;
+
+   if (p != NULL) {
+      h = (size_t *) p - 2;
+      memset(h, POISON, sizeof(size_t) * 2 + h[0]);
+      free(h);
+   }
+}
+
+static unsigned long
+copy_from_user(void *to, const void __user *from, unsigned long n)
+{
+   memcpy(to, from, n);
+   return 0;
+}
+
+static unsigned long
+copy_to_user(void __user *to, const void *from, unsigned long n)
+{
+   memcpy(to, from, n);
+   return 0;
+}
+
+static void *
+compat_ptr(compat_caddr_t uptr)
+{
+   return (void *) (unsigned long) uptr;
+}
+
+static int
+netdev_bounce_ring_stats(struct net_device *dev, u64 *bounced,
+                         u64 *exhausted, u64 *oversized)
+{
+   (void) dev;
+   (void) bounced;
+   (void) exhausted;
+   (void) oversized;
+   return 0;
+}
+
+/*
+ * The driver: configuration cfg exports 4 + cfg % 13 counters. The names
+ * and values of a counter set both carry its size. A refresh asks for the
+ * count first, and the driver stays in that configuration for the rest.
+ */
+static volatile unsigned int driverCfg;
+static unsigned int refreshCfg;
+static int inDriver;
+static unsigned long driverCalls;
+
+static u32
+drv_count(unsigned int cfg)
+{
+   return 4 + cfg % 13;
+}
+
+static void
+drv_enter(void)
+{
+   if (__atomic_fetch_add(&inDriver, 1, __ATOMIC_SEQ_CST) != 0) {
+      fail("driver entered concurrently");
+   }
+   sched_yield();
+}
+
+static void
+drv_exit(void)
+{
+   __atomic_fetch_sub(&inDriver, 1, __ATOMIC_SEQ_CST);
+}
+
+static struct net_device_stats *
+drv_get_stats(struct net_device *dev)
+{
+   static struct net_device_stats st;
+
+   (void) dev;
+   drv_enter();
+   driverCalls++;
+   refreshCfg = driverCfg;
+   st.rx_packets++;
+   drv_exit();
+   return &st;
+}
+
+static int
+drv_get_sset_count(struct net_device *dev, int sset)
+{
+   (void) dev;
+   if (sset != ETH_SS_STATS) {
+      fail("sset %d", sset);
+   }
+   return drv_count(refreshCfg);
+}
+
+static void
+drv_get_strings(struct net_device *dev, u32 sset, u8 *data)
+{
+   u32 i, n = drv_count(refreshCfg);
+
+   (void) dev;
+   (void) sset;
+   drv_enter();
+   for (i = 0; i < n; i++) {
+      snprintf((char *) data + i * ETH_GSTRING_LEN, ETH_GSTRING_LEN,
+               "n%u_stat%u", n, i);
+   }
+   drv_exit();
+}
+
+static void
+drv_get_ethtool_stats(struct net_device *dev, struct ethtool_stats *stats,
+                      u64 *data)
+{
+   u32 i;
+
+   (void) dev;
+   drv_enter();
+   for (i = 0; i < stats->n_stats; i++) {
+      data[i] = (u64) stats->n_stats << 32 | i;
+   }
+   drv_exit();
+}
+
+static struct ethtool_ops drvEthtoolOps = {
+   .get_strings = drv_get_strings,
+   .get_sset_count = drv_get_sset_count,
+   .get_ethtool_stats = drv_get_ethtool_stats,
+};
+
+static struct net_device dev;
+
+/* GetDeviceStats(): the formatted text, up to the vmklinux counters */
+static void
+query_text(void)
+{
+   char buf[64 * NETDEV_STATS_LINE_MAX], name[ETH_GSTRING_LEN];
+   vmk_UplinkStats stats;
+   unsigned int cnt, idx;
+   unsigned long long v;
+   int off = 1, n;
+   u32 i = 0;
+
+   memset(&stats, 0, sizeof(stats));
+   memset(buf, 0, sizeof(buf));
+   stats.privateStats.buffer = (vmk_uint8 *) buf;
+   stats.privateStats.bufferSize = sizeof(buf);
+   if (GetDeviceStats(&dev, &stats) != VMK_OK) {
+      fail("GetDeviceStats failed");
+      return;
+   }
+
+   while (strncmp(buf + off, "   vmklnx_", 10) != 0) {
+      if (sscanf(buf + off, "   %31s : %llu%n", name, &v, &n) != 2 ||
+          buf[off + n] != '\n' ||
+          sscanf(name, "n%u_stat%u", &cnt, &idx) != 2) {
+         fail("garbled text at entry %u", i);
+         return;
+      }
+      if ((v >> 32) != cnt || (v & 0xffffffff) != idx || idx != i) {
+         fail("text mixes configurations at entry %u", i);
+         return;
+      }
+      off += n + 1;
+      i++;
+   }
+   if (i != cnt) {
+      fail("text has %u of %u entries", i, cnt);
+   }
+}
+
+/* netdev_get_estats(): the names, then the values */
+static void
+query_binary(void)
+{
+   struct {
+      struct netdev_estats_req req;
+      union {
+         char strings[32 * ETH_GSTRING_LEN];
+         struct netdev_estat entries[32];
+      } u;
+   } names, values;
+   struct ifreq ifr;
+   unsigned int cnt, idx;
+   uint32_t result;
+   u32 i;
+
+   names.req.nStats = 32;
+   ifr.ifr_data = &names;
+   if (netdev_get_estats(&dev, SIOCGVMKLNXESTRINGS, &ifr, &result,
+                         VMK_IOCTL_CALLER_64) != VMK_OK) {
+      fail("SIOCGVMKLNXESTRINGS failed");
+      return;
+   }
+   values.req.nStats = 32;
+   ifr.ifr_data = &values;
+   if (netdev_get_estats(&dev, SIOCGVMKLNXESTATS, &ifr, &result,
+                         VMK_IOCTL_CALLER_64) != VMK_OK) {
+      fail("SIOCGVMKLNXESTATS failed");
+      return;
+   }
+   if (names.req.generation != values.req.generation) {
+      return;   /* the agent would refetch the names */
+   }
+   if (names.req.nStats != values.req.nStats) {
+      fail("%u names and %u values of one generation", names.req.nStats,
+           values.req.nStats);
+      return;
+   }
+
+   for (i = 0; i < names.req.nStats; i++) {
+      if (sscanf(names.u.strings + i * ETH_GSTRING_LEN, "n%u_stat%u", &cnt,
+                 &idx) != 2 || idx != i || cnt != names.req.nStats) {
+         fail("bad name table at entry %u", i);
+         return;
+      }
+      if (values.u.entries[i].index != i ||
+          (values.u.entries[i].value & 0xffffffff) != i ||
+          (values.u.entries[i].value >> 32) != cnt) {
+         fail("values do not match the name table at entry %u", i);
+         return;
+      }
+   }
+}
+
+static int readersDone;
+
+static void *
+reader(void *arg)
+{
+   int i;
+
+   for (i = 0; i < QUERIES; i++) {
+      if (((unsigned long) arg + i) & 1) {
+         query_text();
+      } else {
+         query_binary();
+      }
+   }
+   __atomic_fetch_add(&readersDone, 1, __ATOMIC_SEQ_CST);
+   return NULL;
+}
+
+static void
+run(int cacheMs)
+{
+   pthread_t t[READERS];
+   unsigned long i;
+
+   vmklnx_stats_cache_ms = cacheMs;
+   readersDone = 0;
+   for (i = 0; i < READERS; i++) {
+      pthread_create(&t[i], NULL, reader, (void *) i);
+   }
+   /* the driver reconfigures itself while the queries run */
+   while (__atomic_load_n(&readersDone, __ATOMIC_SEQ_CST) < READERS) {
+      driverCfg++;
+      sched_yield();
+   }
+   for (i = 0; i < READERS; i++) {
+      pthread_join(t[i], NULL);
+   }
+}
+
+int
+main(void)
+{
+   unsigned long start, elapsed, allowed;
+
+   /* as vmklnx_alloc_etherdev_mq() and register_netdev() set it up */
+   strcpy(dev.name, "vmnic0");
+   dev.num_tx_queues = dev.real_num_tx_queues = 1;
+   dev.linnet_stats = calloc(1, sizeof(*dev.linnet_stats));
+   dev.linnet_stats[0] = calloc(NETDEV_STATS_RX_QUEUES + 1,
+                                sizeof(struct netdev_queue_stats));
+   dev.get_stats = drv_get_stats;
+   dev.ethtool_ops = &drvEthtoolOps;
+   if (netdev_stats_cache_create(&dev) != VMK_OK ||
+       netdev_stats_cache_strings(&dev, dev.stats_cache) != VMK_OK) {
+      fail("no statistics snapshot");
+      return 1;
+   }
+
+   /* no caching: every query refreshes unless one is under way */
+   run(0);
+
+   /* cached: the driver is asked at most once per window */
+   driverCalls = 0;
+   dev.stats_cache->valid = 0;
+   start = now_ms();
+   run(CACHE_MS);
+   elapsed = now_ms() - start;
+   allowed = elapsed / CACHE_MS + 2;
+   if (driverCalls > allowed) {
+      fail("driver asked %lu times in %lu ms, want <= %lu", driverCalls,
+           elapsed, allowed);
+   }
+
+   netdev_stats_cache_destroy(&dev);
+
+   printf("stats_cache: driver asked %lu times in %lu ms\n", driverCalls,
+          elapsed);
+   if (failures) {
+      fprintf(stderr, "stats_cache_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("stats_cache_test: ok\n");
+   return 0;
+}
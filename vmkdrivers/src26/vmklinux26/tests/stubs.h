@@ -0,0 +1,420 @@
+/*
+ * stubs.h --
+ *
+ *    The least of the vmkernel, vmkapi and Linux environment that code
+ *    extracted from vmklinux and the drivers needs to build and run in
+ *    userspace. Everything here runs on the calling thread: a thread is a
+ *    PCPU (stub_pcpu), disabling interrupts or preemption only sets a
+ *    per-thread flag, and spinlocks spin on an atomic and count how often
+ *    they were taken.
+ *
+ *    The vmkapi timer, worldlet, service and bottom half types, packet
+ *    lists, scatter-gather arrays and netqueue ids, Linux list heads,
+ *    vmknetddi queue ids and the interrupt moderation state drivers embed
+ *    in their own structs are the real ones:
+ *
+ * extract ../../include/linux/list.h: struct list_head INIT_LIST_HEAD list_entry list_for_each_entry
+ * extract ../../include/vmklinux26/vmknetddinetq.h: vmknetddi_queueops_queueid_t
+ * extract ../../include/linux/netdevice.h: enum vmklnx_itr_class enum vmklnx_itr_dir struct vmklnx_itr_profile vmklnx_itr_set_fn struct vmklnx_itr vmklnx_itr_add struct napi_wdt_priv
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_types.h: vmk_AddrCookie
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_compiler.h: VMK_ATTRIBUTE_ALIGN VMK_ATTRIBUTE_PACKED
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_platform.h: VMK_L1_CACHELINE_SIZE VMK_ATTRIBUTE_L1_ALIGNED
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_bottom_half.h: vmk_BottomHalf
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_scatter_gather.h: vmk_SgElem vmk_SgArray
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_accounting.h: vmk_ServiceAcctId
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_worldlet.h: vmk_Worldlet vmk_WorldletState VMK_WDT_NAME_SIZE_MAX vmk_WorldletFn
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_time.h: VMK_INVALID_TIMER vmk_TimerRelCycles vmk_TimerCookie vmk_TimerCallback vmk_Timer
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_slist.h: vmk_SList_Links vmk_SList vmk_SListInitElement vmk_SListInit vmk_SListIsEmpty vmk_SListFirst vmk_SListNext vmk_SListPop vmk_SListInsertAtHead vmk_SListInsertAtTail vmk_SListAppend vmk_SListAppendN vmk_SListPrepend
+ * extract ../../../../bora/vmkernel/include/vmkapi/base/vmkapi_cslist.h: vmk_CSList vmk_CSListIsEmpty vmk_CSListFirst vmk_CSListNext vmk_CSListInit vmk_CSListCount vmk_CSListPop vmk_CSListInsertAtHead vmk_CSListInsertAtTail vmk_CSListAppend vmk_CSListAppendN vmk_CSListPrepend
+ * extract ../../../../bora/vmkernel/include/vmkapi/net/vmkapi_net_netqueue.h: vmk_NetqueueQueueId
+ * extract ../../../../bora/vmkernel/include/vmkapi/net/vmkapi_net_pkt.h: vmk_PktDescFlags vmk_PktCompletionData vmk_PktDescriptor vmk_PktHandleFlags vmk_PktHandle vmk_PktFrag
+ * extract ../../../../bora/vmkernel/include/vmkapi/net/vmkapi_net_pktlist.h: vmk_PktList vmk_PktListInit vmk_PktListCount vmk_PktListIsEmpty vmk_PktListAddToHead vmk_PktListAddToTail vmk_PktListGetHead vmk_PktListGetNext vmk_PktListPopHead vmk_PktListJoin vmk_PktListAppendN vmk_PktListPrepend
+ */
+
+#ifndef _TESTS_STUBS_H_
+#define _TESTS_STUBS_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+/*
+ * Types.
+ */
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef long long s64;
+typedef int8_t   __s8;
+typedef int16_t  __s16;
+typedef int32_t  __s32;
+typedef long long __s64;
+typedef uint8_t  __u8;
+typedef uint16_t __u16;
+typedef uint32_t __u32;
+typedef unsigned long long __u64;
+typedef uint16_t __be16;
+typedef uint32_t __be32;
+typedef uint16_t __sum16;
+typedef uint32_t __wsum;
+typedef u64      dma_addr_t;
+
+#define VMK_FALSE 0
+#define VMK_TRUE  1
+typedef char vmk_Bool;
+typedef signed char        vmk_int8;
+typedef unsigned char      vmk_uint8;
+typedef short              vmk_int16;
+typedef unsigned short     vmk_uint16;
+typedef int                vmk_int32;
+typedef unsigned int       vmk_uint32;
+typedef long               vmk_int64;
+typedef unsigned long      vmk_uint64;
+typedef vmk_uint64         vmk_VirtAddr;
+typedef vmk_uint64         vmk_MachAddr;
+typedef vmk_uint64         vmk_IOA;
+typedef vmk_uint32         vmk_small_size_t;
+typedef unsigned long      vmk_size_t;
+typedef vmk_uint64         vmk_TimerCycles;
+typedef int                vmk_ModuleID;
+typedef int                vmk_HeapID;
+
+/* a vmk_PktHandle refers to a buffer descriptor the tests never look at */
+typedef struct vmk_PktBufDescriptor vmk_PktBufDescriptor;
+
+typedef enum {
+   VMK_OK = 0,
+   VMK_FAILURE,
+   VMK_BUSY,
+   VMK_NO_MEMORY,
+   VMK_NO_RESOURCES,
+   VMK_WOULD_BLOCK,
+   VMK_LIMIT_EXCEEDED,
+   VMK_NOT_SUPPORTED,
+   VMK_BAD_PARAM,
+   VMK_INVALID_ADDRESS,
+   VMK_NOT_FOUND,
+} VMK_ReturnStatus;
+
+/*
+ * Byte order, of x86.
+ */
+
+#define __LITTLE_ENDIAN_BITFIELD
+#define htons(x)                ((__u16) __builtin_bswap16(x))
+#define ntohs(x)                htons(x)
+#define htonl(x)                ((__u32) __builtin_bswap32(x))
+#define ntohl(x)                htonl(x)
+#define __constant_htons(x)     htons(x)
+#define __constant_ntohs(x)     htons(x)
+#define __constant_htonl(x)     htonl(x)
+#define __constant_ntohl(x)     htonl(x)
+
+/*
+ * Compiler and debugging.
+ */
+
+#define likely(x)               __builtin_expect(!!(x), 1)
+#define unlikely(x)             __builtin_expect(!!(x), 0)
+#define VMK_LIKELY(x)           likely(x)
+#define VMK_UNLIKELY(x)         unlikely(x)
+#define __init
+#define __exit
+#define __user
+#define __iomem
+#define __force
+#define __devinit
+#define __devexit
+#define __read_mostly
+#define fastcall
+#define EXPORT_SYMBOL(sym)
+#define EXPORT_SYMBOL_GPL(sym)
+#define SMP_CACHE_BYTES         64
+#define ____cacheline_aligned   __attribute__((__aligned__(SMP_CACHE_BYTES)))
+#define ____cacheline_aligned_in_smp ____cacheline_aligned
+#define __cacheline_aligned     ____cacheline_aligned
+
+#define ARRAY_SIZE(a)           (sizeof(a) / sizeof((a)[0]))
+#define container_of(ptr, type, member) \
+   ((type *) ((char *) (ptr) - offsetof(type, member)))
+#define min(a, b)               ((a) < (b) ? (a) : (b))
+#define max(a, b)               ((a) > (b) ? (a) : (b))
+#define min_t(type, a, b)       min((type) (a), (type) (b))
+#define max_t(type, a, b)       max((type) (a), (type) (b))
+
+#define VMK_ASSERT(cond)                                                   \
+   do {                                                                    \
+      if (!(cond)) {                                                       \
+         fprintf(stderr, "%s:%d: assertion %s failed\n", __FILE__,         \
+                 __LINE__, #cond);                                         \
+         abort();                                                          \
+      }                                                                    \
+   } while (0)
+#define BUG_ON(cond)            VMK_ASSERT(!(cond))
+#define BUG()                   VMK_ASSERT(0)
+#define WARN_ON(cond)                                                      \
+   ({                                                                      \
+      int __warned = !!(cond);                                             \
+      __warned;                                                            \
+   })
+#define VMKLNX_DEBUG(level, fmt, args...)       do { } while (0)
+#define VMKLNX_WARN(fmt, args...)               do { } while (0)
+#define VMKLNX_INFO(fmt, args...)               do { } while (0)
+#define VMKLNX_THROTTLED_WARN(count, fmt, args...) ((void) ++(count))
+#define VMKLNX_THROTTLED_INFO(count, fmt, args...) ((void) ++(count))
+#define VMKLNX_STRESS_DEBUG_COUNTER(counter)    0
+#define VMKLNX_STRESS_DEBUG_OPTION(option)      0
+#define printk(fmt, args...)                    do { } while (0)
+
+/* calls into a module are direct calls */
+#define VMKAPI_MODULE_CALL(moduleID, ret, fn, args...)  ((ret) = (fn)(args))
+#define VMKAPI_MODULE_CALL_VOID(moduleID, fn, args...)  ((fn)(args))
+
+/*
+ * PCPUs, interrupts and preemption, per thread. The counters let a test
+ * tell how often code under test toggled them.
+ */
+
+#define __stub_unused           __attribute__((__unused__))
+
+static __thread int stub_pcpu __stub_unused;
+static __thread int stub_irq_off __stub_unused;
+static __thread unsigned long stub_irq_saves __stub_unused;
+static __thread int stub_preempt_count __stub_unused;
+
+#define smp_processor_id()      (stub_pcpu)
+#define raw_smp_processor_id()  (stub_pcpu)
+#define local_irq_save(flags)                                              \
+   ((flags) = stub_irq_off, stub_irq_off = 1, stub_irq_saves++)
+#define local_irq_restore(flags)        (stub_irq_off = (flags))
+#define local_irq_disable()             (stub_irq_off = 1, stub_irq_saves++)
+#define local_irq_enable()              (stub_irq_off = 0)
+#define irqs_disabled()                 (stub_irq_off)
+#define preempt_disable()               (stub_preempt_count++)
+#define preempt_enable()                (stub_preempt_count--)
+#define get_cpu()                       (preempt_disable(), smp_processor_id())
+#define put_cpu()                       preempt_enable()
+#define in_interrupt()                  0
+#define in_irq()                        0
+
+/*
+ * Atomics, barriers and bit operations.
+ */
+
+typedef struct { volatile int counter; } atomic_t;
+typedef struct { volatile long counter; } atomic64_t;
+
+#define ATOMIC_INIT(i)          { (i) }
+#define atomic_read(v)          __atomic_load_n(&(v)->counter, __ATOMIC_SEQ_CST)
+#define atomic_set(v, i)        __atomic_store_n(&(v)->counter, (i), __ATOMIC_SEQ_CST)
+#define atomic_add_return(i, v) __atomic_add_fetch(&(v)->counter, (i), __ATOMIC_SEQ_CST)
+#define atomic_sub_return(i, v) __atomic_sub_fetch(&(v)->counter, (i), __ATOMIC_SEQ_CST)
+#define atomic_add(i, v)        ((void) atomic_add_return(i, v))
+#define atomic_sub(i, v)        ((void) atomic_sub_return(i, v))
+#define atomic_inc(v)           atomic_add(1, v)
+#define atomic_dec(v)           atomic_sub(1, v)
+#define atomic_inc_return(v)    atomic_add_return(1, v)
+#define atomic_dec_return(v)    atomic_sub_return(1, v)
+#define atomic_dec_and_test(v)  (atomic_sub_return(1, v) == 0)
+#define atomic_inc_and_test(v)  (atomic_add_return(1, v) == 0)
+#define atomic_xchg(v, i)       __atomic_exchange_n(&(v)->counter, (i), __ATOMIC_SEQ_CST)
+
+static inline int
+atomic_cmpxchg(atomic_t *v, int old, int new)
+{
+   __atomic_compare_exchange_n(&v->counter, &old, new, 0, __ATOMIC_SEQ_CST,
+                               __ATOMIC_SEQ_CST);
+   return old;
+}
+
+#define xchg(ptr, v)            __atomic_exchange_n(ptr, v, __ATOMIC_SEQ_CST)
+#define cmpxchg(ptr, old, new)                                             \
+   ({                                                                      \
+      __typeof__(*(ptr)) __old = (old);                                    \
+      __atomic_compare_exchange_n(ptr, &__old, new, 0, __ATOMIC_SEQ_CST,   \
+                                  __ATOMIC_SEQ_CST);                       \
+      __old;                                                               \
+   })
+
+#define barrier()               __asm__ __volatile__("" ::: "memory")
+#define mb()                    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define rmb()                   __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define wmb()                   __atomic_thread_fence(__ATOMIC_RELEASE)
+#define smp_mb()                mb()
+#define smp_rmb()               rmb()
+#define smp_wmb()               wmb()
+#define smp_mb__before_clear_bit()      smp_mb()
+#define smp_mb__after_clear_bit()       smp_mb()
+#define cpu_relax()             sched_yield()
+#define ACCESS_ONCE(x)          (*(volatile __typeof__(x) *) &(x))
+#define prefetch(x)             __builtin_prefetch(x)
+
+static inline int
+fls(int x)
+{
+   return x ? 32 - __builtin_clz(x) : 0;
+}
+
+#define BITS_PER_LONG           (8 * (int) sizeof(long))
+#define BIT_WORD(nr)            ((nr) / BITS_PER_LONG)
+#define BIT_MASK(nr)            (1UL << ((nr) % BITS_PER_LONG))
+#define set_bit(nr, addr)                                                  \
+   ((void) __atomic_fetch_or((addr) + BIT_WORD(nr), BIT_MASK(nr),          \
+                             __ATOMIC_SEQ_CST))
+#define clear_bit(nr, addr)                                                \
+   ((void) __atomic_fetch_and((addr) + BIT_WORD(nr), ~BIT_MASK(nr),        \
+                              __ATOMIC_SEQ_CST))
+#define test_and_set_bit(nr, addr)                                         \
+   ((__atomic_fetch_or((addr) + BIT_WORD(nr), BIT_MASK(nr),                \
+                       __ATOMIC_SEQ_CST) & BIT_MASK(nr)) != 0)
+#define test_and_clear_bit(nr, addr)                                       \
+   ((__atomic_fetch_and((addr) + BIT_WORD(nr), ~BIT_MASK(nr),              \
+                        __ATOMIC_SEQ_CST) & BIT_MASK(nr)) != 0)
+#define test_bit(nr, addr)                                                 \
+   ((__atomic_load_n((addr) + BIT_WORD(nr), __ATOMIC_SEQ_CST) &            \
+     BIT_MASK(nr)) != 0)
+
+/*
+ * Spinlocks. acquired counts every time the lock was taken, contended
+ * how often a taker found it held, and moved how often it was taken on
+ * another PCPU than the last time, i.e. had its cache line move.
+ */
+
+typedef struct {
+   volatile int locked;
+   unsigned long acquired;
+   unsigned long contended;
+   unsigned long moved;
+   int lastPcpu;                /* stub_pcpu + 1 of the last taker */
+} spinlock_t;
+
+#define SPIN_LOCK_UNLOCKED      { 0, 0, 0, 0, 0 }
+#define spin_lock_init(l)       memset((l), 0, sizeof(spinlock_t))
+#define spin_is_locked(l)       (__atomic_load_n(&(l)->locked, __ATOMIC_SEQ_CST))
+
+static inline int
+spin_trylock(spinlock_t *l)
+{
+   if (__atomic_exchange_n(&l->locked, 1, __ATOMIC_ACQUIRE)) {
+      return 0;
+   }
+   l->acquired++;
+   if (l->lastPcpu != stub_pcpu + 1) {
+      if (l->lastPcpu != 0) {
+         l->moved++;
+      }
+      l->lastPcpu = stub_pcpu + 1;
+   }
+   return 1;
+}
+
+static inline void
+spin_lock(spinlock_t *l)
+{
+   if (spin_trylock(l)) {
+      return;
+   }
+   __atomic_fetch_add(&l->contended, 1, __ATOMIC_RELAXED);
+   while (!spin_trylock(l)) {
+      while (spin_is_locked(l)) {
+         cpu_relax();
+      }
+   }
+}
+
+static inline void
+spin_unlock(spinlock_t *l)
+{
+   VMK_ASSERT(spin_is_locked(l));
+   __atomic_store_n(&l->locked, 0, __ATOMIC_RELEASE);
+}
+
+#define spin_lock_bh(l)                 spin_lock(l)
+#define spin_unlock_bh(l)               spin_unlock(l)
+#define spin_lock_irq(l)                (local_irq_disable(), spin_lock(l))
+#define spin_unlock_irq(l)              (spin_unlock(l), local_irq_enable())
+#define spin_lock_irqsave(l, flags)     (local_irq_save(flags), spin_lock(l))
+#define spin_unlock_irqrestore(l, flags)                                   \
+   (spin_unlock(l), local_irq_restore(flags))
+
+/*
+ * Failures of a test, reported up to 16 times. Safe to call from any
+ * thread.
+ */
+
+static int failures;
+static pthread_mutex_t stub_fail_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline void __attribute__((format(printf, 1, 2)))
+fail(const char *fmt, ...)
+{
+   va_list ap;
+
+   pthread_mutex_lock(&stub_fail_lock);
+   if (failures++ < 16) {
+      va_start(ap, fmt);
+      vfprintf(stderr, fmt, ap);
+      va_end(ap);
+      fputc('\n', stderr);
+   }
+   pthread_mutex_unlock(&stub_fail_lock);
+}
+
+#include "stubs.inc"
+
+/*
+ * The scatterlist of the asm headers of the vmklinux build, which are not
+ * part of this tree: an entry of a Linux table, or for adapters that take
+ * the vmk_SgArray of an IO, a cursor over its elements.
+ */
+
+enum { SG_LINUX, SG_VMK };
+
+struct page;
+
+struct scatterlist {
+   struct page *page;
+   unsigned int offset;
+   unsigned int length;
+   dma_addr_t dma_address;
+   unsigned int dma_length;
+   vmk_SgElem *vmksgel;         /* SG_VMK: first element of the IO */
+   vmk_SgElem *cursgel;         /* SG_VMK: cursor */
+   int sg_type;
+};
+
+/* VMKLNX_VMKSGARRAY_SUPPORTED: an SG_VMK list moves its cursor */
+static inline struct scatterlist *
+sg_next(struct scatterlist *sg)
+{
+   if (sg->sg_type == SG_VMK) {
+      sg->cursgel++;
+      return sg;
+   }
+   return sg + 1;
+}
+
+static inline void
+sg_reset(struct scatterlist *sg)
+{
+   if (sg->sg_type == SG_VMK) {
+      sg->cursgel = sg->vmksgel;
+   }
+}
+
+#define sg_dma_address(sg)                                                 \
+   ((sg)->sg_type == SG_VMK ? (sg)->cursgel->addr : (sg)->dma_address)
+#define sg_dma_len(sg)                                                     \
+   ((sg)->sg_type == SG_VMK ? (sg)->cursgel->length : (sg)->dma_length)
+
+#endif /* _TESTS_STUBS_H_ */
@@ -0,0 +1,438 @@
+/*
+ * tx_burst_bench.c --
+ *
+ *    Checks and benchmark of the tx burst path of vmware/linux_net.c,
+ *    process_tx_queue as it ships, against a stub driver.
+ *
+ *    The checks run first. They fail if
+ *    - packets reach the driver out of order, twice, or not at all;
+ *    - skb->xmit_more is not set on exactly all but the last skb of each
+ *      burst, or _xmit_lock is taken more than once per burst;
+ *    - after the driver refuses a packet, or stops its queue, part way
+ *      through a burst, the rest of the burst is not back at the head of
+ *      outputList in its original order, or its skbs are not released
+ *      with their packet handles kept (fragsref bumped);
+ *    - process_tx_queue reschedules the queue while the driver has it
+ *      stopped, or fails to when the driver refused without stopping it;
+ *    - packets that could not be mapped to an skb count against
+ *      outputListMaxSize: a call has to hand exactly that many packets
+ *      to the driver when enough are queued;
+ *    - the per-queue counters disagree with what the driver saw.
+ *
+ *    Then outputList is filled with 256 packets at a time and drained
+ *    with vmklnx_tx_burst at 1, 8 and 32, and the packet rate and the
+ *    _xmit_lock acquisitions and doorbells (skbs without xmit_more) per
+ *    packet are reported. The driver does no work, so the rate is that of
+ *    vmklinux's side of the path.
+ *
+ *    usage: tx_burst_bench [millions of packets per run]
+ *
+ * extract ../../include/linux/netdevice.h: NETDEV_TX_OK NETDEV_TX_BUSY enum netdev_queue_state_t struct netdev_soft_queue enum netdev_drop_reason struct netdev_queue_stats NETDEV_STATS_RX_QUEUES struct netdev_queue netif_tx_stop_queue netif_tx_queue_stopped
+ * extract ../vmware/linux_net.c: NETDEV_TX_BURST_MAX enum LIN_NET_QUEUE_UNBLOCKED enum LIN_NET_HARD_QUEUE_XOFF vmklnx_tx_burst netdev_tx_stats_get netdev_stats_put process_tx_queue vmklnx_netif_stop_tx_queue
+ */
+
+#include <time.h>
+
+#include "stubs.h"
+
+#define IFF_UP          0x1
+#define QUEUE_PKTS      256
+#define CHECK_PKTS      200
+
+struct skb_shared_info {
+   atomic_t fragsref;
+};
+
+struct sk_buff {
+   unsigned int len;
+   unsigned char xmit_more;
+   vmk_PktHandle *pkt;
+   struct skb_shared_info shinfo;
+};
+
+#define skb_shinfo(skb)         (&(skb)->shinfo)
+
+struct netdev_queue;
+struct netdev_queue_stats;
+
+struct net_device {
+   char name[16];
+   unsigned int flags;
+   vmk_ModuleID module_id;
+   int (*hard_start_xmit)(struct sk_buff *skb, struct net_device *dev);
+   struct netdev_queue *_tx;
+   struct netdev_queue_stats **linnet_stats;
+};
+
+void vmklnx_netif_stop_tx_queue(struct netdev_queue *queue);
+
+/* a packet, with the skb map_pkt_to_skb hands out for it */
+struct test_pkt {
+   vmk_PktHandle handle;
+   struct sk_buff skb;
+   unsigned int seq;
+   int mapFail;
+};
+
+static struct {
+   int bench;              /* count only, don't log or check */
+   unsigned int calls;     /* hard_start_xmit calls */
+   unsigned int busyAt;    /* refuse the call with this number, 0 never */
+   int stopOnBusy;         /* stop the queue when refusing */
+   unsigned int stopAt;    /* stop the queue after accepting this call */
+   unsigned int nSent;
+   unsigned int sent[CHECK_PKTS];
+   unsigned char more[CHECK_PKTS];
+   unsigned long doorbells;
+   unsigned long freed;    /* skbs released by dev_kfree_skb_any */
+   unsigned long schedules;
+} drv;
+
+static VMK_ReturnStatus
+map_pkt_to_skb(struct net_device *dev, struct netdev_queue *queue,
+               vmk_PktHandle *pkt, struct sk_buff **pskb)
+{
+   struct test_pkt *tp = container_of(pkt, struct test_pkt, handle);
+
+   (void) dev;
+   (void) queue;
+   if (tp->mapFail) {
+      return VMK_NO_MEMORY;
+   }
+   tp->skb.len = 60;
+   tp->skb.xmit_more = 0;
+   tp->skb.pkt = pkt;
+   atomic_set(&tp->skb.shinfo.fragsref, 0);
+   *pskb = &tp->skb;
+   return VMK_OK;
+}
+
+/* the tests never set up a staging ring */
+static void
+netdev_tx_stage_drain(struct netdev_queue *queue, vmk_PktList *freePktsList)
+{
+   (void) queue;
+   (void) freePktsList;
+   VMK_ASSERT(0);
+}
+
+static void
+__netif_schedule(struct netdev_queue *queue)
+{
+   (void) queue;
+   drv.schedules++;
+}
+
+static void
+dev_kfree_skb_any(struct sk_buff *skb)
+{
+   if (atomic_read(&skb_shinfo(skb)->fragsref) != 1) {
+      fail("requeued skb released without keeping its packet handle");
+   }
+   drv.freed++;
+}
+
+#include "tx_burst_bench.inc"
+
+static int
+stub_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+   struct test_pkt *tp = container_of(skb, struct test_pkt, skb);
+   unsigned int call = ++drv.calls;
+
+   if (!skb->xmit_more) {
+      drv.doorbells++;
+   }
+   if (drv.bench) {
+      return NETDEV_TX_OK;
+   }
+   if (!spin_is_locked(&dev->_tx->_xmit_lock)) {
+      fail("hard_start_xmit called without _xmit_lock");
+   }
+   if (call == drv.busyAt) {
+      if (drv.stopOnBusy) {
+         netif_tx_stop_queue(dev->_tx);
+      }
+      return NETDEV_TX_BUSY;
+   }
+   if (drv.nSent < CHECK_PKTS) {
+      drv.sent[drv.nSent] = tp->seq;
+      drv.more[drv.nSent] = skb->xmit_more;
+      drv.nSent++;
+   }
+   if (call == drv.stopAt) {
+      netif_tx_stop_queue(dev->_tx);
+   }
+   return NETDEV_TX_OK;
+}
+
+static struct netdev_queue txq;
+static struct netdev_queue_stats *stats[1];
+static struct test_pkt pkts[QUEUE_PKTS];
+
+static void
+setup(uint32_t maxSize, unsigned int nPkts, unsigned int failEvery)
+{
+   static struct net_device dev;
+   unsigned int i;
+
+   memset(&dev, 0, sizeof(dev));
+   strcpy(dev.name, "vmnic0");
+   dev.flags = IFF_UP;
+   dev.hard_start_xmit = stub_xmit;
+   dev._tx = &txq;
+   if (stats[0] == NULL) {
+      stats[0] = calloc(NETDEV_STATS_RX_QUEUES + 1, sizeof(*stats[0]));
+   }
+   memset(stats[0], 0, (NETDEV_STATS_RX_QUEUES + 1) * sizeof(*stats[0]));
+   dev.linnet_stats = stats;
+
+   memset(&txq, 0, sizeof(txq));
+   txq.dev = &dev;
+   spin_lock_init(&txq.softq.queue_lock);
+   spin_lock_init(&txq._xmit_lock);
+   txq.softq.state = LIN_NET_QUEUE_UNBLOCKED|LIN_NET_QUEUE_STARTED;
+   txq.softq.outputListMaxSize = maxSize;
+   vmk_PktListInit(&txq.softq.outputList);
+
+   memset(&drv, 0, sizeof(drv));
+   for (i = 0; i < QUEUE_PKTS; i++) {
+      pkts[i].seq = i;
+      pkts[i].mapFail = failEvery && (i % failEvery) == failEvery - 1;
+      if (i < nPkts) {
+         vmk_PktListAddToTail(&txq.softq.outputList, &pkts[i].handle);
+      }
+   }
+}
+
+static int
+run(vmk_PktList *freeList)
+{
+   int ret;
+
+   vmk_PktListInit(freeList);
+   spin_lock(&txq.softq.queue_lock);
+   ret = process_tx_queue(&txq, freeList);
+   if (!spin_is_locked(&txq.softq.queue_lock)) {
+      fail("process_tx_queue returned without queue_lock");
+   }
+   spin_unlock(&txq.softq.queue_lock);
+   return ret;
+}
+
+/* outputList has to hold the packets from..nPkts-1 in order */
+static void
+check_output_list(const char *what, unsigned int from, unsigned int nPkts)
+{
+   vmk_PktList *list = &txq.softq.outputList;
+   vmk_PktHandle *pkt;
+   unsigned int seq = from;
+
+   if (vmk_PktListCount(list) != nPkts - from) {
+      fail("%s: %u packets left queued, expected %u", what,
+           (unsigned int) vmk_PktListCount(list), nPkts - from);
+      return;
+   }
+   for (pkt = vmk_PktListGetHead(list); pkt != NULL;
+        pkt = vmk_PktListGetNext(list, pkt)) {
+      if (container_of(pkt, struct test_pkt, handle)->seq != seq++) {
+         fail("%s: packet %u requeued out of order", what, seq - 1);
+         return;
+      }
+   }
+}
+
+static void
+check_sent(const char *what, unsigned int nSent, unsigned int burst)
+{
+   unsigned int i;
+
+   if (drv.nSent != nSent) {
+      fail("%s: driver got %u packets, expected %u", what, drv.nSent, nSent);
+      return;
+   }
+   for (i = 0; i < nSent; i++) {
+      if (drv.sent[i] != i) {
+         fail("%s: packet %u sent in place of %u", what, drv.sent[i], i);
+         return;
+      }
+      if (burst && drv.more[i] != ((i + 1) % burst != 0 && i + 1 < nSent)) {
+         fail("%s: xmit_more %s on packet %u", what,
+              drv.more[i] ? "set" : "clear", i);
+         return;
+      }
+   }
+}
+
+static void
+checks(void)
+{
+   struct netdev_queue_stats *s;
+   vmk_PktList freeList;
+   vmk_PktHandle *pkt;
+   unsigned int n;
+   int ret;
+
+   vmklnx_tx_burst = 32;
+
+   /* 100 packets go out in bursts of 32, 32, 32 and 4 */
+   setup(1000, 100, 0);
+   s = &stats[0][NETDEV_STATS_RX_QUEUES];
+   ret = run(&freeList);
+   check_sent("drain", 100, 32);
+   check_output_list("drain", 100, 100);
+   if (ret != 0 || drv.schedules != 0) {
+      fail("drain: returned %d, %lu schedules", ret, drv.schedules);
+   }
+   if (txq._xmit_lock.acquired != 4 || drv.doorbells != 4) {
+      fail("drain: %lu _xmit_lock acquisitions, %lu doorbells for 4 bursts",
+           txq._xmit_lock.acquired, drv.doorbells);
+   }
+   if (s->packets != 100 || s->bytes != 6000 || s->batches != 4 ||
+       s->batchPkts != 100 || s->requeued != 0) {
+      fail("drain: counters off");
+   }
+
+   /* the driver stops its queue and refuses the 10th packet */
+   setup(1000, 40, 0);
+   drv.busyAt = 10;
+   drv.stopOnBusy = 1;
+   ret = run(&freeList);
+   check_sent("busy", 9, 0);
+   check_output_list("busy", 9, 40);
+   if (ret != 1 || drv.schedules != 0) {
+      fail("busy: returned %d, %lu schedules with the queue stopped",
+           ret, drv.schedules);
+   }
+   if (drv.freed != 23 || s->requeued != 23 || s->packets != 9) {
+      fail("busy: %lu skbs released, %llu requeued, %llu sent",
+           drv.freed, (unsigned long long) s->requeued,
+           (unsigned long long) s->packets);
+   }
+
+   /* it refuses without stopping the queue: try again later */
+   setup(1000, 40, 0);
+   drv.busyAt = 1;
+   ret = run(&freeList);
+   check_sent("busy running", 0, 0);
+   check_output_list("busy running", 0, 40);
+   if (ret != 1 || drv.schedules != 1) {
+      fail("busy running: returned %d, %lu schedules", ret, drv.schedules);
+   }
+
+   /* it accepts the 5th packet and stops its queue on it */
+   setup(1000, 40, 0);
+   drv.stopAt = 5;
+   ret = run(&freeList);
+   check_sent("stop", 5, 0);
+   check_output_list("stop", 5, 40);
+   if (ret != 1 || drv.schedules != 0 || drv.calls != 5) {
+      fail("stop: returned %d, %lu schedules, %u calls", ret,
+           drv.schedules, drv.calls);
+   }
+   if (drv.freed != 27 || s->requeued != 27) {
+      fail("stop: %lu skbs released for 27 requeued", drv.freed);
+   }
+
+   /*
+    * Every 5th packet fails to map. The call still has to hand 64
+    * packets to the driver, and the unmapped ones it came across go on
+    * the free list.
+    */
+   setup(64, CHECK_PKTS, 5);
+   ret = run(&freeList);
+   if (drv.nSent != 64) {
+      fail("map failures: %u packets sent for outputListMaxSize 64",
+           drv.nSent);
+   }
+   n = 0;
+   while (!vmk_PktListIsEmpty(&freeList)) {
+      struct test_pkt *tp;
+
+      pkt = vmk_PktListPopHead(&freeList);
+      tp = container_of(pkt, struct test_pkt, handle);
+
+      if (!tp->mapFail) {
+         fail("map failures: packet %u freed without a failure", tp->seq);
+      }
+      n++;
+   }
+   /* packets 0-78 hold 64 good ones */
+   if (n != 15 || vmk_PktListCount(&txq.softq.outputList) != CHECK_PKTS - 79) {
+      fail("map failures: %u packets freed, %u left", n,
+           (unsigned int) vmk_PktListCount(&txq.softq.outputList));
+   }
+   for (n = 0; n < drv.nSent; n++) {
+      if (pkts[drv.sent[n]].mapFail || (n > 0 && drv.sent[n] <= drv.sent[n - 1])) {
+         fail("map failures: packet %u sent out of order", drv.sent[n]);
+         break;
+      }
+   }
+   if (ret != 0 || drv.schedules != 1) {
+      fail("map failures: returned %d, %lu schedules with packets left",
+           ret, drv.schedules);
+   }
+}
+
+static double
+now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench(int burst, unsigned long total)
+{
+   vmk_PktList freeList;
+   unsigned long done = 0;
+   unsigned int i;
+   double t;
+
+   setup(QUEUE_PKTS, 0, 0);
+   drv.bench = 1;
+   vmklnx_tx_burst = burst;
+
+   t = now();
+   while (done < total) {
+      for (i = 0; i < QUEUE_PKTS; i++) {
+         vmk_PktListAddToTail(&txq.softq.outputList, &pkts[i].handle);
+      }
+      run(&freeList);
+      done += QUEUE_PKTS;
+      if (!vmk_PktListIsEmpty(&txq.softq.outputList)) {
+         fail("bench: burst %d left packets queued", burst);
+         return;
+      }
+   }
+   t = now() - t;
+   if (drv.calls != done) {
+      fail("bench: %u of %lu packets sent", drv.calls, done);
+   }
+
+   printf("%5d %12.2f %12.3f %12.3f\n", burst, done / t / 1e6,
+          (double) txq._xmit_lock.acquired / done,
+          (double) drv.doorbells / done);
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned long total = (argc > 1 ? strtoul(argv[1], NULL, 0) : 20) * 1000000;
+
+   checks();
+   if (failures) {
+      fprintf(stderr, "tx_burst: %d failures\n", failures);
+      return 1;
+   }
+   printf("tx_burst: checks ok\n");
+
+   printf("%5s %12s %12s %12s\n", "burst", "Mpkts/s", "xmitlock/pkt",
+          "doorbell/pkt");
+   bench(1, total);
+   bench(8, total);
+   bench(32, total);
+   return failures != 0;
+}
@@ -0,0 +1,533 @@
+/*
+ * tx_flow_hash_test.c --
+ *
+ *    Test of the tx queue pick of vmklinux, netdev_pkt_flow_hash,
+ *    netdev_pick_tx_queue and netdev_tx of vmware/linux_net.c as they
+ *    ship.
+ *
+ *    Random lists of IPv4, IPv6, fragmented, VLAN tagged, non IP and
+ *    netqueue steered packets go through netdev_tx() on a device with a
+ *    varying number of tx queues, up to more than the flow hash spreads
+ *    over. A stand-in for netdev_tx_queue() logs the packets of each run
+ *    and fails some runs on purpose. The spread of many flows over 8
+ *    queues and the runs a list takes are printed.
+ *
+ *    The test fails if
+ *    - vmklnx_tx_flow_hash is not on by default;
+ *    - with it off, a packet without a netqueue id goes to a queue other
+ *      than 0;
+ *    - with it on, such a packet goes to a queue past the active ones or
+ *      past the first NETDEV_TX_HASH_QUEUES;
+ *    - a packet with a netqueue id does not go to its queue, or to queue
+ *      0 when that queue is out of range;
+ *    - the packets of a flow, fragments included, go to more than one
+ *      queue or leave out of order;
+ *    - a list is sent in more than one run per queue, or not in queue
+ *      order;
+ *    - a packet is lost or sent twice;
+ *    - netdev_tx() does not return the status of the first run that
+ *      failed, or VMK_OK when none did;
+ *    - a queue gets more than 25% more or less than its share of 4096
+ *      flows.
+ *
+ * extract ../../include/linux/jhash.h: JHASH_GOLDEN_RATIO __jhash_mix jhash_3words
+ * extract ../../include/linux/if_ether.h: ETH_HEADER_TYPE_DIX ETH_HEADER_TYPE_802_1PQ ETH_HEADER_TYPE_802_3 ETH_HEADER_TYPE_802_1PQ_802_3 ETH_ALEN ETH_HLEN ETH_P_IP ETH_P_ARP ETH_P_8021Q ETH_P_IPV6 struct ethhdr_llc struct ethhdr
+ * extract ../../include/linux/if_vlan.h: VLAN_ETH_HLEN struct vlan_ethhdr_llc struct vlan_ethhdr
+ * extract ../../include/linux/etherdevice.h: eth_header_type eth_header_len eth_header_frame_type eth_header_is_ipv4
+ * extract ../../include/linux/in.h: enum IPPROTO_IP
+ * extract ../../include/linux/in6.h: struct in6_addr
+ * extract ../../include/linux/ip.h: struct iphdr
+ * extract ../../include/linux/ipv6.h: struct ipv6hdr
+ * extract ../../include/net/ip.h: IP_MF IP_OFFSET
+ * extract ../../include/vmklinux26/vmknetddinetq.h: vmknetddi_queueops_queue_t VMKNETDDI_QUEUEOPS_INVALID_QUEUEID VMKNETDDI_QUEUEOPS_MK_TX_QUEUEID VMKNETDDI_QUEUEOPS_IS_TX_QUEUEID VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID VMKNETDDI_QUEUEOPS_TX_QUEUEID_SET_QIDX VMKNETDDI_QUEUEOPS_TX_QUEUEID_GET_QIDX
+ * extract ../../../../bora/vmkernel/include/vmkapi/net/vmkapi_net_pkt.h: vmk_PktFrameMappedLenGet vmk_PktFrameMappedPointerGet
+ * extract ../vmware/linux_net.c: NETDEV_TX_HASH_QUEUES txFlowHashSeed vmklnx_tx_flow_hash netdev_pkt_flow_hash netdev_pick_tx_queue netdev_tx marshall_to_vmknetq_id marshall_from_vmknetq_id get_embedded_queue_mapping
+ */
+
+#include "stubs.h"
+
+#define MAX_QUEUES              24
+#define FRAME_MAX               128
+#define IPV6_HLEN               40
+#define LISTS                   20000
+#define LIST_MAX                64
+#define FLOWS                   512
+#define SPREAD_FLOWS            4096
+#define SPREAD_QUEUES           8
+#define RUN_LIST                32
+#define RUN_FLOWS               8
+
+#define module_param(name, type, perm)
+#define MODULE_PARM_DESC(name, desc)
+
+struct netdev_queue {
+   int sends;           /* runs sent on the queue for this list */
+};
+
+struct net_device {
+   struct netdev_queue *_tx;
+   unsigned int num_tx_queues;
+   unsigned int real_num_tx_queues;
+};
+
+/* the vmkernel's netqueue ids: the type above the value */
+#define TEST_VMKQ_TX            2ULL
+#define TEST_VMKQ_RX            1ULL
+
+static vmk_Bool
+vmk_NetqueueIsTxQueueId(vmk_NetqueueQueueId qid)
+{
+   return (qid >> 32) == TEST_VMKQ_TX;
+}
+
+static vmk_Bool
+vmk_NetqueueIsRxQueueId(vmk_NetqueueQueueId qid)
+{
+   return (qid >> 32) == TEST_VMKQ_RX;
+}
+
+static vmk_uint32
+vmk_NetqueueQueueIdVal(vmk_NetqueueQueueId qid)
+{
+   return (vmk_uint32) qid;
+}
+
+static VMK_ReturnStatus
+vmk_NetqueueQueueMkTxQueueId(vmk_NetqueueQueueId *qid, vmk_uint32 val)
+{
+   *qid = (TEST_VMKQ_TX << 32) | val;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus
+vmk_NetqueueQueueMkRxQueueId(vmk_NetqueueQueueId *qid, vmk_uint32 val)
+{
+   *qid = (TEST_VMKQ_RX << 32) | val;
+   return VMK_OK;
+}
+
+static VMK_ReturnStatus netdev_tx_queue(struct net_device *dev,
+                                        struct netdev_queue *queue,
+                                        vmk_PktList *pktList);
+static vmk_NetqueueQueueId vmk_PktQueueIdGet(vmk_PktHandle *pkt);
+
+/* declared ahead in linux_net.c */
+static inline VMK_ReturnStatus
+marshall_from_vmknetq_id(vmk_NetqueueQueueId vmkqid,
+                         vmknetddi_queueops_queueid_t *qid);
+static inline u16
+get_embedded_queue_mapping(vmknetddi_queueops_queueid_t queueid);
+
+#include "tx_flow_hash_test.inc"
+
+/* a packet handle and the test's view of it */
+struct test_pkt {
+   vmk_PktHandle handle;
+   u8 frame[FRAME_MAX];
+   vmk_NetqueueQueueId queueId;        /* 0 if not steered */
+   unsigned int steerIdx;
+   int flow;            /* -1 for packets without a flow to keep in order */
+   unsigned int seq;
+   int sent;
+};
+
+#define TP(p)           container_of(p, struct test_pkt, handle)
+
+static vmk_NetqueueQueueId
+vmk_PktQueueIdGet(vmk_PktHandle *pkt)
+{
+   return TP(pkt)->queueId;
+}
+
+/* what the netdev_tx_queue() stand-in saw */
+static int queueOfFlow[FLOWS];
+static unsigned int nextSeq[FLOWS];
+static VMK_ReturnStatus runStatus[LIST_MAX];
+static int runs, runsToFail, lastQueue;
+static int spreadOn;            /* whether flows may leave queue 0 */
+
+static VMK_ReturnStatus
+netdev_tx_queue(struct net_device *dev, struct netdev_queue *queue,
+                vmk_PktList *pktList)
+{
+   int queue_idx = queue - dev->_tx;
+   unsigned int hashQueues = min_t(unsigned int, dev->real_num_tx_queues,
+                                   NETDEV_TX_HASH_QUEUES);
+   VMK_ReturnStatus status = VMK_OK;
+
+   if (queue_idx >= (int) dev->real_num_tx_queues) {
+      fail("run sent to queue %d of %u active", queue_idx,
+           dev->real_num_tx_queues);
+   }
+   if (queue->sends++) {
+      fail("list sent on queue %d in more than one run", queue_idx);
+   }
+   if (queue_idx <= lastQueue) {
+      fail("run on queue %d sent after one on queue %d", queue_idx,
+           lastQueue);
+   }
+   lastQueue = queue_idx;
+
+   while (!vmk_PktListIsEmpty(pktList)) {
+      struct test_pkt *p = TP(vmk_PktListPopHead(pktList));
+
+      if (p->sent++) {
+         fail("packet sent twice");
+      }
+      if (p->queueId) {
+         unsigned int want = p->steerIdx;
+
+         if (want >= dev->real_num_tx_queues) {
+            want = 0;
+         }
+         if (queue_idx != (int) want) {
+            fail("packet steered to queue %u sent on %d", want, queue_idx);
+         }
+      } else if (!spreadOn && queue_idx != 0) {
+         fail("packet sent on queue %d with flow hashing off", queue_idx);
+      } else if (queue_idx >= (int) hashQueues) {
+         fail("packet hashed to queue %d of %u", queue_idx, hashQueues);
+      }
+      if (p->flow >= 0) {
+         if (queueOfFlow[p->flow] < 0) {
+            queueOfFlow[p->flow] = queue_idx;
+         } else if (queueOfFlow[p->flow] != queue_idx) {
+            fail("flow %d sent on queues %d and %d", p->flow,
+                 queueOfFlow[p->flow], queue_idx);
+         }
+         if (p->seq != nextSeq[p->flow]) {
+            fail("flow %d sent packet %u before %u", p->flow, p->seq,
+                 nextSeq[p->flow]);
+         }
+         nextSeq[p->flow] = p->seq + 1;
+      }
+   }
+
+   if (runs < LIST_MAX && (rand() % 4) == 0 && runsToFail) {
+      status = 1 + rand() % 3;
+   }
+   if (runs < LIST_MAX) {
+      runStatus[runs] = status;
+   }
+   runs++;
+   return status;
+}
+
+struct flow {
+   int kind;            /* 0 TCPv4, 1 UDPv4, 2 fragmented UDPv4, 3 TCPv6 */
+   int vlan;
+   u32 addr[2][4];
+   u16 port[2];
+};
+
+static struct flow flows[FLOWS];
+
+static void
+flow_init(struct flow *f)
+{
+   int i, j;
+
+   f->kind = rand() % 4;
+   f->vlan = rand() % 3 == 0;
+   for (i = 0; i < 2; i++) {
+      for (j = 0; j < 4; j++) {
+         f->addr[i][j] = (u32) rand() ^ ((u32) rand() << 16);
+      }
+      f->port[i] = rand();
+   }
+}
+
+static void
+pkt_init(struct test_pkt *p)
+{
+   memset(p, 0, sizeof(*p));
+   p->handle.frameVA = (vmk_VirtAddr) p->frame;
+   p->handle.frameMappedLen = sizeof(p->frame);
+   p->flow = -1;
+}
+
+/* build packet n of a flow in the frame of p, byte by byte */
+static void
+flow_frame(const struct flow *f, unsigned int n, struct test_pkt *p)
+{
+   u8 *eh = p->frame;
+   unsigned int off = ETH_HLEN;
+   u16 type = f->kind == 3 ? ETH_P_IPV6 : ETH_P_IP;
+   u8 *l4;
+
+   memset(p->frame, 0, sizeof(p->frame));
+   /* the payload differs from packet to packet */
+   memset(p->frame + 100, n, sizeof(p->frame) - 100);
+   if (f->vlan) {
+      eh[12] = ETH_P_8021Q >> 8;
+      eh[13] = ETH_P_8021Q & 0xff;
+      eh[14] = n;               /* priority bits may change */
+      eh[15] = 5;
+      off = VLAN_ETH_HLEN;
+   }
+   eh[off - 2] = type >> 8;
+   eh[off - 1] = type & 0xff;
+
+   if (type == ETH_P_IP) {
+      u8 *iph = eh + off;
+      u16 frag_off = 0;
+
+      iph[0] = 0x45;
+      iph[4] = n >> 8;          /* ip id */
+      iph[5] = n;
+      iph[9] = f->kind == 0 ? IPPROTO_TCP : IPPROTO_UDP;
+      if (f->kind == 2) {
+         /* three fragments per datagram, the first with the ports */
+         frag_off = (n % 3) == 2 ? 370 : IP_MF | ((n % 3) * 185);
+      }
+      iph[6] = frag_off >> 8;
+      iph[7] = frag_off & 0xff;
+      memcpy(iph + 12, f->addr[0], 4);
+      memcpy(iph + 16, f->addr[1], 4);
+      l4 = iph + 20;
+   } else {
+      u8 *ip6h = eh + off;
+
+      ip6h[0] = 0x60;
+      ip6h[6] = IPPROTO_TCP;
+      memcpy(ip6h + 8, f->addr[0], 16);
+      memcpy(ip6h + 24, f->addr[1], 16);
+      l4 = ip6h + IPV6_HLEN;
+   }
+   if (f->kind != 2 || (n % 3) == 0) {
+      memcpy(l4, &f->port[0], 2);
+      memcpy(l4 + 2, &f->port[1], 2);
+   } else {
+      /* a later fragment carries payload where the ports would be */
+      l4[0] = n;
+      l4[3] = ~n;
+   }
+}
+
+/* a netqueue id for tx queue idx, as netqueue_op_alloc_queue() hands out */
+static vmk_NetqueueQueueId
+steer_id(unsigned int idx)
+{
+   vmknetddi_queueops_queueid_t qid;
+   vmk_NetqueueQueueId vmkqid = 0;
+
+   qid = VMKNETDDI_QUEUEOPS_TX_QUEUEID_SET_QIDX(
+            VMKNETDDI_QUEUEOPS_MK_TX_QUEUEID(idx), idx);
+   if (marshall_to_vmknetq_id(qid, &vmkqid) != VMK_OK) {
+      fail("no netqueue id for tx queue %u", idx);
+   }
+   return vmkqid;
+}
+
+static struct test_pkt pkts[LIST_MAX];
+
+static VMK_ReturnStatus
+send_list(struct net_device *dev, vmk_PktList *list, int fail_runs)
+{
+   unsigned int q;
+
+   for (q = 0; q < dev->num_tx_queues; q++) {
+      dev->_tx[q].sends = 0;
+   }
+   runs = 0;
+   lastQueue = -1;
+   runsToFail = fail_runs;
+   return netdev_tx(dev, list);
+}
+
+/*
+ * One list through netdev_tx(): either all steered to one netqueue id,
+ * or a mix of flows, non IP frames and short frames.
+ */
+static void
+one_list(struct net_device *dev, int fail_runs)
+{
+   vmk_PktList list;
+   unsigned int inList[FLOWS];
+   int n = 1 + rand() % LIST_MAX;
+   int steered = rand() % 5 == 0;
+   unsigned int steerIdx = rand() % (MAX_QUEUES + 2);
+   VMK_ReturnStatus ret, want;
+   int i;
+
+   vmk_PktListInit(&list);
+   memset(inList, 0, sizeof(inList));
+   for (i = 0; i < n; i++) {
+      struct test_pkt *p = &pkts[i];
+      int r = rand() % 16;
+
+      pkt_init(p);
+      if (r == 0) {
+         /* ARP */
+         p->frame[12] = ETH_P_ARP >> 8;
+         p->frame[13] = ETH_P_ARP & 0xff;
+         p->handle.frameMappedLen = 60;
+      } else if (r == 1) {
+         /* headers not in the mapped area */
+         flow_frame(&flows[rand() % FLOWS], 0, p);
+         p->handle.frameMappedLen = 20;
+      } else {
+         p->flow = rand() % FLOWS;
+         p->seq = nextSeq[p->flow] + inList[p->flow]++;
+         flow_frame(&flows[p->flow], p->seq, p);
+      }
+      if (steered) {
+         /* the vmkernel picked the queue, flows are its business */
+         if (p->flow >= 0) {
+            inList[p->flow]--;
+            p->flow = -1;
+         }
+         p->queueId = steer_id(steerIdx);
+         p->steerIdx = steerIdx;
+      }
+      vmk_PktListAddToTail(&list, &p->handle);
+   }
+
+   ret = send_list(dev, &list, fail_runs);
+
+   for (i = 0; i < n; i++) {
+      if (pkts[i].sent != 1) {
+         fail("packet %d of %d sent %d times", i, n, pkts[i].sent);
+      }
+   }
+   /* the runs went out in queue order */
+   want = VMK_OK;
+   for (i = 0; i < runs && i < LIST_MAX; i++) {
+      if (runStatus[i] != VMK_OK) {
+         want = runStatus[i];
+         break;
+      }
+   }
+   if (ret != want) {
+      fail("netdev_tx returned %d, the first failed run %d", ret, want);
+   }
+}
+
+static void
+reset_flows(void)
+{
+   int i;
+
+   for (i = 0; i < FLOWS; i++) {
+      queueOfFlow[i] = -1;
+   }
+}
+
+/* queue of each of SPREAD_FLOWS fresh TCP flows on SPREAD_QUEUES queues */
+static void
+spread_report(struct net_device *dev)
+{
+   unsigned int count[SPREAD_QUEUES];
+   double share = (double) SPREAD_FLOWS / SPREAD_QUEUES;
+   struct test_pkt p;
+   struct flow f;
+   int i;
+
+   dev->num_tx_queues = dev->real_num_tx_queues = SPREAD_QUEUES;
+   memset(count, 0, sizeof(count));
+   for (i = 0; i < SPREAD_FLOWS; i++) {
+      flow_init(&f);
+      f.kind = i % 2 ? 0 : 3;
+      pkt_init(&p);
+      flow_frame(&f, 0, &p);
+      count[netdev_pick_tx_queue(dev, &p.handle)]++;
+   }
+
+   printf("tx_flow_hash: %d flows over %d queues:", SPREAD_FLOWS,
+          SPREAD_QUEUES);
+   for (i = 0; i < SPREAD_QUEUES; i++) {
+      printf(" %u", count[i]);
+      if (count[i] < share * 0.75 || count[i] > share * 1.25) {
+         fail("%u flows on queue %d, %.0f expected", count[i], i, share);
+      }
+   }
+   printf("\n");
+}
+
+/*
+ * Runs, and so tx lock round trips, of lists of RUN_LIST packets of
+ * RUN_FLOWS interleaved TCP flows on SPREAD_QUEUES queues, against a run
+ * for each change of queue along the list.
+ */
+static void
+runs_report(struct net_device *dev)
+{
+   unsigned long sent = 0, changes = 0;
+   vmk_PktList list;
+   int l, i, prev;
+
+   dev->num_tx_queues = dev->real_num_tx_queues = SPREAD_QUEUES;
+   for (l = 0; l < 1000; l++) {
+      int base = rand() % (FLOWS - RUN_FLOWS);
+
+      vmk_PktListInit(&list);
+      prev = -1;
+      for (i = 0; i < RUN_LIST; i++) {
+         struct test_pkt *p = &pkts[i];
+         int q;
+
+         pkt_init(p);
+         p->flow = base + rand() % RUN_FLOWS;
+         p->seq = nextSeq[p->flow]++;
+         flow_frame(&flows[p->flow], p->seq, p);
+         p->flow = -1;
+         q = netdev_pick_tx_queue(dev, &p->handle);
+         changes += q != prev;
+         prev = q;
+         vmk_PktListAddToTail(&list, &p->handle);
+      }
+      send_list(dev, &list, 0);
+      sent += runs;
+   }
+   printf("tx_flow_hash: lists of %d packets of %d flows over %d queues: "
+          "%.1f runs per list, %.1f with a run per change of queue\n",
+          RUN_LIST, RUN_FLOWS, SPREAD_QUEUES, sent / 1000.0,
+          changes / 1000.0);
+}
+
+int
+main(void)
+{
+   static struct netdev_queue tx[MAX_QUEUES];
+   struct net_device dev = { ._tx = tx };
+   int i;
+
+   srand(1);
+   txFlowHashSeed = 0x5eed1e55;
+   for (i = 0; i < FLOWS; i++) {
+      flow_init(&flows[i]);
+   }
+
+   if (!vmklnx_tx_flow_hash) {
+      fail("tx flow hashing is off by default");
+   }
+
+   /* off: one queue for all but netqueues */
+   vmklnx_tx_flow_hash = spreadOn = 0;
+   dev.num_tx_queues = dev.real_num_tx_queues = 8;
+   reset_flows();
+   for (i = 0; i < LISTS / 4; i++) {
+      one_list(&dev, i & 1);
+   }
+
+   vmklnx_tx_flow_hash = spreadOn = 1;
+   for (i = 0; i < LISTS; i++) {
+      /* a flow may move when the number of active queues changes */
+      if ((i % 1000) == 0) {
+         dev.num_tx_queues = 1 + rand() % MAX_QUEUES;
+         dev.real_num_tx_queues = 1 + rand() % dev.num_tx_queues;
+         reset_flows();
+      }
+      one_list(&dev, i & 1);
+   }
+
+   spread_report(&dev);
+   runs_report(&dev);
+
+   if (failures) {
+      fprintf(stderr, "tx_flow_hash: %d failures\n", failures);
+      return 1;
+   }
+   printf("tx_flow_hash: ok\n");
+   return 0;
+}
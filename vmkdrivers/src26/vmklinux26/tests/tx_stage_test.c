@@ -0,0 +1,272 @@
+/*
+ * tx_stage_test.c --
+ *
+ *    Multi-threaded stress test of the lock-free tx staging ring of
+ *    vmware/linux_net.c: netdev_tx_stage, netdev_tx_stage_put and
+ *    netdev_tx_stage_drain with process_tx_queue, as they ship.
+ *
+ *    Producer threads, each its own PCPU, transmit numbered packets
+ *    through the ring while a deliberately slow driver refuses a packet
+ *    after every TX_BUDGET it takes, so outputList runs full. A
+ *    net_tx_action thread stands in for __netif_schedule. The uplink
+ *    retries what the queue refused.
+ *
+ *    The test fails if
+ *    - a packet is lost, duplicated or reordered within its producer;
+ *    - the ring admits packets that then have to be dropped when they are
+ *      moved to outputList, i.e. admission ignored what outputList holds;
+ *    - staged plus queued packets exceed outputListMaxSize by more than
+ *      the burst a refused driver call puts back.
+ *
+ * extract ../../include/linux/netdevice.h: NETDEV_TX_OK NETDEV_TX_BUSY enum netdev_queue_state_t NETDEV_TX_STAGE_SLOTS struct netdev_tx_stage_slot struct netdev_tx_stage struct netdev_soft_queue enum netdev_drop_reason struct netdev_queue_stats NETDEV_STATS_RX_QUEUES struct netdev_queue netif_tx_stop_queue netif_tx_queue_stopped
+ * extract ../vmware/linux_net.c: NETDEV_TX_STAGE_ROUNDS NETDEV_TX_BURST_MAX enum LIN_NET_QUEUE_UNBLOCKED enum LIN_NET_HARD_QUEUE_XOFF vmklnx_tx_burst netdev_tx_stats_get netdev_stats_put netdev_tx_stage_drain process_tx_queue netdev_tx_stage_put netdev_tx_stage_pending netdev_tx_stage vmklnx_netif_stop_tx_queue
+ */
+
+#include "stubs.h"
+
+#define IFF_UP          0x1
+#define PRODUCERS       6
+#define PKTS_PER_PROD   200000
+#define MAX_BATCH       24
+#define OUTPUT_MAX      256
+#define TX_BUDGET       16
+#define TX_BURST        8
+
+struct skb_shared_info {
+   atomic_t fragsref;
+};
+
+struct sk_buff {
+   unsigned int len;
+   unsigned char xmit_more;
+   vmk_PktHandle *pkt;
+   struct skb_shared_info shinfo;
+};
+
+#define skb_shinfo(skb)         (&(skb)->shinfo)
+
+struct netdev_queue;
+struct netdev_queue_stats;
+
+struct net_device {
+   char name[16];
+   unsigned int flags;
+   vmk_ModuleID module_id;
+   int (*hard_start_xmit)(struct sk_buff *skb, struct net_device *dev);
+   struct netdev_queue *_tx;
+   struct netdev_queue_stats **linnet_stats;
+};
+
+void vmklnx_netif_stop_tx_queue(struct netdev_queue *queue);
+static void __netif_schedule(struct netdev_queue *queue);
+
+/* a packet, with the skb map_pkt_to_skb hands out for it */
+struct test_pkt {
+   vmk_PktHandle handle;
+   struct sk_buff skb;
+   unsigned int producer;
+   unsigned int seq;
+};
+
+static VMK_ReturnStatus
+map_pkt_to_skb(struct net_device *dev, struct netdev_queue *queue,
+               vmk_PktHandle *pkt, struct sk_buff **pskb)
+{
+   struct test_pkt *tp = container_of(pkt, struct test_pkt, handle);
+
+   (void) dev;
+   (void) queue;
+   tp->skb.len = 60;
+   tp->skb.xmit_more = 0;
+   tp->skb.pkt = pkt;
+   atomic_set(&tp->skb.shinfo.fragsref, 0);
+   *pskb = &tp->skb;
+   return VMK_OK;
+}
+
+/* a refused skb goes back on outputList with its packet */
+static void
+dev_kfree_skb_any(struct sk_buff *skb)
+{
+   (void) skb;
+}
+
+#include "tx_stage_test.inc"
+
+static struct net_device dev;
+static struct netdev_queue txq;
+static struct netdev_queue_stats *stats[PRODUCERS + 1];
+
+/* results; the driver's are only written under _xmit_lock */
+static unsigned int nextSeq[PRODUCERS];
+static unsigned long sent, refused, reordered;
+static unsigned long drained;   /* packets handed back on a freePktsList */
+static unsigned long overLimit, maxQueued;
+static volatile int done;
+
+static void
+__netif_schedule(struct netdev_queue *queue)
+{
+   (void) queue;
+   /* the net_tx_action thread polls the queue anyway */
+}
+
+static int
+stub_xmit(struct sk_buff *skb, struct net_device *d)
+{
+   struct test_pkt *tp = container_of(skb, struct test_pkt, skb);
+
+   if (!spin_is_locked(&d->_tx->_xmit_lock)) {
+      fail("hard_start_xmit called without _xmit_lock");
+   }
+   if ((sent + refused) % (TX_BUDGET + 1) == TX_BUDGET) {
+      refused++;
+      return NETDEV_TX_BUSY;
+   }
+   if (tp->seq != nextSeq[tp->producer]) {
+      reordered++;
+   }
+   nextSeq[tp->producer] = tp->seq + 1;
+   sent++;
+   return NETDEV_TX_OK;
+}
+
+static void
+release(vmk_PktList *freeList)
+{
+   unsigned long n = vmk_PktListCount(freeList);
+
+   if (n != 0) {
+      __atomic_add_fetch(&drained, n, __ATOMIC_SEQ_CST);
+      vmk_PktListInit(freeList);
+   }
+}
+
+static void *
+producer(void *arg)
+{
+   unsigned int id = (unsigned long) arg;
+   struct test_pkt *pkts = calloc(PKTS_PER_PROD, sizeof(*pkts));
+   unsigned int seq = 0, n, seed = id;
+   vmk_PktList pktList, freeList;
+
+   stub_pcpu = id;
+   vmk_PktListInit(&pktList);
+   while (seq < PKTS_PER_PROD) {
+      n = 1 + rand_r(&seed) % MAX_BATCH;
+      for (; n > 0 && seq < PKTS_PER_PROD; n--, seq++) {
+         pkts[seq].producer = id;
+         pkts[seq].seq = seq;
+         vmk_PktListAddToTail(&pktList, &pkts[seq].handle);
+      }
+      while (!vmk_PktListIsEmpty(&pktList)) {
+         vmk_PktListInit(&freeList);
+         if (netdev_tx_stage(&txq, &pktList, &freeList) != VMK_OK) {
+            sched_yield();
+         }
+         release(&freeList);
+      }
+   }
+   return pkts;
+}
+
+static void *
+net_tx_action(void *arg)
+{
+   vmk_PktList freeList;
+   unsigned long queued;
+
+   (void) arg;
+   stub_pcpu = PRODUCERS;
+   while (!done) {
+      vmk_PktListInit(&freeList);
+      spin_lock(&txq.softq.queue_lock);
+      queued = vmk_PktListCount(&txq.softq.outputList) +
+               atomic_read(&txq.softq.stage->pkts);
+      if (queued > maxQueued) {
+         maxQueued = queued;
+      }
+      if (queued > OUTPUT_MAX + TX_BURST) {
+         overLimit++;
+      }
+      process_tx_queue(&txq, &freeList);
+      spin_unlock(&txq.softq.queue_lock);
+      release(&freeList);
+      sched_yield();
+   }
+   return NULL;
+}
+
+int
+main(void)
+{
+   pthread_t prod[PRODUCERS], txa;
+   void *pkts[PRODUCERS];
+   vmk_PktList freeList;
+   unsigned long i;
+
+   strcpy(dev.name, "vmnic0");
+   dev.flags = IFF_UP;
+   dev.hard_start_xmit = stub_xmit;
+   dev._tx = &txq;
+   for (i = 0; i <= PRODUCERS; i++) {
+      stats[i] = calloc(NETDEV_STATS_RX_QUEUES + 1, sizeof(*stats[i]));
+   }
+   dev.linnet_stats = stats;
+   vmklnx_tx_burst = TX_BURST;
+
+   /* as netif_alloc_netdev and netdev_tx_stages_create set it up */
+   txq.dev = &dev;
+   spin_lock_init(&txq.softq.queue_lock);
+   spin_lock_init(&txq._xmit_lock);
+   txq.softq.state = LIN_NET_QUEUE_UNBLOCKED|LIN_NET_QUEUE_STARTED;
+   txq.softq.outputListMaxSize = OUTPUT_MAX;
+   vmk_PktListInit(&txq.softq.outputList);
+   txq.softq.stage = calloc(1, sizeof(*txq.softq.stage));
+   for (i = 0; i < NETDEV_TX_STAGE_SLOTS; i++) {
+      atomic_set(&txq.softq.stage->ring[i].seq, i);
+      vmk_PktListInit(&txq.softq.stage->ring[i].pktList);
+   }
+
+   pthread_create(&txa, NULL, net_tx_action, NULL);
+   for (i = 0; i < PRODUCERS; i++) {
+      pthread_create(&prod[i], NULL, producer, (void *) i);
+   }
+   for (i = 0; i < PRODUCERS; i++) {
+      pthread_join(prod[i], &pkts[i]);
+   }
+   done = 1;
+   pthread_join(txa, NULL);
+   while (atomic_read(&txq.softq.stage->pkts) ||
+          !vmk_PktListIsEmpty(&txq.softq.outputList)) {
+      vmk_PktListInit(&freeList);
+      spin_lock(&txq.softq.queue_lock);
+      process_tx_queue(&txq, &freeList);
+      spin_unlock(&txq.softq.queue_lock);
+      release(&freeList);
+   }
+
+   printf("tx_stage: sent %lu, refused %lu, drain drops %lu, over limit %lu, "
+          "reordered %lu, at most %lu queued for %u\n", sent, refused,
+          drained, overLimit, reordered, maxQueued, OUTPUT_MAX);
+
+   if (sent != (unsigned long) PRODUCERS * PKTS_PER_PROD) {
+      fail("%lu packets sent of %u", sent, PRODUCERS * PKTS_PER_PROD);
+   }
+   for (i = 0; i < PRODUCERS; i++) {
+      if (nextSeq[i] != PKTS_PER_PROD) {
+         fail("producer %lu: last sequence %u", i, nextSeq[i]);
+      }
+      free(pkts[i]);
+   }
+   if (drained || overLimit || reordered) {
+      fail("packets dropped, reordered or queued over the limit");
+   }
+
+   if (failures) {
+      fprintf(stderr, "tx_stage_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("tx_stage_test: ok\n");
+   return 0;
+}
@@ -0,0 +1,472 @@
+/*
+ * tx_sw_gso_test.c --
+ *
+ *    Test of the software TSO path of vmware/linux_net.c as it ships:
+ *    netdev_pkt_inet_proto, netdev_pkt_needs_sw_gso, netdev_tx_sw_gso and
+ *    skb_gso_segment. Segmentation itself is the vmkernel's
+ *    (vmk_PktTcpSegmentation); here it is a stub that hands out a given
+ *    number of segment packets, or fails part way, so the test covers
+ *    what vmklinux does around it.
+ *
+ *    Random lists of IPv4, IPv6 and ARP frames, TSO or not, with up to
+ *    three inline 802.1Q tags and sometimes mapped short of their
+ *    ethertype, go through netdev_tx_sw_gso() for every combination of
+ *    NETIF_F_TSO and NETIF_F_TSO6. The test fails if
+ *    - a frame is segmented that the device could have segmented, that
+ *      is not TSO, not IP, or whose ethertype is not mapped, or one is
+ *      not segmented that needs it;
+ *    - the list does not come out as the frames in their original order,
+ *      each segmented one replaced by its segments in order;
+ *    - a segmented frame is not released, or one that failed to segment
+ *      is not moved to the free list with the segments made before the
+ *      failure released;
+ *    - a list with no frame to segment is walked more than once.
+ *
+ *    skb_gso_segment() is checked to chain one skb per segment in order,
+ *    to leave the TSO skb and its packet to the caller, and on a failure
+ *    to map a segment to free the skbs made so far and release the
+ *    remaining segments.
+ *
+ * extract ../../include/linux/err.h: MAX_ERRNO IS_ERR_VALUE ERR_PTR PTR_ERR IS_ERR
+ * extract ../../include/linux/if_ether.h: ETH_ALEN ETH_HLEN ETH_P_IP ETH_P_ARP ETH_P_8021Q ETH_P_IPV6 struct ethhdr
+ * extract ../../include/linux/if_vlan.h: VLAN_HLEN
+ * extract ../../include/linux/slab.h: kmem_cache_t
+ * extract ../../include/linux/skbuff.h: MAX_SKB_FRAGS enum SKB_GSO_TCPV4 skb_frag_t struct skb_frag_struct struct skb_shared_info struct sk_buff skb_shinfo skb_is_gso
+ * extract ../../include/linux/netdevice.h: NETIF_F_GSO_SHIFT NETIF_F_TSO NETIF_F_TSO6 netdev_get_tx_queue
+ * extract ../vmware/linux_net.c: netdev_pkt_inet_proto netdev_pkt_needs_sw_gso netdev_tx_sw_gso skb_gso_segment
+ */
+
+#include <errno.h>
+
+#include "stubs.h"
+
+#define ROUNDS          200000
+#define MAX_LIST        16
+#define MAX_SEGS        8
+#define MAX_PKTS        (MAX_LIST * (MAX_SEGS + 1))
+
+struct sk_buff;
+
+struct netdev_queue {
+   int index;
+};
+
+struct net_device {
+   char name[16];
+   unsigned long features;
+   struct netdev_queue *_tx;
+};
+
+/* what the extracted code calls, defined below */
+static void *vmk_PktFrameMappedPointerGet(vmk_PktHandle *pkt);
+static vmk_uint32 vmk_PktFrameMappedLenGet(vmk_PktHandle *pkt);
+static vmk_uint32 vmk_PktFrameLenGet(vmk_PktHandle *pkt);
+static vmk_Bool vmk_PktIsLargeTcpPacket(vmk_PktHandle *pkt);
+static void vmk_PktRelease(vmk_PktHandle *pkt);
+static void vmk_PktListReleasePkts(vmk_PktList *list);
+static VMK_ReturnStatus vmk_PktTcpSegmentation(vmk_PktHandle *pkt,
+                                               vmk_PktList *segList);
+static VMK_ReturnStatus map_pkt_to_skb(struct net_device *dev,
+                                       struct netdev_queue *queue,
+                                       vmk_PktHandle *pkt,
+                                       struct sk_buff **pskb);
+static void dev_kfree_skb_any(struct sk_buff *skb);
+
+#include "tx_sw_gso_test.inc"
+
+/*
+ * A packet. A segment points at the frame it was cut from; nSegs and
+ * failAt (1 based, 0 never) tell the stub segmenter what to do with a
+ * frame.
+ */
+struct test_pkt {
+   vmk_PktHandle handle;
+   unsigned char frame[ETH_HLEN + 3 * VLAN_HLEN + 2];
+   unsigned int frameLen;
+   unsigned int mappedLen;
+   int large;
+   unsigned int nSegs;
+   unsigned int failAt;
+   struct test_pkt *parent;
+   unsigned int seg;
+   int released;
+   int inUse;
+};
+
+static struct test_pkt pkts[MAX_PKTS];
+static unsigned int isLargeCalls;
+static unsigned int segCalls;
+static unsigned int mapFailAt;  /* map_pkt_to_skb() fails on this call */
+static unsigned int mapCalls;
+static unsigned int skbsFreed;
+
+static struct test_pkt *
+pkt_new(void)
+{
+   unsigned int i;
+
+   for (i = 0; i < MAX_PKTS; i++) {
+      if (!pkts[i].inUse) {
+         memset(&pkts[i], 0, sizeof(pkts[i]));
+         pkts[i].inUse = 1;
+         return &pkts[i];
+      }
+   }
+   VMK_ASSERT(0);
+   return NULL;
+}
+
+#define TP(pkt)         container_of(pkt, struct test_pkt, handle)
+
+static void *
+vmk_PktFrameMappedPointerGet(vmk_PktHandle *pkt)
+{
+   return TP(pkt)->frame;
+}
+
+static vmk_uint32
+vmk_PktFrameMappedLenGet(vmk_PktHandle *pkt)
+{
+   return TP(pkt)->mappedLen;
+}
+
+static vmk_uint32
+vmk_PktFrameLenGet(vmk_PktHandle *pkt)
+{
+   return TP(pkt)->frameLen;
+}
+
+static vmk_Bool
+vmk_PktIsLargeTcpPacket(vmk_PktHandle *pkt)
+{
+   isLargeCalls++;
+   return TP(pkt)->large;
+}
+
+static void
+vmk_PktRelease(vmk_PktHandle *pkt)
+{
+   struct test_pkt *tp = TP(pkt);
+
+   if (tp->released) {
+      fail("packet released twice");
+   }
+   tp->released = 1;
+}
+
+static void
+vmk_PktListReleasePkts(vmk_PktList *list)
+{
+   while (!vmk_PktListIsEmpty(list)) {
+      vmk_PktRelease(vmk_PktListPopHead(list));
+   }
+}
+
+static VMK_ReturnStatus
+vmk_PktTcpSegmentation(vmk_PktHandle *pkt, vmk_PktList *segList)
+{
+   struct test_pkt *tp = TP(pkt);
+   unsigned int i;
+
+   segCalls++;
+   if (!vmk_PktListIsEmpty(segList)) {
+      fail("segment list not empty");
+   }
+   for (i = 1; i <= tp->nSegs; i++) {
+      struct test_pkt *seg;
+
+      if (i == tp->failAt) {
+         return VMK_NO_MEMORY;
+      }
+      seg = pkt_new();
+      seg->parent = tp;
+      seg->seg = i;
+      vmk_PktListAddToTail(segList, &seg->handle);
+   }
+   return VMK_OK;
+}
+
+/* one skb per packet, with room for its shared info */
+static struct {
+   struct sk_buff skb;
+   struct skb_shared_info shinfo;
+} skbs[MAX_PKTS];
+
+static VMK_ReturnStatus
+map_pkt_to_skb(struct net_device *dev, struct netdev_queue *queue,
+               vmk_PktHandle *pkt, struct sk_buff **pskb)
+{
+   struct sk_buff *skb = &skbs[TP(pkt) - pkts].skb;
+
+   if (queue != &dev->_tx[1]) {
+      fail("segment mapped to the wrong tx queue");
+   }
+   if (++mapCalls == mapFailAt) {
+      return VMK_NO_MEMORY;
+   }
+   memset(skb, 0, sizeof(skbs[0]));
+   skb->pkt = pkt;
+   skb->dev = dev;
+   *pskb = skb;
+   return VMK_OK;
+}
+
+static void
+dev_kfree_skb_any(struct sk_buff *skb)
+{
+   if (skb->next != NULL) {
+      fail("skb freed while still chained");
+   }
+   vmk_PktRelease(skb->pkt);
+   skbsFreed++;
+}
+
+static unsigned int seed = 1;
+
+static unsigned int
+rnd(unsigned int n)
+{
+   return rand_r(&seed) % n;
+}
+
+/*
+ * A random frame. Returns the ethertype behind its tags, 0 if it is not
+ * mapped.
+ */
+static unsigned short
+make_frame(struct test_pkt *tp)
+{
+   static const unsigned short types[] = { ETH_P_IP, ETH_P_IPV6, ETH_P_ARP };
+   unsigned int tags = rnd(4);
+   unsigned int off = offsetof(struct ethhdr, h_proto);
+   unsigned short type = types[rnd(ARRAY_SIZE(types))];
+   unsigned int i;
+
+   memset(tp->frame, 0xee, sizeof(tp->frame));
+   for (i = 0; i < tags; i++) {
+      *(unsigned short *) (tp->frame + off) = htons(ETH_P_8021Q);
+      off += VLAN_HLEN;
+   }
+   *(unsigned short *) (tp->frame + off) = htons(type);
+   off += 2;
+
+   tp->frameLen = 1514 + rnd(64 * 1024);
+   tp->mappedLen = sizeof(tp->frame);
+   if (rnd(8) == 0) {
+      /* mapped, or long, only part of the way to the ethertype */
+      if (rnd(2)) {
+         tp->mappedLen = rnd(off);
+      } else {
+         tp->frameLen = rnd(off);
+      }
+      return 0;
+   }
+   return type;
+}
+
+static int
+needs_gso(struct test_pkt *tp, unsigned short type, unsigned long features)
+{
+   if (!tp->large) {
+      return 0;
+   }
+   if (type == ETH_P_IP) {
+      return !(features & NETIF_F_TSO);
+   }
+   if (type == ETH_P_IPV6) {
+      return !(features & NETIF_F_TSO6);
+   }
+   return 0;
+}
+
+static void
+check_sw_gso(struct net_device *dev, unsigned int round)
+{
+   struct test_pkt *frames[MAX_LIST];
+   int needs[MAX_LIST];
+   vmk_PktList list, freeList;
+   vmk_PktHandle *pkt;
+   unsigned int n = 1 + rnd(MAX_LIST);
+   unsigned int i, s, anyNeeds = 0, expectSegCalls = 0;
+
+   memset(pkts, 0, sizeof(pkts));
+   vmk_PktListInit(&list);
+   vmk_PktListInit(&freeList);
+   for (i = 0; i < n; i++) {
+      struct test_pkt *tp = pkt_new();
+      unsigned short type;
+
+      tp->large = rnd(3) == 0;
+      type = make_frame(tp);
+      tp->nSegs = 1 + rnd(MAX_SEGS);
+      tp->failAt = rnd(16) == 0 ? 1 + rnd(tp->nSegs) : 0;
+      needs[i] = needs_gso(tp, type, dev->features);
+      if (needs[i] != netdev_pkt_needs_sw_gso(dev, &tp->handle)) {
+         fail("round %u: frame %u classified wrong", round, i);
+      }
+      anyNeeds |= needs[i];
+      expectSegCalls += needs[i];
+      frames[i] = tp;
+      vmk_PktListAddToTail(&list, &tp->handle);
+   }
+
+   isLargeCalls = 0;
+   segCalls = 0;
+   netdev_tx_sw_gso(dev, &list, &freeList);
+
+   if (!anyNeeds && isLargeCalls != n) {
+      fail("round %u: list without a frame to segment walked %u times "
+           "for %u frames", round, isLargeCalls, n);
+   }
+   if (segCalls != expectSegCalls) {
+      fail("round %u: %u frames segmented, expected %u", round, segCalls,
+           expectSegCalls);
+   }
+
+   for (i = 0; i < n; i++) {
+      struct test_pkt *tp = frames[i];
+
+      if (!needs[i]) {
+         pkt = vmk_PktListIsEmpty(&list) ? NULL : vmk_PktListPopHead(&list);
+         if (pkt != &tp->handle) {
+            fail("round %u: frame %u not passed through in order", round, i);
+            return;
+         }
+         if (tp->released) {
+            fail("round %u: passed through frame released", round);
+         }
+         continue;
+      }
+      if (tp->failAt) {
+         pkt = vmk_PktListIsEmpty(&freeList) ?
+                  NULL : vmk_PktListPopHead(&freeList);
+         if (pkt != &tp->handle || tp->released) {
+            fail("round %u: frame %u failed to segment, not freed", round, i);
+            return;
+         }
+         for (s = 0; s < MAX_PKTS; s++) {
+            if (pkts[s].parent == tp && !pkts[s].released) {
+               fail("round %u: partial segment not released", round);
+            }
+         }
+         continue;
+      }
+      if (!tp->released) {
+         fail("round %u: segmented frame %u not released", round, i);
+      }
+      for (s = 1; s <= tp->nSegs; s++) {
+         struct test_pkt *seg;
+
+         pkt = vmk_PktListIsEmpty(&list) ? NULL : vmk_PktListPopHead(&list);
+         seg = pkt != NULL ? TP(pkt) : NULL;
+         if (seg == NULL || seg->parent != tp || seg->seg != s ||
+             seg->released) {
+            fail("round %u: segment %u of frame %u out of place", round, s,
+                 i);
+            return;
+         }
+      }
+   }
+   if (!vmk_PktListIsEmpty(&list) || !vmk_PktListIsEmpty(&freeList)) {
+      fail("round %u: packets left over", round);
+   }
+}
+
+static void
+check_gso_segment(struct net_device *dev)
+{
+   struct sk_buff *skb, *segs, *seg;
+   struct test_pkt *tp;
+   unsigned int i, n, failAt;
+
+   for (failAt = 0; failAt <= MAX_SEGS; failAt++) {
+      memset(pkts, 0, sizeof(pkts));
+      tp = pkt_new();
+      tp->large = 1;
+      tp->nSegs = MAX_SEGS;
+      skb = &skbs[tp - pkts].skb;
+      memset(skb, 0, sizeof(skbs[0]));
+      skb->pkt = &tp->handle;
+      skb->dev = dev;
+      skb->queue_mapping = 1;
+
+      segs = skb_gso_segment(skb, 0);
+      if (PTR_ERR(segs) != -EINVAL) {
+         fail("skb without gso_size segmented");
+      }
+
+      skb_shinfo(skb)->gso_size = 1448;
+      mapCalls = 0;
+      mapFailAt = failAt;
+      skbsFreed = 0;
+      segs = skb_gso_segment(skb, 0);
+      if (tp->released) {
+         fail("skb_gso_segment released the TSO packet");
+      }
+
+      if (failAt != 0) {
+         if (PTR_ERR(segs) != -ENOMEM) {
+            fail("failure to map segment %u not reported", failAt);
+         }
+         if (skbsFreed != failAt - 1) {
+            fail("%u skbs freed after failing at segment %u", skbsFreed,
+                 failAt);
+         }
+         for (i = 0; i < MAX_PKTS; i++) {
+            if (pkts[i].parent == tp && !pkts[i].released) {
+               fail("segment left over after failing at segment %u",
+                    failAt);
+               break;
+            }
+         }
+         continue;
+      }
+
+      if (IS_ERR(segs)) {
+         fail("skb_gso_segment failed");
+         continue;
+      }
+      for (n = 0, seg = segs; seg != NULL; seg = seg->next) {
+         struct test_pkt *sp = TP(seg->pkt);
+
+         if (sp->parent != tp || sp->seg != ++n) {
+            fail("skb for segment %u out of place", n);
+            break;
+         }
+      }
+      if (n != MAX_SEGS) {
+         fail("%u skbs for %u segments", n, MAX_SEGS);
+      }
+   }
+}
+
+int
+main(void)
+{
+   static const unsigned long features[] = {
+      0, NETIF_F_TSO, NETIF_F_TSO6, NETIF_F_TSO | NETIF_F_TSO6,
+   };
+   struct netdev_queue txq[2] = { { 0 }, { 1 } };
+   struct net_device dev;
+   unsigned int round;
+
+   memset(&dev, 0, sizeof(dev));
+   strcpy(dev.name, "vmnic0");
+   dev._tx = txq;
+
+   for (round = 0; round < ROUNDS; round++) {
+      dev.features = features[round % ARRAY_SIZE(features)];
+      check_sw_gso(&dev, round);
+      if (failures) {
+         break;
+      }
+   }
+   check_gso_segment(&dev);
+
+   if (failures) {
+      fprintf(stderr, "tx_sw_gso_test: %d failures\n", failures);
+      return 1;
+   }
+   printf("tx_sw_gso_test: ok\n");
+   return 0;
+}
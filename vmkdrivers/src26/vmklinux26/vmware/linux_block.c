@@ -92,8 +92,23 @@
 #define BLOCK_DEFAULT_REVISION_STR      "1.0  "
 /* Max number of commands that can be handled in bottom half at one time */
 #define BLOCK_MAX_BH_COMMANDS          25
+/* Max number of queued requests, from the tail, looked at for a merge */
+#define BLOCK_MAX_MERGE_SCAN           8
 
 uint32_t maxCtlrCmds = MAX_CTLR_CMDS;
+
+/*
+ * While the driver has requests outstanding, new IO is held on the plugged
+ * queue so that contiguous commands can be merged.  The queue is unplugged
+ * on completion or once this many requests are waiting on it.
+ */
+static int vmklnx_block_unplug_thresh = 4;
+module_param(vmklnx_block_unplug_thresh, int, 0444);
+MODULE_PARM_DESC(vmklnx_block_unplug_thresh, "Number of queued block requests that forces an unplug while the device is busy. 0 disables plugging.");
+
+static int vmklnx_block_merge = 1;
+module_param(vmklnx_block_merge, int, 0644);
+MODULE_PARM_DESC(vmklnx_block_merge, "Merge contiguous block commands into one request (1 = enabled).");
 static vmk_Semaphore blkDrvSem;
 int *max_sectors[MAX_BLKDEV];
 static vmk_BottomHalf linuxBlockBHNum;
@@ -183,6 +198,13 @@ typedef struct LinuxBlockBuffer {
    vmk_Bool             lastOne;
    struct request       *creq;
    int                  spccmd;
+   /*
+    * Commands merged into one request are chained in bio order; the
+    * driver clears bio->bi_next as it completes, so keep our own link.
+    */
+   struct LinuxBlockBuffer *next;
+   uint32_t             numSectors;
+   int                  errors;
 } LinuxBlockBuffer;
 
 #define LINBLOCK_NORMAL_IO  0
@@ -205,14 +227,17 @@ static void vmklnx_bio_free(struct bio *bio);
 static void vmklnx_bio_fs_destructor(struct bio *bio);
 
 /*
- * add-request adds a request to the linked list.
+ * add-request adds a request to the tail of the linked list, so the
+ * driver sees requests in submission order and sequential streams keep
+ * merging at the tail.
  * queue lock is held and interrupts disabled, as we muck with the
  * request queue list.
  */
 static inline void
 add_request(request_queue_t * q, struct request * req)
 {
-   list_add(&req->queuelist, &q->queue_head);
+   list_add_tail(&req->queuelist, &q->queue_head);
+   q->nr_sorted++;
 }
 
 /*
@@ -863,6 +888,7 @@ LinuxBlockIODone(struct bio *bio, int bytes_done, int errors)
          VMKLNX_DEBUG(0, "Errors. !OK");
          llb->creq->errors++;
       }
+      llb->errors = errors;
 
       /*
        * The last buffer in a buffer chain is marked as the last one.  When
@@ -940,42 +966,81 @@ LinuxBlockBH(void *clientData)
 
          } else {
             struct request *req = llb->creq;
-            if (req && req->q && req->q->softirq_done_fn) {
+            request_queue_t *q = NULL;
+            LinuxBlockAdapter *bd = NULL;
+
+            if (req && req->q) {
+               /*
+                * end_that_request_last() may clear req->q, so grab the
+                * queue before the driver sees the request.
+                */
+               q = req->q;
                major = req->rq_disk->major;
-               LinuxBlockAdapter *bd = blockDevices[major];
-               VMKAPI_MODULE_CALL_VOID(BLOCK_GET_ID(bd), req->q->softirq_done_fn, req);
+               bd = blockDevices[major];
+            }
+            if (q && q->softirq_done_fn) {
+               VMKAPI_MODULE_CALL_VOID(BLOCK_GET_ID(bd), q->softirq_done_fn, req);
             }
 
             if (llb->spccmd == LINBLOCK_NORMAL_IO ) {
-               if (llb->creq->errors) {
-                  VMKLNX_DEBUG(0, "SCSI_HOST_TIMEOUT");
-                  hostStatus = VMK_SCSI_HOST_TIMEOUT;
-                  deviceStatus = VMK_SCSI_DEVICE_GOOD;
+               LinuxBlockBuffer *next;
+               uint32_t reqBytes;
+
+               VMK_ASSERT(req != NULL);
+               if (req->nr_sectors > 0) {
+                  reqBytes = req->nr_sectors * SECTOR_SIZE;
+               } else if (req->hard_nr_sectors > 0){
+                  reqBytes = req->hard_nr_sectors * SECTOR_SIZE;
                } else {
-                  VMKLNX_DEBUG(3, "SCSI_HOST_OK");
-                  hostStatus = VMK_SCSI_HOST_OK;
-                  deviceStatus = VMK_SCSI_DEVICE_GOOD;
-                  if (llb->creq->nr_sectors > 0) {
-                     llb->cmd->bytesXferred = 
-                        llb->creq->nr_sectors * SECTOR_SIZE;
-                  } else if (llb->creq->hard_nr_sectors > 0){
-                     llb->cmd->bytesXferred = 
-                        llb->creq->hard_nr_sectors * SECTOR_SIZE;
+                  reqBytes = (req->sector - req->hard_sector) * SECTOR_SIZE;
+               }
+
+               /*
+                * Complete every command merged into this request, in
+                * sector order, handing out the transferred bytes from
+                * the front.
+                */
+               do {
+                  next = llb->next;
+
+                  if (llb->errors) {
+                     VMKLNX_DEBUG(0, "SCSI_HOST_TIMEOUT");
+                     hostStatus = VMK_SCSI_HOST_TIMEOUT;
+                     deviceStatus = VMK_SCSI_DEVICE_GOOD;
                   } else {
-                     llb->cmd->bytesXferred = 
-                        (llb->creq->sector - llb->creq->hard_sector) * SECTOR_SIZE;
+                     VMKLNX_DEBUG(3, "SCSI_HOST_OK");
+                     hostStatus = VMK_SCSI_HOST_OK;
+                     deviceStatus = VMK_SCSI_DEVICE_GOOD;
+                     llb->cmd->bytesXferred =
+                        min(llb->numSectors * SECTOR_SIZE, reqBytes);
+                     reqBytes -= llb->cmd->bytesXferred;
                   }
-               }
+
+                  /*
+                   * Call completion 
+                   */
+                  LinuxBlockCompleteCommand(llb->cmd, hostStatus, deviceStatus);
+
+                  vmklnx_bio_free(llb->lbio);
+                  VMKLinux26_Free(llb);
+                  llb = next;
+               } while (llb != NULL);
 
                /*
-                * Call completion 
+                * The driver has a free slot now; let it have whatever
+                * was held on the plugged queue meanwhile.
                 */
-               LinuxBlockCompleteCommand(llb->cmd, hostStatus, deviceStatus);
+               if (q) {
+                  spin_lock_irq(q->queue_lock);
+                  q->nr_pending--;
+                  if (blk_queue_plugged(q) && q->nr_sorted > 0) {
+                     q->nr_unplug_done++;
+                     __generic_unplug_device(q, bd);
+                  }
+                  spin_unlock_irq(q->queue_lock);
+               }
 
-               VMK_ASSERT(llb->creq != NULL);
-               VMKLinux26_Free(llb->creq);
-               vmklnx_bio_free(llb->lbio);
-               VMKLinux26_Free(llb);
+               VMKLinux26_Free(req);
             } else {
                VMKLNX_DEBUG(6, "Core Dump");
             }
@@ -999,6 +1064,96 @@ bio_hw_segments(request_queue_t *q, struct bio *bio)
    return bio->bi_hw_segments;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * LinuxBlockMergeBio --
+ *
+ *      Try to merge a new single-bio command into one of the last few
+ *      requests still waiting on the queue.  The bio is appended when it
+ *      starts where a request ends (back merge) and prepended when it
+ *      ends where a request starts (front merge), as long as the merged
+ *      request stays within the queue's sector and segment limits.
+ *      Requests the driver has already looked at are never touched.
+ *
+ *      Must be called with the queue lock held.
+ *
+ * Results:
+ *      The request the bio was merged into, or NULL.
+ *
+ * Side effects:
+ *      The request's bio and LinuxBlockBuffer chains grow by one and
+ *      b->creq is pointed at it.
+ *
+ *----------------------------------------------------------------------
+ */
+static struct request *
+LinuxBlockMergeBio(request_queue_t *q,
+                   struct bio *bio,
+                   LinuxBlockBuffer *b,
+                   uint32_t sectorNumber,
+                   uint32_t numSectors,
+                   int isRead)
+{
+   struct list_head *entry;
+   struct request *rq;
+   LinuxBlockBuffer *llb;
+   int scanned = 0;
+
+   if (!vmklnx_block_merge || q->max_sectors == 0) {
+      return NULL;
+   }
+
+   list_for_each_prev(entry, &q->queue_head) {
+      if (scanned++ == BLOCK_MAX_MERGE_SCAN) {
+         break;
+      }
+
+      rq = list_entry_rq(entry);
+      if ((rq->flags & RQ_NOMERGE_FLAGS) ||
+          rq->bio->bi_end_io != (bio_end_io_t *)LinuxBlockIODone ||
+          rq->rq_disk != bio->bi_bdev->bd_disk ||
+          rq_data_dir(rq) != (isRead ? READ : WRITE)) {
+         continue;
+      }
+
+      if (rq->nr_sectors + numSectors > q->max_sectors ||
+          rq->nr_phys_segments + bio_phys_segments(q, bio) >
+             q->max_phys_segments ||
+          rq->nr_hw_segments + bio_hw_segments(q, bio) >
+             q->max_hw_segments) {
+         continue;
+      }
+
+      if (rq->sector + rq->nr_sectors == sectorNumber) {
+         llb = (LinuxBlockBuffer *) rq->biotail->bi_private;
+         llb->next = b;
+         rq->biotail->bi_next = bio;
+         rq->biotail = bio;
+         q->nr_back_merges++;
+      } else if (sectorNumber + numSectors == rq->sector) {
+         b->next = (LinuxBlockBuffer *) rq->bio->bi_private;
+         bio->bi_next = rq->bio;
+         rq->bio = bio;
+         rq->sector = rq->hard_sector = sectorNumber;
+         rq->current_nr_sectors = bio_cur_sectors(bio);
+         rq->hard_cur_sectors = rq->current_nr_sectors;
+         q->nr_front_merges++;
+      } else {
+         continue;
+      }
+
+      rq->nr_sectors += numSectors;
+      rq->nr_phys_segments += bio_phys_segments(q, bio);
+      rq->nr_hw_segments += bio_hw_segments(q, bio);
+      b->creq = rq;
+
+      return rq;
+   }
+
+   return NULL;
+}
+
 
 /*
  *----------------------------------------------------------------------
@@ -1019,9 +1174,10 @@ bio_hw_segments(request_queue_t *q, struct bio *bio)
  *      VMK_NO_MEMORY if memory couldn't be allocated.
  *
  * Side effects:
- *      A new command is added to the  blk_dev[dev->major].current_request
- *      list.  The ref count is incremented on the async IO token
- *      referred to by rid->token.
+ *      The command is merged into a queued request or a new request is
+ *      added to the tail of the queue.  The queue is unplugged right away
+ *      when the driver has nothing outstanding, and otherwise left plugged
+ *      until a completion or vmklnx_block_unplug_thresh queued requests.
  *
  *----------------------------------------------------------------------
  */
@@ -1159,9 +1315,19 @@ LinuxBlockIssueCmd(LinuxBlockAdapter *dev,
    b->lastOne = VMK_TRUE; // for now, always the last one
    b->spccmd = LINBLOCK_NORMAL_IO; // basic i/o
    b->cmd = cmd;
+   b->numSectors = numSectors;
+
+   bio_get(bio); // don't let driver free
 
    spin_lock_irq(queue->queue_lock);
 
+   queue->nr_bios++;
+   if (LinuxBlockMergeBio(queue, bio, b, sectorNumber, numSectors, isRead)) {
+      VMKLNX_DEBUG(5, "Merged sector %d into request %p for major %d",
+                   sectorNumber, b->creq, dev->major);
+      goto unplug;
+   }
+
    creq->rq_status = RQ_ACTIVE;
    creq->bio = creq->biotail = bio;
    creq->sector = sectorNumber;
@@ -1179,18 +1345,34 @@ LinuxBlockIssueCmd(LinuxBlockAdapter *dev,
    creq->queuelist = queue->queue_head;
    creq->flags |= (isRead ? READ : WRITE);
 
-   bio_get(bio); // don't let driver free
-   
    blk_plug_device(queue);
    add_request(queue, creq);
+   queue->nr_pending++;
+   creq = NULL;
 
-   VMKLNX_DEBUG(5, "Appended request %p to major %d", creq, dev->major);
+   VMKLNX_DEBUG(5, "Appended request %p to major %d", b->creq, dev->major);
+
+unplug:
+   /*
+    * Merging only pays while the driver is busy: an idle device gets
+    * the IO at once, a busy one once enough requests have piled up or
+    * when LinuxBlockBH() completes one of its requests.
+    */
+   if (queue->nr_pending <= queue->nr_sorted) {
+      VMKLNX_DEBUG(2, "Unplug the idle Queue here");
+      queue->nr_unplug_idle++;
+      __generic_unplug_device(queue, dev);
+   } else if (queue->nr_sorted >= queue->unplug_thresh) {
+      VMKLNX_DEBUG(2, "Unplug the Queue at %d requests", queue->nr_sorted);
+      queue->nr_unplug_thresh++;
+      __generic_unplug_device(queue, dev);
+   }
 
    spin_unlock_irq(queue->queue_lock);
 
-   if (1 || bio_sync(bio)) {
-      VMKLNX_DEBUG(2, "Unplug the Queue here");
-      generic_unplug_device(queue, dev);
+   if (creq != NULL) {
+      /* merged, the preallocated request went unused */
+      VMKLinux26_Free(creq);
    }
 
    return VMK_OK;
@@ -1679,7 +1861,7 @@ LinuxBlockDumpCommand(void *clientData, vmk_ScsiCommand *cmd,
    creq->nr_hw_segments = bio_hw_segments(queue, bio);
    creq->current_nr_sectors = cmd->sgArray->elem[0].length / SECTOR_SIZE;
    creq->hard_cur_sectors = creq->current_nr_sectors;
-   creq->flags |= WRITE;
+   creq->flags |= WRITE | REQ_NOMERGE;
    creq->errors = 0;
    creq->rq_disk = bio->bi_bdev->bd_disk;
    creq->waiting = NULL;
@@ -1860,7 +2042,7 @@ LinuxBlockClose(void *clientData)
  *
  * LinuxBlockDumpQueue --
  *
- *      Stub for Linux block command queue dumping.
+ *      Log the merge and plug statistics of each disk's request queue.
  *
  * Results:
  *      None.
@@ -1873,6 +2055,27 @@ LinuxBlockClose(void *clientData)
 static void
 LinuxBlockDumpQueue(void *clientData)
 {
+   LinuxBlockAdapter *dev = (LinuxBlockAdapter *)clientData;
+   request_queue_t *q;
+   int i;
+
+   for (i = 0; i < dev->maxDisks; i++) {
+      if (!dev->disks[i].exists || dev->disks[i].gd == NULL) {
+         continue;
+      }
+      q = dev->disks[i].gd->queue;
+      if (q == NULL) {
+         continue;
+      }
+
+      VMKLNX_INFO("%s: target %d: %u pending, %u queued, %lu bios, "
+                  "%lu back merges, %lu front merges, "
+                  "unplugs: %lu idle, %lu threshold, %lu completion",
+                  dev->devName, dev->disks[i].targetId,
+                  q->nr_pending, q->nr_sorted, q->nr_bios,
+                  q->nr_back_merges, q->nr_front_merges,
+                  q->nr_unplug_idle, q->nr_unplug_thresh, q->nr_unplug_done);
+   }
 }
 
 /**
@@ -2597,6 +2800,7 @@ blk_init_queue_node(request_fn_proc *rfn, spinlock_t *lock, int node_id)
    q->queue_flags          = (1 << QUEUE_FLAG_CLUSTER);
    q->queue_lock           = lock;
    q->make_request_fn      = NULL;
+   q->unplug_thresh        = vmklnx_block_unplug_thresh;
 
    blk_queue_segment_boundary(q, 0xffffffff);
    blk_queue_max_segment_size(q, MAX_SEGMENT_SIZE);
@@ -2632,6 +2836,12 @@ elv_next_request(request_queue_t *q)
    }
 
    rq = list_entry_rq(q->queue_head.next);
+
+   /*
+    * The driver may already be building a command from it, so keep
+    * LinuxBlockMergeBio() away.
+    */
+   rq->flags |= REQ_STARTED;
    return rq;
 }
 
@@ -2641,6 +2851,7 @@ elv_dequeue_request(request_queue_t *q, struct request *rq)
    VMK_ASSERT(!list_empty(&rq->queuelist));
 
    list_del_init(&rq->queuelist);
+   q->nr_sorted--;
 
    if(blk_account_rq(rq)) {
       q->in_flight++;
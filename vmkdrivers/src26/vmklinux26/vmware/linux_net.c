@@ -52,10 +52,16 @@
 #include <linux/if_vlan.h>
 #include <linux/in.h>
 #include <linux/ip.h>
+#include <linux/ipv6.h>
 #include <linux/tcp.h>
+#include <linux/jhash.h>
+#include <linux/random.h>
+#include <net/ip.h> /* IP_MF, IP_OFFSET */
 #include <linux/ethtool.h>
 #include <linux/rtnetlink.h> /* BUG_TRAP */
 #include <linux/workqueue.h>
+#include <linux/proc_fs.h>
+#include <linux/compat.h>
 #include <asm/uaccess.h>
 #include <asm/page.h> /* phys_to_page */
 
@@ -73,9 +79,26 @@
 #define WATCHDOG_DEF_TIMEO 5 * HZ
 #define WATCHDOG_DEF_TIMER 1000
 
-/* defined NAPI related thresholds */
+/* 
+ * defined NAPI related thresholds. The push thresholds of a napi context
+ * start at these values and then adapt, see napi_push_adapt().
+ */
 #define NAPI_STACK_PUSH_WORK_MIN 2
 #define NAPI_STACK_SKIP_PUSH_MAX 3
+#define NAPI_STACK_SKIP_PUSH_LIMIT 16
+/* napi_struct rx_rate fixed point shift and moving average weight */
+#define NAPI_RX_RATE_SHIFT 4
+#define NAPI_EWMA_SHIFT    3
+
+/* upper bound on the number of packets sent per _xmit_lock hold */
+#define NETDEV_TX_BURST_MAX 32
+/* times a tx staging ring owner goes back for more before punting */
+#define NETDEV_TX_STAGE_ROUNDS 4
+
+/* skbs the rx completion handler gathers before freeing them at once */
+#define NETDEV_SKB_FREE_BATCH 32
+/* tx queues the flow hash spreads traffic without a netqueue over */
+#define NETDEV_TX_HASH_QUEUES 16
 /* 
  * this value starts at 0x10000 as we don't want to collide with
  * the genCount used by vNICs port.
@@ -104,8 +127,18 @@ typedef enum {
  *       Instead, embed them in net_device, where they are next to
  *       their cache line brethrens.
  */ 
+/* a napi worldlet of a device, kept for its next napi context when freed */
+struct napi_pool_wdt {
+   struct list_head     list;
+   vmk_Worldlet         worldlet;
+   struct napi_wdt_priv priv;    /* priv.napi is NULL while it is free */
+   int                  id;
+};
+
 struct LinNetDev {
    unsigned int       napiNextId; /* Next unique id for napi context. */
+   struct list_head   napiPool;   /* Worldlet pool, under napi_lock. */
+   unsigned int       napiPoolSize;
    unsigned short     padded;     /* Padding added by alloc_netdev() */
    struct net_device  linNetDev __attribute__((aligned(NETDEV_ALIGN)));
    /* 
@@ -140,8 +173,6 @@ struct net_device    *dev_base = NULL;
 DEFINE_RWLOCK(dev_base_lock);
 struct softnet_data  softnet_data[NR_CPUS] __cacheline_aligned;
 int                  netdev_max_backlog = 300;
-static const unsigned eth_crc32_poly_le = 0xedb88320;
-static unsigned      eth_crc32_poly_tbl_le[256];
 static uint64_t max_phys_addr;
 
 static vmk_ConfigParamHandle useHwIPv6CsumHandle;
@@ -154,6 +185,9 @@ static kmem_cache_t *vmklnx_skb_cache = NULL;
 /* The global generated counter for packet completion */
 static vmk_PktCompletionData globalGenCount;
 
+/* Random seed of the tx flow hash */
+static u32 txFlowHashSeed;
+
 /* Stress option handles */
 static vmk_StressOptionHandle stressNetGenTinyArpRarp;
 static vmk_StressOptionHandle stressNetIfCorruptEthHdr;
@@ -174,6 +208,60 @@ static vmk_ConfigParamHandle vmklnxLROMaxAggrConfigHandle;
 unsigned int vmklnxLROEnabled;
 unsigned int vmklnxLROMaxAggr;
 
+/* Bounds of the adaptive napi stack push batching */
+static int vmklnx_napi_push_latency_us = 100;
+module_param(vmklnx_napi_push_latency_us, int, 0444);
+MODULE_PARM_DESC(vmklnx_napi_push_latency_us, "Max time in us received packets may be held back to batch stack pushes.");
+
+static int vmklnx_napi_push_batch_max = 64;
+module_param(vmklnx_napi_push_batch_max, int, 0444);
+MODULE_PARM_DESC(vmklnx_napi_push_batch_max, "Max number of packets a napi context waits for before pushing them up the stack.");
+
+static vmk_TimerRelCycles napiPushLatencyTC;
+static struct proc_dir_entry *napiProcEntry;
+
+/* Deferred flush of the vmklinux lro sessions */
+static int vmklnx_lro_flush_idle_us = 50;
+module_param(vmklnx_lro_flush_idle_us, int, 0444);
+MODULE_PARM_DESC(vmklnx_lro_flush_idle_us, "Time in us an lro session may stay open across napi polls without new segments (0 flushes after every poll).");
+
+static int vmklnx_lro_session_bytes = 0;
+module_param(vmklnx_lro_session_bytes, int, 0444);
+MODULE_PARM_DESC(vmklnx_lro_session_bytes, "Size in bytes at which an lro session is flushed (0 for as much as fits an IP packet).");
+
+static vmk_TimerRelCycles lroFlushIdleTC;
+static struct proc_dir_entry *lroProcEntry;
+
+/* Tx burst size for process_tx_queue */
+static int vmklnx_tx_burst = NETDEV_TX_BURST_MAX;
+module_param(vmklnx_tx_burst, int, 0444);
+MODULE_PARM_DESC(vmklnx_tx_burst, "Max packets handed to a driver per tx lock hold (1 disables batching).");
+
+/* Lock-free staging of tx packets in front of the soft queue lock */
+static int vmklnx_tx_stage = 0;
+module_param(vmklnx_tx_stage, int, 0444);
+MODULE_PARM_DESC(vmklnx_tx_stage, "Stage tx packets in a lock-free ring instead of taking the soft queue lock on every transmit (0 disables).");
+
+/* Low memory bounce buffers for drivers with a limited dma range */
+static int vmklnx_high_dma_bounce_slots = 64;
+module_param(vmklnx_high_dma_bounce_slots, int, 0444);
+MODULE_PARM_DESC(vmklnx_high_dma_bounce_slots, "Number of preallocated low memory tx bounce buffers per tx queue of a device with a limited dma mask (0 disables).");
+
+/* Upper bound of the memory behind one rx page pool */
+static int vmklnx_rx_page_pool_kb = 1024;
+module_param(vmklnx_rx_page_pool_kb, int, 0444);
+MODULE_PARM_DESC(vmklnx_rx_page_pool_kb, "Max size in KB of the recycled, premapped page pool of one rx ring (0 disables the pools).");
+
+/* Spread traffic without a netqueue over all tx queues by flow hash */
+static int vmklnx_tx_flow_hash = 1;
+module_param(vmklnx_tx_flow_hash, int, 0644);
+MODULE_PARM_DESC(vmklnx_tx_flow_hash, "Spread tx traffic that is not steered to a netqueue over the tx queues of a multiqueue device by a hash of its flow (0 sends it all to queue 0).");
+
+/* Lifetime of the driver statistics snapshot served to the uplink */
+static int vmklnx_stats_cache_ms = 1000;
+module_param(vmklnx_stats_cache_ms, int, 0644);
+MODULE_PARM_DESC(vmklnx_stats_cache_ms, "Time in ms driver statistics are cached between queries (0 asks the driver every time).");
+
 extern void LinStress_SetupStress(void);
 extern void LinStress_CleanupStress(void);
 extern void LinStress_CorruptSkbData(struct sk_buff*, unsigned int,
@@ -186,7 +274,8 @@ static VMK_ReturnStatus map_pkt_to_skb(struct net_device *dev,
                                        vmk_PktHandle *pkt, 
                                        struct sk_buff **pskb);
 static void do_free_skb(struct sk_buff *skb);
-static struct sk_buff *do_alloc_skb(kmem_cache_t *skb);
+static void do_free_skb_bulk(struct sk_buff **skbs, int count);
+static struct sk_buff *do_alloc_skb(kmem_cache_t *cache);
 static VMK_ReturnStatus BlockNetDev(void *clientData);
 static void SetNICLinkStatus(struct net_device *dev);
 
@@ -197,1150 +286,3121 @@ static inline u16
 get_embedded_queue_mapping(vmknetddi_queueops_queueid_t queueid);
 
 /*
- * Section: Receive path
+ * Section: Per-queue statistics
  */
 
 /*
  *----------------------------------------------------------------------------
  *
- *  netif_rx_common --
+ *  netdev_rx_stats_get --
  *
- *    Common receive path from napi and non-napi packet reception. Hands
- *    off received packet up the stack.
+ *    Counters of rx queue qid on the current PCPU. Packets that carry no
+ *    netqueue id are accounted to the default queue. Interrupts stay
+ *    disabled until netdev_stats_put(), so the world can't migrate to
+ *    another PCPU and race with that PCPU's writer. That costs more than
+ *    the counting itself, so the data path takes the counters once per
+ *    stack push or driver burst rather than once per packet.
  *
  *  Results:
- *    NET_RX_SUCCESS on sccesss; NET_RX_DROP if the packet is dropped.
+ *    Pointer to the counters.
  *
  *  Side effects:
- *    Drops packet on the floor if unsuccessful.
+ *    Disables interrupts, saving the previous state in flags.
  *
  *----------------------------------------------------------------------------
  */
-static int
-netif_rx_common(struct sk_buff *skb)
+static inline struct netdev_queue_stats *
+netdev_rx_stats_get(struct net_device *dev, vmknetddi_queueops_queueid_t qid,
+                    unsigned long *flags)
 {
-   vmk_PktHandle *pkt;
-   struct net_device *dev = skb->dev;
-   vmk_Bool needCompl = VMK_FALSE;
-
-   if (unlikely(skb->len == 0)) {
-      static uint32_t logThrottleCounter = 0;
-      VMKLNX_THROTTLED_INFO(logThrottleCounter,
-                            "dropping zero length packet "
-                            "(skb->len=%u, skb->data_len=%u)\n",
-                            skb->len, skb->data_len);
-      goto drop;
-   }
+   int slot = 0;
 
-   /* we need to ensure the blocked status */
-   if (unlikely(test_bit(__LINK_STATE_BLOCKED, &dev->state))) {
-      goto drop;
+   if (VMKNETDDI_QUEUEOPS_IS_RX_QUEUEID(qid)) {
+      slot = min_t(int, VMKNETDDI_QUEUEOPS_QUEUEID_VAL(qid),
+                   NETDEV_STATS_RX_QUEUES - 1);
    }
-   atomic_inc(&dev->rxInFlight);
+   local_irq_save(*flags);
+   return &dev->linnet_stats[smp_processor_id()][slot];
+}
 
-   pkt = skb->pkt;
-   vmk_PktAdjust(pkt, skb_headroom(skb), skb_headlen(skb));
-   
-   if (skb_shinfo(skb)->frag_list != NULL) {
-      VMK_ReturnStatus status = VMK_OK;
-      struct sk_buff *frag_skb = skb_shinfo(skb)->frag_list;
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_tx_stats_get --
+ *
+ *    Counters of a tx queue on the current PCPU, see netdev_rx_stats_get.
+ *
+ *  Results:
+ *    Pointer to the counters.
+ *
+ *  Side effects:
+ *    Disables interrupts, saving the previous state in flags.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline struct netdev_queue_stats *
+netdev_tx_stats_get(struct netdev_queue *queue, unsigned long *flags)
+{
+   struct net_device *dev = queue->dev;
 
-      while (frag_skb) {
-         status = vmk_PktAppend(pkt, frag_skb->pkt,
-                                skb_headroom(frag_skb), skb_headlen(frag_skb));
-         if (status != VMK_OK) {
-            goto drop_dec_rx_inflight;
-         }
-         frag_skb = frag_skb->next;
-      }
-      
-      vmk_PktSetCompletionData(pkt, skb, dev->genCount, VMK_TRUE);
-      needCompl = VMK_TRUE;
-   }
-   
-   if (unlikely(vmk_PktFrameLenSet(pkt, skb->len) != VMK_OK)) {
-      printk("unable to set skb->pkt %p frame length with skb->len = %u\n", 
-             pkt, skb->len);
-      VMK_ASSERT(VMK_FALSE);
-      goto drop_dec_rx_inflight;
-   }
-   
-   /*
-    * The following extracts vlan tag from skb.
-    * The check just looks at a field of skb, so we
-    * don't bother to check whether vlan is enabled.
-    */
-   if (vlan_rx_tag_present(skb)) {
-      VMK_ASSERT(vmk_PktVlanIDGet(pkt) == 0);
+   local_irq_save(*flags);
+   return &dev->linnet_stats[smp_processor_id()]
+                            [NETDEV_STATS_RX_QUEUES + (queue - dev->_tx)];
+}
 
-      if  ((vlan_rx_tag_get(skb) & VLAN_VID_MASK) > VLAN_MAX_VALID_VID) {
-         static uint32_t logThrottleCounter = 0;
-         VMKLNX_THROTTLED_INFO(logThrottleCounter,
-                               "invalid vlan tag: %d dropped",
-                               vlan_rx_tag_get(skb) & VLAN_VID_MASK);
-         goto drop_dec_rx_inflight;
-      }
-      vmk_PktVlanIDSet(pkt, vlan_rx_tag_get(skb) & VLAN_VID_MASK);
-      vmk_PktPrioritySet(pkt,
-                         (vlan_rx_tag_get(skb) & VLAN_1PTAG_MASK) >> VLAN_1PTAG_SHIFT);
-      VMKLNX_DEBUG(2, "%s: vlan tag %u present with priority %u",
-                   dev->name, vmk_PktVlanIDGet(pkt), vmk_PktPriorityGet(pkt));
+static inline void
+netdev_stats_put(unsigned long flags)
+{
+   local_irq_restore(flags);
+}
 
-#ifdef VMX86_DEBUG
-      {
-         // generate arp/rarp frames that are < ETH_MIN_FRAME_LEN to
-         // create test cases for PR 106153.
-	 struct ethhdr *eh = (struct ethhdr *)vmk_PktFrameMappedPointerGet(pkt);
-                    
-         if ((eh->h_proto == ntohs(ETH_P_ARP)
-	      || eh->h_proto == ntohs(ETH_P_RARP))
-	     && VMKLNX_STRESS_DEBUG_COUNTER(stressNetGenTinyArpRarp)) {
-            int old_frameMappedLen;
-            int target_len = (ETH_ZLEN - VLAN_HLEN);
+static inline void
+netdev_rx_stats_drop(struct net_device *dev, vmknetddi_queueops_queueid_t qid,
+                     enum netdev_drop_reason reason)
+{
+   unsigned long flags;
 
-	    old_frameMappedLen = vmk_PktFrameMappedLenGet(pkt);
+   netdev_rx_stats_get(dev, qid, &flags)->dropped[reason]++;
+   netdev_stats_put(flags);
+}
 
-            if (target_len <= old_frameMappedLen) {
-               int old_len;
-	       int len;
+static inline void
+netdev_tx_stats_drop(struct netdev_queue *queue,
+                     enum netdev_drop_reason reason, vmk_uint32 count)
+{
+   unsigned long flags;
 
-	       old_len = vmk_PktFrameLenGet(pkt);
-               vmk_PktFrameLenSet(pkt, target_len);
-	       len = vmk_PktFrameLenGet(pkt);
-               VMKLNX_DEBUG(1, "shorten arp/rarp pkt to %d from %d",
-                            len, old_len);
-            }
-         }
-      }
-#endif
-   }
+   netdev_tx_stats_get(queue, &flags)->dropped[reason] += count;
+   netdev_stats_put(flags);
+}
 
-   if (skb->ip_summed != CHECKSUM_NONE &&
-       !VMKLNX_STRESS_DEBUG_OPTION(stressNetIfForceRxSWCsum)) {
-      vmk_PktSetCsumVfd(pkt);
-   }
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_stats_create --
+ *
+ *    Allocate the per-PCPU queue counters of a device. Each PCPU gets its
+ *    own cache aligned block holding the rx slots followed by one slot
+ *    per tx queue, so the data path never writes a shared line.
+ *
+ *  Results:
+ *    VMK_OK or VMK_NO_MEMORY.
+ *
+ *  Side effects:
+ *    Sets dev->linnet_stats on success.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_stats_create(struct net_device *dev)
+{
+   struct netdev_queue_stats **stats;
+   size_t size;
+   int i;
 
-   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfCorruptRxTcpUdp)) {
-      LinStress_CorruptSkbData(skb, 40, 14);
+   size = (NETDEV_STATS_RX_QUEUES + dev->num_tx_queues) * sizeof(**stats);
+   stats = kzalloc(vmk_NumPCPUs() * sizeof(*stats), GFP_KERNEL);
+   if (stats == NULL) {
+      return VMK_NO_MEMORY;
    }
 
-   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfCorruptRxData)) {
-      LinStress_CorruptRxData(pkt, skb);
+   for (i = 0; i < vmk_NumPCPUs(); i++) {
+      stats[i] = vmklnx_kmalloc_align(VMK_MODULE_HEAP_ID, size,
+                                      SMP_CACHE_BYTES);
+      if (stats[i] == NULL) {
+         goto fail;
+      }
+      memset(stats[i], 0, size);
    }
 
-   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfCorruptEthHdr)) {
-      LinStress_CorruptEthHdr(skb);
-   }
+   dev->linnet_stats = stats;
+   return VMK_OK;
 
-   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfFailRx)) {
-      VMKLNX_DEBUG(2,"Failing To Queue Packet: skb = %p, "
-                   "pkt = %p, device = %s\n",
-                   skb, pkt, dev->name);
+ fail:
+   while (--i >= 0) {
+      vmklnx_kfree(VMK_MODULE_HEAP_ID, stats[i]);
    }
+   kfree(stats);
+   return VMK_NO_MEMORY;
+}
 
-   dev->linnet_rx_packets++;
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_stats_destroy --
+ *
+ *    Free the per-PCPU queue counters of a device.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Clears dev->linnet_stats.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+netdev_stats_destroy(struct net_device *dev)
+{
+   int i;
 
-   if (!needCompl) {
-      do_free_skb(skb);
-      atomic_dec(&dev->rxInFlight);
+   if (dev->linnet_stats == NULL) {
+      return;
    }
 
-   return NET_RX_SUCCESS;
-
- drop_dec_rx_inflight:
-   atomic_dec(&dev->rxInFlight);
-   if (needCompl) {
-      vmk_PktClearCompletionData(pkt);
+   for (i = 0; i < vmk_NumPCPUs(); i++) {
+      vmklnx_kfree(VMK_MODULE_HEAP_ID, dev->linnet_stats[i]);
    }
- drop:
-   dev_kfree_skb_any(skb);
-   dev->linnet_rx_dropped++;
-   return NET_RX_DROP;
+   kfree(dev->linnet_stats);
+   dev->linnet_stats = NULL;
 }
 
-/**
- * netif_rx - post buffer to the network code
- * @skb: buffer to post
+/*
+ *----------------------------------------------------------------------------
  *
- * This function receives a packet from a device driver and queues it for
- * the upper (protocol) levels to process.  It always succeeds. The buffer
- * may be dropped during processing for congestion control or by the
- * protocol layers.
+ *  netdev_stats_fold --
  *
- *  RETURN VALUE:
- *  NET_RX_SUCCESS (no congestion)
- *  NET_RX_DROP	(packet was dropped)
+ *    Add up the counters of slots [first, first + count) over all PCPUs.
+ *    Writers are not stopped, so the result is a snapshot that may lag
+ *    the data path by a few packets.
+ *
+ *  Results:
+ *    None.
  *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
  */
-/* _VMKLNX_CODECHECK_: netif_rx */
-int
-netif_rx(struct sk_buff *skb)
+static void
+netdev_stats_fold(struct net_device *dev, int first, int count,
+                  struct netdev_queue_stats *sum)
+{
+   struct netdev_queue_stats *st;
+   int cpu, slot, r;
+
+   memset(sum, 0, sizeof(*sum));
+   for (cpu = 0; cpu < vmk_NumPCPUs(); cpu++) {
+      for (slot = first; slot < first + count; slot++) {
+         st = &dev->linnet_stats[cpu][slot];
+         sum->packets += st->packets;
+         sum->bytes += st->bytes;
+         for (r = 0; r < NETDEV_DROP_REASONS; r++) {
+            sum->dropped[r] += st->dropped[r];
+         }
+         sum->batches += st->batches;
+         sum->batchPkts += st->batchPkts;
+         sum->requeued += st->requeued;
+      }
+   }
+}
+
+static inline u64
+netdev_stats_dropped(struct netdev_queue_stats *st)
 {
-   struct net_device *dev = skb->dev;
-   vmk_PktHandle *pkt;
-   int status;
+   u64 dropped = 0;
+   int r;
 
-   VMK_ASSERT(dev);
+   for (r = 0; r < NETDEV_DROP_REASONS; r++) {
+      dropped += st->dropped[r];
+   }
+   return dropped;
+}
 
-   VMKLNX_DEBUG(1, "Napi is not enabled for device %s\n", dev->name);
-   
-   pkt = skb->pkt;
-   VMK_ASSERT(pkt);
+/*
+ * Section: Driver statistics cache
+ */
 
-   status = netif_rx_common(skb);
-   if (likely(status == NET_RX_SUCCESS)) {
-      vmk_PktQueueForRxProcess(pkt, dev->uplinkDev);
-   }
+/*
+ * Snapshot of the driver statistics handed to the uplink layer. The
+ * ethtool string table is captured when the device registers and only
+ * captured again if the driver reports a different number of counters;
+ * the counters themselves are refreshed at most every
+ * vmklnx_stats_cache_ms.
+ *
+ * GetDeviceStats may be called where sleeping is not allowed, so the
+ * snapshot is guarded by a spinlock that is never held across a driver
+ * call. One caller at a time refreshes it: it asks the driver into new
+ * buffers and swaps them in under the lock. Callers that find a refresh
+ * under way serve the current snapshot.
+ */
+struct netdev_stats_cache {
+   spinlock_t               lock;         /* guards the fields below */
+   unsigned long            refreshing;   /* bit 0: a refresh is under way */
+   int                      valid;
+   unsigned long            stamp;        /* jiffies of the last refresh */
+   struct net_device_stats  st;
+   u32                      generation;   /* bumped with the string table */
+   u32                      nStats;
+   char                    *strings;      /* nStats * ETH_GSTRING_LEN */
+   u64                     *data;         /* nStats */
+   char                    *text;         /* formatted "name : value" lines */
+   int                      textLen;
+};
 
-   return status;
-}
+/* Room for one "   name : value\n" line of the formatted snapshot */
+#define NETDEV_STATS_LINE_MAX   (ETH_GSTRING_LEN + 32)
 
-/**
- * netif_receive_skb - process receive buffer from network
- * @skb: buffer to process
+/*
+ *----------------------------------------------------------------------------
  *
- * netif_receive_skb() is the main receive data processing function.
- * It always succeeds. The buffer may be dropped during processing
- * for congestion control or by the protocol layers.
+ *  netdev_stats_cache_create --
  *
- * ESX Deviation Notes:
- * This function may only be called from the napi poll callback routine.
+ *    Allocate the statistics snapshot of a device. The string table is
+ *    filled in later, once the driver has set up its ethtool ops.
+ *
+ *  Results:
+ *    VMK_OK or VMK_NO_MEMORY.
+ *
+ *  Side effects:
+ *    Sets dev->stats_cache on success.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_stats_cache_create(struct net_device *dev)
+{
+   struct netdev_stats_cache *cache;
+
+   cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+   if (cache == NULL) {
+      return VMK_NO_MEMORY;
+   }
+   spin_lock_init(&cache->lock);
+
+   dev->stats_cache = cache;
+   return VMK_OK;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_stats_cache_destroy --
+ *
+ *    Free the statistics snapshot of a device.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Clears dev->stats_cache.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+netdev_stats_cache_destroy(struct net_device *dev)
+{
+   struct netdev_stats_cache *cache = dev->stats_cache;
+
+   if (cache == NULL) {
+      return;
+   }
+
+   kfree(cache->strings);
+   kfree(cache->data);
+   kfree(cache->text);
+   kfree(cache);
+   dev->stats_cache = NULL;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_stats_count --
+ *
+ *    Ask the driver how many ethtool statistics it exports.
+ *
+ *  Results:
+ *    Number of counters, 0 if the driver has no ethtool statistics.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static u32
+netdev_stats_count(struct net_device *dev)
+{
+   struct ethtool_ops *ops = dev->ethtool_ops;
+   int count = 0;
+
+   if (!ops ||
+       !ops->get_ethtool_stats ||
+       (!ops->get_stats_count && !ops->get_sset_count) ||
+       !ops->get_strings) {
+      return 0;
+   }
+
+   if (ops->get_stats_count) {
+      /* 2.6.18 network drivers method to retrieve the number of stats */
+      VMKAPI_MODULE_CALL(dev->module_id, count, ops->get_stats_count, dev);
+   } else {
+      /* 2.6.18+ network drivers method to retrieve the number of stats */
+      VMKAPI_MODULE_CALL(dev->module_id, count, ops->get_sset_count, dev,
+                         ETH_SS_STATS);
+   }
+
+   return count > 0 ? count : 0;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_stats_strings --
+ *
+ *    Fetch the ethtool string table of a device into a new buffer.
+ *
+ *  Results:
+ *    nStats * ETH_GSTRING_LEN names, or NULL if out of memory.
+ *
+ *  Side effects:
+ *    Calls into the driver.
+ *
+ *----------------------------------------------------------------------------
+ */
+static char *
+netdev_stats_strings(struct net_device *dev, u32 nStats, gfp_t gfp)
+{
+   char *strings;
+   u32 i;
+
+   strings = kmalloc(nStats * ETH_GSTRING_LEN, gfp);
+   if (strings == NULL) {
+      return NULL;
+   }
+
+   VMKAPI_MODULE_CALL_VOID(dev->module_id, dev->ethtool_ops->get_strings, dev,
+                           ETH_SS_STATS, (vmk_uint8 *)strings);
+   for (i = 0; i < nStats; i++) {
+      strings[(i + 1) * ETH_GSTRING_LEN - 1] = '\0';
+   }
+   return strings;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_stats_cache_strings --
+ *
+ *    Capture the ethtool string table of a device into its snapshot
+ *    before the device is visible to the uplink.
+ *
+ *  Results:
+ *    VMK_OK or VMK_NO_MEMORY.
+ *
+ *  Side effects:
+ *    Calls into the driver.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_stats_cache_strings(struct net_device *dev,
+                           struct netdev_stats_cache *cache)
+{
+   u32 nStats = netdev_stats_count(dev);
+
+   if (nStats == 0) {
+      return VMK_OK;
+   }
+
+   cache->strings = netdev_stats_strings(dev, nStats, GFP_KERNEL);
+   if (cache->strings == NULL) {
+      return VMK_NO_MEMORY;
+   }
+   cache->nStats = nStats;
+   cache->generation++;
+   return VMK_OK;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_stats_cache_refresh --
+ *
+ *    Refresh the snapshot of a device if it is older than
+ *    vmklnx_stats_cache_ms. Does not sleep.
+ *
+ *  Results:
+ *    VMK_OK, or VMK_FAILURE if the driver has no statistics at all.
+ *
+ *  Side effects:
+ *    Calls into the driver.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_stats_cache_refresh(struct net_device *dev,
+                           struct netdev_stats_cache *cache)
+{
+   struct net_device_stats *st = NULL;
+   struct ethtool_stats stat;
+   char *strings = NULL, *text = NULL, *oldStrings = NULL, *oldText = NULL;
+   u64 *data = NULL, *oldData = NULL;
+   u32 nStats, i;
+   int len = 0;
+   VMK_ReturnStatus status = VMK_OK;
+
+   if (cache->valid && vmklnx_stats_cache_ms > 0 &&
+       time_before(jiffies, cache->stamp +
+                   msecs_to_jiffies(vmklnx_stats_cache_ms))) {
+      return VMK_OK;
+   }
+
+   if (test_and_set_bit(0, &cache->refreshing)) {
+      /* someone else is asking the driver; a first snapshot is worth a wait */
+      while (!cache->valid && test_bit(0, &cache->refreshing)) {
+         cpu_relax();
+      }
+      return cache->valid ? VMK_OK : VMK_FAILURE;
+   }
+
+   if (dev->get_stats) {
+      VMKAPI_MODULE_CALL(dev->module_id, st, dev->get_stats, dev);
+   }
+   if (!st) {
+      status = VMK_FAILURE;
+      goto out;
+   }
+
+   /*
+    * Only this context replaces strings, so they can be read unlocked.
+    * Some drivers export a counter set that depends on their current
+    * queue configuration, so recapture the strings when the count moves.
+    */
+   nStats = netdev_stats_count(dev);
+   if (nStats > 0) {
+      data = kmalloc(nStats * sizeof(u64), GFP_ATOMIC);
+      text = kmalloc(nStats * NETDEV_STATS_LINE_MAX + 1, GFP_ATOMIC);
+      if (nStats != cache->nStats) {
+         strings = netdev_stats_strings(dev, nStats, GFP_ATOMIC);
+      }
+      if (!data || !text || (nStats != cache->nStats && !strings)) {
+         VMKLNX_WARN("%s: unable to allocate ethtool statistics snapshot",
+                     dev->name);
+         kfree(data);
+         kfree(text);
+         kfree(strings);
+         data = NULL;
+         text = NULL;
+         strings = NULL;
+         nStats = cache->nStats;
+      } else {
+         stat.n_stats = nStats;
+         VMKAPI_MODULE_CALL_VOID(dev->module_id,
+                                 dev->ethtool_ops->get_ethtool_stats,
+                                 dev, &stat, data);
+         for (i = 0; i < nStats; i++) {
+            len += snprintf(text + len, NETDEV_STATS_LINE_MAX,
+                            "   %s : %lld\n",
+                            (strings ? strings : cache->strings) +
+                            i * ETH_GSTRING_LEN, data[i]);
+         }
+      }
+   }
+
+   spin_lock(&cache->lock);
+   cache->st = *st;
+   if (nStats != cache->nStats || strings != NULL) {
+      oldStrings = cache->strings;
+      cache->strings = strings;
+      cache->nStats = nStats;
+      cache->generation++;
+   }
+   if (data != NULL || nStats == 0) {
+      oldData = cache->data;
+      oldText = cache->text;
+      cache->data = data;
+      cache->text = text;
+      cache->textLen = len;
+   }
+   cache->stamp = jiffies;
+   cache->valid = 1;
+   spin_unlock(&cache->lock);
+
+   kfree(oldStrings);
+   kfree(oldData);
+   kfree(oldText);
+
+ out:
+   smp_mb__before_clear_bit();
+   clear_bit(0, &cache->refreshing);
+   return status;
+}
+
+/*
+ * Section: Receive path
+ */
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netif_rx_common --
+ *
+ *    Common receive path from napi and non-napi packet reception. Hands
+ *    off received packet up the stack.
+ *
+ *  Results:
+ *    NET_RX_SUCCESS on sccesss; NET_RX_DROP if the packet is dropped.
+ *
+ *  Side effects:
+ *    Drops packet on the floor if unsuccessful. The caller counts the
+ *    packets that make it.
+ *
+ *----------------------------------------------------------------------------
+ */
+static int
+netif_rx_common(struct sk_buff *skb)
+{
+   vmk_PktHandle *pkt;
+   struct net_device *dev = skb->dev;
+   vmk_Bool needCompl = VMK_FALSE;
+   enum netdev_drop_reason reason = NETDEV_DROP_INVALID;
+
+   if (unlikely(skb->len == 0)) {
+      static uint32_t logThrottleCounter = 0;
+      VMKLNX_THROTTLED_INFO(logThrottleCounter,
+                            "dropping zero length packet "
+                            "(skb->len=%u, skb->data_len=%u)\n",
+                            skb->len, skb->data_len);
+      goto drop;
+   }
+
+   /* we need to ensure the blocked status */
+   if (unlikely(test_bit(__LINK_STATE_BLOCKED, &dev->state))) {
+      reason = NETDEV_DROP_BLOCKED;
+      goto drop;
+   }
+   atomic_inc(&dev->rxInFlight);
+
+   pkt = skb->pkt;
+   vmk_PktAdjust(pkt, skb_headroom(skb), skb_headlen(skb));
+   
+   if (skb_shinfo(skb)->frag_list != NULL) {
+      VMK_ReturnStatus status = VMK_OK;
+      struct sk_buff *frag_skb = skb_shinfo(skb)->frag_list;
+
+      while (frag_skb) {
+         status = vmk_PktAppend(pkt, frag_skb->pkt,
+                                skb_headroom(frag_skb), skb_headlen(frag_skb));
+         if (status != VMK_OK) {
+            reason = NETDEV_DROP_NORESOURCE;
+            goto drop_dec_rx_inflight;
+         }
+         frag_skb = frag_skb->next;
+      }
+      
+      vmk_PktSetCompletionData(pkt, skb, dev->genCount, VMK_TRUE);
+      needCompl = VMK_TRUE;
+   }
+   
+   if (unlikely(vmk_PktFrameLenSet(pkt, skb->len) != VMK_OK)) {
+      printk("unable to set skb->pkt %p frame length with skb->len = %u\n", 
+             pkt, skb->len);
+      VMK_ASSERT(VMK_FALSE);
+      reason = NETDEV_DROP_NORESOURCE;
+      goto drop_dec_rx_inflight;
+   }
+   
+   /*
+    * The following extracts vlan tag from skb.
+    * The check just looks at a field of skb, so we
+    * don't bother to check whether vlan is enabled.
+    */
+   if (vlan_rx_tag_present(skb)) {
+      VMK_ASSERT(vmk_PktVlanIDGet(pkt) == 0);
+
+      if  ((vlan_rx_tag_get(skb) & VLAN_VID_MASK) > VLAN_MAX_VALID_VID) {
+         static uint32_t logThrottleCounter = 0;
+         VMKLNX_THROTTLED_INFO(logThrottleCounter,
+                               "invalid vlan tag: %d dropped",
+                               vlan_rx_tag_get(skb) & VLAN_VID_MASK);
+         goto drop_dec_rx_inflight;
+      }
+      vmk_PktVlanIDSet(pkt, vlan_rx_tag_get(skb) & VLAN_VID_MASK);
+      vmk_PktPrioritySet(pkt,
+                         (vlan_rx_tag_get(skb) & VLAN_1PTAG_MASK) >> VLAN_1PTAG_SHIFT);
+      VMKLNX_DEBUG(2, "%s: vlan tag %u present with priority %u",
+                   dev->name, vmk_PktVlanIDGet(pkt), vmk_PktPriorityGet(pkt));
+
+#ifdef VMX86_DEBUG
+      {
+         // generate arp/rarp frames that are < ETH_MIN_FRAME_LEN to
+         // create test cases for PR 106153.
+	 struct ethhdr *eh = (struct ethhdr *)vmk_PktFrameMappedPointerGet(pkt);
+                    
+         if ((eh->h_proto == ntohs(ETH_P_ARP)
+	      || eh->h_proto == ntohs(ETH_P_RARP))
+	     && VMKLNX_STRESS_DEBUG_COUNTER(stressNetGenTinyArpRarp)) {
+            int old_frameMappedLen;
+            int target_len = (ETH_ZLEN - VLAN_HLEN);
+
+	    old_frameMappedLen = vmk_PktFrameMappedLenGet(pkt);
+
+            if (target_len <= old_frameMappedLen) {
+               int old_len;
+	       int len;
+
+	       old_len = vmk_PktFrameLenGet(pkt);
+               vmk_PktFrameLenSet(pkt, target_len);
+	       len = vmk_PktFrameLenGet(pkt);
+               VMKLNX_DEBUG(1, "shorten arp/rarp pkt to %d from %d",
+                            len, old_len);
+            }
+         }
+      }
+#endif
+   }
+
+   if (skb->ip_summed != CHECKSUM_NONE &&
+       !VMKLNX_STRESS_DEBUG_OPTION(stressNetIfForceRxSWCsum)) {
+      vmk_PktSetCsumVfd(pkt);
+   }
+
+   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfCorruptRxTcpUdp)) {
+      LinStress_CorruptSkbData(skb, 40, 14);
+   }
+
+   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfCorruptRxData)) {
+      LinStress_CorruptRxData(pkt, skb);
+   }
+
+   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfCorruptEthHdr)) {
+      LinStress_CorruptEthHdr(skb);
+   }
+
+   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfFailRx)) {
+      VMKLNX_DEBUG(2,"Failing To Queue Packet: skb = %p, "
+                   "pkt = %p, device = %s\n",
+                   skb, pkt, dev->name);
+   }
+
+   if (!needCompl) {
+      do_free_skb(skb);
+      atomic_dec(&dev->rxInFlight);
+   }
+
+   return NET_RX_SUCCESS;
+
+ drop_dec_rx_inflight:
+   atomic_dec(&dev->rxInFlight);
+   if (needCompl) {
+      vmk_PktClearCompletionData(pkt);
+   }
+ drop:
+   netdev_rx_stats_drop(dev, skb->qid, reason);
+   dev_kfree_skb_any(skb);
+   return NET_RX_DROP;
+}
+
+/**
+ * netif_rx - post buffer to the network code
+ * @skb: buffer to post
+ *
+ * This function receives a packet from a device driver and queues it for
+ * the upper (protocol) levels to process.  It always succeeds. The buffer
+ * may be dropped during processing for congestion control or by the
+ * protocol layers.
  *
  *  RETURN VALUE:
  *  NET_RX_SUCCESS (no congestion)
  *  NET_RX_DROP	(packet was dropped)
+ *
+ */
+/* _VMKLNX_CODECHECK_: netif_rx */
+int
+netif_rx(struct sk_buff *skb)
+{
+   struct net_device *dev = skb->dev;
+   vmknetddi_queueops_queueid_t qid = skb->qid;
+   unsigned int len = skb->len;
+   struct netdev_queue_stats *stats;
+   unsigned long flags;
+   vmk_PktHandle *pkt;
+   int status;
+
+   VMK_ASSERT(dev);
+
+   VMKLNX_DEBUG(1, "Napi is not enabled for device %s\n", dev->name);
+   
+   pkt = skb->pkt;
+   VMK_ASSERT(pkt);
+
+   /* netif_rx_common() may free the skb */
+   status = netif_rx_common(skb);
+   if (likely(status == NET_RX_SUCCESS)) {
+      vmk_PktQueueForRxProcess(pkt, dev->uplinkDev);
+
+      /* no batch to count with on this path */
+      stats = netdev_rx_stats_get(dev, qid, &flags);
+      stats->packets++;
+      stats->bytes += len;
+      netdev_stats_put(flags);
+   }
+
+   return status;
+}
+
+/**
+ * netif_receive_skb - process receive buffer from network
+ * @skb: buffer to process
+ *
+ * netif_receive_skb() is the main receive data processing function.
+ * It always succeeds. The buffer may be dropped during processing
+ * for congestion control or by the protocol layers.
+ *
+ * ESX Deviation Notes:
+ * This function may only be called from the napi poll callback routine.
+ *
+ *  RETURN VALUE:
+ *  NET_RX_SUCCESS (no congestion)
+ *  NET_RX_DROP	(packet was dropped)
+ */
+/* _VMKLNX_CODECHECK_: netif_receive_skb */
+int
+netif_receive_skb(struct sk_buff *skb)
+{
+   struct net_device *dev = skb->dev;
+   vmk_Worldlet worldlet;
+   struct napi_wdt_priv *wdtPriv;
+   struct napi_struct *napi;
+   vmk_PktHandle *pkt;   
+   unsigned int len;
+   int status;
+   
+   VMK_ASSERT(dev);
+
+   if (skb->napi == NULL) {
+      if (unlikely(vmk_WorldletGetCurrent(&worldlet, (void **) &wdtPriv) != VMK_OK)) {
+         if (unlikely(vmklnx_is_panic())) {
+            napi = NULL;
+            list_for_each_entry(napi, &dev->napi_list, dev_list) {
+               if (napi != NULL) {
+                  VMKLNX_DEBUG(1, "found a napi:%p.", napi);
+                  break;
+               }
+            }
+            VMK_ASSERT(napi != NULL);
+            skb->napi = napi;
+         } else {
+            VMK_ASSERT(VMK_FALSE);
+            netdev_rx_stats_drop(dev, skb->qid, NETDEV_DROP_INVALID);
+            dev_kfree_skb_any(skb);
+            status = NET_RX_DROP;
+            goto done;
+         }
+      } else {
+         VMK_ASSERT(wdtPriv != NULL && wdtPriv->napi != NULL);
+         skb->napi = wdtPriv->napi;
+      }
+   }
+   VMK_ASSERT(skb->napi != NULL);
+   
+   /*
+    * check if the driver uses its own lro implementation or
+    * if the skb has already been processed by the vmklinux
+    * lro engine
+    */
+   if (!vmklnxLROEnabled ||
+       (dev->features & NETIF_F_SW_LRO) ||
+       skb->lro_ready) {
+      
+      pkt = skb->pkt;
+      napi = skb->napi;
+      len = skb->len;
+      /* netif_rx_common() may free the skb */
+      napi->rx_qid = skb->qid;
+      
+      status = netif_rx_common(skb);
+      if (likely(status == NET_RX_SUCCESS)) {
+         VMK_ASSERT(napi);
+         VMK_ASSERT(pkt);
+         vmk_PktListAddToTail(&napi->pktList, pkt);
+         /* counted by napi_stack_push() */
+         napi->rx_bytes += len;
+      }
+   } else {
+      status = lro_receive_skb(&skb->napi->lro_mgr, skb, NULL);
+   }
+   
+ done:
+   return status;
+}
+
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_poll_work_pending --
+ *
+ *    Check if any work is required for the napi context.
+ *
+ *  Results:
+ *    NapiPollState describing the work to be done.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline NapiPollState
+napi_poll_work_pending(struct napi_struct *napi, vmk_uint32 skippedPushCount)
+{
+   vmk_uint32 count = 0;
+   NapiPollState result = NAPI_NO_WORK;
+
+   VMK_ASSERT(napi);
+   if (test_bit(NAPI_STATE_SCHED, &napi->state)) {
+      result |= NAPI_POLL_WORK;
+   }
+   
+   count = vmk_PktListCount(&napi->pktList);
+   if (count > napi->push_min) {
+        /* If there are enough packets in the pktList, push them up */
+   	result |= NAPI_STACK_PUSH_WORK;
+
+   } else if (count > 0) {
+	if (result & NAPI_POLL_WORK) {
+	   /* If there are not enough packets in the pktList but we have skipped
+            * pushing too many times or packets are pending from the previous
+            * invocation, push them now */
+       	   if (skippedPushCount == 0 || skippedPushCount > napi->push_skip_max) {
+	      result |= NAPI_STACK_PUSH_WORK;
+	   } 
+ 	} else  {
+	  /* If we are not polling again, push even if there are few packets */
+      	   result |= NAPI_STACK_PUSH_WORK;
+   	}
+   }
+   return result;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_push_adapt --
+ *
+ *    Recompute the stack push thresholds of a napi context from its
+ *    average arrival rate and its average poll and push costs.
+ *
+ *    A short packet list may be held back for as many polls as fit in
+ *    vmklnx_napi_push_latency_us once the cost of the push itself is taken
+ *    out. The batch size pushed right away is what is expected to arrive
+ *    in that window, capped by vmklnx_napi_push_batch_max. Bulk flows thus
+ *    get large batches while sparse flows are pushed almost immediately.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Updates napi->push_min and napi->push_skip_max.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline void
+napi_push_adapt(struct napi_struct *napi)
+{
+   vmk_TimerRelCycles budget = napiPushLatencyTC - napi->push_cycles;
+   vmk_uint32 skip = 0;
+   vmk_uint32 batch;
+
+   if (budget > 0 && napi->poll_cycles > 0) {
+      skip = min_t(vmk_TimerRelCycles, budget / napi->poll_cycles,
+                   NAPI_STACK_SKIP_PUSH_LIMIT);
+   }
+
+   batch = (napi->rx_rate * (skip + 1)) >> NAPI_RX_RATE_SHIFT;
+   batch = max_t(vmk_uint32, batch, NAPI_STACK_PUSH_WORK_MIN);
+   batch = min_t(vmk_uint32, batch, max(vmklnx_napi_push_batch_max,
+                                        NAPI_STACK_PUSH_WORK_MIN));
+
+   napi->push_skip_max = skip;
+   napi->push_min = batch;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_poll_account --
+ *
+ *    Fold one driver poll of a napi context into its averages and
+ *    counters. workDone is what the poll routine returned, a poll that
+ *    used up the whole weight means the ring still had work left.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Updates napi->rx_rate, napi->poll_cycles and the poll counters.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline void
+napi_poll_account(struct napi_struct *napi, vmk_uint32 pkts,
+                  vmk_TimerRelCycles cycles, int workDone)
+{
+   int delta = (int)(pkts << NAPI_RX_RATE_SHIFT) - (int)napi->rx_rate;
+
+   napi->rx_rate += delta >> NAPI_EWMA_SHIFT;
+   napi->poll_cycles += (cycles - napi->poll_cycles) >> NAPI_EWMA_SHIFT;
+
+   napi->polls++;
+   napi->poll_cycles_total += cycles;
+   if (workDone >= napi->weight) {
+      napi->polls_full++;
+   }
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_stack_push --
+ *
+ *    Push the packets gathered by a napi context up the stack, and account
+ *    for them, the batch size and the cost of the push.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Empties napi->pktList.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline void
+napi_stack_push(struct napi_struct *napi)
+{
+   vmk_uint32 count = vmk_PktListCount(&napi->pktList);
+   vmk_TimerCycles start = vmk_GetTimerCycles();
+   struct netdev_queue_stats *stats;
+   unsigned long flags;
+   int bucket;
+
+   /* netif_rx placed packets in napi->pktList */
+   vmk_PktListRxProcess(&napi->pktList, napi->dev->uplinkDev);
+
+   stats = netdev_rx_stats_get(napi->dev, napi->rx_qid, &flags);
+   stats->packets += count;
+   stats->bytes += napi->rx_bytes;
+   stats->batches++;
+   stats->batchPkts += count;
+   netdev_stats_put(flags);
+   napi->rx_bytes = 0;
+
+   napi->push_cycles += ((vmk_TimerRelCycles)(vmk_GetTimerCycles() - start) -
+                         napi->push_cycles) >> NAPI_EWMA_SHIFT;
+
+   bucket = count ? min(fls(count) - 1, NAPI_PUSH_HIST_BUCKETS - 1) : 0;
+   napi->push_hist[bucket]++;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_lro_timer_cb --
+ *
+ *    Fires when the oldest deferred lro session of a napi context goes
+ *    idle, and wakes up its worldlet to flush it.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Activates the napi worldlet unless the napi context is being disabled.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+napi_lro_timer_cb(vmk_TimerCookie data)
+{
+   struct napi_struct *napi = data.ptr;
+
+   if (!test_bit(NAPI_STATE_DISABLE, &napi->state)) {
+      vmk_WorldletActivate(napi->worldlet);
+   }
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_lro_flush --
+ *
+ *    Flush the lro sessions of a napi context after it has been polled.
+ *
+ *    With LRO_F_DEFERRED_FLUSH only the sessions that went idle are
+ *    flushed, the others keep aggregating over the next polls. If the
+ *    worldlet is about to suspend, the lro timer is armed for the next
+ *    idle deadline so that no session is held back longer than that.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Flushed packets are added to napi->pktList, may arm napi->lro_timer.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+napi_lro_flush(struct napi_struct *napi, vmk_Bool suspend)
+{
+   struct net_lro_mgr *lro_mgr = &napi->lro_mgr;
+   vmk_TimerRelCycles next;
+   vmk_Bool pending;
+
+   if (!(lro_mgr->features & LRO_F_DEFERRED_FLUSH) ||
+       test_bit(NAPI_STATE_DISABLE, &napi->state)) {
+      lro_flush_all(lro_mgr);
+      return;
+   }
+
+   next = vmklnx_lro_flush_idle(lro_mgr, vmk_GetTimerCycles());
+   if (next > 0 && suspend &&
+       vmk_TimerModifyOrAdd(napi_lro_timer_cb, napi,
+                            (vmk_int32)vmk_TimerTCToUS(next) + 1, VMK_FALSE,
+                            VMK_SP_RANK_UNRANKED, &napi->lro_timer,
+                            &pending) != VMK_OK) {
+      static uint32_t throttle = 0;
+      VMKLNX_THROTTLED_WARN(throttle,
+                            "%s: unable to arm lro timer, flushing",
+                            napi->dev->name);
+      lro_flush_all(lro_mgr);
+   }
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_poll --
+ *
+ *    Worldlet handler dedicated for a napi context. This handler is
+ *    responsible of polling a napi context and pushing the resulting
+ *    packet list. 
+ *
+ *  Results:
+ *    VMK_OK always.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+napi_poll(vmk_Worldlet worldlet,
+          void *private,
+          vmk_WorldletState *state)
+{
+   struct napi_wdt_priv * wdtPriv = private;
+   struct napi_struct *napi;
+   int status;
+   vmk_Bool yield = VMK_TRUE;
+   VMK_ReturnStatus ret;
+   NapiPollState work;
+   vmk_uint32 skippedPushCount = 0;
+
+   VMK_ASSERT(wdtPriv);
+
+   /*
+    * A pool worldlet may still run for the napi context it was taken
+    * from. It leaves a napi context alone until the backup worldlet has
+    * handed it over, see napi_poll_handoff().
+    */
+   napi = wdtPriv->napi;
+   if (unlikely(napi == NULL || napi->dev_poll)) {
+      *state = VMK_WDT_SUSPEND;
+      return VMK_OK;
+   }
+   work = napi_poll_work_pending(napi, skippedPushCount);
+   while (1) {
+
+      /* We favor looking at packets picked up from the driver but not
+       * sent up the stack instead of new packets.  This creates back-pressure
+       * to the driver and remote transmitters.
+       */
+
+      if (work & NAPI_STACK_PUSH_WORK) {
+	 skippedPushCount = 1;
+         napi_stack_push(napi);
+      } else {
+	 skippedPushCount++;
+      }
+      
+      if (work & NAPI_POLL_WORK) {
+         vmk_uint32 pending = vmk_PktListCount(&napi->pktList);
+         vmk_TimerCycles start = vmk_GetTimerCycles();
+
+         VMKAPI_MODULE_CALL(napi->dev->module_id, status, napi->poll, napi,
+                            napi->weight);
+         if (!(napi->dev->features & NETIF_F_SW_LRO)) {
+            /* Flush the lro sessions as we are done polling the napi context */
+            napi_lro_flush(napi, VMK_FALSE);
+         }
+
+         napi_poll_account(napi, vmk_PktListCount(&napi->pktList) - pending,
+                           vmk_GetTimerCycles() - start, status);
+         napi_push_adapt(napi);
+      }
+
+      work = napi_poll_work_pending(napi, skippedPushCount);
+      if (work == NAPI_NO_WORK && napi->lro_mgr.active_cnt > 0 &&
+          !(napi->dev->features & NETIF_F_SW_LRO)) {
+         /* Flush the idle lro sessions and time out the others */
+         napi_lro_flush(napi, VMK_TRUE);
+         work = napi_poll_work_pending(napi, skippedPushCount);
+      }
+      if (work == NAPI_NO_WORK) {
+         /* We're done; suspend the worldlet.*/
+         *state = VMK_WDT_SUSPEND;
+         break;
+      }
+
+      ret = vmk_WorldletShouldYield(worldlet, &yield);
+      if (ret != VMK_OK || yield == VMK_TRUE) {
+         /* We should yield; resubmit the request. */
+         *state = VMK_WDT_READY;
+         break;
+      }
+   }
+
+   return VMK_OK;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_poll_handoff --
+ *
+ *    Move a napi context from the backup worldlet to the pool worldlet
+ *    napi_poll_promote() set aside for it. Called by the backup worldlet
+ *    with dev->napi_lock held while it polls no napi context, so the
+ *    driver poll routine never runs from both worldlets at once.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Activates the pool worldlet.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+napi_poll_handoff(struct napi_struct *napi)
+{
+   VMK_ASSERT(napi->dev_poll);
+   VMK_ASSERT(napi->pool_wdt->priv.napi == napi);
+
+   if (lroFlushIdleTC > 0) {
+      napi->lro_mgr.features |= LRO_F_DEFERRED_FLUSH;
+   }
+
+   napi->worldlet = napi->pool_wdt->worldlet;
+   /* pairs with the smp_rmb() of __napi_schedule() */
+   smp_wmb();
+   napi->dev_poll = VMK_FALSE;
+
+   vmk_WorldletActivate(napi->worldlet);
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_poll --
+ *
+ *    Worldlet handler dedicated for napi context which were not able to create
+ *    their own worldlet. This handler is called by the device worldlet, also called
+ *    backup worldlet.
+ *
+ *    This handler is responsible of polling the different napi context and pushing 
+ *    the resulting packet lists. It only serves the overflow of the device
+ *    worldlet pool, and hands its contexts over to a pool worldlet once
+ *    napi_enable() found them a free one.
+ *
+ *  Results:
+ *    VMK_OK always.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_poll(vmk_Worldlet worldlet,
+            void *private,
+            vmk_WorldletState *state)
+{
+   struct napi_wdt_priv *wdtPriv = private;
+   struct net_device *dev;
+   struct napi_struct *napi;
+   int status;
+   vmk_Bool yield = VMK_TRUE;
+   VMK_ReturnStatus ret;
+   NapiPollState work;
+   vmk_Bool needWork;
+
+   VMK_ASSERT(wdtPriv);
+   VMK_ASSERT(wdtPriv->dev);
+
+   dev = wdtPriv->dev;
+
+   while (VMK_TRUE) {
+      
+      needWork = VMK_FALSE;      
+      work = NAPI_NO_WORK;
+
+      spin_lock(&dev->napi_lock);
+      wdtPriv->napi = NULL;
+      list_for_each_entry(napi, &dev->napi_list, dev_list) {             
+         if (napi->dev_poll && napi->pool_wdt != NULL) {
+            napi_poll_handoff(napi);
+            continue;
+         }
+         if (napi->dev_poll &&
+             ((work = napi_poll_work_pending(napi, 0)) != NAPI_NO_WORK)) {
+            needWork = VMK_TRUE;
+            list_move_tail(&napi->dev_list, &dev->napi_list);           
+            wdtPriv->napi = napi;
+            break;
+         }
+      }
+      spin_unlock(&dev->napi_lock);
+      
+      if (!needWork) {
+         break;
+      }
+
+      /* We favor looking at packets picked up from the driver but not
+       * sent up the stack instead of new packets.  This creates back-pressure
+       * to the driver and remote transmitters.
+       */
+      
+      if (work & NAPI_STACK_PUSH_WORK) {
+         napi_stack_push(napi);
+      }
+      
+      ret = vmk_WorldletShouldYield(worldlet, &yield);
+      if (ret != VMK_OK || yield == VMK_TRUE) {
+         goto abort_yield;
+      }
+      
+      if (work & NAPI_POLL_WORK) {
+         vmk_uint32 pending = vmk_PktListCount(&napi->pktList);
+         vmk_TimerCycles start = vmk_GetTimerCycles();
+
+         VMKAPI_MODULE_CALL(napi->dev->module_id, status, napi->poll, napi,
+                            napi->weight);
+         if (vmklnxLROEnabled && !(napi->dev->features & NETIF_F_SW_LRO)) {
+            /* Flush all the lro sessions as we are done polling the napi context */
+            napi_lro_flush(napi, VMK_FALSE);
+         }
+
+         napi_poll_account(napi, vmk_PktListCount(&napi->pktList) - pending,
+                           vmk_GetTimerCycles() - start, status);
+      }
+      
+      ret = vmk_WorldletShouldYield(worldlet, &yield);
+      if (ret != VMK_OK || yield == VMK_TRUE) {
+         goto abort_yield;
+      }
+   }
+
+   /* We're done; suspend the worldlet.*/
+   *state = VMK_WDT_SUSPEND;
+
+ done:
+   wdtPriv->napi = NULL;
+   return VMK_OK;
+   
+  abort_yield:
+   /* Resubmit the request. */
+   *state = VMK_WDT_READY;
+   goto done;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_pool_take --
+ *
+ *    Hand a free worldlet of the device pool to a napi context. Must be
+ *    called with dev->napi_lock held.
+ *
+ *  Results:
+ *    The pool worldlet, NULL if none is free.
+ *
+ *  Side effects:
+ *    Sets napi->pool_wdt. The caller moves napi->worldlet over.
+ *
+ *----------------------------------------------------------------------------
+ */
+static struct napi_pool_wdt *
+napi_pool_take(struct napi_struct *napi)
+{
+   struct LinNetDev *linDev = get_LinNetDev(napi->dev);
+   struct napi_pool_wdt *wdt;
+
+   list_for_each_entry(wdt, &linDev->napiPool, list) {
+      if (wdt->priv.napi == NULL) {
+         wdt->priv.napi = napi;
+         napi->pool_wdt = wdt;
+         return wdt;
+      }
+   }
+
+   return NULL;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_pool_add --
+ *
+ *    Grow the worldlet pool of a device by one worldlet and hand it to a
+ *    napi context that found no free one.
+ *
+ *  Results:
+ *    The new pool worldlet, NULL if it could not be created.
+ *
+ *  Side effects:
+ *    Sets napi->pool_wdt.
+ *
+ *----------------------------------------------------------------------------
+ */
+static struct napi_pool_wdt *
+napi_pool_add(struct napi_struct *napi)
+{
+   struct net_device *dev = napi->dev;
+   struct LinNetDev *linDev = get_LinNetDev(dev);
+   struct napi_pool_wdt *wdt;
+   vmk_ServiceAcctId serviceID;
+
+   if (vmk_ServiceGetID("netdev", &serviceID) != VMK_OK) {
+      return NULL;
+   }
+
+   wdt = kzalloc(sizeof(*wdt), GFP_KERNEL);
+   if (wdt == NULL) {
+      return NULL;
+   }
+   wdt->priv.dev = dev;
+   wdt->priv.napi = napi;
+
+   if (vmk_WorldletCreate(&wdt->worldlet, "", serviceID, vmklinuxModID,
+                          napi_poll, &wdt->priv) != VMK_OK) {
+      kfree(wdt);
+      return NULL;
+   }
+
+   spin_lock(&dev->napi_lock);
+   wdt->id = linDev->napiPoolSize++;
+   list_add_tail(&wdt->list, &linDev->napiPool);
+   napi->pool_wdt = wdt;
+   spin_unlock(&dev->napi_lock);
+
+   return wdt;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_pool_return --
+ *
+ *    Give the pool worldlet of a napi context back to its device, for
+ *    the next napi context the device adds.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Detaches the worldlet from the napi context and its vector.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+napi_pool_return(struct napi_struct *napi)
+{
+   struct napi_pool_wdt *wdt = napi->pool_wdt;
+   char name[VMK_WDT_NAME_SIZE_MAX];
+
+   VMK_ASSERT(wdt->priv.napi == napi);
+
+   if (napi->vector) {
+      vmk_WorldletVectorUnSet(wdt->worldlet);
+      napi->vector = 0;
+   }
+
+   spin_lock(&napi->dev->napi_lock);
+   wdt->priv.napi = NULL;
+   napi->pool_wdt = NULL;
+   spin_unlock(&napi->dev->napi_lock);
+
+   if (napi->dev->reg_state == NETREG_REGISTERED) {
+      snprintf(name, VMK_WDT_NAME_SIZE_MAX, "%s-napi-pool-%d",
+               napi->dev->name, wdt->id);
+      vmk_WorldletNameSet(wdt->worldlet, name);
+   }
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_poll_promote --
+ *
+ *    Set aside a free worldlet of the device pool for a napi context
+ *    polled by the backup worldlet. The backup worldlet hands the napi
+ *    context over to it, see napi_poll_handoff(). Does not block.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    Activates the backup worldlet.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+napi_poll_promote(struct napi_struct *napi)
+{
+   struct net_device *dev = napi->dev;
+   struct napi_pool_wdt *wdt;
+
+   spin_lock(&dev->napi_lock);
+   wdt = napi_pool_take(napi);
+   spin_unlock(&dev->napi_lock);
+
+   if (wdt != NULL) {
+      vmk_WorldletActivate(dev->napi_worldlet);
+   }
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_poll_init --
+ *
+ *    Initialize a napi context and give it a worldlet of its own from the
+ *    pool of the device, which grows by one if no worldlet is free. If the
+ *    pool cannot grow the napi context is attached to the backup worldlet
+ *    of the device.
+ *
+ *  Results:
+ *    VMK_OK always.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */   
+static VMK_ReturnStatus
+napi_poll_init(struct napi_struct *napi)
+{
+   struct napi_pool_wdt *wdt;
+   char name[VMK_WDT_NAME_SIZE_MAX];
+
+   VMK_ASSERT(napi);
+   vmk_PktListInit(&napi->pktList);
+   napi->rx_bytes = 0;
+
+   napi->dev_poll = VMK_FALSE;
+   napi->vector = 0;
+
+   napi->push_min = NAPI_STACK_PUSH_WORK_MIN;
+   napi->push_skip_max = NAPI_STACK_SKIP_PUSH_MAX;
+   napi->rx_rate = 0;
+   napi->poll_cycles = 0;
+   napi->push_cycles = 0;
+   memset(napi->push_hist, 0, sizeof(napi->push_hist));
+   napi->polls = 0;
+   napi->polls_full = 0;
+   napi->poll_cycles_total = 0;
+   napi->pool_wdt = NULL;
+   napi->lro_timer = VMK_INVALID_TIMER;
+
+   spin_lock(&napi->dev->napi_lock);
+   napi->napi_id = get_LinNetDev(napi->dev)->napiNextId++;
+   wdt = napi_pool_take(napi);
+   spin_unlock(&napi->dev->napi_lock);
+
+   if (wdt == NULL) {
+      wdt = napi_pool_add(napi);
+   }
+   if (wdt != NULL) {
+      napi->worldlet = wdt->worldlet;
+      if (napi->dev->reg_state == NETREG_REGISTERED) {
+         snprintf(name, VMK_WDT_NAME_SIZE_MAX, "%s-napi-%d",
+                  napi->dev->name, napi->napi_id);
+         vmk_WorldletNameSet(napi->worldlet, name);
+      }
+   } else {
+      VMKLNX_WARN("Unable to create napi worldlet for %s, using backup\n",
+                  napi->dev->name);
+      if (napi->dev->reg_state == NETREG_REGISTERED) {
+         napi->worldlet = napi->dev->napi_worldlet;
+
+         /*
+          * Use device global worldlet for polling this napi_struct,
+          * if worldlet creation fails
+          */
+         napi->dev_poll = VMK_TRUE;
+      } else {
+         napi->dev->reg_state = NETREG_EARLY_NAPI_ADD_FAILED;
+         return VMK_FAILURE;
+      }
+   }
+
+   spin_lock(&napi->dev->napi_lock);
+   list_add(&napi->dev_list, &napi->dev->napi_list);   
+   spin_unlock(&napi->dev->napi_lock);
+
+   /*
+    * Keep track of which worldlet is (most probably) driving the
+    * default queue. For netqueue capable nics, we call 
+    * VMKNETDDI_QUEUEOPS_OP_GET_DEFAULT_QUEUE to figure out the
+    * default worldlet. For non-netqueue nics, the first suceessful
+    * netif_napi_add wins.
+    */
+   if (!napi->dev->default_worldlet && napi->worldlet) {
+      napi->dev->default_worldlet = napi->worldlet;
+   }
+
+   return VMK_OK;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_poll_init --
+ *
+ *    Initialize a device's backup worldlet for the napi context not able to
+ *    create their own. 
+ *
+ *  Results:
+ *    VMK_OK if everything is ok, VMK_* otherwise.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_poll_init(struct net_device *dev)
+{
+   VMK_ReturnStatus ret;
+   vmk_ServiceAcctId serviceID;
+   
+   VMK_ASSERT(dev);
+
+   ret = vmk_ServiceGetID("netdev", &serviceID);
+   VMK_ASSERT(ret == VMK_OK);
+
+   dev->napi_wdt_priv.dev = dev;
+   dev->napi_wdt_priv.napi = NULL;
+
+   ret = vmk_WorldletCreate(&dev->napi_worldlet, 
+                            "",
+                            serviceID,
+                            vmklinuxModID,
+                            netdev_poll, &dev->napi_wdt_priv);
+   return ret;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_set_worldlet_name --
+ *
+ *    Initialize a device's worldlet name.
+ *
+ *  Results:
+ *    VMK_OK if everything is ok, VMK_* otherwise.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_set_worldlets_name(struct net_device *dev)
+{
+   VMK_ReturnStatus status;
+   struct LinNetDev *linDev = get_LinNetDev(dev);
+   struct napi_pool_wdt *wdt;
+   struct napi_struct *napi;
+   char name[VMK_WDT_NAME_SIZE_MAX];
+
+   VMK_ASSERT(dev);
+
+   snprintf(name, VMK_WDT_NAME_SIZE_MAX, "%s-napi-backup", dev->name);   
+   status = vmk_WorldletNameSet(dev->napi_worldlet, name);
+   VMK_ASSERT(status == VMK_OK);
+
+   spin_lock(&dev->napi_lock);
+   list_for_each_entry(napi, &dev->napi_list, dev_list) {             
+      if (napi->dev_poll) {
+         continue;
+      }
+      snprintf(name, VMK_WDT_NAME_SIZE_MAX, "%s-napi-%d",
+               napi->dev->name, napi->napi_id);
+      status = vmk_WorldletNameSet(napi->worldlet, name);
+      VMK_ASSERT(status == VMK_OK);
+   }
+   list_for_each_entry(wdt, &linDev->napiPool, list) {
+      if (wdt->priv.napi == NULL) {
+         snprintf(name, VMK_WDT_NAME_SIZE_MAX, "%s-napi-pool-%d",
+                  dev->name, wdt->id);
+         status = vmk_WorldletNameSet(wdt->worldlet, name);
+         VMK_ASSERT(status == VMK_OK);
+      }
+   }
+   spin_unlock(&dev->napi_lock);
+
+   return VMK_OK;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  napi_poll_cleanup --
+ *
+ *    Cleanup a napi structure.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+napi_poll_cleanup(struct napi_struct *napi)
+{
+   VMK_ASSERT(napi);
+   VMK_ASSERT(vmk_PktListIsEmpty(&napi->pktList));
+   vmk_TimerRemoveSync(napi->lro_timer);
+   if (napi->pool_wdt != NULL) {
+      napi_pool_return(napi);
+   }
+   list_del(&napi->dev_list);
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_poll_cleanup --
+ *
+ *    Cleanup all napi structures associated with the device.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+netdev_poll_cleanup(struct net_device *dev)
+{
+   VMK_ASSERT(dev);   
+   struct LinNetDev *linDev = get_LinNetDev(dev);
+   struct list_head *ele, *next;
+   struct napi_pool_wdt *wdt;
+   struct napi_struct *napi;
+
+   /*
+    * Cleanup all napi structs
+    */
+   list_for_each_safe(ele, next, &dev->napi_list) {
+      napi = list_entry(ele, struct napi_struct, dev_list);
+      napi_poll_cleanup(napi);
+   }
+
+   list_for_each_safe(ele, next, &linDev->napiPool) {
+      wdt = list_entry(ele, struct napi_pool_wdt, list);
+      VMK_ASSERT(wdt->priv.napi == NULL);
+      list_del(&wdt->list);
+      vmk_WorldletUnref(wdt->worldlet);
+      kfree(wdt);
+   }
+   linDev->napiPoolSize = 0;
+
+   if (dev->napi_worldlet) {
+      vmk_WorldletUnref(dev->napi_worldlet);
+   }
+}
+
+/**
+ * __napi_schedule - schedule for receive
+ * @napi: entry to schedule
+ *
+ * The entry's receive function will be scheduled to run
+ *
+ * RETURN VALUE:
+ * None
+ */
+/* _VMKLNX_CODECHECK_: __napi_schedule */
+void 
+__napi_schedule(struct napi_struct *napi)
+{
+   vmk_uint32 myVector = 0;
+   vmk_Bool inIntr = vmk_ContextIsInterruptHandler(&myVector);
+   vmk_Worldlet worldlet;
+   VMK_ASSERT(napi);
+
+   /*
+    * Follow the vector the context is scheduled from, the worldlet is then
+    * placed with it and moves along when the vector does. The backup
+    * worldlet serves several vectors and is left alone.
+    */
+   if (likely(!napi->dev_poll)) {
+      /* pairs with the smp_wmb() of napi_poll_handoff() */
+      smp_rmb();
+      worldlet = napi->worldlet;
+      if (unlikely(napi->vector != myVector) && likely(inIntr)) {
+         vmk_WorldletVectorSet(worldlet, myVector);
+         napi->vector = myVector;
+      }
+   } else {
+      worldlet = napi->worldlet;
+   }
+
+   vmk_WorldletActivate(worldlet);
+}
+
+/**
+ *      napi_disable - prevent NAPI from scheduling
+ *      @napi: napi context
+ *
+ * Stop NAPI from being scheduled on this context.
+ * Waits till any outstanding processing completes.
+ *
+ * RETURN VALUE:
+ * None
+ */
+/* _VMKLNX_CODECHECK_: napi_disable */
+void
+napi_disable(struct napi_struct *napi)
+{
+   vmk_WorldletState state;
+   VMK_ReturnStatus ret;
+
+   VMK_ASSERT(napi);
+
+   set_bit(NAPI_STATE_DISABLE, &napi->state);
+
+   /*
+    * The worldlet may have suspended with lro sessions left open. Cancel
+    * their deadline and let it flush them, as nothing will run it once
+    * we own NAPI_STATE_SCHED.
+    */
+   vmk_TimerRemoveSync(napi->lro_timer);
+   if (napi->lro_mgr.active_cnt > 0 && !napi->dev_poll) {
+      vmk_WorldletActivate(napi->worldlet);
+   }
+
+   while (1) {
+      ret = vmk_WorldletCheckState(napi->worldlet, &state);
+      VMK_ASSERT(ret == VMK_OK);
+
+      /* If the worldlet isn't running/set to run, then we see if we can
+       * disable it from running in the future by blocking off
+       * NAPI_STATE_SCHED.
+       */
+      if (state == VMK_WDT_SUSPEND  && 
+          !test_and_set_bit(NAPI_STATE_SCHED, &napi->state)) {
+         VMK_DEBUG_ONLY(
+            ret = vmk_WorldletCheckState(napi->worldlet, &state);
+            VMK_ASSERT(state == VMK_WDT_SUSPEND);
+            );
+         break;
+      }
+      /**
+       * Give the flush a chance to run.
+       */
+      schedule_timeout_interruptible(1);
+   }
+
+   /* in case the worldlet rearmed it before seeing NAPI_STATE_DISABLE */
+   vmk_TimerRemoveSync(napi->lro_timer);
+   clear_bit(NAPI_STATE_DISABLE, &napi->state);
+}
+
+/**
+ * netif_napi_add - initialize a napi context
+ * @dev:  network device
+ * @napi: napi context
+ * @poll: polling function
+ * @weight: default weight
+ *
+ * netif_napi_add() must be used to initialize a napi context prior to calling
+ * *any* of the other napi related functions.
+ *
+ * RETURN VALUE:
+ * None
+ */
+/* _VMKLNX_CODECHECK_: netif_napi_add */
+void 
+netif_napi_add(struct net_device *dev,
+               struct napi_struct *napi,
+               int (*poll)(struct napi_struct *, int),
+               int weight)
+{
+        struct net_lro_mgr *lro_mgr;
+
+        napi->poll = poll;
+        napi->weight = weight;
+        napi->dev = dev;
+
+        lro_mgr = &napi->lro_mgr;
+        lro_mgr->dev = dev;
+        lro_mgr->features = LRO_F_NAPI;
+        lro_mgr->ip_summed = CHECKSUM_UNNECESSARY;
+        lro_mgr->ip_summed_aggr = CHECKSUM_UNNECESSARY;
+        lro_mgr->max_desc = LRO_DEFAULT_MAX_DESC;
+        lro_mgr->lro_arr = napi->lro_desc;
+        lro_mgr->get_skb_header = vmklnx_net_lro_get_skb_header;
+        lro_mgr->get_frag_header = NULL;
+        lro_mgr->max_aggr = vmklnxLROMaxAggr;
+        lro_mgr->frag_align_pad = 0;
+        lro_mgr->max_sess_bytes = max(vmklnx_lro_session_bytes, 0);
+        lro_mgr->flush_idle_tc = lroFlushIdleTC;
+
+        napi_poll_init(napi);
+
+        /*
+         * Sessions can only be kept open across polls by a napi context
+         * with its own worldlet, see napi_lro_flush().
+         */
+        if (lroFlushIdleTC > 0 && !napi->dev_poll) {
+                lro_mgr->features |= LRO_F_DEFERRED_FLUSH;
+        }
+
+        set_bit(NAPI_STATE_SCHED, &napi->state); 
+}
+
+/**
+ *  netif_napi_del - remove a napi context
+ *  @napi: napi context
+ *
+ *  netif_napi_del() removes a napi context from the network device napi list
+ *
+ * RETURN VALUE:
+ * None
+ */
+/* _VMKLNX_CODECHECK_: netif_napi_del */
+void 
+netif_napi_del(struct napi_struct *napi)
+{
+   napi_poll_cleanup(napi);
+}
+
+/**
+ *      napi_enable - enable NAPI scheduling
+ *      @n: napi context
+ *
+ * Resume NAPI from being scheduled on this context.
+ * Must be paired with napi_disable.
+ * 
+ * RETURN VALUE:
+ * None
+ */
+/* _VMKLNX_CODECHECK_: napi_enable */
+void
+napi_enable(struct napi_struct *napi)
+{
+   BUG_ON(!test_bit(NAPI_STATE_SCHED, &napi->state));
+
+   if (unlikely(napi->dev_poll) && napi->pool_wdt == NULL) {
+      napi_poll_promote(napi);
+   }
+
+   vmklnx_lro_reset(&napi->lro_mgr);
+
+   smp_mb__before_clear_bit();
+   clear_bit(NAPI_STATE_SCHED, &napi->state);  
+}
+
+
+/*
+ * Section: Skb helpers
+ */
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  do_init_skb_bits --
+ *
+ *    Initialize a socket buffer.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline void
+do_init_skb_bits(struct sk_buff *skb, kmem_cache_t *cache)
+{
+   skb->qid = VMKNETDDI_QUEUEOPS_INVALID_QUEUEID;
+   skb->next = NULL;
+   skb->prev = NULL;
+   skb->head = NULL;
+   skb->data = NULL;
+   skb->tail = NULL;
+   skb->end = NULL;
+   skb->dev = NULL;
+   skb->pkt = NULL;
+   atomic_set(&skb->users, 1);
+   skb->cache = cache;
+   skb->mhead = 0;
+   skb->len = 0;
+   skb->data_len = 0;
+   skb->ip_summed = CHECKSUM_NONE;
+   skb->csum = 0;
+   skb->priority = 0;
+   skb->protocol = 0;
+   skb->truesize = 0;
+   skb->mac.raw = NULL;
+   skb->nh.raw = NULL;
+   skb->h.raw = NULL;
+   skb->napi = NULL;
+   skb->lro_ready = 0;
+   skb->xmit_more = 0;
+
+   /* VLAN_RX_SKB_CB shares the same space so this is sufficient */
+   VLAN_TX_SKB_CB(skb)->magic = 0;
+   VLAN_TX_SKB_CB(skb)->vlan_tag = 0;
+
+   atomic_set(&(skb_shinfo(skb)->dataref), 1);
+   atomic_set(&(skb_shinfo(skb)->fragsref), 1);
+   skb_shinfo(skb)->nr_frags = 0;
+   skb_shinfo(skb)->frag_list = NULL;
+   skb_shinfo(skb)->gso_size = 0;
+   skb_shinfo(skb)->gso_segs = 0;
+   skb_shinfo(skb)->gso_type = 0;
+   skb_shinfo(skb)->ip6_frag_id = 0;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  do_bind_skb_to_pkt --
+ *
+ *    Bind a socket buffer to a packet handle.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline void
+do_bind_skb_to_pkt(struct sk_buff *skb, vmk_PktHandle *pkt, unsigned int size)
+{
+   vmk_PktFrag frag;
+
+   if (vmk_PktFragGet(pkt, &frag, 0) != VMK_OK) {
+      VMK_ASSERT(0);
+      return;
+   }
+
+   skb->pkt = pkt;
+   skb->head = phys_to_virt(frag.addr);
+   skb->end = skb->head + size;
+   skb->data = skb->head;
+   skb->tail = skb->head;
+
+#ifdef VMX86_DEBUG
+   /* Added to assert earlier to catch PR 62560 */
+   virt_to_phys(skb->tail);
+
+   /*
+    * linux guarantees physical contiguity of the pages backing
+    * skb's returned by this routine, so the drivers assume that.
+    * we guarantee this by backing the buffers returned from 
+    * vmk_PktAlloc with a large-page, low-memory heap which is
+    * guaranteed to be physically contiguous, so we just double 
+    * check it here.
+    */
+   {
+      vmk_Bool isFlat;
+      
+      isFlat = vmk_PktIsFlatBuffer(pkt);
+      VMK_ASSERT(isFlat);
+   }  
+#endif // VMX86_DEBUG
+}  
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  do_recycle_skb_bits --
+ *
+ *    Bring a released socket buffer back to the state do_init_skb_bits
+ *    leaves it in. The fields every skb goes through are reset outright;
+ *    the ones only some paths touch are checked first so that their
+ *    cache lines are not dirtied needlessly. skb->cache does not change.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline void
+do_recycle_skb_bits(struct sk_buff *skb)
+{
+   struct skb_shared_info *shinfo = skb_shinfo(skb);
+
+   skb->next = NULL;
+   skb->prev = NULL;
+   skb->head = NULL;
+   skb->data = NULL;
+   skb->tail = NULL;
+   skb->end = NULL;
+   skb->dev = NULL;
+   skb->pkt = NULL;
+   atomic_set(&skb->users, 1);
+   skb->len = 0;
+   skb->data_len = 0;
+   skb->ip_summed = CHECKSUM_NONE;
+   skb->protocol = 0;
+   skb->truesize = 0;
+   skb->mac.raw = NULL;
+   skb->nh.raw = NULL;
+   skb->h.raw = NULL;
+   atomic_set(&shinfo->dataref, 1);
+   atomic_set(&shinfo->fragsref, 1);
+
+   if (unlikely(skb->qid != VMKNETDDI_QUEUEOPS_INVALID_QUEUEID)) {
+      skb->qid = VMKNETDDI_QUEUEOPS_INVALID_QUEUEID;
+   }
+   if (unlikely(skb->mhead != 0)) {
+      skb->mhead = 0;
+   }
+   if (skb->csum != 0) {
+      skb->csum = 0;
+   }
+   if (unlikely(skb->priority != 0)) {
+      skb->priority = 0;
+   }
+   if (skb->napi != NULL) {
+      skb->napi = NULL;
+   }
+   if (skb->lro_ready != 0) {
+      skb->lro_ready = 0;
+   }
+   if (skb->xmit_more != 0) {
+      skb->xmit_more = 0;
+   }
+
+   /* VLAN_RX_SKB_CB shares the same space so this is sufficient */
+   if (unlikely(VLAN_TX_SKB_CB(skb)->magic != 0 ||
+                VLAN_TX_SKB_CB(skb)->vlan_tag != 0)) {
+      VLAN_TX_SKB_CB(skb)->magic = 0;
+      VLAN_TX_SKB_CB(skb)->vlan_tag = 0;
+   }
+
+   if (unlikely(shinfo->nr_frags != 0)) {
+      shinfo->nr_frags = 0;
+   }
+   if (unlikely(shinfo->frag_list != NULL)) {
+      shinfo->frag_list = NULL;
+   }
+   if (unlikely(shinfo->gso_size != 0 || shinfo->gso_segs != 0 ||
+                shinfo->gso_type != 0)) {
+      shinfo->gso_size = 0;
+      shinfo->gso_segs = 0;
+      shinfo->gso_type = 0;
+   }
+   if (unlikely(shinfo->ip6_frag_id != 0)) {
+      shinfo->ip6_frag_id = 0;
+   }
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  skb_pool_ctor --
+ *
+ *    Constructor of the skb pools. The slab runs it once per object, when
+ *    it takes a new cluster from the heap, and keeps the object's contents
+ *    while it sits on the slab's per-PCPU free lists. As do_free_skb()
+ *    brings every skb back to this state before freeing it, skbs come out
+ *    of the pool ready to use.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+skb_pool_ctor(void *item, kmem_cache_t *cache, unsigned long flags)
+{
+   do_init_skb_bits(item, cache);
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  skb_pool_create --
+ *
+ *    Create a pool of socket buffers, see skb_pool_ctor.
+ *
+ *  Results:
+ *    The pool or NULL.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static kmem_cache_t *
+skb_pool_create(vmk_HeapID heapID, const char *name)
+{
+   return vmklnx_kmem_cache_create(heapID, name,
+                                   sizeof(struct sk_buff) +
+                                   sizeof(struct skb_shared_info),
+                                   0, skb_pool_ctor, NULL, 1, 100);
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  do_alloc_skb --
+ *
+ *    Allocate a socket buffer. The pool hands it out initialized.
+ *
+ *  Results:
+ *    A pointer to the allocated socket buffer.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static struct sk_buff *
+do_alloc_skb(kmem_cache_t *cache)
+{
+   if (!cache) {
+      if (vmklnx_skb_cache) {    
+         cache = vmklnx_skb_cache;
+      } else {
+         return NULL;
+      }
+   }
+
+   return vmklnx_kmem_cache_alloc(cache);
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  vmklnx_net_alloc_skb --
+ *
+ *    Allocate a socket buffer for a specified size and bind it to a packet handle.
+ *
+ *  Results:
+ *    A pointer the allocated socket buffer.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+struct sk_buff *
+vmklnx_net_alloc_skb(kmem_cache_t *cache, unsigned int size)
+{
+   vmk_PktHandle *pkt;
+   struct sk_buff *skb;
+
+   skb = do_alloc_skb(cache);
+
+   if (unlikely(skb == NULL)) {
+      goto done;
+   }
+
+   vmk_PktAlloc(size, &pkt);      
+  
+   if (unlikely(pkt == NULL)) {
+      do_free_skb(skb);
+      skb = NULL;
+      goto done;
+   }
+
+   do_bind_skb_to_pkt(skb, pkt, size);
+
+ done:   
+   return skb;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  vmklnx_net_skb_complete --
+ *
+ *    Completion handler for packet coming from vmklinux and requiring it.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
  */
-/* _VMKLNX_CODECHECK_: netif_receive_skb */
-int
-netif_receive_skb(struct sk_buff *skb)
+static VMK_ReturnStatus
+vmklnx_net_skb_complete(void *reserved,
+                        vmk_UplinkCompletionData data,
+                        vmk_PktList *pktList)
 {
-   struct net_device *dev = skb->dev;
-   vmk_Worldlet worldlet;
-   struct napi_wdt_priv *wdtPriv;
-   struct napi_struct *napi;
-   vmk_PktHandle *pkt;   
-   int status;
-   
-   VMK_ASSERT(dev);
+   vmk_PktHandle *pkt;
+   struct sk_buff *skb;
+   struct sk_buff *skbToRelease;
+   struct sk_buff *next_skb;
+   struct net_device *dev = data;
+   vmk_PktCompletionData genCount;
+   struct sk_buff *batch[NETDEV_SKB_FREE_BATCH];
+   int nBatch = 0, nCompleted = 0;
 
-   if (skb->napi == NULL) {
-      if (unlikely(vmk_WorldletGetCurrent(&worldlet, (void **) &wdtPriv) != VMK_OK)) {
-         if (unlikely(vmklnx_is_panic())) {
-            napi = NULL;
-            list_for_each_entry(napi, &dev->napi_list, dev_list) {
-               if (napi != NULL) {
-                  VMKLNX_DEBUG(1, "found a napi:%p.", napi);
-                  break;
-               }
+   while (!vmk_PktListIsEmpty(pktList)) {
+      pkt = vmk_PktListPopHead(pktList);
+      
+      vmk_PktGetCompletionData(pkt, 
+                               (vmk_PktCompletionData *)&skb, &genCount);
+
+      /* Check if the packet really belongs to this device */
+      if (likely(genCount == dev->genCount)) {
+         /*
+          * The fragments were linked into pkt by netif_rx_common; their
+          * skbs go back with the head skb, a batch at a time.
+          */
+         skbToRelease = skb_shinfo(skb)->frag_list;
+         skb_shinfo(skb)->frag_list = NULL;
+         while (skbToRelease) {
+            next_skb = skbToRelease->next;         
+            vmk_PktReleaseAfterComplete(skbToRelease->pkt);
+            if (unlikely(skb_shinfo(skbToRelease)->nr_frags)) {
+               vmklnx_page_pool_put_frags(skbToRelease);
             }
-            VMK_ASSERT(napi != NULL);
-            skb->napi = napi;
-         } else {
-            VMK_ASSERT(VMK_FALSE);
-            dev_kfree_skb_any(skb);
-            dev->linnet_rx_dropped++;
-            status = NET_RX_DROP;
-            goto done;
+            if (nBatch == NETDEV_SKB_FREE_BATCH) {
+               do_free_skb_bulk(batch, nBatch);
+               nBatch = 0;
+            }
+            batch[nBatch++] = skbToRelease;
+            skbToRelease = next_skb;
+         }
+
+         nCompleted++;
+         vmk_PktClearCompletionData(pkt);      
+         vmk_PktReleaseAfterComplete(pkt);
+         if (unlikely(skb_shinfo(skb)->nr_frags)) {
+            vmklnx_page_pool_put_frags(skb);
+         }
+         if (nBatch == NETDEV_SKB_FREE_BATCH) {
+            do_free_skb_bulk(batch, nBatch);
+            nBatch = 0;
          }
+         batch[nBatch++] = skb;
       } else {
-         VMK_ASSERT(wdtPriv != NULL && wdtPriv->napi != NULL);
-         skb->napi = wdtPriv->napi;
+         VMKLNX_WARN("Orphan packet genCount=%p instead of %p\n",
+                     genCount, dev->genCount);
+         vmk_PktClearCompletionData(pkt);      
+         vmk_PktReleaseAfterComplete(pkt);
       }
    }
-   VMK_ASSERT(skb->napi != NULL);
-   
-   /*
-    * check if the driver uses its own lro implementation or
-    * if the skb has already been processed by the vmklinux
-    * lro engine
-    */
-   if (!vmklnxLROEnabled ||
-       (dev->features & NETIF_F_SW_LRO) ||
-       skb->lro_ready) {
-      
-      pkt = skb->pkt;
-      napi = skb->napi;
-      
-      status = netif_rx_common(skb);
-      if (likely(status == NET_RX_SUCCESS)) {
-         VMK_ASSERT(napi);
-         VMK_ASSERT(pkt);
-         vmk_PktListAddToTail(&napi->pktList, pkt);
-      }
-   } else {
-      status = lro_receive_skb(&skb->napi->lro_mgr, skb, NULL);
+
+   if (nBatch > 0) {
+      do_free_skb_bulk(batch, nBatch);
    }
-   
- done:
-   return status;
+
+   if (nCompleted > 0) {
+      dev->linnet_pkt_completed += nCompleted;
+      atomic_sub(nCompleted, &dev->rxInFlight);
+   }
+
+   VMK_ASSERT(atomic_read(&dev->rxInFlight) >= 0);
+   return VMK_OK;
 }
 
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  do_free_skb --
+ *
+ *    Release socket buffer. It is reset here, while its cache lines are
+ *    still hot, so that the allocation path does not have to touch it.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+do_free_skb(struct sk_buff *skb)
+{
+   do_recycle_skb_bits(skb);
+   vmklnx_kmem_cache_free(skb->cache, skb);
+}
 
 /*
  *----------------------------------------------------------------------------
  *
- *  napi_poll_work_pending --
+ *  do_free_skb_bulk --
  *
- *    Check if any work is required for the napi context.
+ *    Release count socket buffers.
  *
  *  Results:
- *    NapiPollState describing the work to be done.
+ *    None.
  *
  *  Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static inline NapiPollState
-napi_poll_work_pending(struct napi_struct *napi, vmk_uint32 skippedPushCount)
+static void
+do_free_skb_bulk(struct sk_buff **skbs, int count)
 {
-   vmk_uint32 count = 0;
-   NapiPollState result = NAPI_NO_WORK;
+   int i;
 
-   VMK_ASSERT(napi);
-   if (test_bit(NAPI_STATE_SCHED, &napi->state)) {
-      result |= NAPI_POLL_WORK;
+   for (i = 0; i < count; i++) {
+      do_free_skb(skbs[i]);
    }
-   
-   count = vmk_PktListCount(&napi->pktList);
-   if (count > NAPI_STACK_PUSH_WORK_MIN) {
-        /* If there are enough packets in the pktList, push them up */
-   	result |= NAPI_STACK_PUSH_WORK;
+}
 
-   } else if (count > 0) {
-	if (result & NAPI_POLL_WORK) {
-	   /* If there are not enough packets in the pktList but we have skipped
-            * pushing twice or packets are pending from the previous invocation,
-            * push them now */
-       	   if (skippedPushCount == 0 || skippedPushCount >  NAPI_STACK_SKIP_PUSH_MAX) {
-	      result |= NAPI_STACK_PUSH_WORK;
-	   } 
- 	} else  {
-	  /* If we are not polling again, push even if there are few packets */
-      	   result |= NAPI_STACK_PUSH_WORK;
-   	}
+/**
+ *  __kfree_skb - private function
+ *  @skb: buffer
+ *
+ *  Free an sk_buff. Release anything attached to the buffer.
+ *  Clean the state. This is an internal helper function. Users should
+ *  always call kfree_skb
+ *
+ * RETURN VALUE:
+ * None
+ */
+/* _VMKLNX_CODECHECK_: __kfree_skb */
+void
+__kfree_skb(struct sk_buff *skb)
+{
+   if (unlikely(!atomic_dec_and_test(&skb->users))) {
+      return;
    }
-   return result;
+
+   skb_release_data(skb);   
+   do_free_skb(skb);
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  napi_poll --
+ *  skb_debug_info -- 
+ *      Debug function to print contents of a socket buffer.
+ *
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    None.
+ *----------------------------------------------------------------------------
+ */
+void
+skb_debug_info(struct sk_buff *skb)
+{
+   int f;
+   skb_frag_t *frag;
+
+   printk(KERN_ERR "skb\n"
+          "   head     <%p>\n"
+          "   mhead    <%u>\n"
+          "   data     <%p>\n"
+          "   tail     <%p>\n"
+          "   end      <%p>\n"
+          "   data_len <%u>\n"
+          "   nr_frags <%u>\n"
+          "   dataref  <%u>\n"
+          "   gso_size <%u>\n",
+          skb->head, skb->mhead,
+          skb->data, skb->tail, skb->end,
+          skb->data_len,
+          skb_shinfo(skb)->nr_frags,
+          atomic_read(&(skb_shinfo(skb)->dataref)),
+          skb_shinfo(skb)->gso_size);
+
+   for (f = 0; f < skb_shinfo(skb)->nr_frags; f++) {
+      frag = &skb_shinfo(skb)->frags[f];
+      printk(KERN_ERR "skb frag %d\n"
+             "   page         <0x%llx>\n"
+             "   page_offset  <%u>\n"
+             "   size         <%u>\n",
+             f, page_to_phys(frag->page),
+             frag->page_offset, frag->size);
+   }
+}
+
+
+/*
+ * Section: High dma bounce rings
+ */
+
+/*
+ * Ring of preallocated skbs backing vmklnx_netdev_high_dma_workaround on
+ * one tx queue. The ring keeps a reference on every slot; a slot is free
+ * again once the driver has completed and released the copy handed out
+ * in it, i.e. when only the ring's reference is left. Slots are handed
+ * out in order, which is the order tx completes in, so the slot at next
+ * being busy means the whole ring is. Only used under the queue's xmit
+ * lock, so no locking of its own.
+ */
+struct netdev_bounce_ring {
+   unsigned int    next;          /* next slot to hand out */
+   unsigned int    nSlots;
+   unsigned int    slotSize;      /* largest frame a slot can hold */
+   u64             bounced;       /* frames copied into a slot */
+   u64             exhausted;     /* slot at next was still in flight */
+   u64             oversized;     /* frame larger than a slot */
+   struct sk_buff *slots[0];
+};
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_bounce_ring_create --
  *
- *    Worldlet handler dedicated for a napi context. This handler is
- *    responsible of polling a napi context and pushing the resulting
- *    packet list. 
+ *    Allocate a bounce ring of nSlots skbs able to hold a frame of
+ *    slotSize bytes, all of them below dmaMask.
  *
  *  Results:
- *    VMK_OK always.
+ *    The ring, or NULL if not enough memory below dmaMask could be had.
  *
  *  Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static VMK_ReturnStatus
-napi_poll(vmk_Worldlet worldlet,
-          void *private,
-          vmk_WorldletState *state)
+static struct netdev_bounce_ring *
+netdev_bounce_ring_create(int nSlots, unsigned int slotSize, u64 dmaMask)
 {
-   struct napi_wdt_priv * wdtPriv = private;
-   struct napi_struct *napi;
-   int status;
-   vmk_Bool yield = VMK_TRUE;
-   VMK_ReturnStatus ret;
-   NapiPollState work;
-   vmk_uint32 skippedPushCount = 0;
+   struct netdev_bounce_ring *ring;
+   struct sk_buff *skb;
+   vmk_PktFrag frag;
+   int i, tries = 0;
 
-   VMK_ASSERT(wdtPriv);
-   VMK_ASSERT(wdtPriv->napi);
+   ring = kzalloc(sizeof(*ring) + nSlots * sizeof(ring->slots[0]), GFP_KERNEL);
+   if (ring == NULL) {
+      return NULL;
+   }
+   ring->slotSize = slotSize;
 
-   napi = wdtPriv->napi;
-   work = napi_poll_work_pending(napi, skippedPushCount);
-   while (1) {
+   for (i = 0; i < nSlots && tries < 2 * nSlots; tries++) {
+      skb = vmklnx_net_alloc_skb(NULL, NET_SKB_PAD + slotSize);
+      if (skb == NULL) {
+         break;
+      }
 
-      /* We favor looking at packets picked up from the driver but not
-       * sent up the stack instead of new packets.  This creates back-pressure
-       * to the driver and remote transmitters.
+      /*
+       * vmk_PktAlloc buffers come from a low memory heap, but don't take
+       * that for granted for a mask this tight.
        */
-
-      if (work & NAPI_STACK_PUSH_WORK) {
-	 skippedPushCount = 1;
-         /* netif_rx placed packets in napi->pktList */
-         vmk_PktListRxProcess(&napi->pktList, napi->dev->uplinkDev);
-      } else {
-	 skippedPushCount++;
-      }
-      
-      if (work & NAPI_POLL_WORK) {
-         VMKAPI_MODULE_CALL(napi->dev->module_id, status, napi->poll, napi,
-                            napi->weight);
-         if (vmklnxLROEnabled && !(napi->dev->features & NETIF_F_SW_LRO)) {
-            /* Flush all the lro sessions as we are done polling the napi context */
-            lro_flush_all(&napi->lro_mgr);
-         }
+      if (vmk_PktFragGet(skb->pkt, &frag, 0) != VMK_OK ||
+          frag.addr + NET_SKB_PAD + slotSize - 1 > dmaMask) {
+         kfree_skb(skb);
+         continue;
       }
 
-      work = napi_poll_work_pending(napi, skippedPushCount);
-      if (work == NAPI_NO_WORK) {
-         /* We're done; suspend the worldlet.*/
-         *state = VMK_WDT_SUSPEND;
-         break;
-      }
+      ring->slots[i++] = skb;
+   }
+   ring->nSlots = i;
 
-      ret = vmk_WorldletShouldYield(worldlet, &yield);
-      if (ret != VMK_OK || yield == VMK_TRUE) {
-         /* We should yield; resubmit the request. */
-         *state = VMK_WDT_READY;
-         break;
+   if (ring->nSlots < nSlots) {
+      while (--i >= 0) {
+         kfree_skb(ring->slots[i]);
       }
+      kfree(ring);
+      return NULL;
    }
 
-   return VMK_OK;
+   return ring;
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  netdev_poll --
- *
- *    Worldlet handler dedicated for napi context which were not able to create
- *    their own worldlet. This handler is called by the device worldlet, also called
- *    backup worldlet.
+ *  netdev_bounce_ring_destroy --
  *
- *    This handler is responsible of polling the different napi context and pushing 
- *    the resulting packet lists. 
+ *    Drop the ring's reference on its slots and free it. Copies still
+ *    held by the driver are freed when it releases them.
  *
  *  Results:
- *    VMK_OK always.
+ *    None.
  *
  *  Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static VMK_ReturnStatus
-netdev_poll(vmk_Worldlet worldlet,
-            void *private,
-            vmk_WorldletState *state)
+static void
+netdev_bounce_ring_destroy(struct netdev_bounce_ring *ring)
 {
-   struct napi_wdt_priv *wdtPriv = private;
-   struct net_device *dev;
-   struct napi_struct *napi;
-   int status;
-   vmk_Bool yield = VMK_TRUE;
-   VMK_ReturnStatus ret;
-   NapiPollState work;
-   vmk_Bool needWork;
-
-   VMK_ASSERT(wdtPriv);
-   VMK_ASSERT(wdtPriv->dev);
-
-   dev = wdtPriv->dev;
-
-   while (VMK_TRUE) {
-      
-      needWork = VMK_FALSE;      
-      work = NAPI_NO_WORK;
-
-      spin_lock(&dev->napi_lock);
-      list_for_each_entry(napi, &dev->napi_list, dev_list) {             
-         if (napi->dev_poll &&
-             ((work = napi_poll_work_pending(napi, 0)) != NAPI_NO_WORK)) {
-            needWork = VMK_TRUE;
-            list_move_tail(&napi->dev_list, &dev->napi_list);           
-            break;
-         }
-      }
-      spin_unlock(&dev->napi_lock);
-      
-      if (!needWork) {
-         break;
-      }
+   unsigned int i;
 
-      wdtPriv->napi = napi;
-      /* We favor looking at packets picked up from the driver but not
-       * sent up the stack instead of new packets.  This creates back-pressure
-       * to the driver and remote transmitters.
-       */
-      
-      if (work & NAPI_STACK_PUSH_WORK) {
-         /* netif_rx placed packets in napi->pktList */
-         vmk_PktListRxProcess(&napi->pktList, napi->dev->uplinkDev);
-      }
-      
-      ret = vmk_WorldletShouldYield(worldlet, &yield);
-      if (ret != VMK_OK || yield == VMK_TRUE) {
-         goto abort_yield;
-      }
-      
-      if (work & NAPI_POLL_WORK) {
-         VMKAPI_MODULE_CALL(napi->dev->module_id, status, napi->poll, napi,
-                            napi->weight);
-         if (vmklnxLROEnabled && !(napi->dev->features & NETIF_F_SW_LRO)) {
-            /* Flush all the lro sessions as we are done polling the napi context */
-            lro_flush_all(&napi->lro_mgr);
-         }
-      }
-      
-      ret = vmk_WorldletShouldYield(worldlet, &yield);
-      if (ret != VMK_OK || yield == VMK_TRUE) {
-         goto abort_yield;
-      }
+   for (i = 0; i < ring->nSlots; i++) {
+      kfree_skb(ring->slots[i]);
    }
-
-   /* We're done; suspend the worldlet.*/
-   *state = VMK_WDT_SUSPEND;
-
- done:
-   wdtPriv->napi = NULL;
-   return VMK_OK;
-   
-  abort_yield:
-   /* Resubmit the request. */
-   *state = VMK_WDT_READY;
-   goto done;
+   kfree(ring);
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  napi_poll_init --
+ *  netdev_bounce_rings_create --
  *
- *    Initialize a napi context . If the function is unable to create a unique
- *    worldlet it will attach the napi context to the one provided by the device
- *    it belongs to.
+ *    Give every tx queue of a device whose dma mask doesn't cover all of
+ *    machine memory a bounce ring for the high dma workaround. Frames
+ *    up to the current mtu fit a slot.
  *
  *  Results:
- *    VMK_OK always.
+ *    None.
  *
  *  Side effects:
- *    None.
+ *    A queue without a ring falls back to copying into a fresh skb.
  *
  *----------------------------------------------------------------------------
- */   
-static VMK_ReturnStatus
-napi_poll_init(struct napi_struct *napi)
+ */
+static void
+netdev_bounce_rings_create(struct net_device *dev)
 {
-   VMK_ReturnStatus ret;
-   vmk_ServiceAcctId serviceID;
-
-   VMK_ASSERT(napi);
-   vmk_PktListInit(&napi->pktList);
-
-   spin_lock(&napi->dev->napi_lock);
-   napi->napi_id = get_LinNetDev(napi->dev)->napiNextId++;
-   spin_unlock(&napi->dev->napi_lock);
-
-   ret = vmk_ServiceGetID("netdev", &serviceID);
-   VMK_ASSERT(ret == VMK_OK);
-
-   napi->napi_wdt_priv.dev = napi->dev;
-   napi->napi_wdt_priv.napi = napi;
-   napi->dev_poll = VMK_FALSE;
-   napi->vector = 0;
+   unsigned int slotSize;
+   u64 dmaMask;
+   int i;
 
-   ret = vmk_WorldletCreate(&napi->worldlet,
-                            "",
-                            serviceID,
-                            vmklinuxModID,
-                            napi_poll, &napi->napi_wdt_priv);
-   if (ret != VMK_OK) {
-      VMKLNX_WARN("Unable to create napi worldlet for %s, using backup\n",
-                  napi->dev->name);
-      if (napi->dev->reg_state == NETREG_REGISTERED) {
-         napi->worldlet = napi->dev->napi_worldlet;
+   if (vmklnx_high_dma_bounce_slots <= 0 || dev->pdev == NULL) {
+      return;
+   }
 
-         /*
-          * Use device global worldlet for polling this napi_struct,
-          * if worldlet creation fails
-          */
-         napi->dev_poll = VMK_TRUE;
-      } else {
-         napi->dev->reg_state = NETREG_EARLY_NAPI_ADD_FAILED;
-         return VMK_FAILURE;
-      }
+   dmaMask = dev->pdev->dma_mask;
+   if (dmaMask == 0 || dmaMask >= max_phys_addr) {
+      return;
    }
 
-   spin_lock(&napi->dev->napi_lock);
-   list_add(&napi->dev_list, &napi->dev->napi_list);   
-   spin_unlock(&napi->dev->napi_lock);
+   slotSize = max_t(unsigned int, dev->mtu, ETH_DATA_LEN) +
+              ETH_HLEN + VLAN_HLEN;
 
-   /*
-    * Keep track of which worldlet is (most probably) driving the
-    * default queue. For netqueue capable nics, we call 
-    * VMKNETDDI_QUEUEOPS_OP_GET_DEFAULT_QUEUE to figure out the
-    * default worldlet. For non-netqueue nics, the first suceessful
-    * netif_napi_add wins.
-    */
-   if (!napi->dev->default_worldlet && napi->worldlet) {
-      napi->dev->default_worldlet = napi->worldlet;
+   for (i = 0; i < dev->num_tx_queues; i++) {
+      dev->_tx[i].bounce_ring =
+         netdev_bounce_ring_create(vmklnx_high_dma_bounce_slots, slotSize,
+                                   dmaMask);
+      if (dev->_tx[i].bounce_ring == NULL) {
+         VMKLNX_WARN("%s: unable to allocate high dma bounce ring for "
+                     "tx queue %d", dev->name, i);
+      }
    }
-
-   return VMK_OK;
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  netdev_poll_init --
+ *  netdev_bounce_rings_destroy --
  *
- *    Initialize a device's backup worldlet for the napi context not able to
- *    create their own. 
+ *    Free the bounce rings of all tx queues of a device.
  *
  *  Results:
- *    VMK_OK if everything is ok, VMK_* otherwise.
+ *    None.
  *
  *  Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static VMK_ReturnStatus
-netdev_poll_init(struct net_device *dev)
+static void
+netdev_bounce_rings_destroy(struct net_device *dev)
 {
-   VMK_ReturnStatus ret;
-   vmk_ServiceAcctId serviceID;
-   
-   VMK_ASSERT(dev);
-
-   ret = vmk_ServiceGetID("netdev", &serviceID);
-   VMK_ASSERT(ret == VMK_OK);
-
-   dev->napi_wdt_priv.dev = dev;
-   dev->napi_wdt_priv.napi = NULL;
+   int i;
 
-   ret = vmk_WorldletCreate(&dev->napi_worldlet, 
-                            "",
-                            serviceID,
-                            vmklinuxModID,
-                            netdev_poll, &dev->napi_wdt_priv);
-   return ret;
+   for (i = 0; i < dev->num_tx_queues; i++) {
+      if (dev->_tx[i].bounce_ring) {
+         netdev_bounce_ring_destroy(dev->_tx[i].bounce_ring);
+         dev->_tx[i].bounce_ring = NULL;
+      }
+   }
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  netdev_set_worldlet_name --
+ *  netdev_bounce_ring_stats --
  *
- *    Initialize a device's worldlet name.
+ *    Sum up the bounce ring counters of a device over its tx queues.
  *
  *  Results:
- *    VMK_OK if everything is ok, VMK_* otherwise.
+ *    Number of tx queues with a bounce ring.
  *
  *  Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static VMK_ReturnStatus
-netdev_set_worldlets_name(struct net_device *dev)
+static int
+netdev_bounce_ring_stats(struct net_device *dev,
+                         u64 *bounced, u64 *exhausted, u64 *oversized)
 {
-   VMK_ReturnStatus status;
-   struct napi_struct *napi;
-   char name[VMK_WDT_NAME_SIZE_MAX];
-
-   VMK_ASSERT(dev);
-
-   snprintf(name, VMK_WDT_NAME_SIZE_MAX, "%s-napi-backup", dev->name);   
-   status = vmk_WorldletNameSet(dev->napi_worldlet, name);
-   VMK_ASSERT(status == VMK_OK);
+   struct netdev_bounce_ring *ring;
+   int i, nRings = 0;
 
-   spin_lock(&dev->napi_lock);
-   list_for_each_entry(napi, &dev->napi_list, dev_list) {             
-      snprintf(name, VMK_WDT_NAME_SIZE_MAX, "%s-napi-%d",
-               napi->dev->name, napi->napi_id);
-      status = vmk_WorldletNameSet(napi->worldlet, name);
-      VMK_ASSERT(status == VMK_OK);
+   *bounced = *exhausted = *oversized = 0;
+   for (i = 0; i < dev->num_tx_queues; i++) {
+      ring = dev->_tx[i].bounce_ring;
+      if (ring) {
+         *bounced += ring->bounced;
+         *exhausted += ring->exhausted;
+         *oversized += ring->oversized;
+         nRings++;
+      }
    }
-   spin_unlock(&dev->napi_lock);
-
-   return VMK_OK;
+   return nRings;
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  napi_poll_cleanup --
+ *  netdev_bounce_get --
  *
- *    Cleanup a napi structure.
+ *    Copy a linear version of base into the next slot of a bounce ring.
  *
  *  Results:
- *    None.
+ *    The copy, or NULL if base doesn't fit a slot or the ring is full.
  *
  *  Side effects:
- *    None.
+ *    Advances the ring.
  *
  *----------------------------------------------------------------------------
  */
-static void
-napi_poll_cleanup(struct napi_struct *napi)
+static struct sk_buff *
+netdev_bounce_get(struct netdev_bounce_ring *ring, struct sk_buff *base)
 {
-   VMK_ASSERT(napi);
-   VMK_ASSERT(vmk_PktListIsEmpty(&napi->pktList));
-   if (likely(!napi->dev_poll)) {
-      if (napi->vector) {
-         vmk_WorldletVectorUnSet(napi->worldlet);
-         napi->vector = 0;
-      }
-      vmk_WorldletUnref(napi->worldlet);
+   struct sk_buff *skb;
+   long offset;
+
+   if (unlikely(base->len > ring->slotSize)) {
+      ring->oversized++;
+      return NULL;
    }
-   list_del(&napi->dev_list);
+
+   skb = ring->slots[ring->next];
+   if (atomic_read(&skb->users) != 1) {
+      ring->exhausted++;
+      return NULL;
+   }
+   if (++ring->next == ring->nSlots) {
+      ring->next = 0;
+   }
+
+   skb->data = skb->head + NET_SKB_PAD;
+   skb->tail = skb->data;
+   skb->len = 0;
+   skb->data_len = 0;
+   skb_shinfo(skb)->nr_frags = 0;
+   skb_shinfo(skb)->frag_list = NULL;
+   skb_put(skb, base->len);
+   if (skb_copy_bits(base, 0, skb->data, base->len)) {
+      BUG();
+   }
+
+   offset = skb->data - base->data;
+   skb->dev = base->dev;
+   skb->queue_mapping = base->queue_mapping;
+   skb->priority = base->priority;
+   skb->protocol = base->protocol;
+   skb->ip_summed = base->ip_summed;
+   skb->csum = base->csum;
+   skb->h.raw = base->h.raw + offset;
+   skb->nh.raw = base->nh.raw + offset;
+   skb->mac.raw = base->mac.raw + offset;
+   memcpy(skb->cb, base->cb, sizeof(base->cb));
+   skb_shinfo(skb)->gso_size = skb_shinfo(base)->gso_size;
+   skb_shinfo(skb)->gso_segs = skb_shinfo(base)->gso_segs;
+   skb_shinfo(skb)->gso_type = skb_shinfo(base)->gso_type;
+
+   ring->bounced++;
+   return skb_get(skb);
 }
 
+
+/*
+ * Section: Rx page pools
+ */
+
+/*
+ * Pool of premapped receive buffers for the page based (packet split,
+ * jumbo) rx paths of a driver ring. The pages are allocated in one
+ * contiguous chunk and mapped once when the pool is created, so a
+ * buffer can be recognized by its address, and buffers of half a page
+ * or less share a page. A buffer goes back to its pool when the driver
+ * frees it or, once it hung off a received skb, when that skb's data is
+ * released. A pool that is destroyed while some of its buffers are still
+ * out is freed when the last one comes back.
+ */
+struct vmklnx_page_pool {
+   struct list_head  link;          /* on pagePoolList */
+   struct pci_dev   *pdev;
+   spinlock_t        lock;
+   char             *base;
+   u64               basePhys;
+   dma_addr_t        baseDma;
+   unsigned int      size;          /* bytes behind base */
+   unsigned int      bufSize;
+   unsigned int      nBufs;
+   unsigned int      nFree;
+   int               dead;          /* destroyed with buffers out */
+   u64               allocs;
+   u64               empty;         /* allocs the pool couldn't serve */
+   u32               freeStack[0];  /* indices of the free buffers */
+};
+
+static LIST_HEAD(pagePoolList);
+static DEFINE_RWLOCK(pagePoolLock);
+static atomic_t pagePoolCount = ATOMIC_INIT(0);
+
 /*
  *----------------------------------------------------------------------------
  *
- *  netdev_poll_cleanup --
+ *  page_pool_release --
  *
- *    Cleanup all napi structures associated with the device.
+ *    Unmap and free the memory of a page pool, which must have all its
+ *    buffers back.
  *
  *  Results:
  *    None.
  *
  *  Side effects:
- *    None.
+ *    The pool is freed.
  *
  *----------------------------------------------------------------------------
  */
 static void
-netdev_poll_cleanup(struct net_device *dev)
+page_pool_release(struct vmklnx_page_pool *pool)
 {
-   VMK_ASSERT(dev);   
-   struct list_head *ele, *next;
-   struct napi_struct *napi;
+   unsigned long flags;
 
-   /*
-    * Cleanup all napi structs
-    */
-   list_for_each_safe(ele, next, &dev->napi_list) {
-      napi = list_entry(ele, struct napi_struct, dev_list);
-      napi_poll_cleanup(napi);
-   }
+   write_lock_irqsave(&pagePoolLock, flags);
+   list_del(&pool->link);
+   atomic_dec(&pagePoolCount);
+   write_unlock_irqrestore(&pagePoolLock, flags);
 
-   if (dev->napi_worldlet) {
-      vmk_WorldletUnref(dev->napi_worldlet);
-   }
+   pci_unmap_single(pool->pdev, pool->baseDma, pool->size,
+                    PCI_DMA_FROMDEVICE);
+   vmklnx_kfree(VMK_MODULE_HEAP_ID, pool->base);
+   kfree(pool);
 }
 
-/**
- * __napi_schedule - schedule for receive
- * @napi: entry to schedule
+/*
+ *----------------------------------------------------------------------------
  *
- * The entry's receive function will be scheduled to run
+ *  vmklnx_page_pool_create --
  *
- * RETURN VALUE:
- * None
- */
-/* _VMKLNX_CODECHECK_: __napi_schedule */
-void 
-__napi_schedule(struct napi_struct *napi)
-{
-   vmk_uint32 myVector = 0;
-   vmk_Bool inIntr = vmk_ContextIsInterruptHandler(&myVector);
-   VMK_ASSERT(napi);
-
-   if (unlikely(napi->vector != myVector)) {
-      if (likely(inIntr)) {
-         vmk_WorldletVectorSet(napi->worldlet, myVector);
-         napi->vector = myVector;
-      }
-   }
-
-   vmk_WorldletActivate(napi->worldlet);
-}
-
-/**
- *      napi_disable - prevent NAPI from scheduling
- *      @napi: napi context
+ *    Create a pool of nBufs premapped rx buffers of bufSize bytes for
+ *    pdev. bufSize must divide PAGE_SIZE; a smaller buffer makes a page
+ *    serve several descriptors. nBufs is cut down to what
+ *    vmklnx_rx_page_pool_kb allows.
  *
- * Stop NAPI from being scheduled on this context.
- * Waits till any outstanding processing completes.
+ *  Results:
+ *    The pool, or NULL if pools are disabled or there's no memory for
+ *    one. Callers then allocate their pages as before.
  *
- * RETURN VALUE:
- * None
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
  */
-/* _VMKLNX_CODECHECK_: napi_disable */
-void
-napi_disable(struct napi_struct *napi)
+struct vmklnx_page_pool *
+vmklnx_page_pool_create(struct pci_dev *pdev, unsigned int nBufs,
+                        unsigned int bufSize)
 {
-   vmk_WorldletState state;
-   VMK_ReturnStatus ret;
-
-   VMK_ASSERT(napi);
+   struct vmklnx_page_pool *pool;
+   unsigned long flags;
+   unsigned int maxBufs, i;
 
-   set_bit(NAPI_STATE_DISABLE, &napi->state);
-   while (1) {
-      ret = vmk_WorldletCheckState(napi->worldlet, &state);
-      VMK_ASSERT(ret == VMK_OK);
+   if (bufSize == 0 || bufSize > PAGE_SIZE || PAGE_SIZE % bufSize) {
+      return NULL;
+   }
 
-      /* If the worldlet isn't running/set to run, then we see if we can
-       * disable it from running in the future by blocking off
-       * NAPI_STATE_SCHED.
-       */
-      if (state == VMK_WDT_SUSPEND  && 
-          !test_and_set_bit(NAPI_STATE_SCHED, &napi->state)) {
-         VMK_DEBUG_ONLY(
-            ret = vmk_WorldletCheckState(napi->worldlet, &state);
-            VMK_ASSERT(state == VMK_WDT_SUSPEND);
-            );
-         break;
-      }
-      /**
-       * Give the flush a chance to run.
-       */
-      schedule_timeout_interruptible(1);
+   maxBufs = ((unsigned int)vmklnx_rx_page_pool_kb * 1024) / bufSize;
+   nBufs = min(nBufs, maxBufs);
+   nBufs = ALIGN(nBufs, PAGE_SIZE / bufSize);
+   if (nBufs == 0) {
+      return NULL;
    }
 
-   clear_bit(NAPI_STATE_DISABLE, &napi->state);
-}
+   pool = kzalloc(sizeof(*pool) + nBufs * sizeof(pool->freeStack[0]),
+                  GFP_KERNEL);
+   if (pool == NULL) {
+      return NULL;
+   }
 
-/**
- * netif_napi_add - initialize a napi context
- * @dev:  network device
- * @napi: napi context
- * @poll: polling function
- * @weight: default weight
- *
- * netif_napi_add() must be used to initialize a napi context prior to calling
- * *any* of the other napi related functions.
- *
- * RETURN VALUE:
- * None
- */
-/* _VMKLNX_CODECHECK_: netif_napi_add */
-void 
-netif_napi_add(struct net_device *dev,
-               struct napi_struct *napi,
-               int (*poll)(struct napi_struct *, int),
-               int weight)
-{
-        struct net_lro_mgr *lro_mgr;
+   pool->size = nBufs * bufSize;
+   pool->base = vmklnx_kmalloc_align(VMK_MODULE_HEAP_ID, pool->size,
+                                     PAGE_SIZE);
+   if (pool->base == NULL) {
+      kfree(pool);
+      return NULL;
+   }
 
-        napi->poll = poll;
-        napi->weight = weight;
-        napi->dev = dev;
+   pool->pdev = pdev;
+   pool->basePhys = virt_to_phys(pool->base);
+   pool->baseDma = pci_map_single(pdev, pool->base, pool->size,
+                                  PCI_DMA_FROMDEVICE);
+   pool->bufSize = bufSize;
+   pool->nBufs = nBufs;
+   spin_lock_init(&pool->lock);
 
-        lro_mgr = &napi->lro_mgr;
-        lro_mgr->dev = dev;
-        lro_mgr->features = LRO_F_NAPI;
-        lro_mgr->ip_summed = CHECKSUM_UNNECESSARY;
-        lro_mgr->ip_summed_aggr = CHECKSUM_UNNECESSARY;
-        lro_mgr->max_desc = LRO_DEFAULT_MAX_DESC;
-        lro_mgr->lro_arr = napi->lro_desc;
-        lro_mgr->get_skb_header = vmklnx_net_lro_get_skb_header;
-        lro_mgr->get_frag_header = NULL;
-        lro_mgr->max_aggr = vmklnxLROMaxAggr;
-        lro_mgr->frag_align_pad = 0;
+   /* hand out the buffers of the first pages first */
+   for (i = 0; i < nBufs; i++) {
+      pool->freeStack[i] = nBufs - 1 - i;
+   }
+   pool->nFree = nBufs;
 
-        napi_poll_init(napi);
+   write_lock_irqsave(&pagePoolLock, flags);
+   list_add(&pool->link, &pagePoolList);
+   atomic_inc(&pagePoolCount);
+   write_unlock_irqrestore(&pagePoolLock, flags);
 
-        set_bit(NAPI_STATE_SCHED, &napi->state); 
+   return pool;
 }
 
-/**
- *  netif_napi_del - remove a napi context
- *  @napi: napi context
+/*
+ *----------------------------------------------------------------------------
  *
- *  netif_napi_del() removes a napi context from the network device napi list
+ *  vmklnx_page_pool_destroy --
  *
- * RETURN VALUE:
- * None
- */
-/* _VMKLNX_CODECHECK_: netif_napi_del */
-void 
-netif_napi_del(struct napi_struct *napi)
-{
-   napi_poll_cleanup(napi);
-}
-
-/**
- *      napi_enable - enable NAPI scheduling
- *      @n: napi context
+ *    Destroy a page pool. Buffers still held by the driver must have been
+ *    given back; buffers still hanging off skbs may come back later.
  *
- * Resume NAPI from being scheduled on this context.
- * Must be paired with napi_disable.
- * 
- * RETURN VALUE:
- * None
+ *  Results:
+ *    None.
+ *
+ *  Side effects:
+ *    The pool is freed now or when its last buffer comes back.
+ *
+ *----------------------------------------------------------------------------
  */
-/* _VMKLNX_CODECHECK_: napi_enable */
 void
-napi_enable(struct napi_struct *napi)
+vmklnx_page_pool_destroy(struct vmklnx_page_pool *pool)
 {
-   struct net_lro_mgr *lro_mgr;
-   int idx;
-
-   BUG_ON(!test_bit(NAPI_STATE_SCHED, &napi->state));
+   unsigned long flags;
+   int release;
 
-   lro_mgr = &napi->lro_mgr;
-   for (idx = 0; idx < lro_mgr->max_desc; idx++) {
-      memset(&napi->lro_desc[idx], 0, sizeof(struct net_lro_desc));
+   if (pool == NULL) {
+      return;
    }
 
-   smp_mb__before_clear_bit();
-   clear_bit(NAPI_STATE_SCHED, &napi->state);  
-}
-
+   spin_lock_irqsave(&pool->lock, flags);
+   pool->dead = 1;
+   release = (pool->nFree == pool->nBufs);
+   spin_unlock_irqrestore(&pool->lock, flags);
 
-/*
- * Section: Skb helpers
- */
+   if (release) {
+      page_pool_release(pool);
+   }
+}
 
 /*
  *----------------------------------------------------------------------------
  *
- *  do_init_skb_bits --
+ *  vmklnx_page_pool_alloc --
  *
- *    Initialize a socket buffer.
+ *    Take a buffer from a page pool.
  *
  *  Results:
- *    None.
+ *    The page holding the buffer, with the buffer's offset in the page
+ *    and its bus address in *offset and *dma. NULL if pool is NULL or
+ *    has no free buffer; the caller falls back to alloc_page then.
  *
  *  Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static inline void
-do_init_skb_bits(struct sk_buff *skb, kmem_cache_t *cache)
+struct page *
+vmklnx_page_pool_alloc(struct vmklnx_page_pool *pool, unsigned int *offset,
+                       dma_addr_t *dma)
 {
-   skb->qid = VMKNETDDI_QUEUEOPS_INVALID_QUEUEID;
-   skb->next = NULL;
-   skb->prev = NULL;
-   skb->head = NULL;
-   skb->data = NULL;
-   skb->tail = NULL;
-   skb->end = NULL;
-   skb->dev = NULL;
-   skb->pkt = NULL;
-   atomic_set(&skb->users, 1);
-   skb->cache = cache;
-   skb->mhead = 0;
-   skb->len = 0;
-   skb->data_len = 0;
-   skb->ip_summed = CHECKSUM_NONE;
-   skb->csum = 0;
-   skb->priority = 0;
-   skb->protocol = 0;
-   skb->truesize = 0;
-   skb->mac.raw = NULL;
-   skb->nh.raw = NULL;
-   skb->h.raw = NULL;
-   skb->napi = NULL;
-   skb->lro_ready = 0;
+   unsigned long flags;
+   unsigned int pos;
 
-   /* VLAN_RX_SKB_CB shares the same space so this is sufficient */
-   VLAN_TX_SKB_CB(skb)->magic = 0;
-   VLAN_TX_SKB_CB(skb)->vlan_tag = 0;
+   if (pool == NULL) {
+      return NULL;
+   }
 
-   atomic_set(&(skb_shinfo(skb)->dataref), 1);
-   atomic_set(&(skb_shinfo(skb)->fragsref), 1);
-   skb_shinfo(skb)->nr_frags = 0;
-   skb_shinfo(skb)->frag_list = NULL;
-   skb_shinfo(skb)->gso_size = 0;
-   skb_shinfo(skb)->gso_segs = 0;
-   skb_shinfo(skb)->gso_type = 0;
-   skb_shinfo(skb)->ip6_frag_id = 0;
+   spin_lock_irqsave(&pool->lock, flags);
+   if (unlikely(pool->nFree == 0)) {
+      pool->empty++;
+      spin_unlock_irqrestore(&pool->lock, flags);
+      return NULL;
+   }
+   pos = pool->freeStack[--pool->nFree] * pool->bufSize;
+   pool->allocs++;
+   spin_unlock_irqrestore(&pool->lock, flags);
+
+   *offset = pos & ~PAGE_MASK;
+   *dma = pool->baseDma + pos;
+   return virt_to_page(pool->base + (pos & PAGE_MASK));
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  do_bind_skb_to_pkt --
+ *  vmklnx_page_pool_owns --
  *
- *    Bind a socket buffer to a packet handle.
+ *    Tell whether page was handed out by pool.
  *
  *  Results:
- *    None.
+ *    TRUE or FALSE.
  *
  *  Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static inline void
-do_bind_skb_to_pkt(struct sk_buff *skb, vmk_PktHandle *pkt, unsigned int size)
+int
+vmklnx_page_pool_owns(struct vmklnx_page_pool *pool, struct page *page)
 {
-   vmk_PktFrag frag;
-
-   if (vmk_PktFragGet(pkt, &frag, 0) != VMK_OK) {
-      VMK_ASSERT(0);
-      return;
-   }
-
-   skb->pkt = pkt;
-   skb->head = phys_to_virt(frag.addr);
-   skb->end = skb->head + size;
-   skb->data = skb->head;
-   skb->tail = skb->head;
-
-#ifdef VMX86_DEBUG
-   /* Added to assert earlier to catch PR 62560 */
-   virt_to_phys(skb->tail);
-
-   /*
-    * linux guarantees physical contiguity of the pages backing
-    * skb's returned by this routine, so the drivers assume that.
-    * we guarantee this by backing the buffers returned from 
-    * vmk_PktAlloc with a large-page, low-memory heap which is
-    * guaranteed to be physically contiguous, so we just double 
-    * check it here.
-    */
-   {
-      vmk_Bool isFlat;
-      
-      isFlat = vmk_PktIsFlatBuffer(pkt);
-      VMK_ASSERT(isFlat);
-   }  
-#endif // VMX86_DEBUG
-}  
+   return pool != NULL && page != NULL &&
+          page_to_phys(page) - pool->basePhys < pool->size;
+}
 
 /*
  *----------------------------------------------------------------------------
  *
- *  do_alloc_skb --
+ *  page_pool_put --
  *
- *    Allocate a socket buffer.
+ *    Push a buffer back on the free stack of its pool.
  *
  *  Results:
- *    A pointer to the allocated socket buffer.
+ *    TRUE if the pool was destroyed and this was its last buffer out, in
+ *    which case the caller must release it.
  *
  *  Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static struct sk_buff *
-do_alloc_skb(kmem_cache_t *cache)
+static int
+page_pool_put(struct vmklnx_page_pool *pool, struct page *page,
+              unsigned int offset)
 {
-   struct sk_buff *skb;
+   unsigned long flags;
+   unsigned int idx;
+   int release;
 
-   if (!cache) {
-      if (vmklnx_skb_cache) {    
-         cache = vmklnx_skb_cache;
-      } else {
-         return NULL;
-      }
-   }
+   idx = (page_to_phys(page) + offset - pool->basePhys) / pool->bufSize;
 
-   skb = vmklnx_kmem_cache_alloc(cache);
-   if (unlikely(skb == NULL)) {
-      return NULL;
-   }
+   spin_lock_irqsave(&pool->lock, flags);
+   VMK_ASSERT(pool->nFree < pool->nBufs);
+   pool->freeStack[pool->nFree++] = idx;
+   release = pool->dead && pool->nFree == pool->nBufs;
+   spin_unlock_irqrestore(&pool->lock, flags);
 
-   do_init_skb_bits(skb, cache);
-   return skb;
+   return release;
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  vmklnx_net_alloc_skb --
+ *  vmklnx_page_pool_free --
  *
- *    Allocate a socket buffer for a specified size and bind it to a packet handle.
+ *    Give a buffer back to the pool it came from. The buffer stays
+ *    mapped for its next use.
  *
  *  Results:
- *    A pointer the allocated socket buffer.
+ *    None.
  *
  *  Side effects:
- *    None.
+ *    Frees the pool if it was destroyed and this was its last buffer.
  *
  *----------------------------------------------------------------------------
  */
-struct sk_buff *
-vmklnx_net_alloc_skb(kmem_cache_t *cache, unsigned int size)
+void
+vmklnx_page_pool_free(struct vmklnx_page_pool *pool, struct page *page,
+                      unsigned int offset)
 {
-   vmk_PktHandle *pkt;
-   struct sk_buff *skb;
-
-   skb = do_alloc_skb(cache);
-
-   if (unlikely(skb == NULL)) {
-      goto done;
-   }
+   VMK_ASSERT(vmklnx_page_pool_owns(pool, page));
 
-   vmk_PktAlloc(size, &pkt);      
-  
-   if (unlikely(pkt == NULL)) {
-      do_free_skb(skb);
-      skb = NULL;
-      goto done;
+   if (page_pool_put(pool, page, offset)) {
+      page_pool_release(pool);
    }
-
-   do_bind_skb_to_pkt(skb, pkt, size);
-
- done:   
-   return skb;
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  vmklnx_net_skb_complete --
+ *  vmklnx_page_pool_put_frags --
  *
- *    Completion handler for packet coming from vmklinux and requiring it.
+ *    Called as the data of an skb with page frags is released. Gives the
+ *    buffers of the frags that came from a page pool back to it.
  *
  *  Results:
  *    None.
  *
  *  Side effects:
- *    None.
+ *    Frees the pools that were destroyed and got their last buffer back.
  *
  *----------------------------------------------------------------------------
  */
-static VMK_ReturnStatus
-vmklnx_net_skb_complete(void *reserved,
-                        vmk_UplinkCompletionData data,
-                        vmk_PktList *pktList)
+void
+vmklnx_page_pool_put_frags(struct sk_buff *skb)
 {
-   vmk_PktHandle *pkt;
-   struct sk_buff *skb;
-   struct sk_buff *skbToRelease;
-   struct sk_buff *next_skb;
-   struct net_device *dev = data;
-   vmk_PktCompletionData genCount;
+   struct vmklnx_page_pool *pool, *dead[MAX_SKB_FRAGS];
+   skb_frag_t *frag;
+   unsigned long flags;
+   int i, nDead = 0;
 
-   while (!vmk_PktListIsEmpty(pktList)) {
-      pkt = vmk_PktListPopHead(pktList);
-      
-      vmk_PktGetCompletionData(pkt, 
-                               (vmk_PktCompletionData *)&skb, &genCount);
+   if (atomic_read(&pagePoolCount) == 0) {
+      return;
+   }
 
-      /* Check if the packet really belongs to this device */
-      if (likely(genCount == dev->genCount)) {
-         skbToRelease = skb_shinfo(skb)->frag_list;
-         while (skbToRelease) {
-            next_skb = skbToRelease->next;         
-            vmk_PktReleaseAfterComplete(skbToRelease->pkt);
-            do_free_skb(skbToRelease);
-            skbToRelease = next_skb;
+   /* a pool stays listed until all its buffers are back */
+   read_lock_irqsave(&pagePoolLock, flags);
+   for (i = 0; i < skb_shinfo(skb)->nr_frags; i++) {
+      frag = &skb_shinfo(skb)->frags[i];
+      list_for_each_entry(pool, &pagePoolList, link) {
+         if (vmklnx_page_pool_owns(pool, frag->page)) {
+            if (page_pool_put(pool, frag->page, frag->page_offset)) {
+               dead[nDead++] = pool;
+            }
+            break;
          }
-
-         dev->linnet_pkt_completed++;
-         atomic_dec(&dev->rxInFlight);
-         vmk_PktClearCompletionData(pkt);      
-         vmk_PktReleaseAfterComplete(pkt);
-         do_free_skb(skb);
-      } else {
-         VMKLNX_WARN("Orphan packet genCount=%p instead of %p\n",
-                     genCount, dev->genCount);
-         vmk_PktClearCompletionData(pkt);      
-         vmk_PktReleaseAfterComplete(pkt);
       }
    }
+   read_unlock_irqrestore(&pagePoolLock, flags);
 
-   VMK_ASSERT(atomic_read(&dev->rxInFlight) >= 0);
-   return VMK_OK;
+   while (nDead > 0) {
+      page_pool_release(dead[--nDead]);
+   }
 }
 
+/*
+ * Section: Adaptive interrupt moderation
+ */
+
 /*
  *----------------------------------------------------------------------------
  *
- *  do_free_skb --
+ *  vmklnx_itr_init --
  *
- *    Release socket buffer.
+ *    Set up the moderation state of one interrupt vector. rate is the
+ *    interrupts/sec the hardware is programmed for now; the vector
+ *    starts out in the lowest latency class. set_interval is called
+ *    with data and the new interval in usecs whenever the rate changes.
  *
  *  Results:
  *    None.
@@ -1350,87 +3410,205 @@ vmklnx_net_skb_complete(void *reserved,
  *
  *----------------------------------------------------------------------------
  */
-static void
-do_free_skb(struct sk_buff *skb)
+void
+vmklnx_itr_init(struct vmklnx_itr *itr,
+                const struct vmklnx_itr_profile *profile,
+                u32 rate, vmklnx_itr_set_fn set_interval, void *data)
 {
-   vmklnx_kmem_cache_free(skb->cache, skb);
+   VMK_ASSERT(profile->smooth_pct > 0 && profile->smooth_pct <= 100);
+
+   itr->profile = profile;
+   itr->set_interval = set_interval;
+   itr->data = data;
+   memset(itr->packets, 0, sizeof(itr->packets));
+   memset(itr->bytes, 0, sizeof(itr->bytes));
+   itr->rate = rate ? rate : profile->rate[VMKLNX_ITR_LOWEST_LATENCY];
+   memset(itr->cls, VMKLNX_ITR_LOWEST_LATENCY, sizeof(itr->cls));
 }
 
-/**
- *  __kfree_skb - private function
- *  @skb: buffer
+/*
+ *----------------------------------------------------------------------------
  *
- *  Free an sk_buff. Release anything attached to the buffer.
- *  Clean the state. This is an internal helper function. Users should
- *  always call kfree_skb
+ *  vmklnx_itr_classify --
  *
- * RETURN VALUE:
- * None
+ *    Move the class of one direction at most one step towards the class
+ *    of bpus bytes/usec.
+ *
+ *  Results:
+ *    The new class.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
  */
-/* _VMKLNX_CODECHECK_: __kfree_skb */
-void
-__kfree_skb(struct sk_buff *skb)
-{
-   if (unlikely(!atomic_dec_and_test(&skb->users))) {
-      return;
+static u8
+vmklnx_itr_classify(const struct vmklnx_itr_profile *profile, u8 cls,
+                    u32 bpus)
+{
+   switch (cls) {
+   case VMKLNX_ITR_LOWEST_LATENCY:
+      if (bpus > profile->low_bpus) {
+         cls = VMKLNX_ITR_LOW_LATENCY;
+      }
+      break;
+   case VMKLNX_ITR_LOW_LATENCY:
+      if (bpus > profile->high_bpus) {
+         cls = VMKLNX_ITR_BULK;
+      } else if (bpus <= profile->low_bpus) {
+         cls = VMKLNX_ITR_LOWEST_LATENCY;
+      }
+      break;
+   case VMKLNX_ITR_BULK:
+   default:
+      if (bpus <= profile->high_bpus) {
+         cls = VMKLNX_ITR_LOW_LATENCY;
+      }
+      break;
    }
-
-   skb_release_data(skb);   
-   do_free_skb(skb);
+   return cls;
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- *  skb_debug_info -- 
- *      Debug function to print contents of a socket buffer.
+ *  vmklnx_itr_update --
+ *
+ *    Classify the rx and the tx traffic added since the last call, each
+ *    on its own, and move the interrupt rate towards the target of the
+ *    higher of the two classes. Summing both directions would push a
+ *    vector with moderate traffic each way into the bulk class. The
+ *    bytes are taken to have arrived over one interval at the current
+ *    rate, so the drivers must add what they handled since the last
+ *    interrupt. A class only moves one step per call, which keeps a
+ *    single burst from swinging the rate, and each rate change is
+ *    smoothed with the profile's smooth_pct. A direction without
+ *    packets keeps its class.
  *
  *  Results:
- *    None.
+ *    The interval in usecs the vector runs at from now on.
  *
  *  Side effects:
- *    None.
+ *    The counters are cleared. set_interval is called if the rate
+ *    changed.
+ *
  *----------------------------------------------------------------------------
  */
-void
-skb_debug_info(struct sk_buff *skb)
+u32
+vmklnx_itr_update(struct vmklnx_itr *itr)
 {
-   int f;
-   skb_frag_t *frag;
+   const struct vmklnx_itr_profile *profile = itr->profile;
+   u32 usecs, target, rate;
+   u8 cls = VMKLNX_ITR_LOWEST_LATENCY;
+   int dir;
 
-   printk(KERN_ERR "skb\n"
-          "   head     <%p>\n"
-          "   mhead    <%u>\n"
-          "   data     <%p>\n"
-          "   tail     <%p>\n"
-          "   end      <%p>\n"
-          "   data_len <%u>\n"
-          "   nr_frags <%u>\n"
-          "   dataref  <%u>\n"
-          "   gso_size <%u>\n",
-          skb->head, skb->mhead,
-          skb->data, skb->tail, skb->end,
-          skb->data_len,
-          skb_shinfo(skb)->nr_frags,
-          atomic_read(&(skb_shinfo(skb)->dataref)),
-          skb_shinfo(skb)->gso_size);
+   if (itr->packets[VMKLNX_ITR_RX] == 0 && itr->packets[VMKLNX_ITR_TX] == 0) {
+      goto done;
+   }
 
-   for (f = 0; f < skb_shinfo(skb)->nr_frags; f++) {
-      frag = &skb_shinfo(skb)->frags[f];
-      printk(KERN_ERR "skb frag %d\n"
-             "   page         <0x%llx>\n"
-             "   page_offset  <%u>\n"
-             "   size         <%u>\n",
-             f, page_to_phys(frag->page),
-             frag->page_offset, frag->size);
+   usecs = max_t(u32, 1000000 / itr->rate, 1);
+   for (dir = 0; dir < VMKLNX_ITR_NUM_DIRS; dir++) {
+      if (itr->packets[dir] != 0) {
+         itr->cls[dir] = vmklnx_itr_classify(profile, itr->cls[dir],
+                                             itr->bytes[dir] / usecs);
+      }
+      cls = max(cls, itr->cls[dir]);
    }
-}
 
+   target = profile->rate[cls];
+   if (target != itr->rate) {
+      rate = ((itr->rate * (100 - profile->smooth_pct)) +
+              (target * profile->smooth_pct)) / 100;
+      /* don't get stuck a rounding error away from the target */
+      if (rate == itr->rate) {
+         rate = target;
+      }
+      itr->rate = rate;
+      itr->set_interval(itr->data, max_t(u32, 1000000 / rate, 1));
+   }
+
+done:
+   memset(itr->packets, 0, sizeof(itr->packets));
+   memset(itr->bytes, 0, sizeof(itr->bytes));
+   return max_t(u32, 1000000 / itr->rate, 1);
+}
 
 /*
  * Section: Transmit path
  */
 
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_tx_stage_drain --
+ *
+ *    Move the packets staged in the tx staging ring of a soft queue to
+ *    its outputList, in the order their slots were claimed, as far as
+ *    outputListMaxSize allows. What doesn't fit stays in its slot for the
+ *    next drain: outputList can be fuller than the producers saw when
+ *    they staged, as process_tx_queue puts back what the driver refused.
+ *    The packets of a queue that got blocked or stopped in the meantime
+ *    are dropped.
+ *
+ *    queue_lock makes the caller the single consumer of the ring.
+ *    The soft queue must have a staging ring.
+ *
+ *   Results:
+ *    None.
+ *
+ *   Side effects:
+ *    Packets that can't be queued are put on freePktsList.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+netdev_tx_stage_drain(struct netdev_queue *queue, vmk_PktList *freePktsList)
+{
+   struct netdev_soft_queue *softq = &queue->softq;
+   struct netdev_tx_stage *stage = softq->stage;
+   struct netdev_tx_stage_slot *slot;
+   unsigned int pos;
+   vmk_uint32 pktsCount, queued;
+
+   VMK_ASSERT(spin_is_locked(&softq->queue_lock));
+   VMK_ASSERT(stage != NULL);
+
+   for (;;) {
+      pos = stage->tail;
+      slot = &stage->ring[pos & (NETDEV_TX_STAGE_SLOTS - 1)];
+      if (atomic_read(&slot->seq) != (int) (pos + 1)) {
+         /* empty, or the producer of this slot hasn't filled it yet */
+         break;
+      }
+      smp_rmb();
+
+      pktsCount = vmk_PktListCount(&slot->pktList);
+      if (unlikely(softq->state !=
+                   (LIN_NET_QUEUE_UNBLOCKED|LIN_NET_QUEUE_STARTED))) {
+         vmk_PktListJoin(freePktsList, &slot->pktList);
+      } else {
+         queued = vmk_PktListCount(&softq->outputList);
+         if (unlikely(queued + pktsCount >= softq->outputListMaxSize)) {
+            /* move what fits, the slot stays published with the rest */
+            if (queued < softq->outputListMaxSize) {
+               vmk_PktListAppendN(&softq->outputList, &slot->pktList,
+                                  softq->outputListMaxSize - queued);
+               atomic_sub(pktsCount - vmk_PktListCount(&slot->pktList),
+                          &stage->pkts);
+            }
+            break;
+         }
+         vmk_PktListJoin(&softq->outputList, &slot->pktList);
+      }
+      atomic_sub(pktsCount, &stage->pkts);
+
+      /* hand the slot back to the producers for the next lap */
+      smp_mb();
+      atomic_set(&slot->seq, pos + NETDEV_TX_STAGE_SLOTS);
+      stage->tail = pos + 1;
+   }
+}
+
 /*
  *----------------------------------------------------------------------------
  *
@@ -1463,6 +3641,14 @@ skb_debug_info(struct sk_buff *skb)
  *    some cases call netif_schedule unnecessarily, but it ensures that 
  *    pkts are not left stranded on dev->outputList.
  *
+ *    With the tx staging ring in use, the packets staged so far are first
+ *    moved to dev->outputList, see netdev_tx_stage.
+ *
+ *    Packets are taken off dev->outputList in bursts of up to
+ *    vmklnx_tx_burst. A burst is mapped to skbs up front and handed to
+ *    hard_start_xmit back to back under a single hold of xmit_lock, with
+ *    skb->xmit_more set on all but the last skb of the burst.
+ *
  *   Results:
  *    Returns 1 if rescheduled; 0 if all packets were drained.
  *
@@ -1482,15 +3668,33 @@ process_tx_queue(struct netdev_queue *queue, vmk_PktList *freePktsList)
    struct net_device *dev = queue->dev;
    struct netdev_soft_queue *softq = &queue->softq;
    vmk_PktList *pktList = &softq->outputList;
+   vmk_PktList burstList;
+   struct sk_buff *burst[NETDEV_TX_BURST_MAX];
+   uint32_t burstMax, burstLen, nSkbs, sent;
+   struct netdev_queue_stats *stats;
+   unsigned long flags;
+   u64 bytes;
 
    VMK_ASSERT(spin_is_locked(&softq->queue_lock));
 
+   if (softq->stage != NULL) {
+      netdev_tx_stage_drain(queue, freePktsList);
+   }
+
    if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfFailTxAndStopQueue)) {
       netif_tx_stop_queue(queue);
    }
 
+   if (unlikely(vmklnx_tx_burst < 1)) {
+      burstMax = 1;
+   } else if (unlikely(vmklnx_tx_burst > NETDEV_TX_BURST_MAX)) {
+      burstMax = NETDEV_TX_BURST_MAX;
+   } else {
+      burstMax = vmklnx_tx_burst;
+   }
+
    while (!vmk_PktListIsEmpty(pktList) && (iter < softq->outputListMaxSize)) {
-      int xmit_status = -1;
+      int xmit_status = 0;
 
       VMK_ASSERT(dev->flags & IFF_UP);
       
@@ -1534,8 +3738,15 @@ process_tx_queue(struct netdev_queue *queue, vmk_PktList *freePktsList)
          goto done_unfinished;
       }
       
-      pkt = vmk_PktListPopHead(pktList);
-      VMK_ASSERT(pkt);
+      /*
+       * Pull a burst off the head of the output list. It is detached
+       * while queue_lock is held so packet order is preserved.
+       */
+      burstLen = min(burstMax, softq->outputListMaxSize - iter);
+      burstLen = min(burstLen, (uint32_t) vmk_PktListCount(pktList));
+      VMK_ASSERT(burstLen > 0);
+      vmk_PktListInit(&burstList);
+      vmk_PktListAppendN(&burstList, pktList, burstLen);
 
       /* 
        * Release queue and call driver.
@@ -1549,43 +3760,86 @@ process_tx_queue(struct netdev_queue *queue, vmk_PktList *freePktsList)
       spin_unlock(&softq->queue_lock);
       
       /*
-       * Map packets to skbs
-       *
-       * XXX: Revisit batching pkt->skb mapping (on whole or partial list) 
-       *      before we dunk into the driver
+       * Map the whole burst to skbs before dunking into the driver so
+       * that hard_start_xmit is called back to back.
        */
-      if (unlikely(map_pkt_to_skb(dev, queue, pkt, &skb) != VMK_OK)) {
-         VMKLNX_DEBUG(0, "%s: Unable to map packet to skb. Dropping", 
-                      dev->name);
-         vmk_PktListAddToTail(freePktsList, pkt);
-         queue->processing_tx = 0;
-	 spin_unlock(&queue->_xmit_lock);
-         spin_lock(&softq->queue_lock);
-         continue;
+      nSkbs = 0;
+      while (!vmk_PktListIsEmpty(&burstList)) {
+         pkt = vmk_PktListPopHead(&burstList);
+         if (unlikely(map_pkt_to_skb(dev, queue, pkt, &skb) != VMK_OK)) {
+            VMKLNX_DEBUG(0, "%s: Unable to map packet to skb. Dropping", 
+                         dev->name);
+            vmk_PktListAddToTail(freePktsList, pkt);
+            continue;
+         }
+         burst[nSkbs++] = skb;
       }
 
-      VMKAPI_MODULE_CALL(dev->module_id, xmit_status, 
-                         *dev->hard_start_xmit, skb, dev);
+      /*
+       * Let the driver know more packets are following so it may
+       * defer its doorbell write until the last one of the burst.
+       */
+      bytes = 0;
+      for (sent = 0; sent < nSkbs; sent++) {
+         unsigned int len;
+
+         skb = burst[sent];
+         skb->xmit_more = (sent + 1 < nSkbs);
+
+         if (unlikely(sent > 0 && netif_tx_queue_stopped(queue))) {
+            /* the driver stopped its queue on the previous packet */
+            xmit_status = NETDEV_TX_BUSY;
+            break;
+         }
+
+         /* the driver owns the skb once it accepts it */
+         len = skb->len;
+         VMKAPI_MODULE_CALL(dev->module_id, xmit_status, 
+                            *dev->hard_start_xmit, skb, dev);
+         if (unlikely(xmit_status != 0)) {
+            break;
+         }
+         bytes += len;
+      }
       
       queue->processing_tx = 0;
       spin_unlock(&queue->_xmit_lock);
       spin_lock(&softq->queue_lock);
+
+      stats = netdev_tx_stats_get(queue, &flags);
+      stats->packets += sent;
+      stats->bytes += bytes;
+      stats->batches++;
+      stats->batchPkts += sent;
+      stats->requeued += nSkbs - sent;
+      netdev_stats_put(flags);
+
+      /* packets that failed to map were dropped, not sent */
+      iter += sent;
       
-      if (xmit_status != 0) {
+      if (sent < nSkbs) {
          VMKLNX_DEBUG(1, "hard_start_xmit failed (status %d; Q stopped %d. "
-	              "Queuing packet. pkt=%p dev=%s\n", 
+	              "Queuing %u packets. pkt=%p dev=%s\n", 
 	              xmit_status, netif_tx_queue_stopped(queue),
-                      skb->pkt, dev->name);
+                      nSkbs - sent, burst[sent]->pkt, dev->name);
 
-         /* destroy skb and its resources besides the packet handle itself. */
-         atomic_inc(&(skb_shinfo(skb)->fragsref));
-         dev_kfree_skb_any(skb);
-         
          /*
-          * sticking pkt back this way may cause tx re-ordering, 
-          * but this should be very rare.
+          * Put the failed packet and whatever followed it in the burst
+          * back on the output list, last one first to keep their order.
+          * Sticking pkts back this way may cause tx re-ordering, but
+          * this should be very rare.
           */
-         vmk_PktListAddToHead(pktList, pkt);
+         while (nSkbs > sent) {
+            skb = burst[--nSkbs];
+            pkt = skb->pkt;
+
+            /* destroy skb and its resources besides the packet handle itself. */
+            atomic_inc(&(skb_shinfo(skb)->fragsref));
+            dev_kfree_skb_any(skb);
+
+            vmk_PktListAddToHead(pktList, pkt);
+         }
+
          if (netif_tx_queue_stopped(queue)) {
             // netif_wake_queue will trigger subsequent xmit
             VMKLNX_DEBUG(3, "queue still stopped.");
@@ -1599,9 +3853,6 @@ process_tx_queue(struct netdev_queue *queue, vmk_PktList *freePktsList)
             goto reschedule;
          }
       }
-      
-      dev->linnet_tx_packets++;
-      iter++;
    }
    
    if (!vmk_PktListIsEmpty(pktList)) {
@@ -1662,7 +3913,7 @@ net_tx_action(struct softirq_action *h)
 
 	    pktsCount = vmk_PktListCount(&freeList);
             if (pktsCount) {
-               q->dev->linnet_tx_dropped += pktsCount;
+               netdev_tx_stats_drop(q, NETDEV_DROP_NORESOURCE, pktsCount);
                vmk_PktListReleasePkts(&freeList);
             }
          } else {
@@ -1993,211 +4244,758 @@ map_pkt_to_skb(struct net_device *dev,
          skb->ip_summed = CHECKSUM_NONE;
       }
 
-   } else {
-      skb->ip_summed = CHECKSUM_NONE; // XXX: for now
-   }
-   
-   bytesLeft = frameLen - headLen;
-   for (i = sgInspected; bytesLeft > 0; i++) {
-      skb_frag_t *skb_frag;
-    
-      if (unlikely(i - sgInspected >= MAX_SKB_FRAGS)) {
-         static uint32_t fragsThrottleCounter = 0;
-         VMKLNX_THROTTLED_INFO(fragsThrottleCounter,
-		               "too many frags (> %u) bytesLeft %d", 
-                               MAX_SKB_FRAGS, bytesLeft);
-#ifdef VMX86_DEBUG
-	 VMK_ASSERT(VMK_FALSE);
-#endif
-    	 ret = VMK_FAILURE;
-         goto done;
+   } else {
+      skb->ip_summed = CHECKSUM_NONE; // XXX: for now
+   }
+   
+   bytesLeft = frameLen - headLen;
+   for (i = sgInspected; bytesLeft > 0; i++) {
+      skb_frag_t *skb_frag;
+    
+      if (unlikely(i - sgInspected >= MAX_SKB_FRAGS)) {
+         static uint32_t fragsThrottleCounter = 0;
+         VMKLNX_THROTTLED_INFO(fragsThrottleCounter,
+		               "too many frags (> %u) bytesLeft %d", 
+                               MAX_SKB_FRAGS, bytesLeft);
+#ifdef VMX86_DEBUG
+	 VMK_ASSERT(VMK_FALSE);
+#endif
+    	 ret = VMK_FAILURE;
+         goto done;
+      }
+
+      if (vmk_PktFragGet(pkt, &frag, i) != VMK_OK) {
+    	 ret = VMK_FAILURE;
+         goto done;
+      }
+      skb_frag = &skb_shinfo(skb)->frags[i - sgInspected];
+      /* Going to use the frag->page to store page number and 
+         frag->page_offset for offset within that page */
+      skb_frag->page = phys_to_page(frag.addr);
+      skb_frag->page_offset = offset_in_page(frag.addr);
+      skb_frag->size = min(frag.length, bytesLeft);
+      VMKLNX_DEBUG(10, "frag: %u bytes at MA 0x%llx", 
+                   skb_frag->size, page_to_phys(skb_frag->page) + skb_frag->page_offset);
+      skb->data_len += skb_frag->size;
+      bytesLeft -= skb_frag->size;
+      skb_shinfo(skb)->nr_frags++;
+		 
+      vmk_AssertMemorySupportsIO(frag.addr, frag.length);
+   }
+
+   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfCorruptTx)) {
+      LinStress_CorruptSkbData(skb, 60, 0);
+   }
+
+ done:
+
+   if ((ret != VMK_OK) && (skb != NULL)) {
+      do_free_skb(skb);
+      skb = NULL;
+   }
+
+   *pskb = skb;
+
+   return ret;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_queue_tx_pkts_locked --
+ *
+ *    Queue Tx packets
+ *
+ * Results:
+ *    VMK_ReturnStatus
+ *
+ * Side effects:
+ *    pktList is not guaranteed to be empty on error. Caller must clear
+ *    pktList on eror. We do this because vmk_PktListReleasePkts can't be 
+ *    called with locks held.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_queue_tx_pkts_locked(struct netdev_queue *queue, vmk_PktList *pktList)
+{
+   VMK_ReturnStatus ret = VMK_OK;
+   vmk_uint32 outputListCount, pktListCount;
+   struct netdev_soft_queue *softq = &queue->softq;
+   vmk_PktList *outputList = &softq->outputList;
+
+   VMK_ASSERT(spin_is_locked(&softq->queue_lock));
+
+   outputListCount = vmk_PktListCount(outputList);
+   pktListCount = vmk_PktListCount(pktList);
+   
+   if (likely(pktListCount + outputListCount < softq->outputListMaxSize)) {
+      vmk_PktListJoin(outputList, pktList);
+   } else {
+      int listSpaceLeft = softq->outputListMaxSize - outputListCount;
+      /*
+       * The count of outputList may exceed the configured max by 1.
+       * This happens when transmit loop drops the queue_lock while
+       * waiting for hardware, the outputList can now grow to the
+       * configured max. The hardware transmit fails and the failed
+       * pkt is added back to the outputList. See process_tx_queue
+       */
+      if (listSpaceLeft > 0) {
+         vmk_PktListAppendN(outputList, pktList, listSpaceLeft);
+      }
+      ret = VMK_NO_RESOURCES;
+   }
+
+   return ret;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_pkt_flow_hash --
+ *
+ *    Hash the IP addresses and, for TCP and UDP, the ports of a packet,
+ *    so that all packets of a flow hash alike.
+ *
+ * Results:
+ *    The hash, 0 for non IP frames or frames whose headers are not in the
+ *    mapped area.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline u32
+netdev_pkt_flow_hash(vmk_PktHandle *pkt)
+{
+   struct ethhdr *eh = (struct ethhdr *) vmk_PktFrameMappedPointerGet(pkt);
+   unsigned int mappedLen = vmk_PktFrameMappedLenGet(pkt);
+   unsigned int off;
+   u32 saddr, daddr, ports = 0;
+   u8 proto;
+
+   if (unlikely(mappedLen < sizeof(struct vlan_ethhdr_llc))) {
+      return 0;
+   }
+   off = eth_header_len(eh);
+
+   if (eth_header_is_ipv4(eh)) {
+      struct iphdr *iph = (struct iphdr *) ((u8 *) eh + off);
+
+      if (unlikely(mappedLen < off + sizeof(*iph))) {
+         return 0;
+      }
+      saddr = iph->saddr;
+      daddr = iph->daddr;
+      proto = iph->protocol;
+      /* only the first fragment carries the ports */
+      if (iph->frag_off & htons(IP_MF | IP_OFFSET)) {
+         proto = 0;
+      }
+      off += iph->ihl << 2;
+   } else if (eth_header_frame_type(eh) == ntohs(ETH_P_IPV6)) {
+      struct ipv6hdr *ip6h = (struct ipv6hdr *) ((u8 *) eh + off);
+
+      if (unlikely(mappedLen < off + sizeof(*ip6h))) {
+         return 0;
+      }
+      saddr = ip6h->saddr.s6_addr32[0] ^ ip6h->saddr.s6_addr32[1] ^
+              ip6h->saddr.s6_addr32[2] ^ ip6h->saddr.s6_addr32[3];
+      daddr = ip6h->daddr.s6_addr32[0] ^ ip6h->daddr.s6_addr32[1] ^
+              ip6h->daddr.s6_addr32[2] ^ ip6h->daddr.s6_addr32[3];
+      proto = ip6h->nexthdr;
+      off += sizeof(*ip6h);
+   } else {
+      return 0;
+   }
+
+   if ((proto == IPPROTO_TCP || proto == IPPROTO_UDP) &&
+       mappedLen >= off + sizeof(ports)) {
+      ports = *(u32 *) ((u8 *) eh + off);
+   }
+
+   return jhash_3words(saddr, daddr, ports, txFlowHashSeed);
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_pick_tx_queue --
+ *
+ *    Pick the device tx subqueue of a packet. A packet the vmkernel
+ *    steered to a netqueue goes to that queue. Any other packet goes to
+ *    one of the first NETDEV_TX_HASH_QUEUES queues picked by the hash of
+ *    its flow, so that the packets of a flow stay in order.
+ *
+ *    There is no XPS-style map from the sending PCPU to a queue: the
+ *    worlds that transmit for a port migrate between PCPUs, and Linux
+ *    keeps a flow in order across such a move only through the queue
+ *    its socket remembers until the old queue drains. A packet handle
+ *    has no place to keep that, so a per-PCPU pick would reorder flows.
+ *
+ * Results:
+ *    Index of the tx queue.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline u16
+netdev_pick_tx_queue(struct net_device *dev, vmk_PktHandle *pkt)
+{
+   vmknetddi_queueops_queueid_t queueid = VMKNETDDI_QUEUEOPS_INVALID_QUEUEID;
+   VMK_ReturnStatus status;
+   vmk_NetqueueQueueId vmkqid;
+   u16 queue_idx = 0;
+
+   vmkqid = vmk_PktQueueIdGet(pkt);
+   if (vmkqid) {
+      status = marshall_from_vmknetq_id(vmkqid, &queueid);
+      VMK_ASSERT(status == VMK_OK);
+      if (status == VMK_OK) {
+         queue_idx = get_embedded_queue_mapping(queueid);
+         if (queue_idx >= dev->real_num_tx_queues ||
+             queue_idx >= dev->num_tx_queues) {
+            queue_idx = 0;
+         }
+      }
+   } else if (vmklnx_tx_flow_hash && dev->real_num_tx_queues > 1) {
+      queue_idx = ((u64) netdev_pkt_flow_hash(pkt) *
+                   min_t(unsigned int, dev->real_num_tx_queues,
+                         NETDEV_TX_HASH_QUEUES)) >> 32;
+   }
+
+   VMK_ASSERT(queue_idx < dev->num_tx_queues);
+   return queue_idx;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_pkt_inet_proto --
+ *
+ *    Find the ethertype of the payload of a frame, skipping any 802.1Q
+ *    tags carried inline in the frame, stacked ones included.
+ *
+ * Results:
+ *    The payload ethertype in network byte order, or 0 if the tags run
+ *    past the mapped part of the frame.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline unsigned short
+netdev_pkt_inet_proto(vmk_PktHandle *pkt)
+{
+   unsigned char *frame = (unsigned char *) vmk_PktFrameMappedPointerGet(pkt);
+   unsigned int mappedLen = min(vmk_PktFrameMappedLenGet(pkt),
+                                vmk_PktFrameLenGet(pkt));
+   unsigned int off = offsetof(struct ethhdr, h_proto);
+   unsigned short proto;
+
+   for (;;) {
+      if (unlikely(off + sizeof(proto) > mappedLen)) {
+         return 0;
+      }
+      proto = *(unsigned short *)(frame + off);
+      if (proto != htons(ETH_P_8021Q)) {
+         return proto;
+      }
+      off += VLAN_HLEN;
+   }
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_pkt_needs_sw_gso --
+ *
+ *    Check if a packet is a TSO frame the device can not segment itself,
+ *    i.e. it lacks NETIF_F_TSO for IPv4 or NETIF_F_TSO6 for IPv6. Frames
+ *    with inline VLAN tags are classified by their encapsulated protocol.
+ *
+ * Results:
+ *    VMK_TRUE if the packet must be segmented in software.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static inline vmk_Bool
+netdev_pkt_needs_sw_gso(struct net_device *dev, vmk_PktHandle *pkt)
+{
+   unsigned short proto;
+
+   if (likely(!vmk_PktIsLargeTcpPacket(pkt))) {
+      return VMK_FALSE;
+   }
+
+   proto = netdev_pkt_inet_proto(pkt);
+   if (proto == htons(ETH_P_IP)) {
+      return !(dev->features & NETIF_F_TSO);
+   } else if (proto == htons(ETH_P_IPV6)) {
+      return !(dev->features & NETIF_F_TSO6);
+   }
+
+   /* not ip, map_pkt_to_skb will reject it */
+   return VMK_FALSE;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_tx_sw_gso --
+ *
+ *    Replace the TSO frames of pktList the device can not segment by their
+ *    MSS sized segments, in place, so that the whole segment train goes
+ *    down to the driver in one burst. Segmentation is done by the vmkernel
+ *    TCP segmenter; segments share the payload of the original frame and
+ *    get their IP/TCP headers fixed up.
+ *
+ * Results:
+ *    None.
+ *
+ * Side effects:
+ *    Frames that could not be segmented are moved to freeList.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+netdev_tx_sw_gso(struct net_device *dev, vmk_PktList *pktList,
+                 vmk_PktList *freeList)
+{
+   vmk_PktList outList;
+   vmk_PktList segList;
+   vmk_PktHandle *pkt;
+
+   /*
+    * Most lists carry no TSO frame at all; leave them untouched rather
+    * than popping and rejoining every packet.
+    */
+   for (pkt = vmk_PktListGetHead(pktList);
+        pkt != NULL;
+        pkt = vmk_PktListGetNext(pktList, pkt)) {
+      if (unlikely(netdev_pkt_needs_sw_gso(dev, pkt))) {
+         break;
+      }
+   }
+   if (likely(pkt == NULL)) {
+      return;
+   }
+
+   vmk_PktListInit(&outList);
+
+   while (!vmk_PktListIsEmpty(pktList)) {
+      pkt = vmk_PktListPopHead(pktList);
+
+      if (likely(!netdev_pkt_needs_sw_gso(dev, pkt))) {
+         vmk_PktListAddToTail(&outList, pkt);
+         continue;
       }
 
-      if (vmk_PktFragGet(pkt, &frag, i) != VMK_OK) {
-    	 ret = VMK_FAILURE;
-         goto done;
+      vmk_PktListInit(&segList);
+      if (unlikely(vmk_PktTcpSegmentation(pkt, &segList) != VMK_OK)) {
+         static uint32_t throttle = 0;
+         VMKLNX_THROTTLED_WARN(throttle, "%s: software TSO failed, dropping",
+                               dev->name);
+         vmk_PktListReleasePkts(&segList);
+         vmk_PktListAddToTail(freeList, pkt);
+         continue;
       }
-      skb_frag = &skb_shinfo(skb)->frags[i - sgInspected];
-      /* Going to use the frag->page to store page number and 
-         frag->page_offset for offset within that page */
-      skb_frag->page = phys_to_page(frag.addr);
-      skb_frag->page_offset = offset_in_page(frag.addr);
-      skb_frag->size = min(frag.length, bytesLeft);
-      VMKLNX_DEBUG(10, "frag: %u bytes at MA 0x%llx", 
-                   skb_frag->size, page_to_phys(skb_frag->page) + skb_frag->page_offset);
-      skb->data_len += skb_frag->size;
-      bytesLeft -= skb_frag->size;
-      skb_shinfo(skb)->nr_frags++;
-		 
-      vmk_AssertMemorySupportsIO(frag.addr, frag.length);
+
+      vmk_PktListJoin(&outList, &segList);
+      vmk_PktRelease(pkt);
    }
 
-   if (VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfCorruptTx)) {
-      LinStress_CorruptSkbData(skb, 60, 0);
+   vmk_PktListJoin(pktList, &outList);
+}
+
+/**
+ *  skb_gso_segment - Perform segmentation on skb.
+ *  @skb: TSO buffer to segment
+ *  @features: Ignored
+ *
+ *  Segments a TSO buffer into a list of MSS sized buffers, linked through
+ *  their next pointer. The segments share the payload of @skb, which is
+ *  still owned by the caller and must be freed once the segments have
+ *  been sent.
+ *
+ *  ESX Deviation Notes:
+ *  Segmentation is done by the vmkernel TCP segmenter, which also takes
+ *  care of checksums, so @features is not consulted.
+ *
+ *  RETURN VALUE:
+ *  The list of segments, or an ERR_PTR() on failure.
+ *
+ */
+/* _VMKLNX_CODECHECK_: skb_gso_segment */
+struct sk_buff *
+skb_gso_segment(struct sk_buff *skb, int features)
+{
+   struct net_device *dev = skb->dev;
+   struct sk_buff *segs = NULL;
+   struct sk_buff **tail = &segs;
+   struct sk_buff *nskb;
+   vmk_PktList segList;
+   vmk_PktHandle *pkt;
+
+   if (unlikely(!skb_is_gso(skb) || skb->pkt == NULL || dev == NULL)) {
+      return ERR_PTR(-EINVAL);
    }
 
- done:
+   vmk_PktListInit(&segList);
+   if (vmk_PktTcpSegmentation(skb->pkt, &segList) != VMK_OK) {
+      vmk_PktListReleasePkts(&segList);
+      return ERR_PTR(-EINVAL);
+   }
 
-   if ((ret != VMK_OK) && (skb != NULL)) {
-      do_free_skb(skb);
-      skb = NULL;
+   while (!vmk_PktListIsEmpty(&segList)) {
+      pkt = vmk_PktListPopHead(&segList);
+      if (unlikely(map_pkt_to_skb(dev, netdev_get_tx_queue(dev, skb->queue_mapping),
+                                  pkt, &nskb) != VMK_OK)) {
+         vmk_PktListAddToHead(&segList, pkt);
+         goto fail;
+      }
+      *tail = nskb;
+      tail = &nskb->next;
    }
 
-   *pskb = skb;
+   return segs;
 
-   return ret;
+ fail:
+   vmk_PktListReleasePkts(&segList);
+   while (segs) {
+      nskb = segs;
+      segs = segs->next;
+      nskb->next = NULL;
+      dev_kfree_skb_any(nskb);
+   }
+   return ERR_PTR(-ENOMEM);
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- * netdev_queue_tx_pkts_locked --
+ * netdev_tx_stage_put --
  *
- *    Queue Tx packets
+ *    Stage tx packets in the staging ring of a soft queue without taking
+ *    any lock. Packets are admitted as long as the staged ones plus those
+ *    already on outputList stay under outputListMaxSize, the limit
+ *    outputList has on its own. outputList is looked at without the lock,
+ *    so the limit may be overshot by what the drainer moves over in the
+ *    meantime, never by more than the ring holds. Then a slot is claimed
+ *    by advancing the ring head and published by setting its sequence
+ *    number.
  *
  * Results:
- *    VMK_ReturnStatus
+ *    VMK_OK if all of pktList was staged, VMK_NO_RESOURCES if only part
+ *    or none of it was, with the remaining packets left on pktList.
+ *    VMK_BUSY if the ring has no free slot, pktList is untouched then.
  *
  * Side effects:
- *    pktList is not guaranteed to be empty on error. Caller must clear
- *    pktList on eror. We do this because vmk_PktListReleasePkts can't be 
- *    called with locks held.
+ *    None.
  *
  *----------------------------------------------------------------------------
  */
 static VMK_ReturnStatus
-netdev_queue_tx_pkts_locked(struct netdev_queue *queue, vmk_PktList *pktList)
+netdev_tx_stage_put(struct netdev_soft_queue *softq, vmk_PktList *pktList)
 {
    VMK_ReturnStatus ret = VMK_OK;
-   vmk_uint32 outputListCount, pktListCount;
-   struct netdev_soft_queue *softq = &queue->softq;
-   vmk_PktList *outputList = &softq->outputList;
+   struct netdev_tx_stage *stage = softq->stage;
+   struct netdev_tx_stage_slot *slot;
+   vmk_uint32 pktsCount, staged, queued, take;
+   unsigned int pos;
+   int dif;
 
-   VMK_ASSERT(spin_is_locked(&softq->queue_lock));
+   pktsCount = vmk_PktListCount(pktList);
+   if (unlikely(pktsCount == 0)) {
+      return VMK_OK;
+   }
 
-   outputListCount = vmk_PktListCount(outputList);
-   pktListCount = vmk_PktListCount(pktList);
-   
-   if (likely(pktListCount + outputListCount < softq->outputListMaxSize)) {
-      vmk_PktListJoin(outputList, pktList);
-   } else {
-      int listSpaceLeft = softq->outputListMaxSize - outputListCount;
-      /*
-       * The count of outputList may exceed the configured max by 1.
-       * This happens when transmit loop drops the queue_lock while
-       * waiting for hardware, the outputList can now grow to the
-       * configured max. The hardware transmit fails and the failed
-       * pkt is added back to the outputList. See process_tx_queue
-       */
-      if (listSpaceLeft > 0) {
-         vmk_PktListAppendN(outputList, pktList, listSpaceLeft);
+   /* reserve room for the packets */
+   do {
+      ret = VMK_OK;
+      staged = atomic_read(&stage->pkts);
+      queued = staged + vmk_PktListCount(&softq->outputList);
+      if (likely(queued + pktsCount < softq->outputListMaxSize)) {
+         take = pktsCount;
+      } else if (queued < softq->outputListMaxSize) {
+         take = softq->outputListMaxSize - queued;
+         ret = VMK_NO_RESOURCES;
+      } else {
+         return VMK_NO_RESOURCES;
       }
-      ret = VMK_NO_RESOURCES;
+   } while (atomic_cmpxchg(&stage->pkts, staged, staged + take) != staged);
+
+   /* claim a slot */
+   for (;;) {
+      pos = atomic_read(&stage->head);
+      slot = &stage->ring[pos & (NETDEV_TX_STAGE_SLOTS - 1)];
+      dif = atomic_read(&slot->seq) - (int) pos;
+      if (dif == 0) {
+         if (atomic_cmpxchg(&stage->head, pos, pos + 1) == (int) pos) {
+            break;
+         }
+      } else if (dif < 0) {
+         /* the consumer is a whole lap behind */
+         atomic_sub(take, &stage->pkts);
+         return VMK_BUSY;
+      }
+      cpu_relax();
+   }
+
+   vmk_PktListInit(&slot->pktList);
+   if (likely(take == pktsCount)) {
+      vmk_PktListJoin(&slot->pktList, pktList);
+   } else {
+      vmk_PktListAppendN(&slot->pktList, pktList, take);
    }
 
+   /* publish the slot */
+   smp_wmb();
+   atomic_set(&slot->seq, pos + 1);
+
    return ret;
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- * netdev_pick_tx_queue --
+ * netdev_tx_stage_pending --
  *
- *    Pick device tx subqueue for transmission. The upper layers must ensure
- *    that all packets in pktList are destined for the same queue.
+ *    Check whether packets are staged in the ring of a soft queue. A
+ *    producer reserves its packets in the ring count before it publishes
+ *    its slot and tries for the owner bit, so unlike the ring tail this
+ *    can't miss a slot the current owner has to go back for.
  *
  * Results:
- *    pointer to netdev_queue
+ *    TRUE if so.
  *
  * Side effects:
  *    None.
  *
  *----------------------------------------------------------------------------
  */
-static inline struct netdev_queue *
-netdev_pick_tx_queue(struct net_device *dev, vmk_PktList *pktList)
+static inline vmk_Bool
+netdev_tx_stage_pending(struct netdev_soft_queue *softq)
 {
-   int queue_idx = 0;
-   vmknetddi_queueops_queueid_t queueid = VMKNETDDI_QUEUEOPS_INVALID_QUEUEID;
-   VMK_ReturnStatus status;
-   vmk_PktHandle *pkt = vmk_PktListGetHead(pktList);
-   vmk_NetqueueQueueId vmkqid;
+   return atomic_read(&softq->stage->pkts) != 0;
+}
 
-   VMK_ASSERT(pkt);
-   vmkqid = vmk_PktQueueIdGet(pkt);
-   if (!vmkqid) {
-      goto out;
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_tx_stage --
+ *
+ *    Lock-free counterpart of queueing packets on outputList under
+ *    queue_lock. The packets are staged in the ring, then whichever
+ *    producer wins the owner bit of the ring takes queue_lock and transmits
+ *    for everyone; the others return right away. The owner goes back
+ *    for what was staged while it held the bit, up to
+ *    NETDEV_TX_STAGE_ROUNDS times before leaving the rest to
+ *    net_tx_action.
+ *
+ *    Producers see the queue state without the lock, so packets staged
+ *    just as the queue is blocked or stopped are dropped when drained
+ *    rather than refused here. Stopped driver queues are handled as
+ *    before by process_tx_queue, and netif_wake_queue reschedules it.
+ *
+ * Results:
+ *    VMK_ReturnStatus indicating the outcome.
+ *
+ * Side effects:
+ *    Packets that could not be queued are left on pktList, the ones the
+ *    driver didn't take are put on freePktsList.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_tx_stage(struct netdev_queue *queue, vmk_PktList *pktList,
+                vmk_PktList *freePktsList)
+{
+   VMK_ReturnStatus ret;
+   struct netdev_soft_queue *softq = &queue->softq;
+   struct netdev_tx_stage *stage = softq->stage;
+   int rounds = 0;
+
+   if (unlikely(softq->state !=
+                (LIN_NET_QUEUE_UNBLOCKED|LIN_NET_QUEUE_STARTED))) {
+      return VMK_FAILURE;
    }
 
-#ifdef VMX86_DEBUG
-   {
-      while (pkt != NULL) {
-         pkt = vmk_PktListGetNext(pktList, pkt);
-         if (!pkt) {
-            break;
-         }
-         VMK_ASSERT(vmk_PktQueueIdGet(pkt) == vmkqid);
+   /*
+    * If the ring is full, drain it ourselves and try again. Queueing
+    * straight to outputList instead could overtake our own packets
+    * still staged behind a slot that isn't published yet.
+    */
+   while (unlikely((ret = netdev_tx_stage_put(softq, pktList)) == VMK_BUSY)) {
+      spin_lock(&softq->queue_lock);
+      process_tx_queue(queue, freePktsList);
+      spin_unlock(&softq->queue_lock);
+      cpu_relax();
+   }
+
+   /*
+    * The atomic test_and_set_bit orders our slot publication before the
+    * check of the bit, so either we become the owner or the current one
+    * sees our slot once it has cleared the bit.
+    */
+   while (!test_and_set_bit(0, &stage->owner)) {
+      spin_lock(&softq->queue_lock);
+      process_tx_queue(queue, freePktsList);
+      spin_unlock(&softq->queue_lock);
+
+      smp_mb__before_clear_bit();
+      clear_bit(0, &stage->owner);
+      smp_mb__after_clear_bit();
+
+      if (!netdev_tx_stage_pending(softq)) {
+         break;
+      }
+      if (++rounds >= NETDEV_TX_STAGE_ROUNDS) {
+         __netif_schedule(queue);
+         break;
       }
    }
-#endif
 
-   status = marshall_from_vmknetq_id(vmkqid, &queueid);
-   VMK_ASSERT(status == VMK_OK);
-   if (status == VMK_OK) {
-      queue_idx = get_embedded_queue_mapping(queueid);
-      if (queue_idx >= dev->real_num_tx_queues ||
-          queue_idx >= dev->num_tx_queues) {
-         queue_idx = 0;
+   return ret;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_tx_stages_create --
+ *
+ *    Give every tx queue of a device a staging ring if tx staging is
+ *    enabled (vmklnx_tx_stage). Devices without it don't carry the ring.
+ *
+ * Results:
+ *    None.
+ *
+ * Side effects:
+ *    A queue whose ring can't be allocated queues on outputList directly.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+netdev_tx_stages_create(struct net_device *dev)
+{
+   struct netdev_tx_stage *stage;
+   int i, j;
+
+   if (vmklnx_tx_stage == 0) {
+      return;
+   }
+
+   for (i = 0; i < dev->num_tx_queues; i++) {
+      if (dev->_tx[i].softq.stage != NULL) {
+         continue;
+      }
+      stage = kzalloc(sizeof(*stage), GFP_KERNEL);
+      if (stage == NULL) {
+         VMKLNX_WARN("%s: unable to allocate tx staging ring for "
+                     "tx queue %d", dev->name, i);
+         continue;
+      }
+      for (j = 0; j < NETDEV_TX_STAGE_SLOTS; j++) {
+         atomic_set(&stage->ring[j].seq, j);
+         vmk_PktListInit(&stage->ring[j].pktList);
       }
+      dev->_tx[i].softq.stage = stage;
    }
+}
 
- out:
-   VMK_ASSERT(queue_idx < dev->num_tx_queues);
-   VMK_ASSERT(queue_idx >= 0);
-   return &dev->_tx[queue_idx];
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_tx_stages_destroy --
+ *
+ *    Free the staging rings of all tx queues of a device.
+ *
+ * Results:
+ *    None.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void
+netdev_tx_stages_destroy(struct net_device *dev)
+{
+   int i;
+
+   for (i = 0; i < dev->num_tx_queues; i++) {
+      if (dev->_tx[i].softq.stage) {
+         VMK_ASSERT(atomic_read(&dev->_tx[i].softq.stage->pkts) == 0);
+         kfree(dev->_tx[i].softq.stage);
+         dev->_tx[i].softq.stage = NULL;
+      }
+   }
 }
 
 /*
  *----------------------------------------------------------------------------
  *
- * netdev_tx --
+ * netdev_tx_queue --
  *
- *    Transmit packets
+ *    Transmit packets on one tx queue of a device.
  *
  * Results:
  *    VMK_ReturnStatus indicating the outcome.
  *
  * Side effects:
- *    None.
+ *    pktList is emptied.
  *
  *----------------------------------------------------------------------------
  */
 static VMK_ReturnStatus
-netdev_tx(struct net_device *dev, vmk_PktList *pktList)
+netdev_tx_queue(struct net_device *dev, struct netdev_queue *queue,
+                vmk_PktList *pktList)
 {
    VMK_ReturnStatus ret;
    vmk_PktList freeList;
    vmk_uint32 pktsCount;
-   struct netdev_queue *queue;
-   struct netdev_soft_queue *softq;
+   struct netdev_soft_queue *softq = &queue->softq;
+   enum netdev_drop_reason reason = NETDEV_DROP_NORESOURCE;
 
    if (unlikely(test_bit(__LINK_STATE_BLOCKED, &dev->state)) ||
        VMKLNX_STRESS_DEBUG_COUNTER(stressNetIfFailHardTx)) {
+      netdev_tx_stats_drop(queue, NETDEV_DROP_BLOCKED,
+                           vmk_PktListCount(pktList));
       vmk_PktListReleasePkts(pktList);
       return VMK_NO_RESOURCES;
    }
    
    vmk_PktListInit(&freeList);
 
-   queue = netdev_pick_tx_queue(dev, pktList);
-   VMK_ASSERT(queue);
-   softq = &queue->softq;
+   /*
+    * Segment TSO frames the device can't handle before they are queued.
+    * Segmentation is expensive, so it is done without holding any lock.
+    */
+   if (unlikely((dev->features & (NETIF_F_TSO | NETIF_F_TSO6)) !=
+                (NETIF_F_TSO | NETIF_F_TSO6))) {
+      netdev_tx_sw_gso(dev, pktList, &freeList);
+   }
+
+   if (softq->stage != NULL) {
+      ret = netdev_tx_stage(queue, pktList, &freeList);
+      goto out;
+   }
 
    /*
     * Queue them
     */
    spin_lock(&softq->queue_lock);
    if (softq->state != (LIN_NET_QUEUE_UNBLOCKED|LIN_NET_QUEUE_STARTED)) {
+      if (!(softq->state & LIN_NET_QUEUE_UNBLOCKED)) {
+         reason = NETDEV_DROP_BLOCKED;
+      }
       ret = VMK_FAILURE;
       goto out_unlock;
    }
@@ -2212,13 +5010,14 @@ netdev_tx(struct net_device *dev, vmk_PktList *pktList)
  out_unlock:
    spin_unlock(&softq->queue_lock);
 
+ out:
    /*
     * Free whatever is left on pktList
     */
    pktsCount = vmk_PktListCount(pktList);
    if (unlikely(pktsCount)) {
       VMK_ASSERT(ret != VMK_OK);
-      dev->linnet_tx_dropped += pktsCount;
+      netdev_tx_stats_drop(queue, reason, pktsCount);
       vmk_PktListReleasePkts(pktList);
    }
 
@@ -2227,13 +5026,83 @@ netdev_tx(struct net_device *dev, vmk_PktList *pktList)
     */
    pktsCount = vmk_PktListCount(&freeList);
    if (unlikely(pktsCount)) {
-      dev->linnet_tx_dropped += pktsCount;
+      netdev_tx_stats_drop(queue, NETDEV_DROP_NORESOURCE, pktsCount);
       vmk_PktListReleasePkts(&freeList);
    }
 
    return ret;
 }
 
+/*
+ *----------------------------------------------------------------------------
+ *
+ * netdev_tx --
+ *
+ *    Transmit packets. The packets of a list steered to a netqueue all go
+ *    to its tx queue. Otherwise the list is split by queue, keeping the
+ *    order of the packets, and each queue's part is sent as one run. A
+ *    flow maps to one queue, so its packets stay in order, and each
+ *    queue's lock is taken once however the flows of the list interleave.
+ *
+ * Results:
+ *    VMK_ReturnStatus indicating the outcome, that of the first run, by
+ *    queue, that could not be sent if any failed.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_tx(struct net_device *dev, vmk_PktList *pktList)
+{
+   VMK_ReturnStatus ret = VMK_OK, status;
+   vmk_PktList runList[NETDEV_TX_HASH_QUEUES];
+   vmk_PktHandle *pkt;
+   u16 queue_idx;
+   u32 queues = 0;
+
+   pkt = vmk_PktListGetHead(pktList);
+   VMK_ASSERT(pkt);
+
+   if (vmk_PktQueueIdGet(pkt) ||
+       !vmklnx_tx_flow_hash || dev->real_num_tx_queues <= 1) {
+#ifdef VMX86_DEBUG
+      vmk_NetqueueQueueId vmkqid = vmk_PktQueueIdGet(pkt);
+
+      while ((pkt = vmk_PktListGetNext(pktList, pkt)) != NULL) {
+         VMK_ASSERT(vmk_PktQueueIdGet(pkt) == vmkqid);
+      }
+      pkt = vmk_PktListGetHead(pktList);
+#endif
+      queue_idx = netdev_pick_tx_queue(dev, pkt);
+      return netdev_tx_queue(dev, &dev->_tx[queue_idx], pktList);
+   }
+
+   while (!vmk_PktListIsEmpty(pktList)) {
+      pkt = vmk_PktListPopHead(pktList);
+      queue_idx = netdev_pick_tx_queue(dev, pkt);
+      VMK_ASSERT(queue_idx < NETDEV_TX_HASH_QUEUES);
+      if (!(queues & (1 << queue_idx))) {
+         queues |= 1 << queue_idx;
+         vmk_PktListInit(&runList[queue_idx]);
+      }
+      vmk_PktListAddToTail(&runList[queue_idx], pkt);
+   }
+
+   for (queue_idx = 0; queues != 0; queue_idx++, queues >>= 1) {
+      if (!(queues & 1)) {
+         continue;
+      }
+      status = netdev_tx_queue(dev, &dev->_tx[queue_idx], &runList[queue_idx]);
+      if (status != VMK_OK && ret == VMK_OK) {
+         ret = status;
+      }
+   }
+
+   return ret;
+}
+
 /*
  * Section: Control operations and queue management
  */
@@ -2291,11 +5160,16 @@ block_tx_soft_queue(struct netdev_queue *queue)
     * Remove packets waiting to be txed
     */
    spin_lock(&softq->queue_lock);
-   vmk_PktListJoin(&freeList, &softq->outputList);
    softq->state &= ~LIN_NET_QUEUE_UNBLOCKED;
+   if (softq->stage != NULL) {
+      /* with the queue no longer running, this drops all that is staged */
+      netdev_tx_stage_drain(queue, &freeList);
+   }
+   vmk_PktListJoin(&freeList, &softq->outputList);
    spin_unlock(&softq->queue_lock);
 
    pktsCount = vmk_PktListCount(&freeList);
+   netdev_tx_stats_drop(queue, NETDEV_DROP_BLOCKED, pktsCount);
 
    /*
     * Go free packets
@@ -2360,11 +5234,16 @@ stop_tx_soft_queue(struct netdev_queue *queue)
     * Remove packets waiting to be txed
     */
    spin_lock(&softq->queue_lock);
-   vmk_PktListJoin(&freeList, &softq->outputList);
    softq->state &= ~LIN_NET_QUEUE_STARTED;
+   if (softq->stage != NULL) {
+      /* with the queue no longer running, this drops all that is staged */
+      netdev_tx_stage_drain(queue, &freeList);
+   }
+   vmk_PktListJoin(&freeList, &softq->outputList);
    spin_unlock(&softq->queue_lock);
 
    pktsCount = vmk_PktListCount(&freeList);
+   netdev_tx_stats_drop(queue, NETDEV_DROP_NORESOURCE, pktsCount);
 
    /*
     * Go free packets
@@ -2627,6 +5506,11 @@ vmklnx_free_netdev(struct vmklnx_pm_skb_cache *pmCache, struct net_device *dev)
    unsigned long flags;
    LinNetDev *linDev = get_LinNetDev(dev);
 
+   netdev_stats_destroy(dev);
+   netdev_stats_cache_destroy(dev);
+   netdev_bounce_rings_destroy(dev);
+   netdev_tx_stages_destroy(dev);
+
    if (dev->skb_pool) {
       spin_lock_irqsave(&pmCache->lock, flags);
       VMK_ASSERT(pmCache->count > 0);
@@ -2721,6 +5605,23 @@ alloc_netdev_mq(int sizeof_priv,
    dev->num_tx_queues = queue_count;
    dev->real_num_tx_queues = queue_count;
 
+   if (netdev_stats_create(dev) != VMK_OK) {
+      printk(KERN_ERR "alloc_netdev: Unable to allocate "
+             "queue statistics.\n");
+      kfree(tx);
+      kfree(p);
+      return NULL;
+   }
+
+   if (netdev_stats_cache_create(dev) != VMK_OK) {
+      printk(KERN_ERR "alloc_netdev: Unable to allocate "
+             "statistics snapshot.\n");
+      netdev_stats_destroy(dev);
+      kfree(tx);
+      kfree(p);
+      return NULL;
+   }
+
    if (sizeof_priv) {
       dev->priv = ((char *)dev +
                    ((sizeof(struct net_device) + NETDEV_ALIGN_CONST)
@@ -2731,6 +5632,7 @@ alloc_netdev_mq(int sizeof_priv,
 
    dev->module_id = vmk_ModuleStackTop();
    INIT_LIST_HEAD(&dev->napi_list);
+   INIT_LIST_HEAD(&linDev->napiPool);
    spin_lock_init(&dev->napi_lock);
    atomic_set(&dev->rxInFlight, 0);
    set_bit(__NETQUEUE_STATE, (void*)&dev->netq_state);
@@ -2814,15 +5716,7 @@ vmklnx_alloc_etherdev_mq(struct vmklnx_pm_skb_cache *pmCache,
       ++pmCache->count;
       spin_unlock_irqrestore(&pmCache->lock, flags);
    } else {
-      dev->skb_pool = vmklnx_kmem_cache_create(skbCacheHeap, 
-                                               "skb_cache",
-                                               sizeof(struct sk_buff) + 
-                                               sizeof(struct skb_shared_info),
-                                               0, 
-                                               NULL, 
-                                               NULL, 
-                                               1, 
-                                               100);
+      dev->skb_pool = skb_pool_create(skbCacheHeap, "skb_cache");
       if (!dev->skb_pool) {
          spin_unlock_irqrestore(&pmCache->lock, flags);
          vmk_WarningMessage("socket buffer cache creation failed for %s\n", 
@@ -2897,6 +5791,7 @@ __netdev_init_queue_locks_one(struct net_device *dev,
    status = vmk_ConfigParamGetUint(maxNetifTxQueueLenConfigHandle, 
                                    &softq->outputListMaxSize);
    VMK_ASSERT(status == VMK_OK);
+
 }
 
 /*
@@ -2951,6 +5846,7 @@ register_netdevice(struct net_device *dev)
    }
  
    netdev_init_queue_locks(dev);
+   netdev_tx_stages_create(dev);
    dev->iflink = -1;
    dev->vlan_group = NULL;
 
@@ -2969,6 +5865,17 @@ register_netdevice(struct net_device *dev)
       goto err_uninit;
    }
 
+   netdev_bounce_rings_create(dev);
+
+   /*
+    * Capture the ethtool string table now so stats queries don't have to
+    * fetch it every time. A failure here is retried on the first query.
+    */
+   if (netdev_stats_cache_strings(dev, dev->stats_cache) != VMK_OK) {
+      VMKLNX_WARN("%s: unable to capture ethtool statistics names",
+                  dev->name);
+   }
+
    set_bit(__LINK_STATE_PRESENT, &dev->state);
 
    write_lock(&dev_base_lock);
@@ -2993,6 +5900,200 @@ register_netdevice(struct net_device *dev)
    goto out;
 }
 
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_ifr_data --
+ *
+ *    User address in ifr_data of an ioctl request. A 32-bit caller passed
+ *    a struct ifreq32; as in ethtool_ioctl(), only the ifr_data pointer
+ *    needs converting since the rest of the layout matches.
+ *
+ *  Results:
+ *    The user pointer.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static void __user *
+netdev_ifr_data(struct ifreq *ifr, vmk_IoctlCallerSize callerSize)
+{
+   if (callerSize == VMK_IOCTL_CALLER_32) {
+      struct ifreq32 *ifr32 = (struct ifreq32 *)ifr;
+
+      return compat_ptr(ifr32->ifr_ifru.ifru_data);
+   }
+   return ifr->ifr_data;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_get_qstats --
+ *
+ *    Handle SIOCGVMKLNXQSTATS: copy the per-queue counters of a device out
+ *    to the struct netdev_qstats_req that ifr_data points to. Rx queues
+ *    that never saw a packet are left out, except the default queue.
+ *
+ *  Results:
+ *    VMK_OK, or VMK_INVALID_ADDRESS if the user buffer can't be accessed.
+ *
+ *  Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_get_qstats(struct net_device *dev, struct ifreq *ifr, uint32_t *result,
+                  vmk_IoctlCallerSize callerSize)
+{
+   struct netdev_qstats_req __user *ureq;
+   struct netdev_qstats_entry entry;
+   u32 room, n = 0;
+   int slot;
+
+   ureq = netdev_ifr_data(ifr, callerSize);
+
+   if (copy_from_user(&room, &ureq->nQueues, sizeof(room))) {
+      return VMK_INVALID_ADDRESS;
+   }
+
+   for (slot = 0;
+        slot < NETDEV_STATS_RX_QUEUES + dev->num_tx_queues && n < room;
+        slot++) {
+      netdev_stats_fold(dev, slot, 1, &entry.stats);
+      if (slot < NETDEV_STATS_RX_QUEUES) {
+         if (slot > 0 && entry.stats.packets == 0 &&
+             netdev_stats_dropped(&entry.stats) == 0) {
+            continue;
+         }
+         entry.type = VMKNETDDI_QUEUEOPS_QUEUE_TYPE_RX;
+         entry.index = slot;
+      } else {
+         entry.type = VMKNETDDI_QUEUEOPS_QUEUE_TYPE_TX;
+         entry.index = slot - NETDEV_STATS_RX_QUEUES;
+      }
+      if (copy_to_user(&ureq->queues[n], &entry, sizeof(entry))) {
+         return VMK_INVALID_ADDRESS;
+      }
+      n++;
+   }
+
+   if (copy_to_user(&ureq->nQueues, &n, sizeof(n))) {
+      return VMK_INVALID_ADDRESS;
+   }
+
+   *result = 0;
+   return VMK_OK;
+}
+
+/*
+ *----------------------------------------------------------------------------
+ *
+ *  netdev_get_estats --
+ *
+ *    Handle SIOCGVMKLNXESTRINGS and SIOCGVMKLNXESTATS: copy the ethtool
+ *    string table or the counters of the statistics snapshot out to the
+ *    struct netdev_estats_req that ifr_data points to, in binary form.
+ *
+ *  Results:
+ *    VMK_OK, VMK_FAILURE if the driver has no statistics, or
+ *    VMK_INVALID_ADDRESS if the user buffer can't be accessed.
+ *
+ *  Side effects:
+ *    May refresh the statistics snapshot.
+ *
+ *----------------------------------------------------------------------------
+ */
+static VMK_ReturnStatus
+netdev_get_estats(struct net_device *dev, uint32_t cmd, struct ifreq *ifr,
+                  uint32_t *result, vmk_IoctlCallerSize callerSize)
+{
+   struct netdev_stats_cache *cache = dev->stats_cache;
+   struct netdev_estats_req __user *ureq;
+   struct netdev_estats_req req;
+   struct netdev_estat *entries = NULL;
+   char *strings = NULL;
+   VMK_ReturnStatus status = VMK_OK;
+   u32 room, i;
+
+   ureq = netdev_ifr_data(ifr, callerSize);
+
+   if (copy_from_user(&req, ureq, sizeof(req))) {
+      return VMK_INVALID_ADDRESS;
+   }
+
+   if (netdev_stats_cache_refresh(dev, cache) != VMK_OK) {
+      return VMK_FAILURE;
+   }
+
+   /*
+    * Copy out of the snapshot under its lock, then to the user without
+    * it. A table that grew past the buffer in between would come out
+    * truncated under its new generation, so size the buffer again.
+    */
+   room = req.nStats;
+ again:
+   req.nStats = min(room, cache->nStats);
+   if (req.nStats > 0) {
+      if (cmd == SIOCGVMKLNXESTRINGS) {
+         strings = kmalloc(req.nStats * ETH_GSTRING_LEN, GFP_KERNEL);
+      } else {
+         entries = kmalloc(req.nStats * sizeof(*entries), GFP_KERNEL);
+      }
+      if (strings == NULL && entries == NULL) {
+         return VMK_NO_MEMORY;
+      }
+   }
+
+   spin_lock(&cache->lock);
+   if (min(room, cache->nStats) > req.nStats) {
+      spin_unlock(&cache->lock);
+      kfree(strings);
+      kfree(entries);
+      strings = NULL;
+      entries = NULL;
+      goto again;
+   }
+   req.nStats = min(req.nStats, cache->nStats);
+   if (strings == NULL && cache->data == NULL) {
+      /* names captured, counters never fetched */
+      req.nStats = 0;
+   }
+   req.generation = cache->generation;
+   if (strings != NULL) {
+      memcpy(strings, cache->strings, req.nStats * ETH_GSTRING_LEN);
+   } else {
+      for (i = 0; i < req.nStats; i++) {
+         entries[i].index = i;
+         entries[i].pad = 0;
+         entries[i].value = cache->data[i];
+      }
+   }
+   spin_unlock(&cache->lock);
+
+   if (req.nStats > 0 &&
+       copy_to_user(ureq->data, strings ? (void *)strings : (void *)entries,
+                    req.nStats * (strings ? ETH_GSTRING_LEN :
+                                  sizeof(*entries)))) {
+      status = VMK_INVALID_ADDRESS;
+      goto out;
+   }
+
+   if (copy_to_user(ureq, &req, sizeof(req))) {
+      status = VMK_INVALID_ADDRESS;
+      goto out;
+   }
+   *result = 0;
+
+ out:
+   kfree(strings);
+   kfree(entries);
+   return status;
+}
+
 /*
  *----------------------------------------------------------------------------
  *
@@ -3039,6 +6140,14 @@ netdev_ioctl(struct net_device *dev, uint32_t cmd, void *args, uint32_t *result,
 
          return ret;
       }  
+
+      if (cmd == SIOCGVMKLNXQSTATS) {
+         return netdev_get_qstats(dev, args, result, callerSize);
+      }
+
+      if (cmd == SIOCGVMKLNXESTRINGS || cmd == SIOCGVMKLNXESTATS) {
+         return netdev_get_estats(dev, cmd, args, result, callerSize);
+      }
       
       if (dev->do_ioctl) {
          VMKAPI_MODULE_CALL(dev->module_id, *result, dev->do_ioctl, dev,
@@ -5401,6 +8510,39 @@ GetDeviceName(void *device, vmk_UplinkDeviceName *devName)
 }
 
 
+/*
+ *----------------------------------------------------------------------------
+ *
+ * append_private_stat --
+ *
+ *    Append a "name : value" line to the private statistics of an uplink,
+ *    truncating it to the room left in the buffer.
+ *
+ * Results:
+ *    The new offset in the private statistics buffer.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static int
+append_private_stat(vmk_UplinkStats *stats, int pidx, const char *name, u64 value)
+{
+   char tmp[128];
+   size_t len;
+
+   if (pidx >= stats->privateStats.bufferSize - 1) {
+      return pidx;
+   }
+
+   snprintf(tmp, 128, "   %s : %lld\n", name, value);
+   len = min(strlen(tmp), (size_t)(stats->privateStats.bufferSize - pidx - 1));
+   memcpy(stats->privateStats.buffer + pidx, tmp, len);
+
+   return pidx + len;
+}
+
 /*
  *----------------------------------------------------------------------------
  *
@@ -5419,6 +8561,9 @@ GetDeviceName(void *device, vmk_UplinkDeviceName *devName)
  *                            A global string is created in gtrings containing all
  *                            formatted statistics.
  *
+ *    Both come from the device's statistics snapshot, so the driver is
+ *    asked at most once every vmklnx_stats_cache_ms.
+ *
  * Results:
  *    None
  *
@@ -5431,99 +8576,122 @@ static VMK_ReturnStatus
 GetDeviceStats(void *device, vmk_UplinkStats *stats)
 {
    struct net_device *dev = device;
-   struct net_device_stats *st = NULL; 
-   struct ethtool_ops *ops = dev->ethtool_ops;
-   struct ethtool_stats stat;
-   u64 *data;
-   char *buf;
-   char *pbuf;
-   int idx = 0;
+   struct netdev_stats_cache *cache = dev->stats_cache;
+   struct net_device_stats *st = &cache->st;
+   struct netdev_queue_stats rx, tx;
+   u64 bounced, exhausted, oversized;
    int pidx = 0;
+   int len;
 
-   if (dev->get_stats) {
-      VMKAPI_MODULE_CALL(dev->module_id, st, dev->get_stats, dev);
-   }
-   
-   if (!st) {
+   netdev_stats_fold(dev, 0, NETDEV_STATS_RX_QUEUES, &rx);
+   netdev_stats_fold(dev, NETDEV_STATS_RX_QUEUES, dev->num_tx_queues, &tx);
+
+   if (netdev_stats_cache_refresh(dev, cache) != VMK_OK) {
       return VMK_FAILURE;
-   } else {
-      stats->rxpkt = st->rx_packets;
-      stats->txpkt = st->tx_packets;
-      stats->rxbytes = st->rx_bytes;
-      stats->txbytes = st->tx_bytes;
-      stats->rxerr = st->rx_errors;
-      stats->txerr = st->tx_errors;
-      stats->rxdrp = st->rx_dropped;
-      stats->txdrp = st->tx_dropped;
-      stats->mltcast = st->multicast;
-      stats->col = st->collisions;
-      stats->rxlgterr = st->rx_length_errors;
-      stats->rxoverr = st->rx_over_errors;
-      stats->rxcrcerr = st->rx_crc_errors;
-      stats->rxfrmerr = st->rx_frame_errors;
-      stats->rxfifoerr = st->rx_fifo_errors;
-      stats->rxmisserr = st->rx_missed_errors;
-      stats->txaborterr = st->tx_aborted_errors;
-      stats->txcarerr = st->tx_carrier_errors;
-      stats->txfifoerr = st->tx_fifo_errors;
-      stats->txhearterr = st->tx_heartbeat_errors;
-      stats->txwinerr = st->tx_window_errors;  
-      stats->intrxpkt = dev->linnet_rx_packets;
-      stats->inttxpkt = dev->linnet_tx_packets;
-      stats->intrxdrp = dev->linnet_rx_dropped;  
-      stats->inttxdrp = dev->linnet_tx_dropped;  
-      stats->intpktcompl = dev->linnet_pkt_completed;
-   }
-
-   if (!ops || 
-       !ops->get_ethtool_stats ||
-       (!ops->get_stats_count && !ops->get_sset_count) ||
-       !ops->get_strings) {
-      goto done;
    }
-   
-   if (ops->get_stats_count) {
-      /* 2.6.18 network drivers method to retrieve the number of stats */
-      VMKAPI_MODULE_CALL(dev->module_id, stat.n_stats, ops->get_stats_count, dev);
-   } else {
-      /* 2.6.18+ network drivers method to retrieve the number of stats */
-      VMKAPI_MODULE_CALL(dev->module_id, stat.n_stats, ops->get_sset_count, dev, ETH_SS_STATS);
+
+   spin_lock(&cache->lock);
+
+   stats->rxpkt = st->rx_packets;
+   stats->txpkt = st->tx_packets;
+   stats->rxbytes = st->rx_bytes;
+   stats->txbytes = st->tx_bytes;
+   stats->rxerr = st->rx_errors;
+   stats->txerr = st->tx_errors;
+   stats->rxdrp = st->rx_dropped;
+   stats->txdrp = st->tx_dropped;
+   stats->mltcast = st->multicast;
+   stats->col = st->collisions;
+   stats->rxlgterr = st->rx_length_errors;
+   stats->rxoverr = st->rx_over_errors;
+   stats->rxcrcerr = st->rx_crc_errors;
+   stats->rxfrmerr = st->rx_frame_errors;
+   stats->rxfifoerr = st->rx_fifo_errors;
+   stats->rxmisserr = st->rx_missed_errors;
+   stats->txaborterr = st->tx_aborted_errors;
+   stats->txcarerr = st->tx_carrier_errors;
+   stats->txfifoerr = st->tx_fifo_errors;
+   stats->txhearterr = st->tx_heartbeat_errors;
+   stats->txwinerr = st->tx_window_errors;  
+   stats->intrxpkt = rx.packets;
+   stats->inttxpkt = tx.packets;
+   stats->intrxdrp = netdev_stats_dropped(&rx);
+   stats->inttxdrp = netdev_stats_dropped(&tx);
+   stats->intpktcompl = dev->linnet_pkt_completed;
+
+   if (cache->textLen > 0 && stats->privateStats.bufferSize > 1) {
+      stats->privateStats.buffer[pidx++] = '\n';
+      len = min(cache->textLen, (int)stats->privateStats.bufferSize - pidx - 1);
+      memcpy(stats->privateStats.buffer + pidx, cache->text, len);
+      pidx += len;
+   }
+
+   spin_unlock(&cache->lock);
+
+   if (pidx == 0) {
+      stats->privateStats.buffer[pidx++] = '\n';
+   }
+   pidx = append_private_stat(stats, pidx, "vmklnx_rx_drop_blocked",
+                              rx.dropped[NETDEV_DROP_BLOCKED]);
+   pidx = append_private_stat(stats, pidx, "vmklnx_rx_drop_invalid",
+                              rx.dropped[NETDEV_DROP_INVALID]);
+   pidx = append_private_stat(stats, pidx, "vmklnx_rx_drop_noresource",
+                              rx.dropped[NETDEV_DROP_NORESOURCE]);
+   pidx = append_private_stat(stats, pidx, "vmklnx_rx_pushes", rx.batches);
+   pidx = append_private_stat(stats, pidx, "vmklnx_rx_push_pkts", rx.batchPkts);
+   pidx = append_private_stat(stats, pidx, "vmklnx_tx_drop_blocked",
+                              tx.dropped[NETDEV_DROP_BLOCKED]);
+   pidx = append_private_stat(stats, pidx, "vmklnx_tx_drop_noresource",
+                              tx.dropped[NETDEV_DROP_NORESOURCE]);
+   pidx = append_private_stat(stats, pidx, "vmklnx_tx_bursts", tx.batches);
+   pidx = append_private_stat(stats, pidx, "vmklnx_tx_burst_pkts", tx.batchPkts);
+   pidx = append_private_stat(stats, pidx, "vmklnx_tx_requeued", tx.requeued);
+
+   if (dev->real_num_tx_queues > 1) {
+      struct netdev_queue_stats txq;
+      char name[32];
+      int i;
+
+      for (i = 0; i < dev->real_num_tx_queues; i++) {
+         netdev_stats_fold(dev, NETDEV_STATS_RX_QUEUES + i, 1, &txq);
+         snprintf(name, sizeof(name), "vmklnx_txq%d_pkts", i);
+         pidx = append_private_stat(stats, pidx, name, txq.packets);
+      }
    }
-   data = kmalloc(stat.n_stats * sizeof(u64), GFP_ATOMIC);
-   pbuf = buf = kmalloc(stat.n_stats * ETH_GSTRING_LEN, GFP_ATOMIC);
-   
-   if (!data) {
-      goto done;
+
+   if (netdev_bounce_ring_stats(dev, &bounced, &exhausted, &oversized) > 0) {
+      pidx = append_private_stat(stats, pidx, "vmklnx_high_dma_bounced", bounced);
+      pidx = append_private_stat(stats, pidx, "vmklnx_high_dma_ring_exhausted", exhausted);
+      pidx = append_private_stat(stats, pidx, "vmklnx_high_dma_oversized", oversized);
    }
 
-   if (!buf) {
-      kfree(data);
-      goto done;
+   if (vmklnxLROEnabled && !(dev->features & NETIF_F_SW_LRO)) {
+      struct napi_struct *napi;
+      u64 ipv4 = 0, ipv6 = 0, vlan = 0, flushed = 0, no_desc = 0;
+
+      spin_lock(&dev->napi_lock);
+      list_for_each_entry(napi, &dev->napi_list, dev_list) {
+         ipv4 += napi->lro_mgr.stats.aggregated_ipv4;
+         ipv6 += napi->lro_mgr.stats.aggregated_ipv6;
+         vlan += napi->lro_mgr.stats.aggregated_vlan;
+         flushed += napi->lro_mgr.stats.flushed;
+         no_desc += napi->lro_mgr.stats.no_desc;
+      }
+      spin_unlock(&dev->napi_lock);
+      if (pidx == 0) {
+         stats->privateStats.buffer[pidx++] = '\n';
+      }
+      pidx = append_private_stat(stats, pidx, "vmklnx_lro_aggregated_ipv4", ipv4);
+      pidx = append_private_stat(stats, pidx, "vmklnx_lro_aggregated_ipv6", ipv6);
+      pidx = append_private_stat(stats, pidx, "vmklnx_lro_aggregated_vlan", vlan);
+      pidx = append_private_stat(stats, pidx, "vmklnx_lro_flushed", flushed);
+      pidx = append_private_stat(stats, pidx, "vmklnx_lro_no_desc", no_desc);
    }
-   
-   VMKAPI_MODULE_CALL_VOID(dev->module_id, ops->get_ethtool_stats, dev, &stat, data);
-   VMKAPI_MODULE_CALL_VOID(dev->module_id, ops->get_strings, dev, ETH_SS_STATS, (vmk_uint8 *)buf);
-
-   stats->privateStats.buffer[pidx++] = '\n';
-   for (; (pidx < stats->privateStats.bufferSize - 1) && (idx < stat.n_stats); idx++) {
-      char tmp[128];
-       
-      snprintf(tmp, 128, "   %s : %lld\n", pbuf, data[idx]);
-      memcpy(stats->privateStats.buffer + pidx, tmp, min(strlen(tmp), 
-             (size_t)(stats->privateStats.bufferSize - pidx - 1)));
-	 
-      pidx += min(strlen(tmp),
-                  (size_t)stats->privateStats.bufferSize - pidx - 1);
-      pbuf += ETH_GSTRING_LEN;
+
+   if (pidx > 0) {
+      stats->privateStats.buffer[pidx] = 0;
+      stats->privateStats.stringLength = strlen((char *)stats->privateStats.buffer);
    }
-   
-   stats->privateStats.buffer[pidx] = 0;
-   stats->privateStats.stringLength = strlen((char *)stats->privateStats.buffer);
-   
-   kfree(data);
-   kfree(buf);
-   
- done:
 
    return VMK_OK;
 }
@@ -5956,7 +9124,9 @@ FlushRxBuffers(void* clientData)
       if (napi != NULL) {
          VMKLNX_DEBUG(1, "Calling Pkt List Rx Process on napi:%p", napi);
          VMK_ASSERT(napi->dev != NULL);
-         vmk_PktListRxProcess(&napi->pktList, napi->dev->uplinkDev);
+         if (!vmk_PktListIsEmpty(&napi->pktList)) {
+            napi_stack_push(napi);
+         }
       }
    }
 
@@ -6350,7 +9520,9 @@ LinNet_ConnectUplink(struct net_device *dev, struct pci_dev *pdev)
  *----------------------------------------------------------------------------
  *
  *  vmklnx_netdev_high_dma_workaround --
- *    Make a copy of a skb buffer in low dma.
+ *    Make a copy of a skb buffer in low dma. The copy goes into the
+ *    bounce ring of the skb's tx queue when it has a free slot, else
+ *    into a freshly allocated skb. Called under the queue's xmit lock.
  *
  *  Results:
  *    If the copy succeeds then it releases the previous skb and
@@ -6365,7 +9537,19 @@ LinNet_ConnectUplink(struct net_device *dev, struct pci_dev *pdev)
 struct sk_buff *
 vmklnx_netdev_high_dma_workaround(struct sk_buff *base)
 {
-   struct sk_buff *skb = skb_copy(base, GFP_ATOMIC);
+   struct net_device *dev = base->dev;
+   struct netdev_bounce_ring *ring = NULL;
+   struct sk_buff *skb = NULL;
+
+   if (dev && base->queue_mapping < dev->num_tx_queues) {
+      ring = dev->_tx[base->queue_mapping].bounce_ring;
+   }
+   if (ring) {
+      skb = netdev_bounce_get(ring, base);
+   }
+   if (skb == NULL) {
+      skb = skb_copy(base, GFP_ATOMIC);
+   }
 
    if (skb) {
       vmk_PktRelease(base->pkt);
@@ -6432,58 +9616,176 @@ vmklnx_netdev_high_dma_overflow(struct sk_buff *skb,
    return VMK_FALSE;
 }
 
+/*
+ *----------------------------------------------------------------------------
+ *
+ * napi_proc_emit --
+ *
+ *    Copy the part of a line of a proc node that falls in the window
+ *    [off, off + count) being read into page.
+ *
+ * Results:
+ *    None.
+ *
+ * Side effects:
+ *    Advances *pos past the line and *len by the number of bytes copied.
+ *
+ *----------------------------------------------------------------------------
+ */
 static void
-LinNetComputeEthCRCTableLE(void)
+napi_proc_emit(char *page, off_t off, int count, off_t *pos, int *len,
+               const char *line, int n)
 {
-   unsigned i, crc, j;
+   int skip, copy;
 
-   for (i = 0; i < 256; i++) {
-      crc = i;
-      for (j = 0; j < 8; j++) {
-         crc = (crc >> 1) ^ ((crc & 0x1)? eth_crc32_poly_le : 0);
-      }
-      eth_crc32_poly_tbl_le[i] = crc;
+   if (*pos + n > off && *len < count) {
+      skip = (*pos < off) ? off - *pos : 0;
+      copy = min(n - skip, count - *len);
+      memcpy(page + *len, line + skip, copy);
+      *len += copy;
    }
+   *pos += n;
 }
 
-static uint32_t
-LinNetComputeEthCRCLE(unsigned crc, const unsigned char *frame, uint32_t frameLen)
+/*
+ *----------------------------------------------------------------------------
+ *
+ * napi_proc_read --
+ *
+ *    read_proc handler of /proc/net/vmklinux_napi. Reports the stack push
+ *    thresholds currently chosen by each napi context, its averages and
+ *    the histogram of the batch sizes it pushed.
+ *
+ * Results:
+ *    Number of bytes written to page.
+ *
+ * Side effects:
+ *    None.
+ *
+ *----------------------------------------------------------------------------
+ */
+static int
+napi_proc_read(char *page, char **start, off_t off, int count, int *eof,
+               void *data)
 {
-   int i, j;
+   struct net_device *dev;
+   struct napi_struct *napi;
+   char line[256];
+   off_t pos = 0;
+   int len = 0;
+   int n, i;
+
+   n = snprintf(line, sizeof(line),
+                "%-16s %4s %6s %5s %4s %8s %7s %7s %10s %5s %9s  %s\n",
+                "device", "napi", "wdt", "batch", "skip", "pkt/poll",
+                "poll-us", "push-us", "polls", "full%", "poll-ms",
+                "pushed batch sizes 1 2-3 4-7 8-15 16-31 32-63 64-127 128+");
+   napi_proc_emit(page, off, count, &pos, &len, line, n);
 
-   for (i = 0; i + 4 <= frameLen; i += 4) {
-      crc ^= *(unsigned *)&frame[i];
-      for (j = 0; j < 4; j++) {
-         crc = eth_crc32_poly_tbl_le[crc & 0xff] ^ (crc >> 8);
+   read_lock(&dev_base_lock);
+   for (dev = dev_base; dev != NULL && len < count; dev = dev->next) {
+      spin_lock(&dev->napi_lock);
+      list_for_each_entry(napi, &dev->napi_list, dev_list) {
+         n = snprintf(line, sizeof(line),
+                      "%-16s %4u %6s %5u %4u %5u.%02u %7lld %7lld %10llu "
+                      "%5llu %9lld ",
+                      dev->name, napi->napi_id,
+                      napi->dev_poll ? "backup" : "own",
+                      napi->push_min, napi->push_skip_max,
+                      napi->rx_rate >> NAPI_RX_RATE_SHIFT,
+                      ((napi->rx_rate & ((1 << NAPI_RX_RATE_SHIFT) - 1)) * 100)
+                         >> NAPI_RX_RATE_SHIFT,
+                      (long long) vmk_TimerTCToUS(napi->poll_cycles),
+                      (long long) vmk_TimerTCToUS(napi->push_cycles),
+                      (unsigned long long) napi->polls,
+                      napi->polls ?
+                         (unsigned long long) (napi->polls_full * 100 /
+                                               napi->polls) : 0ULL,
+                      (long long) vmk_TimerTCToUS(napi->poll_cycles_total) /
+                         1000);
+         for (i = 0; i < NAPI_PUSH_HIST_BUCKETS; i++) {
+            n += snprintf(line + n, sizeof(line) - n, " %lu", napi->push_hist[i]);
+         }
+         n += snprintf(line + n, sizeof(line) - n, "\n");
+         napi_proc_emit(page, off, count, &pos, &len, line,
+                        min(n, (int)sizeof(line) - 1));
       }
+      spin_unlock(&dev->napi_lock);
    }
+   read_unlock(&dev_base_lock);
 
-   while (i < frameLen) {
-      crc = eth_crc32_poly_tbl_le[(crc ^ frame[i++]) & 0xff] ^ (crc >> 8);
-   }
-
-   return crc;
+   *start = page;
+   *eof = (pos <= off + len);
+   return len;
 }
 
-/**                                          
- *  crc32_le - Calculate bitwise little-endian Ethernet CRC       
- *  @crc: seed value for computation    
- *  @p: pointer to buffer over which CRC is run   
- *  @len: length of buffer p
- *                                           
- *  Calculates bitwise little-endian Ethernet CRC from an 
- *  initial seed value that could be 0 or a previous value if
- *  computing incrementally.
- *                                           
- *  RETURN VALUE:                     
- *  32-bit CRC value.                                         
+/*
+ *----------------------------------------------------------------------------
+ *
+ * lro_proc_read --
+ *
+ *    read_proc handler of /proc/net/vmklinux_lro. Reports for the lro
+ *    manager of each napi context the average number of packets per
+ *    flushed session, why sessions were flushed and the histogram of
+ *    packets per session.
+ *
+ * Results:
+ *    Number of bytes written to page.
+ *
+ * Side effects:
+ *    None.
  *
+ *----------------------------------------------------------------------------
  */
-/* _VMKLNX_CODECHECK_: crc32_le */
-uint32_t
-crc32_le(uint32_t crc, unsigned char const *p, size_t len)
+static int
+lro_proc_read(char *page, char **start, off_t off, int count, int *eof,
+              void *data)
 {
-   return LinNetComputeEthCRCLE(crc, p, len);
+   struct net_device *dev;
+   struct napi_struct *napi;
+   struct net_lro_stats *st;
+   unsigned long ratio;
+   char line[320];
+   off_t pos = 0;
+   int len = 0;
+   int n, i;
+
+   n = snprintf(line, sizeof(line),
+                "%-16s %4s %4s %10s %10s %8s %10s %10s %10s %8s  %s\n",
+                "device", "napi", "open", "aggregated", "flushed", "pkt/sess",
+                "psh", "budget", "idle", "no_desc",
+                "session sizes 1 2-3 4-7 8-15 16-31 32-63 64-127 128+");
+   napi_proc_emit(page, off, count, &pos, &len, line, n);
+
+   read_lock(&dev_base_lock);
+   for (dev = dev_base; dev != NULL && len < count; dev = dev->next) {
+      if (dev->features & NETIF_F_SW_LRO) {
+         continue;
+      }
+      spin_lock(&dev->napi_lock);
+      list_for_each_entry(napi, &dev->napi_list, dev_list) {
+         st = &napi->lro_mgr.stats;
+         ratio = st->flushed ? (st->aggregated * 100) / st->flushed : 0;
+         n = snprintf(line, sizeof(line),
+                      "%-16s %4u %4d %10lu %10lu %5lu.%02lu %10lu %10lu %10lu %8lu ",
+                      dev->name, napi->napi_id, napi->lro_mgr.active_cnt,
+                      st->aggregated, st->flushed, ratio / 100, ratio % 100,
+                      st->flushed_psh, st->flushed_budget, st->flushed_idle,
+                      st->no_desc);
+         for (i = 0; i < LRO_AGGR_HIST_BUCKETS; i++) {
+            n += snprintf(line + n, sizeof(line) - n, " %lu", st->aggr_hist[i]);
+         }
+         n += snprintf(line + n, sizeof(line) - n, "\n");
+         napi_proc_emit(page, off, count, &pos, &len, line,
+                        min(n, (int)sizeof(line) - 1));
+      }
+      spin_unlock(&dev->napi_lock);
+   }
+   read_unlock(&dev_base_lock);
+
+   *start = page;
+   *eof = (pos <= off + len);
+   return len;
 }
 
 /*
@@ -6537,7 +9839,6 @@ LinNet_Init(void)
    Linux_OpenSoftirq(NET_TX_SOFTIRQ, net_tx_action, NULL);
    LinNet_InitSoftnetData();
    LinStress_SetupStress();
-   LinNetComputeEthCRCTableLE();
    
    /* set up link state timer */
    status = vmk_ConfigParamOpen("Net", "LinkStatePollTimeout", 
@@ -6561,6 +9862,22 @@ LinNet_Init(void)
                                    &vmklnxLROMaxAggr);
    VMK_ASSERT(status == VMK_OK);
 
+   napiPushLatencyTC = vmk_TimerUSToTC(max(vmklnx_napi_push_latency_us, 0));
+   napiProcEntry = create_proc_entry("vmklinux_napi", 0, proc_net);
+   if (napiProcEntry) {
+      napiProcEntry->read_proc = napi_proc_read;
+   } else {
+      VMKLNX_WARN("Unable to create /proc/net/vmklinux_napi");
+   }
+
+   lroFlushIdleTC = vmk_TimerUSToTC(max(vmklnx_lro_flush_idle_us, 0));
+   lroProcEntry = create_proc_entry("vmklinux_lro", 0, proc_net);
+   if (lroProcEntry) {
+      lroProcEntry->read_proc = lro_proc_read;
+   } else {
+      VMKLNX_WARN("Unable to create /proc/net/vmklinux_lro");
+   }
+
    schedule_delayed_work(&linkStateWork,
                          msecs_to_jiffies(linkStateTimerPeriod));
    
@@ -6573,14 +9890,12 @@ LinNet_Init(void)
    status = vmk_ConfigParamGetUint(blockTotalSleepMsecHandle, &blockTotalSleepMsec);
    VMK_ASSERT(status == VMK_OK);
 
-   vmklnx_skb_cache = vmklnx_kmem_cache_create(VMK_MODULE_SKB_HEAP_ID, 
-                                               "vmklnx_skb_cache",
-                                               sizeof(struct sk_buff) + 
-                                               sizeof(struct skb_shared_info),
-                                               0, NULL, NULL, 1, 100);
+   vmklnx_skb_cache = skb_pool_create(VMK_MODULE_SKB_HEAP_ID,
+                                      "vmklnx_skb_cache");
 
    max_phys_addr = (uint64_t) vmk_GetLastValidMachPage() * PAGE_SIZE;
    globalGenCount = (vmk_PktCompletionData) PKT_COMPL_GEN_COUNT_INIT;
+   get_random_bytes(&txFlowHashSeed, sizeof(txFlowHashSeed));
 
    VMK_ASSERT(vmklnx_skb_cache != NULL);
    if (!vmklnx_skb_cache) {
@@ -6659,6 +9974,14 @@ void LinNet_Cleanup(void)
    VMK_ReturnStatus status;
 
    LinStress_CleanupStress();
+   if (napiProcEntry) {
+      remove_proc_entry("vmklinux_napi", proc_net);
+      napiProcEntry = NULL;
+   }
+   if (lroProcEntry) {
+      remove_proc_entry("vmklinux_lro", proc_net);
+      lroProcEntry = NULL;
+   }
    vmklnx_cancel_work_sync(&linkStateWork.work, &linkStateWork.timer);
    vmklnx_cancel_work_sync(&watchdogWork.work, &watchdogWork.timer);
    vmk_TimerRemoveSync(devWatchdogTimer);
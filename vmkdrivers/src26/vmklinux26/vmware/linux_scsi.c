@@ -26,6 +26,8 @@
 #include <scsi/scsi_transport.h>
 #include <scsi/scsi_tcq.h>
 #include <linux/pci.h>
+#include <linux/moduleparam.h>
+#include <linux/proc_fs.h>
 
 #include "vmkapi.h"
 #include "linux_stubs.h" 
@@ -47,6 +49,8 @@ static VMK_ReturnStatus SCSILinuxAbortCommand(struct Scsi_Host *sh,
 					      struct scsi_cmnd *cmdPtr, 
 					      int32_t abortReason);
 static void SCSIProcessCmdTimedOut(void *data);
+static int SCSILinuxComplProcRead(char *page, char **start, off_t off,
+                                  int count, int *eof, void *data);
 
 /*
  * Globals
@@ -76,11 +80,44 @@ typedef struct scsiLinuxTLS {
    * scheduled to run, or actually running.
    */
   vmk_Bool runningBH;
-  char pad[0] VMK_ATTRIBUTE_L1_ALIGNED; /* effectively pad to 128 bytes */
+  /*
+   * Completion counters, only updated by this PCPU.
+   */
+  vmk_uint64 cmdsDone;    /* completions processed by the BH */
+  vmk_uint64 steeredOut;  /* completions sent to the inbox of another PCPU */
+  vmk_uint64 steeredIn;   /* completions taken from our inbox */
+  vmk_uint64 kicks;       /* BHs scheduled on another PCPU */
+  /*
+   * inbox is a lock-free stack of completions steered to this PCPU by
+   * the others, linked through scmd->bhnext. It is pushed to with
+   * cmpxchg and taken whole by the BH, so it lives on its own cache line.
+   */
+  struct scsi_cmnd *inbox VMK_ATTRIBUTE_L1_ALIGNED;
+  char pad[0] VMK_ATTRIBUTE_L1_ALIGNED; /* pad to whole cache lines */
 } scsiLinuxTLS_t;
 
 scsiLinuxTLS_t *scsiLinuxTLS[NR_CPUS] VMK_ATTRIBUTE_L1_ALIGNED;
 
+/*
+ * Where SCSILinuxCmdDone has the BH complete a command
+ */
+enum {
+   SCSI_COMPL_ON_INTR_PCPU   = 0, /* PCPU that took the interrupt */
+   SCSI_COMPL_ON_SUBMIT_PCPU = 1, /* PCPU the command was issued from */
+   SCSI_COMPL_ON_SUBMIT_DOMAIN = 2, /* interrupt PCPU if it shares a cache
+                                     * domain with the issuing one */
+};
+
+static int vmklnx_scsi_compl_steering = SCSI_COMPL_ON_SUBMIT_DOMAIN;
+module_param(vmklnx_scsi_compl_steering, int, 0644);
+MODULE_PARM_DESC(vmklnx_scsi_compl_steering, "PCPU scsi commands are completed on: 0 interrupt PCPU, 1 issuing PCPU, 2 interrupt PCPU if in the cache domain of the issuing one, else issuing PCPU.");
+
+static int vmklnx_scsi_compl_domain_pcpus = 2;
+module_param(vmklnx_scsi_compl_domain_pcpus, int, 0644);
+MODULE_PARM_DESC(vmklnx_scsi_compl_domain_pcpus, "Number of consecutive PCPUs considered to share a cache domain for completion steering.");
+
+static struct proc_dir_entry *scsiComplProcEntry;
+
 /*
  * SCSI Adapter list and lock associated with this
  */
@@ -113,6 +150,7 @@ struct work_struct linuxSCSIIO_work;
  ********************************************************************
  */
 extern struct mutex host_cmd_pool_mutex;
+extern struct proc_dir_entry *proc_scsi;
 
 /*
  * Heap for allocating commands for all paths
@@ -221,7 +259,7 @@ SCSILinux_Init(void)
       vmk_HeapFree(vmklnxScsiSgHeap, sg_dummy[i]);
    }
 
-   VMK_ASSERT_ON_COMPILE(sizeof(scsiLinuxTLS_t) == VMK_L1_CACHELINE_SIZE);
+   VMK_ASSERT_ON_COMPILE(sizeof(scsiLinuxTLS_t) % VMK_L1_CACHELINE_SIZE == 0);
    for (i = vmk_NumPCPUs()-1; i >= 0; i--) {
       scsiLinuxTLS_t *tls;
 
@@ -242,6 +280,15 @@ SCSILinux_Init(void)
    status = vmk_BottomHalfRegister(SCSILinuxBH, NULL, &scsiLinuxBH, "linuxscsi");
    VMK_ASSERT_BUG(status == VMK_OK);
 
+   scsiComplProcEntry = create_proc_entry("vmklinux_completions", 0,
+                                          proc_scsi);
+   if (scsiComplProcEntry) {
+      scsiComplProcEntry->read_proc = SCSILinuxComplProcRead;
+   } else {
+      vmk_WarningMessage("%s - Unable to create /proc/scsi/vmklinux_completions\n",
+                         __FUNCTION__);
+   }
+
    mutex_init(&host_cmd_pool_mutex);
 
    linuxSCSIWQ = create_singlethread_workqueue("linuxSCSIWQ");
@@ -282,6 +329,11 @@ SCSILinux_Cleanup(void)
    VMK_ReturnStatus status;
    int i;
 
+   if (scsiComplProcEntry) {
+      remove_proc_entry("vmklinux_completions", proc_scsi);
+      scsiComplProcEntry = NULL;
+   }
+
    vmk_BottomHalfUnregister(scsiLinuxBH);
 
    vmk_SPDestroyIRQ(&linuxSCSIAdapterLock);
@@ -484,6 +536,77 @@ SCSILinuxGetModuleID(struct Scsi_Host *sh, struct pci_dev *pdev)
    return(moduleID);
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxTakeInbox --
+ *
+ *      Move the completions other PCPUs steered to us onto the BH list,
+ *      in the order they were pushed.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      Empties tls->inbox.
+ *
+ *----------------------------------------------------------------------
+ */
+static inline void
+SCSILinuxTakeInbox(scsiLinuxTLS_t *tls)
+{
+   struct scsi_cmnd *scmd, *next, *prev = NULL;
+
+   if (tls->inbox == NULL) {
+      return;
+   }
+
+   /* the inbox is a stack, reverse it back to completion order */
+   for (scmd = xchg(&tls->inbox, NULL); scmd != NULL; scmd = next) {
+      next = scmd->bhnext;
+      scmd->bhnext = prev;
+      prev = scmd;
+   }
+   for (scmd = prev; scmd != NULL; scmd = scmd->bhnext) {
+      list_add_tail(&scmd->bhlist, &tls->bhDoneCmds);
+      tls->steeredIn++;
+   }
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxBusyRunEnds --
+ *
+ *      Tell whether the BH must release the busy counts it gathered
+ *      for the device of scmd before completing scmd. It may hold on to
+ *      them only while the next command it will complete in this pass
+ *      is for the same device, as that one keeps the device around.
+ *
+ * Results:
+ *      VMK_TRUE if the busy counts must be released now.
+ *
+ * Side effects:
+ *      None.
+ *
+ *----------------------------------------------------------------------
+ */
+static inline vmk_Bool
+SCSILinuxBusyRunEnds(scsiLinuxTLS_t *tls,
+                     struct scsi_cmnd *scmd,
+                     vmk_TimerCycles yield)
+{
+   struct scsi_cmnd *next;
+
+   if (list_empty(&tls->bhDoneCmds) || vmk_GetTimerCycles() >= yield) {
+      return VMK_TRUE;
+   }
+
+   next = list_entry(tls->bhDoneCmds.next, struct scsi_cmnd, bhlist);
+   return (next->device != scmd->device ||
+           (next->vmkflags & VMK_FLAGS_INTERNAL_COMMAND) != 0);
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -507,13 +630,13 @@ SCSILinuxBH(void *clientData)
    vmk_TimerCycles yield, now;
    unsigned myPCPU = vmk_GetPCPUNum();
    scsiLinuxTLS_t *tls = scsiLinuxTLS[myPCPU];
+   int busyCmds = 0;
 
    /*
-    * Flag should be set saying we need to run, and if it's
-    * set there should always be work for us when we get here.
+    * Besides this PCPU setting runningBH, another PCPU may have kicked
+    * us after steering completions to our inbox. The loop below may take
+    * those before the kick gets here, so there can be nothing left to do.
     */
-   VMK_ASSERT(tls->runningBH == VMK_TRUE);
-   VMK_ASSERT(!list_empty(&tls->isrDoneCmds) || !list_empty(&tls->bhDoneCmds));
 
    now = 0;
    yield = vmk_GetTimerCycles() + vmk_TimerUSToTC(5000); /* 5 ms */
@@ -524,17 +647,22 @@ replenish:
    list_splice_init(&tls->isrDoneCmds, &tls->bhDoneCmds);
    mb();
    vmk_CPUEnableInterrupts();
+   SCSILinuxTakeInbox(tls);
 
-   while (!list_empty(&tls->bhDoneCmds) && now < yield) {
+   /*
+    * Runs of completions for the same device release their busy counts
+    * at once, the pass goes on until the run it is in has been released.
+    */
+   while (!list_empty(&tls->bhDoneCmds) && (now < yield || busyCmds > 0)) {
       struct scsi_cmnd *scmd;
 #ifdef VMKLNX_TRACK_IOS_DOWN
       struct scsi_device *sdev;
 #endif
       vmk_ScsiCommand *vmkCmdPtr;
-      unsigned long flags;
 
       scmd = list_entry(tls->bhDoneCmds.next, struct scsi_cmnd, bhlist);
       list_del(&scmd->bhlist);
+      tls->cmdsDone++;
 
       /*
        * First we check for internal commands, which we complete directly.
@@ -651,10 +779,12 @@ replenish:
 	    SCSILinuxProcessStandardInquiryResponse(scmd);
       }
 
-      spin_lock_irqsave(scmd->device->host->host_lock, flags);
-      --scmd->device->host->host_busy;
-      --scmd->device->device_busy;
-      spin_unlock_irqrestore(scmd->device->host->host_lock, flags);
+      busyCmds++;
+      if (SCSILinuxBusyRunEnds(tls, scmd, yield)) {
+         atomic_sub(busyCmds, &scmd->device->host->host_busy);
+         atomic_sub(busyCmds, &scmd->device->device_busy);
+         busyCmds = 0;
+      }
  
       /* 
        * Put back the scsi command before calling scsi upper layer
@@ -682,14 +812,15 @@ replenish:
 
    VMK_ASSERT_CPU_HAS_INTS_ENABLED();
    vmk_CPUDisableInterrupts();
-   if (now > yield) {
+   if (now >= yield) {
       if (!list_empty(&tls->bhDoneCmds) ||
-          !list_empty(&tls->isrDoneCmds)) {
+          !list_empty(&tls->isrDoneCmds) ||
+          tls->inbox != NULL) {
          vmk_CPUEnableInterrupts();
          vmk_BottomHalfSchedulePCPU(scsiLinuxBH, myPCPU);
          return;
       }
-   } else if (!list_empty(&tls->isrDoneCmds)) {
+   } else if (!list_empty(&tls->isrDoneCmds) || tls->inbox != NULL) {
       goto replenish;
    }
    tls->runningBH = VMK_FALSE;
@@ -697,6 +828,38 @@ replenish:
 }
 
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxAdmitCommand --
+ *
+ *      Account a command against the queue depth of the device and the
+ *      can_queue of the host, without taking the host_lock.
+ *
+ * Results:
+ *      VMK_TRUE if the command may be issued, VMK_FALSE if either limit
+ *      has been reached.
+ *
+ * Side effects:
+ *      Bumps device_busy and host_busy when the command is admitted.
+ *
+ *----------------------------------------------------------------------
+ */
+static inline vmk_Bool
+SCSILinuxAdmitCommand(struct Scsi_Host *shost, struct scsi_device *sdev)
+{
+   if (unlikely(atomic_inc_return(&sdev->device_busy) > sdev->queue_depth)) {
+      atomic_dec(&sdev->device_busy);
+      return VMK_FALSE;
+   }
+   if (unlikely(atomic_inc_return(&shost->host_busy) > shost->can_queue)) {
+      atomic_dec(&shost->host_busy);
+      atomic_dec(&sdev->device_busy);
+      return VMK_FALSE;
+   }
+   return VMK_TRUE;
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -820,10 +983,8 @@ SCSILinuxQueueCommand(struct Scsi_Host *shost,
       spin_lock_irqsave(&scmd->vmklock, flags);
       scmd->vmkflags |= (VMK_FLAGS_DROP_CMD|VMK_FLAGS_NEED_CMDDONE);
       spin_unlock_irqrestore(&scmd->vmklock, flags);
-      spin_lock_irqsave(shost->host_lock, flags);
-      ++shost->host_busy;
-      ++sdev->device_busy;
-      spin_unlock_irqrestore(shost->host_lock, flags);
+      atomic_inc(&shost->host_busy);
+      atomic_inc(&sdev->device_busy);
       return VMK_OK;
    }
    )
@@ -832,35 +993,28 @@ SCSILinuxQueueCommand(struct Scsi_Host *shost,
 
    if (unlikely(scmd->cmd_len > shost->max_cmd_len)) {
       scmd->result = (DID_ABORT << 16)|SAM_STAT_GOOD;
-      spin_lock_irqsave(shost->host_lock, flags);
-      ++shost->host_busy;
-      ++sdev->device_busy;
+      atomic_inc(&shost->host_busy);
+      atomic_inc(&sdev->device_busy);
       scmd->vmkflags |= VMK_FLAGS_NEED_CMDDONE;
-      spin_unlock_irqrestore(shost->host_lock, flags);
       SCSILinuxCmdDone(scmd);  
       return VMK_OK;
    }
 
    if (unlikely(shost->shost_state == SHOST_CANCEL)) {
       scmd->result = (DID_NO_CONNECT << 16)|SAM_STAT_GOOD;
-      spin_lock_irqsave(shost->host_lock, flags);
-      ++shost->host_busy;
-      ++sdev->device_busy;
+      atomic_inc(&shost->host_busy);
+      atomic_inc(&sdev->device_busy);
       scmd->vmkflags |= VMK_FLAGS_NEED_CMDDONE;
-      spin_unlock_irqrestore(shost->host_lock, flags);
       SCSILinuxCmdDone(scmd);
       return VMK_OK;
    }
 
-   spin_lock_irqsave(shost->host_lock, flags);
    /* linux tests all these states without holding the host_lock */
    if (unlikely((shost->host_self_blocked) || 
                 (sdev->sdev_state == SDEV_BLOCK) ||
                 (sdev->sdev_state == SDEV_QUIESCE) || 
                 (shost->shost_state == SHOST_RECOVERY) ||
-                (sdev->device_busy >= sdev->queue_depth) ||
-                (shost->host_busy >= shost->can_queue))) {
-      spin_unlock_irqrestore(shost->host_lock, flags);
+                !SCSILinuxAdmitCommand(shost, sdev))) {
 #ifdef VMKLNX_TRACK_IOS_DOWN
       put_device(&sdev->sdev_gendev);
 #endif
@@ -868,23 +1022,20 @@ SCSILinuxQueueCommand(struct Scsi_Host *shost,
       vmk_LogDebug(vmklinux26Log, 0,
                    "h: sb=%d, b=%d d: %p s=%d, b=%d, cq=%d, qd=%d",
                    shost->host_self_blocked,
-                   shost->host_busy,
+                   atomic_read(&shost->host_busy),
                    sdev,
                    sdev->sdev_state,
-                   sdev->device_busy,
+                   atomic_read(&sdev->device_busy),
                    shost->can_queue,
                    sdev->queue_depth);
       return VMK_WOULD_BLOCK;
    }
 
    scmd->vmkflags |= VMK_FLAGS_NEED_CMDDONE;
-   ++shost->host_busy;
-   ++sdev->device_busy;
 
    if (unlikely((sdev->sdev_state == SDEV_DEL) ||
                 (sdev->sdev_state == SDEV_OFFLINE))) { 
       scmd->result = (DID_NO_CONNECT << 16)|SAM_STAT_GOOD;
-      spin_unlock_irqrestore(shost->host_lock, flags);
       vmk_LogDebug(vmklinux26Log, 2, " - The device is up for delete");
       SCSILinuxCmdDone(scmd);  
       return VMK_OK;
@@ -898,16 +1049,25 @@ SCSILinuxQueueCommand(struct Scsi_Host *shost,
          SCSILinuxCmdTimedOut);
    }
 
-   /*
-    * Linux is weird and holds the host_lock while calling
-    * the drivers queuecommand entrypoint.
-    */
-   VMKAPI_MODULE_CALL(SCSI_GET_MODULE_ID(shost),
-                      status,
-                      shost->hostt->queuecommand,
-                      scmd,
-                      SCSILinuxCmdDone);
-   spin_unlock_irqrestore(shost->host_lock, flags);
+   if (shost->hostt->lockless) {
+      VMKAPI_MODULE_CALL(SCSI_GET_MODULE_ID(shost),
+                         status,
+                         shost->hostt->queuecommand,
+                         scmd,
+                         SCSILinuxCmdDone);
+   } else {
+      /*
+       * Linux is weird and holds the host_lock while calling
+       * the drivers queuecommand entrypoint.
+       */
+      spin_lock_irqsave(shost->host_lock, flags);
+      VMKAPI_MODULE_CALL(SCSI_GET_MODULE_ID(shost),
+                         status,
+                         shost->hostt->queuecommand,
+                         scmd,
+                         SCSILinuxCmdDone);
+      spin_unlock_irqrestore(shost->host_lock, flags);
+   }
 
    if (unlikely(status)) {
       static atomic_t repeat_cnt = ATOMIC_INIT(0);
@@ -992,14 +1152,12 @@ SCSILinuxComputeSGArray(struct scsi_cmnd *scmd, vmk_ScsiCommand *vmkCmdPtr)
 {
    int i, sgArrLen;
    vmk_SgArray *sgArray = vmkCmdPtr->sgArray;
-   vmk_ScsiAdapter *vmkAdapter;
    struct vmklnx_ScsiAdapter *vmklnx26ScsiAdapter;
 
    VMK_ASSERT(scmd->device);
 
    vmklnx26ScsiAdapter = 
 	(struct vmklnx_ScsiAdapter *) scmd->device->host->adapter; 
-   vmkAdapter = vmklnx26ScsiAdapter->vmkAdapter;
 
    sgArrLen = sgArray->nbElems;
 
@@ -1465,8 +1623,8 @@ SCSILinuxDumpCmdDone(struct vmklnx_ScsiIntCmd *vmklnx26_ScsiIntCmd)
 
    scmd->vmkflags &= ~VMK_FLAGS_NEED_CMDDONE;
    scmd->serial_number = 0;
-   --scmd->device->host->host_busy;
-   --scmd->device->device_busy;
+   atomic_dec(&scmd->device->host->host_busy);
+   atomic_dec(&scmd->device->device_busy);
 
    if (ownLock) {
       spin_unlock_irqrestore(scmd->device->host->host_lock, flags);
@@ -1507,6 +1665,71 @@ SCSILinuxDumpCmdDone(struct vmklnx_ScsiIntCmd *vmklnx26_ScsiIntCmd)
    return;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxCollectAborts --
+ *
+ *      Move the outstanding commands of sdev on one per-PCPU active list
+ *      of the host that vmkTaskMgmtPtr wants aborted to abort_list, and
+ *      mark them with VMK_FLAGS_DELAY_CMDDONE so that completions coming
+ *      in meanwhile are deferred.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      Takes hp->lock.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+SCSILinuxCollectAborts(struct scsi_host_pcpu *hp, struct scsi_device *sdev,
+                       vmk_ScsiTaskMgmt *vmkTaskMgmtPtr,
+                       struct list_head *abort_list)
+{
+   struct scsi_cmnd *scmd, *safecmd;
+   unsigned long flags, vmkflags;
+
+   spin_lock_irqsave(&hp->lock, flags);
+   list_for_each_entry_safe(scmd, safecmd, &hp->active, active_entry) {
+      vmk_ScsiTaskMgmtAction taskMgmtAction;
+
+      if (scmd->device != sdev) {
+         continue;
+      }
+
+      /*
+       * Check if the Linux SCSI command has already been
+       * completed or is the one PSA is interested in aborting
+       */
+      spin_lock_irqsave(&scmd->vmklock, vmkflags);
+      if (scmd->vmkflags & VMK_FLAGS_NEED_CMDDONE && 
+          !(scmd->vmkflags & VMK_FLAGS_CMDDONE_ATTEMPTED) &&
+	  ((taskMgmtAction = vmk_ScsiQueryTaskMgmt(vmkTaskMgmtPtr, 
+	    scmd->vmkCmdPtr)) & VMK_SCSI_TASKMGMT_ACTION_ABORT)) {
+
+         if (scmd->vmkflags & VMK_FLAGS_DELAY_CMDDONE) {
+            vmk_LogDebug(vmklinux26Log, 4, "cmd %p is already in the process of"
+                   "being aborted", scmd);
+            goto skip_sending_abort;
+         } 
+         scmd->vmkflags |= VMK_FLAGS_DELAY_CMDDONE;
+
+         /*
+          * Store the commands to be aborted in a temp list.
+          * This is a reentrant function so we are keeping them in a local list
+          * After the abort process is done, we put them back on hp
+          */
+         list_move_tail(&scmd->active_entry, abort_list);
+
+skip_sending_abort:;
+      }
+      spin_unlock_irqrestore(&scmd->vmklock, vmkflags);
+   }
+   spin_unlock_irqrestore(&hp->lock, flags);
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -1540,6 +1763,7 @@ SCSILinuxAbortCommands(struct Scsi_Host *shost, struct scsi_device *sdev,
    VMK_ReturnStatus retval = VMK_OK;
    unsigned long flags, vmkflags;
    struct list_head abort_list;
+   int i;
 
    VMK_ASSERT(sdev != NULL);
 
@@ -1552,48 +1776,18 @@ SCSILinuxAbortCommands(struct Scsi_Host *shost, struct scsi_device *sdev,
 
    /*
     * In the first loop, identify the commands that need to be aborted
-    * and put them to a local queue. We also mark each of the commands
-    * we need to abort with DELAY_CMD_DONE to defer any command completions
-    * that come during this time
+    * and put them to a local queue. The outstanding commands of sdev
+    * are spread over the per-PCPU active lists of the host.
     */
-   spin_lock_irqsave(&sdev->list_lock, flags);
-   list_for_each_entry_safe(scmd, safecmd, &sdev->cmd_list, list) {
-      vmk_ScsiTaskMgmtAction taskMgmtAction;
-
-      /*
-       * Check if the Linux SCSI command has already been
-       * completed or is the one PSA is interested in aborting
-       */
-      spin_lock_irqsave(&scmd->vmklock, vmkflags);
-      if (scmd->vmkflags & VMK_FLAGS_NEED_CMDDONE && 
-          !(scmd->vmkflags & VMK_FLAGS_CMDDONE_ATTEMPTED) &&
-	  ((taskMgmtAction = vmk_ScsiQueryTaskMgmt(vmkTaskMgmtPtr, 
-	    scmd->vmkCmdPtr)) & VMK_SCSI_TASKMGMT_ACTION_ABORT)) {
-
-         if (scmd->vmkflags & VMK_FLAGS_DELAY_CMDDONE) {
-            vmk_LogDebug(vmklinux26Log, 4, "cmd %p is already in the process of"
-                   "being aborted", scmd);
-            goto skip_sending_abort;
-         } 
-         scmd->vmkflags |= VMK_FLAGS_DELAY_CMDDONE;
-
-         /*
-          * Store the commands to be aborted in a temp list.
-          * This is a reentrant function so we are keeping them in a local list
-          * After the abort process is done, we put it back to sdev
-          */
-         list_move_tail(&scmd->list, &abort_list);
-
-skip_sending_abort:;
-      }
-      spin_unlock_irqrestore(&scmd->vmklock, vmkflags);
+   for (i = 0; i < vmk_NumPCPUs(); i++) {
+      SCSILinuxCollectAborts(shost->pcpu_cmds[i], sdev, vmkTaskMgmtPtr,
+                             &abort_list);
    }
-   spin_unlock_irqrestore(&sdev->list_lock, flags);
 
    /*
     * Drivers dont like to get called with locks held
     */
-   list_for_each_entry(scmd, &abort_list, list) {
+   list_for_each_entry(scmd, &abort_list, active_entry) {
       VMK_ReturnStatus status;
 
       status = SCSILinuxAbortCommand(shost, scmd, DID_TIME_OUT);
@@ -1608,19 +1802,19 @@ skip_sending_abort:;
 
    /*
     * Time to complete commands to vmkernel that were completed during the
-    * the time we were aborting. We dont have to hold the lock during
-    * the entire time and instead lock just when we do a list_move_tail, 
-    * but considering reentrancy, this makes the code read bit simpler
+    * the time we were aborting. Each command goes back on the active list
+    * it came from, under that list's lock.
     */
-   spin_lock_irqsave(&sdev->list_lock, flags);
-   list_for_each_entry_safe(scmd, safecmd, &abort_list, list) {
+   list_for_each_entry_safe(scmd, safecmd, &abort_list, active_entry) {
+      struct scsi_host_pcpu *hp = shost->pcpu_cmds[scmd->alloc_pcpu];
 
       VMK_ASSERT(scmd->vmkflags & VMK_FLAGS_DELAY_CMDDONE);
 
+      spin_lock_irqsave(&hp->lock, flags);
       spin_lock_irqsave(&scmd->vmklock, vmkflags);
       scmd->vmkflags &= ~VMK_FLAGS_DELAY_CMDDONE;
 
-      list_move_tail(&scmd->list, &sdev->cmd_list);
+      list_move_tail(&scmd->active_entry, &hp->active);
 
       if (scmd->vmkflags & VMK_FLAGS_CMDDONE_ATTEMPTED) {
          spin_unlock_irqrestore(&scmd->vmklock, vmkflags);
@@ -1633,8 +1827,8 @@ skip_sending_abort:;
       } else {
          spin_unlock_irqrestore(&scmd->vmklock, vmkflags);
       }
+      spin_unlock_irqrestore(&hp->lock, flags);
    }
-   spin_unlock_irqrestore(&sdev->list_lock, flags);
 
    vmk_LogDebug(vmklinux26Log, 4, "%s exit\n",__FUNCTION__);   
 
@@ -1877,21 +2071,26 @@ SCSILinuxResetCommand(struct Scsi_Host *shost, struct scsi_device *sdev,
       return VMK_NO_MEMORY;
    }
 
-   VMK_DEBUG_ONLY(
-      spin_lock_irqsave(&sdev->list_lock, flags);
-
-      list_for_each_entry(scmd, &sdev->cmd_list, list) {
-         // Fake a completion if we threw it away...
-         if (scmd->serial_number &&
-	     (scmd->vmkflags & VMK_FLAGS_DROP_CMD) &&
-	     vmk_ScsiQueryTaskMgmt(vmkTaskMgmtPtr, scmd->vmkCmdPtr) != 
-	     VMK_SCSI_TASKMGMT_ACTION_IGNORE) {
-	    scmd->result = (DID_RESET << 16);
-	    SCSILinuxCmdDone(scmd);
-	 }
+   VMK_DEBUG_ONLY({
+      int i;
+
+      for (i = 0; i < vmk_NumPCPUs(); i++) {
+         struct scsi_host_pcpu *hp = shost->pcpu_cmds[i];
+
+         spin_lock_irqsave(&hp->lock, flags);
+         list_for_each_entry(scmd, &hp->active, active_entry) {
+            // Fake a completion if we threw it away...
+            if (scmd->device == sdev && scmd->serial_number &&
+                (scmd->vmkflags & VMK_FLAGS_DROP_CMD) &&
+                vmk_ScsiQueryTaskMgmt(vmkTaskMgmtPtr, scmd->vmkCmdPtr) != 
+                VMK_SCSI_TASKMGMT_ACTION_IGNORE) {
+               scmd->result = (DID_RESET << 16);
+               SCSILinuxCmdDone(scmd);
+            }
+         }
+         spin_unlock_irqrestore(&hp->lock, flags);
       }
-      spin_unlock_irqrestore(&sdev->list_lock, flags);
-   )
+   })
 
    /*
     * Fill in values required for command structure
@@ -1987,6 +2186,97 @@ static inline void SCSILinuxScheduleCompletion(struct scsi_cmnd *scmd,
 }
 
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxComplPCPU --
+ *
+ *      Pick the PCPU whose BH completes the given command, according to
+ *      vmklnx_scsi_compl_steering.
+ *
+ * Results:
+ *      PCPU number.
+ *
+ * Side effects:
+ *      None.
+ *
+ *----------------------------------------------------------------------
+ */
+static inline unsigned
+SCSILinuxComplPCPU(struct scsi_cmnd *scmd, unsigned myPCPU)
+{
+   unsigned target = scmd->submit_pcpu;
+   int domain;
+
+   if (likely(target == myPCPU)) {
+      return myPCPU;
+   }
+
+   switch (vmklnx_scsi_compl_steering) {
+   case SCSI_COMPL_ON_SUBMIT_PCPU:
+      break;
+   case SCSI_COMPL_ON_SUBMIT_DOMAIN:
+      domain = max(vmklnx_scsi_compl_domain_pcpus, 1);
+      if (target / domain == myPCPU / domain) {
+         return myPCPU;
+      }
+      break;
+   default:
+      return myPCPU;
+   }
+
+   if (unlikely(target >= NR_CPUS || scsiLinuxTLS[target] == NULL)) {
+      return myPCPU;
+   }
+   return target;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxSteerCompletion
+ *
+ *      Push the given scsi_cmnd to the inbox of another PCPU and kick
+ *      that PCPU's BH if the inbox was empty. A burst of completions
+ *      for the same PCPU thus costs a single kick.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      If the BH can't be scheduled there, the inbox is taken back and
+ *      its completions are queued on this PCPU instead.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+SCSILinuxSteerCompletion(struct scsi_cmnd *scmd,
+                         scsiLinuxTLS_t *tls,
+                         int myPCPU,
+                         unsigned target)
+{
+   scsiLinuxTLS_t *targetTls = scsiLinuxTLS[target];
+   struct scsi_cmnd *head, *next;
+
+   do {
+      head = targetTls->inbox;
+      scmd->bhnext = head;
+   } while (cmpxchg(&targetTls->inbox, head, scmd) != head);
+
+   tls->steeredOut++;
+   if (head != NULL) {
+      return;
+   }
+
+   tls->kicks++;
+   if (unlikely(vmk_BottomHalfSchedulePCPU(scsiLinuxBH, target) != VMK_OK)) {
+      for (scmd = xchg(&targetTls->inbox, NULL); scmd != NULL; scmd = next) {
+         next = scmd->bhnext;
+         SCSILinuxScheduleCompletion(scmd, tls, myPCPU);
+      }
+   }
+}
+
 /*
  *----------------------------------------------------------------------
  *
@@ -2009,6 +2299,7 @@ SCSILinuxCmdDone(struct scsi_cmnd *scmd)
    unsigned long flags = 0;
    unsigned myPCPU = vmk_GetPCPUNum();
    scsiLinuxTLS_t *tls = scsiLinuxTLS[myPCPU];
+   unsigned target;
 
 #ifdef SCSI_LINUX_DEBUG
    vmk_LogDebug(vmklinux26Log, 0, "%s - cmd 0x%x sn=%d result=%d \n", 
@@ -2069,9 +2360,15 @@ SCSILinuxCmdDone(struct scsi_cmnd *scmd)
    }
 
    /*
-    * Add to the completion list and schedule a BH.
+    * Add to the completion list and schedule a BH, on the PCPU the
+    * command was issued from if we are steering completions.
     */
-   SCSILinuxScheduleCompletion(scmd, tls, myPCPU);
+   target = SCSILinuxComplPCPU(scmd, myPCPU);
+   if (likely(target == myPCPU)) {
+      SCSILinuxScheduleCompletion(scmd, tls, myPCPU);
+   } else {
+      SCSILinuxSteerCompletion(scmd, tls, myPCPU, target);
+   }
 }
 
 /*
@@ -2096,6 +2393,7 @@ SCSILinuxInitCommand(struct scsi_device *sdev, struct scsi_cmnd *scmd)
 
    scmd->serial_number = SCSILinuxGetSerialNumber();
    scmd->jiffies_at_alloc = jiffies;
+   scmd->submit_pcpu = vmk_GetPCPUNum();
 }
 
 /*
@@ -2870,3 +3168,91 @@ SCSIProcessCmdTimedOut(void *data)
    }
    return;
 }
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxProcEmit --
+ *
+ *      Copy the part of a line of a proc node that falls in the window
+ *      [off, off + count) being read into page.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      Advances *pos past the line and *len by the number of bytes copied.
+ *
+ *----------------------------------------------------------------------
+ */
+static void
+SCSILinuxProcEmit(char *page, off_t off, int count, off_t *pos, int *len,
+                  const char *line, int n)
+{
+   int skip, copy;
+
+   if (*pos + n > off && *len < count) {
+      skip = (*pos < off) ? off - *pos : 0;
+      copy = min(n - skip, count - *len);
+      memcpy(page + *len, line + skip, copy);
+      *len += copy;
+   }
+   *pos += n;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxComplProcRead --
+ *
+ *      read_proc handler of /proc/scsi/vmklinux_completions. Reports
+ *      the completion steering policy and, for each PCPU, how many
+ *      completions its BH processed and how many were steered from and
+ *      to it.
+ *
+ * Results:
+ *      Number of bytes written to page.
+ *
+ * Side effects:
+ *      None.
+ *
+ *----------------------------------------------------------------------
+ */
+static int
+SCSILinuxComplProcRead(char *page, char **start, off_t off, int count,
+                       int *eof, void *data)
+{
+   static const char *policy[] = { "interrupt", "submitter", "domain" };
+   int steering = vmklnx_scsi_compl_steering;
+   scsiLinuxTLS_t *tls;
+   char line[128];
+   off_t pos = 0;
+   int len = 0;
+   int n, i;
+
+   if (steering < 0 || steering >= ARRAY_SIZE(policy)) {
+      steering = SCSI_COMPL_ON_INTR_PCPU;
+   }
+   n = snprintf(line, sizeof(line), "steering: %s, domain: %d pcpus\n",
+                policy[steering], max(vmklnx_scsi_compl_domain_pcpus, 1));
+   SCSILinuxProcEmit(page, off, count, &pos, &len, line, n);
+   n = snprintf(line, sizeof(line), "%4s %14s %14s %14s %12s\n",
+                "pcpu", "done", "steered-out", "steered-in", "kicks");
+   SCSILinuxProcEmit(page, off, count, &pos, &len, line, n);
+
+   for (i = 0; i < vmk_NumPCPUs() && len < count; i++) {
+      tls = scsiLinuxTLS[i];
+      if (tls == NULL) {
+         continue;
+      }
+      n = snprintf(line, sizeof(line),
+                   "%4d %14"VMK_FMT64"u %14"VMK_FMT64"u %14"VMK_FMT64"u "
+                   "%12"VMK_FMT64"u\n", i, tls->cmdsDone, tls->steeredOut,
+                   tls->steeredIn, tls->kicks);
+      SCSILinuxProcEmit(page, off, count, &pos, &len, line, n);
+   }
+
+   *start = page;
+   *eof = (pos <= off + len);
+   return len;
+}
@@ -100,6 +100,30 @@ struct scsi_host_cmd_pool {
    gfp_t		gfp_mask;
 };
 
+/* per-PCPU scsi_cmnd magazine size and slab spill batch */
+#define SCSI_CMD_MAG_SIZE  32
+#define SCSI_CMD_MAG_BATCH (SCSI_CMD_MAG_SIZE / 2)
+
+/*
+ * Per-PCPU command state of a Scsi_Host.
+ *
+ * cmds[] caches free scsi_cmnds in front of the host's command slab.
+ * It is only ever touched by its own PCPU with interrupts disabled,
+ * so it needs no lock.
+ *
+ * active holds the commands allocated on this PCPU that have not been
+ * put back yet; it replaces the per-device cmd_list for the abort and
+ * reset paths. Its lock is normally only taken by its own PCPU, and is
+ * shared only when a command completes away from the PCPU it was
+ * issued on or when the abort and reset paths walk the list.
+ */
+struct scsi_host_pcpu {
+   unsigned int         count;          /* number of scmds in cmds[] */
+   struct scsi_cmnd     *cmds[SCSI_CMD_MAG_SIZE];
+   spinlock_t           lock VMK_ATTRIBUTE_L1_ALIGNED;
+   struct list_head     active;         /* outstanding scmds, by active_entry */
+} VMK_ATTRIBUTE_L1_ALIGNED;
+
 extern vmk_atomic64 SCSILinuxSerialNumber;
 
 extern vmk_HeapID vmklnxScsiCmdHeap; /* linux_scsi.c && lld_if.c */
@@ -508,7 +508,9 @@ failed_sh_alloc:
  * scsi/scsi_host.h
  * \par ESX Deviation Notes:
  * Our scsi_cmnd cache also includes space for the maximally sized
- * scatterlist array.
+ * scatterlist array. Each host also gets a per-PCPU magazine of free
+ * commands and a per-PCPU list of outstanding ones, see
+ * struct scsi_host_pcpu.
  * \sa None.
  **********************************************************************
  */
@@ -569,8 +571,40 @@ static int scsi_setup_command_freelist(struct Scsi_Host *sh)
 	goto fail3;
    }
    list_add(&cmd->list, &sh->free_list);		
+
+   sh->pcpu_cmds = kzalloc(vmk_NumPCPUs() * sizeof(*sh->pcpu_cmds),
+                           GFP_KERNEL);
+   if (!sh->pcpu_cmds) {
+      goto fail4;
+   }
+   for (i = 0; i < vmk_NumPCPUs(); i++) {
+      struct scsi_host_pcpu *hp;
+
+      hp = vmklnx_kmalloc_align(VMK_MODULE_HEAP_ID, sizeof(*hp),
+                                VMK_L1_CACHELINE_SIZE);
+      if (!hp) {
+         goto fail4;
+      }
+      memset(hp, 0, sizeof(*hp));
+      spin_lock_init(&hp->lock);
+      INIT_LIST_HEAD(&hp->active);
+      sh->pcpu_cmds[i] = hp;
+   }
    return 0;
 
+fail4:
+   if (sh->pcpu_cmds) {
+      for (i = 0; i < vmk_NumPCPUs(); i++) {
+         if (sh->pcpu_cmds[i]) {
+            vmklnx_kfree(VMK_MODULE_HEAP_ID, sh->pcpu_cmds[i]);
+         }
+      }
+      kfree(sh->pcpu_cmds);
+      sh->pcpu_cmds = NULL;
+   }
+   list_del_init(&cmd->list);
+   kmem_cache_free(sh->cmd_pool->slab, cmd);
+
 fail3:
    mutex_lock(&host_cmd_pool_mutex);
    sh->cmd_pool = NULL;
@@ -1042,13 +1076,27 @@ vmklnx_scsi_set_path_maxsectors(struct scsi_device *sdev,
  * \par Include:
  * scsi/scsi_host.h
  * \par ESX Deviation Notes:
- * None
+ * Also empties and frees the per-PCPU command magazines of the host.
  * \sa None.
  **********************************************************************
  */
 static void 
 scsi_destroy_command_freelist(struct Scsi_Host *sh)
 {
+   int i;
+
+   for (i = 0; i < vmk_NumPCPUs(); i++) {
+      struct scsi_host_pcpu *hp = sh->pcpu_cmds[i];
+
+      VMK_ASSERT(list_empty(&hp->active));
+      while (hp->count > 0) {
+         kmem_cache_free(sh->cmd_pool->slab, hp->cmds[--hp->count]);
+      }
+      vmklnx_kfree(VMK_MODULE_HEAP_ID, hp);
+   }
+   kfree(sh->pcpu_cmds);
+   sh->pcpu_cmds = NULL;
+
    while (!list_empty(&sh->free_list)) {
       struct scsi_cmnd *cmd;
 
@@ -1059,7 +1107,6 @@ scsi_destroy_command_freelist(struct Scsi_Host *sh)
 
    mutex_lock(&host_cmd_pool_mutex);
    if (!--sh->cmd_pool->users) {
-      int i;
       for (i = 0; i < SG_MEMPOOL_NR; i++) {
          struct scsi_host_sg_pool *sgp = scsi_sg_pools + i;
          /* first free pool, then its slab */
@@ -2363,6 +2410,75 @@ vmklnx_clear_scmd(struct scsi_cmnd *scmd)
    return;
 }
 
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxCmdMagazineGet --
+ *
+ *      Take a free command from the current PCPU's magazine of sh.
+ *
+ * Results:
+ *      A scsi_cmnd, or NULL if the magazine is empty.
+ *
+ * Side effects:
+ *      None.
+ *
+ *----------------------------------------------------------------------
+ */
+static inline struct scsi_cmnd *
+SCSILinuxCmdMagazineGet(struct Scsi_Host *sh)
+{
+   struct scsi_host_pcpu *hp;
+   struct scsi_cmnd *cmd = NULL;
+   unsigned long flags;
+
+   local_irq_save(flags);
+   hp = sh->pcpu_cmds[vmk_GetPCPUNum()];
+   if (likely(hp->count > 0)) {
+      cmd = hp->cmds[--hp->count];
+   }
+   local_irq_restore(flags);
+
+   return cmd;
+}
+
+/*
+ *----------------------------------------------------------------------
+ *
+ * SCSILinuxCmdMagazinePut --
+ *
+ *      Recycle a command into the current PCPU's magazine of sh. When
+ *      the magazine is full, its coldest half goes back to the slab.
+ *
+ * Results:
+ *      None.
+ *
+ * Side effects:
+ *      May free to sh->cmd_pool->slab.
+ *
+ *----------------------------------------------------------------------
+ */
+static inline void
+SCSILinuxCmdMagazinePut(struct Scsi_Host *sh, struct scsi_cmnd *cmd)
+{
+   struct scsi_host_pcpu *hp;
+   unsigned long flags;
+   int i;
+
+   local_irq_save(flags);
+   hp = sh->pcpu_cmds[vmk_GetPCPUNum()];
+   if (unlikely(hp->count == SCSI_CMD_MAG_SIZE)) {
+      for (i = 0; i < SCSI_CMD_MAG_BATCH; i++) {
+         kmem_cache_free(sh->cmd_pool->slab, hp->cmds[i]);
+      }
+      memmove(&hp->cmds[0], &hp->cmds[SCSI_CMD_MAG_BATCH],
+              (SCSI_CMD_MAG_SIZE - SCSI_CMD_MAG_BATCH) * sizeof(hp->cmds[0]));
+      hp->count -= SCSI_CMD_MAG_BATCH;
+   }
+   hp->cmds[hp->count++] = cmd;
+   local_irq_restore(flags);
+}
+
 /*
  * Function:	scsi_get_command()
  *
@@ -2372,15 +2488,25 @@ vmklnx_clear_scmd(struct scsi_cmnd *scmd)
  *		gfp_mask- allocator flags
  *
  * Returns:	The allocated scsi command structure.
+ *
+ * Notes:	The command comes from the current PCPU's magazine if it
+ *		has one, and is put on that PCPU's active list of the host
+ *		rather than on dev->cmd_list, unless the driver asked for
+ *		sdev_cmd_list.
  */
 struct scsi_cmnd *
 scsi_get_command(struct scsi_device *dev, gfp_t gfp_mask)
 {
+   struct Scsi_Host *sh = dev->host;
    struct scsi_cmnd *cmd;
 
-   cmd = __scsi_get_command(dev->host, gfp_mask);
+   cmd = SCSILinuxCmdMagazineGet(sh);
+   if (unlikely(cmd == NULL)) {
+      cmd = __scsi_get_command(sh, gfp_mask);
+   }
 
    if (likely(cmd != NULL)) {
+      struct scsi_host_pcpu *hp;
       unsigned long flags;
 
       /*
@@ -2394,9 +2520,22 @@ scsi_get_command(struct scsi_device *dev, gfp_t gfp_mask)
       INIT_LIST_HEAD(&cmd->eh_entry);
       init_timer(&cmd->eh_timeout);
       spin_lock_init(&cmd->vmklock);
-      spin_lock_irqsave(&dev->list_lock, flags);
-      list_add_tail(&cmd->list, &dev->cmd_list);
-      spin_unlock_irqrestore(&dev->list_lock, flags);
+
+      /*
+       * Migrating off this PCPU before the lock is taken only makes
+       * the put side take a remote lock, it is not a correctness issue.
+       */
+      cmd->alloc_pcpu = vmk_GetPCPUNum();
+      hp = sh->pcpu_cmds[cmd->alloc_pcpu];
+      spin_lock_irqsave(&hp->lock, flags);
+      list_add_tail(&cmd->active_entry, &hp->active);
+      spin_unlock_irqrestore(&hp->lock, flags);
+
+      if (unlikely(sh->hostt->sdev_cmd_list)) {
+         spin_lock_irqsave(&dev->list_lock, flags);
+         list_add_tail(&cmd->list, &dev->cmd_list);
+         spin_unlock_irqrestore(&dev->list_lock, flags);
+      }
    } 
    return cmd;
 }
@@ -2486,13 +2625,21 @@ scsi_put_command(struct scsi_cmnd *scmd)
 {
 	struct scsi_device *sdev = scmd->device;
 	struct Scsi_Host *sh = sdev->host;
+	struct scsi_host_pcpu *hp = sh->pcpu_cmds[scmd->alloc_pcpu];
 	unsigned long flags;
 
-	/* serious error if the command hasn't come from a device list */
-	spin_lock_irqsave(&scmd->device->list_lock, flags);
-	BUG_ON(list_empty(&scmd->list));
-	list_del_init(&scmd->list);
-	spin_unlock_irqrestore(&scmd->device->list_lock, flags);
+	/* serious error if the command hasn't come from an active list */
+	spin_lock_irqsave(&hp->lock, flags);
+	BUG_ON(list_empty(&scmd->active_entry));
+	list_del_init(&scmd->active_entry);
+	spin_unlock_irqrestore(&hp->lock, flags);
+
+	if (unlikely(sh->hostt->sdev_cmd_list)) {
+		spin_lock_irqsave(&sdev->list_lock, flags);
+		BUG_ON(list_empty(&scmd->list));
+		list_del_init(&scmd->list);
+		spin_unlock_irqrestore(&sdev->list_lock, flags);
+	}
 
         /*
    	 * Free up the resources allocated now
@@ -2504,15 +2651,21 @@ scsi_put_command(struct scsi_cmnd *scmd)
 			   scsi_free_sgtable(scmd->sgArray, nbElems); });
 	}
 
-	spin_lock_irqsave(&sh->free_list_lock, flags);
+	/*
+	 * The backup command is only ever used when the slab is out of
+	 * memory, so peek before taking the lock.
+	 */
 	if (unlikely(list_empty(&sh->free_list))) {
-		list_add(&scmd->list, &sh->free_list);
-		scmd = NULL;
+		spin_lock_irqsave(&sh->free_list_lock, flags);
+		if (list_empty(&sh->free_list)) {
+			list_add(&scmd->list, &sh->free_list);
+			scmd = NULL;
+		}
+		spin_unlock_irqrestore(&sh->free_list_lock, flags);
 	}
-	spin_unlock_irqrestore(&sh->free_list_lock, flags);
 
 	if (likely(scmd != NULL)) {
-		kmem_cache_free(sh->cmd_pool->slab, scmd);
+		SCSILinuxCmdMagazinePut(sh, scmd);
  	}
 }
 
@@ -2585,12 +2738,13 @@ scsi_execute(struct scsi_device *sdev, const unsigned char *cmd,
    scmd->vmkflags |= VMK_FLAGS_NEED_CMDDONE;
    spin_unlock_irqrestore(&scmd->vmklock, flags);
 
+   atomic_inc(&shost->host_busy);
+   atomic_inc(&sdev->device_busy);
+
    /* 
     * Acquire lock now
     */
    spin_lock_irqsave(shost->host_lock, flags);
-   ++shost->host_busy;
-   ++sdev->device_busy;
 
    /*
     * Add timer for error handling
@@ -2641,10 +2795,8 @@ scsi_execute(struct scsi_device *sdev, const unsigned char *cmd,
    }
 
 free_internal_command:
-   spin_lock_irqsave(shost->host_lock, flags);
-   --shost->host_busy;
-   --sdev->device_busy;
-   spin_unlock_irqrestore(shost->host_lock, flags);
+   atomic_dec(&shost->host_busy);
+   atomic_dec(&sdev->device_busy);
    /*
     * Free the command structure
     */
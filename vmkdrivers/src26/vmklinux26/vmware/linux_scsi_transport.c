@@ -522,7 +522,7 @@ vmklnx_scsi_device_quiesce(struct scsi_device *sdev, void *ref)
    /*
     * Give some time before all commands are flushed out
     */
-   while (sdev->device_busy) {
+   while (atomic_read(&sdev->device_busy)) {
       /*
        * There is no way to know if all the commands are flushed out
        * This is an arbitary number that seems to work with mptspi
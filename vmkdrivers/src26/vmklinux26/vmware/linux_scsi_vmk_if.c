@@ -510,20 +510,20 @@ SCSILinuxDumpCommand(void *clientData,
    }
 
    if (sh->host_self_blocked 
-       || (sdev->device_busy == sdev->queue_depth) 
-       || (sh->host_busy == sh->can_queue)) {
+       || (atomic_read(&sdev->device_busy) >= sdev->queue_depth) 
+       || (atomic_read(&sh->host_busy) >= sh->can_queue)) {
       vmk_LogDebug(vmklinux26Log, 0, "%s - devcif=%u depth=%u hostcif=%u "
 	"can_queue=%d self_blocked=%u\n",
 	  __FUNCTION__,
-          sdev->device_busy, sdev->queue_depth,
-          sh->host_busy, sh->can_queue,
+          atomic_read(&sdev->device_busy), sdev->queue_depth,
+          atomic_read(&sh->host_busy), sh->can_queue,
           sh->host_self_blocked);
       spin_unlock_irqrestore(sh->host_lock, flags);
       return VMK_WOULD_BLOCK;
    }
 
-   ++scmd->device->host->host_busy;
-   ++sdev->device_busy;
+   atomic_inc(&scmd->device->host->host_busy);
+   atomic_inc(&sdev->device_busy);
    spin_unlock_irqrestore(sh->host_lock, flags);
 
    /* 
@@ -991,21 +991,21 @@ SCSILinuxDumpQueue(void *clientData)
    struct vmklnx_ScsiAdapter *vmklnx26ScsiAdapter = 
 		(struct vmklnx_ScsiAdapter *) clientData; 
    struct Scsi_Host    *sh = vmklnx26ScsiAdapter->shost;
-   struct scsi_device *sdev;
    struct scsi_cmnd *scmd;
-   unsigned long flags, cmdFlags;
+   unsigned long flags;
+   int i;
 
    VMK_ASSERT(sh);
 
-   spin_lock_irqsave(sh->host_lock, flags);
-   shost_for_each_device(sdev, sh) {
-      spin_lock_irqsave(&sdev->list_lock, cmdFlags);
-      list_for_each_entry(scmd, &sdev->cmd_list, list) {
+   for (i = 0; i < vmk_NumPCPUs(); i++) {
+      struct scsi_host_pcpu *hp = sh->pcpu_cmds[i];
+
+      spin_lock_irqsave(&hp->lock, flags);
+      list_for_each_entry(scmd, &hp->active, active_entry) {
          vmk_LogDebug(vmklinux26Log, 3, "%p", scmd);
       }
-      spin_unlock_irqrestore(&sdev->list_lock, cmdFlags);
+      spin_unlock_irqrestore(&hp->lock, flags);
    }
-   spin_unlock_irqrestore(sh->host_lock, flags);
 }
 
 /*
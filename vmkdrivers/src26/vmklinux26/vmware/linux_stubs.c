@@ -61,6 +61,7 @@
 #include <linux/usb.h>
 #include <linux/dmi.h>
 #include <linux/miscdevice.h>
+#include <linux/crc32.h>
 #include <asm/dmi.h>
 
 #include "vmkapi.h"
@@ -2947,6 +2948,7 @@ init_module(void)
    LinuxKthread_Init();
    umem_init();
    LinuxProc_Init();
+   crc32_init();
    LinuxPCI_Init();
    LinuxDMA_Init();
    LinNet_Init();